@@ -16,6 +16,11 @@
 #include <libtcc.h>
 #include <string.h>
 
+#ifdef HAVE_LINUX
+# define GUM_CMODULE_HAVE_EXTERNAL_TOOLCHAIN 1
+# include <glib/gstdio.h>
+#endif
+
 typedef struct _GumEnumerateSymbolsContext GumEnumerateSymbolsContext;
 typedef struct _GumCModuleHeader GumCModuleHeader;
 typedef guint GumCModuleHeaderKind;
@@ -50,8 +55,17 @@ struct _GumEnumerateSymbolsContext
   gpointer user_data;
 };
 
+static GumCModuleToolchain gum_cmodule_resolve_toolchain (
+    const GumCModuleOptions * options);
+#ifdef GUM_CMODULE_HAVE_EXTERNAL_TOOLCHAIN
+static gboolean gum_cmodule_compile_external (TCCState * state,
+    const gchar * source, GString ** error_messages);
+static void gum_rmtree (const gchar * path);
+#endif
 static void gum_append_tcc_error (void * opaque, const char * msg);
 static void gum_emit_symbol (void * ctx, const char * name, const void * val);
+static GHashTable * gum_cmodule_get_header_index (void);
+static void gum_cmodule_deinit_header_index (void);
 static const char * gum_cmodule_load_header (void * opaque, const char * path,
     int * len);
 static void * gum_cmodule_resolve_symbol (void * opaque, const char * name);
@@ -67,13 +81,17 @@ extern void * __va_arg (void * ap, int arg_type, int size, int align);
 
 GumCModule *
 gum_cmodule_new (const gchar * source,
+                 const GumCModuleOptions * options,
                  GError ** error)
 {
   GumCModule * cmodule;
+  GumCModuleToolchain toolchain;
   TCCState * state;
   GString * error_messages;
   gchar * combined_source;
 
+  toolchain = gum_cmodule_resolve_toolchain (options);
+
   cmodule = g_slice_new0 (GumCModule);
 
   state = tcc_new ();
@@ -121,7 +139,22 @@ gum_cmodule_new (const gchar * source,
 
   combined_source = g_strconcat ("#line 1 \"module.c\"\n", source, NULL);
 
-  tcc_compile_string (state, combined_source);
+#ifdef GUM_CMODULE_HAVE_EXTERNAL_TOOLCHAIN
+  if (toolchain == GUM_CMODULE_TOOLCHAIN_EXTERNAL)
+    gum_cmodule_compile_external (state, combined_source, &error_messages);
+  else
+    tcc_compile_string (state, combined_source);
+#else
+  if (toolchain == GUM_CMODULE_TOOLCHAIN_EXTERNAL)
+  {
+    gum_append_tcc_error (&error_messages,
+        "external toolchain is not supported on this OS");
+  }
+  else
+  {
+    tcc_compile_string (state, combined_source);
+  }
+#endif
 
   g_free (combined_source);
 
@@ -154,6 +187,197 @@ failure:
   }
 }
 
+static GumCModuleToolchain
+gum_cmodule_resolve_toolchain (const GumCModuleOptions * options)
+{
+  GumCModuleToolchain toolchain;
+
+  toolchain = (options != NULL)
+      ? options->toolchain
+      : GUM_CMODULE_TOOLCHAIN_ANY;
+
+  if (toolchain == GUM_CMODULE_TOOLCHAIN_ANY)
+  {
+    const gchar * preference = g_getenv ("GUM_CMODULE_TOOLCHAIN");
+
+    if (preference != NULL && strcmp (preference, "external") == 0)
+      toolchain = GUM_CMODULE_TOOLCHAIN_EXTERNAL;
+    else
+      toolchain = GUM_CMODULE_TOOLCHAIN_INTERNAL;
+  }
+
+  return toolchain;
+}
+
+#ifdef GUM_CMODULE_HAVE_EXTERNAL_TOOLCHAIN
+
+/*
+ * Compiles with the system toolchain for better codegen, then hands the
+ * resulting ELF relocatable to TCC's in-memory linker, so symbol
+ * resolution and relocation behave exactly as in the internal path.
+ */
+static gboolean
+gum_cmodule_compile_external (TCCState * state,
+                              const gchar * source,
+                              GString ** error_messages)
+{
+  gboolean success = FALSE;
+  gchar * build_dir = NULL;
+  gchar * source_path = NULL;
+  gchar * obj_path = NULL;
+  const gchar * cc;
+  GPtrArray * argv;
+  gchar * output = NULL;
+  gint exit_status;
+  GError * error = NULL;
+  guint i;
+
+  build_dir = g_dir_make_tmp ("cmodule-XXXXXX", &error);
+  if (build_dir == NULL)
+    goto propagate_error;
+
+  for (i = 0; i != G_N_ELEMENTS (gum_cmodule_headers); i++)
+  {
+    const GumCModuleHeader * h = &gum_cmodule_headers[i];
+    gchar * path, * dir;
+
+    path = g_build_filename (build_dir, h->name, NULL);
+    dir = g_path_get_dirname (path);
+    g_mkdir_with_parents (dir, 0700);
+    g_free (dir);
+
+    if (!g_file_set_contents (path, h->data, h->size, &error))
+    {
+      g_free (path);
+      goto propagate_error;
+    }
+
+    g_free (path);
+  }
+
+  source_path = g_build_filename (build_dir, "module.c", NULL);
+  if (!g_file_set_contents (source_path, source, -1, &error))
+    goto propagate_error;
+
+  obj_path = g_build_filename (build_dir, "module.o", NULL);
+
+  cc = g_getenv ("CC");
+  if (cc == NULL || cc[0] == '\0')
+    cc = "cc";
+
+  argv = g_ptr_array_new_with_free_func (g_free);
+  g_ptr_array_add (argv, g_strdup (cc));
+  g_ptr_array_add (argv, g_strdup ("-c"));
+  g_ptr_array_add (argv, g_strdup (source_path));
+  g_ptr_array_add (argv, g_strdup ("-o"));
+  g_ptr_array_add (argv, g_strdup (obj_path));
+  g_ptr_array_add (argv, g_strdup ("-O2"));
+  g_ptr_array_add (argv, g_strdup ("-fPIC"));
+  g_ptr_array_add (argv, g_strdup ("-nostdinc"));
+  g_ptr_array_add (argv, g_strdup ("-nostdlib"));
+  g_ptr_array_add (argv, g_strdup ("-isystem"));
+  g_ptr_array_add (argv, g_strdup (build_dir));
+#if defined (HAVE_I386)
+  g_ptr_array_add (argv, g_strdup ("-DHAVE_I386"));
+#elif defined (HAVE_ARM)
+  g_ptr_array_add (argv, g_strdup ("-DHAVE_ARM"));
+#elif defined (HAVE_ARM64)
+  g_ptr_array_add (argv, g_strdup ("-DHAVE_ARM64"));
+#elif defined (HAVE_MIPS)
+  g_ptr_array_add (argv, g_strdup ("-DHAVE_MIPS"));
+#endif
+  g_ptr_array_add (argv, g_strdup ("-DTRUE=1"));
+  g_ptr_array_add (argv, g_strdup ("-DFALSE=0"));
+  g_ptr_array_add (argv, g_strdup_printf ("-DG_GINT16_MODIFIER=\"%s\"",
+      G_GINT16_MODIFIER));
+  g_ptr_array_add (argv, g_strdup_printf ("-DG_GINT32_MODIFIER=\"%s\"",
+      G_GINT32_MODIFIER));
+  g_ptr_array_add (argv, g_strdup_printf ("-DG_GINT64_MODIFIER=\"%s\"",
+      G_GINT64_MODIFIER));
+  g_ptr_array_add (argv, g_strdup_printf ("-DG_GSIZE_MODIFIER=\"%s\"",
+      G_GSIZE_MODIFIER));
+  g_ptr_array_add (argv, g_strdup_printf ("-DG_GSSIZE_MODIFIER=\"%s\"",
+      G_GSSIZE_MODIFIER));
+  g_ptr_array_add (argv, g_strdup_printf ("-DGLIB_SIZEOF_VOID_P=%s",
+      G_STRINGIFY (GLIB_SIZEOF_VOID_P)));
+  g_ptr_array_add (argv, NULL);
+
+  if (!g_spawn_sync (build_dir, (gchar **) argv->pdata, NULL,
+      G_SPAWN_SEARCH_PATH | G_SPAWN_STDOUT_TO_DEV_NULL, NULL, NULL,
+      NULL, &output, &exit_status, &error))
+  {
+    g_ptr_array_unref (argv);
+    goto propagate_error;
+  }
+
+  g_ptr_array_unref (argv);
+
+  if (!g_spawn_check_exit_status (exit_status, NULL))
+    goto compiler_failed;
+
+  success = tcc_add_file (state, obj_path) == 0;
+  goto beach;
+
+compiler_failed:
+  {
+    gum_append_tcc_error (error_messages, (output != NULL && output[0] != '\0')
+        ? output
+        : "external compiler failed");
+    goto beach;
+  }
+propagate_error:
+  {
+    gum_append_tcc_error (error_messages, error->message);
+    g_error_free (error);
+    goto beach;
+  }
+beach:
+  {
+    g_free (output);
+    g_free (obj_path);
+    g_free (source_path);
+    if (build_dir != NULL)
+      gum_rmtree (build_dir);
+    g_free (build_dir);
+
+    return success;
+  }
+}
+
+static void
+gum_rmtree (const gchar * path)
+{
+  GDir * dir;
+  const gchar * name;
+
+  dir = g_dir_open (path, 0, NULL);
+  if (dir != NULL)
+  {
+    while ((name = g_dir_read_name (dir)) != NULL)
+    {
+      gchar * child = g_build_filename (path, name, NULL);
+
+      if (g_file_test (child, G_FILE_TEST_IS_DIR) &&
+          !g_file_test (child, G_FILE_TEST_IS_SYMLINK))
+      {
+        gum_rmtree (child);
+      }
+      else
+      {
+        g_unlink (child);
+      }
+
+      g_free (child);
+    }
+
+    g_dir_close (dir);
+  }
+
+  g_rmdir (path);
+}
+
+#endif
+
 void
 gum_cmodule_free (GumCModule * cmodule)
 {
@@ -325,29 +549,62 @@ gum_cmodule_drop_metadata (GumCModule * self)
   g_clear_pointer (&self->state, tcc_delete);
 }
 
+/*
+ * Built once and shared by every TCCState, so repeated CModule builds
+ * resolve each #include with a single hash lookup instead of scanning
+ * the embedded header table.
+ */
+static GHashTable *
+gum_cmodule_get_header_index (void)
+{
+  static gsize gonce_value;
+
+  if (g_once_init_enter (&gonce_value))
+  {
+    GHashTable * index;
+    guint i;
+
+    index = g_hash_table_new (g_str_hash, g_str_equal);
+
+    for (i = 0; i != G_N_ELEMENTS (gum_cmodule_headers); i++)
+    {
+      const GumCModuleHeader * h = &gum_cmodule_headers[i];
+
+      g_hash_table_insert (index, (gpointer) h->name, (gpointer) h);
+    }
+
+    _gum_register_destructor (gum_cmodule_deinit_header_index);
+
+    g_once_init_leave (&gonce_value, GPOINTER_TO_SIZE (index) + 1);
+  }
+
+  return GSIZE_TO_POINTER (gonce_value - 1);
+}
+
+static void
+gum_cmodule_deinit_header_index (void)
+{
+  g_hash_table_unref (gum_cmodule_get_header_index ());
+}
+
 static const char *
 gum_cmodule_load_header (void * opaque,
                          const char * path,
                          int * len)
 {
   const gchar * name;
-  guint i;
+  const GumCModuleHeader * h;
 
   name = path;
   if (g_str_has_prefix (name, "/frida/"))
     name += 7;
 
-  for (i = 0; i != G_N_ELEMENTS (gum_cmodule_headers); i++)
-  {
-    const GumCModuleHeader * h = &gum_cmodule_headers[i];
-    if (strcmp (h->name, name) == 0)
-    {
-      *len = h->size;
-      return h->data;
-    }
-  }
+  h = g_hash_table_lookup (gum_cmodule_get_header_index (), name);
+  if (h == NULL)
+    return NULL;
 
-  return NULL;
+  *len = h->size;
+  return h->data;
 }
 
 static void *
@@ -386,6 +643,7 @@ gum_undecorate_name (const gchar * name)
 
 GumCModule *
 gum_cmodule_new (const gchar * source,
+                 const GumCModuleOptions * options,
                  GError ** error)
 {
   g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
@@ -12,8 +12,22 @@
 G_BEGIN_DECLS
 
 typedef struct _GumCModule GumCModule;
+typedef struct _GumCModuleOptions GumCModuleOptions;
+typedef guint GumCModuleToolchain;
 typedef struct _GumCSymbolDetails GumCSymbolDetails;
 
+struct _GumCModuleOptions
+{
+  GumCModuleToolchain toolchain;
+};
+
+enum _GumCModuleToolchain
+{
+  GUM_CMODULE_TOOLCHAIN_ANY,
+  GUM_CMODULE_TOOLCHAIN_INTERNAL,
+  GUM_CMODULE_TOOLCHAIN_EXTERNAL
+};
+
 struct _GumCSymbolDetails
 {
   const gchar * name;
@@ -23,7 +37,8 @@ struct _GumCSymbolDetails
 typedef void (* GumFoundCSymbolFunc) (const GumCSymbolDetails * details,
     gpointer user_data);
 
-GUM_API GumCModule * gum_cmodule_new (const gchar * source, GError ** error);
+GUM_API GumCModule * gum_cmodule_new (const gchar * source,
+    const GumCModuleOptions * options, GError ** error);
 GUM_API void gum_cmodule_free (GumCModule * cmodule);
 
 GUM_API const GumMemoryRange * gum_cmodule_get_range (GumCModule * self);
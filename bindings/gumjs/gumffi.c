@@ -115,6 +115,43 @@ static const GumFFIABIMapping gum_ffi_abi_mappings[] =
 #endif
 };
 
+GumFFITypeKind
+gum_ffi_classify_type (const ffi_type * type)
+{
+  if (type == &ffi_type_void)
+    return GUM_FFI_KIND_VOID;
+  if (type == &ffi_type_pointer)
+    return GUM_FFI_KIND_POINTER;
+  if (type == &ffi_type_sint8)
+    return GUM_FFI_KIND_SINT8;
+  if (type == &ffi_type_uint8)
+    return GUM_FFI_KIND_UINT8;
+  if (type == &ffi_type_sint16)
+    return GUM_FFI_KIND_SINT16;
+  if (type == &ffi_type_uint16)
+    return GUM_FFI_KIND_UINT16;
+  if (type == &ffi_type_sint32)
+    return GUM_FFI_KIND_SINT32;
+  if (type == &ffi_type_uint32)
+    return GUM_FFI_KIND_UINT32;
+  if (type == &ffi_type_sint64)
+    return GUM_FFI_KIND_SINT64;
+  if (type == &ffi_type_uint64)
+    return GUM_FFI_KIND_UINT64;
+  if (type == &gum_ffi_type_size_t)
+    return GUM_FFI_KIND_SIZE;
+  if (type == &gum_ffi_type_ssize_t)
+    return GUM_FFI_KIND_SSIZE;
+  if (type == &ffi_type_float)
+    return GUM_FFI_KIND_FLOAT;
+  if (type == &ffi_type_double)
+    return GUM_FFI_KIND_DOUBLE;
+
+  g_assert (type->type == FFI_TYPE_STRUCT);
+
+  return GUM_FFI_KIND_STRUCT;
+}
+
 gboolean
 gum_ffi_try_get_type_by_name (const gchar * name,
                               ffi_type ** type)
@@ -172,3 +209,201 @@ gum_ffi_maybe_promote_variadic (ffi_type * type)
 
   return type;
 }
+
+/*
+ * The generic ffi_call() classifies the signature and builds a call frame
+ * on every invocation. Signatures made up solely of register-sized
+ * integers and pointers — the vast majority of hooked C functions — can
+ * instead be dispatched through a plain function-pointer cast, which every
+ * supported ABI allows as long as each argument is extended to register
+ * width. Callers must check gum_ffi_cif_is_direct_callable() first, and
+ * only for non-variadic calls on the default ABI.
+ */
+
+#define GUM_FFI_MAX_DIRECT_ARGS 8
+
+static gboolean
+gum_ffi_type_is_register_sized (const ffi_type * t)
+{
+  switch (t->type)
+  {
+    case FFI_TYPE_INT:
+    case FFI_TYPE_SINT8:
+    case FFI_TYPE_UINT8:
+    case FFI_TYPE_SINT16:
+    case FFI_TYPE_UINT16:
+    case FFI_TYPE_SINT32:
+    case FFI_TYPE_UINT32:
+    case FFI_TYPE_POINTER:
+      return TRUE;
+#if GLIB_SIZEOF_VOID_P == 8
+    case FFI_TYPE_SINT64:
+    case FFI_TYPE_UINT64:
+      return TRUE;
+#endif
+    default:
+      return FALSE;
+  }
+}
+
+static gsize
+gum_ffi_value_as_register (const ffi_type * t,
+                           const GumFFIValue * v)
+{
+  switch (t->type)
+  {
+    case FFI_TYPE_INT:
+      return (gsize) (gssize) v->v_sint;
+    case FFI_TYPE_SINT8:
+      return (gsize) (gssize) v->v_sint8;
+    case FFI_TYPE_UINT8:
+      return v->v_uint8;
+    case FFI_TYPE_SINT16:
+      return (gsize) (gssize) v->v_sint16;
+    case FFI_TYPE_UINT16:
+      return v->v_uint16;
+    case FFI_TYPE_SINT32:
+      return (gsize) (gssize) v->v_sint32;
+    case FFI_TYPE_UINT32:
+      return v->v_uint32;
+#if GLIB_SIZEOF_VOID_P == 8
+    case FFI_TYPE_SINT64:
+      return (gsize) v->v_sint64;
+    case FFI_TYPE_UINT64:
+      return v->v_uint64;
+#endif
+    case FFI_TYPE_POINTER:
+      return GPOINTER_TO_SIZE (v->v_pointer);
+    default:
+      g_assert_not_reached ();
+      return 0;
+  }
+}
+
+static void
+gum_ffi_value_from_register (const ffi_type * t,
+                             gsize raw,
+                             GumFFIValue * v)
+{
+  switch (t->type)
+  {
+    case FFI_TYPE_INT:
+      v->v_sint = (gint) raw;
+      break;
+    case FFI_TYPE_SINT8:
+      v->v_sint8 = (gint8) raw;
+      break;
+    case FFI_TYPE_UINT8:
+      v->v_uint8 = (guint8) raw;
+      break;
+    case FFI_TYPE_SINT16:
+      v->v_sint16 = (gint16) raw;
+      break;
+    case FFI_TYPE_UINT16:
+      v->v_uint16 = (guint16) raw;
+      break;
+    case FFI_TYPE_SINT32:
+      v->v_sint32 = (gint32) raw;
+      break;
+    case FFI_TYPE_UINT32:
+      v->v_uint32 = (guint32) raw;
+      break;
+#if GLIB_SIZEOF_VOID_P == 8
+    case FFI_TYPE_SINT64:
+      v->v_sint64 = (gint64) raw;
+      break;
+    case FFI_TYPE_UINT64:
+      v->v_uint64 = (guint64) raw;
+      break;
+#endif
+    case FFI_TYPE_POINTER:
+      v->v_pointer = GSIZE_TO_POINTER (raw);
+      break;
+    default:
+      g_assert_not_reached ();
+  }
+}
+
+gboolean
+gum_ffi_cif_is_direct_callable (const ffi_cif * cif)
+{
+  guint i;
+
+  if (cif->abi != FFI_DEFAULT_ABI)
+    return FALSE;
+
+  if (cif->nargs > GUM_FFI_MAX_DIRECT_ARGS)
+    return FALSE;
+
+  if (cif->rtype->type != FFI_TYPE_VOID &&
+      !gum_ffi_type_is_register_sized (cif->rtype))
+  {
+    return FALSE;
+  }
+
+  for (i = 0; i != cif->nargs; i++)
+  {
+    if (!gum_ffi_type_is_register_sized (cif->arg_types[i]))
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+void
+gum_ffi_call_direct (GCallback implementation,
+                     const ffi_cif * cif,
+                     GumFFIValue * rvalue,
+                     void ** avalue)
+{
+  gsize a[GUM_FFI_MAX_DIRECT_ARGS] = { 0, };
+  gsize result = 0;
+  guint n, i;
+
+  n = cif->nargs;
+  for (i = 0; i != n; i++)
+    a[i] = gum_ffi_value_as_register (cif->arg_types[i], avalue[i]);
+
+  switch (n)
+  {
+    case 0:
+      result = ((gsize (*) (void)) implementation) ();
+      break;
+    case 1:
+      result = ((gsize (*) (gsize)) implementation) (a[0]);
+      break;
+    case 2:
+      result = ((gsize (*) (gsize, gsize)) implementation) (a[0], a[1]);
+      break;
+    case 3:
+      result = ((gsize (*) (gsize, gsize, gsize)) implementation) (
+          a[0], a[1], a[2]);
+      break;
+    case 4:
+      result = ((gsize (*) (gsize, gsize, gsize, gsize)) implementation) (
+          a[0], a[1], a[2], a[3]);
+      break;
+    case 5:
+      result = ((gsize (*) (gsize, gsize, gsize, gsize, gsize))
+          implementation) (a[0], a[1], a[2], a[3], a[4]);
+      break;
+    case 6:
+      result = ((gsize (*) (gsize, gsize, gsize, gsize, gsize, gsize))
+          implementation) (a[0], a[1], a[2], a[3], a[4], a[5]);
+      break;
+    case 7:
+      result = ((gsize (*) (gsize, gsize, gsize, gsize, gsize, gsize, gsize))
+          implementation) (a[0], a[1], a[2], a[3], a[4], a[5], a[6]);
+      break;
+    case 8:
+      result = ((gsize (*) (gsize, gsize, gsize, gsize, gsize, gsize, gsize,
+          gsize)) implementation) (a[0], a[1], a[2], a[3], a[4], a[5], a[6],
+          a[7]);
+      break;
+    default:
+      g_assert_not_reached ();
+  }
+
+  if (cif->rtype->type != FFI_TYPE_VOID)
+    gum_ffi_value_from_register (cif->rtype, result, rvalue);
+}
@@ -16,6 +16,31 @@ G_BEGIN_DECLS
 
 typedef union _GumFFIValue GumFFIValue;
 
+/*
+ * Dense classification of the ffi_type pointers used by the bindings, so
+ * marshalling plans can be precomputed once at creation time and each
+ * invocation dispatches through a flat switch instead of re-walking the
+ * type-pointer comparison chain per argument.
+ */
+typedef enum _GumFFITypeKind
+{
+  GUM_FFI_KIND_VOID,
+  GUM_FFI_KIND_POINTER,
+  GUM_FFI_KIND_SINT8,
+  GUM_FFI_KIND_UINT8,
+  GUM_FFI_KIND_SINT16,
+  GUM_FFI_KIND_UINT16,
+  GUM_FFI_KIND_SINT32,
+  GUM_FFI_KIND_UINT32,
+  GUM_FFI_KIND_SINT64,
+  GUM_FFI_KIND_UINT64,
+  GUM_FFI_KIND_SIZE,
+  GUM_FFI_KIND_SSIZE,
+  GUM_FFI_KIND_FLOAT,
+  GUM_FFI_KIND_DOUBLE,
+  GUM_FFI_KIND_STRUCT
+} GumFFITypeKind;
+
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
 
 union _GumFFIValue
@@ -167,11 +192,15 @@ union _GumFFIValue
 extern ffi_type gum_ffi_type_size_t;
 extern ffi_type gum_ffi_type_ssize_t;
 
+G_GNUC_INTERNAL GumFFITypeKind gum_ffi_classify_type (const ffi_type * type);
 G_GNUC_INTERNAL gboolean gum_ffi_try_get_type_by_name (const gchar * name,
     ffi_type ** type);
 G_GNUC_INTERNAL gboolean gum_ffi_try_get_abi_by_name (const gchar * name,
     ffi_abi * abi);
 G_GNUC_INTERNAL ffi_type * gum_ffi_maybe_promote_variadic (ffi_type * type);
+G_GNUC_INTERNAL gboolean gum_ffi_cif_is_direct_callable (const ffi_cif * cif);
+G_GNUC_INTERNAL void gum_ffi_call_direct (GCallback implementation,
+    const ffi_cif * cif, GumFFIValue * rvalue, void ** avalue);
 
 G_END_DECLS
 
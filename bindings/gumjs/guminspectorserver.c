@@ -13,6 +13,14 @@
 
 #define GUM_INSPECTOR_DEFAULT_PORT 9229
 
+/*
+ * Peers speaking this subprotocol get outbound stanzas coalesced into
+ * binary frames holding one or more big-endian length-prefixed payloads,
+ * and may batch their own stanzas the same way. Peers not opting in,
+ * such as Chrome DevTools, get one text frame per stanza as before.
+ */
+#define GUM_INSPECTOR_BINARY_PROTOCOL "gum-length-prefixed"
+
 typedef struct _GumInspectorPeer GumInspectorPeer;
 
 struct _GumInspectorServer
@@ -24,6 +32,7 @@ struct _GumInspectorServer
   gchar * id;
   gchar * title;
   SoupServer * server;
+  GMainContext * main_context;
   GHashTable * peers;
   guint next_peer_id;
 };
@@ -32,6 +41,10 @@ struct _GumInspectorPeer
 {
   guint id;
   SoupWebsocketConnection * connection;
+  gboolean binary_mode;
+
+  GQueue pending_stanzas;
+  GSource * flush_source;
 
   gulong closed_handler;
   gulong message_handler;
@@ -85,6 +98,7 @@ static GumInspectorPeer * gum_inspector_peer_new (GumInspectorServer * server,
 static void gum_inspector_peer_free (GumInspectorPeer * peer);
 static void gum_inspector_peer_post_stanza (GumInspectorPeer * self,
     const gchar * stanza);
+static gboolean gum_inspector_peer_flush (GumInspectorPeer * self);
 static void gum_inspector_peer_on_closed (GumInspectorPeer * self);
 static void gum_inspector_peer_on_message (GumInspectorPeer * self, gint type,
     GBytes * message);
@@ -119,10 +133,12 @@ gum_inspector_server_class_init (GumInspectorServerClass * klass)
 static void
 gum_inspector_server_init (GumInspectorServer * self)
 {
+  static const char * ws_protocols[] = { GUM_INSPECTOR_BINARY_PROTOCOL, NULL };
   SoupServer * server;
   gchar * ws_path;
 
   self->id = g_uuid_string_random ();
+  self->main_context = g_main_context_ref_thread_default ();
   gum_process_enumerate_modules (gum_store_process_title, &self->title);
 
   server = g_object_new (SOUP_TYPE_SERVER, NULL);
@@ -137,7 +153,8 @@ gum_inspector_server_init (GumInspectorServer * self)
       gum_inspector_server_on_version, self, NULL);
 
   ws_path = g_strconcat ("/", self->id, NULL);
-  soup_server_add_websocket_handler (server, ws_path, NULL, NULL,
+  soup_server_add_websocket_handler (server, ws_path, NULL,
+      (char **) ws_protocols,
       gum_inspector_server_on_websocket_opened, self, NULL);
   g_free (ws_path);
 
@@ -170,6 +187,7 @@ gum_inspector_server_finalize (GObject * object)
 
   g_free (self->id);
   g_free (self->title);
+  g_main_context_unref (self->main_context);
 
   G_OBJECT_CLASS (gum_inspector_server_parent_class)->finalize (object);
 }
@@ -515,6 +533,12 @@ gum_inspector_peer_new (GumInspectorServer * server,
   peer = g_slice_new (GumInspectorPeer);
   peer->id = server->next_peer_id++;
   peer->connection = g_object_ref (connection);
+  peer->binary_mode = g_strcmp0 (
+      soup_websocket_connection_get_protocol (connection),
+      GUM_INSPECTOR_BINARY_PROTOCOL) == 0;
+
+  g_queue_init (&peer->pending_stanzas);
+  peer->flush_source = NULL;
 
   peer->closed_handler = g_signal_connect_swapped (connection, "closed",
       G_CALLBACK (gum_inspector_peer_on_closed), peer);
@@ -530,6 +554,16 @@ static void
 gum_inspector_peer_free (GumInspectorPeer * peer)
 {
   SoupWebsocketConnection * connection = peer->connection;
+  gchar * stanza;
+
+  if (peer->flush_source != NULL)
+  {
+    g_source_destroy (peer->flush_source);
+    g_source_unref (peer->flush_source);
+  }
+
+  while ((stanza = g_queue_pop_head (&peer->pending_stanzas)) != NULL)
+    g_free (stanza);
 
   g_signal_handler_disconnect (connection, peer->closed_handler);
   g_signal_handler_disconnect (connection, peer->message_handler);
@@ -542,7 +576,72 @@ static void
 gum_inspector_peer_post_stanza (GumInspectorPeer * self,
                                 const gchar * stanza)
 {
-  soup_websocket_connection_send_text (self->connection, stanza);
+  g_queue_push_tail (&self->pending_stanzas, g_strdup (stanza));
+
+  if (self->flush_source == NULL)
+  {
+    GSource * source;
+
+    source = g_idle_source_new ();
+    g_source_set_callback (source, (GSourceFunc) gum_inspector_peer_flush,
+        self, NULL);
+    g_source_attach (source, self->server->main_context);
+
+    self->flush_source = source;
+  }
+}
+
+static gboolean
+gum_inspector_peer_flush (GumInspectorPeer * self)
+{
+  SoupWebsocketConnection * connection = self->connection;
+  gboolean connected;
+  gchar * stanza;
+
+  g_source_unref (self->flush_source);
+  self->flush_source = NULL;
+
+  connected = soup_websocket_connection_get_state (connection) ==
+      SOUP_WEBSOCKET_STATE_OPEN;
+
+  if (self->binary_mode && connected)
+  {
+    GByteArray * frame;
+
+    frame = g_byte_array_new ();
+
+    while ((stanza = g_queue_pop_head (&self->pending_stanzas)) != NULL)
+    {
+      gsize size;
+      guint32 size_prefix;
+
+      size = strlen (stanza);
+      size_prefix = GUINT32_TO_BE ((guint32) size);
+
+      g_byte_array_append (frame, (const guint8 *) &size_prefix,
+          sizeof (size_prefix));
+      g_byte_array_append (frame, (const guint8 *) stanza, size);
+
+      g_free (stanza);
+    }
+
+    soup_websocket_connection_send_binary (connection, frame->data,
+        frame->len);
+
+    g_byte_array_unref (frame);
+  }
+  else
+  {
+    while ((stanza = g_queue_pop_head (&self->pending_stanzas)) != NULL)
+    {
+      if (connected)
+        soup_websocket_connection_send_text (connection, stanza);
+
+      g_free (stanza);
+    }
+  }
+
+  return FALSE;
 }
 
 static void
@@ -561,6 +660,34 @@ gum_inspector_peer_on_message (GumInspectorPeer * self,
     gum_inspector_server_on_websocket_stanza (self->server, self,
         g_bytes_get_data (message, NULL));
   }
+  else if (type == SOUP_WEBSOCKET_DATA_BINARY && self->binary_mode)
+  {
+    gconstpointer data;
+    gsize size, offset;
+
+    data = g_bytes_get_data (message, &size);
+
+    offset = 0;
+    while (size - offset >= sizeof (guint32))
+    {
+      guint32 stanza_size;
+      gchar * stanza;
+
+      memcpy (&stanza_size, (const guint8 *) data + offset,
+          sizeof (stanza_size));
+      stanza_size = GUINT32_FROM_BE (stanza_size);
+      offset += sizeof (guint32);
+
+      if (stanza_size > size - offset)
+        break;
+
+      stanza = g_strndup ((const gchar *) data + offset, stanza_size);
+      gum_inspector_server_on_websocket_stanza (self->server, self, stanza);
+      g_free (stanza);
+
+      offset += stanza_size;
+    }
+  }
 }
 
 static gboolean
@@ -0,0 +1,25 @@
+/*
+ * Copyright (C) 2021 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#ifndef __GUM_IO_URING_H__
+#define __GUM_IO_URING_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GumIOUring GumIOUring;
+
+GumIOUring * gum_io_uring_open (gint fd);
+void gum_io_uring_close (GumIOUring * self);
+
+void gum_io_uring_write (GumIOUring * self, gconstpointer data,
+    gsize size);
+void gum_io_uring_drain (GumIOUring * self);
+
+G_END_DECLS
+
+#endif
@@ -12,6 +12,14 @@
 #define GUM_MEMORY_VFS(vfs) ((GumMemoryVfs *) (vfs))
 #define GUM_MEMORY_FILE(f) ((GumMemoryFile *) (f))
 
+/*
+ * File contents are kept in fixed-size chunks so growth never moves
+ * existing data. Chunk addresses thus stay stable, which lets xFetch
+ * hand out direct pointers; the chunk size is a multiple of SQLite's
+ * largest page size, so page-aligned fetches never straddle a boundary.
+ */
+#define GUM_MEMORY_VFS_CHUNK_SIZE (512 * 1024)
+
 typedef struct _GumMemoryFile GumMemoryFile;
 typedef struct _GumMemoryFileEntry GumMemoryFileEntry;
 
@@ -26,8 +34,10 @@ struct _GumMemoryFile
 struct _GumMemoryFileEntry
 {
   guint ref_count;
-  guint8 * data;
+  GPtrArray * chunks;
   gsize size;
+  guint8 * flattened;
+  GPtrArray * shm_regions;
   gint lock_level;
 };
 
@@ -57,6 +67,11 @@ static int gum_memory_vfs_current_time_int64 (sqlite3_vfs * vfs,
 static GumMemoryFileEntry * gum_memory_file_entry_ref (
     GumMemoryFileEntry * self);
 static void gum_memory_file_entry_unref (GumMemoryFileEntry * self);
+static void gum_memory_file_entry_put (GumMemoryFileEntry * self, gsize offset,
+    gconstpointer buffer, gsize amount);
+static void gum_memory_file_entry_get (GumMemoryFileEntry * self, gsize offset,
+    gpointer buffer, gsize amount);
+static gpointer gum_memory_file_entry_get_contents (GumMemoryFileEntry * self);
 static int gum_memory_file_close (sqlite3_file * file);
 static int gum_memory_file_read (sqlite3_file * file, void * buffer, int amount,
     sqlite3_int64 offset);
@@ -191,7 +206,7 @@ gum_memory_vfs_get_file_contents (GumMemoryVfs * self,
   if (entry == NULL)
     return FALSE;
 
-  *contents = entry->data;
+  *contents = gum_memory_file_entry_get_contents (entry);
   *size = entry->size;
 
   return TRUE;
@@ -207,11 +222,19 @@ gum_memory_vfs_add_entry (GumMemoryVfs * self,
 
   entry = g_slice_new (GumMemoryFileEntry);
   entry->ref_count = 1;
-  entry->data = data;
-  entry->size = size;
+  entry->chunks = g_ptr_array_new_with_free_func (g_free);
+  entry->size = 0;
+  entry->flattened = NULL;
+  entry->shm_regions = NULL;
   entry->lock_level = SQLITE_LOCK_NONE;
   g_hash_table_replace (self->entries, path, entry);
 
+  if (data != NULL)
+  {
+    gum_memory_file_entry_put (entry, 0, data, size);
+    g_free (data);
+  }
+
   return entry;
 }
 
@@ -382,12 +405,93 @@ gum_memory_file_entry_unref (GumMemoryFileEntry * self)
 {
   if (--self->ref_count == 0)
   {
-    g_free (self->data);
+    if (self->shm_regions != NULL)
+      g_ptr_array_unref (self->shm_regions);
+    g_free (self->flattened);
+    g_ptr_array_unref (self->chunks);
 
     g_slice_free (GumMemoryFileEntry, self);
   }
 }
 
+static void
+gum_memory_file_entry_put (GumMemoryFileEntry * self,
+                           gsize offset,
+                           gconstpointer buffer,
+                           gsize amount)
+{
+  gsize required_size;
+  const guint8 * source;
+
+  required_size = offset + amount;
+  while ((gsize) self->chunks->len * GUM_MEMORY_VFS_CHUNK_SIZE <
+      required_size)
+  {
+    g_ptr_array_add (self->chunks, g_malloc0 (GUM_MEMORY_VFS_CHUNK_SIZE));
+  }
+
+  source = buffer;
+  while (amount != 0)
+  {
+    guint8 * chunk;
+    gsize offset_in_chunk, n;
+
+    chunk = g_ptr_array_index (self->chunks,
+        offset / GUM_MEMORY_VFS_CHUNK_SIZE);
+    offset_in_chunk = offset % GUM_MEMORY_VFS_CHUNK_SIZE;
+    n = MIN (amount, GUM_MEMORY_VFS_CHUNK_SIZE - offset_in_chunk);
+
+    memcpy (chunk + offset_in_chunk, source, n);
+
+    offset += n;
+    source += n;
+    amount -= n;
+  }
+
+  if (required_size > self->size)
+    self->size = required_size;
+
+  g_free (g_steal_pointer (&self->flattened));
+}
+
+static void
+gum_memory_file_entry_get (GumMemoryFileEntry * self,
+                           gsize offset,
+                           gpointer buffer,
+                           gsize amount)
+{
+  guint8 * target = buffer;
+
+  while (amount != 0)
+  {
+    const guint8 * chunk;
+    gsize offset_in_chunk, n;
+
+    chunk = g_ptr_array_index (self->chunks,
+        offset / GUM_MEMORY_VFS_CHUNK_SIZE);
+    offset_in_chunk = offset % GUM_MEMORY_VFS_CHUNK_SIZE;
+    n = MIN (amount, GUM_MEMORY_VFS_CHUNK_SIZE - offset_in_chunk);
+
+    memcpy (target, chunk + offset_in_chunk, n);
+
+    offset += n;
+    target += n;
+    amount -= n;
+  }
+}
+
+static gpointer
+gum_memory_file_entry_get_contents (GumMemoryFileEntry * self)
+{
+  if (self->flattened == NULL && self->size != 0)
+  {
+    self->flattened = g_malloc (self->size);
+    gum_memory_file_entry_get (self, 0, self->flattened, self->size);
+  }
+
+  return self->flattened;
+}
+
 static int
 gum_memory_file_close (sqlite3_file * file)
 {
@@ -415,7 +519,7 @@ gum_memory_file_read (sqlite3_file * file,
   available = entry->size - offset;
   n = MIN (amount, available);
 
-  memcpy (buffer, entry->data + offset, n);
+  gum_memory_file_entry_get (entry, offset, buffer, n);
 
   if (n < amount)
   {
@@ -434,19 +538,11 @@ gum_memory_file_write (sqlite3_file * file,
 {
   GumMemoryFile * self = GUM_MEMORY_FILE (file);
   GumMemoryFileEntry * entry = self->entry;
-  gsize required_size;
 
   if (offset < 0)
     return SQLITE_IOERR_WRITE;
 
-  required_size = offset + amount;
-  if (required_size > entry->size)
-  {
-    entry->data = g_realloc (entry->data, required_size);
-    entry->size = required_size;
-  }
-
-  memcpy (entry->data + offset, buffer, amount);
+  gum_memory_file_entry_put (entry, offset, buffer, amount);
 
   return SQLITE_OK;
 }
@@ -457,9 +553,27 @@ gum_memory_file_truncate (sqlite3_file * file,
 {
   GumMemoryFile * self = GUM_MEMORY_FILE (file);
   GumMemoryFileEntry * entry = self->entry;
+  guint chunks_needed;
+  gsize tail;
 
-  g_free (g_steal_pointer (&entry->data));
-  entry->size = 0;
+  if (size < 0 || (gsize) size >= entry->size)
+    return SQLITE_OK;
+
+  chunks_needed =
+      ((gsize) size + GUM_MEMORY_VFS_CHUNK_SIZE - 1) /
+      GUM_MEMORY_VFS_CHUNK_SIZE;
+  g_ptr_array_set_size (entry->chunks, chunks_needed);
+
+  tail = (gsize) size % GUM_MEMORY_VFS_CHUNK_SIZE;
+  if (tail != 0)
+  {
+    memset ((guint8 *) g_ptr_array_index (entry->chunks, chunks_needed - 1) +
+        tail, 0, GUM_MEMORY_VFS_CHUNK_SIZE - tail);
+  }
+
+  entry->size = size;
+
+  g_free (g_steal_pointer (&entry->flattened));
 
   return SQLITE_OK;
 }
@@ -547,7 +661,26 @@ gum_memory_file_shm_map (sqlite3_file * file,
                          int extend,
                          void volatile ** memory)
 {
-  return SQLITE_IOERR_NOMEM;
+  GumMemoryFile * self = GUM_MEMORY_FILE (file);
+  GumMemoryFileEntry * entry = self->entry;
+
+  if (entry->shm_regions == NULL)
+    entry->shm_regions = g_ptr_array_new_with_free_func (g_free);
+
+  if ((guint) region >= entry->shm_regions->len)
+  {
+    if (!extend)
+    {
+      *memory = NULL;
+      return SQLITE_OK;
+    }
+
+    while ((guint) region >= entry->shm_regions->len)
+      g_ptr_array_add (entry->shm_regions, g_malloc0 (region_size));
+  }
+
+  *memory = g_ptr_array_index (entry->shm_regions, region);
+  return SQLITE_OK;
 }
 
 static int
@@ -568,6 +701,12 @@ static int
 gum_memory_file_shm_unmap (sqlite3_file * file,
                            int delete_flag)
 {
+  GumMemoryFile * self = GUM_MEMORY_FILE (file);
+  GumMemoryFileEntry * entry = self->entry;
+
+  if (delete_flag && entry->shm_regions != NULL)
+    g_ptr_array_set_size (entry->shm_regions, 0);
+
   return SQLITE_OK;
 }
 
@@ -577,8 +716,26 @@ gum_memory_file_fetch (sqlite3_file * file,
                        int amount,
                        void ** memory)
 {
-  *memory = NULL;
+  GumMemoryFile * self = GUM_MEMORY_FILE (file);
+  GumMemoryFileEntry * entry = self->entry;
+  gsize offset_in_chunk;
+
+  if (offset < 0 || (gsize) offset + amount > entry->size)
+    goto fall_back_to_read;
+
+  offset_in_chunk = (gsize) offset % GUM_MEMORY_VFS_CHUNK_SIZE;
+  if (offset_in_chunk + amount > GUM_MEMORY_VFS_CHUNK_SIZE)
+    goto fall_back_to_read;
+
+  *memory = (guint8 *) g_ptr_array_index (entry->chunks,
+      (gsize) offset / GUM_MEMORY_VFS_CHUNK_SIZE) + offset_in_chunk;
   return SQLITE_OK;
+
+fall_back_to_read:
+  {
+    *memory = NULL;
+    return SQLITE_OK;
+  }
 }
 
 static int
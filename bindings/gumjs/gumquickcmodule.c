@@ -120,7 +120,7 @@ GUMJS_DEFINE_CONSTRUCTOR (gumjs_cmodule_construct)
     goto propagate_exception;
 
   error = NULL;
-  cmodule = gum_cmodule_new (source, &error);
+  cmodule = gum_cmodule_new (source, NULL, &error);
   if (error != NULL)
     goto propagate_error;
 
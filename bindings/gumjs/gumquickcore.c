@@ -18,9 +18,12 @@
 #include "gumsourcemap.h"
 
 #include <ffi.h>
+#include <math.h>
 #ifdef HAVE_PTRAUTH
 # include <ptrauth.h>
 #endif
+#include <string.h>
+#include <gum/gumstats.h>
 
 #define GUM_QUICK_FFI_FUNCTION_PARAMS_EMPTY { NULL, }
 
@@ -31,8 +34,10 @@ typedef guint8 GumQuickSchedulingBehavior;
 typedef guint8 GumQuickExceptionsBehavior;
 typedef guint8 GumQuickCodeTraps;
 typedef guint8 GumQuickReturnValueShape;
+typedef guint GumQuickNativePointerOp;
 typedef struct _GumQuickFFIFunction GumQuickFFIFunction;
 typedef struct _GumQuickNativeCallback GumQuickNativeCallback;
+typedef struct _GumQuickWorker GumQuickWorker;
 
 struct _GumQuickFlushCallback
 {
@@ -74,6 +79,17 @@ struct _GumQuickMessageSink
   GumQuickCore * core;
 };
 
+struct _GumQuickWorker
+{
+  gint ref_count;
+
+  GumQuickCore * core;
+  GThread * thread;
+  GAsyncQueue * inbox;
+  JSValue on_message;
+  gchar * source;
+};
+
 struct _GumQuickFFIFunctionParams
 {
   GCallback implementation;
@@ -112,6 +128,17 @@ enum _GumQuickReturnValueShape
   GUM_QUICK_RETURN_DETAILED
 };
 
+enum _GumQuickNativePointerOp
+{
+  GUM_QUICK_NATIVE_POINTER_ADD,
+  GUM_QUICK_NATIVE_POINTER_SUB,
+  GUM_QUICK_NATIVE_POINTER_AND,
+  GUM_QUICK_NATIVE_POINTER_OR,
+  GUM_QUICK_NATIVE_POINTER_XOR,
+  GUM_QUICK_NATIVE_POINTER_SHR,
+  GUM_QUICK_NATIVE_POINTER_SHL
+};
+
 struct _GumQuickFFIFunction
 {
   GumQuickNativePointer native_pointer;
@@ -125,6 +152,7 @@ struct _GumQuickFFIFunction
   ffi_type ** atypes;
   gsize arglist_size;
   gboolean is_variadic;
+  gboolean is_direct;
   guint nargs_fixed;
   ffi_abi abi;
   GSList * data;
@@ -139,6 +167,7 @@ struct _GumQuickNativeCallback
   ffi_closure * closure;
   ffi_cif cif;
   ffi_type ** atypes;
+  GumFFITypeKind * arg_kinds;
   GSList * data;
 
   GumQuickCore * core;
@@ -155,11 +184,17 @@ GUMJS_DECLARE_FUNCTION (gumjs_set_interval)
 GUMJS_DECLARE_FUNCTION (gumjs_clear_timer)
 GUMJS_DECLARE_FUNCTION (gumjs_gc)
 GUMJS_DECLARE_FUNCTION (gumjs_send)
+GUMJS_DECLARE_FUNCTION (gumjs_send_flat)
+static gboolean gum_quick_json_append_value (JSContext * ctx, JSValue val,
+    GString * output, GumQuickCore * core);
+static void gum_quick_json_append_string (GString * output,
+    const gchar * str);
 GUMJS_DECLARE_FUNCTION (gumjs_set_unhandled_exception_callback)
 GUMJS_DECLARE_FUNCTION (gumjs_set_incoming_message_callback)
 GUMJS_DECLARE_FUNCTION (gumjs_wait_for_event)
 
 GUMJS_DECLARE_GETTER (gumjs_frida_get_heap_size)
+GUMJS_DECLARE_GETTER (gumjs_frida_get_stats)
 GUMJS_DECLARE_GETTER (gumjs_frida_get_source_map)
 GUMJS_DECLARE_GETTER (gumjs_frida_objc_get_source_map)
 GUMJS_DECLARE_GETTER (gumjs_frida_java_get_source_map)
@@ -215,13 +250,8 @@ GUMJS_DECLARE_FUNCTION (gumjs_uint64_value_of)
 GUMJS_DECLARE_CONSTRUCTOR (gumjs_native_pointer_construct)
 GUMJS_DECLARE_FINALIZER (gumjs_native_pointer_finalize)
 GUMJS_DECLARE_FUNCTION (gumjs_native_pointer_is_null)
-GUMJS_DECLARE_FUNCTION (gumjs_native_pointer_add)
-GUMJS_DECLARE_FUNCTION (gumjs_native_pointer_sub)
-GUMJS_DECLARE_FUNCTION (gumjs_native_pointer_and)
-GUMJS_DECLARE_FUNCTION (gumjs_native_pointer_or)
-GUMJS_DECLARE_FUNCTION (gumjs_native_pointer_xor)
-GUMJS_DECLARE_FUNCTION (gumjs_native_pointer_shr)
-GUMJS_DECLARE_FUNCTION (gumjs_native_pointer_shl)
+static JSValue gumjs_native_pointer_binary_op (JSContext * ctx,
+    JSValueConst this_val, int argc, JSValueConst * argv, int magic);
 GUMJS_DECLARE_FUNCTION (gumjs_native_pointer_not)
 GUMJS_DECLARE_FUNCTION (gumjs_native_pointer_sign)
 GUMJS_DECLARE_FUNCTION (gumjs_native_pointer_strip)
@@ -298,6 +328,17 @@ GUMJS_DECLARE_CONSTRUCTOR (gumjs_source_map_construct)
 GUMJS_DECLARE_FINALIZER (gumjs_source_map_finalize)
 GUMJS_DECLARE_FUNCTION (gumjs_source_map_resolve)
 
+GUMJS_DECLARE_CONSTRUCTOR (gumjs_worker_construct)
+GUMJS_DECLARE_FINALIZER (gumjs_worker_finalize)
+GUMJS_DECLARE_FUNCTION (gumjs_worker_post_message)
+GUMJS_DECLARE_FUNCTION (gumjs_worker_terminate)
+static void gum_quick_worker_unref (GumQuickWorker * worker);
+static void gum_quick_worker_request_exit (GumQuickWorker * self);
+static void gum_quick_worker_message_free (gpointer message);
+static gpointer gum_quick_worker_run (GumQuickWorker * self);
+static JSValue gum_quick_worker_post_to_parent (JSContext * ctx,
+    JSValueConst this_val, int argc, JSValueConst * argv);
+
 static JSValue gum_quick_core_schedule_callback (GumQuickCore * self,
     GumQuickArgs * args, gboolean repeat);
 static GumQuickScheduledCallback * gum_quick_core_try_steal_scheduled_callback (
@@ -329,6 +370,9 @@ static gboolean gum_quick_value_to_ffi (JSContext * ctx, JSValueConst sval,
     const ffi_type * type, GumQuickCore * core, GumFFIValue * val);
 static JSValue gum_quick_value_from_ffi (JSContext * ctx,
     const GumFFIValue * val, const ffi_type * type, GumQuickCore * core);
+static JSValue gum_quick_value_from_ffi_kind (JSContext * ctx,
+    const GumFFIValue * val, GumFFITypeKind kind, const ffi_type * type,
+    GumQuickCore * core);
 
 static void gum_quick_core_setup_atoms (GumQuickCore * self);
 static void gum_quick_core_teardown_atoms (GumQuickCore * self);
@@ -341,6 +385,7 @@ static const JSCFunctionListEntry gumjs_root_entries[] =
   JS_CFUNC_DEF ("clearInterval", 1, gumjs_clear_timer),
   JS_CFUNC_DEF ("gc", 0, gumjs_gc),
   JS_CFUNC_DEF ("_send", 0, gumjs_send),
+  JS_CFUNC_DEF ("_sendFlat", 0, gumjs_send_flat),
   JS_CFUNC_DEF ("_setUnhandledExceptionCallback", 0,
       gumjs_set_unhandled_exception_callback),
   JS_CFUNC_DEF ("_setIncomingMessageCallback", 0,
@@ -352,6 +397,7 @@ static const JSCFunctionListEntry gumjs_frida_entries[] =
 {
   JS_PROP_STRING_DEF ("version", FRIDA_VERSION, JS_PROP_C_W_E),
   JS_CGETSET_DEF ("heapSize", gumjs_frida_get_heap_size, NULL),
+  JS_CGETSET_DEF ("stats", gumjs_frida_get_stats, NULL),
   JS_CGETSET_DEF ("sourceMap", gumjs_frida_get_source_map, NULL),
   JS_CGETSET_DEF ("_objcSourceMap", gumjs_frida_objc_get_source_map, NULL),
   JS_CGETSET_DEF ("_javaSourceMap", gumjs_frida_java_get_source_map, NULL),
@@ -438,13 +484,20 @@ static const JSClassDef gumjs_native_pointer_def =
 static const JSCFunctionListEntry gumjs_native_pointer_entries[] =
 {
   JS_CFUNC_DEF ("isNull", 0, gumjs_native_pointer_is_null),
-  JS_CFUNC_DEF ("add", 0, gumjs_native_pointer_add),
-  JS_CFUNC_DEF ("sub", 0, gumjs_native_pointer_sub),
-  JS_CFUNC_DEF ("and", 0, gumjs_native_pointer_and),
-  JS_CFUNC_DEF ("or", 0, gumjs_native_pointer_or),
-  JS_CFUNC_DEF ("xor", 0, gumjs_native_pointer_xor),
-  JS_CFUNC_DEF ("shr", 0, gumjs_native_pointer_shr),
-  JS_CFUNC_DEF ("shl", 0, gumjs_native_pointer_shl),
+  JS_CFUNC_MAGIC_DEF ("add", 0, gumjs_native_pointer_binary_op,
+      GUM_QUICK_NATIVE_POINTER_ADD),
+  JS_CFUNC_MAGIC_DEF ("sub", 0, gumjs_native_pointer_binary_op,
+      GUM_QUICK_NATIVE_POINTER_SUB),
+  JS_CFUNC_MAGIC_DEF ("and", 0, gumjs_native_pointer_binary_op,
+      GUM_QUICK_NATIVE_POINTER_AND),
+  JS_CFUNC_MAGIC_DEF ("or", 0, gumjs_native_pointer_binary_op,
+      GUM_QUICK_NATIVE_POINTER_OR),
+  JS_CFUNC_MAGIC_DEF ("xor", 0, gumjs_native_pointer_binary_op,
+      GUM_QUICK_NATIVE_POINTER_XOR),
+  JS_CFUNC_MAGIC_DEF ("shr", 0, gumjs_native_pointer_binary_op,
+      GUM_QUICK_NATIVE_POINTER_SHR),
+  JS_CFUNC_MAGIC_DEF ("shl", 0, gumjs_native_pointer_binary_op,
+      GUM_QUICK_NATIVE_POINTER_SHL),
   JS_CFUNC_DEF ("not", 0, gumjs_native_pointer_not),
   JS_CFUNC_DEF ("sign", 0, gumjs_native_pointer_sign),
   JS_CFUNC_DEF ("strip", 0, gumjs_native_pointer_strip),
@@ -835,6 +888,18 @@ static const JSCFunctionListEntry gumjs_source_map_entries[] =
   JS_CFUNC_DEF ("_resolve", 0, gumjs_source_map_resolve),
 };
 
+static const JSClassDef gumjs_worker_def =
+{
+  .class_name = "Worker",
+  .finalizer = gumjs_worker_finalize,
+};
+
+static const JSCFunctionListEntry gumjs_worker_entries[] =
+{
+  JS_CFUNC_DEF ("postMessage", 0, gumjs_worker_post_message),
+  JS_CFUNC_DEF ("terminate", 0, gumjs_worker_terminate),
+};
+
 void
 _gum_quick_core_init (GumQuickCore * self,
                       GumQuickScript * script,
@@ -849,6 +914,7 @@ _gum_quick_core_init (GumQuickCore * self,
 {
   JSRuntime * rt;
   JSValue global_obj, obj, proto, ctor, uint64_proto;
+  guint i;
 
   rt = JS_GetRuntime (ctx);
 
@@ -902,8 +968,13 @@ _gum_quick_core_init (GumQuickCore * self,
   self->scheduled_callbacks = g_hash_table_new (NULL, NULL);
   self->next_callback_id = 1;
 
+  self->workers = g_hash_table_new (NULL, NULL);
+
   self->subclasses = g_hash_table_new (NULL, NULL);
 
+  for (i = 0; i != GUM_QUICK_INTERNED_POINTER_CAPACITY; i++)
+    self->interned_pointer_wrappers[i] = JS_UNDEFINED;
+
   JS_SetPropertyFunctionList (ctx, ns, gumjs_root_entries,
       G_N_ELEMENTS (gumjs_root_entries));
 
@@ -1021,6 +1092,16 @@ _gum_quick_core_init (GumQuickCore * self,
   JS_DefinePropertyValueStr (ctx, ns, gumjs_source_map_def.class_name, ctor,
       JS_PROP_C_W_E);
 
+  _gum_quick_create_class (ctx, &gumjs_worker_def, self, &self->worker_class,
+      &proto);
+  ctor = JS_NewCFunction2 (ctx, gumjs_worker_construct,
+      gumjs_worker_def.class_name, 0, JS_CFUNC_constructor, 0);
+  JS_SetConstructor (ctx, ctor, proto);
+  JS_SetPropertyFunctionList (ctx, proto, gumjs_worker_entries,
+      G_N_ELEMENTS (gumjs_worker_entries));
+  JS_DefinePropertyValueStr (ctx, ns, gumjs_worker_def.class_name, ctor,
+      JS_PROP_C_W_E);
+
   JS_FreeValue (ctx, global_obj);
 
   gum_exceptor_add (self->exceptor, gum_quick_core_handle_crashed_js, self);
@@ -1051,6 +1132,7 @@ _gum_quick_core_flush (GumQuickCore * self,
 {
   JSContext * ctx = self->ctx;
   GHashTableIter iter;
+  GumQuickWorker * worker;
   GumQuickScheduledCallback * callback;
   JSValue old_objects;
   gboolean done;
@@ -1063,6 +1145,10 @@ _gum_quick_core_flush (GumQuickCore * self,
   g_mutex_unlock (&self->event_mutex);
   g_main_loop_quit (self->event_loop);
 
+  g_hash_table_iter_init (&iter, self->workers);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &worker, NULL))
+    gum_quick_worker_request_exit (worker);
+
   if (self->usage_count > 1)
     return FALSE;
 
@@ -1126,6 +1212,7 @@ void
 _gum_quick_core_dispose (GumQuickCore * self)
 {
   JSContext * ctx = self->ctx;
+  guint i;
 
   g_assert (g_hash_table_size (self->weak_callbacks) == 0);
 
@@ -1145,6 +1232,12 @@ _gum_quick_core_dispose (GumQuickCore * self)
   g_object_unref (self->exceptor);
   self->exceptor = NULL;
 
+  for (i = 0; i != GUM_QUICK_INTERNED_POINTER_CAPACITY; i++)
+  {
+    JS_FreeValue (ctx, self->interned_pointer_wrappers[i]);
+    self->interned_pointer_wrappers[i] = JS_UNDEFINED;
+  }
+
   JS_FreeValue (ctx, self->source_map_ctor);
   JS_FreeValue (ctx, self->native_pointer_proto);
 
@@ -1171,6 +1264,9 @@ _gum_quick_core_finalize (GumQuickCore * self)
   g_hash_table_unref (self->scheduled_callbacks);
   self->scheduled_callbacks = NULL;
 
+  g_hash_table_unref (self->workers);
+  self->workers = NULL;
+
   g_hash_table_unref (self->weak_callbacks);
   self->weak_callbacks = NULL;
 
@@ -1476,6 +1572,22 @@ GUMJS_DEFINE_GETTER (gumjs_frida_get_heap_size)
   return JS_NewUint32 (ctx, gum_peek_private_memory_usage ());
 }
 
+GUMJS_DEFINE_GETTER (gumjs_frida_get_stats)
+{
+  JSValue stats;
+  guint id;
+
+  stats = JS_NewObject (ctx);
+
+  for (id = 0; id != GUM_STAT_COUNT; id++)
+  {
+    JS_DefinePropertyValueStr (ctx, stats, gum_stats_get_name (id),
+        JS_NewInt64 (ctx, gum_stats_get (id)), JS_PROP_C_W_E);
+  }
+
+  return stats;
+}
+
 GUMJS_DEFINE_GETTER (gumjs_frida_get_source_map)
 {
   return gumjs_source_map_new (core->runtime_source_map, core);
@@ -1871,6 +1983,267 @@ GUMJS_DEFINE_FUNCTION (gumjs_send)
   return JS_UNDEFINED;
 }
 
+/*
+ * Fast path for send() with a flat payload: the message envelope is
+ * serialized natively into a single buffer, so no intermediate message
+ * object, JSON.stringify() pass, or resulting JS string is created.
+ * Returns false when the payload is not flat, in which case the runtime
+ * falls back to the regular path; for the subset handled here the output
+ * is identical to what that fallback would have produced.
+ */
+GUMJS_DEFINE_FUNCTION (gumjs_send_flat)
+{
+  JSValue result;
+  GumQuickCore * self = core;
+  GumInterceptor * interceptor = self->interceptor->interceptor;
+  JSValue payload;
+  GBytes * data;
+  GString * message;
+  gboolean serializable;
+  JSPropertyEnum * properties = NULL;
+  uint32_t n = 0;
+  uint32_t i;
+
+  if (!_gum_quick_args_parse (args, "VB?", &payload, &data))
+    return JS_EXCEPTION;
+
+  message = g_string_sized_new (128);
+  g_string_append (message, "{\"type\":\"send\",\"payload\":");
+
+  if (gum_quick_json_append_value (ctx, payload, message, core))
+  {
+    serializable = TRUE;
+  }
+  else if (JS_IsObject (payload) && !JS_IsArray (ctx, payload) &&
+      !JS_IsFunction (ctx, payload))
+  {
+    JSValue to_json;
+    gboolean first = TRUE;
+
+    to_json = JS_GetPropertyStr (ctx, payload, "toJSON");
+    if (JS_IsException (to_json))
+      goto propagate_exception;
+    serializable = JS_IsUndefined (to_json);
+    JS_FreeValue (ctx, to_json);
+
+    if (serializable)
+    {
+      if (JS_GetOwnPropertyNames (ctx, &properties, &n, payload,
+          JS_GPN_STRING_MASK | JS_GPN_ENUM_ONLY) != 0)
+        goto propagate_exception;
+
+      g_string_append_c (message, '{');
+
+      for (i = 0; i != n && serializable; i++)
+      {
+        const char * key;
+        JSValue val;
+
+        val = JS_GetProperty (ctx, payload, properties[i].atom);
+        if (JS_IsException (val))
+          goto propagate_exception;
+
+        if (JS_IsUndefined (val) || JS_IsFunction (ctx, val) ||
+            JS_IsSymbol (val))
+        {
+          JS_FreeValue (ctx, val);
+          continue;
+        }
+
+        key = JS_AtomToCString (ctx, properties[i].atom);
+        if (key == NULL)
+        {
+          JS_FreeValue (ctx, val);
+          goto propagate_exception;
+        }
+
+        if (!first)
+          g_string_append_c (message, ',');
+        first = FALSE;
+
+        gum_quick_json_append_string (message, key);
+        g_string_append_c (message, ':');
+
+        serializable = gum_quick_json_append_value (ctx, val, message, core);
+
+        JS_FreeCString (ctx, key);
+        JS_FreeValue (ctx, val);
+      }
+
+      g_string_append_c (message, '}');
+    }
+  }
+  else
+  {
+    serializable = FALSE;
+  }
+
+  if (serializable)
+  {
+    g_string_append_c (message, '}');
+
+    gum_interceptor_end_transaction (interceptor);
+    gum_interceptor_begin_transaction (interceptor);
+
+    self->message_emitter (self->script, message->str, data);
+  }
+
+  result = JS_NewBool (ctx, serializable);
+  goto beach;
+
+propagate_exception:
+  {
+    result = JS_EXCEPTION;
+    goto beach;
+  }
+beach:
+  {
+    for (i = 0; i != n; i++)
+      JS_FreeAtom (ctx, properties[i].atom);
+    js_free (ctx, properties);
+
+    g_string_free (message, TRUE);
+
+    return result;
+  }
+}
+
+static gboolean
+gum_quick_json_append_value (JSContext * ctx,
+                             JSValue val,
+                             GString * output,
+                             GumQuickCore * core)
+{
+  if (JS_IsString (val))
+  {
+    const gchar * str;
+
+    str = JS_ToCString (ctx, val);
+    if (str == NULL)
+      return FALSE;
+
+    gum_quick_json_append_string (output, str);
+
+    JS_FreeCString (ctx, str);
+
+    return TRUE;
+  }
+
+  if (JS_IsNull (val))
+  {
+    g_string_append (output, "null");
+    return TRUE;
+  }
+
+  if (JS_IsBool (val))
+  {
+    g_string_append (output, JS_ToBool (ctx, val) ? "true" : "false");
+    return TRUE;
+  }
+
+  if (JS_VALUE_GET_TAG (val) == JS_TAG_INT)
+  {
+    g_string_append_printf (output, "%d", JS_VALUE_GET_INT (val));
+    return TRUE;
+  }
+
+  if (JS_VALUE_GET_TAG (val) == JS_TAG_FLOAT64)
+  {
+    gdouble d;
+    gint64 i;
+
+    d = JS_VALUE_GET_FLOAT64 (val);
+    if (!isfinite (d) || d <= -9007199254740992.0 || d >= 9007199254740992.0)
+      return FALSE;
+
+    i = (gint64) d;
+    if ((gdouble) i != d)
+      return FALSE;
+
+    g_string_append_printf (output, "%" G_GINT64_FORMAT, i);
+
+    return TRUE;
+  }
+
+  if (JS_IsObject (val))
+  {
+    GumQuickNativePointer * ptr;
+    GumQuickInt64 * i64;
+    GumQuickUInt64 * u64;
+
+    ptr = JS_GetOpaque (val, core->native_pointer_class);
+    if (ptr != NULL)
+    {
+      g_string_append_printf (output, "\"0x%" G_GSIZE_MODIFIER "x\"",
+          GPOINTER_TO_SIZE (ptr->value));
+      return TRUE;
+    }
+
+    i64 = JS_GetOpaque (val, core->int64_class);
+    if (i64 != NULL)
+    {
+      g_string_append_printf (output, "\"%" G_GINT64_FORMAT "\"", i64->value);
+      return TRUE;
+    }
+
+    u64 = JS_GetOpaque (val, core->uint64_class);
+    if (u64 != NULL)
+    {
+      g_string_append_printf (output, "\"%" G_GUINT64_FORMAT "\"", u64->value);
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+static void
+gum_quick_json_append_string (GString * output,
+                              const gchar * str)
+{
+  const gchar * p;
+
+  g_string_append_c (output, '"');
+
+  for (p = str; *p != '\0'; p++)
+  {
+    gchar c = *p;
+
+    switch (c)
+    {
+      case '"':
+        g_string_append (output, "\\\"");
+        break;
+      case '\\':
+        g_string_append (output, "\\\\");
+        break;
+      case '\b':
+        g_string_append (output, "\\b");
+        break;
+      case '\f':
+        g_string_append (output, "\\f");
+        break;
+      case '\n':
+        g_string_append (output, "\\n");
+        break;
+      case '\r':
+        g_string_append (output, "\\r");
+        break;
+      case '\t':
+        g_string_append (output, "\\t");
+        break;
+      default:
+        if ((guchar) c < 0x20)
+          g_string_append_printf (output, "\\u%04x", (guint) (guchar) c);
+        else
+          g_string_append_c (output, c);
+        break;
+    }
+  }
+
+  g_string_append_c (output, '"');
+}
+
 GUMJS_DEFINE_FUNCTION (gumjs_set_unhandled_exception_callback)
 {
   GumQuickCore * self = core;
@@ -2316,36 +2689,69 @@ GUMJS_DEFINE_FUNCTION (gumjs_native_pointer_is_null)
   return JS_NewBool (ctx, self->value == NULL);
 }
 
-#define GUM_DEFINE_NATIVE_POINTER_BINARY_OP_IMPL(name, op) \
-    GUMJS_DEFINE_FUNCTION (gumjs_native_pointer_##name) \
-    { \
-      GumQuickNativePointer * self; \
-      gpointer lhs_ptr, rhs_ptr; \
-      gsize lhs_bits, rhs_bits; \
-      gpointer result; \
-      \
-      if (!_gum_quick_native_pointer_unwrap (ctx, this_val, core, &self)) \
-        return JS_EXCEPTION; \
-      lhs_ptr = self->value; \
-      \
-      if (!_gum_quick_args_parse (args, "p~", &rhs_ptr)) \
-        return JS_EXCEPTION; \
-      \
-      lhs_bits = GPOINTER_TO_SIZE (lhs_ptr); \
-      rhs_bits = GPOINTER_TO_SIZE (rhs_ptr); \
-      \
-      result = GSIZE_TO_POINTER (lhs_bits op rhs_bits); \
-      \
-      return _gum_quick_native_pointer_new (ctx, result, core); \
-    }
+/*
+ * Pointer arithmetic is hot enough in typical scripts that going through
+ * GumQuickArgs for a single operand shows up in profiles, so all binary
+ * operators share one magic-dispatched handler that decodes its operand
+ * directly.
+ */
 
-GUM_DEFINE_NATIVE_POINTER_BINARY_OP_IMPL (add, +)
-GUM_DEFINE_NATIVE_POINTER_BINARY_OP_IMPL (sub, -)
-GUM_DEFINE_NATIVE_POINTER_BINARY_OP_IMPL (and, &)
-GUM_DEFINE_NATIVE_POINTER_BINARY_OP_IMPL (or,  |)
-GUM_DEFINE_NATIVE_POINTER_BINARY_OP_IMPL (xor, ^)
-GUM_DEFINE_NATIVE_POINTER_BINARY_OP_IMPL (shr, >>)
-GUM_DEFINE_NATIVE_POINTER_BINARY_OP_IMPL (shl, <<)
+static JSValue
+gumjs_native_pointer_binary_op (JSContext * ctx,
+                                JSValueConst this_val,
+                                int argc,
+                                JSValueConst * argv,
+                                int magic)
+{
+  GumQuickCore * core;
+  GumQuickNativePointer * self;
+  gpointer rhs_ptr;
+  gsize lhs_bits, rhs_bits;
+  gpointer result;
+
+  core = JS_GetContextOpaque (ctx);
+
+  if (!_gum_quick_native_pointer_unwrap (ctx, this_val, core, &self))
+    return JS_EXCEPTION;
+
+  if (argc == 0 || JS_IsUndefined (argv[0]))
+    return _gum_quick_throw_literal (ctx, "missing argument");
+
+  if (!_gum_quick_native_pointer_parse (ctx, argv[0], core, &rhs_ptr))
+    return JS_EXCEPTION;
+
+  lhs_bits = GPOINTER_TO_SIZE (self->value);
+  rhs_bits = GPOINTER_TO_SIZE (rhs_ptr);
+
+  switch ((GumQuickNativePointerOp) magic)
+  {
+    case GUM_QUICK_NATIVE_POINTER_ADD:
+      result = GSIZE_TO_POINTER (lhs_bits + rhs_bits);
+      break;
+    case GUM_QUICK_NATIVE_POINTER_SUB:
+      result = GSIZE_TO_POINTER (lhs_bits - rhs_bits);
+      break;
+    case GUM_QUICK_NATIVE_POINTER_AND:
+      result = GSIZE_TO_POINTER (lhs_bits & rhs_bits);
+      break;
+    case GUM_QUICK_NATIVE_POINTER_OR:
+      result = GSIZE_TO_POINTER (lhs_bits | rhs_bits);
+      break;
+    case GUM_QUICK_NATIVE_POINTER_XOR:
+      result = GSIZE_TO_POINTER (lhs_bits ^ rhs_bits);
+      break;
+    case GUM_QUICK_NATIVE_POINTER_SHR:
+      result = GSIZE_TO_POINTER (lhs_bits >> rhs_bits);
+      break;
+    case GUM_QUICK_NATIVE_POINTER_SHL:
+      result = GSIZE_TO_POINTER (lhs_bits << rhs_bits);
+      break;
+    default:
+      g_assert_not_reached ();
+  }
+
+  return _gum_quick_native_pointer_new (ctx, result, core);
+}
 
 #define GUM_DEFINE_NATIVE_POINTER_UNARY_OP_IMPL(name, op) \
     GUMJS_DEFINE_FUNCTION (gumjs_native_pointer_##name) \
@@ -2868,6 +3274,8 @@ gumjs_ffi_function_new (JSContext * ctx,
   }
 
   func->is_variadic = nargs_fixed < nargs_total;
+  func->is_direct = !func->is_variadic &&
+      gum_ffi_cif_is_direct_callable (&func->cif);
   func->nargs_fixed = nargs_fixed;
   func->abi = abi;
 
@@ -3067,7 +3475,10 @@ gum_quick_ffi_function_invoke (GumQuickFFIFunction * self,
             GUM_FUNCPTR_TO_POINTER (implementation));
       }
 
-      ffi_call (cif, implementation, rvalue, avalue);
+      if (self->is_direct)
+        gum_ffi_call_direct (implementation, cif, rvalue, avalue);
+      else
+        ffi_call (cif, implementation, rvalue, avalue);
 
       g_clear_pointer (&stalker, gum_stalker_deactivate);
 
@@ -3525,6 +3936,15 @@ GUMJS_DEFINE_CONSTRUCTOR (gumjs_native_callback_construct)
     val = JS_NULL;
   }
 
+  /*
+   * The argument types are declared up front, so precompute the
+   * marshalling plan here instead of re-classifying each type on every
+   * invocation.
+   */
+  cb->arg_kinds = g_new (GumFFITypeKind, nargs);
+  for (i = 0; i != nargs; i++)
+    cb->arg_kinds[i] = gum_ffi_classify_type (cb->atypes[i]);
+
   if (abi_str != NULL)
   {
     if (!gum_quick_ffi_abi_get (ctx, abi_str, &abi))
@@ -3602,6 +4022,7 @@ gum_quick_native_callback_finalize (GumQuickNativeCallback * callback)
     g_free (head->data);
     callback->data = g_slist_delete_link (callback->data, head);
   }
+  g_free (callback->arg_kinds);
   g_free (callback->atypes);
 
   g_slice_free (GumQuickNativeCallback, callback);
@@ -3657,7 +4078,10 @@ gum_quick_native_callback_invoke (ffi_cif * cif,
   argv = g_newa (JSValue, argc);
 
   for (i = 0; i != argc; i++)
-    argv[i] = gum_quick_value_from_ffi (ctx, args[i], cif->arg_types[i], core);
+  {
+    argv[i] = gum_quick_value_from_ffi_kind (ctx, args[i], self->arg_kinds[i],
+        cif->arg_types[i], core);
+  }
 
   result = _gum_quick_scope_call (&scope, self->func, this_obj, argc, argv);
 
@@ -3855,6 +4279,232 @@ GUMJS_DEFINE_FUNCTION (gumjs_source_map_resolve)
   }
 }
 
+/*
+ * Runs the provided source in its own JSRuntime on a dedicated thread,
+ * so CPU-heavy analysis can proceed while the main script keeps
+ * ingesting events. Messages are strings in both directions: the worker
+ * global gets postMessage () and may define onMessage (), and replies
+ * are delivered to the callback given to the constructor. The worker
+ * pins the core until it has exited, and script teardown asks every
+ * worker to wind down.
+ */
+GUMJS_DEFINE_CONSTRUCTOR (gumjs_worker_construct)
+{
+  JSValue wrapper = JS_NULL;
+  const gchar * source;
+  JSValue on_message, proto;
+  GumQuickWorker * worker;
+
+  if (!_gum_quick_args_parse (args, "sF", &source, &on_message))
+    goto propagate_exception;
+
+  proto = JS_GetProperty (ctx, new_target,
+      GUM_QUICK_CORE_ATOM (core, prototype));
+  wrapper = JS_NewObjectProtoClass (ctx, proto, core->worker_class);
+  JS_FreeValue (ctx, proto);
+  if (JS_IsException (wrapper))
+    goto propagate_exception;
+
+  worker = g_slice_new (GumQuickWorker);
+  worker->ref_count = 2;
+  worker->core = core;
+  worker->inbox = g_async_queue_new_full (gum_quick_worker_message_free);
+  worker->on_message = JS_DupValue (ctx, on_message);
+  worker->source = g_strdup (source);
+
+  g_hash_table_add (core->workers, worker);
+  _gum_quick_core_pin (core);
+
+  worker->thread = g_thread_new ("gum-js-worker",
+      (GThreadFunc) gum_quick_worker_run, worker);
+
+  JS_SetOpaque (wrapper, worker);
+
+  return wrapper;
+
+propagate_exception:
+  {
+    JS_FreeValue (ctx, wrapper);
+
+    return JS_EXCEPTION;
+  }
+}
+
+GUMJS_DEFINE_FINALIZER (gumjs_worker_finalize)
+{
+  GumQuickWorker * w;
+
+  w = JS_GetOpaque (val, core->worker_class);
+  if (w == NULL)
+    return;
+
+  gum_quick_worker_request_exit (w);
+
+  JS_FreeValue (ctx, w->on_message);
+  w->on_message = JS_NULL;
+
+  gum_quick_worker_unref (w);
+}
+
+GUMJS_DEFINE_FUNCTION (gumjs_worker_post_message)
+{
+  GumQuickWorker * self;
+  const gchar * message;
+
+  if (!_gum_quick_unwrap (ctx, this_val, core->worker_class, core,
+      (gpointer *) &self))
+    return JS_EXCEPTION;
+
+  if (!_gum_quick_args_parse (args, "s", &message))
+    return JS_EXCEPTION;
+
+  g_async_queue_push (self->inbox, g_strdup (message));
+
+  return JS_UNDEFINED;
+}
+
+GUMJS_DEFINE_FUNCTION (gumjs_worker_terminate)
+{
+  GumQuickWorker * self;
+
+  if (!_gum_quick_unwrap (ctx, this_val, core->worker_class, core,
+      (gpointer *) &self))
+    return JS_EXCEPTION;
+
+  gum_quick_worker_request_exit (self);
+
+  return JS_UNDEFINED;
+}
+
+static void
+gum_quick_worker_unref (GumQuickWorker * worker)
+{
+  if (!g_atomic_int_dec_and_test (&worker->ref_count))
+    return;
+
+  g_thread_unref (worker->thread);
+  g_async_queue_unref (worker->inbox);
+  g_free (worker->source);
+
+  g_slice_free (GumQuickWorker, worker);
+}
+
+static gchar gum_quick_worker_exit_request;
+
+static void
+gum_quick_worker_request_exit (GumQuickWorker * self)
+{
+  g_async_queue_push (self->inbox, &gum_quick_worker_exit_request);
+}
+
+static void
+gum_quick_worker_message_free (gpointer message)
+{
+  if (message != (gpointer) &gum_quick_worker_exit_request)
+    g_free (message);
+}
+
+static gpointer
+gum_quick_worker_run (GumQuickWorker * self)
+{
+  JSRuntime * rt;
+  JSContext * ctx;
+  JSValue global, result;
+  GumQuickScope scope;
+
+  rt = JS_NewRuntime ();
+  ctx = JS_NewContext (rt);
+  JS_SetContextOpaque (ctx, self);
+
+  global = JS_GetGlobalObject (ctx);
+  JS_SetPropertyStr (ctx, global, "postMessage",
+      JS_NewCFunction (ctx, gum_quick_worker_post_to_parent, "postMessage",
+          1));
+
+  result = JS_Eval (ctx, self->source, strlen (self->source), "worker.js",
+      JS_EVAL_TYPE_GLOBAL);
+  if (!JS_IsException (result))
+  {
+    JSValue on_message;
+    gpointer message;
+
+    on_message = JS_GetPropertyStr (ctx, global, "onMessage");
+
+    while ((message = g_async_queue_pop (self->inbox)) !=
+        (gpointer) &gum_quick_worker_exit_request)
+    {
+      if (JS_IsFunction (ctx, on_message))
+      {
+        JSValue message_val, ret;
+
+        message_val = JS_NewString (ctx, message);
+        ret = JS_Call (ctx, on_message, JS_UNDEFINED, 1, &message_val);
+        JS_FreeValue (ctx, ret);
+        JS_FreeValue (ctx, message_val);
+      }
+
+      g_free (message);
+    }
+
+    JS_FreeValue (ctx, on_message);
+  }
+  JS_FreeValue (ctx, result);
+
+  JS_FreeValue (ctx, global);
+  JS_FreeContext (ctx);
+  JS_FreeRuntime (rt);
+
+  _gum_quick_scope_enter (&scope, self->core);
+  g_hash_table_remove (self->core->workers, self);
+  _gum_quick_core_unpin (self->core);
+  _gum_quick_scope_leave (&scope);
+
+  gum_quick_worker_unref (self);
+
+  return NULL;
+}
+
+static JSValue
+gum_quick_worker_post_to_parent (JSContext * ctx,
+                                 JSValueConst this_val,
+                                 int argc,
+                                 JSValueConst * argv)
+{
+  GumQuickWorker * self = JS_GetContextOpaque (ctx);
+  const char * message;
+  GumQuickCore * core;
+  GumQuickScope scope;
+
+  if (argc < 1)
+    return JS_ThrowTypeError (ctx, "missing argument");
+
+  message = JS_ToCString (ctx, argv[0]);
+  if (message == NULL)
+    return JS_EXCEPTION;
+
+  core = self->core;
+
+  _gum_quick_scope_enter (&scope, core);
+
+  if (!JS_IsNull (self->on_message))
+  {
+    JSValue message_val;
+
+    message_val = JS_NewString (core->ctx, message);
+
+    _gum_quick_scope_call_void (&scope, self->on_message, JS_UNDEFINED, 1,
+        &message_val);
+
+    JS_FreeValue (core->ctx, message_val);
+  }
+
+  _gum_quick_scope_leave (&scope);
+
+  JS_FreeCString (ctx, message);
+
+  return JS_UNDEFINED;
+}
+
 static JSValue
 gum_quick_core_schedule_callback (GumQuickCore * self,
                                   GumQuickArgs * args,
@@ -4445,6 +5095,58 @@ gum_quick_value_from_ffi (JSContext * ctx,
   }
 }
 
+static JSValue
+gum_quick_value_from_ffi_kind (JSContext * ctx,
+                               const GumFFIValue * val,
+                               GumFFITypeKind kind,
+                               const ffi_type * type,
+                               GumQuickCore * core)
+{
+  switch (kind)
+  {
+    case GUM_FFI_KIND_VOID:
+      return JS_UNDEFINED;
+    case GUM_FFI_KIND_POINTER:
+      return _gum_quick_native_pointer_new (ctx, val->v_pointer, core);
+    case GUM_FFI_KIND_SINT8:
+      return JS_NewInt32 (ctx, val->v_sint8);
+    case GUM_FFI_KIND_UINT8:
+      return JS_NewUint32 (ctx, val->v_uint8);
+    case GUM_FFI_KIND_SINT16:
+      return JS_NewInt32 (ctx, val->v_sint16);
+    case GUM_FFI_KIND_UINT16:
+      return JS_NewUint32 (ctx, val->v_uint16);
+    case GUM_FFI_KIND_SINT32:
+      return JS_NewInt32 (ctx, val->v_sint32);
+    case GUM_FFI_KIND_UINT32:
+      return JS_NewUint32 (ctx, val->v_uint32);
+    case GUM_FFI_KIND_SINT64:
+      return _gum_quick_int64_new (ctx, val->v_sint64, core);
+    case GUM_FFI_KIND_UINT64:
+      return _gum_quick_uint64_new (ctx, val->v_uint64, core);
+    case GUM_FFI_KIND_SIZE:
+#if GLIB_SIZEOF_SIZE_T == 8
+      return _gum_quick_uint64_new (ctx, val->v_uint64, core);
+#else
+      return _gum_quick_uint64_new (ctx, val->v_uint32, core);
+#endif
+    case GUM_FFI_KIND_SSIZE:
+#if GLIB_SIZEOF_SIZE_T == 8
+      return _gum_quick_int64_new (ctx, val->v_sint64, core);
+#else
+      return _gum_quick_int64_new (ctx, val->v_sint32, core);
+#endif
+    case GUM_FFI_KIND_FLOAT:
+      return JS_NewFloat64 (ctx, val->v_float);
+    case GUM_FFI_KIND_DOUBLE:
+      return JS_NewFloat64 (ctx, val->v_double);
+    case GUM_FFI_KIND_STRUCT:
+      return gum_quick_value_from_ffi (ctx, val, type, core);
+    default:
+      g_assert_not_reached ();
+  }
+}
+
 static void
 gum_quick_core_setup_atoms (GumQuickCore * self)
 {
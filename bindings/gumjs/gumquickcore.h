@@ -18,6 +18,8 @@
 
 #define GUM_QUICK_SCOPE_INIT(core) { core, NULL, }
 
+#define GUM_QUICK_INTERNED_POINTER_CAPACITY 64
+
 #ifdef HAVE_WINDOWS
 # define GUMJS_SYSTEM_ERROR_FIELD "lastError"
 #else
@@ -94,6 +96,8 @@ struct _GumQuickCore
   GHashTable * scheduled_callbacks;
   guint next_callback_id;
 
+  GHashTable * workers;
+
   GHashTable * subclasses;
 
   JSClassID weak_ref_class;
@@ -101,6 +105,8 @@ struct _GumQuickCore
   JSClassID uint64_class;
   JSClassID native_pointer_class;
   JSValue native_pointer_proto;
+  gpointer interned_pointer_values[GUM_QUICK_INTERNED_POINTER_CAPACITY];
+  JSValue interned_pointer_wrappers[GUM_QUICK_INTERNED_POINTER_CAPACITY];
   JSClassID native_resource_class;
   JSClassID kernel_resource_class;
   JSClassID native_function_class;
@@ -109,6 +115,7 @@ struct _GumQuickCore
   JSClassID cpu_context_class;
   JSClassID source_map_class;
   JSValue source_map_ctor;
+  JSClassID worker_class;
 
 #define GUM_DECLARE_ATOM(id) \
     JSAtom G_PASTE (atom_for_, id)
@@ -6,7 +6,9 @@
 
 #include "gumquickfile.h"
 
+#include "gumiouring.h"
 #include "gumquickmacros.h"
+#include "gumringfile.h"
 
 #include <errno.h>
 #include <string.h>
@@ -16,10 +18,12 @@ typedef struct _GumFile GumFile;
 struct _GumFile
 {
   FILE * handle;
+  GumIOUring * uring;
 };
 
 GUMJS_DECLARE_CONSTRUCTOR (gumjs_file_construct)
 GUMJS_DECLARE_FINALIZER (gumjs_file_finalize)
+GUMJS_DECLARE_FUNCTION (gumjs_file_read_into)
 GUMJS_DECLARE_FUNCTION (gumjs_file_write)
 GUMJS_DECLARE_FUNCTION (gumjs_file_flush)
 GUMJS_DECLARE_FUNCTION (gumjs_file_close)
@@ -28,6 +32,14 @@ static GumFile * gum_file_new (FILE * handle);
 static void gum_file_free (GumFile * self);
 static void gum_file_close (GumFile * self);
 
+GUMJS_DECLARE_CONSTRUCTOR (gumjs_ring_file_construct)
+GUMJS_DECLARE_FINALIZER (gumjs_ring_file_finalize)
+GUMJS_DECLARE_GETTER (gumjs_ring_file_get_capacity)
+GUMJS_DECLARE_GETTER (gumjs_ring_file_get_position)
+GUMJS_DECLARE_FUNCTION (gumjs_ring_file_write)
+GUMJS_DECLARE_FUNCTION (gumjs_ring_file_flush)
+GUMJS_DECLARE_FUNCTION (gumjs_ring_file_close)
+
 static const JSClassDef gumjs_file_def =
 {
   .class_name = "File",
@@ -36,11 +48,27 @@ static const JSClassDef gumjs_file_def =
 
 static const JSCFunctionListEntry gumjs_file_entries[] =
 {
+  JS_CFUNC_DEF ("readInto", 0, gumjs_file_read_into),
   JS_CFUNC_DEF ("write", 0, gumjs_file_write),
   JS_CFUNC_DEF ("flush", 0, gumjs_file_flush),
   JS_CFUNC_DEF ("close", 0, gumjs_file_close),
 };
 
+static const JSClassDef gumjs_ring_file_def =
+{
+  .class_name = "RingFile",
+  .finalizer = gumjs_ring_file_finalize,
+};
+
+static const JSCFunctionListEntry gumjs_ring_file_entries[] =
+{
+  JS_CGETSET_DEF ("capacity", gumjs_ring_file_get_capacity, NULL),
+  JS_CGETSET_DEF ("position", gumjs_ring_file_get_position, NULL),
+  JS_CFUNC_DEF ("write", 0, gumjs_ring_file_write),
+  JS_CFUNC_DEF ("flush", 0, gumjs_ring_file_flush),
+  JS_CFUNC_DEF ("close", 0, gumjs_ring_file_close),
+};
+
 void
 _gum_quick_file_init (GumQuickFile * self,
                       JSValue ns,
@@ -62,6 +90,16 @@ _gum_quick_file_init (GumQuickFile * self,
       G_N_ELEMENTS (gumjs_file_entries));
   JS_DefinePropertyValueStr (ctx, ns, gumjs_file_def.class_name, ctor,
       JS_PROP_C_W_E);
+
+  _gum_quick_create_class (ctx, &gumjs_ring_file_def, core,
+      &self->ring_file_class, &proto);
+  ctor = JS_NewCFunction2 (ctx, gumjs_ring_file_construct,
+      gumjs_ring_file_def.class_name, 0, JS_CFUNC_constructor, 0);
+  JS_SetConstructor (ctx, ctor, proto);
+  JS_SetPropertyFunctionList (ctx, proto, gumjs_ring_file_entries,
+      G_N_ELEMENTS (gumjs_ring_file_entries));
+  JS_DefinePropertyValueStr (ctx, ns, gumjs_ring_file_def.class_name, ctor,
+      JS_PROP_C_W_E);
 }
 
 void
@@ -127,6 +165,19 @@ GUMJS_DEFINE_CONSTRUCTOR (gumjs_file_construct)
 
   file = gum_file_new (handle);
 
+  /*
+   * Write-only streams get an io_uring engine where the kernel provides
+   * one, turning a steady stream of writes into batched submissions with
+   * no stdio buffering in between; everything else, including files that
+   * may be read back through the same handle, stays on stdio.
+   */
+  if (strchr (mode, '+') == NULL && (mode[0] == 'w' || mode[0] == 'a'))
+  {
+    file->uring = gum_io_uring_open (fileno (handle));
+    if (file->uring != NULL)
+      setvbuf (handle, NULL, _IONBF, 0);
+  }
+
   JS_SetOpaque (wrapper, file);
 
   return wrapper;
@@ -155,6 +206,52 @@ GUMJS_DEFINE_FINALIZER (gumjs_file_finalize)
   gum_file_free (f);
 }
 
+/*
+ * Reads directly into the caller-provided ArrayBuffer or typed array, so
+ * bulk transfers avoid an intermediate copy; pair with ArrayBuffer.wrap()
+ * to stream straight into target memory. Returns the number of bytes read.
+ */
+GUMJS_DEFINE_FUNCTION (gumjs_file_read_into)
+{
+  GumFile * self;
+  JSValue buffer_val;
+  uint8_t * data;
+  size_t size;
+  size_t n;
+
+  if (!gum_file_get (ctx, this_val, core, &self))
+    return JS_EXCEPTION;
+
+  if (!_gum_quick_args_parse (args, "V", &buffer_val))
+    return JS_EXCEPTION;
+
+  data = JS_GetArrayBuffer (ctx, &size, buffer_val);
+  if (data == NULL)
+  {
+    JSValue buf;
+    size_t byte_offset, byte_length;
+
+    JS_FreeValue (ctx, JS_GetException (ctx));
+
+    buf = JS_GetTypedArrayBuffer (ctx, buffer_val, &byte_offset, &byte_length,
+        NULL);
+    if (JS_IsException (buf))
+      return JS_EXCEPTION;
+
+    data = JS_GetArrayBuffer (ctx, &size, buf);
+    JS_FreeValue (ctx, buf);
+    if (data == NULL)
+      return JS_EXCEPTION;
+
+    data += byte_offset;
+    size = byte_length;
+  }
+
+  n = fread (data, 1, size, self->handle);
+
+  return JS_NewUint32 (ctx, (uint32_t) n);
+}
+
 GUMJS_DEFINE_FUNCTION (gumjs_file_write)
 {
   GumFile * self;
@@ -169,7 +266,10 @@ GUMJS_DEFINE_FUNCTION (gumjs_file_write)
     return JS_EXCEPTION;
 
   data = g_bytes_get_data (bytes, &size);
-  fwrite (data, size, 1, self->handle);
+  if (self->uring != NULL)
+    gum_io_uring_write (self->uring, data, size);
+  else
+    fwrite (data, size, 1, self->handle);
 
   return JS_UNDEFINED;
 }
@@ -181,6 +281,8 @@ GUMJS_DEFINE_FUNCTION (gumjs_file_flush)
   if (!gum_file_get (ctx, this_val, core, &self))
     return JS_EXCEPTION;
 
+  if (self->uring != NULL)
+    gum_io_uring_drain (self->uring);
   fflush (self->handle);
 
   return JS_UNDEFINED;
@@ -205,6 +307,7 @@ gum_file_new (FILE * handle)
 
   file = g_slice_new (GumFile);
   file->handle = handle;
+  file->uring = NULL;
 
   return file;
 }
@@ -220,5 +323,152 @@ gum_file_free (GumFile * self)
 static void
 gum_file_close (GumFile * self)
 {
+  g_clear_pointer (&self->uring, gum_io_uring_close);
   g_clear_pointer (&self->handle, fclose);
 }
+
+static gboolean
+gum_ring_file_get (JSContext * ctx,
+                   JSValueConst val,
+                   GumQuickCore * core,
+                   GumRingFile ** file)
+{
+  GumRingFile * f;
+
+  if (!_gum_quick_unwrap (ctx, val,
+      gumjs_get_parent_module (core)->ring_file_class, core, (gpointer *) &f))
+    return FALSE;
+
+  if (gum_ring_file_is_closed (f))
+  {
+    _gum_quick_throw_literal (ctx, "file is closed");
+    return FALSE;
+  }
+
+  *file = f;
+  return TRUE;
+}
+
+/*
+ * A bounded on-disk ring for continuous tracing: the file is preallocated
+ * and memory-mapped up front, so steady-state writes are plain memcpys with
+ * no syscalls, no growth, and no rotation stalls. The oldest data is
+ * overwritten once the ring is full, and the write cursor in the file's
+ * header is only advanced past fully copied records.
+ */
+GUMJS_DEFINE_CONSTRUCTOR (gumjs_ring_file_construct)
+{
+  JSValue wrapper = JS_NULL;
+  const gchar * path;
+  gsize capacity;
+  JSValue proto;
+  GumRingFile * file;
+  GError * error;
+
+  if (!_gum_quick_args_parse (args, "sZ", &path, &capacity))
+    goto propagate_exception;
+
+  proto = JS_GetProperty (ctx, new_target,
+      GUM_QUICK_CORE_ATOM (core, prototype));
+  wrapper = JS_NewObjectProtoClass (ctx, proto,
+      gumjs_get_parent_module (core)->ring_file_class);
+  JS_FreeValue (ctx, proto);
+  if (JS_IsException (wrapper))
+    goto propagate_exception;
+
+  error = NULL;
+  file = gum_ring_file_open (path, capacity, &error);
+  if (error != NULL)
+    goto open_failed;
+
+  JS_SetOpaque (wrapper, file);
+
+  return wrapper;
+
+open_failed:
+  {
+    _gum_quick_throw_error (ctx, &error);
+    goto propagate_exception;
+  }
+propagate_exception:
+  {
+    JS_FreeValue (ctx, wrapper);
+
+    return JS_EXCEPTION;
+  }
+}
+
+GUMJS_DEFINE_FINALIZER (gumjs_ring_file_finalize)
+{
+  GumRingFile * f;
+
+  f = JS_GetOpaque (val, gumjs_get_parent_module (core)->ring_file_class);
+  if (f == NULL)
+    return;
+
+  g_object_unref (f);
+}
+
+GUMJS_DEFINE_GETTER (gumjs_ring_file_get_capacity)
+{
+  GumRingFile * self;
+
+  if (!gum_ring_file_get (ctx, this_val, core, &self))
+    return JS_EXCEPTION;
+
+  return JS_NewInt64 (ctx, gum_ring_file_get_capacity (self));
+}
+
+GUMJS_DEFINE_GETTER (gumjs_ring_file_get_position)
+{
+  GumRingFile * self;
+
+  if (!gum_ring_file_get (ctx, this_val, core, &self))
+    return JS_EXCEPTION;
+
+  return JS_NewInt64 (ctx, gum_ring_file_get_position (self));
+}
+
+GUMJS_DEFINE_FUNCTION (gumjs_ring_file_write)
+{
+  GumRingFile * self;
+  GBytes * bytes;
+  gconstpointer data;
+  gsize size;
+
+  if (!gum_ring_file_get (ctx, this_val, core, &self))
+    return JS_EXCEPTION;
+
+  if (!_gum_quick_args_parse (args, "B~", &bytes))
+    return JS_EXCEPTION;
+
+  data = g_bytes_get_data (bytes, &size);
+  if (!gum_ring_file_write (self, data, size))
+    return _gum_quick_throw_literal (ctx, "record is larger than the ring");
+
+  return JS_UNDEFINED;
+}
+
+GUMJS_DEFINE_FUNCTION (gumjs_ring_file_flush)
+{
+  GumRingFile * self;
+
+  if (!gum_ring_file_get (ctx, this_val, core, &self))
+    return JS_EXCEPTION;
+
+  gum_ring_file_flush (self);
+
+  return JS_UNDEFINED;
+}
+
+GUMJS_DEFINE_FUNCTION (gumjs_ring_file_close)
+{
+  GumRingFile * self;
+
+  if (!gum_ring_file_get (ctx, this_val, core, &self))
+    return JS_EXCEPTION;
+
+  gum_ring_file_close (self);
+
+  return JS_UNDEFINED;
+}
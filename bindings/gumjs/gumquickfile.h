@@ -18,6 +18,7 @@ struct _GumQuickFile
   GumQuickCore * core;
 
   JSClassID file_class;
+  JSClassID ring_file_class;
 };
 
 G_GNUC_INTERNAL void _gum_quick_file_init (GumQuickFile * self,
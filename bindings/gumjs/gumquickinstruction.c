@@ -11,6 +11,7 @@
 #include <string.h>
 
 GUMJS_DECLARE_FUNCTION (gumjs_instruction_parse)
+GUMJS_DECLARE_FUNCTION (gumjs_instruction_parse_block)
 
 GUMJS_DECLARE_CONSTRUCTOR (gumjs_instruction_construct)
 GUMJS_DECLARE_FINALIZER (gumjs_instruction_finalize)
@@ -66,6 +67,7 @@ static const JSClassDef gumjs_instruction_def =
 static const JSCFunctionListEntry gumjs_instruction_module_entries[] =
 {
   JS_CFUNC_DEF ("_parse", 0, gumjs_instruction_parse),
+  JS_CFUNC_DEF ("_parseBlock", 0, gumjs_instruction_parse_block),
 };
 
 static const JSCFunctionListEntry gumjs_instruction_entries[] =
@@ -224,6 +226,91 @@ GUMJS_DEFINE_FUNCTION (gumjs_instruction_parse)
       self, NULL);
 }
 
+/*
+ * Batch counterpart of _parse: walks up to the requested number of
+ * instructions through a single reused capstone buffer, with operand
+ * detail switched off, and returns a compact struct-of-arrays view
+ * instead of one wrapper object per instruction.
+ */
+GUMJS_DEFINE_FUNCTION (gumjs_instruction_parse_block)
+{
+  GumQuickInstruction * self;
+  gpointer target;
+  guint limit;
+  const gsize max_instruction_size = 16;
+  uint64_t address;
+  const uint8_t * code;
+  cs_insn * insn;
+  JSValue result, addresses, sizes, mnemonics, op_strs;
+  uint32_t i;
+
+  self = gumjs_get_parent_module (core);
+
+  if (!_gum_quick_args_parse (args, "pu", &target, &limit))
+    return JS_EXCEPTION;
+
+  target = gum_strip_code_pointer (target);
+
+#ifdef HAVE_ARM
+  address = GPOINTER_TO_SIZE (target) & ~1;
+  cs_option (self->capstone, CS_OPT_MODE,
+      (((GPOINTER_TO_SIZE (target) & 1) == 1) ? CS_MODE_THUMB : CS_MODE_ARM) |
+      CS_MODE_V8 | GUM_DEFAULT_CS_ENDIAN);
+#else
+  address = GPOINTER_TO_SIZE (target);
+#endif
+
+  addresses = JS_NewArray (ctx);
+  sizes = JS_NewArray (ctx);
+  mnemonics = JS_NewArray (ctx);
+  op_strs = JS_NewArray (ctx);
+
+  cs_option (self->capstone, CS_OPT_DETAIL, CS_OPT_OFF);
+
+  insn = cs_malloc (self->capstone);
+
+  code = GSIZE_TO_POINTER (address);
+
+  for (i = 0; i != limit; i++)
+  {
+    size_t remaining = max_instruction_size;
+
+    gum_ensure_code_readable (code, remaining);
+
+    if (!cs_disasm_iter (self->capstone, &code, &remaining, &address, insn))
+      break;
+
+    JS_DefinePropertyValueUint32 (ctx, addresses, i,
+        _gum_quick_native_pointer_new (ctx,
+            GSIZE_TO_POINTER (insn->address), core),
+        JS_PROP_C_W_E);
+    JS_DefinePropertyValueUint32 (ctx, sizes, i,
+        JS_NewInt32 (ctx, insn->size),
+        JS_PROP_C_W_E);
+    JS_DefinePropertyValueUint32 (ctx, mnemonics, i,
+        JS_NewString (ctx, insn->mnemonic),
+        JS_PROP_C_W_E);
+    JS_DefinePropertyValueUint32 (ctx, op_strs, i,
+        JS_NewString (ctx, insn->op_str),
+        JS_PROP_C_W_E);
+  }
+
+  cs_free (insn, 1);
+
+  cs_option (self->capstone, CS_OPT_DETAIL, CS_OPT_ON);
+
+  result = JS_NewObject (ctx);
+  JS_DefinePropertyValueStr (ctx, result, "count",
+      JS_NewUint32 (ctx, i), JS_PROP_C_W_E);
+  JS_DefinePropertyValueStr (ctx, result, "address", addresses, JS_PROP_C_W_E);
+  JS_DefinePropertyValueStr (ctx, result, "size", sizes, JS_PROP_C_W_E);
+  JS_DefinePropertyValueStr (ctx, result, "mnemonic", mnemonics,
+      JS_PROP_C_W_E);
+  JS_DefinePropertyValueStr (ctx, result, "opStr", op_strs, JS_PROP_C_W_E);
+
+  return result;
+}
+
 GUMJS_DEFINE_CONSTRUCTOR (gumjs_instruction_construct)
 {
   return _gum_quick_throw_literal (ctx, "not user-instantiable");
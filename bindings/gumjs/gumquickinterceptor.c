@@ -81,6 +81,7 @@ struct _GumQuickJSCallListener
 
   JSValue on_enter;
   JSValue on_leave;
+  guint arg_count;
 };
 
 struct _GumQuickJSCallListenerClass
@@ -384,14 +385,21 @@ _gum_quick_interceptor_init (GumQuickInterceptor * self,
   JS_SetPropertyFunctionList (ctx, proto, gumjs_invocation_retval_entries,
       G_N_ELEMENTS (gumjs_invocation_retval_entries));
 
-  gum_quick_invocation_context_new (self, &self->cached_invocation_context);
-  self->cached_invocation_context_in_use = FALSE;
+  {
+    guint i;
+
+    for (i = 0; i != GUM_QUICK_INVOCATION_CACHE_CAPACITY; i++)
+    {
+      self->cached_invocation_contexts[i] = NULL;
+      self->cached_invocation_context_in_use[i] = FALSE;
 
-  gum_quick_invocation_args_new (self, &self->cached_invocation_args);
-  self->cached_invocation_args_in_use = FALSE;
+      self->cached_invocation_args[i] = NULL;
+      self->cached_invocation_args_in_use[i] = FALSE;
 
-  gum_quick_invocation_retval_new (self, &self->cached_invocation_retval);
-  self->cached_invocation_retval_in_use = FALSE;
+      self->cached_invocation_retvals[i] = NULL;
+      self->cached_invocation_retval_in_use[i] = FALSE;
+    }
+  }
 }
 
 void
@@ -453,11 +461,22 @@ gum_quick_interceptor_on_flush_timer_tick (GumQuickInterceptor * self)
 void
 _gum_quick_interceptor_dispose (GumQuickInterceptor * self)
 {
+  guint i;
+
   g_assert (self->flush_timer == NULL);
 
-  gum_quick_invocation_context_release (self->cached_invocation_context);
-  gum_quick_invocation_args_release (self->cached_invocation_args);
-  gum_quick_invocation_retval_release (self->cached_invocation_retval);
+  for (i = 0; i != GUM_QUICK_INVOCATION_CACHE_CAPACITY; i++)
+  {
+    if (self->cached_invocation_contexts[i] != NULL)
+    {
+      gum_quick_invocation_context_release (
+          self->cached_invocation_contexts[i]);
+    }
+    if (self->cached_invocation_args[i] != NULL)
+      gum_quick_invocation_args_release (self->cached_invocation_args[i]);
+    if (self->cached_invocation_retvals[i] != NULL)
+      gum_quick_invocation_retval_release (self->cached_invocation_retvals[i]);
+  }
 }
 
 void
@@ -525,11 +544,28 @@ GUMJS_DEFINE_FUNCTION (gumjs_interceptor_attach)
     if (!JS_IsNull (on_enter_js) || !JS_IsNull (on_leave_js))
     {
       GumQuickJSCallListener * l;
+      JSValue ac_val;
 
       l = g_object_new (GUM_QUICK_TYPE_JS_CALL_LISTENER, NULL);
       l->on_enter = JS_DupValue (ctx, on_enter_js);
       l->on_leave = JS_DupValue (ctx, on_leave_js);
 
+      ac_val = JS_GetPropertyStr (ctx, cb_val, "argCount");
+      if (!JS_IsUndefined (ac_val) && !JS_IsNull (ac_val))
+      {
+        uint32_t n;
+
+        if (JS_ToUint32 (ctx, &n, ac_val) != 0)
+        {
+          JS_FreeValue (ctx, ac_val);
+          g_object_unref (l);
+          goto propagate_exception;
+        }
+
+        l->arg_count = n;
+      }
+      JS_FreeValue (ctx, ac_val);
+
       listener = GUM_QUICK_INVOCATION_LISTENER (l);
     }
     else if (on_enter_c != NULL || on_leave_c != NULL)
@@ -871,14 +907,43 @@ gum_quick_js_call_listener_on_enter (GumInvocationListener * listener,
     jic = _gum_quick_interceptor_obtain_invocation_context (parent);
     _gum_quick_invocation_context_reset (jic, ic);
 
-    args = gum_quick_interceptor_obtain_invocation_args (parent);
-    gum_quick_invocation_args_reset (args, ic);
+    if (self->arg_count != 0)
+    {
+      JSContext * ctx = parent->core->ctx;
+      JSValue prefetched;
+      guint i;
+
+      /*
+       * The hook declared its argument count up front, so capture the
+       * values in one native sweep and let everything else materialize
+       * lazily through the invocation context.
+       */
+      prefetched = JS_NewArray (ctx);
+      for (i = 0; i != self->arg_count; i++)
+      {
+        JS_DefinePropertyValueUint32 (ctx, prefetched, i,
+            _gum_quick_native_pointer_new (ctx,
+                gum_invocation_context_get_nth_argument (ic, i),
+                parent->core),
+            JS_PROP_C_W_E);
+      }
+
+      _gum_quick_scope_call_void (&scope, self->on_enter, jic->wrapper, 1,
+          &prefetched);
+
+      JS_FreeValue (ctx, prefetched);
+    }
+    else
+    {
+      args = gum_quick_interceptor_obtain_invocation_args (parent);
+      gum_quick_invocation_args_reset (args, ic);
 
-    _gum_quick_scope_call_void (&scope, self->on_enter, jic->wrapper, 1,
-        &args->wrapper);
+      _gum_quick_scope_call_void (&scope, self->on_enter, jic->wrapper, 1,
+          &args->wrapper);
 
-    gum_quick_invocation_args_reset (args, NULL);
-    gum_quick_interceptor_release_invocation_args (parent, args);
+      gum_quick_invocation_args_reset (args, NULL);
+      gum_quick_interceptor_release_invocation_args (parent, args);
+    }
 
     _gum_quick_invocation_context_reset (jic, NULL);
     gum_quick_interceptor_check_invocation_context (parent, jic, &jic_is_dirty);
@@ -1567,17 +1632,25 @@ GumQuickInvocationContext *
 _gum_quick_interceptor_obtain_invocation_context (GumQuickInterceptor * self)
 {
   GumQuickInvocationContext * jic;
+  guint i;
 
-  if (!self->cached_invocation_context_in_use)
-  {
-    jic = self->cached_invocation_context;
-    self->cached_invocation_context_in_use = TRUE;
-  }
-  else
+  for (i = 0; i != GUM_QUICK_INVOCATION_CACHE_CAPACITY; i++)
   {
-    gum_quick_invocation_context_new (self, &jic);
+    if (!self->cached_invocation_context_in_use[i])
+    {
+      jic = self->cached_invocation_contexts[i];
+      if (jic == NULL)
+      {
+        gum_quick_invocation_context_new (self, &jic);
+        self->cached_invocation_contexts[i] = jic;
+      }
+      self->cached_invocation_context_in_use[i] = TRUE;
+      return jic;
+    }
   }
 
+  gum_quick_invocation_context_new (self, &jic);
+
   return jic;
 }
 
@@ -1586,10 +1659,18 @@ _gum_quick_interceptor_release_invocation_context (
     GumQuickInterceptor * self,
     GumQuickInvocationContext * jic)
 {
-  if (jic == self->cached_invocation_context)
-    self->cached_invocation_context_in_use = FALSE;
-  else
-    gum_quick_invocation_context_release (jic);
+  guint i;
+
+  for (i = 0; i != GUM_QUICK_INVOCATION_CACHE_CAPACITY; i++)
+  {
+    if (jic == self->cached_invocation_contexts[i])
+    {
+      self->cached_invocation_context_in_use[i] = FALSE;
+      return;
+    }
+  }
+
+  gum_quick_invocation_context_release (jic);
 }
 
 static void
@@ -1601,10 +1682,24 @@ gum_quick_interceptor_check_invocation_context (GumQuickInterceptor * self,
 
   is_dirty = gum_quick_invocation_context_is_dirty (jic);
 
-  if (is_dirty && jic == self->cached_invocation_context)
+  if (is_dirty)
   {
-    gum_quick_invocation_context_new (self, &self->cached_invocation_context);
-    self->cached_invocation_context_in_use = FALSE;
+    guint i;
+
+    /*
+     * The callback hung properties off the view, so evict it from the
+     * pool: whoever still holds it will release it for real, and the
+     * slot repopulates lazily with a pristine instance.
+     */
+    for (i = 0; i != GUM_QUICK_INVOCATION_CACHE_CAPACITY; i++)
+    {
+      if (jic == self->cached_invocation_contexts[i])
+      {
+        self->cached_invocation_contexts[i] = NULL;
+        self->cached_invocation_context_in_use[i] = FALSE;
+        break;
+      }
+    }
   }
 
   if (jic_is_dirty != NULL)
@@ -1615,17 +1710,25 @@ static GumQuickInvocationArgs *
 gum_quick_interceptor_obtain_invocation_args (GumQuickInterceptor * self)
 {
   GumQuickInvocationArgs * args;
+  guint i;
 
-  if (!self->cached_invocation_args_in_use)
+  for (i = 0; i != GUM_QUICK_INVOCATION_CACHE_CAPACITY; i++)
   {
-    args = self->cached_invocation_args;
-    self->cached_invocation_args_in_use = TRUE;
-  }
-  else
-  {
-    gum_quick_invocation_args_new (self, &args);
+    if (!self->cached_invocation_args_in_use[i])
+    {
+      args = self->cached_invocation_args[i];
+      if (args == NULL)
+      {
+        gum_quick_invocation_args_new (self, &args);
+        self->cached_invocation_args[i] = args;
+      }
+      self->cached_invocation_args_in_use[i] = TRUE;
+      return args;
+    }
   }
 
+  gum_quick_invocation_args_new (self, &args);
+
   return args;
 }
 
@@ -1633,27 +1736,43 @@ static void
 gum_quick_interceptor_release_invocation_args (GumQuickInterceptor * self,
                                                GumQuickInvocationArgs * args)
 {
-  if (args == self->cached_invocation_args)
-    self->cached_invocation_args_in_use = FALSE;
-  else
-    gum_quick_invocation_args_release (args);
+  guint i;
+
+  for (i = 0; i != GUM_QUICK_INVOCATION_CACHE_CAPACITY; i++)
+  {
+    if (args == self->cached_invocation_args[i])
+    {
+      self->cached_invocation_args_in_use[i] = FALSE;
+      return;
+    }
+  }
+
+  gum_quick_invocation_args_release (args);
 }
 
 static GumQuickInvocationRetval *
 gum_quick_interceptor_obtain_invocation_retval (GumQuickInterceptor * self)
 {
   GumQuickInvocationRetval * retval;
+  guint i;
 
-  if (!self->cached_invocation_retval_in_use)
-  {
-    retval = self->cached_invocation_retval;
-    self->cached_invocation_retval_in_use = TRUE;
-  }
-  else
+  for (i = 0; i != GUM_QUICK_INVOCATION_CACHE_CAPACITY; i++)
   {
-    gum_quick_invocation_retval_new (self, &retval);
+    if (!self->cached_invocation_retval_in_use[i])
+    {
+      retval = self->cached_invocation_retvals[i];
+      if (retval == NULL)
+      {
+        gum_quick_invocation_retval_new (self, &retval);
+        self->cached_invocation_retvals[i] = retval;
+      }
+      self->cached_invocation_retval_in_use[i] = TRUE;
+      return retval;
+    }
   }
 
+  gum_quick_invocation_retval_new (self, &retval);
+
   return retval;
 }
 
@@ -1662,8 +1781,16 @@ gum_quick_interceptor_release_invocation_retval (
     GumQuickInterceptor * self,
     GumQuickInvocationRetval * retval)
 {
-  if (retval == self->cached_invocation_retval)
-    self->cached_invocation_retval_in_use = FALSE;
-  else
-    gum_quick_invocation_retval_release (retval);
+  guint i;
+
+  for (i = 0; i != GUM_QUICK_INVOCATION_CACHE_CAPACITY; i++)
+  {
+    if (retval == self->cached_invocation_retvals[i])
+    {
+      self->cached_invocation_retval_in_use[i] = FALSE;
+      return;
+    }
+  }
+
+  gum_quick_invocation_retval_release (retval);
 }
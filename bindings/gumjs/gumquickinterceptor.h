@@ -13,6 +13,8 @@
 
 G_BEGIN_DECLS
 
+#define GUM_QUICK_INVOCATION_CACHE_CAPACITY 8
+
 typedef struct _GumQuickInvocationContext GumQuickInvocationContext;
 typedef struct _GumQuickInvocationArgs GumQuickInvocationArgs;
 typedef struct _GumQuickInvocationRetval GumQuickInvocationRetval;
@@ -32,14 +34,25 @@ struct _GumQuickInterceptor
   JSClassID invocation_args_class;
   JSClassID invocation_retval_class;
 
-  GumQuickInvocationContext * cached_invocation_context;
-  gboolean cached_invocation_context_in_use;
-
-  GumQuickInvocationArgs * cached_invocation_args;
-  gboolean cached_invocation_args_in_use;
-
-  GumQuickInvocationRetval * cached_invocation_retval;
-  gboolean cached_invocation_retval_in_use;
+  /*
+   * Pools of reusable invocation views, rebound per call, so steady-state
+   * hook callbacks perform zero JS allocations even when invocations nest
+   * or a context is held from onEnter until onLeave. Entries are created
+   * lazily and allocation only kicks in beyond the pool capacity.
+   */
+  GumQuickInvocationContext * cached_invocation_contexts[
+      GUM_QUICK_INVOCATION_CACHE_CAPACITY];
+  gboolean cached_invocation_context_in_use[
+      GUM_QUICK_INVOCATION_CACHE_CAPACITY];
+
+  GumQuickInvocationArgs * cached_invocation_args[
+      GUM_QUICK_INVOCATION_CACHE_CAPACITY];
+  gboolean cached_invocation_args_in_use[GUM_QUICK_INVOCATION_CACHE_CAPACITY];
+
+  GumQuickInvocationRetval * cached_invocation_retvals[
+      GUM_QUICK_INVOCATION_CACHE_CAPACITY];
+  gboolean cached_invocation_retval_in_use[
+      GUM_QUICK_INVOCATION_CACHE_CAPACITY];
 };
 
 struct _GumQuickInvocationContext
@@ -8,6 +8,7 @@
 
 #include "gumquickmacros.h"
 
+#include <gum/gummemory-priv.h>
 #include <string.h>
 #ifdef HAVE_WINDOWS
 # ifndef WIN32_LEAN_AND_MEAN
@@ -60,6 +61,12 @@ struct _GumMemoryScanContext
   JSValue on_complete;
   GumQuickMatchResult result;
 
+  gboolean deliver_batches;
+  guint batch_capacity;
+  GumAddress * pending_addresses;
+  guint32 * pending_sizes;
+  guint n_pending;
+
   JSContext * ctx;
   GumQuickCore * core;
 };
@@ -76,6 +83,7 @@ struct _GumMemoryScanSyncContext
 GUMJS_DECLARE_FUNCTION (gumjs_memory_alloc)
 GUMJS_DECLARE_FUNCTION (gumjs_memory_copy)
 GUMJS_DECLARE_FUNCTION (gumjs_memory_protect)
+GUMJS_DECLARE_FUNCTION (gumjs_memory_protect_ranges)
 GUMJS_DECLARE_FUNCTION (gumjs_memory_patch_code)
 static void gum_memory_patch_context_apply (gpointer mem,
     GumMemoryPatchContext * self);
@@ -85,6 +93,8 @@ static JSValue gum_quick_memory_read (JSContext * ctx, GumMemoryValueType type,
     GumQuickArgs * args, GumQuickCore * core);
 static JSValue gum_quick_memory_write (JSContext * ctx, GumMemoryValueType type,
     GumQuickArgs * args, GumQuickCore * core);
+static gboolean gum_quick_memory_range_is_known_readable (GumQuickMemory * self,
+    gconstpointer address, gsize size);
 
 static void gum_quick_memory_on_access (GumMemoryAccessMonitor * monitor,
     const GumMemoryAccessDetails * details, GumQuickMemory * self);
@@ -94,47 +104,62 @@ static gchar * gum_ansi_string_to_utf8 (const gchar * str_ansi, gint length);
 static gchar * gum_ansi_string_from_utf8 (const gchar * str_utf8);
 #endif
 
-#define GUMJS_DEFINE_MEMORY_READ(T) \
-    GUMJS_DEFINE_FUNCTION (gumjs_memory_read_##T) \
-    { \
-      return gum_quick_memory_read (ctx, GUM_MEMORY_VALUE_##T, args, core); \
-    }
-#define GUMJS_DEFINE_MEMORY_WRITE(T) \
-    GUMJS_DEFINE_FUNCTION (gumjs_memory_write_##T) \
-    { \
-      return gum_quick_memory_write (ctx, GUM_MEMORY_VALUE_##T, args, core); \
-    }
-#define GUMJS_DEFINE_MEMORY_READ_WRITE(T) \
-    GUMJS_DEFINE_MEMORY_READ (T); \
-    GUMJS_DEFINE_MEMORY_WRITE (T)
+/*
+ * All read/write accessors funnel into the shared converters via the entry's
+ * magic, so QuickJS dispatches them through a single pair of C functions
+ * instead of one trampoline per value type.
+ */
+
+static JSValue
+gumjs_memory_read (JSContext * ctx,
+                   JSValueConst this_val,
+                   int argc,
+                   JSValueConst * argv,
+                   int magic)
+{
+  JSValue result;
+  GumQuickCore * core;
+  GumQuickArgs args;
+
+  core = JS_GetContextOpaque (ctx);
+  _gum_quick_args_init (&args, ctx, argc, argv, core);
+
+  result = gum_quick_memory_read (ctx, magic, &args, core);
+
+  _gum_quick_args_destroy (&args);
+
+  return result;
+}
+
+static JSValue
+gumjs_memory_write (JSContext * ctx,
+                    JSValueConst this_val,
+                    int argc,
+                    JSValueConst * argv,
+                    int magic)
+{
+  JSValue result;
+  GumQuickCore * core;
+  GumQuickArgs args;
+
+  core = JS_GetContextOpaque (ctx);
+  _gum_quick_args_init (&args, ctx, argc, argv, core);
+
+  result = gum_quick_memory_write (ctx, magic, &args, core);
+
+  _gum_quick_args_destroy (&args);
+
+  return result;
+}
 
 #define GUMJS_EXPORT_MEMORY_READ(N, T) \
-    JS_CFUNC_DEF ("read" N, 0, gumjs_memory_read_##T)
+    JS_CFUNC_MAGIC_DEF ("read" N, 0, gumjs_memory_read, GUM_MEMORY_VALUE_##T)
 #define GUMJS_EXPORT_MEMORY_WRITE(N, T) \
-    JS_CFUNC_DEF ("write" N, 0, gumjs_memory_write_##T)
+    JS_CFUNC_MAGIC_DEF ("write" N, 0, gumjs_memory_write, GUM_MEMORY_VALUE_##T)
 #define GUMJS_EXPORT_MEMORY_READ_WRITE(N, T) \
     GUMJS_EXPORT_MEMORY_READ (N, T), \
     GUMJS_EXPORT_MEMORY_WRITE (N, T)
 
-GUMJS_DEFINE_MEMORY_READ_WRITE (POINTER)
-GUMJS_DEFINE_MEMORY_READ_WRITE (S8)
-GUMJS_DEFINE_MEMORY_READ_WRITE (U8)
-GUMJS_DEFINE_MEMORY_READ_WRITE (S16)
-GUMJS_DEFINE_MEMORY_READ_WRITE (U16)
-GUMJS_DEFINE_MEMORY_READ_WRITE (S32)
-GUMJS_DEFINE_MEMORY_READ_WRITE (U32)
-GUMJS_DEFINE_MEMORY_READ_WRITE (S64)
-GUMJS_DEFINE_MEMORY_READ_WRITE (U64)
-GUMJS_DEFINE_MEMORY_READ_WRITE (LONG)
-GUMJS_DEFINE_MEMORY_READ_WRITE (ULONG)
-GUMJS_DEFINE_MEMORY_READ_WRITE (FLOAT)
-GUMJS_DEFINE_MEMORY_READ_WRITE (DOUBLE)
-GUMJS_DEFINE_MEMORY_READ_WRITE (BYTE_ARRAY)
-GUMJS_DEFINE_MEMORY_READ (C_STRING)
-GUMJS_DEFINE_MEMORY_READ_WRITE (UTF8_STRING)
-GUMJS_DEFINE_MEMORY_READ_WRITE (UTF16_STRING)
-GUMJS_DEFINE_MEMORY_READ_WRITE (ANSI_STRING)
-
 GUMJS_DECLARE_FUNCTION (gumjs_memory_alloc_ansi_string)
 GUMJS_DECLARE_FUNCTION (gumjs_memory_alloc_utf8_string)
 GUMJS_DECLARE_FUNCTION (gumjs_memory_alloc_utf16_string)
@@ -144,10 +169,25 @@ static void gum_memory_scan_context_free (GumMemoryScanContext * ctx);
 static void gum_memory_scan_context_run (GumMemoryScanContext * self);
 static gboolean gum_memory_scan_context_emit_match (GumAddress address,
     gsize size, GumMemoryScanContext * self);
+static gboolean gum_memory_scan_context_flush (GumMemoryScanContext * self);
 GUMJS_DECLARE_FUNCTION (gumjs_memory_scan_sync)
 static gboolean gum_append_match (GumAddress address, gsize size,
     GumMemoryScanSyncContext * sc);
 
+GUMJS_DECLARE_FUNCTION (gumjs_memory_hexdump)
+static void gum_append_hexdump (GString * output, gconstpointer address,
+    gsize size, gboolean show_header, gboolean use_ansi);
+GUMJS_DECLARE_FUNCTION (gumjs_memory_scan_strings)
+static void gum_scan_utf8_strings (JSContext * ctx, JSValue matches,
+    uint32_t * index, GumQuickCore * core, gconstpointer address, gsize size,
+    guint min_length);
+static void gum_scan_utf16_strings (JSContext * ctx, JSValue matches,
+    uint32_t * index, GumQuickCore * core, gconstpointer address, gsize size,
+    guint min_length);
+static void gum_append_string_match (JSContext * ctx, JSValue matches,
+    uint32_t * index, GumQuickCore * core, GumAddress address, gsize size,
+    const gchar * encoding, JSValue content);
+
 GUMJS_DECLARE_FUNCTION (gumjs_memory_access_monitor_enable)
 GUMJS_DECLARE_FUNCTION (gumjs_memory_access_monitor_disable)
 static void gum_quick_memory_clear_monitor (GumQuickMemory * self,
@@ -166,6 +206,7 @@ static const JSCFunctionListEntry gumjs_memory_entries[] =
   JS_CFUNC_DEF ("alloc", 0, gumjs_memory_alloc),
   JS_CFUNC_DEF ("copy", 0, gumjs_memory_copy),
   JS_CFUNC_DEF ("protect", 0, gumjs_memory_protect),
+  JS_CFUNC_DEF ("protectRanges", 0, gumjs_memory_protect_ranges),
   JS_CFUNC_DEF ("_patchCode", 0, gumjs_memory_patch_code),
   JS_CFUNC_DEF ("_checkCodePointer", 0, gumjs_memory_check_code_pointer),
 
@@ -198,6 +239,9 @@ static const JSCFunctionListEntry gumjs_memory_entries[] =
 
   JS_CFUNC_DEF ("scan", 0, gumjs_memory_scan),
   JS_CFUNC_DEF ("scanSync", 0, gumjs_memory_scan_sync),
+
+  JS_CFUNC_DEF ("hexdump", 0, gumjs_memory_hexdump),
+  JS_CFUNC_DEF ("scanStrings", 0, gumjs_memory_scan_strings),
 };
 
 static const JSCFunctionListEntry gumjs_memory_access_monitor_entries[] =
@@ -235,6 +279,8 @@ _gum_quick_memory_init (GumQuickMemory * self,
   JSValue obj, proto;
 
   self->core = core;
+  self->readable_map = NULL;
+  self->readable_map_generation = 0;
   self->monitor = NULL;
   self->on_access = JS_NULL;
 
@@ -261,6 +307,8 @@ void
 _gum_quick_memory_dispose (GumQuickMemory * self)
 {
   gum_quick_memory_clear_monitor (self, self->core->ctx);
+
+  g_clear_object (&self->readable_map);
 }
 
 void
@@ -347,6 +395,26 @@ GUMJS_DEFINE_FUNCTION (gumjs_memory_protect)
   return JS_NewBool (ctx, success);
 }
 
+/*
+ * Batch variant for scripts toggling protection on many ranges at once:
+ * gum_try_mprotect_batch() merges adjacent and overlapping ranges so the
+ * kernel sees as few protection changes as possible.
+ */
+GUMJS_DEFINE_FUNCTION (gumjs_memory_protect_ranges)
+{
+  GArray * ranges;
+  GumPageProtection prot;
+  gboolean success;
+
+  if (!_gum_quick_args_parse (args, "Rm", &ranges, &prot))
+    return JS_EXCEPTION;
+
+  success = gum_try_mprotect_batch ((const GumMemoryRange *) ranges->data,
+      ranges->len, prot);
+
+  return JS_NewBool (ctx, success);
+}
+
 GUMJS_DEFINE_FUNCTION (gumjs_memory_patch_code)
 {
   gpointer address;
@@ -424,6 +492,8 @@ gum_quick_memory_read (JSContext * ctx,
   GumExceptor * exceptor = core->exceptor;
   gpointer address;
   gssize length = -1;
+  gsize access_size;
+  gboolean prechecked;
   GumExceptorScope scope;
 
   switch (type)
@@ -445,7 +515,46 @@ gum_quick_memory_read (JSContext * ctx,
       break;
   }
 
-  if (gum_exceptor_try (exceptor, &scope))
+  switch (type)
+  {
+    case GUM_MEMORY_VALUE_POINTER:
+      access_size = sizeof (gpointer);
+      break;
+    case GUM_MEMORY_VALUE_S8:
+    case GUM_MEMORY_VALUE_U8:
+      access_size = 1;
+      break;
+    case GUM_MEMORY_VALUE_S16:
+    case GUM_MEMORY_VALUE_U16:
+      access_size = 2;
+      break;
+    case GUM_MEMORY_VALUE_S32:
+    case GUM_MEMORY_VALUE_U32:
+    case GUM_MEMORY_VALUE_FLOAT:
+      access_size = 4;
+      break;
+    case GUM_MEMORY_VALUE_S64:
+    case GUM_MEMORY_VALUE_U64:
+    case GUM_MEMORY_VALUE_DOUBLE:
+      access_size = 8;
+      break;
+    case GUM_MEMORY_VALUE_LONG:
+    case GUM_MEMORY_VALUE_ULONG:
+      access_size = sizeof (glong);
+      break;
+    case GUM_MEMORY_VALUE_BYTE_ARRAY:
+      access_size = length;
+      break;
+    default:
+      /* Strings have unknown extents; leave those to the exceptor. */
+      access_size = 0;
+      break;
+  }
+
+  prechecked = gum_quick_memory_range_is_known_readable (
+      gumjs_get_parent_module (core), address, access_size);
+
+  if (prechecked || gum_exceptor_try (exceptor, &scope))
   {
     switch (type)
     {
@@ -622,7 +731,7 @@ gum_quick_memory_read (JSContext * ctx,
     }
   }
 
-  if (gum_exceptor_catch (exceptor, &scope))
+  if (!prechecked && gum_exceptor_catch (exceptor, &scope))
   {
     JS_FreeValue (ctx, result);
     result = _gum_quick_throw_native (ctx, &scope.exception, core);
@@ -808,6 +917,42 @@ gum_quick_memory_write (JSContext * ctx,
   return result;
 }
 
+/*
+ * Reads of scalars and byte arrays have a known extent up front, so we can
+ * vouch for them against a cached map of readable pages and skip the exceptor
+ * scope entirely for the common safe case. The map is refreshed lazily
+ * whenever the memory layout generation has moved since it was last built.
+ */
+static gboolean
+gum_quick_memory_range_is_known_readable (GumQuickMemory * self,
+                                          gconstpointer address,
+                                          gsize size)
+{
+  guint generation;
+  GumMemoryRange range;
+
+  if (address == NULL || size == 0)
+    return FALSE;
+
+  generation = _gum_memory_query_layout_generation ();
+
+  if (self->readable_map == NULL)
+  {
+    self->readable_map = gum_memory_map_new (GUM_PAGE_READ);
+    self->readable_map_generation = generation;
+  }
+  else if (self->readable_map_generation != generation)
+  {
+    gum_memory_map_update (self->readable_map);
+    self->readable_map_generation = generation;
+  }
+
+  range.base_address = GUM_ADDRESS (address);
+  range.size = size;
+
+  return gum_memory_map_contains (self->readable_map, &range);
+}
+
 #ifdef HAVE_WINDOWS
 
 static gchar *
@@ -908,19 +1053,30 @@ GUMJS_DEFINE_FUNCTION (gumjs_memory_scan)
   gpointer address;
   gsize size;
   const gchar * match_str;
+  guint batch_size = 0;
 
-  if (!_gum_quick_args_parse (args, "pZsF{onMatch,onError?,onComplete}",
-      &address, &size, &match_str, &sc.on_match, &sc.on_error, &sc.on_complete))
+  if (!_gum_quick_args_parse (args, "pZsF{onMatch,onError?,onComplete}|u",
+      &address, &size, &match_str, &sc.on_match, &sc.on_error, &sc.on_complete,
+      &batch_size))
     return JS_EXCEPTION;
   sc.range.base_address = GUM_ADDRESS (address);
   sc.range.size = size;
   sc.pattern = gum_match_pattern_new_from_string (match_str);
   sc.result = GUM_QUICK_MATCH_CONTINUE;
+  sc.deliver_batches = batch_size != 0;
+  sc.batch_capacity = sc.deliver_batches ? batch_size : 64;
+  sc.pending_addresses = g_new (GumAddress, sc.batch_capacity);
+  sc.pending_sizes = g_new (guint32, sc.batch_capacity);
+  sc.n_pending = 0;
   sc.ctx = ctx;
   sc.core = core;
 
   if (sc.pattern == NULL)
+  {
+    g_free (sc.pending_addresses);
+    g_free (sc.pending_sizes);
     return _gum_quick_throw_literal (ctx, "invalid match pattern");
+  }
 
   JS_DupValue (ctx, sc.on_match);
   JS_DupValue (ctx, sc.on_error);
@@ -953,6 +1109,9 @@ gum_memory_scan_context_free (GumMemoryScanContext * self)
 
   gum_match_pattern_free (self->pattern);
 
+  g_free (self->pending_addresses);
+  g_free (self->pending_sizes);
+
   g_slice_free (GumMemoryScanContext, self);
 }
 
@@ -971,6 +1130,9 @@ gum_memory_scan_context_run (GumMemoryScanContext * self)
         (GumMemoryScanMatchFunc) gum_memory_scan_context_emit_match, self);
   }
 
+  if (self->result == GUM_QUICK_MATCH_CONTINUE)
+    gum_memory_scan_context_flush (self);
+
   _gum_quick_scope_enter (&script_scope, core);
 
   if (gum_exceptor_catch (exceptor, &exceptor_scope))
@@ -998,30 +1160,90 @@ gum_memory_scan_context_run (GumMemoryScanContext * self)
   _gum_quick_scope_leave (&script_scope);
 }
 
+/*
+ * Matches are accumulated natively and handed over per batch, so a scan with
+ * huge match counts does not spend its time crossing the JS boundary. When
+ * the caller supplies a batch size, onMatch receives (addresses, sizes)
+ * arrays in one call; otherwise the classic per-match contract is preserved,
+ * with the scope entered once per batch instead of once per hit.
+ */
+
 static gboolean
 gum_memory_scan_context_emit_match (GumAddress address,
                                     gsize size,
                                     GumMemoryScanContext * self)
 {
-  gboolean proceed;
+  self->pending_addresses[self->n_pending] = address;
+  self->pending_sizes[self->n_pending] = (guint32) size;
+  self->n_pending++;
+
+  if (self->n_pending != self->batch_capacity)
+    return TRUE;
+
+  return gum_memory_scan_context_flush (self);
+}
+
+static gboolean
+gum_memory_scan_context_flush (GumMemoryScanContext * self)
+{
+  gboolean proceed = TRUE;
   JSContext * ctx = self->ctx;
   GumQuickCore * core = self->core;
   GumQuickScope scope;
-  JSValue argv[2];
-  JSValue result;
+  guint n, i;
+
+  n = self->n_pending;
+  self->n_pending = 0;
+  if (n == 0)
+    return TRUE;
 
   _gum_quick_scope_enter (&scope, core);
 
-  argv[0] = _gum_quick_native_pointer_new (ctx, GSIZE_TO_POINTER (address),
-      core);
-  argv[1] = JS_NewUint32 (ctx, size);
+  if (self->deliver_batches)
+  {
+    JSValue argv[2];
+    JSValue result;
+
+    argv[0] = JS_NewArray (ctx);
+    argv[1] = JS_NewArray (ctx);
+    for (i = 0; i != n; i++)
+    {
+      JS_DefinePropertyValueUint32 (ctx, argv[0], i,
+          _gum_quick_native_pointer_new (ctx,
+              GSIZE_TO_POINTER (self->pending_addresses[i]), core),
+          JS_PROP_C_W_E);
+      JS_DefinePropertyValueUint32 (ctx, argv[1], i,
+          JS_NewUint32 (ctx, self->pending_sizes[i]),
+          JS_PROP_C_W_E);
+    }
+
+    result = _gum_quick_scope_call (&scope, self->on_match, JS_UNDEFINED,
+        G_N_ELEMENTS (argv), argv);
+
+    JS_FreeValue (ctx, argv[1]);
+    JS_FreeValue (ctx, argv[0]);
+
+    proceed = _gum_quick_process_match_result (ctx, &result, &self->result);
+  }
+  else
+  {
+    for (i = 0; i != n && proceed; i++)
+    {
+      JSValue argv[2];
+      JSValue result;
+
+      argv[0] = _gum_quick_native_pointer_new (ctx,
+          GSIZE_TO_POINTER (self->pending_addresses[i]), core);
+      argv[1] = JS_NewUint32 (ctx, self->pending_sizes[i]);
 
-  result = _gum_quick_scope_call (&scope, self->on_match, JS_UNDEFINED,
-      G_N_ELEMENTS (argv), argv);
+      result = _gum_quick_scope_call (&scope, self->on_match, JS_UNDEFINED,
+          G_N_ELEMENTS (argv), argv);
 
-  JS_FreeValue (ctx, argv[0]);
+      JS_FreeValue (ctx, argv[0]);
 
-  proceed = _gum_quick_process_match_result (ctx, &result, &self->result);
+      proceed = _gum_quick_process_match_result (ctx, &result, &self->result);
+    }
+  }
 
   _gum_quick_scope_leave (&scope);
 
@@ -1097,6 +1319,351 @@ gum_append_match (GumAddress address,
   return TRUE;
 }
 
+GUMJS_DEFINE_FUNCTION (gumjs_memory_hexdump)
+{
+  JSValue result;
+  gpointer address;
+  gsize size;
+  gboolean show_header, use_ansi;
+  GString * output;
+  GumExceptorScope scope;
+
+  show_header = TRUE;
+  use_ansi = FALSE;
+  if (!_gum_quick_args_parse (args, "pZ|tt", &address, &size, &show_header,
+      &use_ansi))
+    return JS_EXCEPTION;
+
+  output = g_string_sized_new (MIN (size, 4096) * 5);
+
+  if (gum_exceptor_try (core->exceptor, &scope))
+  {
+    gum_append_hexdump (output, address, size, show_header, use_ansi);
+  }
+
+  if (gum_exceptor_catch (core->exceptor, &scope))
+  {
+    g_string_free (output, TRUE);
+    return _gum_quick_throw_native (ctx, &scope.exception, core);
+  }
+
+  result = JS_NewStringLen (ctx, output->str, output->len);
+
+  g_string_free (output, TRUE);
+
+  return result;
+}
+
+/*
+ * Produces the exact same text as the hexdump() runtime helper, but does it
+ * with a couple of table lookups per byte instead of a handful of JS string
+ * operations per byte. We deliberately keep it table-driven plain C rather
+ * than hand-vectorized so it is equally at home on every architecture this
+ * file builds for.
+ */
+
+static void
+gum_append_hexdump (GString * output,
+                    gconstpointer address,
+                    gsize size,
+                    gboolean show_header,
+                    gboolean use_ansi)
+{
+  static const gchar nibbles[] = "0123456789abcdef";
+  const guint8 * bytes = address;
+  const gchar * reset_color, * offset_color, * data_color, * newline_color;
+  guint left_column_width;
+  gsize cursor, offset;
+  gchar address_str[16];
+  guint i;
+
+  left_column_width = 0;
+  for (cursor = GPOINTER_TO_SIZE (address) + size; cursor != 0; cursor >>= 4)
+    left_column_width++;
+  left_column_width = MAX (left_column_width, 8);
+
+  if (use_ansi)
+  {
+    reset_color = "\x1b[0m";
+    offset_color = "\x1b[0;32m";
+    data_color = "\x1b[0;33m";
+    newline_color = reset_color;
+  }
+  else
+  {
+    reset_color = "";
+    offset_color = "";
+    data_color = "";
+    newline_color = "";
+  }
+
+  if (show_header)
+  {
+    for (i = 0; i != left_column_width; i++)
+      g_string_append_c (output, ' ');
+    g_string_append (output,
+        "   0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F"
+        "  0123456789ABCDEF\n");
+  }
+
+  for (offset = 0; offset < size; offset += 16)
+  {
+    gsize line_address, line_size, j;
+
+    line_address = GPOINTER_TO_SIZE (address) + offset;
+    line_size = MIN (size - offset, 16);
+
+    if (offset != 0)
+      g_string_append_c (output, '\n');
+
+    for (i = 0; i != left_column_width; i++)
+    {
+      address_str[left_column_width - 1 - i] =
+          nibbles[(line_address >> (4 * i)) & 0xf];
+    }
+    g_string_append (output, offset_color);
+    g_string_append_len (output, address_str, left_column_width);
+    g_string_append (output, reset_color);
+    g_string_append (output, "  ");
+
+    for (j = 0; j != line_size; j++)
+    {
+      guint8 value = bytes[offset + j];
+
+      if (j != 0)
+        g_string_append_c (output, ' ');
+      g_string_append (output, (value == '\n') ? newline_color : data_color);
+      g_string_append_c (output, nibbles[value >> 4]);
+      g_string_append_c (output, nibbles[value & 0xf]);
+      g_string_append (output, reset_color);
+    }
+    for (j = line_size; j != 16; j++)
+      g_string_append (output, "   ");
+
+    g_string_append (output, "  ");
+
+    for (j = 0; j != line_size; j++)
+    {
+      guint8 value = bytes[offset + j];
+
+      g_string_append (output, (value == '\n') ? newline_color : data_color);
+      g_string_append_c (output,
+          (value >= 32 && value <= 126) ? (gchar) value : '.');
+      g_string_append (output, reset_color);
+    }
+    for (j = line_size; j != 16; j++)
+      g_string_append_c (output, ' ');
+  }
+
+  while (output->len != 0 && output->str[output->len - 1] == ' ')
+    g_string_truncate (output, output->len - 1);
+}
+
+GUMJS_DEFINE_FUNCTION (gumjs_memory_scan_strings)
+{
+  JSValue result;
+  gpointer address;
+  gsize size;
+  guint min_length;
+  uint32_t index;
+  GumExceptorScope scope;
+
+  min_length = 4;
+  if (!_gum_quick_args_parse (args, "pZ|u", &address, &size, &min_length))
+    return JS_EXCEPTION;
+  min_length = MAX (min_length, 1);
+
+  result = JS_NewArray (ctx);
+  index = 0;
+
+  if (gum_exceptor_try (core->exceptor, &scope))
+  {
+    gum_scan_utf8_strings (ctx, result, &index, core, address, size,
+        min_length);
+    gum_scan_utf16_strings (ctx, result, &index, core, address, size,
+        min_length);
+  }
+
+  if (gum_exceptor_catch (core->exceptor, &scope))
+  {
+    JS_FreeValue (ctx, result);
+    result = _gum_quick_throw_native (ctx, &scope.exception, core);
+  }
+
+  return result;
+}
+
+/*
+ * Matches are runs of printable ASCII and well-formed multi-byte sequences.
+ * A candidate run is only emitted once g_utf8_validate() agrees, so the
+ * cheap byte-class pass merely narrows down what the strict validator has to
+ * look at.
+ */
+
+static void
+gum_scan_utf8_strings (JSContext * ctx,
+                       JSValue matches,
+                       uint32_t * index,
+                       GumQuickCore * core,
+                       gconstpointer address,
+                       gsize size,
+                       guint min_length)
+{
+  const guint8 * bytes = address;
+  gsize cursor, start;
+  guint n_chars;
+
+  cursor = 0;
+  while (cursor != size)
+  {
+    start = cursor;
+    n_chars = 0;
+
+    while (cursor != size)
+    {
+      guint8 byte = bytes[cursor];
+      guint seq_len, k;
+      gboolean valid;
+
+      if ((byte >= 0x20 && byte <= 0x7e) || byte == '\t')
+      {
+        cursor++;
+        n_chars++;
+        continue;
+      }
+
+      if (byte >= 0xc2 && byte <= 0xdf)
+        seq_len = 2;
+      else if (byte >= 0xe0 && byte <= 0xef)
+        seq_len = 3;
+      else if (byte >= 0xf0 && byte <= 0xf4)
+        seq_len = 4;
+      else
+        break;
+
+      if (cursor + seq_len > size)
+        break;
+
+      valid = TRUE;
+      for (k = 1; k != seq_len; k++)
+      {
+        if ((bytes[cursor + k] & 0xc0) != 0x80)
+          valid = FALSE;
+      }
+      if (!valid)
+        break;
+
+      cursor += seq_len;
+      n_chars++;
+    }
+
+    if (n_chars >= min_length &&
+        g_utf8_validate ((const gchar *) bytes + start, cursor - start, NULL))
+    {
+      gum_append_string_match (ctx, matches, index, core,
+          GUM_ADDRESS (GPOINTER_TO_SIZE (address) + start), cursor - start,
+          "utf8",
+          JS_NewStringLen (ctx, (const gchar *) bytes + start,
+              cursor - start));
+    }
+
+    if (cursor == start)
+      cursor++;
+  }
+}
+
+/*
+ * Like the classic `strings -el`: little-endian UTF-16 units restricted to
+ * the printable ASCII range, tried at both alignments so strings embedded
+ * at odd offsets are found too.
+ */
+
+static void
+gum_scan_utf16_strings (JSContext * ctx,
+                        JSValue matches,
+                        uint32_t * index,
+                        GumQuickCore * core,
+                        gconstpointer address,
+                        gsize size,
+                        guint min_length)
+{
+  const guint8 * bytes = address;
+  guint parity;
+
+  for (parity = 0; parity != 2; parity++)
+  {
+    gsize cursor = parity;
+
+    while (cursor + 2 <= size)
+    {
+      gsize start;
+      guint n_chars;
+
+      start = cursor;
+      n_chars = 0;
+
+      while (cursor + 2 <= size)
+      {
+        guint16 unit = bytes[cursor] | ((guint16) bytes[cursor + 1] << 8);
+
+        if (!((unit >= 0x20 && unit <= 0x7e) || unit == '\t'))
+          break;
+
+        cursor += 2;
+        n_chars++;
+      }
+
+      if (n_chars >= min_length)
+      {
+        gchar * content;
+        guint k;
+
+        content = g_malloc (n_chars);
+        for (k = 0; k != n_chars; k++)
+          content[k] = (gchar) bytes[start + ((gsize) k * 2)];
+
+        gum_append_string_match (ctx, matches, index, core,
+            GUM_ADDRESS (GPOINTER_TO_SIZE (address) + start), cursor - start,
+            "utf16",
+            JS_NewStringLen (ctx, content, n_chars));
+
+        g_free (content);
+      }
+
+      if (cursor == start)
+        cursor += 2;
+    }
+  }
+}
+
+static void
+gum_append_string_match (JSContext * ctx,
+                         JSValue matches,
+                         uint32_t * index,
+                         GumQuickCore * core,
+                         GumAddress address,
+                         gsize size,
+                         const gchar * encoding,
+                         JSValue content)
+{
+  JSValue m;
+
+  m = JS_NewObject (ctx);
+  JS_DefinePropertyValue (ctx, m, GUM_QUICK_CORE_ATOM (core, address),
+      _gum_quick_native_pointer_new (ctx, GSIZE_TO_POINTER (address), core),
+      JS_PROP_C_W_E);
+  JS_DefinePropertyValue (ctx, m, GUM_QUICK_CORE_ATOM (core, size),
+      JS_NewUint32 (ctx, size),
+      JS_PROP_C_W_E);
+  JS_DefinePropertyValueStr (ctx, m, "encoding",
+      JS_NewString (ctx, encoding),
+      JS_PROP_C_W_E);
+  JS_DefinePropertyValueStr (ctx, m, "content", content, JS_PROP_C_W_E);
+
+  JS_DefinePropertyValueUint32 (ctx, matches, *index, m, JS_PROP_C_W_E);
+  (*index)++;
+}
+
 GUMJS_DEFINE_FUNCTION (gumjs_memory_access_monitor_enable)
 {
   GumQuickMemory * self;
@@ -10,6 +10,7 @@
 #include "gumquickcore.h"
 
 #include <gum/gummemoryaccessmonitor.h>
+#include <gum/gummemorymap.h>
 
 G_BEGIN_DECLS
 
@@ -19,6 +20,9 @@ struct _GumQuickMemory
 {
   GumQuickCore * core;
 
+  GumMemoryMap * readable_map;
+  guint readable_map_generation;
+
   GumMemoryAccessMonitor * monitor;
   JSValue on_access;
 
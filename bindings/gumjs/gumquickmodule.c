@@ -8,6 +8,8 @@
 
 #include "gumquickmacros.h"
 
+#include <gum/gumprocess-priv.h>
+
 typedef struct _GumQuickMatchContext GumQuickMatchContext;
 typedef struct _GumQuickModuleFilter GumQuickModuleFilter;
 
@@ -45,6 +47,8 @@ static gboolean gum_emit_range (const GumRangeDetails * details,
     GumQuickMatchContext * mc);
 GUMJS_DECLARE_FUNCTION (gumjs_module_find_base_address)
 GUMJS_DECLARE_FUNCTION (gumjs_module_find_export_by_name)
+static GumAddress gum_quick_module_find_cached_export (GumQuickModule * self,
+    const gchar * module_name, const gchar * symbol_name);
 
 GUMJS_DECLARE_CONSTRUCTOR (gumjs_module_map_construct)
 GUMJS_DECLARE_FINALIZER (gumjs_module_map_finalize)
@@ -104,6 +108,11 @@ _gum_quick_module_init (GumQuickModule * self,
 
   self->core = core;
 
+  self->export_tables = g_hash_table_new_full (g_str_hash, g_str_equal,
+      g_free, (GDestroyNotify) gum_export_table_free);
+  self->has_module_generation = _gum_process_try_query_module_generation (
+      &self->export_tables_generation);
+
   _gum_quick_core_store_module_data (core, "module", self);
 
   _gum_quick_create_class (ctx, &gumjs_module_def, core, &self->module_class,
@@ -135,6 +144,7 @@ _gum_quick_module_dispose (GumQuickModule * self)
 void
 _gum_quick_module_finalize (GumQuickModule * self)
 {
+  g_hash_table_unref (self->export_tables);
 }
 
 JSValue
@@ -476,16 +486,23 @@ GUMJS_DEFINE_FUNCTION (gumjs_module_find_base_address)
 
 GUMJS_DEFINE_FUNCTION (gumjs_module_find_export_by_name)
 {
+  GumQuickModule * self;
   const gchar * module_name, * symbol_name;
   GumQuickScope scope = GUM_QUICK_SCOPE_INIT (core);
   GumAddress address;
 
+  self = gumjs_get_parent_module (core);
+
   if (!_gum_quick_args_parse (args, "s?s", &module_name, &symbol_name))
     return JS_EXCEPTION;
 
   _gum_quick_scope_suspend (&scope);
 
-  address = gum_module_find_export_by_name (module_name, symbol_name);
+  if (module_name != NULL && self->has_module_generation)
+    address = gum_quick_module_find_cached_export (self, module_name,
+        symbol_name);
+  else
+    address = gum_module_find_export_by_name (module_name, symbol_name);
 
   _gum_quick_scope_resume (&scope);
 
@@ -495,6 +512,41 @@ GUMJS_DEFINE_FUNCTION (gumjs_module_find_export_by_name)
   return _gum_quick_native_pointer_new (ctx, GSIZE_TO_POINTER (address), core);
 }
 
+/*
+ * Scripts tend to poll findExportByName, so per-module export tables are
+ * kept around and binary-searched, with the loader's generation counter
+ * deciding when the set of tables must be dropped.
+ */
+static GumAddress
+gum_quick_module_find_cached_export (GumQuickModule * self,
+                                     const gchar * module_name,
+                                     const gchar * symbol_name)
+{
+  guint64 generation;
+  GumExportTable * table;
+  const GumExportTableEntry * entry;
+
+  if (_gum_process_try_query_module_generation (&generation) &&
+      generation != self->export_tables_generation)
+  {
+    g_hash_table_remove_all (self->export_tables);
+    self->export_tables_generation = generation;
+  }
+
+  table = g_hash_table_lookup (self->export_tables, module_name);
+  if (table == NULL)
+  {
+    table = gum_module_collect_exports (module_name);
+    g_hash_table_insert (self->export_tables, g_strdup (module_name), table);
+  }
+
+  entry = gum_export_table_find (table, symbol_name);
+  if (entry == NULL)
+    return 0;
+
+  return entry->address;
+}
+
 static gboolean
 gum_quick_module_map_get (JSContext * ctx,
                           JSValueConst val,
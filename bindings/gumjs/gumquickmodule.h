@@ -17,6 +17,10 @@ struct _GumQuickModule
 {
   GumQuickCore * core;
 
+  GHashTable * export_tables;
+  guint64 export_tables_generation;
+  gboolean has_module_generation;
+
   JSClassID module_class;
   JSClassID module_map_class;
 };
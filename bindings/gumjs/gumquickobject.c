@@ -8,6 +8,8 @@
 
 #include "gumquickmacros.h"
 
+#define GUM_QUICK_OBJECT_ARENA_BLOCK_CAPACITY 64
+
 typedef struct _GumQuickTryScheduleIfIdleOperation
     GumQuickTryScheduleIfIdleOperation;
 
@@ -17,7 +19,33 @@ struct _GumQuickTryScheduleIfIdleOperation
   GumQuickObjectOperation * blocked_operation;
 };
 
+/*
+ * Script-lifetime objects are tiny and typically die all at once when the
+ * agent is unloaded, so instead of hitting the heap once per object we
+ * carve them out of shared blocks that are released wholesale when the
+ * manager and the last object are gone. Objects may outlive their manager
+ * on this runtime, as the JS wrapper owns the object and dies with the
+ * context, hence the reference count. Cells are recycled through a free
+ * list, which may be pushed to from the thread pool.
+ */
+struct _GumQuickObjectArena
+{
+  gint ref_count;
+  GMutex mutex;
+  GSList * blocks;
+  gpointer free_cells;
+  guint n_used_in_current_block;
+};
+
+static GumQuickObjectArena * gum_quick_object_arena_new (void);
+static void gum_quick_object_arena_unref (GumQuickObjectArena * self);
+static GumQuickObject * gum_quick_object_arena_alloc (
+    GumQuickObjectArena * self);
+static void gum_quick_object_arena_release (GumQuickObjectArena * self,
+    GumQuickObject * object);
+
 static void gum_quick_object_free (GumQuickObject * self);
+static void gum_quick_object_release (GumQuickObject * self);
 
 static void gum_quick_object_operation_free (GumQuickObjectOperation * self);
 static void gum_quick_object_operation_try_schedule_when_idle (
@@ -35,6 +63,7 @@ _gum_quick_object_manager_init (GumQuickObjectManager * self,
   self->module = module;
   self->core = core;
   self->object_by_handle = g_hash_table_new (NULL, NULL);
+  self->arena = gum_quick_object_arena_new ();
   self->cancellable = g_cancellable_new ();
 }
 
@@ -72,9 +101,81 @@ _gum_quick_object_manager_free (GumQuickObjectManager * self)
   g_hash_table_remove_all (self->object_by_handle);
 
   g_object_unref (self->cancellable);
+  gum_quick_object_arena_unref (self->arena);
   g_hash_table_unref (self->object_by_handle);
 }
 
+static GumQuickObjectArena *
+gum_quick_object_arena_new (void)
+{
+  GumQuickObjectArena * arena;
+
+  arena = g_slice_new (GumQuickObjectArena);
+  arena->ref_count = 1;
+  g_mutex_init (&arena->mutex);
+  arena->blocks = NULL;
+  arena->free_cells = NULL;
+  arena->n_used_in_current_block = GUM_QUICK_OBJECT_ARENA_BLOCK_CAPACITY;
+
+  return arena;
+}
+
+static void
+gum_quick_object_arena_unref (GumQuickObjectArena * self)
+{
+  if (!g_atomic_int_dec_and_test (&self->ref_count))
+    return;
+
+  g_slist_free_full (self->blocks, g_free);
+  g_mutex_clear (&self->mutex);
+  g_slice_free (GumQuickObjectArena, self);
+}
+
+static GumQuickObject *
+gum_quick_object_arena_alloc (GumQuickObjectArena * self)
+{
+  GumQuickObject * object;
+
+  g_mutex_lock (&self->mutex);
+
+  if (self->free_cells != NULL)
+  {
+    object = self->free_cells;
+    self->free_cells = *(gpointer *) object;
+  }
+  else
+  {
+    if (self->n_used_in_current_block ==
+        GUM_QUICK_OBJECT_ARENA_BLOCK_CAPACITY)
+    {
+      self->blocks = g_slist_prepend (self->blocks, g_malloc (
+          GUM_QUICK_OBJECT_ARENA_BLOCK_CAPACITY * sizeof (GumQuickObject)));
+      self->n_used_in_current_block = 0;
+    }
+
+    object = (GumQuickObject *) self->blocks->data +
+        self->n_used_in_current_block++;
+  }
+
+  g_mutex_unlock (&self->mutex);
+
+  g_atomic_int_inc (&self->ref_count);
+
+  return object;
+}
+
+static void
+gum_quick_object_arena_release (GumQuickObjectArena * self,
+                                GumQuickObject * object)
+{
+  g_mutex_lock (&self->mutex);
+  *(gpointer *) object = self->free_cells;
+  self->free_cells = object;
+  g_mutex_unlock (&self->mutex);
+
+  gum_quick_object_arena_unref (self);
+}
+
 gpointer
 _gum_quick_object_manager_add (GumQuickObjectManager * self,
                                JSContext * ctx,
@@ -84,7 +185,7 @@ _gum_quick_object_manager_add (GumQuickObjectManager * self,
   GumQuickCore * core = self->core;
   GumQuickObject * object;
 
-  object = g_slice_new (GumQuickObject);
+  object = gum_quick_object_arena_alloc (self->arena);
   object->wrapper = wrapper;
   object->handle = handle;
   object->cancellable = g_cancellable_new ();
@@ -92,6 +193,7 @@ _gum_quick_object_manager_add (GumQuickObjectManager * self,
   object->core = core;
 
   object->manager = self;
+  object->arena = self->arena;
   object->num_active_operations = 0;
   object->pending_operations = g_queue_new ();
 
@@ -118,6 +220,8 @@ _gum_quick_object_manager_lookup (GumQuickObjectManager * self,
 static void
 gum_quick_object_free (GumQuickObject * self)
 {
+  GumScriptScheduler * scheduler = self->core->scheduler;
+
   if (self->manager != NULL)
     g_hash_table_remove (self->manager->object_by_handle, self->handle);
 
@@ -125,10 +229,22 @@ gum_quick_object_free (GumQuickObject * self)
   g_assert (g_queue_is_empty (self->pending_operations));
   g_queue_free (self->pending_operations);
 
+  /*
+   * Neither the handle nor the cancellable needs to die on the JS thread,
+   * and running their dispose handlers is the expensive part of tearing
+   * down a large agent, so hand them to the thread pool and move on.
+   */
+  gum_script_scheduler_push_job_on_thread_pool (scheduler,
+      (GumScriptJobFunc) gum_quick_object_release, self, NULL);
+}
+
+static void
+gum_quick_object_release (GumQuickObject * self)
+{
   g_object_unref (self->cancellable);
   g_object_unref (self->handle);
 
-  g_slice_free (GumQuickObject, self);
+  gum_quick_object_arena_release (self->arena, self);
 }
 
 gpointer
@@ -15,6 +15,7 @@
 G_BEGIN_DECLS
 
 typedef struct _GumQuickObjectManager GumQuickObjectManager;
+typedef struct _GumQuickObjectArena GumQuickObjectArena;
 typedef struct _GumQuickObject GumQuickObject;
 typedef struct _GumQuickObjectOperation GumQuickObjectOperation;
 typedef struct _GumQuickModuleOperation GumQuickModuleOperation;
@@ -27,6 +28,7 @@ struct _GumQuickObjectManager
   gpointer module;
   GumQuickCore * core;
   GHashTable * object_by_handle;
+  GumQuickObjectArena * arena;
   GCancellable * cancellable;
 };
 
@@ -39,6 +41,7 @@ struct _GumQuickObject
   GumQuickCore * core;
 
   GumQuickObjectManager * manager;
+  GumQuickObjectArena * arena;
   guint num_active_operations;
   GQueue * pending_operations;
 };
@@ -8,6 +8,8 @@
 #include "gumquickprocess.h"
 
 #include "gumquickmacros.h"
+
+#include <gum/gumprocess-priv.h>
 #ifdef HAVE_DARWIN
 # include <gumdarwin.h>
 #endif
@@ -37,6 +39,7 @@
 #endif
 
 typedef struct _GumQuickMatchContext GumQuickMatchContext;
+typedef struct _GumQuickCachedModule GumQuickCachedModule;
 typedef struct _GumQuickFindModuleByNameContext GumQuickFindModuleByNameContext;
 typedef struct _GumQuickFindRangeByAddressContext
     GumQuickFindRangeByAddressContext;
@@ -57,6 +60,13 @@ struct _GumQuickMatchContext
   GumQuickProcess * parent;
 };
 
+struct _GumQuickCachedModule
+{
+  gchar * name;
+  gchar * path;
+  GumMemoryRange range;
+};
+
 struct _GumQuickFindModuleByNameContext
 {
   const gchar * name;
@@ -87,6 +97,11 @@ static gboolean gum_store_module_if_name_matches (
 GUMJS_DECLARE_FUNCTION (gumjs_process_enumerate_modules)
 static gboolean gum_emit_module (const GumModuleDetails * details,
     GumQuickMatchContext * mc);
+static GArray * gum_quick_process_get_module_snapshot (
+    GumQuickProcess * self);
+static gboolean gum_quick_process_collect_module (
+    const GumModuleDetails * details, gpointer user_data);
+static void gum_quick_cached_module_clear (GumQuickCachedModule * module);
 GUMJS_DECLARE_FUNCTION (gumjs_process_find_range_by_address)
 static gboolean gum_store_range_if_containing_address (
     const GumRangeDetails * details, GumQuickFindRangeByAddressContext * fc);
@@ -135,6 +150,9 @@ _gum_quick_process_init (GumQuickProcess * self,
   self->module = module;
   self->core = core;
 
+  self->has_module_generation =
+      _gum_process_try_query_module_generation (&self->cached_modules_generation);
+
   _gum_quick_core_store_module_data (core, "process", self);
 
   obj = JS_NewObject (ctx);
@@ -166,6 +184,7 @@ _gum_quick_process_dispose (GumQuickProcess * self)
 void
 _gum_quick_process_finalize (GumQuickProcess * self)
 {
+  g_clear_pointer (&self->cached_modules, g_array_unref);
 }
 
 static GumQuickProcess *
@@ -286,6 +305,7 @@ gum_store_module_if_name_matches (const GumModuleDetails * details,
 GUMJS_DEFINE_FUNCTION (gumjs_process_enumerate_modules)
 {
   GumQuickMatchContext mc;
+  GArray * modules;
 
   if (!_gum_quick_args_parse (args, "F{onMatch,onComplete}", &mc.on_match,
       &mc.on_complete))
@@ -294,7 +314,29 @@ GUMJS_DEFINE_FUNCTION (gumjs_process_enumerate_modules)
   mc.ctx = ctx;
   mc.parent = gumjs_get_parent_module (core);
 
-  gum_process_enumerate_modules ((GumFoundModuleFunc) gum_emit_module, &mc);
+  modules = gum_quick_process_get_module_snapshot (mc.parent);
+  if (modules != NULL)
+  {
+    guint i;
+
+    for (i = 0; i != modules->len; i++)
+    {
+      GumQuickCachedModule * m =
+          &g_array_index (modules, GumQuickCachedModule, i);
+      GumModuleDetails details;
+
+      details.name = m->name;
+      details.range = &m->range;
+      details.path = m->path;
+
+      if (!gum_emit_module (&details, &mc))
+        break;
+    }
+  }
+  else
+  {
+    gum_process_enumerate_modules ((GumFoundModuleFunc) gum_emit_module, &mc);
+  }
 
   return _gum_quick_maybe_call_on_complete (ctx, mc.result, mc.on_complete);
 }
@@ -315,6 +357,69 @@ gum_emit_module (const GumModuleDetails * details,
   return _gum_quick_process_match_result (ctx, &result, &mc->result);
 }
 
+/*
+ * Scripts tend to call enumerateModules() in tight polling loops, so the
+ * native module walk is snapshotted and replayed until the loader's
+ * generation counter indicates that modules have been added or removed.
+ */
+
+static GArray *
+gum_quick_process_get_module_snapshot (GumQuickProcess * self)
+{
+  guint64 generation;
+
+  if (!self->has_module_generation)
+    return NULL;
+
+  if (!_gum_process_try_query_module_generation (&generation))
+    return NULL;
+
+  if (self->cached_modules != NULL &&
+      generation == self->cached_modules_generation)
+    return self->cached_modules;
+
+  if (self->cached_modules == NULL)
+  {
+    self->cached_modules =
+        g_array_new (FALSE, FALSE, sizeof (GumQuickCachedModule));
+    g_array_set_clear_func (self->cached_modules,
+        (GDestroyNotify) gum_quick_cached_module_clear);
+  }
+  else
+  {
+    g_array_set_size (self->cached_modules, 0);
+  }
+
+  gum_process_enumerate_modules (gum_quick_process_collect_module,
+      self->cached_modules);
+  self->cached_modules_generation = generation;
+
+  return self->cached_modules;
+}
+
+static gboolean
+gum_quick_process_collect_module (const GumModuleDetails * details,
+                                  gpointer user_data)
+{
+  GArray * modules = user_data;
+  GumQuickCachedModule m;
+
+  m.name = g_strdup (details->name);
+  m.path = g_strdup (details->path);
+  m.range = *details->range;
+
+  g_array_append_val (modules, m);
+
+  return TRUE;
+}
+
+static void
+gum_quick_cached_module_clear (GumQuickCachedModule * module)
+{
+  g_free (module->name);
+  g_free (module->path);
+}
+
 GUMJS_DEFINE_FUNCTION (gumjs_process_find_range_by_address)
 {
   GumQuickFindRangeByAddressContext fc;
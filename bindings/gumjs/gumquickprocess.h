@@ -20,6 +20,10 @@ struct _GumQuickProcess
   GumQuickModule * module;
   GumQuickCore * core;
 
+  GArray * cached_modules;
+  guint64 cached_modules_generation;
+  gboolean has_module_generation;
+
   GumQuickExceptionHandler * exception_handler;
 };
 
@@ -48,6 +48,7 @@ struct _GumQuickScript
   GumQuickScriptBackend * backend;
 
   GumScriptState state;
+  gboolean runtime_loaded;
   GSList * on_unload;
   JSRuntime * rt;
   JSContext * ctx;
@@ -74,6 +75,10 @@ struct _GumQuickScript
   GumScriptMessageHandler message_handler;
   gpointer message_handler_data;
   GDestroyNotify message_handler_data_destroy;
+
+  GMutex emit_mutex;
+  GQueue emit_queue;
+  gboolean emit_flush_scheduled;
 };
 
 enum
@@ -102,7 +107,6 @@ struct _GumUnloadNotifyCallback
 
 struct _GumEmitData
 {
-  GumQuickScript * script;
   gchar * message;
   GBytes * data;
 };
@@ -162,7 +166,7 @@ static GumStalker * gum_quick_script_get_stalker (GumScript * script);
 
 static void gum_quick_script_emit (GumQuickScript * self,
     const gchar * message, GBytes * data);
-static gboolean gum_quick_script_do_emit (GumEmitData * d);
+static gboolean gum_quick_script_do_emit (GumQuickScript * self);
 static void gum_quick_emit_data_free (GumEmitData * d);
 
 G_DEFINE_TYPE_EXTENDED (GumQuickScript,
@@ -227,6 +231,10 @@ gum_quick_script_init (GumQuickScript * self)
 
   self->state = GUM_SCRIPT_STATE_UNLOADED;
   self->on_unload = NULL;
+
+  g_mutex_init (&self->emit_mutex);
+  g_queue_init (&self->emit_queue);
+  self->emit_flush_scheduled = FALSE;
 }
 
 static void
@@ -259,6 +267,12 @@ gum_quick_script_finalize (GObject * object)
 {
   GumQuickScript * self = GUM_QUICK_SCRIPT (object);
 
+  GumEmitData * d;
+
+  while ((d = g_queue_pop_head (&self->emit_queue)) != NULL)
+    gum_quick_emit_data_free (d);
+  g_mutex_clear (&self->emit_mutex);
+
   g_free (self->name);
   g_free (self->source);
   g_bytes_unref (self->bytecode);
@@ -356,11 +370,15 @@ gum_quick_script_create_context (GumQuickScript * self,
     val = gum_quick_script_backend_read_program (self->backend, ctx,
         self->bytecode, error);
   }
-  else
+  else if (self->source != NULL)
   {
     val = gum_quick_script_backend_compile_program (self->backend, ctx,
         self->name, self->source, error);
   }
+  else
+  {
+    val = JS_NULL;
+  }
   if (JS_IsException (val))
     goto malformed_program;
 
@@ -416,6 +434,76 @@ malformed_program:
   }
 }
 
+/*
+ * Bootstraps a script without a program: context created, bridges bound,
+ * and the runtime bundle evaluated, so all that remains at claim time is
+ * reading the program and evaluating it. Used by the backend to maintain
+ * its warm-standby pool.
+ */
+gboolean
+gum_quick_script_warm_up (GumQuickScript * self,
+                          GError ** error)
+{
+  GumQuickScope scope;
+
+  g_assert (self->source == NULL && self->bytecode == NULL);
+
+  if (!gum_quick_script_create_context (self, error))
+    return FALSE;
+
+  _gum_quick_scope_enter (&scope, &self->core);
+
+  gum_quick_bundle_load (gumjs_runtime_modules, self->ctx);
+  self->runtime_loaded = TRUE;
+
+  _gum_quick_scope_leave (&scope);
+
+  return TRUE;
+}
+
+/*
+ * Binds a program to a warmed-up script, making it indistinguishable from
+ * one created the regular way. Returns FALSE with `error` set and leaves
+ * the script untouched if the program is malformed.
+ */
+gboolean
+gum_quick_script_adopt_program (GumQuickScript * self,
+                                const gchar * name,
+                                GBytes * bytecode,
+                                GMainContext * main_context,
+                                GError ** error)
+{
+  GumQuickScope scope;
+  JSValue val;
+
+  g_assert (self->ctx != NULL && JS_IsNull (self->code));
+
+  _gum_quick_scope_enter (&scope, &self->core);
+  val = gum_quick_script_backend_read_program (self->backend, self->ctx,
+      bytecode, error);
+  _gum_quick_scope_leave (&scope);
+  if (JS_IsException (val))
+    return FALSE;
+
+  if (name != NULL)
+  {
+    g_free (self->name);
+    self->name = g_strdup (name);
+  }
+
+  g_bytes_unref (self->bytecode);
+  self->bytecode = g_bytes_ref (bytecode);
+
+  if (self->main_context != NULL)
+    g_main_context_unref (self->main_context);
+  self->main_context =
+      (main_context != NULL) ? g_main_context_ref (main_context) : NULL;
+
+  self->code = val;
+
+  return TRUE;
+}
+
 static void
 gum_quick_script_destroy_context (GumQuickScript * self)
 {
@@ -467,6 +555,8 @@ gum_quick_script_destroy_context (GumQuickScript * self)
     core->current_scope = NULL;
   }
 
+  self->runtime_loaded = FALSE;
+
   _gum_quick_stalker_finalize (&self->stalker);
   _gum_quick_code_relocator_finalize (&self->code_relocator);
   _gum_quick_code_writer_finalize (&self->code_writer);
@@ -566,7 +656,11 @@ gum_quick_script_perform_load_task (GumQuickScript * self,
 
     _gum_quick_scope_enter (&scope, &self->core);
 
-    gum_quick_bundle_load (gumjs_runtime_modules, ctx);
+    if (!self->runtime_loaded)
+    {
+      gum_quick_bundle_load (gumjs_runtime_modules, ctx);
+      self->runtime_loaded = TRUE;
+    }
 
     result = JS_EvalFunction (ctx, self->code);
     self->code = JS_NULL;
@@ -776,38 +870,63 @@ gum_quick_script_get_stalker (GumScript * script)
   return _gum_quick_stalker_get (&self->stalker);
 }
 
+/*
+ * Emitted messages are queued and flushed in one batch per main-loop
+ * tick, so a script blasting messages pays for a single source attach —
+ * and main-context wakeup — per tick instead of one per message.
+ */
 static void
 gum_quick_script_emit (GumQuickScript * self,
                        const gchar * message,
                        GBytes * data)
 {
   GumEmitData * d;
+  gboolean flush_scheduled;
   GSource * source;
 
   d = g_slice_new (GumEmitData);
-  d->script = self;
-  g_object_ref (self);
   d->message = g_strdup (message);
   d->data = (data != NULL) ? g_bytes_ref (data) : NULL;
 
+  g_mutex_lock (&self->emit_mutex);
+  g_queue_push_tail (&self->emit_queue, d);
+  flush_scheduled = self->emit_flush_scheduled;
+  self->emit_flush_scheduled = TRUE;
+  g_mutex_unlock (&self->emit_mutex);
+
+  if (flush_scheduled)
+    return;
+
   source = g_idle_source_new ();
   g_source_set_callback (source,
       (GSourceFunc) gum_quick_script_do_emit,
-      d,
-      (GDestroyNotify) gum_quick_emit_data_free);
+      g_object_ref (self),
+      g_object_unref);
   g_source_attach (source, self->main_context);
   g_source_unref (source);
 }
 
 static gboolean
-gum_quick_script_do_emit (GumEmitData * d)
+gum_quick_script_do_emit (GumQuickScript * self)
 {
-  GumQuickScript * self = d->script;
+  GQueue pending;
+  GumEmitData * d;
+
+  g_mutex_lock (&self->emit_mutex);
+  pending = self->emit_queue;
+  g_queue_init (&self->emit_queue);
+  self->emit_flush_scheduled = FALSE;
+  g_mutex_unlock (&self->emit_mutex);
 
-  if (self->message_handler != NULL)
+  while ((d = g_queue_pop_head (&pending)) != NULL)
   {
-    self->message_handler (GUM_SCRIPT (self), d->message, d->data,
-        self->message_handler_data);
+    if (self->message_handler != NULL)
+    {
+      self->message_handler (GUM_SCRIPT (self), d->message, d->data,
+          self->message_handler_data);
+    }
+
+    gum_quick_emit_data_free (d);
   }
 
   return FALSE;
@@ -818,7 +937,6 @@ gum_quick_emit_data_free (GumEmitData * d)
 {
   g_bytes_unref (d->data);
   g_free (d->message);
-  g_object_unref (d->script);
 
   g_slice_free (GumEmitData, d);
 }
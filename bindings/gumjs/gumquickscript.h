@@ -17,6 +17,11 @@ G_DECLARE_FINAL_TYPE (GumQuickScript, gum_quick_script, GUM_QUICK, SCRIPT,
 
 G_GNUC_INTERNAL gboolean gum_quick_script_create_context (GumQuickScript * self,
     GError ** error);
+G_GNUC_INTERNAL gboolean gum_quick_script_warm_up (GumQuickScript * self,
+    GError ** error);
+G_GNUC_INTERNAL gboolean gum_quick_script_adopt_program (GumQuickScript * self,
+    const gchar * name, GBytes * bytecode, GMainContext * main_context,
+    GError ** error);
 
 G_END_DECLS
 
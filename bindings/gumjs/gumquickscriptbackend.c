@@ -11,12 +11,14 @@
 #include "gumquickscriptbackend-priv.h"
 #include "gumscripttask.h"
 
+#include <gum/gum-init.h>
 #include <stdlib.h>
 #include <string.h>
 
 typedef struct _GumCreateScriptData GumCreateScriptData;
 typedef struct _GumCreateScriptFromBytesData GumCreateScriptFromBytesData;
 typedef struct _GumCompileScriptData GumCompileScriptData;
+typedef struct _GumPrewarmRequest GumPrewarmRequest;
 
 struct _GumQuickScriptBackend
 {
@@ -26,6 +28,10 @@ struct _GumQuickScriptBackend
   GRecMutex scope_mutex;
   gboolean scope_mutex_trapped;
 
+  GHashTable * bytecode_cache;
+
+  GQueue warm_scripts;
+
   GumScriptScheduler * scheduler;
 };
 
@@ -46,6 +52,12 @@ struct _GumCompileScriptData
   gchar * source;
 };
 
+struct _GumPrewarmRequest
+{
+  GumQuickScriptBackend * backend;
+  guint pool_size;
+};
+
 static void gum_quick_script_backend_iface_init (gpointer g_iface,
     gpointer iface_data);
 static void gum_quick_script_backend_dispose (GObject * object);
@@ -100,6 +112,9 @@ static void gum_compile_script_task_run (GumScriptTask * task,
     GumQuickScriptBackend * self, GumCompileScriptData * d,
     GCancellable * cancellable);
 static void gum_compile_script_data_free (GumCompileScriptData * d);
+static GBytes * gum_quick_script_backend_compile_to_bytecode (
+    GumQuickScriptBackend * self, const gchar * name, const gchar * source,
+    GError ** error);
 
 static void gum_quick_script_backend_set_debug_message_handler (
     GumScriptBackend * backend, GumScriptBackendDebugMessageHandler handler,
@@ -111,6 +126,16 @@ static void gum_quick_script_backend_with_lock_held (GumScriptBackend * backend,
     GumScriptBackendLockedFunc func, gpointer user_data);
 static gboolean gum_quick_script_backend_is_locked (GumScriptBackend * backend);
 
+static void gum_quick_script_backend_prewarm (GumScriptBackend * backend,
+    guint pool_size);
+static void gum_quick_script_backend_do_prewarm (GumPrewarmRequest * request);
+static void gum_prewarm_request_free (GumPrewarmRequest * request);
+static GumQuickScript * gum_quick_script_backend_claim_warm_script (
+    GumQuickScriptBackend * self);
+static void gum_quick_script_backend_drain_warm_scripts (
+    GumQuickScriptBackend * self);
+static void gum_quick_script_backend_deinit_warm_scripts (void);
+
 #ifndef HAVE_ASAN
 static void * gum_quick_malloc (JSMallocState * state, size_t size);
 static void gum_quick_free (JSMallocState * state, void * ptr);
@@ -160,6 +185,8 @@ gum_quick_script_backend_iface_init (gpointer g_iface,
 
   iface->with_lock_held = gum_quick_script_backend_with_lock_held;
   iface->is_locked = gum_quick_script_backend_is_locked;
+
+  iface->prewarm = gum_quick_script_backend_prewarm;
 }
 
 static void
@@ -169,6 +196,11 @@ gum_quick_script_backend_init (GumQuickScriptBackend * self)
   g_rec_mutex_init (&self->scope_mutex);
   self->scope_mutex_trapped = FALSE;
 
+  self->bytecode_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+      g_free, (GDestroyNotify) g_bytes_unref);
+
+  g_queue_init (&self->warm_scripts);
+
   self->scheduler = g_object_ref (gum_script_backend_get_scheduler ());
 }
 
@@ -177,6 +209,8 @@ gum_quick_script_backend_dispose (GObject * object)
 {
   GumQuickScriptBackend * self = GUM_QUICK_SCRIPT_BACKEND (object);
 
+  gum_quick_script_backend_drain_warm_scripts (self);
+
   g_clear_object (&self->scheduler);
 
   G_OBJECT_CLASS (gum_quick_script_backend_parent_class)->dispose (object);
@@ -187,6 +221,8 @@ gum_quick_script_backend_finalize (GObject * object)
 {
   GumQuickScriptBackend * self = GUM_QUICK_SCRIPT_BACKEND (object);
 
+  g_hash_table_unref (self->bytecode_cache);
+
   g_mutex_clear (&self->mutex);
   g_rec_mutex_clear (&self->scope_mutex);
 
@@ -365,6 +401,11 @@ gum_create_script_task_new (GumQuickScriptBackend * backend,
   return task;
 }
 
+/*
+ * Parsing a large agent from source dominates load time, so compiled
+ * bytecode is cached keyed by name and source digest; subsequent loads of
+ * the same script skip parsing and go straight through JS_ReadObject.
+ */
 static void
 gum_create_script_task_run (GumScriptTask * task,
                             GumQuickScriptBackend * self,
@@ -372,16 +413,60 @@ gum_create_script_task_run (GumScriptTask * task,
                             GCancellable * cancellable)
 {
   GumQuickScript * script;
+  GBytes * bytecode;
+  gchar * checksum, * cache_key;
   GError * error = NULL;
 
-  script = g_object_new (GUM_QUICK_TYPE_SCRIPT,
-      "name", d->name,
-      "source", d->source,
-      "main-context", gum_script_task_get_context (task),
-      "backend", self,
-      NULL);
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA256, d->source, -1);
+  cache_key = g_strconcat (d->name, ":", checksum, NULL);
+  g_free (checksum);
 
-  gum_quick_script_create_context (script, &error);
+  g_mutex_lock (&self->mutex);
+  bytecode = g_hash_table_lookup (self->bytecode_cache, cache_key);
+  if (bytecode != NULL)
+    g_bytes_ref (bytecode);
+  g_mutex_unlock (&self->mutex);
+
+  if (bytecode == NULL)
+  {
+    bytecode = gum_quick_script_backend_compile_to_bytecode (self, d->name,
+        d->source, &error);
+    if (bytecode != NULL)
+    {
+      g_mutex_lock (&self->mutex);
+      g_hash_table_replace (self->bytecode_cache, g_strdup (cache_key),
+          g_bytes_ref (bytecode));
+      g_mutex_unlock (&self->mutex);
+    }
+  }
+
+  g_free (cache_key);
+
+  if (error != NULL)
+  {
+    gum_script_task_return_error (task, error);
+    return;
+  }
+
+  script = gum_quick_script_backend_claim_warm_script (self);
+  if (script != NULL)
+  {
+    gum_quick_script_adopt_program (script, d->name, bytecode,
+        gum_script_task_get_context (task), &error);
+  }
+  else
+  {
+    script = g_object_new (GUM_QUICK_TYPE_SCRIPT,
+        "name", d->name,
+        "bytecode", bytecode,
+        "main-context", gum_script_task_get_context (task),
+        "backend", self,
+        NULL);
+
+    gum_quick_script_create_context (script, &error);
+  }
+
+  g_bytes_unref (bytecode);
 
   if (error == NULL)
   {
@@ -476,13 +561,22 @@ gum_create_script_from_bytes_task_run (GumScriptTask * task,
   GumQuickScript * script;
   GError * error = NULL;
 
-  script = g_object_new (GUM_QUICK_TYPE_SCRIPT,
-      "bytecode", d->bytes,
-      "main-context", gum_script_task_get_context (task),
-      "backend", self,
-      NULL);
+  script = gum_quick_script_backend_claim_warm_script (self);
+  if (script != NULL)
+  {
+    gum_quick_script_adopt_program (script, NULL, d->bytes,
+        gum_script_task_get_context (task), &error);
+  }
+  else
+  {
+    script = g_object_new (GUM_QUICK_TYPE_SCRIPT,
+        "bytecode", d->bytes,
+        "main-context", gum_script_task_get_context (task),
+        "backend", self,
+        NULL);
 
-  gum_quick_script_create_context (script, &error);
+    gum_quick_script_create_context (script, &error);
+  }
 
   if (error == NULL)
   {
@@ -574,22 +668,45 @@ gum_compile_script_task_run (GumScriptTask * task,
                              GumCompileScriptData * d,
                              GCancellable * cancellable)
 {
+  GBytes * bytes;
+  GError * error = NULL;
+
+  bytes = gum_quick_script_backend_compile_to_bytecode (self, d->name,
+      d->source, &error);
+
+  if (error == NULL)
+  {
+    gum_script_task_return_pointer (task, bytes,
+        (GDestroyNotify) g_bytes_unref);
+  }
+  else
+  {
+    gum_script_task_return_error (task, error);
+  }
+}
+
+static GBytes *
+gum_quick_script_backend_compile_to_bytecode (GumQuickScriptBackend * self,
+                                              const gchar * name,
+                                              const gchar * source,
+                                              GError ** error)
+{
+  GBytes * bytes = NULL;
   JSRuntime * rt;
   JSContext * ctx;
   JSValue val;
-  GError * error = NULL;
+  GError * compile_error = NULL;
 
   rt = gum_quick_script_backend_make_runtime (self);
   ctx = JS_NewContext (rt);
 
-  val = gum_quick_script_backend_compile_program (self, ctx, d->name, d->source,
-      &error);
+  val = gum_quick_script_backend_compile_program (self, ctx, name, source,
+      &compile_error);
 
-  if (error == NULL)
+  if (compile_error == NULL)
   {
     uint8_t * code;
     size_t size;
-    GBytes * bytes;
     GDestroyNotify free_impl;
 
 #ifndef HAVE_ASAN
@@ -602,16 +719,17 @@ gum_compile_script_task_run (GumScriptTask * task,
 
     bytes = g_bytes_new_with_free_func (code, size, free_impl, code);
 
-    gum_script_task_return_pointer (task, bytes,
-        (GDestroyNotify) g_bytes_unref);
+    JS_FreeValue (ctx, val);
   }
   else
   {
-    gum_script_task_return_error (task, error);
-
-    JS_FreeContext (ctx);
-    JS_FreeRuntime (rt);
+    g_propagate_error (error, compile_error);
   }
+
+  JS_FreeContext (ctx);
+  JS_FreeRuntime (rt);
+
+  return bytes;
 }
 
 static void
@@ -674,6 +792,110 @@ gum_quick_script_backend_is_locked (GumScriptBackend * backend)
   return FALSE;
 }
 
+/*
+ * Tops up a pool of scripts that have a runtime, a context, all bridges,
+ * and the runtime bundle already in place, so create() only has to read
+ * the program into a claimed context. Filling happens on the JS thread at
+ * low priority to stay out of the way of real work.
+ */
+static void
+gum_quick_script_backend_prewarm (GumScriptBackend * backend,
+                                  guint pool_size)
+{
+  GumQuickScriptBackend * self = GUM_QUICK_SCRIPT_BACKEND (backend);
+  static gsize deinit_registered = FALSE;
+  GumPrewarmRequest * request;
+
+  if (g_once_init_enter (&deinit_registered))
+  {
+    _gum_register_early_destructor (
+        gum_quick_script_backend_deinit_warm_scripts);
+
+    g_once_init_leave (&deinit_registered, TRUE);
+  }
+
+  request = g_slice_new (GumPrewarmRequest);
+  request->backend = g_object_ref (self);
+  request->pool_size = pool_size;
+
+  gum_script_scheduler_push_job_on_js_thread (self->scheduler, G_PRIORITY_LOW,
+      (GumScriptJobFunc) gum_quick_script_backend_do_prewarm, request,
+      (GDestroyNotify) gum_prewarm_request_free);
+}
+
+static void
+gum_quick_script_backend_do_prewarm (GumPrewarmRequest * request)
+{
+  GumQuickScriptBackend * self = request->backend;
+
+  while (TRUE)
+  {
+    GumQuickScript * script;
+    gboolean satisfied;
+
+    g_mutex_lock (&self->mutex);
+    satisfied = self->warm_scripts.length >= request->pool_size;
+    g_mutex_unlock (&self->mutex);
+
+    if (satisfied)
+      break;
+
+    script = g_object_new (GUM_QUICK_TYPE_SCRIPT,
+        "backend", self,
+        NULL);
+
+    if (!gum_quick_script_warm_up (script, NULL))
+    {
+      g_object_unref (script);
+      break;
+    }
+
+    g_mutex_lock (&self->mutex);
+    g_queue_push_tail (&self->warm_scripts, script);
+    g_mutex_unlock (&self->mutex);
+  }
+}
+
+static void
+gum_prewarm_request_free (GumPrewarmRequest * request)
+{
+  g_object_unref (request->backend);
+
+  g_slice_free (GumPrewarmRequest, request);
+}
+
+static GumQuickScript *
+gum_quick_script_backend_claim_warm_script (GumQuickScriptBackend * self)
+{
+  GumQuickScript * script;
+
+  g_mutex_lock (&self->mutex);
+  script = g_queue_pop_head (&self->warm_scripts);
+  g_mutex_unlock (&self->mutex);
+
+  return script;
+}
+
+static void
+gum_quick_script_backend_drain_warm_scripts (GumQuickScriptBackend * self)
+{
+  GumQuickScript * script;
+
+  while ((script = gum_quick_script_backend_claim_warm_script (self)) != NULL)
+    g_object_unref (script);
+}
+
+/*
+ * Pooled scripts each hold a reference to the backend, so the pool must be
+ * emptied explicitly for the backend singleton to wind down.
+ */
+static void
+gum_quick_script_backend_deinit_warm_scripts (void)
+{
+  gum_quick_script_backend_drain_warm_scripts (
+      GUM_QUICK_SCRIPT_BACKEND (gum_script_backend_obtain_qjs ()));
+}
+
 gboolean
 gum_quick_script_backend_is_scope_mutex_trapped (GumQuickScriptBackend * self)
 {
@@ -94,6 +94,7 @@ GUMJS_DECLARE_FUNCTION (gumjs_stalker_unfollow)
 GUMJS_DECLARE_FUNCTION (gumjs_stalker_add_call_probe)
 GUMJS_DECLARE_FUNCTION (gumjs_stalker_remove_call_probe)
 GUMJS_DECLARE_FUNCTION (gumjs_stalker_parse)
+GUMJS_DECLARE_FUNCTION (gumjs_stalker_parse_columns)
 
 static void gum_quick_transformer_iface_init (gpointer g_iface,
     gpointer iface_data);
@@ -164,6 +165,8 @@ static void gum_quick_stalker_release_probe_args (GumQuickStalker * self,
 
 static JSValue gum_encode_pointer (JSContext * ctx, gpointer value,
     gboolean stringify, GumQuickCore * core);
+static JSValue gum_make_column (JSContext * ctx, const char * ctor_name,
+    size_t count, gpointer * data);
 
 static const JSCFunctionListEntry gumjs_stalker_entries[] =
 {
@@ -181,6 +184,7 @@ static const JSCFunctionListEntry gumjs_stalker_entries[] =
   JS_CFUNC_DEF ("addCallProbe", 0, gumjs_stalker_add_call_probe),
   JS_CFUNC_DEF ("removeCallProbe", 0, gumjs_stalker_remove_call_probe),
   JS_CFUNC_DEF ("_parse", 0, gumjs_stalker_parse),
+  JS_CFUNC_DEF ("_parseColumns", 0, gumjs_stalker_parse_columns),
 };
 
 static const JSClassDef gumjs_default_iterator_def =
@@ -782,6 +786,166 @@ propagate_exception:
   }
 }
 
+/*
+ * Decodes a GumEvent buffer into a structure-of-arrays: one flat typed
+ * array per field, so consumers iterate plain Float64/Uint32/Int32 data
+ * instead of nested JS arrays. Block and compile events store begin in
+ * `location` and end in `target`; fields an event type lacks are zero.
+ */
+GUMJS_DEFINE_FUNCTION (gumjs_stalker_parse_columns)
+{
+  JSValue result = JS_NULL;
+  JSValue events_value;
+  const GumEvent * events;
+  size_t size, count, i;
+  JSValue type_val = JS_NULL, location_val = JS_NULL, target_val = JS_NULL;
+  JSValue depth_val = JS_NULL;
+  uint32_t * type_col;
+  double * location_col, * target_col;
+  int32_t * depth_col;
+  const GumEvent * ev;
+
+  if (!_gum_quick_args_parse (args, "V", &events_value))
+    return JS_EXCEPTION;
+
+  events = (const GumEvent *) JS_GetArrayBuffer (ctx, &size, events_value);
+  if (events == NULL)
+    return JS_EXCEPTION;
+
+  if (size % sizeof (GumEvent) != 0)
+    goto invalid_buffer_shape;
+
+  count = size / sizeof (GumEvent);
+
+  type_val = gum_make_column (ctx, "Uint32Array", count,
+      (gpointer *) &type_col);
+  if (JS_IsException (type_val))
+    goto propagate_exception;
+  location_val = gum_make_column (ctx, "Float64Array", count,
+      (gpointer *) &location_col);
+  if (JS_IsException (location_val))
+    goto propagate_exception;
+  target_val = gum_make_column (ctx, "Float64Array", count,
+      (gpointer *) &target_col);
+  if (JS_IsException (target_val))
+    goto propagate_exception;
+  depth_val = gum_make_column (ctx, "Int32Array", count,
+      (gpointer *) &depth_col);
+  if (JS_IsException (depth_val))
+    goto propagate_exception;
+
+  for (ev = events, i = 0; i != count; ev++, i++)
+  {
+    type_col[i] = (uint32_t) ev->type;
+
+    switch (ev->type)
+    {
+      case GUM_CALL:
+        location_col[i] = (double) GPOINTER_TO_SIZE (ev->call.location);
+        target_col[i] = (double) GPOINTER_TO_SIZE (ev->call.target);
+        depth_col[i] = ev->call.depth;
+        break;
+      case GUM_RET:
+        location_col[i] = (double) GPOINTER_TO_SIZE (ev->ret.location);
+        target_col[i] = (double) GPOINTER_TO_SIZE (ev->ret.target);
+        depth_col[i] = ev->ret.depth;
+        break;
+      case GUM_EXEC:
+        location_col[i] = (double) GPOINTER_TO_SIZE (ev->exec.location);
+        target_col[i] = 0;
+        depth_col[i] = 0;
+        break;
+      case GUM_BLOCK:
+        location_col[i] = (double) GPOINTER_TO_SIZE (ev->block.begin);
+        target_col[i] = (double) GPOINTER_TO_SIZE (ev->block.end);
+        depth_col[i] = 0;
+        break;
+      case GUM_COMPILE:
+        location_col[i] = (double) GPOINTER_TO_SIZE (ev->compile.begin);
+        target_col[i] = (double) GPOINTER_TO_SIZE (ev->compile.end);
+        depth_col[i] = 0;
+        break;
+      default:
+        goto invalid_event_type;
+    }
+  }
+
+  result = JS_NewObject (ctx);
+  JS_DefinePropertyValueStr (ctx, result, "length",
+      JS_NewInt64 (ctx, count), JS_PROP_C_W_E);
+  JS_DefinePropertyValueStr (ctx, result, "type", type_val, JS_PROP_C_W_E);
+  JS_DefinePropertyValueStr (ctx, result, "location", location_val,
+      JS_PROP_C_W_E);
+  JS_DefinePropertyValueStr (ctx, result, "target", target_val,
+      JS_PROP_C_W_E);
+  JS_DefinePropertyValueStr (ctx, result, "depth", depth_val, JS_PROP_C_W_E);
+
+  return result;
+
+invalid_buffer_shape:
+  {
+    _gum_quick_throw_literal (ctx, "invalid buffer shape");
+    goto propagate_exception;
+  }
+invalid_event_type:
+  {
+    _gum_quick_throw_literal (ctx, "invalid event type");
+    goto propagate_exception;
+  }
+propagate_exception:
+  {
+    JS_FreeValue (ctx, depth_val);
+    JS_FreeValue (ctx, target_val);
+    JS_FreeValue (ctx, location_val);
+    JS_FreeValue (ctx, type_val);
+
+    return JS_EXCEPTION;
+  }
+}
+
+static JSValue
+gum_make_column (JSContext * ctx,
+                 const char * ctor_name,
+                 size_t count,
+                 gpointer * data)
+{
+  JSValue global, ctor, length_val, column, buf;
+  size_t byte_offset, byte_length, buf_size;
+  uint8_t * buf_data;
+
+  global = JS_GetGlobalObject (ctx);
+  ctor = JS_GetPropertyStr (ctx, global, ctor_name);
+  JS_FreeValue (ctx, global);
+  if (JS_IsException (ctor))
+    return JS_EXCEPTION;
+
+  length_val = JS_NewInt64 (ctx, count);
+  column = JS_CallConstructor (ctx, ctor, 1, &length_val);
+  JS_FreeValue (ctx, length_val);
+  JS_FreeValue (ctx, ctor);
+  if (JS_IsException (column))
+    return JS_EXCEPTION;
+
+  buf = JS_GetTypedArrayBuffer (ctx, column, &byte_offset, &byte_length, NULL);
+  if (JS_IsException (buf))
+  {
+    JS_FreeValue (ctx, column);
+    return JS_EXCEPTION;
+  }
+
+  buf_data = JS_GetArrayBuffer (ctx, &buf_size, buf);
+  JS_FreeValue (ctx, buf);
+  if (buf_data == NULL)
+  {
+    JS_FreeValue (ctx, column);
+    return JS_EXCEPTION;
+  }
+
+  *data = buf_data + byte_offset;
+
+  return column;
+}
+
 static void
 gum_quick_transformer_transform_block (GumStalkerTransformer * transformer,
                                        GumStalkerIterator * iterator,
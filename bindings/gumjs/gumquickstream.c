@@ -32,6 +32,8 @@ typedef struct _GumQuickCloseInputOperation GumQuickCloseInputOperation;
 typedef struct _GumQuickReadOperation GumQuickReadOperation;
 typedef guint GumQuickReadStrategy;
 
+typedef struct _GumQuickPumpOperation GumQuickPumpOperation;
+
 typedef struct _GumQuickCloseOutputOperation GumQuickCloseOutputOperation;
 typedef struct _GumQuickWriteOperation GumQuickWriteOperation;
 typedef guint GumQuickWriteStrategy;
@@ -60,6 +62,12 @@ enum _GumQuickReadStrategy
   GUM_QUICK_READ_ALL
 };
 
+struct _GumQuickPumpOperation
+{
+  GumQuickObjectOperation operation;
+  GOutputStream * output;
+};
+
 struct _GumQuickCloseOutputOperation
 {
   GumQuickObjectOperation operation;
@@ -102,7 +110,14 @@ static void gum_quick_read_operation_dispose (GumQuickReadOperation * self);
 static void gum_quick_read_operation_start (GumQuickReadOperation * self);
 static void gum_quick_read_operation_finish (GInputStream * stream,
     GAsyncResult * result, GumQuickReadOperation * self);
-
+GUMJS_DECLARE_FUNCTION (gumjs_input_stream_pump)
+static void gum_quick_pump_operation_dispose (GumQuickPumpOperation * self);
+static void gum_quick_pump_operation_start (GumQuickPumpOperation * self);
+static void gum_quick_pump_operation_finish (GOutputStream * stream,
+    GAsyncResult * result, GumQuickPumpOperation * self);
+
+static gboolean gum_quick_output_stream_get (JSContext * ctx,
+    JSValueConst val, GumQuickCore * core, GumQuickObject ** object);
 GUMJS_DECLARE_CONSTRUCTOR (gumjs_output_stream_construct)
 GUMJS_DECLARE_FUNCTION (gumjs_output_stream_close)
 static void gum_quick_close_output_operation_start (
@@ -149,6 +164,7 @@ static const JSCFunctionListEntry gumjs_input_stream_entries[] =
   JS_CFUNC_DEF ("_close", 0, gumjs_input_stream_close),
   JS_CFUNC_DEF ("_read", 0, gumjs_input_stream_read),
   JS_CFUNC_DEF ("_readAll", 0, gumjs_input_stream_read_all),
+  JS_CFUNC_DEF ("_pump", 0, gumjs_input_stream_pump),
 };
 
 static const JSClassDef gumjs_output_stream_def =
@@ -655,6 +671,83 @@ gum_quick_read_operation_finish (GInputStream * stream,
   _gum_quick_object_operation_finish (op);
 }
 
+/*
+ * Connects this input stream to an output stream and moves the data
+ * entirely on the GIO side, with the stream's own flow control providing
+ * backpressure. Only the completion and total byte count reach JS, so
+ * bulk transfers avoid one JS round-trip per chunk.
+ */
+GUMJS_DEFINE_FUNCTION (gumjs_input_stream_pump)
+{
+  GumQuickObject * self;
+  JSValue target, callback;
+  GumQuickObject * output;
+  GumQuickPumpOperation * op;
+
+  if (!gum_quick_input_stream_get (ctx, this_val, core, &self))
+    return JS_EXCEPTION;
+
+  if (!_gum_quick_args_parse (args, "OF", &target, &callback))
+    return JS_EXCEPTION;
+
+  if (!gum_quick_output_stream_get (ctx, target, core, &output))
+    return JS_EXCEPTION;
+
+  op = _gum_quick_object_operation_new (GumQuickPumpOperation, self, callback,
+      gum_quick_pump_operation_start, gum_quick_pump_operation_dispose);
+  op->output = g_object_ref (output->handle);
+  _gum_quick_object_operation_schedule (op);
+
+  return JS_UNDEFINED;
+}
+
+static void
+gum_quick_pump_operation_dispose (GumQuickPumpOperation * self)
+{
+  g_object_unref (self->output);
+}
+
+static void
+gum_quick_pump_operation_start (GumQuickPumpOperation * self)
+{
+  GumQuickObjectOperation * op = GUM_QUICK_OBJECT_OPERATION (self);
+  GumQuickObject * stream = op->object;
+
+  g_output_stream_splice_async (self->output, stream->handle,
+      G_OUTPUT_STREAM_SPLICE_NONE, G_PRIORITY_DEFAULT, stream->cancellable,
+      (GAsyncReadyCallback) gum_quick_pump_operation_finish, self);
+}
+
+static void
+gum_quick_pump_operation_finish (GOutputStream * stream,
+                                 GAsyncResult * result,
+                                 GumQuickPumpOperation * self)
+{
+  GumQuickObjectOperation * op = GUM_QUICK_OBJECT_OPERATION (self);
+  GumQuickCore * core = op->core;
+  JSContext * ctx = core->ctx;
+  gssize n;
+  GError * error = NULL;
+  GumQuickScope scope;
+  JSValue argv[2];
+
+  n = g_output_stream_splice_finish (stream, result, &error);
+
+  _gum_quick_scope_enter (&scope, core);
+
+  argv[0] = _gum_quick_error_new_take_error (ctx, &error, core);
+  argv[1] = JS_NewInt64 (ctx, MAX (n, 0));
+
+  _gum_quick_scope_call_void (&scope, op->callback, JS_UNDEFINED,
+      G_N_ELEMENTS (argv), argv);
+
+  JS_FreeValue (ctx, argv[0]);
+
+  _gum_quick_scope_leave (&scope);
+
+  _gum_quick_object_operation_finish (op);
+}
+
 static gboolean
 gum_quick_output_stream_get (JSContext * ctx,
                             JSValueConst val,
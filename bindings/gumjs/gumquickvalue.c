@@ -1145,14 +1145,34 @@ expected_number:
   }
 }
 
+/*
+ * Boxing is the top allocation category in heap profiles of busy agents, and
+ * the same pointers (module bases, hooked-function addresses) keep crossing
+ * into script over and over. A small direct-mapped cache hands out the same
+ * wrapper for a recurring value; this is safe as NativePointer is a value
+ * object whose payload never changes after construction. Pointers created
+ * with `new NativePointer()` are not interned, so such instances keep their
+ * own identity.
+ */
+
 JSValue
 _gum_quick_native_pointer_new (JSContext * ctx,
                                gpointer ptr,
                                GumQuickCore * core)
 {
+  gsize bits;
+  guint slot;
   JSValue wrapper;
   GumQuickNativePointer * np;
 
+  bits = GPOINTER_TO_SIZE (ptr);
+  slot = (guint) ((bits ^ (bits >> 9)) &
+      (GUM_QUICK_INTERNED_POINTER_CAPACITY - 1));
+
+  wrapper = core->interned_pointer_wrappers[slot];
+  if (!JS_IsUndefined (wrapper) && core->interned_pointer_values[slot] == ptr)
+    return JS_DupValue (ctx, wrapper);
+
   wrapper = JS_NewObjectClass (ctx, core->native_pointer_class);
 
   np = g_slice_new (GumQuickNativePointer);
@@ -1160,6 +1180,10 @@ _gum_quick_native_pointer_new (JSContext * ctx,
 
   JS_SetOpaque (wrapper, np);
 
+  JS_FreeValue (ctx, core->interned_pointer_wrappers[slot]);
+  core->interned_pointer_values[slot] = ptr;
+  core->interned_pointer_wrappers[slot] = JS_DupValue (ctx, wrapper);
+
   return wrapper;
 }
 
@@ -0,0 +1,373 @@
+/*
+ * Copyright (C) 2021 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#include "gumringfile.h"
+
+#include <gio/gio.h>
+#include <string.h>
+#ifdef HAVE_WINDOWS
+# include <windows.h>
+#else
+# include <errno.h>
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+#define GUM_RING_FILE_MAGIC   0x47524e47
+#define GUM_RING_FILE_VERSION 1
+
+typedef struct _GumRingFileHeader GumRingFileHeader;
+
+/*
+ * On-disk layout: this header followed by `capacity` bytes of ring data.
+ * `position` is the total number of bytes ever appended; the valid window
+ * is the last MIN (position, capacity) bytes, ending at position % capacity.
+ */
+struct _GumRingFileHeader
+{
+  guint32 magic;
+  guint32 version;
+  guint64 capacity;
+  guint64 position;
+  guint8 reserved[40];
+};
+
+G_STATIC_ASSERT (sizeof (GumRingFileHeader) == 64);
+
+struct _GumRingFile
+{
+  GObject parent;
+
+  GumRingFileHeader * header;
+  guint8 * data;
+  gsize capacity;
+  gsize mapped_size;
+
+#ifdef HAVE_WINDOWS
+  HANDLE file;
+  HANDLE mapping;
+#else
+  int fd;
+#endif
+};
+
+static void gum_ring_file_finalize (GObject * object);
+
+G_DEFINE_TYPE (GumRingFile, gum_ring_file, G_TYPE_OBJECT)
+
+static void
+gum_ring_file_class_init (GumRingFileClass * klass)
+{
+  GObjectClass * object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gum_ring_file_finalize;
+}
+
+static void
+gum_ring_file_init (GumRingFile * self)
+{
+#ifdef HAVE_WINDOWS
+  self->file = INVALID_HANDLE_VALUE;
+  self->mapping = NULL;
+#else
+  self->fd = -1;
+#endif
+}
+
+static void
+gum_ring_file_finalize (GObject * object)
+{
+  GumRingFile * self = GUM_RING_FILE (object);
+
+  gum_ring_file_close (self);
+
+  G_OBJECT_CLASS (gum_ring_file_parent_class)->finalize (object);
+}
+
+/*
+ * Opens the ring at `path`, preallocating and initializing it when it does
+ * not yet exist. An existing ring is adopted as-is, keeping its contents and
+ * stored capacity; `capacity` is only used when creating.
+ */
+GumRingFile *
+gum_ring_file_open (const gchar * path,
+                    gsize capacity,
+                    GError ** error)
+{
+  GumRingFile * file;
+  GumRingFileHeader * header;
+  guint64 file_size;
+  gboolean fresh;
+  gsize mapped_size;
+#ifdef HAVE_WINDOWS
+  gunichar2 * path_utf16;
+  HANDLE handle, mapping;
+  LARGE_INTEGER size;
+  gpointer base;
+#else
+  int fd;
+  struct stat st;
+  gpointer base;
+#endif
+
+  if (capacity == 0)
+    goto invalid_capacity;
+
+#ifdef HAVE_WINDOWS
+  path_utf16 = g_utf8_to_utf16 (path, -1, NULL, NULL, NULL);
+  handle = CreateFileW ((LPCWSTR) path_utf16, GENERIC_READ | GENERIC_WRITE,
+      FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  g_free (path_utf16);
+  if (handle == INVALID_HANDLE_VALUE)
+    goto open_failed;
+
+  if (!GetFileSizeEx (handle, &size))
+  {
+    CloseHandle (handle);
+    goto open_failed;
+  }
+  file_size = size.QuadPart;
+#else
+  fd = open (path, O_RDWR | O_CREAT, 0644);
+  if (fd == -1)
+    goto open_failed;
+
+  if (fstat (fd, &st) != 0)
+  {
+    close (fd);
+    goto open_failed;
+  }
+  file_size = st.st_size;
+#endif
+
+  fresh = file_size == 0;
+
+  if (fresh)
+  {
+    mapped_size = sizeof (GumRingFileHeader) + capacity;
+  }
+  else if (file_size > sizeof (GumRingFileHeader))
+  {
+    mapped_size = file_size;
+  }
+  else
+  {
+    goto invalid_file;
+  }
+
+#ifdef HAVE_WINDOWS
+  if (fresh)
+  {
+    size.QuadPart = mapped_size;
+    if (!SetFilePointerEx (handle, size, NULL, FILE_BEGIN) ||
+        !SetEndOfFile (handle))
+    {
+      goto preallocate_failed;
+    }
+  }
+
+  mapping = CreateFileMappingW (handle, NULL, PAGE_READWRITE, 0, 0, NULL);
+  if (mapping == NULL)
+    goto map_failed;
+
+  base = MapViewOfFile (mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0,
+      mapped_size);
+  if (base == NULL)
+  {
+    CloseHandle (mapping);
+    goto map_failed;
+  }
+#else
+  if (fresh && ftruncate (fd, mapped_size) != 0)
+    goto preallocate_failed;
+
+  base = mmap (NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (base == MAP_FAILED)
+    goto map_failed;
+#endif
+
+  header = base;
+
+  if (fresh)
+  {
+    header->magic = GUM_RING_FILE_MAGIC;
+    header->version = GUM_RING_FILE_VERSION;
+    header->capacity = capacity;
+    header->position = 0;
+    memset (header->reserved, 0, sizeof (header->reserved));
+  }
+  else if (header->magic != GUM_RING_FILE_MAGIC ||
+      header->version != GUM_RING_FILE_VERSION ||
+      header->capacity != mapped_size - sizeof (GumRingFileHeader))
+  {
+    goto invalid_ring;
+  }
+
+  file = g_object_new (GUM_TYPE_RING_FILE, NULL);
+  file->header = header;
+  file->data = (guint8 *) base + sizeof (GumRingFileHeader);
+  file->capacity = header->capacity;
+  file->mapped_size = mapped_size;
+#ifdef HAVE_WINDOWS
+  file->file = handle;
+  file->mapping = mapping;
+#else
+  file->fd = fd;
+#endif
+
+  return file;
+
+invalid_capacity:
+  {
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+        "Capacity must be greater than zero");
+    return NULL;
+  }
+open_failed:
+  {
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+        "Unable to open '%s'", path);
+    return NULL;
+  }
+invalid_file:
+  {
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+        "'%s' exists but is not a ring file", path);
+#ifdef HAVE_WINDOWS
+    CloseHandle (handle);
+#else
+    close (fd);
+#endif
+    return NULL;
+  }
+preallocate_failed:
+  {
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_NO_SPACE,
+        "Unable to preallocate '%s'", path);
+#ifdef HAVE_WINDOWS
+    CloseHandle (handle);
+#else
+    close (fd);
+#endif
+    return NULL;
+  }
+map_failed:
+  {
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+        "Unable to map '%s'", path);
+#ifdef HAVE_WINDOWS
+    CloseHandle (handle);
+#else
+    close (fd);
+#endif
+    return NULL;
+  }
+invalid_ring:
+  {
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+        "'%s' exists but is not a ring file", path);
+#ifdef HAVE_WINDOWS
+    UnmapViewOfFile (base);
+    CloseHandle (mapping);
+    CloseHandle (handle);
+#else
+    munmap (base, mapped_size);
+    close (fd);
+#endif
+    return NULL;
+  }
+}
+
+/*
+ * Appends `size` bytes, wrapping around and overwriting the oldest data when
+ * full. The cursor is published only after the payload has been copied, so
+ * a consumer that trusts the cursor never observes a partially copied
+ * record; durability of both is subject to gum_ring_file_flush().
+ *
+ * Returns FALSE when the record is larger than the ring itself.
+ */
+gboolean
+gum_ring_file_write (GumRingFile * self,
+                     gconstpointer data,
+                     gsize size)
+{
+  gsize offset, head;
+
+  g_return_val_if_fail (self->header != NULL, FALSE);
+
+  if (size > self->capacity)
+    return FALSE;
+
+  if (size == 0)
+    return TRUE;
+
+  offset = (gsize) (self->header->position % self->capacity);
+  head = MIN (size, self->capacity - offset);
+
+  memcpy (self->data + offset, data, head);
+  memcpy (self->data, (const guint8 *) data + head, size - head);
+
+  self->header->position += size;
+
+  return TRUE;
+}
+
+void
+gum_ring_file_flush (GumRingFile * self)
+{
+  g_return_if_fail (self->header != NULL);
+
+#ifdef HAVE_WINDOWS
+  FlushViewOfFile (self->header, self->mapped_size);
+  FlushFileBuffers (self->file);
+#else
+  msync (self->header, self->mapped_size, MS_SYNC);
+#endif
+}
+
+void
+gum_ring_file_close (GumRingFile * self)
+{
+  if (self->header == NULL)
+    return;
+
+#ifdef HAVE_WINDOWS
+  UnmapViewOfFile (self->header);
+  CloseHandle (self->mapping);
+  CloseHandle (self->file);
+  self->mapping = NULL;
+  self->file = INVALID_HANDLE_VALUE;
+#else
+  munmap (self->header, self->mapped_size);
+  close (self->fd);
+  self->fd = -1;
+#endif
+
+  self->header = NULL;
+  self->data = NULL;
+}
+
+gboolean
+gum_ring_file_is_closed (GumRingFile * self)
+{
+  return self->header == NULL;
+}
+
+gsize
+gum_ring_file_get_capacity (GumRingFile * self)
+{
+  return self->capacity;
+}
+
+guint64
+gum_ring_file_get_position (GumRingFile * self)
+{
+  g_return_val_if_fail (self->header != NULL, 0);
+
+  return self->header->position;
+}
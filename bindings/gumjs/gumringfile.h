@@ -0,0 +1,31 @@
+/*
+ * Copyright (C) 2021 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#ifndef __GUM_RING_FILE_H__
+#define __GUM_RING_FILE_H__
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define GUM_TYPE_RING_FILE (gum_ring_file_get_type ())
+G_DECLARE_FINAL_TYPE (GumRingFile, gum_ring_file, GUM, RING_FILE, GObject)
+
+GumRingFile * gum_ring_file_open (const gchar * path, gsize capacity,
+    GError ** error);
+
+gboolean gum_ring_file_write (GumRingFile * self, gconstpointer data,
+    gsize size);
+void gum_ring_file_flush (GumRingFile * self);
+void gum_ring_file_close (GumRingFile * self);
+gboolean gum_ring_file_is_closed (GumRingFile * self);
+
+gsize gum_ring_file_get_capacity (GumRingFile * self);
+guint64 gum_ring_file_get_position (GumRingFile * self);
+
+G_END_DECLS
+
+#endif
@@ -261,6 +261,22 @@ gum_script_backend_is_locked (GumScriptBackend * self)
   return GUM_SCRIPT_BACKEND_GET_IFACE (self)->is_locked (self);
 }
 
+/*
+ * Asks the backend to keep up to `pool_size` fully bootstrapped script
+ * contexts on standby, so a subsequent create() claims one instead of
+ * paying runtime bootstrap while early process activity goes by.
+ * Backends without pooling support treat this as a no-op.
+ */
+void
+gum_script_backend_prewarm (GumScriptBackend * self,
+                            guint pool_size)
+{
+  GumScriptBackendInterface * iface = GUM_SCRIPT_BACKEND_GET_IFACE (self);
+
+  if (iface->prewarm != NULL)
+    iface->prewarm (self, pool_size);
+}
+
 GumScriptScheduler *
 gum_script_backend_get_scheduler (void)
 {
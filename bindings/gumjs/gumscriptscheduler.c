@@ -19,6 +19,8 @@ struct _GumScriptScheduler
   volatile gint start_request_seqno;
 
   GThreadPool * thread_pool;
+  GThreadPool * urgent_pool;
+  volatile gint next_job_seqno;
 };
 
 struct _GumScriptJob
@@ -27,6 +29,9 @@ struct _GumScriptJob
   gpointer data;
   GDestroyNotify data_destroy;
 
+  gint priority;
+  gint seqno;
+
   GumScriptScheduler * scheduler;
 };
 
@@ -36,6 +41,8 @@ static gboolean gum_script_scheduler_perform_js_job (
     GumScriptJob * job);
 static void gum_script_scheduler_perform_pool_job (GumScriptJob * job,
     GumScriptScheduler * self);
+static gint gum_script_job_compare (gconstpointer a, gconstpointer b,
+    gpointer user_data);
 
 static gpointer gum_script_scheduler_run_js_loop (GumScriptScheduler * self);
 
@@ -62,6 +69,20 @@ gum_script_scheduler_init (GumScriptScheduler * self)
       4,
       FALSE,
       NULL);
+  g_thread_pool_set_sort_function (self->thread_pool, gum_script_job_compare,
+      NULL);
+
+  /*
+   * Dedicated low-latency lane: urgent jobs never queue behind bulk work
+   * sitting in the main pool. Kept at a single thread so urgent jobs
+   * also cannot starve each other of ordering.
+   */
+  self->urgent_pool = g_thread_pool_new (
+      (GFunc) gum_script_scheduler_perform_pool_job,
+      self,
+      1,
+      FALSE,
+      NULL);
 }
 
 static void
@@ -73,6 +94,9 @@ gum_script_scheduler_dispose (GObject * obj)
   {
     self->disposed = TRUE;
 
+    g_thread_pool_free (self->urgent_pool, FALSE, TRUE);
+    self->urgent_pool = NULL;
+
     g_thread_pool_free (self->thread_pool, FALSE, TRUE);
     self->thread_pool = NULL;
 
@@ -176,11 +200,46 @@ gum_script_scheduler_push_job_on_thread_pool (GumScriptScheduler * self,
                                               gpointer data,
                                               GDestroyNotify data_destroy)
 {
-  g_thread_pool_push (self->thread_pool,
-      gum_script_job_new (self, func, data, data_destroy),
+  gum_script_scheduler_push_job_on_thread_pool_with_priority (self,
+      G_PRIORITY_DEFAULT, func, data, data_destroy);
+}
+
+/*
+ * Jobs at G_PRIORITY_HIGH and above go on the dedicated low-latency lane,
+ * which interceptor- and stalker-originated callbacks should use so bulk
+ * background work cannot delay them. Within the main pool, jobs are
+ * dispatched by priority, FIFO among equals.
+ */
+void
+gum_script_scheduler_push_job_on_thread_pool_with_priority (
+    GumScriptScheduler * self,
+    gint priority,
+    GumScriptJobFunc func,
+    gpointer data,
+    GDestroyNotify data_destroy)
+{
+  GumScriptJob * job;
+
+  job = gum_script_job_new (self, func, data, data_destroy);
+  job->priority = priority;
+
+  g_thread_pool_push (
+      (priority <= G_PRIORITY_HIGH) ? self->urgent_pool : self->thread_pool,
+      job,
       NULL);
 }
 
+void
+gum_script_scheduler_query_queue_depths (GumScriptScheduler * self,
+                                         guint * n_urgent,
+                                         guint * n_normal)
+{
+  if (n_urgent != NULL)
+    *n_urgent = g_thread_pool_unprocessed (self->urgent_pool);
+  if (n_normal != NULL)
+    *n_normal = g_thread_pool_unprocessed (self->thread_pool);
+}
+
 static gboolean
 gum_script_scheduler_perform_js_job (GumScriptJob * job)
 {
@@ -198,6 +257,19 @@ gum_script_scheduler_perform_pool_job (GumScriptJob * job,
   gum_script_job_free (job);
 }
 
+static gint
+gum_script_job_compare (gconstpointer a,
+                        gconstpointer b,
+                        gpointer user_data)
+{
+  const GumScriptJob * job_a = a, * job_b = b;
+
+  if (job_a->priority != job_b->priority)
+    return job_a->priority - job_b->priority;
+
+  return job_a->seqno - job_b->seqno;
+}
+
 static gpointer
 gum_script_scheduler_run_js_loop (GumScriptScheduler * self)
 {
@@ -221,6 +293,9 @@ gum_script_job_new (GumScriptScheduler * scheduler,
   job->data = data;
   job->data_destroy = data_destroy;
 
+  job->priority = G_PRIORITY_DEFAULT;
+  job->seqno = g_atomic_int_add (&scheduler->next_job_seqno, 1);
+
   job->scheduler = scheduler;
 
   return job;
@@ -37,6 +37,11 @@ GUM_API void gum_script_scheduler_push_job_on_js_thread (
 GUM_API void gum_script_scheduler_push_job_on_thread_pool (
     GumScriptScheduler * self, GumScriptJobFunc func, gpointer data,
     GDestroyNotify data_destroy);
+GUM_API void gum_script_scheduler_push_job_on_thread_pool_with_priority (
+    GumScriptScheduler * self, gint priority, GumScriptJobFunc func,
+    gpointer data, GDestroyNotify data_destroy);
+GUM_API void gum_script_scheduler_query_queue_depths (
+    GumScriptScheduler * self, guint * n_urgent, guint * n_normal);
 
 GUM_API GumScriptJob * gum_script_job_new (GumScriptScheduler * scheduler,
     GumScriptJobFunc func, gpointer data, GDestroyNotify data_destroy);
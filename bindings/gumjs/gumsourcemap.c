@@ -16,6 +16,7 @@ struct _GumSourceMap
 
   GPtrArray * sources;
   GPtrArray * names;
+  gchar * encoded_mappings;
   GArray * mappings;
 };
 
@@ -32,6 +33,7 @@ struct _GumSourceMapping
 
 static void gum_source_map_finalize (GObject * object);
 static gboolean gum_source_map_load (GumSourceMap * self, const gchar * json);
+static void gum_source_map_ensure_mappings_loaded (GumSourceMap * self);
 static gboolean gum_source_map_load_mappings (GumSourceMap * self,
     const gchar * encoded_mappings);
 
@@ -73,6 +75,7 @@ gum_source_map_finalize (GObject * object)
   GumSourceMap * self = GUM_SOURCE_MAP (object);
 
   g_array_unref (self->mappings);
+  g_free (self->encoded_mappings);
   g_ptr_array_unref (self->names);
   g_ptr_array_unref (self->sources);
 
@@ -118,8 +121,7 @@ gum_source_map_load (GumSourceMap * self,
   mappings = json_reader_get_string_value (reader);
   if (mappings == NULL)
     goto error;
-  if (!gum_source_map_load_mappings (self, mappings))
-    goto error;
+  self->encoded_mappings = g_strdup (mappings);
   json_reader_end_member (reader);
 
   g_object_unref (reader);
@@ -132,6 +134,19 @@ error:
   }
 }
 
+static void
+gum_source_map_ensure_mappings_loaded (GumSourceMap * self)
+{
+  if (self->encoded_mappings == NULL)
+    return;
+
+  if (!gum_source_map_load_mappings (self, self->encoded_mappings))
+    g_array_set_size (self->mappings, 0);
+
+  g_free (self->encoded_mappings);
+  self->encoded_mappings = NULL;
+}
+
 static gboolean
 gum_source_map_load_mappings (GumSourceMap * self,
                               const gchar * encoded_mappings)
@@ -235,6 +250,8 @@ gum_source_map_resolve (GumSourceMap * self,
   GumSourceMapping needle;
   const GumSourceMapping * mapping;
 
+  gum_source_map_ensure_mappings_loaded (self);
+
   needle.generated_line = *line;
   needle.generated_column = *column;
 
@@ -97,7 +97,7 @@ GUMJS_DEFINE_CONSTRUCTOR (gumjs_cmodule_construct)
     return;
 
   GError * error = NULL;
-  auto handle = gum_cmodule_new (source, &error);
+  auto handle = gum_cmodule_new (source, NULL, &error);
 
   g_free (source);
 
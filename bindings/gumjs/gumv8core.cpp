@@ -22,6 +22,7 @@
 #endif
 #include <string.h>
 #include <gum/gum-init.h>
+#include <gum/gumstats.h>
 
 #define GUMJS_MODULE_NAME Core
 
@@ -118,6 +119,7 @@ struct GumV8NativeFunction
   ffi_type ** atypes;
   gsize arglist_size;
   gboolean is_variadic;
+  gboolean is_direct;
   uint32_t nargs_fixed;
   ffi_abi abi;
   GSList * data;
@@ -135,6 +137,7 @@ struct GumV8NativeCallback
   ffi_closure * closure;
   ffi_cif cif;
   ffi_type ** atypes;
+  GumFFITypeKind * arg_kinds;
   GSList * data;
 
   GumV8Core * core;
@@ -168,6 +171,10 @@ static void gum_v8_scheduled_callback_free (GumV8ScheduledCallback * callback);
 static gboolean gum_v8_scheduled_callback_invoke (
     GumV8ScheduledCallback * self);
 GUMJS_DECLARE_FUNCTION (gumjs_send)
+GUMJS_DECLARE_FUNCTION (gumjs_send_flat)
+static gboolean gum_v8_json_append_value (Local<Value> value, GString * output,
+    GumV8Core * core);
+static void gum_v8_json_append_string (GString * output, const gchar * str);
 GUMJS_DECLARE_FUNCTION (gumjs_set_unhandled_exception_callback)
 GUMJS_DECLARE_FUNCTION (gumjs_set_incoming_message_callback)
 GUMJS_DECLARE_FUNCTION (gumjs_wait_for_event)
@@ -176,6 +183,7 @@ static void gumjs_global_get (Local<Name> property,
     const PropertyCallbackInfo<Value> & info);
 
 GUMJS_DECLARE_GETTER (gumjs_frida_get_heap_size)
+GUMJS_DECLARE_GETTER (gumjs_frida_get_stats)
 GUMJS_DECLARE_GETTER (gumjs_frida_get_source_map)
 GUMJS_DECLARE_GETTER (gumjs_frida_objc_get_source_map)
 GUMJS_DECLARE_GETTER (gumjs_frida_java_get_source_map)
@@ -327,6 +335,9 @@ static gboolean gum_v8_ffi_abi_get (GumV8Core * core, Local<Value> name,
     ffi_abi * abi);
 static gboolean gum_v8_value_to_ffi_type (GumV8Core * core,
     const Local<Value> svalue, GumFFIValue * value, const ffi_type * type);
+static gboolean gum_v8_value_from_ffi_kind (GumV8Core * core,
+    Local<Value> * svalue, const GumFFIValue * value, GumFFITypeKind kind,
+    const ffi_type * type);
 static gboolean gum_v8_value_from_ffi_type (GumV8Core * core,
     Local<Value> * svalue, const GumFFIValue * value, const ffi_type * type);
 
@@ -337,6 +348,7 @@ static const GumV8Function gumjs_global_functions[] =
   { "clearTimeout", gumjs_clear_timer },
   { "clearInterval", gumjs_clear_timer },
   { "_send", gumjs_send },
+  { "_sendFlat", gumjs_send_flat },
   { "_setUnhandledExceptionCallback", gumjs_set_unhandled_exception_callback },
   { "_setIncomingMessageCallback", gumjs_set_incoming_message_callback },
   { "_waitForEvent", gumjs_wait_for_event },
@@ -347,6 +359,7 @@ static const GumV8Function gumjs_global_functions[] =
 static const GumV8Property gumjs_frida_values[] =
 {
   { "heapSize", gumjs_frida_get_heap_size, NULL },
+  { "stats", gumjs_frida_get_stats, NULL },
   { "sourceMap", gumjs_frida_get_source_map, NULL },
   { "_objcSourceMap", gumjs_frida_objc_get_source_map, NULL },
   { "_javaSourceMap", gumjs_frida_java_get_source_map, NULL },
@@ -938,6 +951,12 @@ _gum_v8_core_dispose (GumV8Core * self)
   self->handle_key = nullptr;
   self->native_pointer_value = nullptr;
 
+  for (guint i = 0; i != GUM_V8_INTERNED_POINTER_CAPACITY; i++)
+  {
+    delete self->interned_pointer_wrappers[i];
+    self->interned_pointer_wrappers[i] = nullptr;
+  }
+
   delete self->abi_key;
   delete self->scheduling_key;
   delete self->exceptions_key;
@@ -1216,6 +1235,258 @@ GUMJS_DEFINE_FUNCTION (gumjs_send)
   g_free (message);
 }
 
+/*
+ * Fast path for send() with a flat payload: the message envelope is
+ * serialized natively into a single buffer, so no intermediate message
+ * object, JSON.stringify() pass, or resulting JS string is created.
+ * Returns false when the payload is not flat, in which case the runtime
+ * falls back to the regular path; for the subset handled here the output
+ * is identical to what that fallback would have produced.
+ */
+GUMJS_DEFINE_FUNCTION (gumjs_send_flat)
+{
+  Local<Value> payload;
+  GBytes * data;
+  if (!_gum_v8_args_parse (args, "VB?", &payload, &data))
+    return;
+
+  auto context = isolate->GetCurrentContext ();
+
+  auto message = g_string_sized_new (128);
+  g_string_append (message, "{\"type\":\"send\",\"payload\":");
+
+  gboolean serializable;
+  if (gum_v8_json_append_value (payload, message, core))
+  {
+    serializable = TRUE;
+  }
+  else if (payload->IsObject () && !payload->IsArray () &&
+      !payload->IsFunction ())
+  {
+    auto object = payload.As<Object> ();
+
+    Local<Value> to_json;
+    if (!object->Get (context, _gum_v8_string_new_ascii (isolate, "toJSON"))
+        .ToLocal (&to_json))
+    {
+      g_bytes_unref (data);
+      g_string_free (message, TRUE);
+      return;
+    }
+    serializable = to_json->IsUndefined ();
+
+    if (serializable)
+    {
+      Local<Array> names;
+      if (!object->GetOwnPropertyNames (context).ToLocal (&names))
+      {
+        g_bytes_unref (data);
+        g_string_free (message, TRUE);
+        return;
+      }
+
+      g_string_append_c (message, '{');
+
+      gboolean first = TRUE;
+      uint32_t n = names->Length ();
+      for (uint32_t i = 0; i != n && serializable; i++)
+      {
+        Local<Value> name, value;
+        if (!names->Get (context, i).ToLocal (&name) ||
+            !object->Get (context, name).ToLocal (&value))
+        {
+          g_bytes_unref (data);
+          g_string_free (message, TRUE);
+          return;
+        }
+
+        if (!name->IsString ())
+        {
+          serializable = FALSE;
+          break;
+        }
+
+        if (value->IsUndefined () || value->IsFunction () ||
+            value->IsSymbol ())
+        {
+          continue;
+        }
+
+        if (!first)
+          g_string_append_c (message, ',');
+        first = FALSE;
+
+        String::Utf8Value key (isolate, name);
+        gum_v8_json_append_string (message, *key);
+        g_string_append_c (message, ':');
+
+        serializable = gum_v8_json_append_value (value, message, core);
+      }
+
+      g_string_append_c (message, '}');
+    }
+  }
+  else
+  {
+    serializable = FALSE;
+  }
+
+  if (serializable)
+  {
+    g_string_append_c (message, '}');
+
+    /*
+     * Synchronized for the same reason as gumjs_send(): the application might
+     * be waiting for an acknowledgement that APIs have been instrumented.
+     */
+    auto interceptor = core->script->interceptor.interceptor;
+    gum_interceptor_end_transaction (interceptor);
+    gum_interceptor_begin_transaction (interceptor);
+
+    core->message_emitter (core->script, message->str, data);
+  }
+
+  info.GetReturnValue ().Set ((bool) serializable);
+
+  g_bytes_unref (data);
+  g_string_free (message, TRUE);
+}
+
+static gboolean
+gum_v8_json_append_value (Local<Value> value,
+                          GString * output,
+                          GumV8Core * core)
+{
+  auto isolate = core->isolate;
+
+  if (value->IsString ())
+  {
+    String::Utf8Value str (isolate, value);
+    if (*str == NULL)
+      return FALSE;
+
+    gum_v8_json_append_string (output, *str);
+
+    return TRUE;
+  }
+
+  if (value->IsNull ())
+  {
+    g_string_append (output, "null");
+    return TRUE;
+  }
+
+  if (value->IsBoolean ())
+  {
+    g_string_append (output,
+        value->BooleanValue (isolate) ? "true" : "false");
+    return TRUE;
+  }
+
+  if (value->IsInt32 ())
+  {
+    g_string_append_printf (output, "%" G_GINT32_FORMAT,
+        value.As<Int32> ()->Value ());
+    return TRUE;
+  }
+
+  if (value->IsNumber ())
+  {
+    gdouble d = value.As<Number> ()->Value ();
+    if (d != d)
+      return FALSE;
+
+    gint64 i = (gint64) d;
+    if ((gdouble) i != d ||
+        i <= -G_GINT64_CONSTANT (9007199254740992) ||
+        i >= G_GINT64_CONSTANT (9007199254740992))
+    {
+      return FALSE;
+    }
+
+    g_string_append_printf (output, "%" G_GINT64_FORMAT, i);
+
+    return TRUE;
+  }
+
+  if (value->IsObject ())
+  {
+    auto native_pointer = Local<FunctionTemplate>::New (isolate,
+        *core->native_pointer);
+    if (native_pointer->HasInstance (value))
+    {
+      g_string_append_printf (output, "\"0x%" G_GSIZE_MODIFIER "x\"",
+          GPOINTER_TO_SIZE (GUMJS_NATIVE_POINTER_VALUE (value.As<Object> ())));
+      return TRUE;
+    }
+
+    auto int64 = Local<FunctionTemplate>::New (isolate, *core->int64);
+    if (int64->HasInstance (value))
+    {
+      g_string_append_printf (output, "\"%" G_GINT64_FORMAT "\"",
+          _gum_v8_int64_get_value (value.As<Object> ()));
+      return TRUE;
+    }
+
+    auto uint64 = Local<FunctionTemplate>::New (isolate, *core->uint64);
+    if (uint64->HasInstance (value))
+    {
+      g_string_append_printf (output, "\"%" G_GUINT64_FORMAT "\"",
+          _gum_v8_uint64_get_value (value.As<Object> ()));
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+static void
+gum_v8_json_append_string (GString * output,
+                           const gchar * str)
+{
+  const gchar * p;
+
+  g_string_append_c (output, '"');
+
+  for (p = str; *p != '\0'; p++)
+  {
+    gchar c = *p;
+
+    switch (c)
+    {
+      case '"':
+        g_string_append (output, "\\\"");
+        break;
+      case '\\':
+        g_string_append (output, "\\\\");
+        break;
+      case '\b':
+        g_string_append (output, "\\b");
+        break;
+      case '\f':
+        g_string_append (output, "\\f");
+        break;
+      case '\n':
+        g_string_append (output, "\\n");
+        break;
+      case '\r':
+        g_string_append (output, "\\r");
+        break;
+      case '\t':
+        g_string_append (output, "\\t");
+        break;
+      default:
+        if ((guchar) c < 0x20)
+          g_string_append_printf (output, "\\u%04x", (guint) (guchar) c);
+        else
+          g_string_append_c (output, c);
+        break;
+    }
+  }
+
+  g_string_append_c (output, '"');
+}
+
 GUMJS_DEFINE_FUNCTION (gumjs_set_unhandled_exception_callback)
 {
   Local<Function> callback;
@@ -1316,6 +1587,24 @@ GUMJS_DEFINE_GETTER (gumjs_frida_get_heap_size)
   info.GetReturnValue ().Set (gum_peek_private_memory_usage ());
 }
 
+GUMJS_DEFINE_GETTER (gumjs_frida_get_stats)
+{
+  auto context = isolate->GetCurrentContext ();
+
+  auto stats = Object::New (isolate);
+
+  for (guint id = 0; id != GUM_STAT_COUNT; id++)
+  {
+    stats->Set (context,
+        _gum_v8_string_new_ascii (isolate,
+            gum_stats_get_name ((GumStatId) id)),
+        Number::New (isolate, (double) gum_stats_get ((GumStatId) id)))
+        .Check ();
+  }
+
+  info.GetReturnValue ().Set (stats);
+}
+
 GUMJS_DEFINE_GETTER (gumjs_frida_get_source_map)
 {
   Local<Object> map;
@@ -2390,6 +2679,8 @@ gumjs_native_function_init (Local<Object> wrapper,
   }
 
   func->is_variadic = nargs_fixed < nargs_total;
+  func->is_direct = !func->is_variadic &&
+      gum_ffi_cif_is_direct_callable (&func->cif);
   func->nargs_fixed = nargs_fixed;
   func->abi = abi;
 
@@ -2576,7 +2867,10 @@ gum_v8_native_function_invoke (GumV8NativeFunction * self,
         gum_stalker_activate (stalker, GUM_FUNCPTR_TO_POINTER (implementation));
       }
 
-      ffi_call (cif, FFI_FN (implementation), rvalue, avalue);
+      if (self->is_direct)
+        gum_ffi_call_direct (implementation, cif, rvalue, avalue);
+      else
+        ffi_call (cif, FFI_FN (implementation), rvalue, avalue);
 
       g_clear_pointer (&stalker, gum_stalker_deactivate);
 
@@ -2857,6 +3151,15 @@ GUMJS_DEFINE_CONSTRUCTOR (gumjs_native_callback_construct)
       goto error;
   }
 
+  /*
+   * The argument types are declared up front, so precompute the
+   * marshalling plan here instead of re-classifying each type on every
+   * invocation.
+   */
+  callback->arg_kinds = g_new (GumFFITypeKind, nargs);
+  for (i = 0; i != nargs; i++)
+    callback->arg_kinds[i] = gum_ffi_classify_type (callback->atypes[i]);
+
   abi = FFI_DEFAULT_ABI;
   if (!abi_value.IsEmpty ())
   {
@@ -2934,6 +3237,7 @@ gum_v8_native_callback_unref (GumV8NativeCallback * callback)
     g_free (head->data);
     callback->data = g_slist_delete_link (callback->data, head);
   }
+  g_free (callback->arg_kinds);
   g_free (callback->atypes);
 
   g_slice_free (GumV8NativeCallback, callback);
@@ -2977,8 +3281,8 @@ gum_v8_native_callback_invoke (ffi_cif * cif,
   for (guint i = 0; i != cif->nargs; i++)
   {
     new (&argv[i]) Local<Value> ();
-    if (!gum_v8_value_from_ffi_type (self->core, &argv[i],
-        (GumFFIValue *) args[i], cif->arg_types[i]))
+    if (!gum_v8_value_from_ffi_kind (self->core, &argv[i],
+        (GumFFIValue *) args[i], self->arg_kinds[i], cif->arg_types[i]))
     {
       for (guint j = 0; j <= i; j++)
         argv[j].~Local<Value> ();
@@ -3047,6 +3351,12 @@ gumjs_cpu_context_get_register (Local<Name> property,
       (gpointer *) wrapper->GetInternalField (0).As<External> ()->Value ();
   gsize offset = info.Data ().As<Integer> ()->Value ();
 
+  if (cpu_context == NULL)
+  {
+    _gum_v8_throw_ascii_literal (info.GetIsolate (), "invalid operation");
+    return;
+  }
+
   info.GetReturnValue ().Set (
       _gum_v8_native_pointer_new (cpu_context[offset], core));
 }
@@ -3064,7 +3374,7 @@ gumjs_cpu_context_set_register (Local<Name> property,
   bool is_mutable = wrapper->GetInternalField (1).As<Boolean> ()->Value ();
   gsize offset = info.Data ().As<Integer> ()->Value ();
 
-  if (!is_mutable)
+  if (cpu_context == NULL || !is_mutable)
   {
     _gum_v8_throw_ascii_literal (isolate, "invalid operation");
     return;
@@ -3695,3 +4005,73 @@ gum_v8_value_from_ffi_type (GumV8Core * core,
 
   return TRUE;
 }
+
+static gboolean
+gum_v8_value_from_ffi_kind (GumV8Core * core,
+                            Local<Value> * svalue,
+                            const GumFFIValue * value,
+                            GumFFITypeKind kind,
+                            const ffi_type * type)
+{
+  auto isolate = core->isolate;
+
+  switch (kind)
+  {
+    case GUM_FFI_KIND_VOID:
+      *svalue = Undefined (isolate);
+      break;
+    case GUM_FFI_KIND_POINTER:
+      *svalue = _gum_v8_native_pointer_new (value->v_pointer, core);
+      break;
+    case GUM_FFI_KIND_SINT8:
+      *svalue = Integer::New (isolate, value->v_sint8);
+      break;
+    case GUM_FFI_KIND_UINT8:
+      *svalue = Integer::NewFromUnsigned (isolate, value->v_uint8);
+      break;
+    case GUM_FFI_KIND_SINT16:
+      *svalue = Integer::New (isolate, value->v_sint16);
+      break;
+    case GUM_FFI_KIND_UINT16:
+      *svalue = Integer::NewFromUnsigned (isolate, value->v_uint16);
+      break;
+    case GUM_FFI_KIND_SINT32:
+      *svalue = Integer::New (isolate, value->v_sint32);
+      break;
+    case GUM_FFI_KIND_UINT32:
+      *svalue = Integer::NewFromUnsigned (isolate, value->v_uint32);
+      break;
+    case GUM_FFI_KIND_SINT64:
+      *svalue = _gum_v8_int64_new (value->v_sint64, core);
+      break;
+    case GUM_FFI_KIND_UINT64:
+      *svalue = _gum_v8_uint64_new (value->v_uint64, core);
+      break;
+    case GUM_FFI_KIND_SIZE:
+#if GLIB_SIZEOF_SIZE_T == 8
+      *svalue = _gum_v8_uint64_new (value->v_uint64, core);
+#else
+      *svalue = _gum_v8_uint64_new (value->v_uint32, core);
+#endif
+      break;
+    case GUM_FFI_KIND_SSIZE:
+#if GLIB_SIZEOF_SIZE_T == 8
+      *svalue = _gum_v8_int64_new (value->v_sint64, core);
+#else
+      *svalue = _gum_v8_int64_new (value->v_sint32, core);
+#endif
+      break;
+    case GUM_FFI_KIND_FLOAT:
+      *svalue = Number::New (isolate, value->v_float);
+      break;
+    case GUM_FFI_KIND_DOUBLE:
+      *svalue = Number::New (isolate, value->v_double);
+      break;
+    case GUM_FFI_KIND_STRUCT:
+      return gum_v8_value_from_ffi_type (core, svalue, value, type);
+    default:
+      g_assert_not_reached ();
+  }
+
+  return TRUE;
+}
@@ -22,6 +22,8 @@
 #define GUMJS_CPU_CONTEXT_VALUE(o) \
     ((GumCpuContext *) (o)->GetInternalField (0).As<External> ()->Value ())
 
+#define GUM_V8_INTERNED_POINTER_CAPACITY 64
+
 #ifdef HAVE_WINDOWS
 # define GUMJS_SYSTEM_ERROR_FIELD "lastError"
 #else
@@ -96,6 +98,9 @@ struct GumV8Core
   GumPersistent<v8::FunctionTemplate>::type * native_pointer;
   GumPersistent<v8::Object>::type * native_pointer_value;
   GumPersistent<v8::String>::type * handle_key;
+  gpointer interned_pointer_values[GUM_V8_INTERNED_POINTER_CAPACITY];
+  GumPersistent<v8::Object>::type * interned_pointer_wrappers[
+      GUM_V8_INTERNED_POINTER_CAPACITY];
 
   GumPersistent<v8::FunctionTemplate>::type * native_function;
   GumPersistent<v8::String>::type * abi_key;
@@ -6,6 +6,8 @@
 
 #include "gumv8file.h"
 
+#include "gumiouring.h"
+#include "gumringfile.h"
 #include "gumv8macros.h"
 
 #include <errno.h>
@@ -19,10 +21,19 @@ struct GumFile
 {
   GumPersistent<Object>::type * wrapper;
   FILE * handle;
+  GumIOUring * uring;
+  GumV8File * module;
+};
+
+struct GumRingFileInstance
+{
+  GumPersistent<Object>::type * wrapper;
+  GumRingFile * handle;
   GumV8File * module;
 };
 
 GUMJS_DECLARE_CONSTRUCTOR (gumjs_file_construct)
+GUMJS_DECLARE_FUNCTION (gumjs_file_read_into)
 GUMJS_DECLARE_FUNCTION (gumjs_file_write)
 GUMJS_DECLARE_FUNCTION (gumjs_file_flush)
 GUMJS_DECLARE_FUNCTION (gumjs_file_close)
@@ -34,8 +45,24 @@ static gboolean gum_file_check_open (GumFile * self, Isolate * isolate);
 static void gum_file_close (GumFile * self);
 static void gum_file_on_weak_notify (const WeakCallbackInfo<GumFile> & info);
 
+GUMJS_DECLARE_CONSTRUCTOR (gumjs_ring_file_construct)
+GUMJS_DECLARE_GETTER (gumjs_ring_file_get_capacity)
+GUMJS_DECLARE_GETTER (gumjs_ring_file_get_position)
+GUMJS_DECLARE_FUNCTION (gumjs_ring_file_write)
+GUMJS_DECLARE_FUNCTION (gumjs_ring_file_flush)
+GUMJS_DECLARE_FUNCTION (gumjs_ring_file_close)
+
+static GumRingFileInstance * gum_ring_file_instance_new (Local<Object> wrapper,
+    GumRingFile * handle, GumV8File * module);
+static void gum_ring_file_instance_free (GumRingFileInstance * instance);
+static gboolean gum_ring_file_instance_check_open (
+    GumRingFileInstance * self, Isolate * isolate);
+static void gum_ring_file_instance_on_weak_notify (
+    const WeakCallbackInfo<GumRingFileInstance> & info);
+
 static const GumV8Function gumjs_file_functions[] =
 {
+  { "readInto", gumjs_file_read_into },
   { "write", gumjs_file_write },
   { "flush", gumjs_file_flush },
   { "close", gumjs_file_close },
@@ -43,6 +70,23 @@ static const GumV8Function gumjs_file_functions[] =
   { NULL, NULL }
 };
 
+static const GumV8Property gumjs_ring_file_values[] =
+{
+  { "capacity", gumjs_ring_file_get_capacity, NULL },
+  { "position", gumjs_ring_file_get_position, NULL },
+
+  { NULL, NULL, NULL }
+};
+
+static const GumV8Function gumjs_ring_file_functions[] =
+{
+  { "write", gumjs_ring_file_write },
+  { "flush", gumjs_ring_file_flush },
+  { "close", gumjs_ring_file_close },
+
+  { NULL, NULL }
+};
+
 void
 _gum_v8_file_init (GumV8File * self,
                    GumV8Core * core,
@@ -57,6 +101,11 @@ _gum_v8_file_init (GumV8File * self,
   auto file = _gum_v8_create_class ("File", gumjs_file_construct, scope,
       module, isolate);
   _gum_v8_class_add (file, gumjs_file_functions, module, isolate);
+
+  auto ring_file = _gum_v8_create_class ("RingFile", gumjs_ring_file_construct,
+      scope, module, isolate);
+  _gum_v8_class_add (ring_file, gumjs_ring_file_values, module, isolate);
+  _gum_v8_class_add (ring_file, gumjs_ring_file_functions, module, isolate);
 }
 
 void
@@ -64,11 +113,16 @@ _gum_v8_file_realize (GumV8File * self)
 {
   self->files = g_hash_table_new_full (NULL, NULL, NULL,
       (GDestroyNotify) gum_file_free);
+  self->ring_files = g_hash_table_new_full (NULL, NULL, NULL,
+      (GDestroyNotify) gum_ring_file_instance_free);
 }
 
 void
 _gum_v8_file_dispose (GumV8File * self)
 {
+  g_hash_table_unref (self->ring_files);
+  self->ring_files = NULL;
+
   g_hash_table_unref (self->files);
   self->files = NULL;
 }
@@ -93,6 +147,9 @@ GUMJS_DEFINE_CONSTRUCTOR (gumjs_file_construct)
 
   auto handle = fopen (filename, mode);
 
+  gboolean write_only = strchr (mode, '+') == NULL &&
+      (mode[0] == 'w' || mode[0] == 'a');
+
   g_free (filename);
   g_free (mode);
 
@@ -103,9 +160,64 @@ GUMJS_DEFINE_CONSTRUCTOR (gumjs_file_construct)
   }
 
   auto file = gum_file_new (wrapper, handle, module);
+
+  /*
+   * Write-only streams get an io_uring engine where the kernel provides
+   * one, turning a steady stream of writes into batched submissions with
+   * no stdio buffering in between; everything else, including files that
+   * may be read back through the same handle, stays on stdio.
+   */
+  if (write_only)
+  {
+    file->uring = gum_io_uring_open (fileno (handle));
+    if (file->uring != NULL)
+      setvbuf (handle, NULL, _IONBF, 0);
+  }
+
   wrapper->SetAlignedPointerInInternalField (0, file);
 }
 
+/*
+ * Reads directly into the caller-provided ArrayBuffer or typed array, so
+ * bulk transfers avoid an intermediate copy; pair with ArrayBuffer.wrap()
+ * to stream straight into target memory. Returns the number of bytes read.
+ */
+GUMJS_DEFINE_CLASS_METHOD (gumjs_file_read_into, GumFile)
+{
+  if (!gum_file_check_open (self, isolate))
+    return;
+
+  Local<Value> buffer_val;
+  if (!_gum_v8_args_parse (args, "V", &buffer_val))
+    return;
+
+  gpointer data;
+  gsize size;
+  if (buffer_val->IsArrayBuffer ())
+  {
+    auto store = buffer_val.As<ArrayBuffer> ()->GetBackingStore ();
+    data = store->Data ();
+    size = store->ByteLength ();
+  }
+  else if (buffer_val->IsArrayBufferView ())
+  {
+    auto view = buffer_val.As<ArrayBufferView> ();
+    auto store = view->Buffer ()->GetBackingStore ();
+    data = (guint8 *) store->Data () + view->ByteOffset ();
+    size = view->ByteLength ();
+  }
+  else
+  {
+    _gum_v8_throw_ascii_literal (isolate,
+        "expected an ArrayBuffer or typed array");
+    return;
+  }
+
+  auto n = fread (data, 1, size, self->handle);
+
+  info.GetReturnValue ().Set ((uint32_t) n);
+}
+
 GUMJS_DEFINE_CLASS_METHOD (gumjs_file_write, GumFile)
 {
   if (!gum_file_check_open (self, isolate))
@@ -117,7 +229,10 @@ GUMJS_DEFINE_CLASS_METHOD (gumjs_file_write, GumFile)
 
   gsize size;
   auto data = g_bytes_get_data (bytes, &size);
-  fwrite (data, size, 1, self->handle);
+  if (self->uring != NULL)
+    gum_io_uring_write (self->uring, data, size);
+  else
+    fwrite (data, size, 1, self->handle);
 
   g_bytes_unref (bytes);
 }
@@ -127,6 +242,8 @@ GUMJS_DEFINE_CLASS_METHOD (gumjs_file_flush, GumFile)
   if (!gum_file_check_open (self, isolate))
     return;
 
+  if (self->uring != NULL)
+    gum_io_uring_drain (self->uring);
   fflush (self->handle);
 }
 
@@ -149,6 +266,7 @@ gum_file_new (Local<Object> wrapper,
   file->wrapper->SetWeak (file, gum_file_on_weak_notify,
       WeakCallbackType::kParameter);
   file->handle = handle;
+  file->uring = NULL;
   file->module = module;
 
   g_hash_table_add (module->files, file);
@@ -182,6 +300,7 @@ gum_file_check_open (GumFile * self,
 static void
 gum_file_close (GumFile * self)
 {
+  g_clear_pointer (&self->uring, gum_io_uring_close);
   g_clear_pointer (&self->handle, fclose);
 }
 
@@ -192,3 +311,137 @@ gum_file_on_weak_notify (const WeakCallbackInfo<GumFile> & info)
   auto self = info.GetParameter ();
   g_hash_table_remove (self->module->files, self);
 }
+
+/*
+ * A bounded on-disk ring for continuous tracing: the file is preallocated
+ * and memory-mapped up front, so steady-state writes are plain memcpys with
+ * no syscalls, no growth, and no rotation stalls. The oldest data is
+ * overwritten once the ring is full, and the write cursor in the file's
+ * header is only advanced past fully copied records.
+ */
+GUMJS_DEFINE_CONSTRUCTOR (gumjs_ring_file_construct)
+{
+  if (!info.IsConstructCall ())
+  {
+    _gum_v8_throw_ascii_literal (isolate,
+        "use `new RingFile()` to create a new instance");
+    return;
+  }
+
+  gchar * path;
+  gsize capacity;
+  if (!_gum_v8_args_parse (args, "sZ", &path, &capacity))
+    return;
+
+  GError * error = NULL;
+  auto handle = gum_ring_file_open (path, capacity, &error);
+
+  g_free (path);
+
+  if (_gum_v8_maybe_throw (isolate, &error))
+    return;
+
+  auto instance = gum_ring_file_instance_new (wrapper, handle, module);
+  wrapper->SetAlignedPointerInInternalField (0, instance);
+}
+
+GUMJS_DEFINE_CLASS_GETTER (gumjs_ring_file_get_capacity, GumRingFileInstance)
+{
+  if (!gum_ring_file_instance_check_open (self, isolate))
+    return;
+
+  info.GetReturnValue ().Set (
+      (double) gum_ring_file_get_capacity (self->handle));
+}
+
+GUMJS_DEFINE_CLASS_GETTER (gumjs_ring_file_get_position, GumRingFileInstance)
+{
+  if (!gum_ring_file_instance_check_open (self, isolate))
+    return;
+
+  info.GetReturnValue ().Set (
+      (double) gum_ring_file_get_position (self->handle));
+}
+
+GUMJS_DEFINE_CLASS_METHOD (gumjs_ring_file_write, GumRingFileInstance)
+{
+  if (!gum_ring_file_instance_check_open (self, isolate))
+    return;
+
+  GBytes * bytes;
+  if (!_gum_v8_args_parse (args, "B~", &bytes))
+    return;
+
+  gsize size;
+  auto data = g_bytes_get_data (bytes, &size);
+  if (!gum_ring_file_write (self->handle, data, size))
+    _gum_v8_throw_ascii_literal (isolate, "record is larger than the ring");
+
+  g_bytes_unref (bytes);
+}
+
+GUMJS_DEFINE_CLASS_METHOD (gumjs_ring_file_flush, GumRingFileInstance)
+{
+  if (!gum_ring_file_instance_check_open (self, isolate))
+    return;
+
+  gum_ring_file_flush (self->handle);
+}
+
+GUMJS_DEFINE_CLASS_METHOD (gumjs_ring_file_close, GumRingFileInstance)
+{
+  if (!gum_ring_file_instance_check_open (self, isolate))
+    return;
+
+  gum_ring_file_close (self->handle);
+}
+
+static GumRingFileInstance *
+gum_ring_file_instance_new (Local<Object> wrapper,
+                            GumRingFile * handle,
+                            GumV8File * module)
+{
+  auto instance = g_slice_new (GumRingFileInstance);
+  instance->wrapper =
+      new GumPersistent<Object>::type (module->core->isolate, wrapper);
+  instance->wrapper->SetWeak (instance, gum_ring_file_instance_on_weak_notify,
+      WeakCallbackType::kParameter);
+  instance->handle = handle;
+  instance->module = module;
+
+  g_hash_table_add (module->ring_files, instance);
+
+  return instance;
+}
+
+static void
+gum_ring_file_instance_free (GumRingFileInstance * self)
+{
+  g_object_unref (self->handle);
+
+  delete self->wrapper;
+
+  g_slice_free (GumRingFileInstance, self);
+}
+
+static gboolean
+gum_ring_file_instance_check_open (GumRingFileInstance * self,
+                                   Isolate * isolate)
+{
+  if (gum_ring_file_is_closed (self->handle))
+  {
+    _gum_v8_throw_ascii_literal (isolate, "file is closed");
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static void
+gum_ring_file_instance_on_weak_notify (
+    const WeakCallbackInfo<GumRingFileInstance> & info)
+{
+  HandleScope handle_scope (info.GetIsolate ());
+  auto self = info.GetParameter ();
+  g_hash_table_remove (self->module->ring_files, self);
+}
@@ -14,6 +14,7 @@ struct GumV8File
   GumV8Core * core;
 
   GHashTable * files;
+  GHashTable * ring_files;
 };
 
 G_GNUC_INTERNAL void _gum_v8_file_init (GumV8File * self,
@@ -17,6 +17,7 @@
 using namespace v8;
 
 GUMJS_DECLARE_FUNCTION (gumjs_instruction_parse)
+GUMJS_DECLARE_FUNCTION (gumjs_instruction_parse_block)
 
 static GumV8InstructionValue * gum_v8_instruction_alloc (
     GumV8Instruction * module);
@@ -69,6 +70,7 @@ static Local<Array> gum_parse_groups (const uint8_t * groups, uint8_t count,
 static const GumV8Function gumjs_instruction_module_functions[] =
 {
   { "_parse", gumjs_instruction_parse },
+  { "_parseBlock", gumjs_instruction_parse_block },
 
   { NULL, NULL }
 };
@@ -294,6 +296,79 @@ GUMJS_DEFINE_FUNCTION (gumjs_instruction_parse)
       _gum_v8_instruction_new (module->capstone, insn, TRUE, target, module));
 }
 
+/*
+ * Batch counterpart of _parse: walks up to the requested number of
+ * instructions through a single reused capstone buffer, with operand
+ * detail switched off, and returns a compact struct-of-arrays view
+ * instead of one wrapper object per instruction.
+ */
+GUMJS_DEFINE_FUNCTION (gumjs_instruction_parse_block)
+{
+  gpointer target;
+  guint limit;
+  if (!_gum_v8_args_parse (args, "pu", &target, &limit))
+    return;
+
+  target = gum_strip_code_pointer (target);
+
+  uint64_t address;
+#ifdef HAVE_ARM
+  address = GPOINTER_TO_SIZE (target) & ~1;
+  cs_option (module->capstone, CS_OPT_MODE,
+      (((GPOINTER_TO_SIZE (target) & 1) == 1) ? CS_MODE_THUMB : CS_MODE_ARM) |
+      CS_MODE_V8 | GUM_DEFAULT_CS_ENDIAN);
+#else
+  address = GPOINTER_TO_SIZE (target);
+#endif
+
+  const gsize max_instruction_size = 16;
+
+  auto context = isolate->GetCurrentContext ();
+
+  auto addresses = Array::New (isolate);
+  auto sizes = Array::New (isolate);
+  auto mnemonics = Array::New (isolate);
+  auto op_strs = Array::New (isolate);
+
+  cs_option (module->capstone, CS_OPT_DETAIL, CS_OPT_OFF);
+
+  auto insn = cs_malloc (module->capstone);
+
+  auto code = (const uint8_t *) GSIZE_TO_POINTER (address);
+
+  uint32_t i;
+  for (i = 0; i != limit; i++)
+  {
+    size_t remaining = max_instruction_size;
+
+    gum_ensure_code_readable (code, remaining);
+
+    if (!cs_disasm_iter (module->capstone, &code, &remaining, &address, insn))
+      break;
+
+    addresses->Set (context, i, _gum_v8_native_pointer_new (
+        GSIZE_TO_POINTER (insn->address), core)).Check ();
+    sizes->Set (context, i, Integer::New (isolate, insn->size)).Check ();
+    mnemonics->Set (context, i,
+        _gum_v8_string_new_ascii (isolate, insn->mnemonic)).Check ();
+    op_strs->Set (context, i,
+        _gum_v8_string_new_ascii (isolate, insn->op_str)).Check ();
+  }
+
+  cs_free (insn, 1);
+
+  cs_option (module->capstone, CS_OPT_DETAIL, CS_OPT_ON);
+
+  auto result = Object::New (isolate);
+  _gum_v8_object_set_uint (result, "count", i, core);
+  _gum_v8_object_set (result, "address", addresses, core);
+  _gum_v8_object_set (result, "size", sizes, core);
+  _gum_v8_object_set (result, "mnemonic", mnemonics, core);
+  _gum_v8_object_set (result, "opStr", op_strs, core);
+
+  info.GetReturnValue ().Set (result);
+}
+
 GUMJS_DEFINE_CLASS_GETTER (gumjs_instruction_get_address, GumV8InstructionValue)
 {
   if (!gum_v8_instruction_check_valid (self, isolate))
@@ -65,6 +65,7 @@ struct GumV8JSCallListener
 
   GumPersistent<Function>::type * on_enter;
   GumPersistent<Function>::type * on_leave;
+  guint arg_count;
 };
 
 struct GumV8JSCallListenerClass
@@ -597,6 +598,15 @@ GUMJS_DEFINE_FUNCTION (gumjs_interceptor_attach)
       if (!on_leave_js.IsEmpty ())
         l->on_leave = new GumPersistent<Function>::type (isolate, on_leave_js);
 
+      Local<Value> ac_val;
+      if (callback_val.As<Object> ()->Get (isolate->GetCurrentContext (),
+          _gum_v8_string_new_ascii (isolate, "argCount")).ToLocal (&ac_val) &&
+          ac_val->IsNumber ())
+      {
+        l->arg_count =
+            ac_val->Uint32Value (isolate->GetCurrentContext ()).FromMaybe (0);
+      }
+
       listener = GUM_V8_INVOCATION_LISTENER (l);
     }
     else if (on_enter_c != NULL || on_leave_c != NULL)
@@ -876,17 +886,40 @@ gum_v8_js_call_listener_on_enter (GumInvocationListener * listener,
     _gum_v8_invocation_context_reset (jic, ic);
     auto recv = Local<Object>::New (isolate, *jic->object);
 
-    auto args = gum_v8_interceptor_obtain_invocation_args (module);
-    gum_v8_invocation_args_reset (args, ic);
-    auto args_object = Local<Object>::New (isolate, *args->object);
+    GumV8InvocationArgs * args = NULL;
+    Local<Value> args_value;
+    if (self->arg_count != 0)
+    {
+      /*
+       * The hook declared its argument count up front, so capture the
+       * values in one native sweep and let everything else materialize
+       * lazily through the invocation context.
+       */
+      auto prefetched = Array::New (isolate, self->arg_count);
+      for (guint i = 0; i != self->arg_count; i++)
+      {
+        prefetched->Set (context, i, _gum_v8_native_pointer_new (
+            gum_invocation_context_get_nth_argument (ic, i), core)).Check ();
+      }
+      args_value = prefetched;
+    }
+    else
+    {
+      args = gum_v8_interceptor_obtain_invocation_args (module);
+      gum_v8_invocation_args_reset (args, ic);
+      args_value = Local<Object>::New (isolate, *args->object);
+    }
 
-    Local<Value> argv[] = { args_object };
+    Local<Value> argv[] = { args_value };
     auto result = on_enter->Call (context, recv, G_N_ELEMENTS (argv), argv);
     if (result.IsEmpty ())
       scope.ProcessAnyPendingException ();
 
-    gum_v8_invocation_args_reset (args, NULL);
-    gum_v8_interceptor_release_invocation_args (module, args);
+    if (args != NULL)
+    {
+      gum_v8_invocation_args_reset (args, NULL);
+      gum_v8_interceptor_release_invocation_args (module, args);
+    }
 
     _gum_v8_invocation_context_reset (jic, NULL);
     if (self->on_leave != nullptr || jic->dirty)
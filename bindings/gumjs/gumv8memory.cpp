@@ -59,6 +59,12 @@ struct GumMemoryScanContext
   GumPersistent<Function>::type * on_match;
   GumPersistent<Function>::type * on_error;
   GumPersistent<Function>::type * on_complete;
+  gboolean deliver_batches;
+  guint batch_capacity;
+  GumAddress * pending_addresses;
+  guint32 * pending_sizes;
+  guint n_pending;
+  gboolean stopped;
 
   GumV8Core * core;
 };
@@ -73,6 +79,7 @@ struct GumMemoryScanSyncContext
 GUMJS_DECLARE_FUNCTION (gumjs_memory_alloc)
 GUMJS_DECLARE_FUNCTION (gumjs_memory_copy)
 GUMJS_DECLARE_FUNCTION (gumjs_memory_protect)
+GUMJS_DECLARE_FUNCTION (gumjs_memory_protect_ranges)
 GUMJS_DECLARE_FUNCTION (gumjs_memory_patch_code)
 static void gum_memory_patch_context_apply (gpointer mem,
     GumMemoryPatchContext * self);
@@ -138,10 +145,23 @@ static void gum_memory_scan_context_free (GumMemoryScanContext * self);
 static void gum_memory_scan_context_run (GumMemoryScanContext * self);
 static gboolean gum_memory_scan_context_emit_match (GumAddress address,
     gsize size, GumMemoryScanContext * self);
+static gboolean gum_memory_scan_context_flush (GumMemoryScanContext * self);
 GUMJS_DECLARE_FUNCTION (gumjs_memory_scan_sync)
 static gboolean gum_append_match (GumAddress address, gsize size,
     GumMemoryScanSyncContext * ctx);
 
+GUMJS_DECLARE_FUNCTION (gumjs_memory_hexdump)
+static void gum_append_hexdump (GString * output, gconstpointer address,
+    gsize size, gboolean show_header, gboolean use_ansi);
+GUMJS_DECLARE_FUNCTION (gumjs_memory_scan_strings)
+static void gum_scan_utf8_strings (Local<Array> matches, gconstpointer address,
+    gsize size, guint min_length, GumV8Core * core);
+static void gum_scan_utf16_strings (Local<Array> matches, gconstpointer address,
+    gsize size, guint min_length, GumV8Core * core);
+static void gum_append_string_match (Local<Array> matches, GumAddress address,
+    gsize size, const gchar * encoding, Local<String> content,
+    GumV8Core * core);
+
 GUMJS_DECLARE_FUNCTION (gumjs_memory_access_monitor_enable)
 GUMJS_DECLARE_FUNCTION (gumjs_memory_access_monitor_disable)
 static void gum_v8_memory_clear_monitor (GumV8Memory * self);
@@ -153,6 +173,7 @@ static const GumV8Function gumjs_memory_functions[] =
   { "alloc", gumjs_memory_alloc },
   { "copy", gumjs_memory_copy },
   { "protect", gumjs_memory_protect },
+  { "protectRanges", gumjs_memory_protect_ranges },
   { "_patchCode", gumjs_memory_patch_code },
   { "_checkCodePointer", gumjs_memory_check_code_pointer },
 
@@ -186,6 +207,9 @@ static const GumV8Function gumjs_memory_functions[] =
   { "scan", gumjs_memory_scan },
   { "scanSync", gumjs_memory_scan_sync },
 
+  { "hexdump", gumjs_memory_hexdump },
+  { "scanStrings", gumjs_memory_scan_strings },
+
   { NULL, NULL }
 };
 
@@ -320,6 +344,26 @@ GUMJS_DEFINE_FUNCTION (gumjs_memory_protect)
   info.GetReturnValue ().Set (success);
 }
 
+/*
+ * Batch variant for scripts toggling protection on many ranges at once:
+ * gum_try_mprotect_batch() merges adjacent and overlapping ranges so the
+ * kernel sees as few protection changes as possible.
+ */
+GUMJS_DEFINE_FUNCTION (gumjs_memory_protect_ranges)
+{
+  GArray * ranges;
+  GumPageProtection prot;
+  if (!_gum_v8_args_parse (args, "Rm", &ranges, &prot))
+    return;
+
+  bool success = !!gum_try_mprotect_batch (
+      (const GumMemoryRange *) ranges->data, ranges->len, prot);
+
+  g_array_free (ranges, TRUE);
+
+  info.GetReturnValue ().Set (success);
+}
+
 GUMJS_DEFINE_FUNCTION (gumjs_memory_patch_code)
 {
   gpointer address;
@@ -888,8 +932,10 @@ GUMJS_DEFINE_FUNCTION (gumjs_memory_scan)
   gsize size;
   gchar * match_str;
   Local<Function> on_match, on_error, on_complete;
-  if (!_gum_v8_args_parse (args, "pZsF{onMatch,onError?,onComplete}",
-      &address, &size, &match_str, &on_match, &on_error, &on_complete))
+  guint batch_size = 0;
+  if (!_gum_v8_args_parse (args, "pZsF{onMatch,onError?,onComplete}|u",
+      &address, &size, &match_str, &on_match, &on_error, &on_complete,
+      &batch_size))
     return;
 
   GumMemoryRange range;
@@ -909,6 +955,10 @@ GUMJS_DEFINE_FUNCTION (gumjs_memory_scan)
     if (!on_error.IsEmpty ())
       ctx->on_error = new GumPersistent<Function>::type (isolate, on_error);
     ctx->on_complete = new GumPersistent<Function>::type (isolate, on_complete);
+    ctx->deliver_batches = batch_size != 0;
+    ctx->batch_capacity = (batch_size != 0) ? batch_size : 64;
+    ctx->pending_addresses = g_new (GumAddress, ctx->batch_capacity);
+    ctx->pending_sizes = g_new (guint32, ctx->batch_capacity);
     ctx->core = core;
 
     _gum_v8_core_pin (core);
@@ -928,6 +978,9 @@ gum_memory_scan_context_free (GumMemoryScanContext * self)
 
   gum_match_pattern_free (self->pattern);
 
+  g_free (self->pending_addresses);
+  g_free (self->pending_sizes);
+
   {
     ScriptScope script_scope (core->script);
 
@@ -960,6 +1013,9 @@ gum_memory_scan_context_run (GumMemoryScanContext * self)
         (GumMemoryScanMatchFunc) gum_memory_scan_context_emit_match, self);
   }
 
+  if (!self->stopped)
+    gum_memory_scan_context_flush (self);
+
   if (gum_exceptor_catch (exceptor, &scope) && self->on_error != nullptr)
   {
     ScriptScope script_scope (core->script);
@@ -989,11 +1045,36 @@ gum_memory_scan_context_run (GumMemoryScanContext * self)
   }
 }
 
+/*
+ * Matches are buffered natively and dispatched per batch, keeping callback
+ * overhead bounded on scans with huge match counts. A caller-supplied batch
+ * size switches onMatch to (addresses, sizes) array delivery; the default
+ * keeps the per-match contract but amortizes scope entry across each batch.
+ */
+
 static gboolean
 gum_memory_scan_context_emit_match (GumAddress address,
                                     gsize size,
                                     GumMemoryScanContext * self)
 {
+  self->pending_addresses[self->n_pending] = address;
+  self->pending_sizes[self->n_pending] = (guint32) size;
+  self->n_pending++;
+
+  if (self->n_pending != self->batch_capacity)
+    return TRUE;
+
+  return gum_memory_scan_context_flush (self);
+}
+
+static gboolean
+gum_memory_scan_context_flush (GumMemoryScanContext * self)
+{
+  auto n = self->n_pending;
+  self->n_pending = 0;
+  if (n == 0)
+    return TRUE;
+
   ScriptScope scope (self->core->script);
   auto isolate = self->core->isolate;
   auto context = isolate->GetCurrentContext ();
@@ -1001,18 +1082,52 @@ gum_memory_scan_context_emit_match (GumAddress address,
   gboolean proceed = TRUE;
   auto on_match = Local<Function>::New (isolate, *self->on_match);
   auto recv = Undefined (isolate);
-  Local<Value> argv[] = {
-    _gum_v8_native_pointer_new (GSIZE_TO_POINTER (address), self->core),
-    Integer::NewFromUnsigned (isolate, size)
-  };
-  Local<Value> result;
-  if (on_match->Call (context, recv, G_N_ELEMENTS (argv), argv)
-      .ToLocal (&result) && result->IsString ())
+
+  if (self->deliver_batches)
+  {
+    auto addresses = Array::New (isolate, n);
+    auto sizes = Array::New (isolate, n);
+    for (guint i = 0; i != n; i++)
+    {
+      addresses->Set (context, i, _gum_v8_native_pointer_new (
+          GSIZE_TO_POINTER (self->pending_addresses[i]), self->core))
+          .ToChecked ();
+      sizes->Set (context, i,
+          Integer::NewFromUnsigned (isolate, self->pending_sizes[i]))
+          .ToChecked ();
+    }
+
+    Local<Value> argv[] = { addresses, sizes };
+    Local<Value> result;
+    if (on_match->Call (context, recv, G_N_ELEMENTS (argv), argv)
+        .ToLocal (&result) && result->IsString ())
+    {
+      String::Utf8Value str (isolate, result);
+      proceed = strcmp (*str, "stop") != 0;
+    }
+  }
+  else
   {
-    String::Utf8Value str (isolate, result);
-    proceed = strcmp (*str, "stop") != 0;
+    for (guint i = 0; i != n && proceed; i++)
+    {
+      Local<Value> argv[] = {
+        _gum_v8_native_pointer_new (
+            GSIZE_TO_POINTER (self->pending_addresses[i]), self->core),
+        Integer::NewFromUnsigned (isolate, self->pending_sizes[i])
+      };
+      Local<Value> result;
+      if (on_match->Call (context, recv, G_N_ELEMENTS (argv), argv)
+          .ToLocal (&result) && result->IsString ())
+      {
+        String::Utf8Value str (isolate, result);
+        proceed = strcmp (*str, "stop") != 0;
+      }
+    }
   }
 
+  if (!proceed)
+    self->stopped = TRUE;
+
   return proceed;
 }
 
@@ -1082,6 +1197,320 @@ gum_append_match (GumAddress address,
 # pragma warning (pop)
 #endif
 
+GUMJS_DEFINE_FUNCTION (gumjs_memory_hexdump)
+{
+  gpointer address;
+  gsize size;
+  gboolean show_header = TRUE;
+  gboolean use_ansi = FALSE;
+  if (!_gum_v8_args_parse (args, "pZ|tt", &address, &size, &show_header,
+      &use_ansi))
+    return;
+
+  auto output = g_string_sized_new (MIN (size, 4096) * 5);
+
+  GumExceptorScope scope;
+
+  if (gum_exceptor_try (core->exceptor, &scope))
+  {
+    gum_append_hexdump (output, address, size, show_header, use_ansi);
+  }
+
+  if (gum_exceptor_catch (core->exceptor, &scope))
+  {
+    _gum_v8_throw_native (&scope.exception, core);
+  }
+  else
+  {
+    info.GetReturnValue ().Set (String::NewFromUtf8 (isolate, output->str,
+        NewStringType::kNormal, output->len).ToLocalChecked ());
+  }
+
+  g_string_free (output, TRUE);
+}
+
+/*
+ * Produces the exact same text as the hexdump() runtime helper, but does it
+ * with a couple of table lookups per byte instead of a handful of JS string
+ * operations per byte. We deliberately keep it table-driven plain C rather
+ * than hand-vectorized so it is equally at home on every architecture this
+ * file builds for.
+ */
+
+static void
+gum_append_hexdump (GString * output,
+                    gconstpointer address,
+                    gsize size,
+                    gboolean show_header,
+                    gboolean use_ansi)
+{
+  static const gchar nibbles[] = "0123456789abcdef";
+  auto bytes = (const guint8 *) address;
+  gchar address_str[16];
+
+  guint left_column_width = 0;
+  for (gsize cursor = GPOINTER_TO_SIZE (address) + size; cursor != 0;
+      cursor >>= 4)
+  {
+    left_column_width++;
+  }
+  left_column_width = MAX (left_column_width, 8);
+
+  const gchar * reset_color, * offset_color, * data_color, * newline_color;
+  if (use_ansi)
+  {
+    reset_color = "\x1b[0m";
+    offset_color = "\x1b[0;32m";
+    data_color = "\x1b[0;33m";
+    newline_color = reset_color;
+  }
+  else
+  {
+    reset_color = "";
+    offset_color = "";
+    data_color = "";
+    newline_color = "";
+  }
+
+  if (show_header)
+  {
+    for (guint i = 0; i != left_column_width; i++)
+      g_string_append_c (output, ' ');
+    g_string_append (output,
+        "   0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F"
+        "  0123456789ABCDEF\n");
+  }
+
+  for (gsize offset = 0; offset < size; offset += 16)
+  {
+    gsize line_address = GPOINTER_TO_SIZE (address) + offset;
+    gsize line_size = MIN (size - offset, 16);
+
+    if (offset != 0)
+      g_string_append_c (output, '\n');
+
+    for (guint i = 0; i != left_column_width; i++)
+    {
+      address_str[left_column_width - 1 - i] =
+          nibbles[(line_address >> (4 * i)) & 0xf];
+    }
+    g_string_append (output, offset_color);
+    g_string_append_len (output, address_str, left_column_width);
+    g_string_append (output, reset_color);
+    g_string_append (output, "  ");
+
+    for (gsize j = 0; j != line_size; j++)
+    {
+      guint8 value = bytes[offset + j];
+
+      if (j != 0)
+        g_string_append_c (output, ' ');
+      g_string_append (output, (value == '\n') ? newline_color : data_color);
+      g_string_append_c (output, nibbles[value >> 4]);
+      g_string_append_c (output, nibbles[value & 0xf]);
+      g_string_append (output, reset_color);
+    }
+    for (gsize j = line_size; j != 16; j++)
+      g_string_append (output, "   ");
+
+    g_string_append (output, "  ");
+
+    for (gsize j = 0; j != line_size; j++)
+    {
+      guint8 value = bytes[offset + j];
+
+      g_string_append (output, (value == '\n') ? newline_color : data_color);
+      g_string_append_c (output,
+          (value >= 32 && value <= 126) ? (gchar) value : '.');
+      g_string_append (output, reset_color);
+    }
+    for (gsize j = line_size; j != 16; j++)
+      g_string_append_c (output, ' ');
+  }
+
+  while (output->len != 0 && output->str[output->len - 1] == ' ')
+    g_string_truncate (output, output->len - 1);
+}
+
+GUMJS_DEFINE_FUNCTION (gumjs_memory_scan_strings)
+{
+  gpointer address;
+  gsize size;
+  guint min_length = 4;
+  if (!_gum_v8_args_parse (args, "pZ|u", &address, &size, &min_length))
+    return;
+  min_length = MAX (min_length, 1);
+
+  auto matches = Array::New (isolate);
+
+  GumExceptorScope scope;
+
+  if (gum_exceptor_try (core->exceptor, &scope))
+  {
+    gum_scan_utf8_strings (matches, address, size, min_length, core);
+    gum_scan_utf16_strings (matches, address, size, min_length, core);
+  }
+
+  if (gum_exceptor_catch (core->exceptor, &scope))
+  {
+    _gum_v8_throw_native (&scope.exception, core);
+  }
+  else
+  {
+    info.GetReturnValue ().Set (matches);
+  }
+}
+
+/*
+ * Matches are runs of printable ASCII and well-formed multi-byte sequences.
+ * A candidate run is only emitted once g_utf8_validate() agrees, so the
+ * cheap byte-class pass merely narrows down what the strict validator has to
+ * look at.
+ */
+
+static void
+gum_scan_utf8_strings (Local<Array> matches,
+                       gconstpointer address,
+                       gsize size,
+                       guint min_length,
+                       GumV8Core * core)
+{
+  auto bytes = (const guint8 *) address;
+
+  gsize cursor = 0;
+  while (cursor != size)
+  {
+    gsize start = cursor;
+    guint n_chars = 0;
+
+    while (cursor != size)
+    {
+      guint8 byte = bytes[cursor];
+
+      if ((byte >= 0x20 && byte <= 0x7e) || byte == '\t')
+      {
+        cursor++;
+        n_chars++;
+        continue;
+      }
+
+      guint seq_len;
+      if (byte >= 0xc2 && byte <= 0xdf)
+        seq_len = 2;
+      else if (byte >= 0xe0 && byte <= 0xef)
+        seq_len = 3;
+      else if (byte >= 0xf0 && byte <= 0xf4)
+        seq_len = 4;
+      else
+        break;
+
+      if (cursor + seq_len > size)
+        break;
+
+      gboolean valid = TRUE;
+      for (guint k = 1; k != seq_len; k++)
+      {
+        if ((bytes[cursor + k] & 0xc0) != 0x80)
+          valid = FALSE;
+      }
+      if (!valid)
+        break;
+
+      cursor += seq_len;
+      n_chars++;
+    }
+
+    if (n_chars >= min_length &&
+        g_utf8_validate ((const gchar *) bytes + start, cursor - start, NULL))
+    {
+      gum_append_string_match (matches,
+          GUM_ADDRESS (GPOINTER_TO_SIZE (address) + start), cursor - start,
+          "utf8",
+          String::NewFromUtf8 (core->isolate, (const gchar *) bytes + start,
+              NewStringType::kNormal, cursor - start).ToLocalChecked (),
+          core);
+    }
+
+    if (cursor == start)
+      cursor++;
+  }
+}
+
+/*
+ * Like the classic `strings -el`: little-endian UTF-16 units restricted to
+ * the printable ASCII range, tried at both alignments so strings embedded
+ * at odd offsets are found too.
+ */
+
+static void
+gum_scan_utf16_strings (Local<Array> matches,
+                        gconstpointer address,
+                        gsize size,
+                        guint min_length,
+                        GumV8Core * core)
+{
+  auto bytes = (const guint8 *) address;
+
+  for (guint parity = 0; parity != 2; parity++)
+  {
+    gsize cursor = parity;
+
+    while (cursor + 2 <= size)
+    {
+      gsize start = cursor;
+      guint n_chars = 0;
+
+      while (cursor + 2 <= size)
+      {
+        guint16 unit = bytes[cursor] | ((guint16) bytes[cursor + 1] << 8);
+
+        if (!((unit >= 0x20 && unit <= 0x7e) || unit == '\t'))
+          break;
+
+        cursor += 2;
+        n_chars++;
+      }
+
+      if (n_chars >= min_length)
+      {
+        auto content = (gchar *) g_malloc (n_chars);
+        for (guint k = 0; k != n_chars; k++)
+          content[k] = (gchar) bytes[start + ((gsize) k * 2)];
+
+        gum_append_string_match (matches,
+            GUM_ADDRESS (GPOINTER_TO_SIZE (address) + start), cursor - start,
+            "utf16",
+            String::NewFromUtf8 (core->isolate, content,
+                NewStringType::kNormal, n_chars).ToLocalChecked (),
+            core);
+
+        g_free (content);
+      }
+
+      if (cursor == start)
+        cursor += 2;
+    }
+  }
+}
+
+static void
+gum_append_string_match (Local<Array> matches,
+                         GumAddress address,
+                         gsize size,
+                         const gchar * encoding,
+                         Local<String> content,
+                         GumV8Core * core)
+{
+  auto match = Object::New (core->isolate);
+  _gum_v8_object_set_pointer (match, "address", address, core);
+  _gum_v8_object_set_uint (match, "size", size, core);
+  _gum_v8_object_set_ascii (match, "encoding", encoding, core);
+  _gum_v8_object_set (match, "content", content, core);
+
+  matches->Set (core->isolate->GetCurrentContext (), matches->Length (),
+      match).ToChecked ();
+}
+
 GUMJS_DEFINE_FUNCTION (gumjs_memory_access_monitor_enable)
 {
   GArray * ranges;
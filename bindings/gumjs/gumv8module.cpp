@@ -10,6 +10,7 @@
 #include "gumv8matchcontext.h"
 
 #include <gum/gum-init.h>
+#include <gum/gumprocess-priv.h>
 #include <string.h>
 
 #define GUMJS_MODULE_NAME Module
@@ -79,6 +80,8 @@ static gboolean gum_emit_range (const GumRangeDetails * details,
     GumV8MatchContext<GumV8Module> * mc);
 GUMJS_DECLARE_FUNCTION (gumjs_module_find_base_address)
 GUMJS_DECLARE_FUNCTION (gumjs_module_find_export_by_name)
+static GumAddress gum_v8_module_find_cached_export (GumV8Module * self,
+    const gchar * module_name, const gchar * symbol_name);
 
 GUMJS_DECLARE_CONSTRUCTOR (gumjs_module_map_construct)
 GUMJS_DECLARE_GETTER (gumjs_module_map_get_handle)
@@ -141,6 +144,11 @@ _gum_v8_module_init (GumV8Module * self,
 
   self->core = core;
 
+  self->export_tables = g_hash_table_new_full (g_str_hash, g_str_equal,
+      g_free, (GDestroyNotify) gum_export_table_free);
+  self->has_module_generation =
+      _gum_process_try_query_module_generation (&self->export_tables_generation);
+
   auto module = External::New (isolate, self);
 
   auto klass = _gum_v8_create_class ("Module", nullptr, scope, module, isolate);
@@ -203,6 +211,9 @@ _gum_v8_module_dispose (GumV8Module * self)
   g_hash_table_unref (self->maps);
   self->maps = NULL;
 
+  g_hash_table_unref (self->export_tables);
+  self->export_tables = NULL;
+
   delete self->klass;
   self->klass = nullptr;
 
@@ -543,7 +554,15 @@ GUMJS_DEFINE_FUNCTION (gumjs_module_find_export_by_name)
   {
     ScriptUnlocker unlocker (core);
 
-    address = gum_module_find_export_by_name (module_name, symbol_name);
+    if (module_name != NULL && module->has_module_generation)
+    {
+      address = gum_v8_module_find_cached_export (module, module_name,
+          symbol_name);
+    }
+    else
+    {
+      address = gum_module_find_export_by_name (module_name, symbol_name);
+    }
   }
 
   if (address != 0)
@@ -560,6 +579,40 @@ GUMJS_DEFINE_FUNCTION (gumjs_module_find_export_by_name)
   g_free (symbol_name);
 }
 
+/*
+ * Polling findExportByName() is a common script pattern, so lookups are
+ * served from per-module export tables that stay valid until the loader's
+ * generation counter reports a change in the set of loaded modules.
+ */
+
+static GumAddress
+gum_v8_module_find_cached_export (GumV8Module * self,
+                                  const gchar * module_name,
+                                  const gchar * symbol_name)
+{
+  guint64 generation;
+  if (_gum_process_try_query_module_generation (&generation) &&
+      generation != self->export_tables_generation)
+  {
+    g_hash_table_remove_all (self->export_tables);
+    self->export_tables_generation = generation;
+  }
+
+  auto table = (GumExportTable *)
+      g_hash_table_lookup (self->export_tables, module_name);
+  if (table == NULL)
+  {
+    table = gum_module_collect_exports (module_name);
+    g_hash_table_insert (self->export_tables, g_strdup (module_name), table);
+  }
+
+  auto entry = gum_export_table_find (table, symbol_name);
+  if (entry == NULL)
+    return 0;
+
+  return entry->address;
+}
+
 GUMJS_DEFINE_CONSTRUCTOR (gumjs_module_map_construct)
 {
   if (!info.IsConstructCall ())
@@ -15,6 +15,10 @@ struct GumV8Module
 
   GHashTable * maps;
 
+  GHashTable * export_tables;
+  guint64 export_tables_generation;
+  gboolean has_module_generation;
+
   GumPersistent<v8::FunctionTemplate>::type * klass;
 
   GumPersistent<v8::Object>::type * import_value;
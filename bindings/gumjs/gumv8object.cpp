@@ -10,18 +10,44 @@
 
 using namespace v8;
 
+#define GUM_V8_OBJECT_ARENA_BLOCK_CAPACITY 64
+
 typedef GumV8Object<void, void> GumV8AnyObject;
 typedef GumV8ObjectOperation<void, void> GumV8AnyObjectOperation;
 typedef GumV8ModuleOperation<void> GumV8AnyModuleOperation;
 
+/*
+ * All GumV8Object instantiations share the same layout, so the manager
+ * carves them out of shared blocks instead of paying one heap round-trip
+ * per tracked object. The blocks are released wholesale once the manager
+ * and the last object are gone; the reference count is needed as cells
+ * may be handed back from the thread pool after the manager has been
+ * torn down.
+ */
+struct GumV8ObjectArena
+{
+  gint ref_count;
+  GMutex mutex;
+  GSList * blocks;
+  gpointer free_cells;
+  guint n_used_in_current_block;
+};
+
 struct GumV8TryScheduleIfIdleOperation : public GumV8ObjectOperation<void, void>
 {
   GumV8AnyObjectOperation * blocked_operation;
 };
 
+static GumV8ObjectArena * gum_v8_object_arena_new (void);
+static void gum_v8_object_arena_unref (GumV8ObjectArena * self);
+static GumV8AnyObject * gum_v8_object_arena_alloc (GumV8ObjectArena * self);
+static void gum_v8_object_arena_release (GumV8ObjectArena * self,
+    GumV8AnyObject * object);
+
 static void gum_v8_object_on_weak_notify (
     const WeakCallbackInfo<GumV8AnyObject> & info);
 static void gum_v8_object_free (GumV8AnyObject * self);
+static void gum_v8_object_release (GumV8AnyObject * self);
 
 static void gum_v8_object_operation_free (GumV8AnyObjectOperation * self);
 static void gum_v8_object_operation_try_schedule_when_idle (
@@ -36,6 +62,7 @@ gum_v8_object_manager_init (GumV8ObjectManager * self)
 {
   self->object_by_handle = g_hash_table_new_full (NULL, NULL, NULL,
       (GDestroyNotify) gum_v8_object_free);
+  self->arena = gum_v8_object_arena_new ();
   self->cancellable = g_cancellable_new ();
 }
 
@@ -65,9 +92,78 @@ gum_v8_object_manager_free (GumV8ObjectManager * self)
   g_hash_table_remove_all (self->object_by_handle);
 
   g_object_unref (self->cancellable);
+  gum_v8_object_arena_unref (self->arena);
   g_hash_table_unref (self->object_by_handle);
 }
 
+static GumV8ObjectArena *
+gum_v8_object_arena_new (void)
+{
+  auto arena = g_slice_new (GumV8ObjectArena);
+  arena->ref_count = 1;
+  g_mutex_init (&arena->mutex);
+  arena->blocks = NULL;
+  arena->free_cells = NULL;
+  arena->n_used_in_current_block = GUM_V8_OBJECT_ARENA_BLOCK_CAPACITY;
+
+  return arena;
+}
+
+static void
+gum_v8_object_arena_unref (GumV8ObjectArena * self)
+{
+  if (!g_atomic_int_dec_and_test (&self->ref_count))
+    return;
+
+  g_slist_free_full (self->blocks, g_free);
+  g_mutex_clear (&self->mutex);
+  g_slice_free (GumV8ObjectArena, self);
+}
+
+static GumV8AnyObject *
+gum_v8_object_arena_alloc (GumV8ObjectArena * self)
+{
+  GumV8AnyObject * object;
+
+  g_mutex_lock (&self->mutex);
+
+  if (self->free_cells != NULL)
+  {
+    object = (GumV8AnyObject *) self->free_cells;
+    self->free_cells = *(gpointer *) object;
+  }
+  else
+  {
+    if (self->n_used_in_current_block == GUM_V8_OBJECT_ARENA_BLOCK_CAPACITY)
+    {
+      self->blocks = g_slist_prepend (self->blocks, g_malloc (
+          GUM_V8_OBJECT_ARENA_BLOCK_CAPACITY * sizeof (GumV8AnyObject)));
+      self->n_used_in_current_block = 0;
+    }
+
+    object = (GumV8AnyObject *) self->blocks->data +
+        self->n_used_in_current_block++;
+  }
+
+  g_mutex_unlock (&self->mutex);
+
+  g_atomic_int_inc (&self->ref_count);
+
+  return object;
+}
+
+static void
+gum_v8_object_arena_release (GumV8ObjectArena * self,
+                             GumV8AnyObject * object)
+{
+  g_mutex_lock (&self->mutex);
+  *(gpointer *) object = self->free_cells;
+  self->free_cells = object;
+  g_mutex_unlock (&self->mutex);
+
+  gum_v8_object_arena_unref (self);
+}
+
 gpointer
 _gum_v8_object_manager_add (GumV8ObjectManager * self,
                             Local<Object> wrapper,
@@ -75,7 +171,7 @@ _gum_v8_object_manager_add (GumV8ObjectManager * self,
                             gpointer module,
                             GumV8Core * core)
 {
-  auto object = g_slice_new (GumV8AnyObject);
+  auto object = gum_v8_object_arena_alloc (self->arena);
 
   auto * w = new GumPersistent<Object>::type (core->isolate, wrapper);
   w->SetWeak (object, gum_v8_object_on_weak_notify,
@@ -88,6 +184,7 @@ _gum_v8_object_manager_add (GumV8ObjectManager * self,
   object->module = module;
 
   object->manager = self;
+  object->arena = self->arena;
   object->num_active_operations = 0;
   object->pending_operations = g_queue_new ();
 
@@ -117,15 +214,30 @@ gum_v8_object_on_weak_notify (
 static void
 gum_v8_object_free (GumV8AnyObject * self)
 {
+  auto scheduler = self->core->scheduler;
+
   g_assert (self->num_active_operations == 0);
   g_assert (g_queue_is_empty (self->pending_operations));
   g_queue_free (self->pending_operations);
 
+  delete self->wrapper;
+
+  /*
+   * Only the wrapper has to die on the isolate thread; running the
+   * handle's dispose machinery is the expensive part of tearing down a
+   * large agent, so hand it to the thread pool and move on.
+   */
+  gum_script_scheduler_push_job_on_thread_pool (scheduler,
+      (GumScriptJobFunc) gum_v8_object_release, self, NULL);
+}
+
+static void
+gum_v8_object_release (GumV8AnyObject * self)
+{
   g_object_unref (self->cancellable);
   g_object_unref (self->handle);
-  delete self->wrapper;
 
-  g_slice_free (GumV8AnyObject, self);
+  gum_v8_object_arena_release (self->arena, self);
 }
 
 gpointer
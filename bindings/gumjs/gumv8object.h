@@ -9,9 +9,12 @@
 
 #include "gumv8core.h"
 
+struct GumV8ObjectArena;
+
 struct GumV8ObjectManager
 {
   GHashTable * object_by_handle;
+  GumV8ObjectArena * arena;
   GCancellable * cancellable;
 };
 
@@ -26,6 +29,7 @@ struct GumV8Object
   M * module;
 
   GumV8ObjectManager * manager;
+  GumV8ObjectArena * arena;
   guint num_active_operations;
   GQueue * pending_operations;
 };
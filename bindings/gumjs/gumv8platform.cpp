@@ -15,11 +15,17 @@
 #include <gum/gumcodesegment.h>
 #include <gum/gummemory.h>
 
+#include <string.h>
+
 using namespace v8;
 
 namespace
 {
   constexpr size_t kMaxWorkerPerJob = 32;
+
+  constexpr guint kArrayBufferSizeClasses = 11;
+  constexpr guint kArrayBufferMaxPerThreadPerClass = 2;
+  constexpr guint kArrayBufferMaxPooledPerClass = 8;
 }
 
 static GumPageProtection gum_page_protection_from_v8 (
@@ -259,6 +265,7 @@ class GumV8ArrayBufferAllocator : public ArrayBuffer::Allocator
 {
 public:
   GumV8ArrayBufferAllocator () = default;
+  ~GumV8ArrayBufferAllocator () override;
 
   void * Allocate (size_t length) override;
   void * AllocateUninitialized (size_t length) override;
@@ -429,7 +436,8 @@ private:
 };
 
 GumV8Platform::GumV8Platform ()
-  : objc_bundle (NULL),
+  : runtime_bundle (NULL),
+    objc_bundle (NULL),
     java_bundle (NULL),
     scheduler (gum_script_backend_get_scheduler ()),
     page_allocator (new GumV8PageAllocator ()),
@@ -450,8 +458,6 @@ GumV8Platform::GumV8Platform ()
   shared_isolate = Isolate::New (params);
   shared_isolate->SetFatalErrorHandler (OnFatalError);
   shared_isolate->SetMicrotasksPolicy (MicrotasksPolicy::kExplicit);
-
-  InitRuntime ();
 }
 
 GumV8Platform::~GumV8Platform ()
@@ -463,18 +469,6 @@ GumV8Platform::~GumV8Platform ()
   g_mutex_clear (&mutex);
 }
 
-void
-GumV8Platform::InitRuntime ()
-{
-  Locker locker (shared_isolate);
-  Isolate::Scope isolate_scope (shared_isolate);
-  HandleScope handle_scope (shared_isolate);
-  Local<Context> context (Context::New (shared_isolate));
-  Context::Scope context_scope (context);
-
-  runtime_bundle = gum_v8_bundle_new (shared_isolate, gumjs_runtime_modules);
-}
-
 void
 GumV8Platform::Dispose ()
 {
@@ -551,6 +545,14 @@ GumV8Platform::GetRuntimeSourceMap () const
   return gumjs_frida_source_map;
 }
 
+GumV8Bundle *
+GumV8Platform::GetRuntimeBundle ()
+{
+  if (runtime_bundle == NULL)
+    runtime_bundle = gum_v8_bundle_new (shared_isolate, gumjs_runtime_modules);
+  return runtime_bundle;
+}
+
 GumV8Bundle *
 GumV8Platform::GetObjCBundle ()
 {
@@ -1612,23 +1614,199 @@ GumV8PageAllocator::SetPermissions (void * address,
   return true;
 }
 
+/*
+ * Buffers of a page or more are served from a pool of power-of-two size
+ * classes, as dump-heavy agents allocate and free large ArrayBuffers at a
+ * rate where allocator churn dominates. Each thread keeps a couple of hot
+ * buffers per class; beyond that buffers land in a shared pool where their
+ * pages are decommitted, so pooled capacity costs address space but not
+ * RSS. Decommit does not guarantee zero-fill on reuse on all of our
+ * platforms, so recycled buffers are scrubbed when zeroed memory is
+ * requested.
+ */
+
+struct GumV8ArrayBufferThreadCache
+{
+  void * buffers[kArrayBufferSizeClasses][kArrayBufferMaxPerThreadPerClass];
+  guint count[kArrayBufferSizeClasses];
+};
+
+static void gum_v8_array_buffer_thread_cache_flush (gpointer data);
+
+static GMutex gum_v8_array_buffer_pool_mutex;
+static GSList * gum_v8_array_buffer_pool[kArrayBufferSizeClasses];
+static guint gum_v8_array_buffer_pool_count[kArrayBufferSizeClasses];
+static GPrivate gum_v8_array_buffer_thread_cache =
+    G_PRIVATE_INIT (gum_v8_array_buffer_thread_cache_flush);
+
+static gint
+gum_v8_array_buffer_size_class_for (size_t length)
+{
+  size_t size = gum_query_page_size ();
+
+  if (length < size)
+    return -1;
+
+  for (guint i = 0; i != kArrayBufferSizeClasses; i++, size <<= 1)
+  {
+    if (length <= size)
+      return i;
+  }
+
+  return -1;
+}
+
+static size_t
+gum_v8_array_buffer_size_class_capacity (gint size_class)
+{
+  return (size_t) gum_query_page_size () << size_class;
+}
+
+static GumV8ArrayBufferThreadCache *
+gum_v8_array_buffer_get_thread_cache ()
+{
+  auto cache = (GumV8ArrayBufferThreadCache *)
+      g_private_get (&gum_v8_array_buffer_thread_cache);
+  if (cache == NULL)
+  {
+    cache = g_new0 (GumV8ArrayBufferThreadCache, 1);
+    g_private_set (&gum_v8_array_buffer_thread_cache, cache);
+  }
+
+  return cache;
+}
+
+static void
+gum_v8_array_buffer_release_to_pool (void * data,
+                                     gint size_class)
+{
+  gboolean pooled = FALSE;
+
+  g_mutex_lock (&gum_v8_array_buffer_pool_mutex);
+  if (gum_v8_array_buffer_pool_count[size_class] !=
+      kArrayBufferMaxPooledPerClass)
+  {
+    gum_memory_decommit (data,
+        gum_v8_array_buffer_size_class_capacity (size_class));
+    gum_v8_array_buffer_pool[size_class] =
+        g_slist_prepend (gum_v8_array_buffer_pool[size_class], data);
+    gum_v8_array_buffer_pool_count[size_class]++;
+    pooled = TRUE;
+  }
+  g_mutex_unlock (&gum_v8_array_buffer_pool_mutex);
+
+  if (!pooled)
+    gum_free_pages (data);
+}
+
+static void
+gum_v8_array_buffer_thread_cache_flush (gpointer data)
+{
+  auto cache = (GumV8ArrayBufferThreadCache *) data;
+
+  for (guint i = 0; i != kArrayBufferSizeClasses; i++)
+  {
+    for (guint j = 0; j != cache->count[i]; j++)
+      gum_v8_array_buffer_release_to_pool (cache->buffers[i][j], i);
+  }
+
+  g_free (cache);
+}
+
+static void *
+gum_v8_array_buffer_alloc (size_t length,
+                           bool zeroed)
+{
+  gint size_class = gum_v8_array_buffer_size_class_for (length);
+  if (size_class < 0)
+    return zeroed ? g_malloc0 (MAX (length, 1)) : g_malloc (MAX (length, 1));
+
+  size_t capacity = gum_v8_array_buffer_size_class_capacity (size_class);
+  auto cache = gum_v8_array_buffer_get_thread_cache ();
+  void * data = NULL;
+
+  if (cache->count[size_class] != 0)
+  {
+    data = cache->buffers[size_class][--cache->count[size_class]];
+  }
+  else
+  {
+    g_mutex_lock (&gum_v8_array_buffer_pool_mutex);
+    GSList * head = gum_v8_array_buffer_pool[size_class];
+    if (head != NULL)
+    {
+      data = head->data;
+      gum_v8_array_buffer_pool[size_class] = g_slist_delete_link (head, head);
+      gum_v8_array_buffer_pool_count[size_class]--;
+    }
+    g_mutex_unlock (&gum_v8_array_buffer_pool_mutex);
+
+    if (data != NULL)
+      gum_memory_commit (data, capacity, GUM_PAGE_RW);
+  }
+
+  if (data == NULL)
+  {
+    return gum_alloc_n_pages (capacity / gum_query_page_size (),
+        GUM_PAGE_RW);
+  }
+
+  if (zeroed)
+    memset (data, 0, capacity);
+
+  return data;
+}
+
+static void
+gum_v8_array_buffer_release (void * data,
+                             size_t length)
+{
+  gint size_class = gum_v8_array_buffer_size_class_for (length);
+  if (size_class < 0)
+  {
+    g_free (data);
+    return;
+  }
+
+  auto cache = gum_v8_array_buffer_get_thread_cache ();
+  if (cache->count[size_class] != kArrayBufferMaxPerThreadPerClass)
+  {
+    cache->buffers[size_class][cache->count[size_class]++] = data;
+    return;
+  }
+
+  gum_v8_array_buffer_release_to_pool (data, size_class);
+}
+
+GumV8ArrayBufferAllocator::~GumV8ArrayBufferAllocator ()
+{
+  g_mutex_lock (&gum_v8_array_buffer_pool_mutex);
+  for (guint i = 0; i != kArrayBufferSizeClasses; i++)
+  {
+    g_slist_free_full (gum_v8_array_buffer_pool[i], gum_free_pages);
+    gum_v8_array_buffer_pool[i] = NULL;
+    gum_v8_array_buffer_pool_count[i] = 0;
+  }
+  g_mutex_unlock (&gum_v8_array_buffer_pool_mutex);
+}
+
 void *
 GumV8ArrayBufferAllocator::Allocate (size_t length)
 {
-  return g_malloc0 (MAX (length, 1));
+  return gum_v8_array_buffer_alloc (length, true);
 }
 
 void *
 GumV8ArrayBufferAllocator::AllocateUninitialized (size_t length)
 {
-  return g_malloc (MAX (length, 1));
+  return gum_v8_array_buffer_alloc (length, false);
 }
 
 void
 GumV8ArrayBufferAllocator::Free (void * data,
                                  size_t length)
 {
-  g_free (data);
+  gum_v8_array_buffer_release (data, length);
 }
 
 void *
@@ -1636,7 +1814,20 @@ GumV8ArrayBufferAllocator::Reallocate (void * data,
                                        size_t old_length,
                                        size_t new_length)
 {
-  return gum_realloc (data, new_length);
+  gint old_class = gum_v8_array_buffer_size_class_for (old_length);
+  gint new_class = gum_v8_array_buffer_size_class_for (new_length);
+
+  if (old_class < 0 && new_class < 0)
+    return gum_realloc (data, new_length);
+
+  if (old_class == new_class)
+    return data;
+
+  auto new_data = gum_v8_array_buffer_alloc (new_length, true);
+  memcpy (new_data, data, MIN (old_length, new_length));
+  gum_v8_array_buffer_release (data, old_length);
+
+  return new_data;
 }
 
 MutexImpl *
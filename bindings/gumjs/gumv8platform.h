@@ -31,7 +31,7 @@ public:
   ~GumV8Platform ();
 
   v8::Isolate * GetIsolate () const { return shared_isolate; }
-  GumV8Bundle * GetRuntimeBundle () const { return runtime_bundle; }
+  GumV8Bundle * GetRuntimeBundle ();
   const gchar * GetRuntimeSourceMap () const;
   GumV8Bundle * GetObjCBundle ();
   const gchar * GetObjCSourceMap () const;
@@ -68,7 +68,6 @@ public:
   v8::TracingController * GetTracingController () override;
 
 private:
-  void InitRuntime ();
   void Dispose ();
   void CancelPendingOperations ();
   static void OnFatalError (const char * location, const char * message);
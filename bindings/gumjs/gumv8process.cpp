@@ -14,6 +14,7 @@
 # include <gumdarwin.h>
 #endif
 
+#include <gum/gumprocess-priv.h>
 #include <string.h>
 
 #define GUMJS_MODULE_NAME Process
@@ -49,6 +50,13 @@ struct GumV8ExceptionHandler
   GumV8Core * core;
 };
 
+struct GumV8CachedModule
+{
+  gchar * name;
+  gchar * path;
+  GumMemoryRange range;
+};
+
 struct GumV8FindModuleByNameContext
 {
   gchar * name;
@@ -70,6 +78,10 @@ static gboolean gum_store_module_if_name_matches (
 GUMJS_DECLARE_FUNCTION (gumjs_process_enumerate_modules)
 static gboolean gum_emit_module (const GumModuleDetails * details,
     GumV8MatchContext<GumV8Process> * mc);
+static GArray * gum_v8_process_get_module_snapshot (GumV8Process * self);
+static gboolean gum_v8_process_collect_module (
+    const GumModuleDetails * details, gpointer user_data);
+static void gum_v8_cached_module_clear (GumV8CachedModule * module);
 GUMJS_DECLARE_FUNCTION (gumjs_process_enumerate_ranges)
 static gboolean gum_emit_range (const GumRangeDetails * details,
     GumV8MatchContext<GumV8Process> * mc);
@@ -112,6 +124,9 @@ _gum_v8_process_init (GumV8Process * self,
   self->module = module;
   self->core = core;
 
+  self->has_module_generation =
+      _gum_process_try_query_module_generation (&self->cached_modules_generation);
+
   auto process = _gum_v8_create_module ("Process", scope, isolate);
   process->Set (_gum_v8_string_new_ascii (isolate, "id"),
       Number::New (isolate, gum_process_get_id ()), ReadOnly);
@@ -150,6 +165,7 @@ _gum_v8_process_dispose (GumV8Process * self)
 void
 _gum_v8_process_finalize (GumV8Process * self)
 {
+  g_clear_pointer (&self->cached_modules, g_array_unref);
 }
 
 GUMJS_DEFINE_FUNCTION (gumjs_process_is_debugger_attached)
@@ -255,7 +271,26 @@ GUMJS_DEFINE_FUNCTION (gumjs_process_enumerate_modules)
       &mc.on_complete))
     return;
 
-  gum_process_enumerate_modules ((GumFoundModuleFunc) gum_emit_module, &mc);
+  auto modules = gum_v8_process_get_module_snapshot (module);
+  if (modules != NULL)
+  {
+    for (guint i = 0; i != modules->len; i++)
+    {
+      auto m = &g_array_index (modules, GumV8CachedModule, i);
+
+      GumModuleDetails details;
+      details.name = m->name;
+      details.range = &m->range;
+      details.path = m->path;
+
+      if (!gum_emit_module (&details, &mc))
+        break;
+    }
+  }
+  else
+  {
+    gum_process_enumerate_modules ((GumFoundModuleFunc) gum_emit_module, &mc);
+  }
 
   mc.OnComplete ();
 }
@@ -269,6 +304,68 @@ gum_emit_module (const GumModuleDetails * details,
   return mc->OnMatch (module);
 }
 
+/*
+ * Replaying a snapshot of the module list keeps enumerateModules() polling
+ * cheap; the loader's generation counter tells us when the snapshot has to
+ * be rebuilt.
+ */
+
+static GArray *
+gum_v8_process_get_module_snapshot (GumV8Process * self)
+{
+  if (!self->has_module_generation)
+    return NULL;
+
+  guint64 generation;
+  if (!_gum_process_try_query_module_generation (&generation))
+    return NULL;
+
+  if (self->cached_modules != NULL &&
+      generation == self->cached_modules_generation)
+    return self->cached_modules;
+
+  if (self->cached_modules == NULL)
+  {
+    self->cached_modules =
+        g_array_new (FALSE, FALSE, sizeof (GumV8CachedModule));
+    g_array_set_clear_func (self->cached_modules,
+        (GDestroyNotify) gum_v8_cached_module_clear);
+  }
+  else
+  {
+    g_array_set_size (self->cached_modules, 0);
+  }
+
+  gum_process_enumerate_modules (gum_v8_process_collect_module,
+      self->cached_modules);
+  self->cached_modules_generation = generation;
+
+  return self->cached_modules;
+}
+
+static gboolean
+gum_v8_process_collect_module (const GumModuleDetails * details,
+                               gpointer user_data)
+{
+  auto modules = (GArray *) user_data;
+
+  GumV8CachedModule m;
+  m.name = g_strdup (details->name);
+  m.path = g_strdup (details->path);
+  m.range = *details->range;
+
+  g_array_append_val (modules, m);
+
+  return TRUE;
+}
+
+static void
+gum_v8_cached_module_clear (GumV8CachedModule * module)
+{
+  g_free (module->name);
+  g_free (module->path);
+}
+
 GUMJS_DEFINE_FUNCTION (gumjs_process_enumerate_ranges)
 {
   GumPageProtection prot;
@@ -17,6 +17,10 @@ struct GumV8Process
   GumV8Module * module;
   GumV8Core * core;
 
+  GArray * cached_modules;
+  guint64 cached_modules_generation;
+  gboolean has_module_generation;
+
   GumV8ExceptionHandler * exception_handler;
 };
 
@@ -68,6 +68,9 @@ struct _GumV8Script
   GumScriptMessageHandler message_handler;
   gpointer message_handler_data;
   GDestroyNotify message_handler_data_destroy;
+  GMutex emit_mutex;
+  GQueue emit_queue;
+  gboolean emit_flush_scheduled;
 };
 
 #endif
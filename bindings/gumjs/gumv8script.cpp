@@ -11,10 +11,43 @@
 #include "gumv8script-priv.h"
 #include "gumv8value.h"
 
+#include <string.h>
+
 using namespace v8;
 
 typedef void (* GumUnloadNotifyFunc) (GumV8Script * self, gpointer user_data);
 
+class GumV8SourceStream : public ScriptCompiler::ExternalSourceStream
+{
+public:
+  GumV8SourceStream (const gchar * source)
+    : source (source),
+      delivered (false)
+  {
+  }
+
+  size_t GetMoreData (const uint8_t ** src) override
+  {
+    if (delivered)
+      return 0;
+    delivered = true;
+
+    size_t size = strlen (source);
+    if (size == 0)
+      return 0;
+
+    auto data = new uint8_t[size];
+    memcpy (data, source, size);
+    *src = data;
+
+    return size;
+  }
+
+private:
+  const gchar * source;
+  bool delivered;
+};
+
 enum
 {
   CONTEXT_CREATED,
@@ -47,7 +80,6 @@ struct GumUnloadNotifyCallback
 
 struct GumEmitData
 {
-  GumV8Script * script;
   gchar * message;
   GBytes * data;
 };
@@ -68,6 +100,7 @@ static void gum_v8_script_get_property (GObject * object, guint property_id,
     GValue * value, GParamSpec * pspec);
 static void gum_v8_script_set_property (GObject * object, guint property_id,
     const GValue * value, GParamSpec * pspec);
+static gpointer gum_v8_script_run_streaming_task (gpointer data);
 static void gum_v8_script_destroy_context (GumV8Script * self);
 
 static void gum_v8_script_load (GumScript * script, GCancellable * cancellable,
@@ -107,7 +140,7 @@ static GumStalker * gum_v8_script_get_stalker (GumScript * script);
 
 static void gum_v8_script_emit (GumV8Script * self, const gchar * message,
     GBytes * data);
-static gboolean gum_v8_script_do_emit (GumEmitData * d);
+static gboolean gum_v8_script_do_emit (GumV8Script * self);
 static void gum_v8_emit_data_free (GumEmitData * d);
 
 G_DEFINE_TYPE_EXTENDED (GumV8Script,
@@ -181,6 +214,10 @@ gum_v8_script_init (GumV8Script * self)
 {
   self->state = GUM_SCRIPT_STATE_UNLOADED;
   self->on_unload = NULL;
+
+  g_mutex_init (&self->emit_mutex);
+  g_queue_init (&self->emit_queue);
+  self->emit_flush_scheduled = FALSE;
 }
 
 static void
@@ -225,6 +262,11 @@ gum_v8_script_finalize (GObject * object)
 {
   auto self = GUM_V8_SCRIPT (object);
 
+  GumEmitData * d;
+  while ((d = (GumEmitData *) g_queue_pop_head (&self->emit_queue)) != NULL)
+    gum_v8_emit_data_free (d);
+  g_mutex_clear (&self->emit_mutex);
+
   g_free (self->name);
   g_free (self->source);
 
@@ -291,6 +333,16 @@ gum_v8_script_set_property (GObject * object,
   }
 }
 
+static gpointer
+gum_v8_script_run_streaming_task (gpointer data)
+{
+  auto task = (ScriptCompiler::ScriptStreamingTask *) data;
+
+  task->Run ();
+
+  return NULL;
+}
+
 gboolean
 gum_v8_script_create_context (GumV8Script * self,
                               GError ** error)
@@ -303,6 +355,19 @@ gum_v8_script_create_context (GumV8Script * self,
     Isolate::Scope isolate_scope (isolate);
     HandleScope handle_scope (isolate);
 
+    /*
+     * Parsing and compilation run on a worker while the globals and the
+     * context are being set up below, so on reload the isolate is only
+     * blocked for the final context binding instead of the whole parse.
+     */
+    ScriptCompiler::StreamedSource streamed_source (
+        std::make_unique<GumV8SourceStream> (self->source),
+        ScriptCompiler::StreamedSource::UTF8);
+    std::unique_ptr<ScriptCompiler::ScriptStreamingTask> streaming_task (
+        ScriptCompiler::StartStreamingScript (isolate, &streamed_source));
+    auto parse_thread = g_thread_new ("gum-v8-parse",
+        gum_v8_script_run_streaming_task, streaming_task.get ());
+
     auto global_templ = ObjectTemplate::New (isolate);
     auto platform =
         (GumV8Platform *) gum_v8_script_backend_get_platform (self->backend);
@@ -362,8 +427,12 @@ gum_v8_script_create_context (GumV8Script * self,
 
     auto source = String::NewFromUtf8 (isolate, self->source).ToLocalChecked ();
 
+    g_thread_join (parse_thread);
+    parse_thread = NULL;
+
     TryCatch trycatch (isolate);
-    auto maybe_code = Script::Compile (context, source, &origin);
+    auto maybe_code = ScriptCompiler::Compile (context, &streamed_source,
+        source, origin);
     Local<Script> code;
     if (maybe_code.ToLocal (&code))
     {
@@ -716,33 +785,55 @@ gum_v8_script_get_stalker (GumScript * script)
   return _gum_v8_stalker_get (&self->stalker);
 }
 
+/*
+ * Emitted messages are queued and flushed in one batch per main-loop
+ * tick, so a script blasting messages pays for a single source attach —
+ * and main-context wakeup — per tick instead of one per message.
+ */
 static void
 gum_v8_script_emit (GumV8Script * self,
                     const gchar * message,
                     GBytes * data)
 {
   auto d = g_slice_new (GumEmitData);
-  d->script = self;
-  g_object_ref (self);
   d->message = g_strdup (message);
   d->data = (data != NULL) ? g_bytes_ref (data) : NULL;
 
+  g_mutex_lock (&self->emit_mutex);
+  g_queue_push_tail (&self->emit_queue, d);
+  auto flush_scheduled = self->emit_flush_scheduled;
+  self->emit_flush_scheduled = TRUE;
+  g_mutex_unlock (&self->emit_mutex);
+
+  if (flush_scheduled)
+    return;
+
   auto source = g_idle_source_new ();
-  g_source_set_callback (source, (GSourceFunc) gum_v8_script_do_emit, d,
-      (GDestroyNotify) gum_v8_emit_data_free);
+  g_source_set_callback (source, (GSourceFunc) gum_v8_script_do_emit,
+      g_object_ref (self), g_object_unref);
   g_source_attach (source, self->main_context);
   g_source_unref (source);
 }
 
 static gboolean
-gum_v8_script_do_emit (GumEmitData * d)
+gum_v8_script_do_emit (GumV8Script * self)
 {
-  auto self = d->script;
+  g_mutex_lock (&self->emit_mutex);
+  auto pending = self->emit_queue;
+  g_queue_init (&self->emit_queue);
+  self->emit_flush_scheduled = FALSE;
+  g_mutex_unlock (&self->emit_mutex);
 
-  if (self->message_handler != NULL)
+  GumEmitData * d;
+  while ((d = (GumEmitData *) g_queue_pop_head (&pending)) != NULL)
   {
-    self->message_handler (GUM_SCRIPT (self), d->message, d->data,
-        self->message_handler_data);
+    if (self->message_handler != NULL)
+    {
+      self->message_handler (GUM_SCRIPT (self), d->message, d->data,
+          self->message_handler_data);
+    }
+
+    gum_v8_emit_data_free (d);
   }
 
   return FALSE;
@@ -753,7 +844,6 @@ gum_v8_emit_data_free (GumEmitData * d)
 {
   g_bytes_unref (d->data);
   g_free (d->message);
-  g_object_unref (d->script);
 
   g_slice_free (GumEmitData, d);
 }
@@ -104,6 +104,7 @@ GUMJS_DECLARE_FUNCTION (gumjs_stalker_unfollow)
 GUMJS_DECLARE_FUNCTION (gumjs_stalker_add_call_probe)
 GUMJS_DECLARE_FUNCTION (gumjs_stalker_remove_call_probe)
 GUMJS_DECLARE_FUNCTION (gumjs_stalker_parse)
+GUMJS_DECLARE_FUNCTION (gumjs_stalker_parse_columns)
 
 static void gum_v8_callback_transformer_iface_init (gpointer g_iface,
     gpointer iface_data);
@@ -205,6 +206,7 @@ static const GumV8Function gumjs_stalker_functions[] =
   { "addCallProbe", gumjs_stalker_add_call_probe },
   { "removeCallProbe", gumjs_stalker_remove_call_probe },
   { "_parse", gumjs_stalker_parse },
+  { "_parseColumns", gumjs_stalker_parse_columns },
 
   { NULL, NULL }
 };
@@ -323,6 +325,13 @@ _gum_v8_stalker_realize (GumV8Stalker * self)
   self->cached_instruction =
       _gum_v8_instruction_new_persistent (self->instruction);
   self->cached_instruction_in_use = FALSE;
+
+  {
+    auto cpu_context_value = _gum_v8_cpu_context_new_mutable (NULL, self->core);
+    self->cached_cpu_context =
+        new GumPersistent<Object>::type (isolate, cpu_context_value);
+    self->cached_cpu_context_in_use = FALSE;
+  }
 }
 
 void
@@ -392,6 +401,9 @@ _gum_v8_stalker_dispose (GumV8Stalker * self)
 {
   g_assert (self->flush_timer == NULL);
 
+  delete self->cached_cpu_context;
+  self->cached_cpu_context = nullptr;
+
   _gum_v8_instruction_release_persistent (self->cached_instruction);
   self->cached_instruction = NULL;
 
@@ -818,6 +830,101 @@ GUMJS_DEFINE_FUNCTION (gumjs_stalker_parse)
   info.GetReturnValue ().Set (rows);
 }
 
+/*
+ * Decodes a GumEvent buffer into a structure-of-arrays: one flat typed
+ * array per field, so consumers iterate plain Float64/Uint32/Int32 data
+ * instead of nested JS arrays. Block and compile events store begin in
+ * `location` and end in `target`; fields an event type lacks are zero.
+ */
+GUMJS_DEFINE_FUNCTION (gumjs_stalker_parse_columns)
+{
+  auto context = isolate->GetCurrentContext ();
+
+  Local<Value> events_value;
+  if (!_gum_v8_args_parse (args, "V", &events_value))
+    return;
+
+  if (!events_value->IsArrayBuffer ())
+  {
+    _gum_v8_throw_ascii_literal (isolate, "expected an ArrayBuffer");
+    return;
+  }
+
+  auto events_store = events_value.As<ArrayBuffer> ()->GetBackingStore ();
+  const GumEvent * events = (const GumEvent *) events_store->Data ();
+  size_t size = events_store->ByteLength ();
+  if (size % sizeof (GumEvent) != 0)
+  {
+    _gum_v8_throw_ascii_literal (isolate, "invalid buffer shape");
+    return;
+  }
+
+  size_t count = size / sizeof (GumEvent);
+
+  auto type_buf = ArrayBuffer::New (isolate, count * sizeof (uint32_t));
+  auto location_buf = ArrayBuffer::New (isolate, count * sizeof (double));
+  auto target_buf = ArrayBuffer::New (isolate, count * sizeof (double));
+  auto depth_buf = ArrayBuffer::New (isolate, count * sizeof (int32_t));
+
+  auto type_col = (uint32_t *) type_buf->GetBackingStore ()->Data ();
+  auto location_col = (double *) location_buf->GetBackingStore ()->Data ();
+  auto target_col = (double *) target_buf->GetBackingStore ()->Data ();
+  auto depth_col = (int32_t *) depth_buf->GetBackingStore ()->Data ();
+
+  const GumEvent * ev;
+  size_t i;
+  for (ev = events, i = 0; i != count; ev++, i++)
+  {
+    type_col[i] = (uint32_t) ev->type;
+
+    switch (ev->type)
+    {
+      case GUM_CALL:
+        location_col[i] = (double) GPOINTER_TO_SIZE (ev->call.location);
+        target_col[i] = (double) GPOINTER_TO_SIZE (ev->call.target);
+        depth_col[i] = ev->call.depth;
+        break;
+      case GUM_RET:
+        location_col[i] = (double) GPOINTER_TO_SIZE (ev->ret.location);
+        target_col[i] = (double) GPOINTER_TO_SIZE (ev->ret.target);
+        depth_col[i] = ev->ret.depth;
+        break;
+      case GUM_EXEC:
+        location_col[i] = (double) GPOINTER_TO_SIZE (ev->exec.location);
+        target_col[i] = 0;
+        depth_col[i] = 0;
+        break;
+      case GUM_BLOCK:
+        location_col[i] = (double) GPOINTER_TO_SIZE (ev->block.begin);
+        target_col[i] = (double) GPOINTER_TO_SIZE (ev->block.end);
+        depth_col[i] = 0;
+        break;
+      case GUM_COMPILE:
+        location_col[i] = (double) GPOINTER_TO_SIZE (ev->compile.begin);
+        target_col[i] = (double) GPOINTER_TO_SIZE (ev->compile.end);
+        depth_col[i] = 0;
+        break;
+      default:
+        _gum_v8_throw_ascii_literal (isolate, "invalid event type");
+        return;
+    }
+  }
+
+  auto result = Object::New (isolate);
+  result->Set (context, _gum_v8_string_new_ascii (isolate, "length"),
+      Number::New (isolate, (double) count)).Check ();
+  result->Set (context, _gum_v8_string_new_ascii (isolate, "type"),
+      Uint32Array::New (type_buf, 0, count)).Check ();
+  result->Set (context, _gum_v8_string_new_ascii (isolate, "location"),
+      Float64Array::New (location_buf, 0, count)).Check ();
+  result->Set (context, _gum_v8_string_new_ascii (isolate, "target"),
+      Float64Array::New (target_buf, 0, count)).Check ();
+  result->Set (context, _gum_v8_string_new_ascii (isolate, "depth"),
+      Int32Array::New (depth_buf, 0, count)).Check ();
+
+  info.GetReturnValue ().Set (result);
+}
+
 static void
 gum_v8_callback_transformer_transform_block (
     GumStalkerTransformer * transformer,
@@ -1195,7 +1302,28 @@ gum_v8_callout_on_invoke (GumCpuContext * cpu_context,
   auto isolate = core->isolate;
   auto context = isolate->GetCurrentContext ();
 
-  auto cpu_context_value = _gum_v8_cpu_context_new_mutable (cpu_context, core);
+  /*
+   * Reuse one CpuContext wrapper for the common case, so each callout only
+   * pays two internal-field stores instead of a clone plus a deferred copy
+   * of the full frame; registers are still materialized lazily on access.
+   * A context retained past the callout is detached and throws on access.
+   */
+  auto module = self->module;
+  gboolean used_cached = !module->cached_cpu_context_in_use;
+  Local<Object> cpu_context_value;
+  if (used_cached)
+  {
+    module->cached_cpu_context_in_use = TRUE;
+    cpu_context_value =
+        Local<Object>::New (isolate, *module->cached_cpu_context);
+    cpu_context_value->SetInternalField (0,
+        External::New (isolate, cpu_context));
+    cpu_context_value->SetInternalField (1, Boolean::New (isolate, true));
+  }
+  else
+  {
+    cpu_context_value = _gum_v8_cpu_context_new_mutable (cpu_context, core);
+  }
 
   auto callback (Local<Function>::New (isolate, *self->callback));
   auto recv = Undefined (isolate);
@@ -1204,8 +1332,17 @@ gum_v8_callout_on_invoke (GumCpuContext * cpu_context,
   if (result.IsEmpty ())
     scope.ProcessAnyPendingException ();
 
-  _gum_v8_cpu_context_free_later (
-      new GumPersistent<Object>::type (isolate, cpu_context_value), core);
+  if (used_cached)
+  {
+    cpu_context_value->SetInternalField (0, External::New (isolate, nullptr));
+    cpu_context_value->SetInternalField (1, Boolean::New (isolate, false));
+    module->cached_cpu_context_in_use = FALSE;
+  }
+  else
+  {
+    _gum_v8_cpu_context_free_later (
+        new GumPersistent<Object>::type (isolate, cpu_context_value), core);
+  }
 }
 
 static void
@@ -44,6 +44,9 @@ struct GumV8Stalker
 
   GumV8InstructionValue * cached_instruction;
   gboolean cached_instruction_in_use;
+
+  GumPersistent<v8::Object>::type * cached_cpu_context;
+  gboolean cached_cpu_context_in_use;
 };
 
 G_GNUC_INTERNAL void _gum_v8_stalker_init (GumV8Stalker * self,
@@ -57,6 +57,12 @@ struct GumV8ReadOperation
   gsize buffer_size;
 };
 
+struct GumV8PumpOperation
+    : public GumV8ObjectOperation<GInputStream, GumV8Stream>
+{
+  GOutputStream * output;
+};
+
 struct GumV8CloseOutputOperation
     : public GumV8ObjectOperation<GOutputStream, GumV8Stream>
 {
@@ -96,6 +102,11 @@ static void gum_v8_read_operation_dispose (GumV8ReadOperation * self);
 static void gum_v8_read_operation_start (GumV8ReadOperation * self);
 static void gum_v8_read_operation_finish (GInputStream * stream,
     GAsyncResult * result, GumV8ReadOperation * self);
+GUMJS_DECLARE_FUNCTION (gumjs_input_stream_pump)
+static void gum_v8_pump_operation_dispose (GumV8PumpOperation * self);
+static void gum_v8_pump_operation_start (GumV8PumpOperation * self);
+static void gum_v8_pump_operation_finish (GOutputStream * stream,
+    GAsyncResult * result, GumV8PumpOperation * self);
 
 GUMJS_DECLARE_CONSTRUCTOR (gumjs_output_stream_construct)
 GUMJS_DECLARE_FUNCTION (gumjs_output_stream_close)
@@ -132,6 +143,7 @@ static const GumV8Function gumjs_input_stream_functions[] =
   { "_close", gumjs_input_stream_close },
   { "_read", gumjs_input_stream_read },
   { "_readAll", gumjs_input_stream_read_all },
+  { "_pump", gumjs_input_stream_pump },
 
   { NULL, NULL }
 };
@@ -502,6 +514,74 @@ gum_v8_read_operation_finish (GInputStream * stream,
   gum_v8_object_operation_finish (self);
 }
 
+GUMJS_DEFINE_CLASS_METHOD (gumjs_input_stream_pump, GumV8InputStream)
+{
+  Local<Object> target;
+  Local<Function> callback;
+  if (!_gum_v8_args_parse (args, "OF", &target, &callback))
+    return;
+
+  auto output_stream (Local<FunctionTemplate>::New (isolate,
+      *module->output_stream));
+  if (!output_stream->HasInstance (target))
+  {
+    _gum_v8_throw_ascii_literal (isolate, "expected an OutputStream");
+    return;
+  }
+  auto output =
+      (GumV8OutputStream *) target->GetAlignedPointerFromInternalField (0);
+
+  auto op = gum_v8_object_operation_new (self, callback,
+      gum_v8_pump_operation_start, gum_v8_pump_operation_dispose);
+  op->output = (GOutputStream *) g_object_ref (output->handle);
+  gum_v8_object_operation_schedule (op);
+}
+
+static void
+gum_v8_pump_operation_dispose (GumV8PumpOperation * self)
+{
+  g_object_unref (self->output);
+}
+
+static void
+gum_v8_pump_operation_start (GumV8PumpOperation * self)
+{
+  auto stream = self->object;
+
+  g_output_stream_splice_async (self->output, stream->handle,
+      G_OUTPUT_STREAM_SPLICE_NONE, G_PRIORITY_DEFAULT, stream->cancellable,
+      (GAsyncReadyCallback) gum_v8_pump_operation_finish, self);
+}
+
+static void
+gum_v8_pump_operation_finish (GOutputStream * stream,
+                              GAsyncResult * result,
+                              GumV8PumpOperation * self)
+{
+  GError * error = NULL;
+  gssize n;
+
+  n = g_output_stream_splice_finish (stream, result, &error);
+
+  {
+    auto core = self->core;
+    ScriptScope scope (core->script);
+    auto isolate = core->isolate;
+    auto context = isolate->GetCurrentContext ();
+
+    auto error_value = _gum_v8_error_new_take_error (isolate, &error);
+    auto size_value = Number::New (isolate, (double) MAX (n, (gssize) 0));
+
+    Local<Value> argv[] = { error_value, size_value };
+    auto callback (Local<Function>::New (isolate, *self->callback));
+    auto recv = Undefined (isolate);
+    auto res = callback->Call (context, recv, G_N_ELEMENTS (argv), argv);
+    _gum_v8_ignore_result (res);
+  }
+
+  gum_v8_object_operation_finish (self);
+}
+
 GUMJS_DEFINE_CONSTRUCTOR (gumjs_output_stream_construct)
 {
   GOutputStream * stream;
@@ -1195,15 +1195,37 @@ _gum_v8_ssize_get (Local<Value> value,
   return FALSE;
 }
 
+/*
+ * Wrappers for recurring pointer values are interned in a small
+ * direct-mapped cache to keep boxing from dominating the agent's own GC
+ * load. NativePointer is a value object and its payload is only assigned
+ * here, so handing out the same wrapper twice is unobservable apart from
+ * identity.
+ */
+
 Local<Object>
 _gum_v8_native_pointer_new (gpointer address,
                             GumV8Core * core)
 {
+  auto bits = GPOINTER_TO_SIZE (address);
+  auto slot = (guint) ((bits ^ (bits >> 9)) &
+      (GUM_V8_INTERNED_POINTER_CAPACITY - 1));
+
+  auto cached = core->interned_pointer_wrappers[slot];
+  if (cached != nullptr && core->interned_pointer_values[slot] == address)
+    return Local<Object>::New (core->isolate, *cached);
+
   auto native_pointer_value (Local<Object>::New (core->isolate,
       *core->native_pointer_value));
   auto native_pointer_object (native_pointer_value->Clone ());
   native_pointer_object->SetInternalField (0,
       External::New (core->isolate, address));
+
+  delete cached;
+  core->interned_pointer_values[slot] = address;
+  core->interned_pointer_wrappers[slot] =
+      new GumPersistent<Object>::type (core->isolate, native_pointer_object);
+
   return native_pointer_object;
 }
 
@@ -41,6 +41,11 @@ Object.defineProperties(engine, {
   send: {
     enumerable: true,
     value: function (payload, data) {
+      if (typeof payload === 'string' ||
+          (typeof payload === 'object' && payload !== null)) {
+        if (engine._sendFlat(payload, data || null))
+          return;
+      }
       const message = {
         type: 'send',
         payload: payload
@@ -460,6 +465,12 @@ Object.defineProperties(Stalker, {
 
       return Stalker._parse(events, annotate, stringify);
     }
+  },
+  parseColumns: {
+    enumerable: true,
+    value: function (events) {
+      return Stalker._parseColumns(events);
+    }
   }
 });
 
@@ -471,6 +482,14 @@ Object.defineProperty(Instruction, 'parse', {
   }
 });
 
+Object.defineProperty(Instruction, 'parseBlock', {
+  enumerable: true,
+  value: function (target, limit) {
+    Memory._checkCodePointer(target);
+    return Instruction._parseBlock(target, limit);
+  }
+});
+
 makeEnumerateApi(ApiResolver.prototype, 'enumerateMatches', 1);
 
 const _closeIOStream = IOStream.prototype._close;
@@ -527,6 +546,19 @@ InputStream.prototype.readAll = function (size) {
   });
 };
 
+const _pump = InputStream.prototype._pump;
+InputStream.prototype.pump = function (output) {
+  const stream = this;
+  return new Promise(function (resolve, reject) {
+    _pump.call(stream, output, function (error, size) {
+      if (error === null)
+        resolve(size);
+      else
+        reject(error);
+    });
+  });
+};
+
 const _closeOutput = OutputStream.prototype._close;
 OutputStream.prototype.close = function () {
   const stream = this;
@@ -3,6 +3,19 @@ module.exports = hexdump;
 function hexdump(target, options) {
   options = options || {};
 
+  if (!(target instanceof ArrayBuffer) &&
+      !options.hasOwnProperty('address') &&
+      !options.hasOwnProperty('offset')) {
+    // The common case: dumping live memory. Let the native kernel format it.
+    let pointer = target;
+    if (!(pointer instanceof NativePointer))
+      pointer = pointer.handle;
+    const length = (options.length === undefined) ? 256 : options.length;
+    const showHeader = options.hasOwnProperty('header') ? options.header : true;
+    const useAnsi = options.hasOwnProperty('ansi') ? options.ansi : false;
+    return Memory.hexdump(pointer, length, showHeader, useAnsi);
+  }
+
   const startOffset = options.offset || 0;
   let length = options.length;
   const showHeader = options.hasOwnProperty('header') ? options.header : true;
@@ -46,11 +46,24 @@ namespace Gum
   {
     virtual int length () = 0;
     virtual void * nth (int n) = 0;
+    /* Direct view of the backing store: one contiguous block of `length ()`
+     * pointers, freed as a unit when the array is unreffed. */
+    virtual void * const * elements () = 0;
+  };
+
+  struct AttachSpec
+  {
+    void * function_address;
+    InvocationListener * listener;
+    void * listener_function_data;
   };
 
   struct Interceptor : public Object
   {
     virtual bool attach (void * function_address, InvocationListener * listener, void * listener_function_data = 0) = 0;
+    /* Attaches all specs inside a single transaction, so the whole batch is
+     * patched in one grouped update. Returns the number attached. */
+    virtual unsigned int attach_many (const AttachSpec * specs, unsigned int count) = 0;
     virtual void detach (InvocationListener * listener) = 0;
 
     virtual void replace (void * function_address, void * replacement_address, void * replacement_data = 0) = 0;
@@ -70,6 +83,26 @@ namespace Gum
 
   GUMPP_CAPI Interceptor * Interceptor_obtain (void);
 
+  class ScopedTransaction
+  {
+  public:
+    explicit ScopedTransaction (Interceptor * interceptor) : interceptor (interceptor)
+    {
+      interceptor->begin_transaction ();
+    }
+
+    ~ScopedTransaction ()
+    {
+      interceptor->end_transaction ();
+    }
+
+    ScopedTransaction (const ScopedTransaction &) = delete;
+    ScopedTransaction & operator= (const ScopedTransaction &) = delete;
+
+  private:
+    Interceptor * interceptor;
+  };
+
   struct InvocationContext
   {
     virtual ~InvocationContext () {}
@@ -260,6 +293,15 @@ namespace Gum
         ptr->ref ();
     }
 
+    RefPtr (RefPtr && other) noexcept : ptr (other.ptr)
+    {
+      other.ptr = 0;
+    }
+
+    template <class U> RefPtr (RefPtr<U> && other) noexcept : ptr (other.steal ())
+    {
+    }
+
     RefPtr () : ptr (0) {}
 
     bool is_null () const
@@ -274,6 +316,13 @@ namespace Gum
       return *this;
     }
 
+    RefPtr & operator = (RefPtr && other) noexcept
+    {
+      RefPtr tmp (static_cast<RefPtr &&> (other));
+      swap (*this, tmp);
+      return *this;
+    }
+
     RefPtr & operator = (T * other)
     {
       RefPtr tmp (other);
@@ -281,6 +330,13 @@ namespace Gum
       return *this;
     }
 
+    T * steal () noexcept
+    {
+      T * result = ptr;
+      ptr = 0;
+      return result;
+    }
+
     T * operator-> () const
     {
       return ptr;
@@ -324,10 +380,8 @@ namespace Gum
     static std::vector<void *> find_matching_functions (const char * str)
     {
       RefPtr<PtrArray> functions = RefPtr<PtrArray> (find_matching_functions_array (str));
-      std::vector<void *> result;
-      for (int i = functions->length () - 1; i >= 0; i--)
-        result.push_back (functions->nth (i));
-      return result;
+      void * const * elements = functions->elements ();
+      return std::vector<void *> (elements, elements + functions->length ());
     }
   };
 }
@@ -8,6 +8,7 @@
 #include <gum/gum.h>
 #include <cassert>
 #include <map>
+#include <vector>
 
 namespace Gum
 {
@@ -48,6 +49,44 @@ namespace Gum
       return (attach_ret == GUM_ATTACH_OK);
     }
 
+    virtual unsigned int attach_many (const AttachSpec * specs, unsigned int count)
+    {
+      std::vector<RefPtr<InvocationListenerProxy> > proxies;
+      proxies.reserve (count);
+
+      g_mutex_lock (&mutex);
+      for (unsigned int i = 0; i != count; i++)
+      {
+        InvocationListener * listener = specs[i].listener;
+
+        ProxyMap::iterator it = proxy_by_listener.find (listener);
+        if (it == proxy_by_listener.end ())
+        {
+          RefPtr<InvocationListenerProxy> proxy (new InvocationListenerProxy (listener));
+          proxy_by_listener[listener] = proxy;
+          proxies.push_back (proxy);
+        }
+        else
+        {
+          proxies.push_back (it->second);
+        }
+      }
+      g_mutex_unlock (&mutex);
+
+      unsigned int num_attached = 0;
+
+      gum_interceptor_begin_transaction (handle);
+      for (unsigned int i = 0; i != count; i++)
+      {
+        GumAttachReturn attach_ret = gum_interceptor_attach (handle, specs[i].function_address, GUM_INVOCATION_LISTENER (proxies[i]->get_handle ()), specs[i].listener_function_data);
+        if (attach_ret == GUM_ATTACH_OK)
+          num_attached++;
+      }
+      gum_interceptor_end_transaction (handle);
+
+      return num_attached;
+    }
+
     virtual void detach (InvocationListener * listener)
     {
       RefPtr<InvocationListenerProxy> proxy;
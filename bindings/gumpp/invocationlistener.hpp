@@ -3,6 +3,8 @@
 
 #include "gumpp.hpp"
 
+#include <gum/gum.h>
+
 namespace Gum
 {
   typedef struct _GumInvocationListenerProxy GumInvocationListenerProxy;
@@ -24,6 +26,127 @@ namespace Gum
     GumInvocationListenerProxy * cproxy;
     InvocationListener * listener;
   };
+
+  /*
+   * Plain-data view of an invocation. Accessors forward straight to the C
+   * API, so there is no wrapper object and no virtual dispatch.
+   */
+  struct InvocationArgs
+  {
+    InvocationArgs (GumInvocationContext * ic) : ic (ic) {}
+
+    void * get_function () const { return GUM_FUNCPTR_TO_POINTER (ic->function); }
+
+    template <typename T>
+    T get_nth_argument (unsigned int n) const
+    {
+      return static_cast<T> (gum_invocation_context_get_nth_argument (ic, n));
+    }
+    void * get_nth_argument_ptr (unsigned int n) const { return gum_invocation_context_get_nth_argument (ic, n); }
+    void replace_nth_argument (unsigned int n, void * value) const { gum_invocation_context_replace_nth_argument (ic, n, value); }
+
+    template <typename T>
+    T get_return_value () const
+    {
+      return static_cast<T> (gum_invocation_context_get_return_value (ic));
+    }
+    void replace_return_value (void * value) const { gum_invocation_context_replace_return_value (ic, value); }
+
+    unsigned int get_thread_id () const { return gum_invocation_context_get_thread_id (ic); }
+
+    template <typename T>
+    T * get_listener_function_data () const
+    {
+      return static_cast<T *> (gum_invocation_context_get_listener_function_data (ic));
+    }
+
+    CpuContext * get_cpu_context () const { return reinterpret_cast<CpuContext *> (ic->cpu_context); }
+
+    GumInvocationContext * ic;
+  };
+
+  /*
+   * CRTP listener that binds its callbacks at compile time: the interface
+   * thunks call straight into the derived class, so a hook hit pays no C++
+   * virtual calls and constructs no InvocationContext wrapper. Derive and
+   * shadow on_enter () and/or on_leave (); detach before destroying.
+   */
+  template <class D>
+  class StaticInvocationListener
+  {
+  public:
+    StaticInvocationListener ()
+      : chandle (g_object_new (get_type (), NULL))
+    {
+      reinterpret_cast<Instance *> (chandle)->owner = this;
+    }
+
+    ~StaticInvocationListener ()
+    {
+      g_object_unref (chandle);
+    }
+
+    bool attach_to (Interceptor * interceptor, void * function_address, void * listener_function_data = 0)
+    {
+      return gum_interceptor_attach (static_cast<GumInterceptor *> (interceptor->get_handle ()), function_address, GUM_INVOCATION_LISTENER (chandle), listener_function_data) == GUM_ATTACH_OK;
+    }
+
+    void detach_from (Interceptor * interceptor)
+    {
+      gum_interceptor_detach (static_cast<GumInterceptor *> (interceptor->get_handle ()), GUM_INVOCATION_LISTENER (chandle));
+    }
+
+    void * get_handle () const { return chandle; }
+
+    void on_enter (InvocationArgs args) {}
+    void on_leave (InvocationArgs args) {}
+
+  private:
+    struct Instance
+    {
+      GObject parent;
+      StaticInvocationListener<D> * owner;
+    };
+
+    static GType get_type ()
+    {
+      static gsize cached_type = 0;
+
+      if (g_once_init_enter (&cached_type))
+      {
+        gchar * name = g_strdup_printf ("GumppStaticInvocationListener_%p", static_cast<void *> (&cached_type));
+        GType type = g_type_register_static_simple (G_TYPE_OBJECT, g_intern_string (name), sizeof (GObjectClass), NULL, sizeof (Instance), NULL, static_cast<GTypeFlags> (0));
+        g_free (name);
+
+        const GInterfaceInfo iface_info = { init_iface, NULL, NULL };
+        g_type_add_interface_static (type, GUM_TYPE_INVOCATION_LISTENER, &iface_info);
+
+        g_once_init_leave (&cached_type, type);
+      }
+
+      return static_cast<GType> (cached_type);
+    }
+
+    static void init_iface (gpointer g_iface, gpointer iface_data)
+    {
+      GumInvocationListenerInterface * iface = static_cast<GumInvocationListenerInterface *> (g_iface);
+
+      iface->on_enter = enter_thunk;
+      iface->on_leave = leave_thunk;
+    }
+
+    static void enter_thunk (GumInvocationListener * listener, GumInvocationContext * context)
+    {
+      static_cast<D *> (reinterpret_cast<Instance *> (listener)->owner)->on_enter (InvocationArgs (context));
+    }
+
+    static void leave_thunk (GumInvocationListener * listener, GumInvocationContext * context)
+    {
+      static_cast<D *> (reinterpret_cast<Instance *> (listener)->owner)->on_leave (InvocationArgs (context));
+    }
+
+    gpointer chandle;
+  };
 }
 
 #endif
@@ -31,6 +31,11 @@ namespace Gum
     {
       return g_array_index (handle, gpointer, n);
     }
+
+    virtual void * const * elements ()
+    {
+      return reinterpret_cast<void * const *> (handle->data);
+    }
   };
 
   extern "C" void * find_function_ptr (const char * name)
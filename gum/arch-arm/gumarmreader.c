@@ -4,6 +4,8 @@
 
 #include "gumarmreader.h"
 
+#include "gumcapstone.h"
+
 static cs_insn * disassemble_instruction_at (gconstpointer address);
 
 static guint gum_rotate_right_32bit (guint val, guint rotation);
@@ -119,12 +121,14 @@ disassemble_instruction_at (gconstpointer address)
   csh capstone;
   cs_insn * insn = NULL;
 
-  cs_open (CS_ARCH_ARM, CS_MODE_ARM | CS_MODE_V8, &capstone);
+  capstone = gum_capstone_borrow (CS_ARCH_ARM, CS_MODE_ARM | CS_MODE_V8);
+  if (capstone == 0)
+    return NULL;
   cs_option (capstone, CS_OPT_DETAIL, CS_OPT_ON);
 
   cs_disasm (capstone, address, 4, GPOINTER_TO_SIZE (address), 1, &insn);
 
-  cs_close (&capstone);
+  gum_capstone_release (capstone);
 
   return insn;
 }
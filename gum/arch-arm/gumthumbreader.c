@@ -6,6 +6,8 @@
 
 #include "gumthumbreader.h"
 
+#include "gumcapstone.h"
+
 #include <capstone.h>
 
 static cs_insn * disassemble_instruction_at (gconstpointer address);
@@ -39,12 +41,14 @@ disassemble_instruction_at (gconstpointer address)
   csh capstone;
   cs_insn * insn = NULL;
 
-  cs_open (CS_ARCH_ARM, CS_MODE_THUMB | CS_MODE_V8, &capstone);
+  capstone = gum_capstone_borrow (CS_ARCH_ARM, CS_MODE_THUMB | CS_MODE_V8);
+  if (capstone == 0)
+    return NULL;
   cs_option (capstone, CS_OPT_DETAIL, CS_OPT_ON);
 
   cs_disasm (capstone, code, 16, GPOINTER_TO_SIZE (code), 1, &insn);
 
-  cs_close (&capstone);
+  gum_capstone_release (capstone);
 
   return insn;
 }
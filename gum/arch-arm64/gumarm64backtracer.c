@@ -23,6 +23,13 @@ static void gum_arm64_backtracer_dispose (GObject * object);
 static void gum_arm64_backtracer_generate (GumBacktracer * backtracer,
     const GumCpuContext * cpu_context,
     GumReturnAddressArray * return_addresses);
+static guint gum_arm64_backtracer_walk_frame_pointers (
+    GumArm64Backtracer * self, GumInvocationStack * invocation_stack,
+    const GumCpuContext * cpu_context, gsize page_size,
+    GumReturnAddressArray * return_addresses);
+static gboolean gum_arm64_backtracer_translate_return_address (
+    GumArm64Backtracer * self, GumInvocationStack * invocation_stack,
+    gsize page_size, gsize * value);
 
 static gsize gum_strip_item (gsize address);
 
@@ -89,8 +96,24 @@ gum_arm64_backtracer_generate (GumBacktracer * backtracer,
   self = GUM_ARM64_BACKTRACER (backtracer);
   invocation_stack = gum_interceptor_get_current_stack ();
 
+  page_size = gum_query_page_size ();
+
   if (cpu_context != NULL)
   {
+    /*
+     * A CPU context, e.g. one captured by Interceptor at a hook, gives us
+     * the frame pointer, so try the precise walk first and only fall back
+     * to scanning the stack when the chain is broken, e.g. due to code
+     * built with -fomit-frame-pointer.
+     */
+    i = gum_arm64_backtracer_walk_frame_pointers (self, invocation_stack,
+        cpu_context, page_size, return_addresses);
+    if (i >= 2)
+    {
+      return_addresses->len = i;
+      return;
+    }
+
     start_address = GSIZE_TO_POINTER (cpu_context->sp);
     skips_pending = 0;
   }
@@ -100,8 +123,6 @@ gum_arm64_backtracer_generate (GumBacktracer * backtracer,
     skips_pending = 1;
   }
 
-  page_size = gum_query_page_size ();
-
   for (i = 0, p = start_address; p < start_address + 2048; p++)
   {
     gboolean valid = FALSE;
@@ -174,6 +195,88 @@ gum_arm64_backtracer_generate (GumBacktracer * backtracer,
   return_addresses->len = i;
 }
 
+static guint
+gum_arm64_backtracer_walk_frame_pointers (
+    GumArm64Backtracer * self,
+    GumInvocationStack * invocation_stack,
+    const GumCpuContext * cpu_context,
+    gsize page_size,
+    GumReturnAddressArray * return_addresses)
+{
+  guint i = 0;
+  gsize * sp, * prev, * frame;
+  gsize value;
+
+  sp = GSIZE_TO_POINTER (cpu_context->sp);
+
+  value = gum_strip_item (cpu_context->lr);
+  if (gum_arm64_backtracer_translate_return_address (self, invocation_stack,
+      page_size, &value))
+  {
+    return_addresses->items[i++] = GSIZE_TO_POINTER (value);
+  }
+
+  prev = sp;
+  frame = GSIZE_TO_POINTER (gum_strip_item (cpu_context->fp));
+
+  while (i != G_N_ELEMENTS (return_addresses->items))
+  {
+    GumMemoryRange fr;
+
+    if (frame <= prev ||
+        (GPOINTER_TO_SIZE (frame) & (sizeof (gsize) - 1)) != 0)
+    {
+      break;
+    }
+
+    fr.base_address = GUM_ADDRESS (frame);
+    fr.size = 2 * sizeof (gsize);
+    if (!gum_memory_map_contains (self->writable, &fr))
+      break;
+
+    value = gum_strip_item (frame[1]);
+    if (!gum_arm64_backtracer_translate_return_address (self,
+        invocation_stack, page_size, &value))
+    {
+      break;
+    }
+
+    return_addresses->items[i++] = GSIZE_TO_POINTER (value);
+
+    prev = frame;
+    frame = GSIZE_TO_POINTER (gum_strip_item (frame[0]));
+  }
+
+  return i;
+}
+
+static gboolean
+gum_arm64_backtracer_translate_return_address (
+    GumArm64Backtracer * self,
+    GumInvocationStack * invocation_stack,
+    gsize page_size,
+    gsize * value)
+{
+  gsize translated_value;
+  GumMemoryRange vr;
+
+  translated_value = GPOINTER_TO_SIZE (gum_invocation_stack_translate (
+      invocation_stack, GSIZE_TO_POINTER (*value)));
+  if (translated_value != *value)
+  {
+    *value = translated_value;
+    return TRUE;
+  }
+
+  if (*value <= page_size + 4 || (*value & 0x3) != 0)
+    return FALSE;
+
+  vr.base_address = *value - 4;
+  vr.size = 4;
+
+  return gum_memory_map_contains (self->code, &vr);
+}
+
 static gsize
 gum_strip_item (gsize address)
 {
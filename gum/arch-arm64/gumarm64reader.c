@@ -6,6 +6,8 @@
 
 #include "gumarm64reader.h"
 
+#include "gumcapstone.h"
+
 #include <capstone.h>
 
 static cs_insn * disassemble_instruction_at (gconstpointer address);
@@ -36,12 +38,14 @@ disassemble_instruction_at (gconstpointer address)
   csh capstone;
   cs_insn * insn = NULL;
 
-  cs_open (CS_ARCH_ARM64, GUM_DEFAULT_CS_ENDIAN, &capstone);
+  capstone = gum_capstone_borrow (CS_ARCH_ARM64, GUM_DEFAULT_CS_ENDIAN);
+  if (capstone == 0)
+    return NULL;
   cs_option (capstone, CS_OPT_DETAIL, CS_OPT_ON);
 
   cs_disasm (capstone, address, 16, GPOINTER_TO_SIZE (address), 1, &insn);
 
-  cs_close (&capstone);
+  gum_capstone_release (capstone);
 
   return insn;
 }
@@ -10,9 +10,14 @@
 
 #include "gummemory.h"
 
+#include <string.h>
+
 #define GUM_MAX_INPUT_INSN_COUNT (100)
 
+#define GUM_DECODE_CACHE_SIZE 32
+
 typedef struct _GumCodeGenCtx GumCodeGenCtx;
+typedef struct _GumDecodeCacheEntry GumDecodeCacheEntry;
 
 struct _GumCodeGenCtx
 {
@@ -22,8 +27,31 @@ struct _GumCodeGenCtx
   GumArm64Writer * output;
 };
 
+/*
+ * Per-thread direct-mapped cache of decoded instructions, so repeated
+ * decodes of the same bytes — can_relocate probing followed by the actual
+ * relocation, or recompilation of a hot prologue — skip capstone entirely.
+ * Entries are validated against the raw bytes, so patched code never yields
+ * a stale decode.
+ */
+struct _GumDecodeCacheEntry
+{
+  guint64 address;
+  guint32 raw_insn;
+  gboolean occupied;
+  cs_insn insn;
+  cs_detail detail;
+};
+
 static gboolean gum_arm64_branch_is_unconditional (const cs_insn * insn);
 
+static gboolean gum_arm64_relocator_try_decode_cached (guint64 address,
+    guint32 raw_insn, cs_insn * insn);
+static void gum_arm64_relocator_cache_decode (guint32 raw_insn,
+    const cs_insn * insn);
+
+static GPrivate gum_decode_cache_key = G_PRIVATE_INIT (g_free);
+
 static gboolean gum_arm64_relocator_rewrite_ldr (GumArm64Relocator * self,
     GumCodeGenCtx * ctx);
 static gboolean gum_arm64_relocator_rewrite_adr (GumArm64Relocator * self,
@@ -156,6 +184,60 @@ gum_arm64_relocator_increment_outpos (GumArm64Relocator * self)
   g_assert (self->outpos <= self->inpos);
 }
 
+static GumDecodeCacheEntry *
+gum_arm64_relocator_get_decode_cache_entry (guint64 address)
+{
+  GumDecodeCacheEntry * cache;
+
+  cache = g_private_get (&gum_decode_cache_key);
+  if (cache == NULL)
+  {
+    cache = g_new0 (GumDecodeCacheEntry, GUM_DECODE_CACHE_SIZE);
+    g_private_set (&gum_decode_cache_key, cache);
+  }
+
+  return &cache[(address / 4) % GUM_DECODE_CACHE_SIZE];
+}
+
+static gboolean
+gum_arm64_relocator_try_decode_cached (guint64 address,
+                                       guint32 raw_insn,
+                                       cs_insn * insn)
+{
+  GumDecodeCacheEntry * entry;
+  cs_detail * detail;
+
+  entry = gum_arm64_relocator_get_decode_cache_entry (address);
+  if (!entry->occupied ||
+      entry->address != address ||
+      entry->raw_insn != raw_insn)
+  {
+    return FALSE;
+  }
+
+  detail = insn->detail;
+  memcpy (insn, &entry->insn, sizeof (cs_insn));
+  insn->detail = detail;
+  memcpy (detail, &entry->detail, sizeof (cs_detail));
+
+  return TRUE;
+}
+
+static void
+gum_arm64_relocator_cache_decode (guint32 raw_insn,
+                                  const cs_insn * insn)
+{
+  GumDecodeCacheEntry * entry;
+
+  entry = gum_arm64_relocator_get_decode_cache_entry (insn->address);
+
+  entry->address = insn->address;
+  entry->raw_insn = raw_insn;
+  entry->occupied = TRUE;
+  memcpy (&entry->insn, insn, sizeof (cs_insn));
+  memcpy (&entry->detail, insn->detail, sizeof (cs_detail));
+}
+
 guint
 gum_arm64_relocator_read_one (GumArm64Relocator * self,
                               const cs_insn ** instruction)
@@ -164,6 +246,7 @@ gum_arm64_relocator_read_one (GumArm64Relocator * self,
   const uint8_t * code;
   size_t size;
   uint64_t address;
+  guint32 raw_insn;
 
   if (self->eoi)
     return 0;
@@ -178,8 +261,15 @@ gum_arm64_relocator_read_one (GumArm64Relocator * self,
   address = self->input_pc;
   insn = *insn_ptr;
 
-  if (!cs_disasm_iter (self->capstone, &code, &size, &address, insn))
-    return 0;
+  memcpy (&raw_insn, code, sizeof (raw_insn));
+
+  if (!gum_arm64_relocator_try_decode_cached (address, raw_insn, insn))
+  {
+    if (!cs_disasm_iter (self->capstone, &code, &size, &address, insn))
+      return 0;
+
+    gum_arm64_relocator_cache_decode (raw_insn, insn);
+  }
 
   switch (insn->id)
   {
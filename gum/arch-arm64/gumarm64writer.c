@@ -1521,37 +1521,50 @@ gum_arm64_writer_maybe_commit_literals (GumArm64Writer * self)
 static void
 gum_arm64_writer_commit_literals (GumArm64Writer * self)
 {
-  guint num_refs, ref_index;
-  gint64 * first_slot, * last_slot;
+  GumArm64LiteralRef * first_ref, * last_ref, * r;
+  gint64 * first_slot, * last_slot, * last_val_slot;
+  gint64 last_val;
 
   if (!gum_arm64_writer_has_literal_refs (self))
     return;
 
-  num_refs = self->literal_refs.length;
-  if (num_refs == 0)
+  if (self->literal_refs.length == 0)
     return;
 
+  first_ref = gum_metal_array_element_at (&self->literal_refs, 0);
+  last_ref = first_ref + self->literal_refs.length;
+
   first_slot = (gint64 *) self->code;
   last_slot = first_slot;
 
-  for (ref_index = 0; ref_index != num_refs; ref_index++)
+  last_val = 0;
+  last_val_slot = NULL;
+
+  for (r = first_ref; r != last_ref; r++)
   {
-    GumArm64LiteralRef * r;
     gint64 * cur_slot, distance;
     guint32 insn;
 
-    r = gum_metal_array_element_at (&self->literal_refs, ref_index);
-
-    for (cur_slot = first_slot; cur_slot != last_slot; cur_slot++)
+    if (last_val_slot != NULL && r->val == last_val)
     {
-      if (GINT64_FROM_LE (*cur_slot) == r->val)
-        break;
+      cur_slot = last_val_slot;
     }
-
-    if (cur_slot == last_slot)
+    else
     {
-      *cur_slot = GINT64_TO_LE (r->val);
-      last_slot++;
+      for (cur_slot = first_slot; cur_slot != last_slot; cur_slot++)
+      {
+        if (GINT64_FROM_LE (*cur_slot) == r->val)
+          break;
+      }
+
+      if (cur_slot == last_slot)
+      {
+        *cur_slot = GINT64_TO_LE (r->val);
+        last_slot++;
+      }
+
+      last_val = r->val;
+      last_val_slot = cur_slot;
     }
 
     distance = (gint64) GPOINTER_TO_SIZE (cur_slot) -
@@ -23,6 +23,12 @@ static void gum_x86_backtracer_dispose (GObject * object);
 static void gum_x86_backtracer_generate (GumBacktracer * backtracer,
     const GumCpuContext * cpu_context,
     GumReturnAddressArray * return_addresses);
+static guint gum_x86_backtracer_walk_frame_pointers (GumX86Backtracer * self,
+    GumInvocationStack * invocation_stack, const GumCpuContext * cpu_context,
+    GumReturnAddressArray * return_addresses);
+static gboolean gum_x86_backtracer_translate_return_address (
+    GumX86Backtracer * self, GumInvocationStack * invocation_stack,
+    gsize * value);
 
 G_DEFINE_TYPE_EXTENDED (GumX86Backtracer,
                         gum_x86_backtracer,
@@ -90,10 +96,31 @@ gum_x86_backtracer_generate (GumBacktracer * backtracer,
   self = GUM_X86_BACKTRACER (backtracer);
   invocation_stack = gum_interceptor_get_current_stack ();
 
+  gum_memory_map_update_if_stale (self->code);
+  gum_memory_map_update_if_stale (self->writable);
+
   if (cpu_context != NULL)
+  {
+    /*
+     * A CPU context, e.g. one captured by Interceptor at a hook, gives us
+     * the frame pointer, so try the precise walk first and only fall back
+     * to scanning the stack when the chain is broken, e.g. due to code
+     * built with -fomit-frame-pointer.
+     */
+    i = gum_x86_backtracer_walk_frame_pointers (self, invocation_stack,
+        cpu_context, return_addresses);
+    if (i >= 2)
+    {
+      return_addresses->len = i;
+      return;
+    }
+
     start_address = GSIZE_TO_POINTER (GUM_CPU_CONTEXT_XSP (cpu_context));
+  }
   else
+  {
     start_address = (gsize *) &backtracer;
+  }
 
   for (i = 0, p = start_address; p < start_address + 2048; p++)
   {
@@ -153,3 +180,82 @@ gum_x86_backtracer_generate (GumBacktracer * backtracer,
 
   return_addresses->len = i;
 }
+
+static guint
+gum_x86_backtracer_walk_frame_pointers (GumX86Backtracer * self,
+                                        GumInvocationStack * invocation_stack,
+                                        const GumCpuContext * cpu_context,
+                                        GumReturnAddressArray * return_addresses)
+{
+  guint i = 0;
+  gsize * sp, * prev, * frame;
+  gsize value;
+
+  sp = GSIZE_TO_POINTER (GUM_CPU_CONTEXT_XSP (cpu_context));
+
+  value = *sp;
+  if (gum_x86_backtracer_translate_return_address (self, invocation_stack,
+      &value))
+  {
+    return_addresses->items[i++] = GSIZE_TO_POINTER (value);
+  }
+
+  prev = sp;
+  frame = GSIZE_TO_POINTER (GUM_CPU_CONTEXT_XBP (cpu_context));
+
+  while (i != G_N_ELEMENTS (return_addresses->items))
+  {
+    GumMemoryRange fr;
+
+    if (frame <= prev ||
+        (GPOINTER_TO_SIZE (frame) & (sizeof (gsize) - 1)) != 0)
+    {
+      break;
+    }
+
+    fr.base_address = GUM_ADDRESS (frame);
+    fr.size = 2 * sizeof (gsize);
+    if (!gum_memory_map_contains (self->writable, &fr))
+      break;
+
+    value = frame[1];
+    if (!gum_x86_backtracer_translate_return_address (self, invocation_stack,
+        &value))
+    {
+      break;
+    }
+
+    return_addresses->items[i++] = GSIZE_TO_POINTER (value);
+
+    prev = frame;
+    frame = GSIZE_TO_POINTER (frame[0]);
+  }
+
+  return i;
+}
+
+static gboolean
+gum_x86_backtracer_translate_return_address (
+    GumX86Backtracer * self,
+    GumInvocationStack * invocation_stack,
+    gsize * value)
+{
+  gsize translated_value;
+  GumMemoryRange vr;
+
+  translated_value = GPOINTER_TO_SIZE (gum_invocation_stack_translate (
+      invocation_stack, GSIZE_TO_POINTER (*value)));
+  if (translated_value != *value)
+  {
+    *value = translated_value;
+    return TRUE;
+  }
+
+  if (*value <= 4096 + 6)
+    return FALSE;
+
+  vr.base_address = *value - 6;
+  vr.size = 6;
+
+  return gum_memory_map_contains (self->code, &vr);
+}
@@ -6,9 +6,13 @@
 
 #include "gumx86reader.h"
 
+#include "gumcapstone.h"
+
 static gpointer try_get_relative_call_or_jump_target (gconstpointer address,
     guint call_or_jump);
 static cs_insn * disassemble_instruction_at (gconstpointer address);
+static cs_insn * disassemble_instruction_at_with_detail (gconstpointer address,
+    cs_opt_value detail);
 
 guint
 gum_x86_reader_insn_length (guint8 * code)
@@ -16,7 +20,7 @@ gum_x86_reader_insn_length (guint8 * code)
   guint result;
   cs_insn * insn;
 
-  insn = disassemble_instruction_at (code);
+  insn = disassemble_instruction_at_with_detail (code, CS_OPT_OFF);
   if (insn == NULL)
     return 0;
   result = insn->size;
@@ -120,16 +124,25 @@ try_get_relative_call_or_jump_target (gconstpointer address,
 
 static cs_insn *
 disassemble_instruction_at (gconstpointer address)
+{
+  return disassemble_instruction_at_with_detail (address, CS_OPT_ON);
+}
+
+static cs_insn *
+disassemble_instruction_at_with_detail (gconstpointer address,
+                                        cs_opt_value detail)
 {
   csh capstone;
   cs_insn * insn = NULL;
 
-  cs_open (CS_ARCH_X86, GUM_CPU_MODE, &capstone);
-  cs_option (capstone, CS_OPT_DETAIL, CS_OPT_ON);
+  capstone = gum_capstone_borrow (CS_ARCH_X86, GUM_CPU_MODE);
+  if (capstone == 0)
+    return NULL;
+  cs_option (capstone, CS_OPT_DETAIL, detail);
 
   cs_disasm (capstone, address, 16, GPOINTER_TO_SIZE (address), 1, &insn);
 
-  cs_close (&capstone);
+  gum_capstone_release (capstone);
 
   return insn;
 }
@@ -14,7 +14,10 @@
 
 #define GUM_MAX_INPUT_INSN_COUNT (100)
 
+#define GUM_DECODE_CACHE_SIZE 32
+
 typedef struct _GumCodeGenCtx GumCodeGenCtx;
+typedef struct _GumDecodeCacheEntry GumDecodeCacheEntry;
 
 struct _GumCodeGenCtx
 {
@@ -26,6 +29,23 @@ struct _GumCodeGenCtx
   GumX86Writer * code_writer;
 };
 
+/*
+ * Per-thread direct-mapped cache of decoded instructions, so repeated
+ * decodes of the same bytes — can_relocate probing followed by the actual
+ * relocation, or recompilation of a hot prologue — skip capstone entirely.
+ * Entries are validated against the raw bytes, so patched code never yields
+ * a stale decode.
+ */
+struct _GumDecodeCacheEntry
+{
+  guint64 address;
+  guint8 bytes[16];
+  guint8 length;
+  GumCpuType cpu_type;
+  cs_insn insn;
+  cs_detail detail;
+};
+
 static gboolean gum_x86_relocator_write_one_instruction (
     GumX86Relocator * self);
 static void gum_x86_relocator_put_label_for (GumX86Relocator * self,
@@ -42,6 +62,13 @@ static gboolean gum_x86_call_is_to_next_instruction (cs_insn * insn);
 static gboolean gum_x86_call_try_parse_get_pc_thunk (cs_insn * insn,
     GumCpuType cpu_type, GumCpuReg * pc_reg);
 
+static gboolean gum_x86_relocator_try_decode_cached (GumX86Relocator * self,
+    const guint8 * code, guint64 address, cs_insn * insn);
+static void gum_x86_relocator_cache_decode (GumX86Relocator * self,
+    const guint8 * code, const cs_insn * insn);
+
+static GPrivate gum_decode_cache_key = G_PRIVATE_INIT (g_free);
+
 GumX86Relocator *
 gum_x86_relocator_new (gconstpointer input_code,
                        GumX86Writer * output)
@@ -160,6 +187,64 @@ gum_x86_relocator_increment_outpos (GumX86Relocator * self)
   g_assert (self->outpos <= self->inpos);
 }
 
+static GumDecodeCacheEntry *
+gum_x86_relocator_get_decode_cache_entry (guint64 address)
+{
+  GumDecodeCacheEntry * cache;
+
+  cache = g_private_get (&gum_decode_cache_key);
+  if (cache == NULL)
+  {
+    cache = g_new0 (GumDecodeCacheEntry, GUM_DECODE_CACHE_SIZE);
+    g_private_set (&gum_decode_cache_key, cache);
+  }
+
+  return &cache[address % GUM_DECODE_CACHE_SIZE];
+}
+
+static gboolean
+gum_x86_relocator_try_decode_cached (GumX86Relocator * self,
+                                     const guint8 * code,
+                                     guint64 address,
+                                     cs_insn * insn)
+{
+  GumDecodeCacheEntry * entry;
+  cs_detail * detail;
+
+  entry = gum_x86_relocator_get_decode_cache_entry (address);
+  if (entry->length == 0 ||
+      entry->address != address ||
+      entry->cpu_type != self->output->target_cpu ||
+      memcmp (entry->bytes, code, entry->length) != 0)
+  {
+    return FALSE;
+  }
+
+  detail = insn->detail;
+  memcpy (insn, &entry->insn, sizeof (cs_insn));
+  insn->detail = detail;
+  memcpy (detail, &entry->detail, sizeof (cs_detail));
+
+  return TRUE;
+}
+
+static void
+gum_x86_relocator_cache_decode (GumX86Relocator * self,
+                                const guint8 * code,
+                                const cs_insn * insn)
+{
+  GumDecodeCacheEntry * entry;
+
+  entry = gum_x86_relocator_get_decode_cache_entry (insn->address);
+
+  entry->address = insn->address;
+  memcpy (entry->bytes, code, insn->size);
+  entry->length = insn->size;
+  entry->cpu_type = self->output->target_cpu;
+  memcpy (&entry->insn, insn, sizeof (cs_insn));
+  memcpy (&entry->detail, insn->detail, sizeof (cs_detail));
+}
+
 guint
 gum_x86_relocator_read_one (GumX86Relocator * self,
                             const cs_insn ** instruction)
@@ -182,8 +267,13 @@ gum_x86_relocator_read_one (GumX86Relocator * self,
   address = GPOINTER_TO_SIZE (self->input_cur);
   insn = *insn_ptr;
 
-  if (!cs_disasm_iter (self->capstone, &code, &size, &address, insn))
-    return 0;
+  if (!gum_x86_relocator_try_decode_cached (self, code, address, insn))
+  {
+    if (!cs_disasm_iter (self->capstone, &code, &size, &address, insn))
+      return 0;
+
+    gum_x86_relocator_cache_decode (self, self->input_cur, insn);
+  }
 
   switch (insn->id)
   {
@@ -545,6 +635,7 @@ gum_x86_relocator_rewrite_if_rip_relative (GumX86Relocator * self,
   GumCpuReg other_reg, rip_reg;
   GumAbiType target_abi = self->output->target_abi;
   guint8 code[16];
+  guint modrm_offset, disp_offset;
 
   if (x86->encoding.modrm_offset == 0)
     return FALSE;
@@ -557,6 +648,9 @@ gum_x86_relocator_rewrite_if_rip_relative (GumX86Relocator * self,
   if (!is_rip_relative)
     return FALSE;
 
+  modrm_offset = x86->encoding.modrm_offset;
+  disp_offset = x86->encoding.disp_offset;
+
   other_reg = (GumCpuReg) (GUM_REG_RAX + reg);
 
   rip_reg_index = -1;
@@ -605,10 +699,25 @@ gum_x86_relocator_rewrite_if_rip_relative (GumX86Relocator * self,
         0x08 + ((target_abi == GUM_ABI_UNIX) ? GUM_RED_ZONE_SIZE : 0),
         rip_reg);
   }
+  else if (x86->disp >= G_MININT8 && x86->disp <= G_MAXINT8)
+  {
+    guint len;
+
+    /* The displacement fits in a disp8, so shrink to the mod=1 form. */
+    gum_memcpy (code, ctx->start, disp_offset);
+    code[modrm_offset] = (1 << 6) | (reg << 3) | rm;
+    len = disp_offset;
+    code[len++] = (guint8) (gint8) x86->disp;
+    gum_memcpy (code + len, ctx->start + disp_offset + 4,
+        ctx->len - (disp_offset + 4));
+    len += ctx->len - (disp_offset + 4);
+
+    gum_x86_writer_put_bytes (ctx->code_writer, code, len);
+  }
   else
   {
     gum_memcpy (code, ctx->start, ctx->len);
-    code[x86->encoding.modrm_offset] = (mod << 6) | (reg << 3) | rm;
+    code[modrm_offset] = (mod << 6) | (reg << 3) | rm;
     gum_x86_writer_put_bytes (ctx->code_writer, code, ctx->len);
   }
 
@@ -212,7 +212,9 @@ gum_x86_writer_commit (GumX86Writer * self,
 gboolean
 gum_x86_writer_flush (GumX86Writer * self)
 {
-  guint num_refs, ref_index;
+  GumX86LabelRef * first_ref, * last_ref, * r;
+  gconstpointer last_id;
+  gpointer last_target;
 
   if (!gum_x86_writer_has_label_refs (self))
     return TRUE;
@@ -220,19 +222,30 @@ gum_x86_writer_flush (GumX86Writer * self)
   if (!gum_x86_writer_has_label_defs (self))
     return FALSE;
 
-  num_refs = self->label_refs.length;
+  first_ref = gum_metal_array_element_at (&self->label_refs, 0);
+  last_ref = first_ref + self->label_refs.length;
 
-  for (ref_index = 0; ref_index != num_refs; ref_index++)
+  last_id = NULL;
+  last_target = NULL;
+
+  for (r = first_ref; r != last_ref; r++)
   {
-    GumX86LabelRef * r;
     gpointer target_address;
     gint32 distance;
 
-    r = gum_metal_array_element_at (&self->label_refs, ref_index);
+    if (r->id == last_id)
+    {
+      target_address = last_target;
+    }
+    else
+    {
+      target_address = gum_metal_hash_table_lookup (self->label_defs, r->id);
+      if (target_address == NULL)
+        goto error;
 
-    target_address = gum_metal_hash_table_lookup (self->label_defs, r->id);
-    if (target_address == NULL)
-      goto error;
+      last_id = r->id;
+      last_target = target_address;
+    }
 
     distance = (gssize) target_address - (gssize) r->address;
 
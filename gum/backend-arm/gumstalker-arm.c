@@ -10,8 +10,10 @@
 #include "gumarmrelocator.h"
 #include "gumarmwriter.h"
 #include "gummemory.h"
+#include "gummodulemap.h"
 #include "gummetalhash.h"
 #include "gumspinlock.h"
+#include "gumstats.h"
 #include "gumthumbrelocator.h"
 #include "gumthumbwriter.h"
 #include "gumtls.h"
@@ -23,6 +25,7 @@
 
 #define GUM_CODE_SLAB_MAX_SIZE  (4 * 1024 * 1024)
 #define GUM_EXEC_BLOCK_MIN_SIZE 1024
+#define GUM_EVENT_BATCH_CAPACITY 256
 
 #define GUM_INSTRUCTION_OFFSET_NONE (-1)
 
@@ -55,6 +58,13 @@ typedef struct _GumWriteback GumWriteback;
 
 typedef gboolean (* GumCheckExcludedFunc) (GumExecCtx * ctx,
     gconstpointer address);
+typedef struct _GumEventMaskOverride GumEventMaskOverride;
+
+struct _GumEventMaskOverride
+{
+  GumMemoryRange range;
+  GumEventType mask;
+};
 
 struct _GumStalker
 {
@@ -72,7 +82,10 @@ struct _GumStalker
   GumTlsKey exec_ctx;
 
   GArray * exclusions;
+  GArray * event_mask_overrides;
   gint trust_threshold;
+  gboolean trusts_immutable_code;
+  gsize code_memory_limit;
 };
 
 struct _GumInfectContext
@@ -115,9 +128,14 @@ struct _GumExecCtx
   GumEventSink * sink;
   gboolean sink_started;
   GumEventType sink_mask;
+  GumEventType active_mask;
   gpointer last_exec_location;
   void (* sink_process_impl) (GumEventSink * self, const GumEvent * event,
       GumCpuContext * cpu_context);
+  void (* sink_process_batch_impl) (GumEventSink * self,
+      const GumEvent * events, guint n_events);
+  guint event_batch_len;
+  GumEvent event_batch[GUM_EVENT_BATCH_CAPACITY];
 
   gboolean unfollow_called_while_still_following;
   GumExecBlock * current_block;
@@ -167,6 +185,7 @@ struct _GumSlab
 enum _GumExecBlockFlags
 {
   GUM_EXEC_ACTIVATION_TARGET = (1 << 0),
+  GUM_EXEC_IMMUTABLE_SOURCE  = (1 << 1),
 };
 
 enum _GumPrologState
@@ -317,6 +336,9 @@ static void gum_stalker_freeze (GumStalker * self, gpointer code, gsize size);
 
 static void gum_exec_ctx_dispose_callouts (GumExecCtx * ctx);
 static void gum_exec_ctx_free (GumExecCtx * ctx);
+static void gum_exec_ctx_emit_event (GumExecCtx * ctx, const GumEvent * ev,
+    GumCpuContext * cpu_context);
+static void gum_exec_ctx_flush_event_batch (GumExecCtx * ctx);
 static GumSlab * gum_exec_ctx_add_slab (GumExecCtx * ctx);
 static gboolean gum_exec_ctx_maybe_unfollow (GumExecCtx * ctx,
     gpointer resume_at);
@@ -500,7 +522,10 @@ static void
 gum_stalker_init (GumStalker * self)
 {
   self->exclusions = g_array_new (FALSE, FALSE, sizeof (GumMemoryRange));
+  self->event_mask_overrides =
+      g_array_new (FALSE, FALSE, sizeof (GumEventMaskOverride));
   self->trust_threshold = 1;
+  self->trusts_immutable_code = FALSE;
 
   self->page_size = gum_query_page_size ();
   self->slab_size =
@@ -522,6 +547,7 @@ gum_stalker_finalize (GObject * object)
 {
   GumStalker * self = GUM_STALKER (object);
 
+  g_array_free (self->event_mask_overrides, TRUE);
   g_array_free (self->exclusions, TRUE);
 
   g_assert (self->contexts == NULL);
@@ -537,11 +563,108 @@ gum_stalker_new (void)
   return g_object_new (GUM_TYPE_STALKER, NULL);
 }
 
+static gint
+gum_memory_range_compare_base (gconstpointer a,
+                               gconstpointer b)
+{
+  const GumMemoryRange * range_a = a;
+  const GumMemoryRange * range_b = b;
+
+  if (range_a->base_address < range_b->base_address)
+    return -1;
+  if (range_a->base_address > range_b->base_address)
+    return 1;
+  return 0;
+}
+
+static void
+gum_stalker_coalesce_exclusions (GumStalker * self)
+{
+  GArray * exclusions = self->exclusions;
+  guint i;
+
+  g_array_sort (exclusions, gum_memory_range_compare_base);
+
+  i = 1;
+  while (i < exclusions->len)
+  {
+    GumMemoryRange * prev = &g_array_index (exclusions, GumMemoryRange, i - 1);
+    GumMemoryRange * cur = &g_array_index (exclusions, GumMemoryRange, i);
+    GumAddress prev_end = prev->base_address + prev->size;
+    GumAddress cur_end = cur->base_address + cur->size;
+
+    if (cur->base_address <= prev_end)
+    {
+      if (cur_end > prev_end)
+        prev->size = cur_end - prev->base_address;
+      g_array_remove_index (exclusions, i);
+    }
+    else
+    {
+      i++;
+    }
+  }
+}
+
 void
 gum_stalker_exclude (GumStalker * self,
                      const GumMemoryRange * range)
 {
   g_array_append_val (self->exclusions, *range);
+
+  gum_stalker_coalesce_exclusions (self);
+}
+
+void
+gum_stalker_exclude_module_map (GumStalker * self,
+                                GumModuleMap * map)
+{
+  GArray * modules = gum_module_map_get_values (map);
+  guint i;
+
+  for (i = 0; i != modules->len; i++)
+  {
+    const GumModuleDetails * d =
+        &g_array_index (modules, GumModuleDetails, i);
+
+    g_array_append_val (self->exclusions, *d->range);
+  }
+
+  gum_stalker_coalesce_exclusions (self);
+}
+
+void
+gum_stalker_set_event_mask_for_range (GumStalker * self,
+                                      const GumMemoryRange * range,
+                                      GumEventType mask)
+{
+  GumEventMaskOverride override;
+
+  override.range = *range;
+  override.mask = mask;
+
+  g_array_append_val (self->event_mask_overrides, override);
+}
+
+static GumEventType
+gum_stalker_query_sink_mask_for (GumStalker * self,
+                                 GumEventType sink_mask,
+                                 gconstpointer address)
+{
+  GArray * overrides = self->event_mask_overrides;
+  GumAddress needle = GUM_ADDRESS (address);
+  guint i;
+
+  for (i = 0; i != overrides->len; i++)
+  {
+    GumEventMaskOverride * o =
+        &g_array_index (overrides, GumEventMaskOverride, i);
+
+    if (GUM_MEMORY_RANGE_INCLUDES (&o->range, needle))
+      return o->mask;
+  }
+
+  return sink_mask;
 }
 
 static gboolean
@@ -549,7 +672,8 @@ gum_stalker_is_call_excluding (GumExecCtx * ctx,
                                gconstpointer address)
 {
   GArray * exclusions = ctx->stalker->exclusions;
-  guint i;
+  GumAddress needle = GUM_ADDRESS (address);
+  guint lower, upper;
 
   if (ctx->activation_target != NULL)
     return FALSE;
@@ -557,11 +681,18 @@ gum_stalker_is_call_excluding (GumExecCtx * ctx,
   if (gum_is_kuser_helper (address))
     return TRUE;
 
-  for (i = 0; i != exclusions->len; i++)
+  lower = 0;
+  upper = exclusions->len;
+  while (lower != upper)
   {
-    GumMemoryRange * r = &g_array_index (exclusions, GumMemoryRange, i);
+    guint middle = (lower + upper) / 2;
+    GumMemoryRange * r = &g_array_index (exclusions, GumMemoryRange, middle);
 
-    if (GUM_MEMORY_RANGE_INCLUDES (r, GUM_ADDRESS (address)))
+    if (needle < r->base_address)
+      upper = middle;
+    else if (needle >= r->base_address + r->size)
+      lower = middle + 1;
+    else
       return TRUE;
   }
 
@@ -588,6 +719,60 @@ gum_stalker_set_trust_threshold (GumStalker * self,
   self->trust_threshold = trust_threshold;
 }
 
+gboolean
+gum_stalker_get_trusts_immutable_code (GumStalker * self)
+{
+  return self->trusts_immutable_code;
+}
+
+void
+gum_stalker_set_trusts_immutable_code (GumStalker * self,
+                                       gboolean trusts_immutable_code)
+{
+  self->trusts_immutable_code = trusts_immutable_code;
+}
+
+void
+gum_stalker_set_coverage_bitmap (GumStalker * self,
+                                 guint8 * bitmap,
+                                 gsize size)
+{
+}
+
+gsize
+gum_stalker_get_code_memory_limit (GumStalker * self)
+{
+  return self->code_memory_limit;
+}
+
+void
+gum_stalker_set_code_memory_limit (GumStalker * self,
+                                   gsize limit)
+{
+  self->code_memory_limit = limit;
+}
+
+void
+gum_stalker_set_background_compilation (GumStalker * self,
+                                        gboolean enabled)
+{
+}
+
+gboolean
+gum_stalker_query_stats (GumStalker * self,
+                         GumThreadId thread_id,
+                         GumStalkerStats * stats)
+{
+  return FALSE;
+}
+
+void
+gum_stalker_prefetch (GumStalker * self,
+                      gconstpointer address,
+                      gint recycle_count)
+{
+}
+
 void
 gum_stalker_flush (GumStalker * self)
 {
@@ -600,6 +785,8 @@ gum_stalker_flush (GumStalker * self)
   {
     GumExecCtx * ctx = cur->data;
 
+    gum_exec_ctx_flush_event_batch (ctx);
+
     sinks = g_slist_prepend (sinks, g_object_ref (ctx->sink));
   }
 
@@ -998,7 +1185,11 @@ gum_stalker_create_exec_ctx (GumStalker * self,
     ctx->sink = gum_event_sink_make_default ();
 
   ctx->sink_mask = gum_event_sink_query_mask (ctx->sink);
+  ctx->active_mask = ctx->sink_mask;
   ctx->sink_process_impl = GUM_EVENT_SINK_GET_IFACE (ctx->sink)->process;
+  ctx->sink_process_batch_impl =
+      GUM_EVENT_SINK_GET_IFACE (ctx->sink)->process_batch;
+  ctx->event_batch_len = 0;
 
   ctx->frames =
       gum_memory_allocate (NULL, self->page_size, self->page_size, GUM_PAGE_RW);
@@ -1042,6 +1233,8 @@ gum_stalker_destroy_exec_ctx (GumStalker * self,
 
   if (ctx->sink_started)
   {
+    gum_exec_ctx_flush_event_batch (ctx);
+
     gum_event_sink_stop (ctx->sink);
 
     ctx->sink_started = FALSE;
@@ -1073,7 +1266,7 @@ gum_stalker_freeze (GumStalker * self,
   if (!self->is_rwx_supported)
     gum_memory_mark_code (code, size);
 
-  gum_clear_cache (code, size);
+  gum_clear_cache_schedule (code, size);
 }
 
 static void
@@ -1233,7 +1426,8 @@ gum_exec_ctx_may_now_backpatch (GumExecCtx * ctx,
   if ((target_block->flags & GUM_EXEC_ACTIVATION_TARGET) != 0)
     return FALSE;
 
-  if (target_block->recycle_count < ctx->stalker->trust_threshold)
+  if (target_block->recycle_count < ctx->stalker->trust_threshold &&
+      (target_block->flags & GUM_EXEC_IMMUTABLE_SOURCE) == 0)
     return FALSE;
 
   return TRUE;
@@ -1327,6 +1521,9 @@ gum_exec_ctx_obtain_arm_block_for (GumExecCtx * ctx,
   if (block != NULL)
     return block;
 
+  ctx->active_mask = gum_stalker_query_sink_mask_for (ctx->stalker,
+      ctx->sink_mask, real_address);
+
   block = gum_exec_block_new (ctx);
   block->real_begin = real_address;
   *code_address_ptr = block->code_begin;
@@ -1412,8 +1609,12 @@ gum_exec_ctx_obtain_thumb_block_for (GumExecCtx * ctx,
   if (block != NULL)
     return block;
 
-  block = gum_exec_block_new (ctx);
   aligned_address = gum_strip_thumb_bit (real_address);
+
+  ctx->active_mask = gum_stalker_query_sink_mask_for (ctx->stalker,
+      ctx->sink_mask, aligned_address);
+
+  block = gum_exec_block_new (ctx);
   block->real_begin = aligned_address;
   *code_address_ptr = block->code_begin + 1;
 
@@ -1787,7 +1988,7 @@ gum_stalker_iterator_handle_thumb_it_insn (GumStalkerIterator * self)
    * labels as individual instructions may need to be replaced by multiple
    * instructions as a result of relocation.
    */
-  if ((block->ctx->sink_mask & GUM_EXEC) != 0)
+  if ((block->ctx->active_mask & GUM_EXEC) != 0)
   {
     gum_exec_block_thumb_open_prolog (block, gc);
     gum_exec_block_write_thumb_exec_event_code (block, gc);
@@ -2222,6 +2423,35 @@ gum_stalker_get_writeback (const cs_insn * insn,
   }
 }
 
+static void
+gum_exec_ctx_emit_event (GumExecCtx * ctx,
+                         const GumEvent * ev,
+                         GumCpuContext * cpu_context)
+{
+  if (ctx->sink_process_batch_impl != NULL)
+  {
+    ctx->event_batch[ctx->event_batch_len++] = *ev;
+
+    if (ctx->event_batch_len == GUM_EVENT_BATCH_CAPACITY)
+      gum_exec_ctx_flush_event_batch (ctx);
+  }
+  else
+  {
+    ctx->sink_process_impl (ctx->sink, ev, cpu_context);
+  }
+}
+
+static void
+gum_exec_ctx_flush_event_batch (GumExecCtx * ctx)
+{
+  if (ctx->event_batch_len == 0)
+    return;
+
+  ctx->sink_process_batch_impl (ctx->sink, ctx->event_batch,
+      ctx->event_batch_len);
+  ctx->event_batch_len = 0;
+}
+
 static void
 gum_exec_ctx_emit_call_event (GumExecCtx * ctx,
                               gpointer location,
@@ -2239,7 +2469,7 @@ gum_exec_ctx_emit_call_event (GumExecCtx * ctx,
 
   cpu_context->pc = GPOINTER_TO_SIZE (location);
 
-  ctx->sink_process_impl (ctx->sink, &ev, cpu_context);
+  gum_exec_ctx_emit_event (ctx, &ev, cpu_context);
 }
 
 static void
@@ -2259,7 +2489,7 @@ gum_exec_ctx_emit_ret_event (GumExecCtx * ctx,
 
   cpu_context->pc = GPOINTER_TO_SIZE (location);
 
-  ctx->sink_process_impl (ctx->sink, &ev, cpu_context);
+  gum_exec_ctx_emit_event (ctx, &ev, cpu_context);
 }
 
 static void
@@ -2288,7 +2518,7 @@ gum_exec_ctx_emit_exec_event (GumExecCtx * ctx,
 
   cpu_context->pc = GPOINTER_TO_SIZE (location);
 
-  ctx->sink_process_impl (ctx->sink, &ev, cpu_context);
+  gum_exec_ctx_emit_event (ctx, &ev, cpu_context);
 }
 
 static void
@@ -2311,7 +2541,7 @@ gum_exec_ctx_emit_block_event (GumExecCtx * ctx,
 
   cpu_context->pc = GPOINTER_TO_SIZE (block->end - trailer_size);
 
-  ctx->sink_process_impl (ctx->sink, &ev, cpu_context);
+  gum_exec_ctx_emit_event (ctx, &ev, cpu_context);
 }
 
 void
@@ -2360,6 +2590,17 @@ gum_stalker_iterator_put_callout (GumStalkerIterator * self,
   gum_spinlock_release (&ec->callout_lock);
 }
 
+void
+gum_stalker_iterator_put_callout_with_flags (GumStalkerIterator * self,
+                                             GumStalkerCallout callout,
+                                             gpointer data,
+                                             GDestroyNotify data_destroy,
+                                             GumStalkerCalloutFlags flags)
+{
+  /* This backend only has one prolog flavor, so flags are just a hint. */
+  gum_stalker_iterator_put_callout (self, callout, data, data_destroy);
+}
+
 static void
 gum_stalker_invoke_callout (GumCpuContext * cpu_context,
                             GumCalloutEntry * entry)
@@ -3008,6 +3249,8 @@ gum_exec_block_new (GumExecCtx * ctx)
     gum_stalker_thaw (stalker, block->code_begin, available);
     slab->num_blocks++;
 
+    gum_stats_add (GUM_STAT_STALKER_BLOCKS_COMPILED, 1);
+
     return block;
   }
 
@@ -3059,7 +3302,8 @@ gum_exec_block_obtain_trusted (GumExecCtx * ctx,
   if (block == NULL)
     return NULL;
 
-  if (block->recycle_count >= ctx->stalker->trust_threshold ||
+  if ((block->flags & GUM_EXEC_IMMUTABLE_SOURCE) != 0 ||
+      block->recycle_count >= ctx->stalker->trust_threshold ||
       memcmp (gum_strip_thumb_bit (real_address), block->real_snapshot,
           block->real_end - block->real_begin) == 0)
   {
@@ -3091,6 +3335,13 @@ gum_exec_block_commit_and_emit (GumExecBlock * block)
   block->slab->offset += code_size;
 
   real_size = block->real_end - block->real_begin;
+
+  if (ctx->stalker->trusts_immutable_code &&
+      !gum_memory_is_writable (block->real_begin, real_size))
+  {
+    block->flags |= GUM_EXEC_IMMUTABLE_SOURCE;
+  }
+
   block->real_snapshot = block->code_end;
   memcpy (block->real_snapshot, block->real_begin, real_size);
   block->slab->offset += real_size;
@@ -3105,7 +3356,7 @@ gum_exec_block_commit_and_emit (GumExecBlock * block)
     ev.compile.begin = block->real_begin;
     ev.compile.end = block->real_end;
 
-    ctx->sink_process_impl (ctx->sink, &ev, NULL);
+    gum_exec_ctx_emit_event (ctx, &ev, NULL);
   }
 }
 
@@ -3125,16 +3376,16 @@ gum_exec_block_virtualize_arm_branch_insn (GumExecBlock * block,
   gum_exec_block_write_arm_handle_not_taken (block, target, cc, gc);
 
   should_emit_events = !gum_generator_context_is_timing_sensitive (gc) &&
-      (ec->sink_mask & (GUM_EXEC | GUM_BLOCK)) != 0;
+      (ec->active_mask & (GUM_EXEC | GUM_BLOCK)) != 0;
   if (should_emit_events)
   {
     gum_exec_block_arm_open_prolog (block, gc);
     backpatch_prolog_state = GUM_PROLOG_OPEN;
 
-    if ((ec->sink_mask & GUM_EXEC) != 0)
+    if ((ec->active_mask & GUM_EXEC) != 0)
       gum_exec_block_write_arm_exec_event_code (block, gc);
 
-    if ((ec->sink_mask & GUM_BLOCK) != 0)
+    if ((ec->active_mask & GUM_BLOCK) != 0)
       gum_exec_block_write_arm_block_event_code (block, gc);
   }
   else
@@ -3186,16 +3437,16 @@ gum_exec_block_virtualize_thumb_branch_insn (GumExecBlock * block,
   gum_exec_block_write_thumb_handle_not_taken (block, target, cc, cc_reg, gc);
 
   should_emit_events = !gum_generator_context_is_timing_sensitive (gc) &&
-      (ec->sink_mask & (GUM_EXEC | GUM_BLOCK)) != 0;
+      (ec->active_mask & (GUM_EXEC | GUM_BLOCK)) != 0;
   if (should_emit_events)
   {
     gum_exec_block_thumb_open_prolog (block, gc);
     backpatch_prolog_state = GUM_PROLOG_OPEN;
 
-    if ((ec->sink_mask & GUM_EXEC) != 0)
+    if ((ec->active_mask & GUM_EXEC) != 0)
       gum_exec_block_write_thumb_exec_event_code (block, gc);
 
-    if ((ec->sink_mask & GUM_BLOCK) != 0)
+    if ((ec->active_mask & GUM_BLOCK) != 0)
       gum_exec_block_write_thumb_block_event_code (block, gc);
   }
   else
@@ -3244,10 +3495,10 @@ gum_exec_block_virtualize_arm_call_insn (GumExecBlock * block,
 
   gum_exec_block_arm_open_prolog (block, gc);
 
-  if ((ec->sink_mask & GUM_EXEC) != 0)
+  if ((ec->active_mask & GUM_EXEC) != 0)
     gum_exec_block_write_arm_exec_event_code (block, gc);
 
-  if ((ec->sink_mask & GUM_CALL) != 0)
+  if ((ec->active_mask & GUM_CALL) != 0)
     gum_exec_block_write_arm_call_event_code (block, target, gc);
 
   gum_exec_block_write_arm_handle_excluded (block, target, TRUE, gc);
@@ -3271,10 +3522,10 @@ gum_exec_block_virtualize_thumb_call_insn (GumExecBlock * block,
 
   gum_exec_block_thumb_open_prolog (block, gc);
 
-  if ((ec->sink_mask & GUM_EXEC) != 0)
+  if ((ec->active_mask & GUM_EXEC) != 0)
     gum_exec_block_write_thumb_exec_event_code (block, gc);
 
-  if ((ec->sink_mask & GUM_CALL) != 0)
+  if ((ec->active_mask & GUM_CALL) != 0)
     gum_exec_block_write_thumb_call_event_code (block, target, gc);
 
   gum_exec_block_write_thumb_handle_excluded (block, target, TRUE, gc);
@@ -3302,12 +3553,12 @@ gum_exec_block_virtualize_arm_ret_insn (GumExecBlock * block,
 
   gum_exec_block_arm_open_prolog (block, gc);
 
-  if ((ec->sink_mask & GUM_EXEC) != 0)
+  if ((ec->active_mask & GUM_EXEC) != 0)
     gum_exec_block_write_arm_exec_event_code (block, gc);
 
   gum_exec_block_write_arm_pop_stack_frame (block, target, gc);
 
-  if ((ec->sink_mask & GUM_RET) != 0)
+  if ((ec->active_mask & GUM_RET) != 0)
     gum_exec_block_write_arm_ret_event_code (block, target, gc);
 
   gum_exec_block_write_arm_call_replace_block (block, target, gc);
@@ -3349,12 +3600,12 @@ gum_exec_block_virtualize_thumb_ret_insn (GumExecBlock * block,
 
   gum_exec_block_thumb_open_prolog (block, gc);
 
-  if ((ec->sink_mask & GUM_EXEC) != 0)
+  if ((ec->active_mask & GUM_EXEC) != 0)
     gum_exec_block_write_thumb_exec_event_code (block, gc);
 
   gum_exec_block_write_thumb_pop_stack_frame (block, target, gc);
 
-  if ((ec->sink_mask & GUM_RET) != 0)
+  if ((ec->active_mask & GUM_RET) != 0)
     gum_exec_block_write_thumb_ret_event_code (block, target, gc);
 
   gum_exec_block_write_thumb_call_replace_block (block, target, gc);
@@ -3705,7 +3956,7 @@ gum_exec_block_dont_virtualize_arm_insn (GumExecBlock * block,
 {
   GumExecCtx * ec = block->ctx;
 
-  if ((ec->sink_mask & GUM_EXEC) != 0)
+  if ((ec->active_mask & GUM_EXEC) != 0)
   {
     gum_exec_block_arm_open_prolog (block, gc);
     gum_exec_block_write_arm_exec_event_code (block, gc);
@@ -3721,7 +3972,7 @@ gum_exec_block_dont_virtualize_thumb_insn (GumExecBlock * block,
 {
   GumExecCtx * ec = block->ctx;
 
-  if ((ec->sink_mask & GUM_EXEC) != 0)
+  if ((ec->active_mask & GUM_EXEC) != 0)
   {
     gum_exec_block_thumb_open_prolog (block, gc);
     gum_exec_block_write_thumb_exec_event_code (block, gc);
@@ -3894,16 +4145,16 @@ gum_exec_block_write_arm_handle_not_taken (GumExecBlock * block,
    */
 
   should_emit_events = !gum_generator_context_is_timing_sensitive (gc) &&
-      (ec->sink_mask & (GUM_EXEC | GUM_BLOCK)) != 0;
+      (ec->active_mask & (GUM_EXEC | GUM_BLOCK)) != 0;
   if (should_emit_events)
   {
     gum_exec_block_arm_open_prolog (block, gc);
     backpatch_prolog_state = GUM_PROLOG_OPEN;
 
-    if ((ec->sink_mask & GUM_EXEC) != 0)
+    if ((ec->active_mask & GUM_EXEC) != 0)
       gum_exec_block_write_arm_exec_event_code (block, gc);
 
-    if ((ec->sink_mask & GUM_BLOCK) != 0)
+    if ((ec->active_mask & GUM_BLOCK) != 0)
       gum_exec_block_write_arm_block_event_code (block, gc);
   }
   else
@@ -3982,16 +4233,16 @@ gum_exec_block_write_thumb_handle_not_taken (GumExecBlock * block,
     guint16 * backpatch_code_start;
 
     should_emit_events = !gum_generator_context_is_timing_sensitive (gc) &&
-        (ec->sink_mask & (GUM_EXEC | GUM_BLOCK)) != 0;
+        (ec->active_mask & (GUM_EXEC | GUM_BLOCK)) != 0;
     if (should_emit_events)
     {
       gum_exec_block_thumb_open_prolog (block, gc);
       backpatch_prolog_state = GUM_PROLOG_OPEN;
 
-      if ((ec->sink_mask & GUM_EXEC) != 0)
+      if ((ec->active_mask & GUM_EXEC) != 0)
         gum_exec_block_write_thumb_exec_event_code (block, gc);
 
-      if ((ec->sink_mask & GUM_BLOCK) != 0)
+      if ((ec->active_mask & GUM_BLOCK) != 0)
         gum_exec_block_write_thumb_block_event_code (block, gc);
     }
     else
@@ -32,6 +32,7 @@ struct _GumInterceptorBackend
 
   GumCodeSlice * enter_thunk;
   GumCodeSlice * leave_thunk;
+  GumCodeSlice * probe_thunk;
 };
 
 struct _GumArm64FunctionContextData
@@ -50,6 +51,7 @@ static void gum_interceptor_backend_destroy_thunks (
 
 static void gum_emit_enter_thunk (GumArm64Writer * aw);
 static void gum_emit_leave_thunk (GumArm64Writer * aw);
+static void gum_emit_probe_thunk (GumArm64Writer * aw);
 
 static void gum_emit_prolog (GumArm64Writer * aw);
 static void gum_emit_epilog (GumArm64Writer * aw);
@@ -197,17 +199,30 @@ _gum_interceptor_backend_create_trampoline (GumInterceptorBackend * self,
     gum_arm64_writer_put_pop_reg_reg (aw, ARM64_REG_X0, ARM64_REG_LR);
   }
 
-  gum_arm64_writer_put_ldr_reg_address (aw, ARM64_REG_X17, GUM_ADDRESS (ctx));
-  gum_arm64_writer_put_ldr_reg_address (aw, ARM64_REG_X16,
-      GUM_ADDRESS (gum_sign_code_pointer (self->enter_thunk->data)));
-  gum_arm64_writer_put_br_reg (aw, ARM64_REG_X16);
-
-  ctx->on_leave_trampoline = gum_arm64_writer_cur (aw);
-
-  gum_arm64_writer_put_ldr_reg_address (aw, ARM64_REG_X17, GUM_ADDRESS (ctx));
-  gum_arm64_writer_put_ldr_reg_address (aw, ARM64_REG_X16,
-      GUM_ADDRESS (gum_sign_code_pointer (self->leave_thunk->data)));
-  gum_arm64_writer_put_br_reg (aw, ARM64_REG_X16);
+  if (ctx->probe_func != NULL)
+  {
+    gum_arm64_writer_put_ldr_reg_address (aw, ARM64_REG_X17,
+        GUM_ADDRESS (ctx));
+    gum_arm64_writer_put_ldr_reg_address (aw, ARM64_REG_X16,
+        GUM_ADDRESS (gum_sign_code_pointer (self->probe_thunk->data)));
+    gum_arm64_writer_put_br_reg (aw, ARM64_REG_X16);
+  }
+  else
+  {
+    gum_arm64_writer_put_ldr_reg_address (aw, ARM64_REG_X17,
+        GUM_ADDRESS (ctx));
+    gum_arm64_writer_put_ldr_reg_address (aw, ARM64_REG_X16,
+        GUM_ADDRESS (gum_sign_code_pointer (self->enter_thunk->data)));
+    gum_arm64_writer_put_br_reg (aw, ARM64_REG_X16);
+
+    ctx->on_leave_trampoline = gum_arm64_writer_cur (aw);
+
+    gum_arm64_writer_put_ldr_reg_address (aw, ARM64_REG_X17,
+        GUM_ADDRESS (ctx));
+    gum_arm64_writer_put_ldr_reg_address (aw, ARM64_REG_X16,
+        GUM_ADDRESS (gum_sign_code_pointer (self->leave_thunk->data)));
+    gum_arm64_writer_put_br_reg (aw, ARM64_REG_X16);
+  }
 
   gum_arm64_writer_flush (aw);
   g_assert (gum_arm64_writer_offset (aw) <= ctx->trampoline_slice->size);
@@ -428,11 +443,19 @@ gum_interceptor_backend_create_thunks (GumInterceptorBackend * self)
   gum_emit_leave_thunk (aw);
   gum_arm64_writer_flush (aw);
   g_assert (gum_arm64_writer_offset (aw) <= self->leave_thunk->size);
+
+  self->probe_thunk = gum_code_allocator_alloc_slice (self->allocator);
+  gum_arm64_writer_reset (aw, self->probe_thunk->data);
+  gum_emit_probe_thunk (aw);
+  gum_arm64_writer_flush (aw);
+  g_assert (gum_arm64_writer_offset (aw) <= self->probe_thunk->size);
 }
 
 static void
 gum_interceptor_backend_destroy_thunks (GumInterceptorBackend * self)
 {
+  gum_code_slice_free (self->probe_thunk);
+
   gum_code_slice_free (self->leave_thunk);
 
   gum_code_slice_free (self->enter_thunk);
@@ -479,6 +502,56 @@ gum_emit_leave_thunk (GumArm64Writer * aw)
   gum_emit_epilog (aw);
 }
 
+/*
+ * Probes bypass the invocation machinery: spill only the caller-saved
+ * integer registers, call the plain C function, and continue into the
+ * relocated prologue. The thunk is shared between all probes; each hook
+ * merely loads its GumFunctionContext into X17, from which the probe
+ * function, data, and the hook's on_invoke trampoline are loaded at
+ * runtime.
+ */
+static void
+gum_emit_probe_thunk (GumArm64Writer * aw)
+{
+  gum_arm64_writer_put_push_reg_reg (aw, ARM64_REG_FP, ARM64_REG_LR);
+  gum_arm64_writer_put_mov_reg_reg (aw, ARM64_REG_FP, ARM64_REG_SP);
+
+  gum_arm64_writer_put_push_reg_reg (aw, ARM64_REG_X16, ARM64_REG_X17);
+  gum_arm64_writer_put_push_reg_reg (aw, ARM64_REG_X0, ARM64_REG_X1);
+  gum_arm64_writer_put_push_reg_reg (aw, ARM64_REG_X2, ARM64_REG_X3);
+  gum_arm64_writer_put_push_reg_reg (aw, ARM64_REG_X4, ARM64_REG_X5);
+  gum_arm64_writer_put_push_reg_reg (aw, ARM64_REG_X6, ARM64_REG_X7);
+  gum_arm64_writer_put_push_reg_reg (aw, ARM64_REG_X8, ARM64_REG_X9);
+  gum_arm64_writer_put_push_reg_reg (aw, ARM64_REG_X10, ARM64_REG_X11);
+  gum_arm64_writer_put_push_reg_reg (aw, ARM64_REG_X12, ARM64_REG_X13);
+  gum_arm64_writer_put_push_reg_reg (aw, ARM64_REG_X14, ARM64_REG_X15);
+
+  gum_arm64_writer_put_mov_reg_reg (aw, ARM64_REG_X3, ARM64_REG_X2);
+  gum_arm64_writer_put_mov_reg_reg (aw, ARM64_REG_X2, ARM64_REG_X1);
+  gum_arm64_writer_put_mov_reg_reg (aw, ARM64_REG_X1, ARM64_REG_X0);
+  gum_arm64_writer_put_ldr_reg_reg_offset (aw, ARM64_REG_X0, ARM64_REG_X17,
+      G_STRUCT_OFFSET (GumFunctionContext, probe_data));
+  gum_arm64_writer_put_ldr_reg_reg_offset (aw, ARM64_REG_X16, ARM64_REG_X17,
+      G_STRUCT_OFFSET (GumFunctionContext, probe_func));
+  gum_arm64_writer_put_blr_reg (aw, ARM64_REG_X16);
+
+  gum_arm64_writer_put_pop_reg_reg (aw, ARM64_REG_X14, ARM64_REG_X15);
+  gum_arm64_writer_put_pop_reg_reg (aw, ARM64_REG_X12, ARM64_REG_X13);
+  gum_arm64_writer_put_pop_reg_reg (aw, ARM64_REG_X10, ARM64_REG_X11);
+  gum_arm64_writer_put_pop_reg_reg (aw, ARM64_REG_X8, ARM64_REG_X9);
+  gum_arm64_writer_put_pop_reg_reg (aw, ARM64_REG_X6, ARM64_REG_X7);
+  gum_arm64_writer_put_pop_reg_reg (aw, ARM64_REG_X4, ARM64_REG_X5);
+  gum_arm64_writer_put_pop_reg_reg (aw, ARM64_REG_X2, ARM64_REG_X3);
+  gum_arm64_writer_put_pop_reg_reg (aw, ARM64_REG_X0, ARM64_REG_X1);
+  gum_arm64_writer_put_pop_reg_reg (aw, ARM64_REG_X16, ARM64_REG_X17);
+
+  gum_arm64_writer_put_pop_reg_reg (aw, ARM64_REG_FP, ARM64_REG_LR);
+
+  gum_arm64_writer_put_ldr_reg_reg_offset (aw, ARM64_REG_X16, ARM64_REG_X17,
+      G_STRUCT_OFFSET (GumFunctionContext, on_invoke_trampoline));
+  gum_arm64_writer_put_br_reg (aw, ARM64_REG_X16);
+}
+
 static void
 gum_emit_prolog (GumArm64Writer * aw)
 {
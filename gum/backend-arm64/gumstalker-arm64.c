@@ -12,8 +12,10 @@
 #include "gumarm64relocator.h"
 #include "gumarm64writer.h"
 #include "gummemory.h"
+#include "gummodulemap.h"
 #include "gummetalhash.h"
 #include "gumspinlock.h"
+#include "gumstats.h"
 #include "gumtls.h"
 
 #include <stdlib.h>
@@ -23,6 +25,13 @@
 
 #define GUM_CODE_SLAB_MAX_SIZE  (4 * 1024 * 1024)
 #define GUM_EXEC_BLOCK_MIN_SIZE 1024
+#define GUM_IC_ENTRIES 4
+#define GUM_IC_MISS_THRESHOLD 8
+#define GUM_EVENT_BATCH_CAPACITY 256
+#define GUM_PROBE_FILTER_BITS 4096
+#define GUM_PROBE_FILTER_WORD_BITS (8 * sizeof (gsize))
+#define GUM_PROBE_FILTER_NUM_WORDS \
+    (GUM_PROBE_FILTER_BITS / GUM_PROBE_FILTER_WORD_BITS)
 
 #define GUM_RESTORATION_PROLOG_SIZE 4
 
@@ -35,6 +44,7 @@ typedef struct _GumInfectContext GumInfectContext;
 typedef struct _GumDisinfectContext GumDisinfectContext;
 
 typedef struct _GumCallProbe GumCallProbe;
+typedef struct _GumEventMaskOverride GumEventMaskOverride;
 typedef struct _GumSlab GumSlab;
 
 typedef struct _GumExecFrame GumExecFrame;
@@ -70,12 +80,19 @@ struct _GumStalker
   GumTlsKey exec_ctx;
 
   GArray * exclusions;
+  GArray * event_mask_overrides;
   gint trust_threshold;
+  gboolean trusts_immutable_code;
+  gsize code_memory_limit;
+  gboolean background_compilation;
+  guint8 * coverage_bitmap;
+  gsize coverage_mask;
   volatile gboolean any_probes_attached;
   volatile gint last_probe_id;
   GumSpinlock probe_lock;
   GHashTable * probe_target_by_id;
   GHashTable * probe_array_by_address;
+  volatile gsize probe_filter[GUM_PROBE_FILTER_NUM_WORDS];
 };
 
 struct _GumInfectContext
@@ -99,6 +116,12 @@ struct _GumCallProbe
   GDestroyNotify user_notify;
 };
 
+struct _GumEventMaskOverride
+{
+  GumMemoryRange range;
+  GumEventType mask;
+};
+
 struct _GumExecFrame
 {
   gpointer real_address;
@@ -132,8 +155,20 @@ struct _GumExecCtx
   GumEventSink * sink;
   gboolean sink_started;
   GumEventType sink_mask;
+  GumEventType active_mask;
   void (* sink_process_impl) (GumEventSink * self, const GumEvent * event,
       GumCpuContext * cpu_context);
+  void (* sink_process_batch_impl) (GumEventSink * self,
+      const GumEvent * events, guint n_events);
+  guint event_batch_len;
+  GumEvent event_batch[GUM_EVENT_BATCH_CAPACITY];
+  gsize coverage_prev;
+
+  GMutex compile_mutex;
+  GAsyncQueue * compile_requests;
+  GThread * compile_worker;
+
+  GumStalkerStats stats;
 
   gboolean unfollow_called_while_still_following;
   GumExecBlock * current_block;
@@ -152,6 +187,7 @@ struct _GumExecCtx
   GumAddress infect_body;
 
   GumSlab * code_slab;
+  guint64 usage_counter;
   gpointer last_prolog_minimal;
   gpointer last_epilog_minimal;
   gpointer last_prolog_full;
@@ -181,6 +217,8 @@ struct _GumSlab
   guint8 * data;
   guint offset;
   guint size;
+  guint64 last_used;
+  gboolean has_backpatch_targets;
   GumSlab * next;
 
   guint num_blocks;
@@ -190,6 +228,7 @@ struct _GumSlab
 enum _GumExecBlockFlags
 {
   GUM_EXEC_ACTIVATION_TARGET = (1 << 0),
+  GUM_EXEC_IMMUTABLE_SOURCE  = (1 << 1),
 };
 
 enum _GumPrologType
@@ -275,6 +314,13 @@ G_GNUC_INTERNAL gpointer _gum_stalker_do_deactivate (GumStalker * self,
     gpointer ret_addr);
 
 static void gum_stalker_free_probe_array (gpointer data);
+static void gum_stalker_probe_filter_compute (gpointer target_address,
+    guint * first_bit, guint * second_bit);
+static void gum_stalker_probe_filter_add (GumStalker * self,
+    gpointer target_address);
+static gboolean gum_stalker_probe_filter_may_contain (GumStalker * self,
+    gpointer target_address);
+static void gum_stalker_probe_filter_rebuild (GumStalker * self);
 
 static GumExecCtx * gum_stalker_create_exec_ctx (GumStalker * self,
     GumThreadId thread_id, GumStalkerTransformer * transformer,
@@ -288,7 +334,17 @@ static void gum_stalker_freeze (GumStalker * self, gpointer code, gsize size);
 
 static void gum_exec_ctx_dispose_callouts (GumExecCtx * ctx);
 static void gum_exec_ctx_free (GumExecCtx * ctx);
+static void gum_exec_ctx_emit_event (GumExecCtx * ctx, const GumEvent * ev,
+    GumCpuContext * cpu_context);
+static void gum_exec_ctx_flush_event_batch (GumExecCtx * ctx);
+static void gum_exec_ctx_write_coverage_code (GumExecCtx * ctx,
+    gpointer real_address, GumArm64Writer * cw);
 static GumSlab * gum_exec_ctx_add_slab (GumExecCtx * ctx);
+static void gum_exec_ctx_maybe_evict_code_slab (GumExecCtx * ctx);
+static gboolean gum_exec_ctx_slab_is_evictable (GumExecCtx * ctx,
+    GumSlab * slab);
+static gboolean gum_exec_block_is_in_slab (gpointer key, gpointer value,
+    gpointer user_data);
 static gboolean gum_exec_ctx_maybe_unfollow (GumExecCtx * ctx,
     gpointer resume_at);
 static void gum_exec_ctx_unfollow (GumExecCtx * ctx, gpointer resume_at);
@@ -301,9 +357,15 @@ static void gum_exec_ctx_end_call (GumExecCtx * ctx);
 
 static GumExecBlock * gum_exec_ctx_obtain_block_for (GumExecCtx * ctx,
     gpointer real_address, gpointer * code_address);
+static GumExecBlock * gum_exec_ctx_obtain_block_unlocked (GumExecCtx * ctx,
+    gpointer real_address, gpointer * code_address);
+static gpointer gum_exec_ctx_compile_worker (gpointer data);
+static void gum_exec_ctx_maybe_queue_for_compilation (GumExecCtx * ctx,
+    const GumBranchTarget * target);
 
 static void gum_stalker_invoke_callout (GumCpuContext * cpu_context,
     GumCalloutEntry * entry);
+static void gum_stalker_invoke_minimal_callout (GumCalloutEntry * entry);
 
 static void gum_exec_ctx_write_prolog (GumExecCtx * ctx, GumPrologType type,
     GumArm64Writer * cw);
@@ -426,7 +488,10 @@ static void
 gum_stalker_init (GumStalker * self)
 {
   self->exclusions = g_array_new (FALSE, FALSE, sizeof (GumMemoryRange));
+  self->event_mask_overrides =
+      g_array_new (FALSE, FALSE, sizeof (GumEventMaskOverride));
   self->trust_threshold = 1;
+  self->trusts_immutable_code = FALSE;
 
   gum_spinlock_init (&self->probe_lock);
   self->probe_target_by_id =
@@ -457,6 +522,7 @@ gum_stalker_finalize (GObject * object)
   g_hash_table_unref (self->probe_array_by_address);
   g_hash_table_unref (self->probe_target_by_id);
 
+  g_array_free (self->event_mask_overrides, TRUE);
   g_array_free (self->exclusions, TRUE);
 
   g_assert (self->contexts == NULL);
@@ -472,11 +538,108 @@ gum_stalker_new (void)
   return g_object_new (GUM_TYPE_STALKER, NULL);
 }
 
+static gint
+gum_memory_range_compare_base (gconstpointer a,
+                               gconstpointer b)
+{
+  const GumMemoryRange * range_a = a;
+  const GumMemoryRange * range_b = b;
+
+  if (range_a->base_address < range_b->base_address)
+    return -1;
+  if (range_a->base_address > range_b->base_address)
+    return 1;
+  return 0;
+}
+
+static void
+gum_stalker_coalesce_exclusions (GumStalker * self)
+{
+  GArray * exclusions = self->exclusions;
+  guint i;
+
+  g_array_sort (exclusions, gum_memory_range_compare_base);
+
+  i = 1;
+  while (i < exclusions->len)
+  {
+    GumMemoryRange * prev = &g_array_index (exclusions, GumMemoryRange, i - 1);
+    GumMemoryRange * cur = &g_array_index (exclusions, GumMemoryRange, i);
+    GumAddress prev_end = prev->base_address + prev->size;
+    GumAddress cur_end = cur->base_address + cur->size;
+
+    if (cur->base_address <= prev_end)
+    {
+      if (cur_end > prev_end)
+        prev->size = cur_end - prev->base_address;
+      g_array_remove_index (exclusions, i);
+    }
+    else
+    {
+      i++;
+    }
+  }
+}
+
 void
 gum_stalker_exclude (GumStalker * self,
                      const GumMemoryRange * range)
 {
   g_array_append_val (self->exclusions, *range);
+
+  gum_stalker_coalesce_exclusions (self);
+}
+
+void
+gum_stalker_exclude_module_map (GumStalker * self,
+                                GumModuleMap * map)
+{
+  GArray * modules = gum_module_map_get_values (map);
+  guint i;
+
+  for (i = 0; i != modules->len; i++)
+  {
+    const GumModuleDetails * d =
+        &g_array_index (modules, GumModuleDetails, i);
+
+    g_array_append_val (self->exclusions, *d->range);
+  }
+
+  gum_stalker_coalesce_exclusions (self);
+}
+
+void
+gum_stalker_set_event_mask_for_range (GumStalker * self,
+                                      const GumMemoryRange * range,
+                                      GumEventType mask)
+{
+  GumEventMaskOverride override;
+
+  override.range = *range;
+  override.mask = mask;
+
+  g_array_append_val (self->event_mask_overrides, override);
+}
+
+static GumEventType
+gum_stalker_query_sink_mask_for (GumStalker * self,
+                                 GumEventType sink_mask,
+                                 gconstpointer address)
+{
+  GArray * overrides = self->event_mask_overrides;
+  GumAddress needle = GUM_ADDRESS (address);
+  guint i;
+
+  for (i = 0; i != overrides->len; i++)
+  {
+    GumEventMaskOverride * o =
+        &g_array_index (overrides, GumEventMaskOverride, i);
+
+    if (GUM_MEMORY_RANGE_INCLUDES (&o->range, needle))
+      return o->mask;
+  }
+
+  return sink_mask;
 }
 
 static gboolean
@@ -484,13 +647,21 @@ gum_stalker_is_excluding (GumStalker * self,
                           gconstpointer address)
 {
   GArray * exclusions = self->exclusions;
-  guint i;
+  GumAddress needle = GUM_ADDRESS (address);
+  guint lower, upper;
 
-  for (i = 0; i != exclusions->len; i++)
+  lower = 0;
+  upper = exclusions->len;
+  while (lower != upper)
   {
-    GumMemoryRange * r = &g_array_index (exclusions, GumMemoryRange, i);
+    guint middle = (lower + upper) / 2;
+    GumMemoryRange * r = &g_array_index (exclusions, GumMemoryRange, middle);
 
-    if (GUM_MEMORY_RANGE_INCLUDES (r, GUM_ADDRESS (address)))
+    if (needle < r->base_address)
+      upper = middle;
+    else if (needle >= r->base_address + r->size)
+      lower = middle + 1;
+    else
       return TRUE;
   }
 
@@ -510,6 +681,95 @@ gum_stalker_set_trust_threshold (GumStalker * self,
   self->trust_threshold = trust_threshold;
 }
 
+gboolean
+gum_stalker_get_trusts_immutable_code (GumStalker * self)
+{
+  return self->trusts_immutable_code;
+}
+
+void
+gum_stalker_set_trusts_immutable_code (GumStalker * self,
+                                       gboolean trusts_immutable_code)
+{
+  self->trusts_immutable_code = trusts_immutable_code;
+}
+
+void
+gum_stalker_set_coverage_bitmap (GumStalker * self,
+                                 guint8 * bitmap,
+                                 gsize size)
+{
+  g_assert (bitmap == NULL || (size != 0 && (size & (size - 1)) == 0));
+
+  self->coverage_bitmap = bitmap;
+  self->coverage_mask = size - 1;
+}
+
+gsize
+gum_stalker_get_code_memory_limit (GumStalker * self)
+{
+  return self->code_memory_limit;
+}
+
+void
+gum_stalker_set_code_memory_limit (GumStalker * self,
+                                   gsize limit)
+{
+  self->code_memory_limit = limit;
+}
+
+void
+gum_stalker_set_background_compilation (GumStalker * self,
+                                        gboolean enabled)
+{
+  self->background_compilation = enabled;
+}
+
+gboolean
+gum_stalker_query_stats (GumStalker * self,
+                         GumThreadId thread_id,
+                         GumStalkerStats * stats)
+{
+  gboolean found = FALSE;
+  GSList * cur;
+
+  GUM_STALKER_LOCK (self);
+
+  for (cur = self->contexts; cur != NULL; cur = cur->next)
+  {
+    GumExecCtx * ctx = cur->data;
+
+    if (ctx->thread_id == thread_id &&
+        g_atomic_int_get (&ctx->state) == GUM_EXEC_CTX_ACTIVE)
+    {
+      *stats = ctx->stats;
+      found = TRUE;
+      break;
+    }
+  }
+
+  GUM_STALKER_UNLOCK (self);
+
+  return found;
+}
+
+void
+gum_stalker_prefetch (GumStalker * self,
+                      gconstpointer address,
+                      gint recycle_count)
+{
+  GumExecCtx * ctx;
+  GumExecBlock * block;
+  gpointer code_address;
+
+  ctx = gum_stalker_get_exec_ctx (self);
+  g_assert (ctx != NULL);
+
+  block = gum_exec_ctx_obtain_block_for (ctx, (gpointer) address,
+      &code_address);
+  block->recycle_count = recycle_count;
+}
+
 void
 gum_stalker_flush (GumStalker * self)
 {
@@ -522,6 +782,8 @@ gum_stalker_flush (GumStalker * self)
   {
     GumExecCtx * ctx = cur->data;
 
+    gum_exec_ctx_flush_event_batch (ctx);
+
     sinks = g_slist_prepend (sinks, g_object_ref (ctx->sink));
   }
 
@@ -545,6 +807,7 @@ gum_stalker_stop (GumStalker * self)
   gum_spinlock_acquire (&self->probe_lock);
   g_hash_table_remove_all (self->probe_target_by_id);
   g_hash_table_remove_all (self->probe_array_by_address);
+  gum_stalker_probe_filter_rebuild (self);
   self->any_probes_attached = FALSE;
   gum_spinlock_release (&self->probe_lock);
 
@@ -898,6 +1161,8 @@ gum_stalker_add_call_probe (GumStalker * self,
 
   g_array_append_val (probes, probe);
 
+  gum_stalker_probe_filter_add (self, target_address);
+
   self->any_probes_attached = TRUE;
 
   gum_spinlock_release (&self->probe_lock);
@@ -948,6 +1213,8 @@ gum_stalker_remove_call_probe (GumStalker * self,
     if (probes->len == 0)
       g_hash_table_remove (self->probe_array_by_address, target_address);
 
+    gum_stalker_probe_filter_rebuild (self);
+
     self->any_probes_attached =
         g_hash_table_size (self->probe_array_by_address) != 0;
   }
@@ -973,6 +1240,63 @@ gum_stalker_free_probe_array (gpointer data)
   g_array_free (probes, TRUE);
 }
 
+static void
+gum_stalker_probe_filter_compute (gpointer target_address,
+                                  guint * first_bit,
+                                  guint * second_bit)
+{
+  guint h = (guint) ((GPOINTER_TO_SIZE (target_address) >> 2) * 2654435761U);
+
+  *first_bit = h & (GUM_PROBE_FILTER_BITS - 1);
+  *second_bit = (h >> 16) & (GUM_PROBE_FILTER_BITS - 1);
+}
+
+static void
+gum_stalker_probe_filter_add (GumStalker * self,
+                              gpointer target_address)
+{
+  guint first_bit, second_bit;
+
+  gum_stalker_probe_filter_compute (target_address, &first_bit, &second_bit);
+
+  self->probe_filter[first_bit / GUM_PROBE_FILTER_WORD_BITS] |=
+      (gsize) 1 << (first_bit % GUM_PROBE_FILTER_WORD_BITS);
+  self->probe_filter[second_bit / GUM_PROBE_FILTER_WORD_BITS] |=
+      (gsize) 1 << (second_bit % GUM_PROBE_FILTER_WORD_BITS);
+}
+
+static gboolean
+gum_stalker_probe_filter_may_contain (GumStalker * self,
+                                      gpointer target_address)
+{
+  guint first_bit, second_bit;
+
+  gum_stalker_probe_filter_compute (target_address, &first_bit, &second_bit);
+
+  if ((self->probe_filter[first_bit / GUM_PROBE_FILTER_WORD_BITS] &
+      ((gsize) 1 << (first_bit % GUM_PROBE_FILTER_WORD_BITS))) == 0)
+    return FALSE;
+
+  return (self->probe_filter[second_bit / GUM_PROBE_FILTER_WORD_BITS] &
+      ((gsize) 1 << (second_bit % GUM_PROBE_FILTER_WORD_BITS))) != 0;
+}
+
+static void
+gum_stalker_probe_filter_rebuild (GumStalker * self)
+{
+  GHashTableIter iter;
+  gpointer target_address;
+  guint i;
+
+  for (i = 0; i != GUM_PROBE_FILTER_NUM_WORDS; i++)
+    self->probe_filter[i] = 0;
+
+  g_hash_table_iter_init (&iter, self->probe_array_by_address);
+  while (g_hash_table_iter_next (&iter, &target_address, NULL))
+    gum_stalker_probe_filter_add (self, target_address);
+}
+
+
 static GumExecCtx *
 gum_stalker_create_exec_ctx (GumStalker * self,
                              GumThreadId thread_id,
@@ -1006,7 +1330,12 @@ gum_stalker_create_exec_ctx (GumStalker * self,
     ctx->sink = gum_event_sink_make_default ();
 
   ctx->sink_mask = gum_event_sink_query_mask (ctx->sink);
+  ctx->active_mask = ctx->sink_mask;
   ctx->sink_process_impl = GUM_EVENT_SINK_GET_IFACE (ctx->sink)->process;
+  ctx->sink_process_batch_impl =
+      GUM_EVENT_SINK_GET_IFACE (ctx->sink)->process_batch;
+  ctx->event_batch_len = 0;
+  ctx->coverage_prev = 0;
 
   ctx->frames =
       gum_memory_allocate (NULL, self->page_size, self->page_size, GUM_PAGE_RW);
@@ -1024,6 +1353,14 @@ gum_stalker_create_exec_ctx (GumStalker * self,
 
   gum_exec_ctx_ensure_inline_helpers_reachable (ctx);
 
+  if (self->background_compilation && self->trust_threshold >= 0)
+  {
+    g_mutex_init (&ctx->compile_mutex);
+    ctx->compile_requests = g_async_queue_new ();
+    ctx->compile_worker = g_thread_new ("gum-stalker-compile",
+        gum_exec_ctx_compile_worker, ctx);
+  }
+
   return ctx;
 }
 
@@ -1043,10 +1380,23 @@ gum_stalker_destroy_exec_ctx (GumStalker * self,
   if (entry == NULL)
     return;
 
+  if (ctx->compile_worker != NULL)
+  {
+    g_async_queue_push (ctx->compile_requests, ctx);
+    g_thread_join (ctx->compile_worker);
+    ctx->compile_worker = NULL;
+
+    g_async_queue_unref (ctx->compile_requests);
+    ctx->compile_requests = NULL;
+    g_mutex_clear (&ctx->compile_mutex);
+  }
+
   gum_exec_ctx_dispose_callouts (ctx);
 
   if (ctx->sink_started)
   {
+    gum_exec_ctx_flush_event_batch (ctx);
+
     gum_event_sink_stop (ctx->sink);
 
     ctx->sink_started = FALSE;
@@ -1095,7 +1445,7 @@ gum_stalker_freeze (GumStalker * self,
   if (!self->is_rwx_supported)
     gum_memory_mark_code (code, size);
 
-  gum_clear_cache (code, size);
+  gum_clear_cache_schedule (code, size);
 }
 
 static void
@@ -1208,6 +1558,8 @@ gum_exec_ctx_add_slab (GumExecCtx * ctx)
 
   ctx->code_slab = slab;
 
+  ctx->stats.slab_bytes += stalker->slab_size;
+
   return slab;
 }
 
@@ -1275,7 +1627,8 @@ gum_exec_ctx_may_now_backpatch (GumExecCtx * ctx,
   if ((target_block->flags & GUM_EXEC_ACTIVATION_TARGET) != 0)
     return FALSE;
 
-  if (target_block->recycle_count < ctx->stalker->trust_threshold)
+  if (target_block->recycle_count < ctx->stalker->trust_threshold &&
+      (target_block->flags & GUM_EXEC_IMMUTABLE_SOURCE) == 0)
     return FALSE;
 
   return TRUE;
@@ -1299,18 +1652,33 @@ static guint total_transitions = 0;
       \
       return gum_exec_ctx_replace_current_block_with (ctx, start_address); \
     }
+#define GUM_DEFINE_INDIRECT_ENTRYGATE(name) \
+    static guint total_##name##s = 0; \
+    \
+    static gpointer GUM_THUNK \
+    GUM_ENTRYGATE (name) ( \
+        GumExecCtx * ctx, \
+        gpointer start_address) \
+    { \
+      if (counters_enabled) \
+        total_##name##s++; \
+      \
+      ctx->stats.indirect_lookups++; \
+      \
+      return gum_exec_ctx_replace_current_block_with (ctx, start_address); \
+    }
 #define GUM_PRINT_ENTRYGATE_COUNTER(name) \
     g_printerr ("\t" G_STRINGIFY (name) "s: %u\n", total_##name##s)
 
 GUM_DEFINE_ENTRYGATE (call_imm)
-GUM_DEFINE_ENTRYGATE (call_reg)
+GUM_DEFINE_INDIRECT_ENTRYGATE (call_reg)
 GUM_DEFINE_ENTRYGATE (post_call_invoke)
 GUM_DEFINE_ENTRYGATE (excluded_call_imm)
 GUM_DEFINE_ENTRYGATE (excluded_call_reg)
-GUM_DEFINE_ENTRYGATE (ret)
+GUM_DEFINE_INDIRECT_ENTRYGATE (ret)
 
 GUM_DEFINE_ENTRYGATE (jmp_imm)
-GUM_DEFINE_ENTRYGATE (jmp_reg)
+GUM_DEFINE_INDIRECT_ENTRYGATE (jmp_reg)
 
 GUM_DEFINE_ENTRYGATE (jmp_cond_cc)
 GUM_DEFINE_ENTRYGATE (jmp_cond_cbz)
@@ -1390,6 +1758,26 @@ gum_exec_ctx_obtain_block_for (GumExecCtx * ctx,
                                gpointer * code_address_ptr)
 {
   GumExecBlock * block;
+
+  if (ctx->compile_requests == NULL)
+    return gum_exec_ctx_obtain_block_unlocked (ctx, real_address,
+        code_address_ptr);
+
+  g_mutex_lock (&ctx->compile_mutex);
+  block = gum_exec_ctx_obtain_block_unlocked (ctx, real_address,
+      code_address_ptr);
+  g_mutex_unlock (&ctx->compile_mutex);
+
+  return block;
+}
+
+static GumExecBlock *
+gum_exec_ctx_obtain_block_unlocked (GumExecCtx * ctx,
+                                    gpointer real_address,
+                                    gpointer * code_address_ptr)
+{
+  GumExecBlock * block;
+  gint64 translation_started_at;
   GumArm64Writer * cw;
   GumArm64Relocator * rl;
   GumGeneratorContext gc;
@@ -1402,11 +1790,14 @@ gum_exec_ctx_obtain_block_for (GumExecCtx * ctx,
     block = gum_exec_block_obtain (ctx, real_address, code_address_ptr);
     if (block != NULL)
     {
-      if (block->recycle_count >= ctx->stalker->trust_threshold ||
+      if ((block->flags & GUM_EXEC_IMMUTABLE_SOURCE) != 0 ||
+          block->recycle_count >= ctx->stalker->trust_threshold ||
           memcmp (real_address, block->real_snapshot,
               block->real_end - block->real_begin) == 0)
       {
         block->recycle_count++;
+        block->slab->last_used = ++ctx->usage_counter;
+        ctx->stats.blocks_recycled++;
         return block;
       }
       else
@@ -1416,6 +1807,11 @@ gum_exec_ctx_obtain_block_for (GumExecCtx * ctx,
     }
   }
 
+  translation_started_at = g_get_monotonic_time ();
+
+  ctx->active_mask = gum_stalker_query_sink_mask_for (ctx->stalker,
+      ctx->sink_mask, real_address);
+
   block = gum_exec_block_new (ctx);
   block->real_begin = real_address;
   *code_address_ptr = block->code_begin;
@@ -1431,6 +1827,9 @@ gum_exec_ctx_obtain_block_for (GumExecCtx * ctx,
 
   gum_ensure_code_readable (real_address, ctx->stalker->page_size);
 
+  if (ctx->stalker->coverage_bitmap != NULL)
+    gum_exec_ctx_write_coverage_code (ctx, real_address, cw);
+
   gc.instruction = NULL;
   gc.relocator = rl;
   gc.code_writer = cw;
@@ -1480,6 +1879,10 @@ gum_exec_ctx_obtain_block_for (GumExecCtx * ctx,
 
   gum_exec_block_commit (block);
 
+  ctx->stats.blocks_compiled++;
+  ctx->stats.translation_time_us +=
+      g_get_monotonic_time () - translation_started_at;
+
   if ((ctx->sink_mask & GUM_COMPILE) != 0)
   {
     GumEvent ev;
@@ -1488,12 +1891,55 @@ gum_exec_ctx_obtain_block_for (GumExecCtx * ctx,
     ev.compile.begin = block->real_begin;
     ev.compile.end = block->real_end;
 
-    ctx->sink_process_impl (ctx->sink, &ev, NULL);
+    gum_exec_ctx_emit_event (ctx, &ev, NULL);
   }
 
   return block;
 }
 
+static gpointer
+gum_exec_ctx_compile_worker (gpointer data)
+{
+  GumExecCtx * ctx = data;
+
+  while (TRUE)
+  {
+    gpointer address, code_address;
+
+    address = g_async_queue_pop (ctx->compile_requests);
+    if (address == (gpointer) ctx)
+      break;
+
+    if (g_atomic_int_get (&ctx->state) != GUM_EXEC_CTX_ACTIVE)
+      continue;
+
+    g_mutex_lock (&ctx->compile_mutex);
+
+    if (gum_metal_hash_table_lookup (ctx->mappings, address) == NULL)
+      gum_exec_ctx_obtain_block_unlocked (ctx, address, &code_address);
+
+    g_mutex_unlock (&ctx->compile_mutex);
+  }
+
+  return NULL;
+}
+
+static void
+gum_exec_ctx_maybe_queue_for_compilation (GumExecCtx * ctx,
+                                          const GumBranchTarget * target)
+{
+  if (ctx->compile_requests == NULL)
+    return;
+
+  if (target->reg != ARM64_REG_INVALID)
+    return;
+
+  if (target->absolute_address == NULL)
+    return;
+
+  g_async_queue_push (ctx->compile_requests, target->absolute_address);
+}
+
 gboolean
 gum_stalker_iterator_next (GumStalkerIterator * self,
                            const cs_insn ** insn)
@@ -1597,13 +2043,13 @@ gum_stalker_iterator_keep (GumStalkerIterator * self)
       break;
   }
 
-  if ((ec->sink_mask & GUM_EXEC) != 0 &&
+  if ((ec->active_mask & GUM_EXEC) != 0 &&
       gc->exclusive_load_offset == GUM_INSTRUCTION_OFFSET_NONE)
   {
     gum_exec_block_write_exec_event_code (block, gc, GUM_CODE_INTERRUPTIBLE);
   }
 
-  if ((ec->sink_mask & GUM_BLOCK) != 0 &&
+  if ((ec->active_mask & GUM_BLOCK) != 0 &&
       gc->exclusive_load_offset == GUM_INSTRUCTION_OFFSET_NONE &&
       gum_arm64_relocator_eob (rl))
   {
@@ -1667,6 +2113,79 @@ gum_stalker_iterator_keep (GumStalkerIterator * self)
   self->requirements = requirements;
 }
 
+static void
+gum_exec_ctx_write_coverage_code (GumExecCtx * ctx,
+                                  gpointer real_address,
+                                  GumArm64Writer * cw)
+{
+  GumStalker * stalker = ctx->stalker;
+  gsize cur_id, next_prev;
+
+  cur_id = ((GPOINTER_TO_SIZE (real_address) >> 2) * 2654435761U) &
+      stalker->coverage_mask;
+  next_prev = cur_id >> 1;
+
+  gum_arm64_writer_put_push_reg_reg (cw, ARM64_REG_X16, ARM64_REG_X17);
+  gum_arm64_writer_put_push_reg_reg (cw, ARM64_REG_X15, ARM64_REG_X16);
+
+  gum_arm64_writer_put_ldr_reg_address (cw, ARM64_REG_X15,
+      GUM_ADDRESS (&ctx->coverage_prev));
+  gum_arm64_writer_put_ldr_reg_reg_offset (cw, ARM64_REG_X16,
+      ARM64_REG_X15, 0);
+  gum_arm64_writer_put_ldr_reg_u64 (cw, ARM64_REG_X17, cur_id);
+  /* eor x16, x16, x17 */
+  gum_arm64_writer_put_instruction (cw, 0xca110210);
+  gum_arm64_writer_put_ldr_reg_u64 (cw, ARM64_REG_X17, next_prev);
+  gum_arm64_writer_put_str_reg_reg_offset (cw, ARM64_REG_X17,
+      ARM64_REG_X15, 0);
+  gum_arm64_writer_put_ldr_reg_address (cw, ARM64_REG_X15,
+      GUM_ADDRESS (stalker->coverage_bitmap));
+  /* ldrb w17, [x15, x16] */
+  gum_arm64_writer_put_instruction (cw, 0x387069f1);
+  /* add w17, w17, #1 */
+  gum_arm64_writer_put_instruction (cw, 0x11000631);
+  /* strb w17, [x15, x16] */
+  gum_arm64_writer_put_instruction (cw, 0x383069f1);
+
+  gum_arm64_writer_put_pop_reg_reg (cw, ARM64_REG_X15, ARM64_REG_X16);
+  gum_arm64_writer_put_pop_reg_reg (cw, ARM64_REG_X16, ARM64_REG_X17);
+}
+
+static void
+gum_exec_ctx_emit_event (GumExecCtx * ctx,
+                         const GumEvent * ev,
+                         GumCpuContext * cpu_context)
+{
+  if (ctx->compile_worker != NULL && g_thread_self () == ctx->compile_worker)
+  {
+    ctx->sink_process_impl (ctx->sink, ev, cpu_context);
+    return;
+  }
+
+  if (ctx->sink_process_batch_impl != NULL)
+  {
+    ctx->event_batch[ctx->event_batch_len++] = *ev;
+
+    if (ctx->event_batch_len == GUM_EVENT_BATCH_CAPACITY)
+      gum_exec_ctx_flush_event_batch (ctx);
+  }
+  else
+  {
+    ctx->sink_process_impl (ctx->sink, ev, cpu_context);
+  }
+}
+
+static void
+gum_exec_ctx_flush_event_batch (GumExecCtx * ctx)
+{
+  if (ctx->event_batch_len == 0)
+    return;
+
+  ctx->sink_process_batch_impl (ctx->sink, ctx->event_batch,
+      ctx->event_batch_len);
+  ctx->event_batch_len = 0;
+}
+
 static void
 gum_exec_ctx_emit_call_event (GumExecCtx * ctx,
                               gpointer location,
@@ -1684,7 +2203,7 @@ gum_exec_ctx_emit_call_event (GumExecCtx * ctx,
 
   cpu_context->pc = GPOINTER_TO_SIZE (location);
 
-  ctx->sink_process_impl (ctx->sink, &ev, cpu_context);
+  gum_exec_ctx_emit_event (ctx, &ev, cpu_context);
 }
 
 static void
@@ -1704,7 +2223,7 @@ gum_exec_ctx_emit_ret_event (GumExecCtx * ctx,
 
   cpu_context->pc = GPOINTER_TO_SIZE (location);
 
-  ctx->sink_process_impl (ctx->sink, &ev, cpu_context);
+  gum_exec_ctx_emit_event (ctx, &ev, cpu_context);
 }
 
 static void
@@ -1721,7 +2240,7 @@ gum_exec_ctx_emit_exec_event (GumExecCtx * ctx,
 
   cpu_context->pc = GPOINTER_TO_SIZE (location);
 
-  ctx->sink_process_impl (ctx->sink, &ev, cpu_context);
+  gum_exec_ctx_emit_event (ctx, &ev, cpu_context);
 }
 
 static void
@@ -1741,7 +2260,7 @@ gum_exec_ctx_emit_block_event (GumExecCtx * ctx,
 
   cpu_context->pc = GPOINTER_TO_SIZE (location);
 
-  ctx->sink_process_impl (ctx->sink, &ev, cpu_context);
+  gum_exec_ctx_emit_event (ctx, &ev, cpu_context);
 }
 
 void
@@ -1749,6 +2268,17 @@ gum_stalker_iterator_put_callout (GumStalkerIterator * self,
                                   GumStalkerCallout callout,
                                   gpointer data,
                                   GDestroyNotify data_destroy)
+{
+  gum_stalker_iterator_put_callout_with_flags (self, callout, data,
+      data_destroy, GUM_STALKER_CALLOUT_DEFAULT);
+}
+
+void
+gum_stalker_iterator_put_callout_with_flags (GumStalkerIterator * self,
+                                             GumStalkerCallout callout,
+                                             gpointer data,
+                                             GDestroyNotify data_destroy,
+                                             GumStalkerCalloutFlags flags)
 {
   GumCalloutEntry * entry;
   GumExecCtx * ec = self->exec_context;
@@ -1762,12 +2292,23 @@ gum_stalker_iterator_put_callout (GumStalkerIterator * self,
   entry->pc = gc->instruction->begin;
   entry->exec_context = ec;
 
-  gum_exec_block_open_prolog (block, GUM_PROLOG_FULL, gc);
+  if ((flags & GUM_STALKER_CALLOUT_NO_CONTEXT) != 0)
+  {
+    gum_exec_block_open_prolog (block, GUM_PROLOG_MINIMAL, gc);
 
-  gum_arm64_writer_put_call_address_with_arguments (gc->code_writer,
-      GUM_ADDRESS (gum_stalker_invoke_callout), 2,
-      GUM_ARG_REGISTER, ARM64_REG_X20,
-      GUM_ARG_ADDRESS, GUM_ADDRESS (entry));
+    gum_arm64_writer_put_call_address_with_arguments (gc->code_writer,
+        GUM_ADDRESS (gum_stalker_invoke_minimal_callout), 1,
+        GUM_ARG_ADDRESS, GUM_ADDRESS (entry));
+  }
+  else
+  {
+    gum_exec_block_open_prolog (block, GUM_PROLOG_FULL, gc);
+
+    gum_arm64_writer_put_call_address_with_arguments (gc->code_writer,
+        GUM_ADDRESS (gum_stalker_invoke_callout), 2,
+        GUM_ARG_REGISTER, ARM64_REG_X20,
+        GUM_ARG_ADDRESS, GUM_ADDRESS (entry));
+  }
 
   gum_exec_block_close_prolog (block, gc);
 
@@ -1794,6 +2335,21 @@ gum_stalker_invoke_callout (GumCpuContext * cpu_context,
   gum_spinlock_release (&ec->callout_lock);
 }
 
+static void
+gum_stalker_invoke_minimal_callout (GumCalloutEntry * entry)
+{
+  GumExecCtx * ec = entry->exec_context;
+
+  gum_spinlock_acquire (&ec->callout_lock);
+
+  if (entry->callout != NULL)
+  {
+    entry->callout (NULL, entry->data);
+  }
+
+  gum_spinlock_release (&ec->callout_lock);
+}
+
 static void
 gum_exec_ctx_write_prolog (GumExecCtx * ctx,
                            GumPrologType type,
@@ -1831,6 +2387,12 @@ gum_exec_ctx_write_epilog (GumExecCtx * ctx,
 static void
 gum_exec_ctx_ensure_inline_helpers_reachable (GumExecCtx * ctx)
 {
+  /*
+   * The helpers are written back to back into the same slab, so their
+   * cache flushes merge into one.
+   */
+  gum_clear_cache_begin_batch ();
+
   gum_exec_ctx_ensure_helper_reachable (ctx, &ctx->last_prolog_minimal,
       gum_exec_ctx_write_minimal_prolog_helper);
   gum_exec_ctx_ensure_helper_reachable (ctx, &ctx->last_epilog_minimal,
@@ -1845,6 +2407,8 @@ gum_exec_ctx_ensure_inline_helpers_reachable (GumExecCtx * ctx)
       gum_exec_ctx_write_stack_push_helper);
   gum_exec_ctx_ensure_helper_reachable (ctx, &ctx->last_stack_pop_and_go,
       gum_exec_ctx_write_stack_pop_and_go_helper);
+
+  gum_clear_cache_commit_batch ();
 }
 
 static void
@@ -2321,6 +2885,10 @@ gum_exec_block_new (GumExecCtx * ctx)
     gum_stalker_thaw (stalker, block->code_begin, available);
     slab->num_blocks++;
 
+    slab->last_used = ++ctx->usage_counter;
+
+    gum_stats_add (GUM_STAT_STALKER_BLOCKS_COMPILED, 1);
+
     return block;
   }
 
@@ -2331,6 +2899,8 @@ gum_exec_block_new (GumExecCtx * ctx)
     return gum_exec_block_new (ctx);
   }
 
+  gum_exec_ctx_maybe_evict_code_slab (ctx);
+
   gum_exec_ctx_add_slab (ctx);
 
   gum_exec_ctx_ensure_inline_helpers_reachable (ctx);
@@ -2352,6 +2922,102 @@ gum_exec_block_obtain (GumExecCtx * ctx,
   return block;
 }
 
+static void
+gum_exec_ctx_maybe_evict_code_slab (GumExecCtx * ctx)
+{
+  GumStalker * stalker = ctx->stalker;
+  gsize limit = stalker->code_memory_limit;
+  gsize total;
+  GumSlab * slab, * prev, * victim, * victim_prev;
+
+  if (limit == 0 || ctx->code_slab == NULL)
+    return;
+
+  total = 0;
+  for (slab = ctx->code_slab; slab != NULL; slab = slab->next)
+    total += stalker->slab_size;
+  if (total < limit)
+    return;
+
+  victim = NULL;
+  victim_prev = NULL;
+  for (prev = ctx->code_slab, slab = prev->next; slab != NULL;
+      prev = slab, slab = slab->next)
+  {
+    if (!gum_exec_ctx_slab_is_evictable (ctx, slab))
+      continue;
+
+    if (victim == NULL || slab->last_used < victim->last_used)
+    {
+      victim = slab;
+      victim_prev = prev;
+    }
+  }
+  if (victim == NULL)
+    return;
+
+  gum_metal_hash_table_foreach_remove (ctx->mappings,
+      gum_exec_block_is_in_slab, victim);
+
+  victim_prev->next = victim->next;
+  ctx->stats.slab_bytes -= stalker->slab_size;
+  gum_memory_free (victim, stalker->slab_size);
+}
+
+static gboolean
+gum_exec_ctx_slab_is_evictable (GumExecCtx * ctx,
+                                GumSlab * slab)
+{
+  gpointer * helpers[] = {
+    &ctx->last_prolog_minimal,
+    &ctx->last_epilog_minimal,
+    &ctx->last_prolog_full,
+    &ctx->last_epilog_full,
+    &ctx->last_stack_push,
+    &ctx->last_stack_pop_and_go
+  };
+  guint i;
+  GumExecFrame * frame;
+
+  if ((guint8 *) slab == (guint8 *) ctx->thunks + ctx->stalker->page_size)
+    return FALSE;
+
+  if (slab->has_backpatch_targets)
+    return FALSE;
+
+  if (ctx->current_block != NULL && ctx->current_block->slab == slab)
+    return FALSE;
+
+  for (i = 0; i != G_N_ELEMENTS (helpers); i++)
+  {
+    guint8 * helper = *helpers[i];
+
+    if (helper >= slab->data && helper < slab->data + slab->size)
+      return FALSE;
+  }
+
+  for (frame = ctx->current_frame; frame <= ctx->first_frame; frame++)
+  {
+    guint8 * code = frame->code_address;
+
+    if (code >= slab->data && code < slab->data + slab->size)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+static gboolean
+gum_exec_block_is_in_slab (gpointer key,
+                           gpointer value,
+                           gpointer user_data)
+{
+  GumExecBlock * block = value;
+  GumSlab * slab = user_data;
+
+  return block->slab == slab;
+}
+
 static gboolean
 gum_exec_block_is_full (GumExecBlock * block)
 {
@@ -2384,6 +3050,13 @@ gum_exec_block_commit (GumExecBlock * block)
   block->slab->offset += code_size;
 
   real_size = block->real_end - block->real_begin;
+
+  if (block->ctx->stalker->trusts_immutable_code &&
+      !gum_memory_is_writable (block->real_begin, real_size))
+  {
+    block->flags |= GUM_EXEC_IMMUTABLE_SOURCE;
+  }
+
   block->real_snapshot = block->code_end;
   memcpy (block->real_snapshot, block->real_begin, real_size);
   block->slab->offset += real_size;
@@ -2410,11 +3083,16 @@ gum_exec_block_backpatch_call (GumExecBlock * block,
   ctx = block->ctx;
   stalker = ctx->stalker;
 
+  if (ctx->compile_requests != NULL)
+    g_mutex_lock (&ctx->compile_mutex);
+
   if (gum_exec_ctx_may_now_backpatch (ctx, block))
   {
     GumArm64Writer * cw = &ctx->code_writer;
     const gsize code_max_size = ret_code_address - code_start;
 
+    block->slab->has_backpatch_targets = TRUE;
+
     gum_stalker_thaw (stalker, code_start, code_max_size);
     gum_arm64_writer_reset (cw, code_start);
 
@@ -2455,6 +3133,9 @@ gum_exec_block_backpatch_call (GumExecBlock * block,
     g_assert (gum_arm64_writer_offset (cw) <= code_max_size);
     gum_stalker_freeze (stalker, code_start, code_max_size);
   }
+
+  if (ctx->compile_requests != NULL)
+    g_mutex_unlock (&ctx->compile_mutex);
 }
 
 static void
@@ -2476,10 +3157,15 @@ gum_exec_block_backpatch_jmp (GumExecBlock * block,
   cw = &ctx->code_writer;
   stalker = ctx->stalker;
 
+  if (ctx->compile_requests != NULL)
+    g_mutex_lock (&ctx->compile_mutex);
+
   if (gum_exec_ctx_may_now_backpatch (ctx, block))
   {
     const gsize code_max_size = 128;
 
+    block->slab->has_backpatch_targets = TRUE;
+
     gum_stalker_thaw (stalker, code_start, code_max_size);
     gum_arm64_writer_reset (cw, code_start);
 
@@ -2494,6 +3180,9 @@ gum_exec_block_backpatch_jmp (GumExecBlock * block,
     g_assert (gum_arm64_writer_offset (cw) <= code_max_size);
     gum_stalker_freeze (stalker, code_start, code_max_size);
   }
+
+  if (ctx->compile_requests != NULL)
+    g_mutex_unlock (&ctx->compile_mutex);
 }
 
 static void
@@ -2514,10 +3203,15 @@ gum_exec_block_backpatch_ret (GumExecBlock * block,
   cw = &ctx->code_writer;
   stalker = ctx->stalker;
 
+  if (ctx->compile_requests != NULL)
+    g_mutex_lock (&ctx->compile_mutex);
+
   if (gum_exec_ctx_may_now_backpatch (ctx, block))
   {
     const gsize code_max_size = 128;
 
+    block->slab->has_backpatch_targets = TRUE;
+
     gum_stalker_thaw (stalker, code_start, code_max_size);
     gum_arm64_writer_reset (cw, code_start);
 
@@ -2531,6 +3225,9 @@ gum_exec_block_backpatch_ret (GumExecBlock * block,
     g_assert (gum_arm64_writer_offset (cw) <= code_max_size);
     gum_stalker_freeze (stalker, code_start, code_max_size);
   }
+
+  if (ctx->compile_requests != NULL)
+    g_mutex_unlock (&ctx->compile_mutex);
 }
 
 static void
@@ -2548,24 +3245,62 @@ gum_exec_block_backpatch_inline_cache (GumExecBlock * block,
   ctx = block->ctx;
   stalker = ctx->stalker;
 
+  if (ctx->compile_requests != NULL)
+    g_mutex_lock (&ctx->compile_mutex);
+
   if (gum_exec_ctx_may_now_backpatch (ctx, block))
   {
-    guint offset;
+    const gsize ic_size = ((2 * GUM_IC_ENTRIES) + 1) * sizeof (gpointer);
+    gsize * num_misses;
+    guint i;
 
-    offset = (ic_entries[0] == NULL) ? 0 : 2;
+    block->slab->has_backpatch_targets = TRUE;
 
-    if (ic_entries[offset + 0] == NULL)
+    for (i = 0; i != GUM_IC_ENTRIES; i++)
     {
-      const gsize ic_slot_size = 2 * sizeof (gpointer);
+      if (ic_entries[(2 * i) + 0] == block->real_begin)
+        goto beach;
+
+      if (ic_entries[(2 * i) + 0] == NULL)
+      {
+        gum_stalker_thaw (stalker, ic_entries, ic_size);
+
+        ic_entries[(2 * i) + 1] = block->code_begin;
+        ic_entries[(2 * i) + 0] = block->real_begin;
+
+        gum_stalker_freeze (stalker, ic_entries, ic_size);
+        goto beach;
+      }
+    }
 
-      gum_stalker_thaw (stalker, ic_entries + offset, ic_slot_size);
+    /*
+     * The cache is full and we are still missing: tolerate a few misses, then
+     * evict the oldest entry so the working set can rotate in.
+     */
+    gum_stalker_thaw (stalker, ic_entries, ic_size);
 
-      ic_entries[offset + 0] = block->real_begin;
-      ic_entries[offset + 1] = block->code_begin;
+    num_misses = (gsize *) &ic_entries[2 * GUM_IC_ENTRIES];
+    (*num_misses)++;
+    if (*num_misses >= GUM_IC_MISS_THRESHOLD)
+    {
+      *num_misses = 0;
 
-      gum_stalker_freeze (stalker, ic_entries + offset, ic_slot_size);
+      for (i = 0; i != GUM_IC_ENTRIES - 1; i++)
+      {
+        ic_entries[(2 * i) + 0] = ic_entries[(2 * (i + 1)) + 0];
+        ic_entries[(2 * i) + 1] = ic_entries[(2 * (i + 1)) + 1];
+      }
+
+      ic_entries[(2 * (GUM_IC_ENTRIES - 1)) + 0] = block->real_begin;
+      ic_entries[(2 * (GUM_IC_ENTRIES - 1)) + 1] = block->code_begin;
     }
+
+    gum_stalker_freeze (stalker, ic_entries, ic_size);
   }
+
+beach:
+  if (ctx->compile_requests != NULL)
+    g_mutex_unlock (&ctx->compile_mutex);
 }
 
 static GumVirtualizationRequirements
@@ -2756,7 +3491,7 @@ gum_exec_block_virtualize_branch_insn (GumExecBlock * block,
     {
       gboolean target_is_excluded = FALSE;
 
-      if ((ctx->sink_mask & GUM_CALL) != 0)
+      if ((ctx->active_mask & GUM_CALL) != 0)
       {
         gum_exec_block_write_call_event_code (block, &target, gc,
             GUM_CODE_INTERRUPTIBLE);
@@ -2822,7 +3557,7 @@ gum_exec_block_virtualize_ret_insn (GumExecBlock * block,
   cs_arm64_op * op;
   arm64_reg ret_reg;
 
-  if ((block->ctx->sink_mask & GUM_RET) != 0)
+  if ((block->ctx->active_mask & GUM_RET) != 0)
     gum_exec_block_write_ret_event_code (block, gc, GUM_CODE_INTERRUPTIBLE);
 
   insn = gc->instruction;
@@ -2934,7 +3669,6 @@ gum_exec_block_write_call_invoke_code (GumExecBlock * block,
   GumPrologType second_prolog;
   GumExecCtxReplaceCurrentBlockFunc entry_func;
   gconstpointer perform_stack_push = cw->code + 1;
-  gconstpointer try_second = cw->code + 2;
   gconstpointer jump_to_cached = cw->code + 3;
   gconstpointer resolve_dynamically = cw->code + 4;
   gconstpointer keep_this_blr = cw->code + 5;
@@ -2943,14 +3677,18 @@ gum_exec_block_write_call_invoke_code (GumExecBlock * block,
   call_code_start = cw->code;
   opened_prolog = gc->opened_prolog;
 
+  gum_exec_ctx_maybe_queue_for_compilation (ctx, target);
+
   can_backpatch_statically = (stalker->trust_threshold >= 0 &&
       target->reg == ARM64_REG_INVALID);
 
   if (stalker->trust_threshold >= 0 && target->reg != ARM64_REG_INVALID)
   {
     arm64_reg call_target_reg, candidate_reg;
-    guint ic1_real_ref, ic1_code_ref;
-    guint ic2_real_ref, ic2_code_ref;
+    guint ic_real_refs[GUM_IC_ENTRIES], ic_code_refs[GUM_IC_ENTRIES];
+    const guint32 * ic_label_id_base;
+    const guint64 empty_slot = 0;
+    guint i;
 
     if (opened_prolog == GUM_PROLOG_NONE)
     {
@@ -3001,27 +3739,33 @@ gum_exec_block_write_call_invoke_code (GumExecBlock * block,
     if ((stalker->cpu_features & GUM_CPU_PTRAUTH) != 0)
       gum_arm64_writer_put_xpaci_reg (cw, call_target_reg);
 
-    ic1_real_ref = gum_arm64_writer_put_ldr_reg_ref (cw, candidate_reg);
-    gum_arm64_writer_put_sub_reg_reg_reg (cw, candidate_reg, candidate_reg,
-        call_target_reg);
-    gum_arm64_writer_put_cbnz_reg_label (cw, candidate_reg, try_second);
-    ic1_code_ref = gum_arm64_writer_put_ldr_reg_ref (cw, candidate_reg);
-    gum_arm64_writer_put_b_label (cw, jump_to_cached);
-
-    gum_arm64_writer_put_label (cw, try_second);
-    ic2_real_ref = gum_arm64_writer_put_ldr_reg_ref (cw, candidate_reg);
-    gum_arm64_writer_put_sub_reg_reg_reg (cw, candidate_reg, candidate_reg,
-        call_target_reg);
-    gum_arm64_writer_put_cbnz_reg_label (cw, candidate_reg,
-        resolve_dynamically);
-    ic2_code_ref = gum_arm64_writer_put_ldr_reg_ref (cw, candidate_reg);
-    gum_arm64_writer_put_b_label (cw, jump_to_cached);
+    ic_label_id_base = cw->code;
+
+    for (i = 0; i != GUM_IC_ENTRIES; i++)
+    {
+      gconstpointer try_next = (i != GUM_IC_ENTRIES - 1)
+          ? (gconstpointer) (ic_label_id_base + i + 1)
+          : resolve_dynamically;
+
+      if (i != 0)
+        gum_arm64_writer_put_label (cw, ic_label_id_base + i);
+
+      ic_real_refs[i] = gum_arm64_writer_put_ldr_reg_ref (cw, candidate_reg);
+      gum_arm64_writer_put_sub_reg_reg_reg (cw, candidate_reg, candidate_reg,
+          call_target_reg);
+      gum_arm64_writer_put_cbnz_reg_label (cw, candidate_reg, try_next);
+      ic_code_refs[i] = gum_arm64_writer_put_ldr_reg_ref (cw, candidate_reg);
+      gum_arm64_writer_put_b_label (cw, jump_to_cached);
+    }
 
     ic_entries = gum_arm64_writer_cur (cw);
-    gum_arm64_writer_put_ldr_reg_value (cw, ic1_real_ref, 0);
-    gum_arm64_writer_put_ldr_reg_value (cw, ic1_code_ref, 0);
-    gum_arm64_writer_put_ldr_reg_value (cw, ic2_real_ref, 0);
-    gum_arm64_writer_put_ldr_reg_value (cw, ic2_code_ref, 0);
+    for (i = 0; i != GUM_IC_ENTRIES; i++)
+    {
+      gum_arm64_writer_put_ldr_reg_value (cw, ic_real_refs[i], 0);
+      gum_arm64_writer_put_ldr_reg_value (cw, ic_code_refs[i], 0);
+    }
+    gum_arm64_writer_put_bytes (cw, (const guint8 *) &empty_slot,
+        sizeof (empty_slot));
 
     gum_arm64_writer_put_label (cw, jump_to_cached);
     ic_load_real_address_ref =
@@ -3201,13 +3945,16 @@ gum_exec_block_write_jmp_transfer_code (GumExecBlock * block,
   GumPrologType opened_prolog = gc->opened_prolog;
   gpointer * ic_entries = NULL;
 
+  gum_exec_ctx_maybe_queue_for_compilation (block->ctx, target);
+
   if (stalker->trust_threshold >= 0 && target->reg != ARM64_REG_INVALID)
   {
-    gconstpointer try_second = cw->code + 1;
     gconstpointer resolve_dynamically = cw->code + 2;
     arm64_reg jmp_target_reg, candidate_reg;
-    guint ic1_real_ref, ic1_code_ref;
-    guint ic2_real_ref, ic2_code_ref;
+    guint ic_real_refs[GUM_IC_ENTRIES], ic_code_refs[GUM_IC_ENTRIES];
+    const guint32 * ic_label_id_base;
+    const guint64 empty_slot = 0;
+    guint i;
 
     if (opened_prolog != GUM_PROLOG_NONE)
       gum_exec_block_close_prolog (block, gc);
@@ -3234,29 +3981,34 @@ gum_exec_block_write_jmp_transfer_code (GumExecBlock * block,
     if ((stalker->cpu_features & GUM_CPU_PTRAUTH) != 0)
       gum_arm64_writer_put_xpaci_reg (cw, jmp_target_reg);
 
-    ic1_real_ref = gum_arm64_writer_put_ldr_reg_ref (cw, candidate_reg);
-    gum_arm64_writer_put_sub_reg_reg_reg (cw, candidate_reg, candidate_reg,
-        jmp_target_reg);
-    gum_arm64_writer_put_cbnz_reg_label (cw, candidate_reg, try_second);
-    ic1_code_ref = gum_arm64_writer_put_ldr_reg_ref (cw, candidate_reg);
-    gum_arm64_writer_put_pop_reg_reg (cw, ARM64_REG_X0, ARM64_REG_X1);
-    gum_arm64_writer_put_br_reg_no_auth (cw, candidate_reg);
+    ic_label_id_base = cw->code;
 
-    gum_arm64_writer_put_label (cw, try_second);
-    ic2_real_ref = gum_arm64_writer_put_ldr_reg_ref (cw, candidate_reg);
-    gum_arm64_writer_put_sub_reg_reg_reg (cw, candidate_reg, candidate_reg,
-        jmp_target_reg);
-    gum_arm64_writer_put_cbnz_reg_label (cw, candidate_reg,
-        resolve_dynamically);
-    ic2_code_ref = gum_arm64_writer_put_ldr_reg_ref (cw, candidate_reg);
-    gum_arm64_writer_put_pop_reg_reg (cw, ARM64_REG_X0, ARM64_REG_X1);
-    gum_arm64_writer_put_br_reg_no_auth (cw, candidate_reg);
+    for (i = 0; i != GUM_IC_ENTRIES; i++)
+    {
+      gconstpointer try_next = (i != GUM_IC_ENTRIES - 1)
+          ? (gconstpointer) (ic_label_id_base + i + 1)
+          : resolve_dynamically;
+
+      if (i != 0)
+        gum_arm64_writer_put_label (cw, ic_label_id_base + i);
+
+      ic_real_refs[i] = gum_arm64_writer_put_ldr_reg_ref (cw, candidate_reg);
+      gum_arm64_writer_put_sub_reg_reg_reg (cw, candidate_reg, candidate_reg,
+          jmp_target_reg);
+      gum_arm64_writer_put_cbnz_reg_label (cw, candidate_reg, try_next);
+      ic_code_refs[i] = gum_arm64_writer_put_ldr_reg_ref (cw, candidate_reg);
+      gum_arm64_writer_put_pop_reg_reg (cw, ARM64_REG_X0, ARM64_REG_X1);
+      gum_arm64_writer_put_br_reg_no_auth (cw, candidate_reg);
+    }
 
     ic_entries = gum_arm64_writer_cur (cw);
-    gum_arm64_writer_put_ldr_reg_value (cw, ic1_real_ref, 0);
-    gum_arm64_writer_put_ldr_reg_value (cw, ic1_code_ref, 0);
-    gum_arm64_writer_put_ldr_reg_value (cw, ic2_real_ref, 0);
-    gum_arm64_writer_put_ldr_reg_value (cw, ic2_code_ref, 0);
+    for (i = 0; i != GUM_IC_ENTRIES; i++)
+    {
+      gum_arm64_writer_put_ldr_reg_value (cw, ic_real_refs[i], 0);
+      gum_arm64_writer_put_ldr_reg_value (cw, ic_code_refs[i], 0);
+    }
+    gum_arm64_writer_put_bytes (cw, (const guint8 *) &empty_slot,
+        sizeof (empty_slot));
 
     gum_arm64_writer_put_label (cw, resolve_dynamically);
     gum_arm64_writer_put_pop_reg_reg (cw, ARM64_REG_X0, ARM64_REG_X1);
@@ -3526,10 +4278,18 @@ gum_exec_block_write_call_probe_code (GumExecBlock * block,
   {
     GumStalker * stalker = block->ctx->stalker;
 
-    gum_spinlock_acquire (&stalker->probe_lock);
-    skip_probing = g_hash_table_lookup (stalker->probe_array_by_address,
-        target->absolute_address) == NULL;
-    gum_spinlock_release (&stalker->probe_lock);
+    if (!gum_stalker_probe_filter_may_contain (stalker,
+        target->absolute_address))
+    {
+      skip_probing = TRUE;
+    }
+    else
+    {
+      gum_spinlock_acquire (&stalker->probe_lock);
+      skip_probing = g_hash_table_lookup (stalker->probe_array_by_address,
+          target->absolute_address) == NULL;
+      gum_spinlock_release (&stalker->probe_lock);
+    }
   }
 
   if (!skip_probing)
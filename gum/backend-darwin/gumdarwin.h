@@ -100,6 +100,9 @@ GUM_API guint8 * gum_darwin_read (mach_port_t task, GumAddress address,
     gsize len, gsize * n_bytes_read);
 GUM_API gboolean gum_darwin_write (mach_port_t task, GumAddress address,
     const guint8 * bytes, gsize len);
+GUM_API void gum_darwin_scan (mach_port_t task, const GumMemoryRange * range,
+    const GumMatchPattern * pattern, GumMemoryScanMatchFunc func,
+    gpointer user_data);
 GUM_API gboolean gum_darwin_cpu_type_from_pid (pid_t pid,
     GumCpuType * cpu_type);
 GUM_API gboolean gum_darwin_query_ptrauth_support (mach_port_t task,
@@ -75,6 +75,7 @@ struct _GumDarwinMapper
 
   GSList * children;
   GHashTable * mappings;
+  GHashTable * cached_symbols;
 };
 
 enum
@@ -159,6 +160,11 @@ static GumDarwinMapping * gum_darwin_mapper_get_dependency_by_name (
 static gboolean gum_darwin_mapper_resolve_symbol (GumDarwinMapper * self,
     GumDarwinModule * module, const gchar * symbol,
     GumDarwinSymbolValue * value);
+static gboolean gum_darwin_mapper_do_resolve_symbol (GumDarwinMapper * self,
+    GumDarwinModule * module, const gchar * symbol,
+    GumDarwinSymbolValue * value);
+static gboolean gum_darwin_mapper_symbol_is_atexit (const gchar * name);
+static void gum_darwin_symbol_value_free (GumDarwinSymbolValue * value);
 static GumDarwinMapping * gum_darwin_mapper_add_existing_mapping (
     GumDarwinMapper * self, GumDarwinModule * module);
 static GumDarwinMapping * gum_darwin_mapper_add_pending_mapping (
@@ -287,6 +293,11 @@ gum_darwin_mapper_constructed (GObject * object)
 
     gum_darwin_mapper_add_pending_mapping (parent, self->name, self);
   }
+  else
+  {
+    self->cached_symbols = g_hash_table_new_full (NULL, NULL, NULL,
+        (GDestroyNotify) g_hash_table_unref);
+  }
 }
 
 static gboolean
@@ -307,6 +318,7 @@ gum_darwin_mapper_finalize (GObject * object)
 {
   GumDarwinMapper * self = GUM_DARWIN_MAPPER (object);
 
+  g_clear_pointer (&self->cached_symbols, g_hash_table_unref);
   g_clear_pointer (&self->mappings, g_hash_table_unref);
   g_slist_free_full (self->children, g_object_unref);
 
@@ -1781,18 +1793,77 @@ gum_darwin_mapper_resolve_symbol (GumDarwinMapper * self,
                                   const gchar * name,
                                   GumDarwinSymbolValue * value)
 {
-  GumDarwinExportDetails details;
+  GumDarwinMapper * root;
+  GHashTable * module_cache;
+  GumDarwinSymbolValue * cached;
+  gboolean success;
 
-  if (self->parent != NULL)
+  root = self;
+  while (root->parent != NULL)
+    root = root->parent;
+
+  /*
+   * The atexit stubs resolve to a location inside our runtime, which is not
+   * known until mapping time, so those must not be cached.
+   */
+  if (gum_darwin_mapper_symbol_is_atexit (name))
+    return gum_darwin_mapper_do_resolve_symbol (root, module, name, value);
+
+  module_cache = g_hash_table_lookup (root->cached_symbols, module);
+  if (module_cache != NULL)
   {
-    return gum_darwin_mapper_resolve_symbol (self->parent, module, name, value);
+    cached = g_hash_table_lookup (module_cache, name);
+    if (cached != NULL)
+    {
+      *value = *cached;
+      return value->address != 0 || value->resolver != 0;
+    }
   }
 
-  if (strcmp (name, "_atexit") == 0 ||
+  success = gum_darwin_mapper_do_resolve_symbol (root, module, name, value);
+  if (!success)
+  {
+    value->address = 0;
+    value->resolver = 0;
+  }
+
+  if (module_cache == NULL)
+  {
+    module_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify) gum_darwin_symbol_value_free);
+    g_hash_table_insert (root->cached_symbols, module, module_cache);
+  }
+  g_hash_table_insert (module_cache, g_strdup (name),
+      g_slice_dup (GumDarwinSymbolValue, value));
+
+  return success;
+}
+
+static void
+gum_darwin_symbol_value_free (GumDarwinSymbolValue * value)
+{
+  g_slice_free (GumDarwinSymbolValue, value);
+}
+
+static gboolean
+gum_darwin_mapper_symbol_is_atexit (const gchar * name)
+{
+  return strcmp (name, "_atexit") == 0 ||
       strcmp (name, "_atexit_b") == 0 ||
       strcmp (name, "___cxa_atexit") == 0 ||
       strcmp (name, "___cxa_thread_atexit") == 0 ||
-      strcmp (name, "__tlv_atexit") == 0)
+      strcmp (name, "__tlv_atexit") == 0;
+}
+
+static gboolean
+gum_darwin_mapper_do_resolve_symbol (GumDarwinMapper * self,
+                                     GumDarwinModule * module,
+                                     const gchar * name,
+                                     GumDarwinSymbolValue * value)
+{
+  GumDarwinExportDetails details;
+
+  if (gum_darwin_mapper_symbol_is_atexit (name))
   {
     /*
      * We pretend we install the handler by resolving to a dummy function that
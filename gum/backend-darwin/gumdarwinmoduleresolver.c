@@ -12,6 +12,7 @@
 #include <mach-o/loader.h>
 
 typedef struct _GumCollectModulesContext GumCollectModulesContext;
+typedef struct _GumResolvedExport GumResolvedExport;
 
 enum
 {
@@ -27,6 +28,12 @@ struct _GumCollectModulesContext
   guint sysroot_length;
 };
 
+struct _GumResolvedExport
+{
+  gboolean found;
+  GumExportDetails details;
+};
+
 static void gum_darwin_module_resolver_initable_iface_init (gpointer g_iface,
     gpointer iface_data);
 static void gum_darwin_module_resolver_constructed (GObject * object);
@@ -38,9 +45,15 @@ static void gum_darwin_module_resolver_get_property (GObject * object,
 static void gum_darwin_module_resolver_set_property (GObject * object,
     guint property_id, const GValue * value, GParamSpec * pspec);
 
+static gboolean gum_darwin_module_resolver_do_find_export_by_mangled_name (
+    GumDarwinModuleResolver * self, GumDarwinModule * module,
+    const gchar * symbol, GumExportDetails * details);
+
 static gboolean gum_store_module (const GumModuleDetails * details,
     gpointer user_data);
 
+static void gum_resolved_export_free (GumResolvedExport * resolved);
+
 G_DEFINE_TYPE_EXTENDED (GumDarwinModuleResolver,
                         gum_darwin_module_resolver,
                         G_TYPE_OBJECT,
@@ -78,6 +91,8 @@ gum_darwin_module_resolver_init (GumDarwinModuleResolver * self)
 {
   self->modules = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
       g_object_unref);
+  self->cached_exports = g_hash_table_new_full (NULL, NULL, NULL,
+      (GDestroyNotify) g_hash_table_unref);
 }
 
 static void
@@ -133,6 +148,7 @@ gum_darwin_module_resolver_finalize (GObject * object)
   GumDarwinModuleResolver * self = GUM_DARWIN_MODULE_RESOLVER (object);
 
   g_free (self->sysroot);
+  g_hash_table_unref (self->cached_exports);
   g_hash_table_unref (self->modules);
 
   G_OBJECT_CLASS (gum_darwin_module_resolver_parent_class)->finalize (object);
@@ -242,6 +258,55 @@ gum_darwin_module_resolver_find_export_by_mangled_name (
     GumDarwinModule * module,
     const gchar * symbol,
     GumExportDetails * details)
+{
+  GHashTable * module_cache;
+  GumResolvedExport * resolved;
+
+  /*
+   * Resolution may involve parsing remote task memory and chasing reexport
+   * chains across modules, so we memoize the outcome — misses included —
+   * for the lifetime of the resolver, whose module snapshot is immutable
+   * anyway.
+   */
+  module_cache = g_hash_table_lookup (self->cached_exports, module);
+  if (module_cache != NULL)
+  {
+    resolved = g_hash_table_lookup (module_cache, symbol);
+    if (resolved != NULL)
+    {
+      if (resolved->found)
+        *details = resolved->details;
+      return resolved->found;
+    }
+  }
+
+  resolved = g_slice_new0 (GumResolvedExport);
+  resolved->found = gum_darwin_module_resolver_do_find_export_by_mangled_name (
+      self, module, symbol, details);
+  if (resolved->found)
+  {
+    resolved->details = *details;
+    resolved->details.name = g_strdup (details->name);
+    details->name = resolved->details.name;
+  }
+
+  if (module_cache == NULL)
+  {
+    module_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify) gum_resolved_export_free);
+    g_hash_table_insert (self->cached_exports, module, module_cache);
+  }
+  g_hash_table_insert (module_cache, g_strdup (symbol), resolved);
+
+  return resolved->found;
+}
+
+static gboolean
+gum_darwin_module_resolver_do_find_export_by_mangled_name (
+    GumDarwinModuleResolver * self,
+    GumDarwinModule * module,
+    const gchar * symbol,
+    GumExportDetails * details)
 {
   GumDarwinModule * m;
   GumDarwinExportDetails d;
@@ -388,3 +453,11 @@ gum_store_module (const GumModuleDetails * details,
 
   return TRUE;
 }
+
+static void
+gum_resolved_export_free (GumResolvedExport * resolved)
+{
+  g_free ((gchar *) resolved->details.name);
+
+  g_slice_free (GumResolvedExport, resolved);
+}
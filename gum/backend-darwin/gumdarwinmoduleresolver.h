@@ -25,6 +25,7 @@ struct _GumDarwinModuleResolver
   GumPtrauthSupport ptrauth_support;
   guint page_size;
   GHashTable * modules;
+  GHashTable * cached_exports;
   gchar * sysroot;
 };
 
@@ -72,6 +72,10 @@ static void gum_darwin_symbolicator_set_property (GObject * object,
 static cpu_type_t gum_cpu_type_to_darwin (GumCpuType cpu_type);
 static GumAddress gum_cs_symbol_address (CSSymbolRef symbol);
 
+static CSSymbolicatorRef gum_cs_symbolicator_open_for_path (const gchar * path,
+    cpu_type_t cpu_type);
+static void gum_cs_cached_symbolicator_free (gpointer data);
+
 static gboolean gum_cs_ensure_library_loaded (void);
 static gpointer gum_cs_load_library (gpointer data);
 static void gum_cs_unload_library (void);
@@ -85,11 +89,15 @@ G_DEFINE_TYPE_EXTENDED (GumDarwinSymbolicator,
 
 static void * gum_cs;
 
+static GMutex gum_cs_path_cache_mutex;
+static GHashTable * gum_cs_path_cache;
+
 #define GUM_DECLARE_CS_FUNC(N, R, A) \
     typedef R (* G_PASTE (G_PASTE (CS, N), Func)) A; \
     static G_PASTE (G_PASTE (CS, N), Func) G_PASTE (CS, N)
 
 GUM_DECLARE_CS_FUNC (IsNull, Boolean, (CSTypeRef cs));
+GUM_DECLARE_CS_FUNC (Retain, CSTypeRef, (CSTypeRef cs));
 GUM_DECLARE_CS_FUNC (Release, void, (CSTypeRef cs));
 
 GUM_DECLARE_CS_FUNC (SymbolicatorCreateWithPathAndArchitecture,
@@ -175,7 +183,7 @@ gum_darwin_symbolicator_initable_init (GInitable * initable,
 
   if (self->path != NULL)
   {
-    self->handle = CSSymbolicatorCreateWithPathAndArchitecture (self->path,
+    self->handle = gum_cs_symbolicator_open_for_path (self->path,
         gum_cpu_type_to_darwin (self->cpu_type));
     if (CSIsNull (self->handle))
       goto invalid_path;
@@ -457,6 +465,82 @@ gum_darwin_symbolicator_find_functions_matching (GumDarwinSymbolicator * self,
   return (GumAddress *) g_array_free (result, FALSE);
 }
 
+/*
+ * Path-based symbolicators are shared process-wide: the CS handle is where
+ * all of the decoded symbol state lives, and for modules in the dyld shared
+ * cache that state is identical no matter which process we are inspecting.
+ * The cache keeps its own reference so a later attach still hits, even
+ * after every earlier symbolicator is gone.
+ */
+static CSSymbolicatorRef
+gum_cs_symbolicator_open_for_path (const gchar * path,
+                                   cpu_type_t cpu_type)
+{
+  CSSymbolicatorRef handle;
+  gchar * key;
+  CSSymbolicatorRef * cached;
+
+  key = g_strdup_printf ("%u:%s", (guint) cpu_type, path);
+
+  g_mutex_lock (&gum_cs_path_cache_mutex);
+
+  if (gum_cs_path_cache == NULL)
+  {
+    gum_cs_path_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+        g_free, gum_cs_cached_symbolicator_free);
+  }
+
+  cached = g_hash_table_lookup (gum_cs_path_cache, key);
+  if (cached != NULL)
+  {
+    handle = CSRetain (*cached);
+
+    g_mutex_unlock (&gum_cs_path_cache_mutex);
+
+    g_free (key);
+
+    return handle;
+  }
+
+  g_mutex_unlock (&gum_cs_path_cache_mutex);
+
+  handle = CSSymbolicatorCreateWithPathAndArchitecture (path, cpu_type);
+  if (CSIsNull (handle))
+  {
+    g_free (key);
+
+    return handle;
+  }
+
+  g_mutex_lock (&gum_cs_path_cache_mutex);
+
+  cached = g_hash_table_lookup (gum_cs_path_cache, key);
+  if (cached == NULL)
+  {
+    cached = g_slice_new (CSSymbolicatorRef);
+    *cached = CSRetain (handle);
+
+    g_hash_table_insert (gum_cs_path_cache, key, cached);
+    key = NULL;
+  }
+
+  g_mutex_unlock (&gum_cs_path_cache_mutex);
+
+  g_free (key);
+
+  return handle;
+}
+
+static void
+gum_cs_cached_symbolicator_free (gpointer data)
+{
+  CSSymbolicatorRef * cached = data;
+
+  CSRelease (*cached);
+
+  g_slice_free (CSSymbolicatorRef, cached);
+}
+
 static cpu_type_t
 gum_cpu_type_to_darwin (GumCpuType cpu_type)
 {
@@ -527,6 +611,7 @@ gum_cs_load_library (gpointer data)
       goto api_error
 
   GUM_TRY_ASSIGN (IsNull);
+  GUM_TRY_ASSIGN (Retain);
   GUM_TRY_ASSIGN (Release);
 
   GUM_TRY_ASSIGN (SymbolicatorCreateWithPathAndArchitecture);
@@ -569,6 +654,14 @@ api_error:
 static void
 gum_cs_unload_library (void)
 {
+  g_mutex_lock (&gum_cs_path_cache_mutex);
+  if (gum_cs_path_cache != NULL)
+  {
+    g_hash_table_unref (gum_cs_path_cache);
+    gum_cs_path_cache = NULL;
+  }
+  g_mutex_unlock (&gum_cs_path_cache_mutex);
+
   dlclose (gum_cs);
   gum_cs = NULL;
 }
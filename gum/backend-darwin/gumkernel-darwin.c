@@ -12,12 +12,20 @@
 
 #include <mach/mach.h>
 #include <mach-o/loader.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/sysctl.h>
 
 #define GUM_KERNEL_SLIDE_OFFSET 0x1000000
 #define GUM_KERNEL_SLIDE_SIZE 0x200000
 
+#define GUM_KERNEL_SCAN_CHUNK_SIZE (2048 * 512)
+#define GUM_KERNEL_SCAN_MIN_SHARD_SIZE (4 * GUM_KERNEL_SCAN_CHUNK_SIZE)
+
 typedef struct _GumKernelScanContext GumKernelScanContext;
+typedef struct _GumKernelScanOperation GumKernelScanOperation;
+typedef struct _GumKernelScanShard GumKernelScanShard;
+typedef struct _GumKernelScanMatch GumKernelScanMatch;
 typedef struct _GumKernelEnumerateModuleRangesContext
     GumKernelEnumerateModuleRangesContext;
 typedef struct _GumKernelSearchKextContext GumKernelSearchKextContext;
@@ -25,6 +33,7 @@ typedef struct _GumKernelKextInfo GumKernelKextInfo;
 typedef struct _GumKernelFindRangeByNameContext GumKernelFindRangeByNameContext;
 typedef struct _GumEmitModuleContext GumEmitModuleContext;
 typedef struct _GumKernelKextByNameContext GumKernelKextByNameContext;
+typedef struct _GumKernelBatchEntry GumKernelBatchEntry;
 
 struct _GumKernelScanContext
 {
@@ -37,6 +46,28 @@ struct _GumKernelScanContext
   gboolean carry_on;
 };
 
+struct _GumKernelScanShard
+{
+  GumMemoryRange range;
+  GumAddress limit;
+  GArray * matches;
+};
+
+struct _GumKernelScanOperation
+{
+  const GumMatchPattern * pattern;
+  GumKernelScanShard * shards;
+  guint n_shards;
+  gsize buffer_size;
+  gint next_shard;
+};
+
+struct _GumKernelScanMatch
+{
+  GumAddress address;
+  gsize size;
+};
+
 struct _GumKernelEnumerateModuleRangesContext
 {
   GumPageProtection protection;
@@ -75,9 +106,25 @@ struct _GumKernelKextByNameContext
   GumDarwinModule * module;
 };
 
+struct _GumKernelBatchEntry
+{
+  guint index;
+  GumAddress start;
+  GumAddress end;
+};
+
 typedef gboolean (* GumFoundKextFunc) (GumDarwinModule * module,
     gpointer user_data);
 
+static gint gum_kernel_batch_entry_compare (gconstpointer a, gconstpointer b);
+static gsize gum_kernel_read_into (mach_port_t task, GumAddress address,
+    guint8 * buffer, gsize len);
+static gboolean gum_kernel_scan_chunked (const GumMemoryRange * range,
+    const GumMatchPattern * pattern, GumMemoryScanMatchFunc func,
+    gpointer user_data, guint8 * buffer, gsize buffer_size);
+static gpointer gum_kernel_scan_worker (gpointer data);
+static gboolean gum_kernel_scan_collect (GumAddress address, gsize size,
+    gpointer user_data);
 static gboolean gum_kernel_emit_match (GumAddress address, gsize size,
     GumKernelScanContext * ctx);
 static void gum_kernel_enumerate_kexts (GumFoundKextFunc func,
@@ -235,35 +282,56 @@ gum_kernel_read (GumAddress address,
                  gsize * n_bytes_read)
 {
   mach_port_t task;
-  guint page_size;
   guint8 * result;
   gsize offset;
-  kern_return_t kr;
 
   task = gum_kernel_get_task ();
   if (task == MACH_PORT_NULL)
     return NULL;
 
+  result = g_malloc (len);
+
+  offset = gum_kernel_read_into (task, address, result, len);
+  if (offset == 0)
+  {
+    g_free (result);
+    result = NULL;
+  }
+
+  if (n_bytes_read != NULL)
+    *n_bytes_read = offset;
+
+  return result;
+}
+
+static gsize
+gum_kernel_read_into (mach_port_t task,
+                      GumAddress address,
+                      guint8 * buffer,
+                      gsize len)
+{
+  guint page_size;
+  gsize offset;
+  kern_return_t kr;
+
   /* Failsafe size, smaller than the kernel page size. */
   page_size = 2048;
-  result = g_malloc (len);
   offset = 0;
 
   while (offset != len)
   {
     GumAddress chunk_address, page_address;
     gsize chunk_size, page_offset;
+    mach_vm_size_t n_bytes_read;
 
     chunk_address = address + offset;
     page_address = chunk_address & ~GUM_ADDRESS (page_size - 1);
     page_offset = chunk_address - page_address;
     chunk_size = MIN (len - offset, page_size - page_offset);
 
-    mach_vm_size_t n_bytes_read;
-
     /* mach_vm_read corrupts memory on iOS */
     kr = mach_vm_read_overwrite (task, chunk_address, chunk_size,
-        (vm_address_t) (result + offset), &n_bytes_read);
+        (vm_address_t) (buffer + offset), &n_bytes_read);
     if (kr != KERN_SUCCESS)
       break;
     g_assert (n_bytes_read == chunk_size);
@@ -271,16 +339,7 @@ gum_kernel_read (GumAddress address,
     offset += chunk_size;
   }
 
-  if (offset == 0)
-  {
-    g_free (result);
-    result = NULL;
-  }
-
-  if (n_bytes_read != NULL)
-    *n_bytes_read = offset;
-
-  return result;
+  return offset;
 }
 
 gboolean
@@ -297,6 +356,191 @@ gum_kernel_write (GumAddress address,
   return gum_darwin_write (task, address, bytes, len);
 }
 
+/*
+ * Reads a batch of ranges, coalescing ranges that share or border on the
+ * same pages into a single VM operation, so reading thousands of small
+ * structures costs far fewer RPC round-trips than one gum_kernel_read per
+ * range. blocks[i] receives a buffer of ranges[i].size owned by the
+ * caller, or NULL when nothing could be read; n_bytes_read may be NULL.
+ */
+void
+gum_kernel_read_batch (const GumMemoryRange * ranges,
+                       guint num_ranges,
+                       guint8 ** blocks,
+                       gsize * n_bytes_read)
+{
+  mach_port_t task;
+  guint page_size;
+  GumKernelBatchEntry * entries;
+  guint i;
+
+  for (i = 0; i != num_ranges; i++)
+  {
+    blocks[i] = NULL;
+    if (n_bytes_read != NULL)
+      n_bytes_read[i] = 0;
+  }
+
+  task = gum_kernel_get_task ();
+  if (task == MACH_PORT_NULL)
+    return;
+
+  /* Failsafe size, smaller than the kernel page size. */
+  page_size = 2048;
+
+  entries = g_new (GumKernelBatchEntry, num_ranges);
+  for (i = 0; i != num_ranges; i++)
+  {
+    entries[i].index = i;
+    entries[i].start = ranges[i].base_address;
+    entries[i].end = ranges[i].base_address + ranges[i].size;
+  }
+  qsort (entries, num_ranges, sizeof (GumKernelBatchEntry),
+      gum_kernel_batch_entry_compare);
+
+  i = 0;
+  while (i != num_ranges)
+  {
+    GumAddress span_start, span_end;
+    guint j, k;
+    guint8 * span;
+    gsize span_read;
+
+    span_start = entries[i].start;
+    span_end = entries[i].end;
+
+    for (j = i + 1; j != num_ranges; j++)
+    {
+      GumAddress boundary;
+
+      boundary = (span_end + page_size - 1) & ~GUM_ADDRESS (page_size - 1);
+      if (entries[j].start > boundary)
+        break;
+      span_end = MAX (span_end, entries[j].end);
+    }
+
+    span = gum_kernel_read (span_start, span_end - span_start, &span_read);
+
+    for (k = i; k != j; k++)
+    {
+      const GumKernelBatchEntry * e = &entries[k];
+      gsize offset, size, avail;
+
+      offset = e->start - span_start;
+      size = e->end - e->start;
+
+      if (span == NULL || span_read <= offset)
+        continue;
+      avail = MIN (size, span_read - offset);
+
+      blocks[e->index] = g_malloc (size);
+      memcpy (blocks[e->index], span + offset, avail);
+      if (n_bytes_read != NULL)
+        n_bytes_read[e->index] = avail;
+    }
+
+    g_free (span);
+
+    i = j;
+  }
+
+  g_free (entries);
+}
+
+/*
+ * Writes a batch of ranges, merging strictly contiguous ranges into a
+ * single VM operation. Returns the number of ranges fully written.
+ */
+guint
+gum_kernel_write_batch (const GumMemoryRange * ranges,
+                        const guint8 ** blocks,
+                        guint num_ranges)
+{
+  mach_port_t task;
+  GumKernelBatchEntry * entries;
+  guint num_written, i;
+
+  task = gum_kernel_get_task ();
+  if (task == MACH_PORT_NULL)
+    return 0;
+
+  entries = g_new (GumKernelBatchEntry, num_ranges);
+  for (i = 0; i != num_ranges; i++)
+  {
+    entries[i].index = i;
+    entries[i].start = ranges[i].base_address;
+    entries[i].end = ranges[i].base_address + ranges[i].size;
+  }
+  qsort (entries, num_ranges, sizeof (GumKernelBatchEntry),
+      gum_kernel_batch_entry_compare);
+
+  num_written = 0;
+
+  i = 0;
+  while (i != num_ranges)
+  {
+    GumAddress span_start, span_end;
+    guint j;
+    gboolean written;
+
+    span_start = entries[i].start;
+    span_end = entries[i].end;
+
+    for (j = i + 1; j != num_ranges && entries[j].start == span_end; j++)
+      span_end = entries[j].end;
+
+    if (j == i + 1)
+    {
+      const GumKernelBatchEntry * e = &entries[i];
+
+      written = gum_darwin_write (task, e->start, blocks[e->index],
+          e->end - e->start);
+    }
+    else
+    {
+      guint8 * span;
+      guint k;
+
+      span = g_malloc (span_end - span_start);
+      for (k = i; k != j; k++)
+      {
+        const GumKernelBatchEntry * e = &entries[k];
+
+        memcpy (span + (e->start - span_start), blocks[e->index],
+            e->end - e->start);
+      }
+
+      written = gum_darwin_write (task, span_start, span,
+          span_end - span_start);
+
+      g_free (span);
+    }
+
+    if (written)
+      num_written += j - i;
+
+    i = j;
+  }
+
+  g_free (entries);
+
+  return num_written;
+}
+
+static gint
+gum_kernel_batch_entry_compare (gconstpointer a,
+                                gconstpointer b)
+{
+  const GumKernelBatchEntry * entry_a = a;
+  const GumKernelBatchEntry * entry_b = b;
+
+  if (entry_a->start < entry_b->start)
+    return -1;
+  if (entry_a->start > entry_b->start)
+    return 1;
+  return 0;
+}
+
 void
 gum_kernel_enumerate_ranges (GumPageProtection prot,
                              GumFoundRangeFunc func,
@@ -311,52 +555,197 @@ gum_kernel_enumerate_ranges (GumPageProtection prot,
   gum_darwin_enumerate_ranges (task, prot, func, user_data);
 }
 
+/*
+ * Kernel memory cannot be matched in place, so scanning works on userland
+ * copies: each worker pages its shard through one reusable buffer instead of
+ * allocating per chunk, and the copies go through gum_memory_scan so the
+ * vectorized first-byte search applies. Large ranges are sharded across
+ * threads, with matches collected per shard and emitted in address order
+ * from the calling thread; shards overlap by one pattern length so matches
+ * straddling a boundary are found exactly once.
+ */
+
 void
 gum_kernel_scan (const GumMemoryRange * range,
                  const GumMatchPattern * pattern,
                  GumMemoryScanMatchFunc func,
                  gpointer user_data)
+{
+  GumKernelScanOperation op;
+  guint n_workers, i;
+  gsize shard_size, overlap;
+  GumAddress cursor, end;
+  GThread ** workers;
+  gboolean carry_on;
+
+  if (range->size < pattern->size)
+    return;
+
+  op.buffer_size = MAX ((gsize) pattern->size * 2,
+      (gsize) GUM_KERNEL_SCAN_CHUNK_SIZE);
+
+  n_workers = MIN ((gsize) g_get_num_processors (),
+      range->size / GUM_KERNEL_SCAN_MIN_SHARD_SIZE);
+  if (n_workers <= 1)
+  {
+    guint8 * buffer;
+
+    buffer = g_malloc (op.buffer_size);
+    gum_kernel_scan_chunked (range, pattern, func, user_data, buffer,
+        op.buffer_size);
+    g_free (buffer);
+
+    return;
+  }
+
+  op.pattern = pattern;
+  op.n_shards = n_workers;
+  op.shards = g_new (GumKernelScanShard, op.n_shards);
+  op.next_shard = 0;
+
+  overlap = pattern->size - 1;
+  shard_size = range->size / op.n_shards;
+  cursor = range->base_address;
+  end = range->base_address + range->size;
+
+  for (i = 0; i != op.n_shards; i++)
+  {
+    GumKernelScanShard * shard = &op.shards[i];
+    GumAddress limit;
+
+    limit = (i == op.n_shards - 1) ? end : cursor + shard_size;
+
+    shard->range.base_address = cursor;
+    shard->range.size = MIN (limit + overlap, end) - cursor;
+    shard->limit = limit;
+    shard->matches = g_array_new (FALSE, FALSE, sizeof (GumKernelScanMatch));
+
+    cursor = limit;
+  }
+
+  workers = g_new (GThread *, n_workers);
+  for (i = 0; i != n_workers; i++)
+    workers[i] = g_thread_new ("gum-kernel-scan", gum_kernel_scan_worker, &op);
+  for (i = 0; i != n_workers; i++)
+    g_thread_join (workers[i]);
+  g_free (workers);
+
+  carry_on = TRUE;
+
+  for (i = 0; i != op.n_shards; i++)
+  {
+    GumKernelScanShard * shard = &op.shards[i];
+    guint match_index;
+
+    for (match_index = 0;
+        carry_on && match_index != shard->matches->len;
+        match_index++)
+    {
+      GumKernelScanMatch * match;
+
+      match = &g_array_index (shard->matches, GumKernelScanMatch, match_index);
+      carry_on = func (match->address, match->size, user_data);
+    }
+
+    g_array_free (shard->matches, TRUE);
+  }
+
+  g_free (op.shards);
+}
+
+static gboolean
+gum_kernel_scan_chunked (const GumMemoryRange * range,
+                         const GumMatchPattern * pattern,
+                         GumMemoryScanMatchFunc func,
+                         gpointer user_data,
+                         guint8 * buffer,
+                         gsize buffer_size)
 {
   GumKernelScanContext ctx;
+  mach_port_t task;
   GumAddress cursor, end;
-  gsize size, max_chunk_size;
+  gsize size;
+
+  task = gum_kernel_get_task ();
+  if (task == MACH_PORT_NULL)
+    return FALSE;
 
   ctx.func = func;
   ctx.user_data = user_data;
+  ctx.carry_on = TRUE;
 
   cursor = range->base_address;
   size = range->size;
-  max_chunk_size = MAX (pattern->size * 2, 2048 * 512);
   end = cursor + size - pattern->size;
 
   while (cursor <= end)
   {
-    gsize chunk_size;
-    guint8 * haystack;
+    gsize chunk_size, n_read;
     GumMemoryRange subrange;
 
-    chunk_size = MIN (size, max_chunk_size);
-    haystack = gum_kernel_read (cursor, chunk_size, NULL);
-    if (haystack == NULL)
-      return;
+    chunk_size = MIN (size, buffer_size);
+    n_read = gum_kernel_read_into (task, cursor, buffer, chunk_size);
+    if (n_read < pattern->size)
+      return ctx.carry_on;
 
-    subrange.base_address = GUM_ADDRESS (haystack);
-    subrange.size = chunk_size;
+    subrange.base_address = GUM_ADDRESS (buffer);
+    subrange.size = n_read;
 
-    ctx.cursor_userland = GUM_ADDRESS (haystack);
-    ctx.cursor_kernel = GUM_ADDRESS (cursor);
+    ctx.cursor_userland = GUM_ADDRESS (buffer);
+    ctx.cursor_kernel = cursor;
 
     gum_memory_scan (&subrange, pattern,
         (GumMemoryScanMatchFunc) gum_kernel_emit_match, &ctx);
 
-    g_free (haystack);
-
-    if (!ctx.carry_on)
-      return;
+    if (!ctx.carry_on || n_read != chunk_size)
+      return ctx.carry_on;
 
     cursor += chunk_size - pattern->size + 1;
     size -= chunk_size - pattern->size + 1;
   }
+
+  return ctx.carry_on;
+}
+
+static gpointer
+gum_kernel_scan_worker (gpointer data)
+{
+  GumKernelScanOperation * op = data;
+  guint8 * buffer;
+  gint index;
+
+  buffer = g_malloc (op->buffer_size);
+
+  while ((index = g_atomic_int_add (&op->next_shard, 1)) <
+      (gint) op->n_shards)
+  {
+    GumKernelScanShard * shard = &op->shards[index];
+
+    gum_kernel_scan_chunked (&shard->range, op->pattern,
+        gum_kernel_scan_collect, shard, buffer, op->buffer_size);
+  }
+
+  g_free (buffer);
+
+  return NULL;
+}
+
+static gboolean
+gum_kernel_scan_collect (GumAddress address,
+                         gsize size,
+                         gpointer user_data)
+{
+  GumKernelScanShard * shard = user_data;
+  GumKernelScanMatch match;
+
+  if (address >= shard->limit)
+    return FALSE;
+
+  match.address = address;
+  match.size = size;
+  g_array_append_val (shard->matches, match);
+
+  return TRUE;
 }
 
 static gboolean
@@ -19,6 +19,7 @@ typedef gboolean (* GumFoundFreeRangeFunc) (const GumMemoryRange * range,
     gpointer user_data);
 
 typedef struct _GumAllocNearContext GumAllocNearContext;
+typedef struct _GumRemoteScanContext GumRemoteScanContext;
 
 struct _GumAllocNearContext
 {
@@ -28,6 +29,19 @@ struct _GumAllocNearContext
   mach_port_t task;
 };
 
+struct _GumRemoteScanContext
+{
+  GumMemoryScanMatchFunc func;
+  gpointer user_data;
+  GumAddress remote_base;
+  GumAddress local_base;
+};
+
+static gboolean gum_emit_remote_match (GumAddress address, gsize size,
+    gpointer user_data);
+static kern_return_t gum_mach_vm_protect (vm_map_t target_task,
+    mach_vm_address_t address, mach_vm_size_t size, boolean_t set_maximum,
+    vm_prot_t new_protection);
 static gboolean gum_try_alloc_in_range_if_near_enough (
     const GumMemoryRange * range, gpointer user_data);
 static gpointer gum_allocate_page_aligned (gpointer address, gsize size,
@@ -247,6 +261,41 @@ gum_memory_is_readable (gconstpointer address,
   return is_readable;
 }
 
+gboolean
+gum_memory_is_writable (gconstpointer address,
+                        gsize len)
+{
+  mach_port_t self;
+  mach_vm_address_t cur, end;
+
+  self = mach_task_self ();
+
+  cur = GPOINTER_TO_SIZE (address);
+  end = cur + len;
+
+  while (cur < end)
+  {
+    mach_vm_address_t region_address = cur;
+    mach_vm_size_t region_size = 0;
+    natural_t depth = 0;
+    vm_region_submap_info_data_64_t info;
+    mach_msg_type_number_t info_count = VM_REGION_SUBMAP_INFO_COUNT_64;
+    kern_return_t kr;
+
+    kr = mach_vm_region_recurse (self, &region_address, &region_size, &depth,
+        (vm_region_recurse_info_t) &info, &info_count);
+    if (kr != KERN_SUCCESS || region_address > cur)
+      return FALSE;
+
+    if ((info.protection & VM_PROT_WRITE) == 0)
+      return FALSE;
+
+    cur = region_address + region_size;
+  }
+
+  return TRUE;
+}
+
 guint8 *
 gum_memory_read (gconstpointer address,
                  gsize len,
@@ -347,6 +396,114 @@ gum_darwin_write (mach_port_t task,
   return (kr == KERN_SUCCESS);
 }
 
+/*
+ * Scans a range inside another task without copying it over first: the
+ * range is remapped into our address space copy-on-write and the native
+ * matcher runs directly on the mapping. Only when the kernel refuses the
+ * remap do we fall back to reading a private copy.
+ */
+void
+gum_darwin_scan (mach_port_t task,
+                 const GumMemoryRange * range,
+                 const GumMatchPattern * pattern,
+                 GumMemoryScanMatchFunc func,
+                 gpointer user_data)
+{
+  guint page_size;
+  mach_port_t self;
+  GumAddress aligned_base;
+  gsize page_offset, mapping_size;
+  mach_vm_address_t mapping;
+  vm_prot_t cur_protection, max_protection;
+  kern_return_t kr;
+  GumRemoteScanContext ctx;
+  GumMemoryRange view;
+
+  if (range->size == 0)
+    return;
+
+  if (!gum_darwin_query_page_size (task, &page_size))
+    return;
+
+  self = mach_task_self ();
+
+  aligned_base = range->base_address & ~(GumAddress) (page_size - 1);
+  page_offset = range->base_address - aligned_base;
+  mapping_size = (page_offset + range->size + page_size - 1) &
+      ~(gsize) (page_size - 1);
+
+  mapping = 0;
+  kr = mach_vm_remap (self, &mapping, mapping_size, 0, VM_FLAGS_ANYWHERE,
+      task, aligned_base, TRUE, &cur_protection, &max_protection,
+      VM_INHERIT_NONE);
+  if (kr != KERN_SUCCESS)
+    goto fall_back_to_copying;
+
+  if ((cur_protection & VM_PROT_READ) == 0)
+  {
+    if ((max_protection & VM_PROT_READ) == 0)
+      goto fall_back_to_copying;
+
+    kr = gum_mach_vm_protect (self, mapping, mapping_size, FALSE,
+        VM_PROT_READ);
+    if (kr != KERN_SUCCESS)
+      goto fall_back_to_copying;
+  }
+
+  ctx.func = func;
+  ctx.user_data = user_data;
+  ctx.remote_base = range->base_address;
+  ctx.local_base = mapping + page_offset;
+
+  view.base_address = ctx.local_base;
+  view.size = range->size;
+
+  gum_memory_scan (&view, pattern, gum_emit_remote_match, &ctx);
+
+  mach_vm_deallocate (self, mapping, mapping_size);
+
+  return;
+
+fall_back_to_copying:
+  {
+    guint8 * data;
+    gsize n_bytes_read;
+
+    if (mapping != 0)
+      mach_vm_deallocate (self, mapping, mapping_size);
+
+    data = gum_darwin_read (task, range->base_address, range->size,
+        &n_bytes_read);
+    if (data == NULL)
+      return;
+
+    ctx.func = func;
+    ctx.user_data = user_data;
+    ctx.remote_base = range->base_address;
+    ctx.local_base = GUM_ADDRESS (data);
+
+    view.base_address = ctx.local_base;
+    view.size = n_bytes_read;
+
+    gum_memory_scan (&view, pattern, gum_emit_remote_match, &ctx);
+
+    g_free (data);
+
+    return;
+  }
+}
+
+static gboolean
+gum_emit_remote_match (GumAddress address,
+                       gsize size,
+                       gpointer user_data)
+{
+  GumRemoteScanContext * ctx = user_data;
+
+  return ctx->func (ctx->remote_base + (address - ctx->local_base), size,
+      ctx->user_data);
+}
+
 static kern_return_t
 gum_mach_vm_protect (vm_map_t target_task,
                      mach_vm_address_t address,
@@ -444,8 +601,12 @@ gum_try_mprotect (gpointer address,
 
   kr = gum_mach_vm_protect (mach_task_self (),
       GPOINTER_TO_SIZE (aligned_address), aligned_size, FALSE, mach_page_prot);
+  if (kr != KERN_SUCCESS)
+    return FALSE;
 
-  return kr == KERN_SUCCESS;
+  _gum_memory_bump_layout_generation ();
+
+  return TRUE;
 }
 
 void
@@ -471,6 +632,8 @@ gum_try_alloc_n_pages (guint n_pages,
   if (kr != KERN_SUCCESS)
     return NULL;
 
+  _gum_memory_bump_layout_generation ();
+
   *((gsize *) GSIZE_TO_POINTER (result)) = size;
 
   gum_mprotect (GSIZE_TO_POINTER (result), page_size, GUM_PAGE_READ);
@@ -550,6 +713,8 @@ gum_try_alloc_in_range_if_near_enough (const GumMemoryRange * range,
   if (kr != KERN_SUCCESS)
     return TRUE;
 
+  _gum_memory_bump_layout_generation ();
+
   ctx->result = GSIZE_TO_POINTER (address);
   return FALSE;
 }
@@ -580,6 +745,8 @@ gum_free_pages (gpointer mem)
 
   kr = mach_vm_deallocate (mach_task_self (), address, size);
   g_assert (kr == KERN_SUCCESS);
+
+  _gum_memory_bump_layout_generation ();
 }
 
 gpointer
@@ -635,6 +802,8 @@ gum_allocate_page_aligned (gpointer address,
   if (result == MAP_FAILED)
     return NULL;
 
+  _gum_memory_bump_layout_generation ();
+
 #if defined (HAVE_IOS) && !defined (HAVE_I386)
   {
     gboolean need_checkra1n_quirk;
@@ -656,7 +825,12 @@ gboolean
 gum_memory_free (gpointer address,
                  gsize size)
 {
-  return munmap (address, size) == 0;
+  if (munmap (address, size) != 0)
+    return FALSE;
+
+  _gum_memory_bump_layout_generation ();
+
+  return TRUE;
 }
 
 gboolean
@@ -533,6 +533,59 @@ _gum_process_enumerate_threads (GumFoundThreadFunc func,
   gum_darwin_enumerate_threads (mach_task_self (), func, user_data);
 }
 
+struct _GumThreadSuspension
+{
+  GumThreadId * thread_ids;
+  guint n_threads;
+};
+
+/*
+ * Suspending our own task would also stop the calling thread, so each
+ * thread is stopped through its Mach port instead; thread_suspend() is a
+ * single trap per thread with no handshake, unlike the ptrace() dance
+ * other systems need.
+ */
+GumThreadSuspension *
+_gum_process_suspend_threads (const GumThreadId * thread_ids,
+                              guint n_threads)
+{
+  GumThreadSuspension * suspension;
+  guint i;
+
+  for (i = 0; i != n_threads; i++)
+  {
+    if (thread_suspend (thread_ids[i]) != KERN_SUCCESS)
+      goto failure;
+  }
+
+  suspension = g_slice_new (GumThreadSuspension);
+  suspension->thread_ids =
+      g_memdup (thread_ids, n_threads * sizeof (GumThreadId));
+  suspension->n_threads = n_threads;
+
+  return suspension;
+
+failure:
+  {
+    while (i != 0)
+      thread_resume (thread_ids[--i]);
+
+    return NULL;
+  }
+}
+
+void
+_gum_process_resume_threads (GumThreadSuspension * suspension)
+{
+  guint i;
+
+  for (i = 0; i != suspension->n_threads; i++)
+    thread_resume (suspension->thread_ids[i]);
+
+  g_free (suspension->thread_ids);
+  g_slice_free (GumThreadSuspension, suspension);
+}
+
 void
 gum_process_enumerate_modules (GumFoundModuleFunc func,
                                gpointer user_data)
@@ -548,6 +601,12 @@ _gum_process_enumerate_ranges (GumPageProtection prot,
   gum_darwin_enumerate_ranges (mach_task_self (), prot, func, user_data);
 }
 
+gboolean
+_gum_process_try_query_module_generation (guint64 * generation)
+{
+  return FALSE;
+}
+
 void
 gum_process_enumerate_malloc_ranges (GumFoundMallocRangeFunc func,
                                      gpointer user_data)
@@ -852,8 +911,8 @@ gum_module_find_base_address (const gchar * module_name)
 }
 
 GumAddress
-gum_module_find_export_by_name (const gchar * module_name,
-                                const gchar * symbol_name)
+_gum_module_find_export_by_name (const gchar * module_name,
+                                 const gchar * symbol_name)
 {
   GumAddress result;
   void * module;
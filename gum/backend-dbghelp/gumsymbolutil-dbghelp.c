@@ -8,6 +8,7 @@
 #include "gumsymbolutil.h"
 
 #include "gumdbghelp.h"
+#include "gumprocess.h"
 
 #include <psapi.h>
 
@@ -15,7 +16,23 @@
 #define GUM_SymTagFunction       5
 #define GUM_SymTagPublicSymbol  10
 
+#define GUM_SYMBOL_CACHE_SIZE  256
+
 typedef struct _GumSymbolInfo GumSymbolInfo;
+typedef struct _GumCachedSymbol GumCachedSymbol;
+
+/*
+ * Direct-mapped cache of resolved symbols, readable without taking the
+ * DbgHelp lock. The address tag is cleared before a slot is rewritten and
+ * published afterwards, so a reader that observes the same tag before and
+ * after copying knows the copy is not torn. Slots are only written while
+ * holding the DbgHelp lock, which keeps writers from interleaving.
+ */
+struct _GumCachedSymbol
+{
+  gsize address;
+  GumDebugSymbolDetails details;
+};
 
 #ifdef _MSC_VER
 # pragma pack(push)
@@ -38,11 +55,19 @@ static BOOL CALLBACK enum_functions_callback (SYMBOL_INFO * sym_info,
     gulong symbol_size, gpointer user_context);
 static gboolean is_function (SYMBOL_INFO * sym_info);
 
+static void gum_ensure_symbols_preloaded (GumDbghelpImpl * dbghelp);
+static gpointer gum_preload_module_symbols (gpointer data);
+static gboolean gum_collect_module_base (const GumModuleDetails * details,
+    gpointer user_data);
+
+static GumCachedSymbol gum_symbol_cache[GUM_SYMBOL_CACHE_SIZE];
+
 gboolean
 gum_symbol_details_from_address (gpointer address,
                                  GumDebugSymbolDetails * details)
 {
   GumDbghelpImpl * dbghelp;
+  GumCachedSymbol * cached;
   GumSymbolInfo si = { 0, };
   IMAGEHLP_LINE64 li = { 0, };
   DWORD displacement_dw;
@@ -53,6 +78,22 @@ gum_symbol_details_from_address (gpointer address,
   if (dbghelp == NULL)
     return FALSE;
 
+  gum_ensure_symbols_preloaded (dbghelp);
+
+  cached = &gum_symbol_cache[
+      (GPOINTER_TO_SIZE (address) >> 4) % GUM_SYMBOL_CACHE_SIZE];
+  if ((gsize) g_atomic_pointer_get (&cached->address) ==
+      GPOINTER_TO_SIZE (address))
+  {
+    *details = cached->details;
+
+    if ((gsize) g_atomic_pointer_get (&cached->address) ==
+        GPOINTER_TO_SIZE (address))
+    {
+      return TRUE;
+    }
+  }
+
   memset (details, 0, sizeof (GumDebugSymbolDetails));
   details->address = GUM_ADDRESS (address);
 
@@ -83,6 +124,13 @@ gum_symbol_details_from_address (gpointer address,
     details->line_number = li.LineNumber;
   }
 
+  if (has_sym_info || has_file_info)
+  {
+    g_atomic_pointer_set (&cached->address, 0);
+    cached->details = *details;
+    g_atomic_pointer_set (&cached->address, GPOINTER_TO_SIZE (address));
+  }
+
   dbghelp->Unlock ();
 
   return (has_sym_info || has_file_info);
@@ -182,6 +230,67 @@ beach:
   return success;
 }
 
+/*
+ * DbgHelp defers PDB parsing until a module is first queried, which can
+ * stall the querying thread for seconds on large PDBs. Touching each
+ * module once from a background thread moves that cost off the first
+ * symbolication; the lock is released between modules so concurrent
+ * queries can interleave.
+ */
+static void
+gum_ensure_symbols_preloaded (GumDbghelpImpl * dbghelp)
+{
+  static gsize preload_started = 0;
+
+  if (g_once_init_enter (&preload_started))
+  {
+    g_thread_unref (g_thread_new ("gum-symbol-preloader",
+        gum_preload_module_symbols, dbghelp));
+
+    g_once_init_leave (&preload_started, 1);
+  }
+}
+
+static gpointer
+gum_preload_module_symbols (gpointer data)
+{
+  GumDbghelpImpl * dbghelp = data;
+  GArray * bases;
+  guint i;
+
+  bases = g_array_new (FALSE, FALSE, sizeof (GumAddress));
+  gum_process_enumerate_modules (gum_collect_module_base, bases);
+
+  for (i = 0; i != bases->len; i++)
+  {
+    GumSymbolInfo si = { 0, };
+    DWORD64 displacement;
+
+    si.sym_info.SizeOfStruct = sizeof (SYMBOL_INFO);
+    si.sym_info.MaxNameLen = sizeof (si.sym_name_buf);
+
+    dbghelp->Lock ();
+    dbghelp->SymFromAddr (GetCurrentProcess (),
+        g_array_index (bases, GumAddress, i), &displacement, &si.sym_info);
+    dbghelp->Unlock ();
+  }
+
+  g_array_free (bases, TRUE);
+
+  return NULL;
+}
+
+static gboolean
+gum_collect_module_base (const GumModuleDetails * details,
+                         gpointer user_data)
+{
+  GArray * bases = user_data;
+
+  g_array_append_val (bases, details->range->base_address);
+
+  return TRUE;
+}
+
 static BOOL CALLBACK
 enum_functions_callback (SYMBOL_INFO * sym_info,
                          gulong symbol_size,
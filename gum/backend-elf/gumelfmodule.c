@@ -7,8 +7,10 @@
 
 #include "gumelfmodule.h"
 
+#include "gum-init.h"
 #ifdef HAVE_ANDROID
 # include "backend-linux/gumandroid.h"
+# include "gumprocess-priv.h"
 #endif
 
 #include <fcntl.h>
@@ -16,6 +18,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+typedef struct _GumElfFileMapping GumElfFileMapping;
 typedef struct _GumElfEnumerateDepsContext GumElfEnumerateDepsContext;
 typedef struct _GumElfEnumerateImportsContext GumElfEnumerateImportsContext;
 typedef struct _GumElfEnumerateExportsContext GumElfEnumerateExportsContext;
@@ -29,6 +32,15 @@ enum
   PROP_BASE_ADDRESS
 };
 
+struct _GumElfFileMapping
+{
+  gint ref_count;
+
+  gchar * path;
+  gpointer data;
+  gsize size;
+};
+
 struct _GumElfEnumerateDepsContext
 {
   GumElfFoundDependencyFunc func;
@@ -66,6 +78,10 @@ struct _GumElfStoreFindStringTableContext
   GumElfModule * module;
 };
 
+static GumElfFileMapping * gum_elf_file_mapping_open (const gchar * path);
+static void gum_elf_file_mapping_unref (GumElfFileMapping * mapping);
+static void gum_elf_file_mappings_deinit (void);
+
 static void gum_elf_module_constructed (GObject * object);
 static void gum_elf_module_finalize (GObject * object);
 static void gum_elf_module_get_property (GObject * object,
@@ -99,6 +115,117 @@ static gboolean gum_store_dynamic_string_table (
 
 G_DEFINE_TYPE (GumElfModule, gum_elf_module, G_TYPE_OBJECT)
 
+static GMutex gum_elf_file_mappings_mutex;
+static GHashTable * gum_elf_file_mappings = NULL;
+
+/*
+ * Instances for the same file share one read-only mapping, so repeated
+ * introspection of a large library maps its pages once. Each instance still
+ * gets its own Elf handle on top of the shared data, keeping libelf's
+ * lazily-decoded state private to the instance.
+ */
+static GumElfFileMapping *
+gum_elf_file_mapping_open (const gchar * path)
+{
+  GumElfFileMapping * mapping, * existing;
+  int fd;
+  gsize size;
+  gpointer data;
+
+  g_mutex_lock (&gum_elf_file_mappings_mutex);
+
+  if (gum_elf_file_mappings == NULL)
+  {
+    gum_elf_file_mappings = g_hash_table_new (g_str_hash, g_str_equal);
+
+    _gum_register_destructor (gum_elf_file_mappings_deinit);
+  }
+
+  mapping = g_hash_table_lookup (gum_elf_file_mappings, path);
+  if (mapping != NULL)
+  {
+    mapping->ref_count++;
+    g_mutex_unlock (&gum_elf_file_mappings_mutex);
+    return mapping;
+  }
+
+  g_mutex_unlock (&gum_elf_file_mappings_mutex);
+
+  fd = open (path, O_RDONLY);
+  if (fd == -1)
+    return NULL;
+
+  size = lseek (fd, 0, SEEK_END);
+  lseek (fd, 0, SEEK_SET);
+
+  data = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  close (fd);
+
+  if (data == MAP_FAILED)
+    return NULL;
+
+  mapping = g_slice_new (GumElfFileMapping);
+  mapping->ref_count = 1;
+  mapping->path = g_strdup (path);
+  mapping->data = data;
+  mapping->size = size;
+
+  g_mutex_lock (&gum_elf_file_mappings_mutex);
+
+  existing = g_hash_table_lookup (gum_elf_file_mappings, path);
+  if (existing != NULL)
+  {
+    existing->ref_count++;
+    g_mutex_unlock (&gum_elf_file_mappings_mutex);
+
+    munmap (mapping->data, mapping->size);
+    g_free (mapping->path);
+    g_slice_free (GumElfFileMapping, mapping);
+
+    return existing;
+  }
+
+  g_hash_table_insert (gum_elf_file_mappings, mapping->path, mapping);
+
+  g_mutex_unlock (&gum_elf_file_mappings_mutex);
+
+  return mapping;
+}
+
+static void
+gum_elf_file_mapping_unref (GumElfFileMapping * mapping)
+{
+  gboolean dead;
+
+  g_mutex_lock (&gum_elf_file_mappings_mutex);
+
+  mapping->ref_count--;
+  dead = mapping->ref_count == 0;
+  if (dead && gum_elf_file_mappings != NULL)
+    g_hash_table_remove (gum_elf_file_mappings, mapping->path);
+
+  g_mutex_unlock (&gum_elf_file_mappings_mutex);
+
+  if (dead)
+  {
+    munmap (mapping->data, mapping->size);
+    g_free (mapping->path);
+    g_slice_free (GumElfFileMapping, mapping);
+  }
+}
+
+static void
+gum_elf_file_mappings_deinit (void)
+{
+  g_mutex_lock (&gum_elf_file_mappings_mutex);
+
+  g_hash_table_unref (gum_elf_file_mappings);
+  gum_elf_file_mappings = NULL;
+
+  g_mutex_unlock (&gum_elf_file_mappings_mutex);
+}
+
 static void
 gum_elf_module_class_init (GumElfModuleClass * klass)
 {
@@ -145,22 +272,15 @@ gum_elf_module_constructed (GObject * object)
   }
   else
   {
-    int fd;
+    GumElfFileMapping * mapping;
 
-    fd = open (self->path, O_RDONLY);
-    if (fd == -1)
+    mapping = gum_elf_file_mapping_open (self->path);
+    if (mapping == NULL)
       goto error;
 
-    self->file_size = lseek (fd, 0, SEEK_END);
-    lseek (fd, 0, SEEK_SET);
-
-    self->file_data =
-        mmap (NULL, self->file_size, PROT_READ, MAP_PRIVATE, fd, 0);
-
-    close (fd);
-
-    if (self->file_data == MAP_FAILED)
-      goto mmap_failed;
+    self->mapping = mapping;
+    self->file_data = mapping->data;
+    self->file_size = mapping->size;
 
     self->is_linux_vdso = FALSE;
   }
@@ -188,11 +308,6 @@ gum_elf_module_constructed (GObject * object)
   self->valid = TRUE;
   return;
 
-mmap_failed:
-  {
-    self->file_data = NULL;
-    goto error;
-  }
 error:
   {
     self->valid = FALSE;
@@ -208,8 +323,8 @@ gum_elf_module_finalize (GObject * object)
   if (self->elf != NULL)
     elf_end (self->elf);
 
-  if (self->file_data != NULL && !self->is_linux_vdso)
-    munmap (self->file_data, self->file_size);
+  if (self->mapping != NULL)
+    gum_elf_file_mapping_unref (self->mapping);
 
   g_free (self->path);
   g_free (self->name);
@@ -377,7 +492,12 @@ gum_elf_module_enumerate_exports (GumElfModule * self,
 
       d.type = GUM_EXPORT_FUNCTION;
       d.name = name;
-      d.address = gum_module_find_export_by_name (self->path, name);
+      /*
+       * Must not go through the public API here: its export-table cache
+       * builds tables by enumerating exports, i.e. through this very
+       * function.
+       */
+      d.address = _gum_module_find_export_by_name (self->path, name);
       g_assert (d.address != 0);
 
       if (!func (&d, user_data))
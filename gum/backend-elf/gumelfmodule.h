@@ -45,6 +45,7 @@ struct _GumElfModule
   gchar * name;
   gchar * path;
 
+  gpointer mapping;
   gpointer file_data;
   gsize file_size;
   gboolean is_linux_vdso;
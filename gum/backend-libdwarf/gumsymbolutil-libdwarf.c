@@ -105,6 +105,7 @@ static Dwarf_Addr gum_module_entry_virtual_address_to_file (
 
 static GHashTable * gum_get_function_addresses (void);
 static GHashTable * gum_get_address_symbols (void);
+static GArray * gum_get_sorted_symbols (void);
 static void gum_maybe_refresh_symbol_caches (void);
 static gboolean gum_collect_module_functions (const GumModuleDetails * details,
     gpointer user_data);
@@ -147,11 +148,15 @@ static gboolean gum_read_attribute_uint (Dwarf_Debug dbg, Dwarf_Die die,
     Dwarf_Half id, Dwarf_Unsigned * value);
 
 static gint gum_compare_pointers (gconstpointer a, gconstpointer b);
+static gint gum_compare_symbol_addresses (gconstpointer a, gconstpointer b);
 
 G_LOCK_DEFINE_STATIC (gum_symbol_util);
 static GHashTable * gum_module_entries = NULL;
 static GHashTable * gum_function_addresses = NULL;
 static GHashTable * gum_address_symbols = NULL;
+static GArray * gum_sorted_symbols = NULL;
+static gboolean gum_sorted_symbols_dirty = FALSE;
+static gsize gum_sorted_symbols_max_size = 0;
 static GTimer * gum_cache_timer = NULL;
 
 gboolean
@@ -361,10 +366,12 @@ static gboolean
 gum_find_nearest_symbol_by_address (gpointer address,
                                     GumNearestSymbolDetails * nearest)
 {
+  GumAddress needle = GUM_ADDRESS (address);
   GHashTable * table;
   GumElfSymbolDetails * details;
-  GHashTableIter iter;
-  GumElfSymbolDetails * current_symbol = NULL;
+  GArray * sorted;
+  guint lower, upper;
+  gint index;
 
   table = gum_get_address_symbols ();
 
@@ -376,20 +383,41 @@ gum_find_nearest_symbol_by_address (gpointer address,
     return TRUE;
   }
 
-  g_hash_table_iter_init (&iter, table);
-  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &current_symbol))
+  sorted = gum_get_sorted_symbols ();
+
+  lower = 0;
+  upper = sorted->len;
+  while (lower != upper)
   {
-    if (current_symbol->address > GUM_ADDRESS (address))
-      continue;
+    guint mid = (lower + upper) / 2;
+    GumElfSymbolDetails * candidate;
+
+    candidate = g_array_index (sorted, GumElfSymbolDetails *, mid);
+    if (candidate->address < needle)
+      lower = mid + 1;
+    else
+      upper = mid;
+  }
+
+  /*
+   * Symbols may overlap, so walk backwards from the insertion point until no
+   * earlier symbol can be large enough to still contain the address.
+   */
+  for (index = (gint) lower - 1; index >= 0; index--)
+  {
+    GumElfSymbolDetails * candidate;
+
+    candidate = g_array_index (sorted, GumElfSymbolDetails *, index);
+
+    if (needle - candidate->address >= gum_sorted_symbols_max_size)
+      break;
 
-    if (current_symbol->address + current_symbol->size <= GUM_ADDRESS (address))
+    if (candidate->address + candidate->size > needle)
     {
-      continue;
+      nearest->address = GSIZE_TO_POINTER (candidate->address);
+      nearest->name = candidate->name;
+      return TRUE;
     }
-
-    nearest->address = GSIZE_TO_POINTER (current_symbol->address);
-    nearest->name = current_symbol->name;
-    return TRUE;
   }
 
   return FALSE;
@@ -579,6 +607,39 @@ gum_get_address_symbols (void)
   return gum_address_symbols;
 }
 
+/*
+ * Entries in gum_address_symbols are only ever added, so the sorted index
+ * borrows its values and is rebuilt lazily whenever new symbols have been
+ * collected since the last lookup.
+ */
+static GArray *
+gum_get_sorted_symbols (void)
+{
+  if (gum_sorted_symbols_dirty)
+  {
+    GHashTableIter iter;
+    GumElfSymbolDetails * details;
+
+    g_array_set_size (gum_sorted_symbols, 0);
+    gum_sorted_symbols_max_size = 0;
+
+    g_hash_table_iter_init (&iter, gum_address_symbols);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &details))
+    {
+      g_array_append_val (gum_sorted_symbols, details);
+
+      if (details->size > gum_sorted_symbols_max_size)
+        gum_sorted_symbols_max_size = details->size;
+    }
+
+    g_array_sort (gum_sorted_symbols, gum_compare_symbol_addresses);
+
+    gum_sorted_symbols_dirty = FALSE;
+  }
+
+  return gum_sorted_symbols;
+}
+
 static void
 gum_maybe_refresh_symbol_caches (void)
 {
@@ -677,6 +738,8 @@ gum_collect_symbol_if_function (const GumElfSymbolDetails * details,
     address_symbol->bind = details->bind;
     address_symbol->section_header_index = details->section_header_index;
     g_hash_table_insert (gum_address_symbols, address, address_symbol);
+
+    gum_sorted_symbols_dirty = TRUE;
   }
     
   return TRUE;
@@ -707,6 +770,8 @@ gum_symbol_util_ensure_initialized (void)
       g_free, (GDestroyNotify) gum_function_addresses_free);
   gum_address_symbols = g_hash_table_new_full (g_direct_hash, g_direct_equal,
       NULL, (GDestroyNotify) gum_address_symbols_value_free);
+  gum_sorted_symbols =
+      g_array_new (FALSE, FALSE, sizeof (GumElfSymbolDetails *));
 
   _gum_register_destructor (gum_symbol_util_deinitialize);
 }
@@ -716,6 +781,11 @@ gum_symbol_util_deinitialize (void)
 {
   g_clear_pointer (&gum_cache_timer, g_timer_destroy);
 
+  g_array_free (gum_sorted_symbols, TRUE);
+  gum_sorted_symbols = NULL;
+  gum_sorted_symbols_dirty = FALSE;
+  gum_sorted_symbols_max_size = 0;
+
   g_hash_table_unref (gum_address_symbols);
   gum_address_symbols = NULL;
 
@@ -1177,3 +1247,19 @@ gum_compare_pointers (gconstpointer a,
 {
   return *((gconstpointer *) a) - *((gconstpointer *) b);
 }
+
+static gint
+gum_compare_symbol_addresses (gconstpointer a,
+                              gconstpointer b)
+{
+  const GumElfSymbolDetails * symbol_a = *((GumElfSymbolDetails **) a);
+  const GumElfSymbolDetails * symbol_b = *((GumElfSymbolDetails **) b);
+
+  if (symbol_a->address < symbol_b->address)
+    return -1;
+
+  if (symbol_a->address > symbol_b->address)
+    return 1;
+
+  return 0;
+}
@@ -35,6 +35,14 @@ G_DEFINE_TYPE_EXTENDED (GumUnwBacktracer,
 static void
 gum_unw_backtracer_class_init (GumUnwBacktracerClass * klass)
 {
+  /*
+   * Have libunwind keep its decoded unwind tables around instead of
+   * re-parsing .eh_frame on every backtrace. Entries are keyed on IP
+   * ranges, so the cache stays valid for as long as modules are not
+   * unloaded, and going per-thread avoids lock contention when many
+   * threads are backtracing at once.
+   */
+  unw_set_caching_policy (unw_local_addr_space, UNW_CACHE_PER_THREAD);
 }
 
 static void
@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2020 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#include "gumcodesegment.h"
+
+#include "gumcloak.h"
+#include "gummemory.h"
+
+#include <errno.h>
+#include <gio/gio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef MFD_CLOEXEC
+# define MFD_CLOEXEC 0x0001U
+#endif
+
+struct _GumCodeSegment
+{
+  gpointer data;
+  gsize size;
+  gsize virtual_size;
+
+  gint fd;
+};
+
+static gint gum_memfd_create (const gchar * name, guint flags);
+
+gboolean
+gum_code_segment_is_supported (void)
+{
+  static gsize supported = 0;
+
+  if (g_once_init_enter (&supported))
+  {
+    gint fd;
+
+    fd = gum_memfd_create ("gum-probe", MFD_CLOEXEC);
+    if (fd != -1)
+      close (fd);
+
+    g_once_init_leave (&supported, (fd != -1) ? 1 : 2);
+  }
+
+  return supported == 1;
+}
+
+GumCodeSegment *
+gum_code_segment_new (gsize size,
+                      const GumAddressSpec * spec)
+{
+  GumCodeSegment * segment;
+  gsize page_size, size_in_pages, virtual_size;
+  gint fd;
+  gpointer data;
+  GumMemoryRange range;
+
+  page_size = gum_query_page_size ();
+  size_in_pages = size / page_size;
+  if (size % page_size != 0)
+    size_in_pages++;
+  virtual_size = size_in_pages * page_size;
+
+  fd = gum_memfd_create ("gum-code-segment", MFD_CLOEXEC);
+  if (fd == -1)
+    return NULL;
+
+  if (ftruncate (fd, virtual_size) == -1)
+    goto ftruncate_failed;
+
+  /*
+   * The caller writes through a plain anonymous scratch area; realize()
+   * copies it into the memfd and map() installs read-execute views of the
+   * file, so no page ever transitions between writable and executable.
+   */
+  if (spec == NULL)
+  {
+    data = gum_alloc_n_pages (size_in_pages, GUM_PAGE_RW);
+  }
+  else
+  {
+    data = gum_try_alloc_n_pages_near (size_in_pages, GUM_PAGE_RW, spec);
+    if (data == NULL)
+      goto ftruncate_failed;
+  }
+
+  segment = g_slice_new (GumCodeSegment);
+  segment->data = data;
+  segment->size = size;
+  segment->virtual_size = virtual_size;
+  segment->fd = fd;
+
+  gum_query_page_allocation_range (data, virtual_size, &range);
+  gum_cloak_add_range (&range);
+
+  return segment;
+
+ftruncate_failed:
+  {
+    close (fd);
+    return NULL;
+  }
+}
+
+void
+gum_code_segment_free (GumCodeSegment * segment)
+{
+  GumMemoryRange range;
+
+  close (segment->fd);
+
+  gum_query_page_allocation_range (segment->data, segment->virtual_size,
+      &range);
+
+  gum_free_pages (segment->data);
+
+  gum_cloak_remove_range (&range);
+
+  g_slice_free (GumCodeSegment, segment);
+}
+
+gpointer
+gum_code_segment_get_address (GumCodeSegment * self)
+{
+  return self->data;
+}
+
+gsize
+gum_code_segment_get_size (GumCodeSegment * self)
+{
+  return self->size;
+}
+
+gsize
+gum_code_segment_get_virtual_size (GumCodeSegment * self)
+{
+  return self->virtual_size;
+}
+
+void
+gum_code_segment_realize (GumCodeSegment * self)
+{
+  gssize written;
+  gsize remaining;
+  const guint8 * cursor;
+
+  cursor = self->data;
+  remaining = self->virtual_size;
+  while (remaining != 0)
+  {
+    written = pwrite (self->fd, cursor, remaining,
+        self->virtual_size - remaining);
+    if (written == -1)
+    {
+      if (errno == EINTR)
+        continue;
+      return;
+    }
+
+    cursor += written;
+    remaining -= written;
+  }
+}
+
+void
+gum_code_segment_map (GumCodeSegment * self,
+                      gsize source_offset,
+                      gsize source_size,
+                      gpointer target_address)
+{
+  gpointer result;
+
+  result = mmap (target_address, source_size, PROT_READ | PROT_EXEC,
+      MAP_PRIVATE | MAP_FIXED, self->fd, source_offset);
+  g_assert (result != MAP_FAILED);
+}
+
+gboolean
+gum_code_segment_mark (gpointer code,
+                       gsize size,
+                       GError ** error)
+{
+  if (gum_code_segment_is_supported ())
+  {
+    GumCodeSegment * segment;
+
+    segment = gum_code_segment_new (size, NULL);
+    if (segment == NULL)
+      goto fallback;
+
+    memcpy (segment->data, code, size);
+
+    gum_code_segment_realize (segment);
+    gum_code_segment_map (segment, 0, segment->virtual_size, code);
+
+    gum_code_segment_free (segment);
+
+    return TRUE;
+  }
+
+fallback:
+  {
+    if (!gum_try_mprotect (code, size, GUM_PAGE_RX))
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+          "Invalid address");
+      return FALSE;
+    }
+
+    return TRUE;
+  }
+}
+
+static gint
+gum_memfd_create (const gchar * name,
+                  guint flags)
+{
+  return syscall (__NR_memfd_create, name, flags);
+}
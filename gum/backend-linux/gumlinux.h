@@ -14,6 +14,18 @@
 G_BEGIN_DECLS
 
 typedef struct _GumLinuxNamedRange GumLinuxNamedRange;
+typedef struct _GumLinuxThreadEnumSession GumLinuxThreadEnumSession;
+
+typedef enum _GumLinuxThreadEventType
+{
+  GUM_LINUX_THREAD_ADDED,
+  GUM_LINUX_THREAD_REMOVED
+} GumLinuxThreadEventType;
+
+typedef void (* GumLinuxThreadChangeFunc) (GumLinuxThreadEventType type,
+    GumThreadId id, gpointer user_data);
+typedef gboolean (* GumLinuxFoundDirtyRangeFunc) (
+    const GumMemoryRange * range, gpointer user_data);
 
 struct _GumLinuxNamedRange
 {
@@ -33,6 +45,20 @@ GUM_API void gum_linux_enumerate_ranges (pid_t pid, GumPageProtection prot,
     GumFoundRangeFunc func, gpointer user_data);
 GUM_API GHashTable * gum_linux_collect_named_ranges (void);
 
+GUM_API gboolean gum_linux_reset_dirty_tracking (void);
+GUM_API gboolean gum_linux_enumerate_dirty_ranges (
+    const GumMemoryRange * ranges, guint n_ranges,
+    GumLinuxFoundDirtyRangeFunc func, gpointer user_data);
+
+GUM_API GumLinuxThreadEnumSession * gum_linux_thread_enum_session_new (void);
+GUM_API void gum_linux_thread_enum_session_refresh (
+    GumLinuxThreadEnumSession * self, GumLinuxThreadChangeFunc func,
+    gpointer user_data);
+GUM_API guint gum_linux_thread_enum_session_get_threads (
+    GumLinuxThreadEnumSession * self, const GumThreadId ** ids);
+GUM_API void gum_linux_thread_enum_session_free (
+    GumLinuxThreadEnumSession * self);
+
 GUM_API gboolean gum_linux_module_path_matches (const gchar * path,
     const gchar * name_or_path);
 
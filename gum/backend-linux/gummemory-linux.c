@@ -6,14 +6,22 @@
 
 #include "gummemory.h"
 
+#include "gumlinux.h"
 #include "gummemory-priv.h"
 #include "valgrind.h"
 
+#include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/mman.h>
 #include <unistd.h>
 
+#define GUM_PAGEMAP_SOFT_DIRTY (G_GUINT64_CONSTANT (1) << 55)
+#define GUM_PAGEMAP_CHUNK_SIZE 512
+
+static gboolean gum_emit_dirty_run (const GumMemoryRange * range,
+    GumAddress run_start, gsize run_size, GumLinuxFoundDirtyRangeFunc func,
+    gpointer user_data);
 static gboolean gum_memory_get_protection (gconstpointer address, gsize n,
     gsize * size, GumPageProtection * prot);
 
@@ -30,7 +38,7 @@ gum_memory_is_readable (gconstpointer address,
   return size >= len && (prot & GUM_PAGE_READ) != 0;
 }
 
-static gboolean
+gboolean
 gum_memory_is_writable (gconstpointer address,
                         gsize len)
 {
@@ -103,8 +111,12 @@ gum_try_mprotect (gpointer address,
   posix_page_prot = _gum_page_protection_to_posix (page_prot);
 
   result = mprotect (aligned_address, aligned_size, posix_page_prot);
+  if (result != 0)
+    return FALSE;
 
-  return result == 0;
+  _gum_memory_bump_layout_generation ();
+
+  return TRUE;
 }
 
 void
@@ -118,6 +130,131 @@ gum_clear_cache (gpointer address,
   VALGRIND_DISCARD_TRANSLATIONS (address, size);
 }
 
+/*
+ * Clears the kernel's soft-dirty bits for the whole process, so a later
+ * gum_linux_enumerate_dirty_ranges() only reports pages written to since
+ * this call. Note that the bits are per-process, so concurrent users of
+ * this facility will step on each other. Fails gracefully on kernels
+ * built without CONFIG_MEM_SOFT_DIRTY.
+ */
+gboolean
+gum_linux_reset_dirty_tracking (void)
+{
+  gint fd;
+  gboolean success;
+
+  fd = open ("/proc/self/clear_refs", O_WRONLY);
+  if (fd == -1)
+    return FALSE;
+
+  success = write (fd, "4", 1) == 1;
+
+  close (fd);
+
+  return success;
+}
+
+/*
+ * Reports which parts of the given ranges have been written to since the
+ * last gum_linux_reset_dirty_tracking(), by reading the soft-dirty bit
+ * (bit 55) of each page's /proc/self/pagemap entry. Consecutive dirty
+ * pages are coalesced into a single range, clamped to the queried range.
+ */
+gboolean
+gum_linux_enumerate_dirty_ranges (const GumMemoryRange * ranges,
+                                  guint n_ranges,
+                                  GumLinuxFoundDirtyRangeFunc func,
+                                  gpointer user_data)
+{
+  gint fd;
+  gsize page_size;
+  gboolean success, carry_on;
+  guint i;
+
+  fd = open ("/proc/self/pagemap", O_RDONLY);
+  if (fd == -1)
+    return FALSE;
+
+  page_size = gum_query_page_size ();
+  success = TRUE;
+  carry_on = TRUE;
+
+  for (i = 0; success && carry_on && i != n_ranges; i++)
+  {
+    const GumMemoryRange * r = &ranges[i];
+    GumAddress page, end, run_start;
+    gsize run_size;
+
+    page = r->base_address & ~((GumAddress) (page_size - 1));
+    end = r->base_address + r->size;
+    run_start = 0;
+    run_size = 0;
+
+    while (success && carry_on && page < end)
+    {
+      guint64 entries[GUM_PAGEMAP_CHUNK_SIZE];
+      gsize n, j;
+
+      n = MIN ((gsize) ((end - page + page_size - 1) / page_size),
+          (gsize) GUM_PAGEMAP_CHUNK_SIZE);
+
+      if (pread (fd, entries, n * sizeof (guint64),
+          (page / page_size) * sizeof (guint64)) !=
+          (gssize) (n * sizeof (guint64)))
+      {
+        success = FALSE;
+        break;
+      }
+
+      for (j = 0; carry_on && j != n; j++)
+      {
+        if ((entries[j] & GUM_PAGEMAP_SOFT_DIRTY) != 0)
+        {
+          if (run_size == 0)
+            run_start = page + (j * page_size);
+          run_size += page_size;
+        }
+        else if (run_size != 0)
+        {
+          carry_on = gum_emit_dirty_run (r, run_start, run_size, func,
+              user_data);
+          run_size = 0;
+        }
+      }
+
+      page += n * page_size;
+    }
+
+    if (success && carry_on && run_size != 0)
+    {
+      carry_on = gum_emit_dirty_run (r, run_start, run_size, func, user_data);
+    }
+  }
+
+  close (fd);
+
+  return success;
+}
+
+static gboolean
+gum_emit_dirty_run (const GumMemoryRange * range,
+                    GumAddress run_start,
+                    gsize run_size,
+                    GumLinuxFoundDirtyRangeFunc func,
+                    gpointer user_data)
+{
+  GumMemoryRange dirty;
+  GumAddress start, end;
+
+  start = MAX (run_start, range->base_address);
+  end = MIN (run_start + run_size, range->base_address + range->size);
+
+  dirty.base_address = start;
+  dirty.size = end - start;
+
+  return func (&dirty, user_data);
+}
+
 static gboolean
 gum_memory_get_protection (gconstpointer address,
                            gsize n,
@@ -10,6 +10,7 @@
 #include "gum-init.h"
 #include "gumandroid.h"
 #include "gumlinux.h"
+#include "gummemory-priv.h"
 #include "gummodulemap.h"
 #include "valgrind.h"
 
@@ -85,6 +86,7 @@
     })
 
 typedef struct _GumModifyThreadContext GumModifyThreadContext;
+typedef struct _GumSuspendThreadsContext GumSuspendThreadsContext;
 typedef guint8 GumModifyThreadAck;
 
 typedef struct _GumEnumerateModulesContext GumEnumerateModulesContext;
@@ -94,6 +96,9 @@ typedef struct _GumDependencyExport GumDependencyExport;
 typedef struct _GumEnumerateModuleSymbolContext GumEnumerateModuleSymbolContext;
 typedef struct _GumEnumerateModuleRangesContext GumEnumerateModuleRangesContext;
 typedef struct _GumResolveModuleNameContext GumResolveModuleNameContext;
+typedef struct _GumProcMapsEntry GumProcMapsEntry;
+typedef struct _GumProcMapsSnapshot GumProcMapsSnapshot;
+typedef struct _GumQueryDlGenerationOperation GumQueryDlGenerationOperation;
 
 typedef gint (* GumFoundDlPhdrFunc) (struct dl_phdr_info * info,
     gsize size, gpointer data);
@@ -112,6 +117,8 @@ enum _GumModifyThreadAck
   GUM_ACK_READ_CONTEXT,
   GUM_ACK_MODIFIED_CONTEXT,
   GUM_ACK_WROTE_CONTEXT,
+  GUM_ACK_RESUME,
+  GUM_ACK_DETACHED,
   GUM_ACK_FAILED_TO_ATTACH,
   GUM_ACK_FAILED_TO_STOP,
   GUM_ACK_FAILED_TO_READ,
@@ -126,6 +133,22 @@ struct _GumModifyThreadContext
   GumCpuContext cpu_context;
 };
 
+struct _GumSuspendThreadsContext
+{
+  gint fd[2];
+  GumThreadId * thread_ids;
+  guint n_threads;
+};
+
+struct _GumThreadSuspension
+{
+  GumSuspendThreadsContext * ctx;
+  gssize child;
+  gpointer stack;
+  gpointer tls;
+  int prev_dumpable;
+};
+
 struct _GumEnumerateModulesContext
 {
   GumFoundModuleFunc func;
@@ -183,6 +206,31 @@ struct _GumResolveModuleNameContext
   GumAddress base;
 };
 
+struct _GumProcMapsEntry
+{
+  GumMemoryRange range;
+  GumPageProtection protection;
+  guint64 file_offset;
+  const gchar * file_path;
+};
+
+struct _GumProcMapsSnapshot
+{
+  gint ref_count;
+
+  guint64 dl_generation;
+  guint layout_generation;
+
+  GArray * entries;
+  GStringChunk * file_paths;
+};
+
+struct _GumQueryDlGenerationOperation
+{
+  gboolean available;
+  guint64 generation;
+};
+
 struct _GumUserDesc
 {
   guint entry_number;
@@ -214,6 +262,8 @@ static gboolean gum_try_resolve_dynamic_symbol (const gchar * name,
 static void gum_deinit_libc_name (void);
 
 static gint gum_do_modify_thread (gpointer data);
+static gint gum_do_suspend_threads (gpointer data);
+static gboolean gum_await_thread_stopped (GumThreadId thread_id);
 static gboolean gum_await_ack (gint fd, GumModifyThreadAck expected_ack);
 static void gum_put_ack (gint fd, GumModifyThreadAck ack);
 
@@ -258,12 +308,27 @@ static void gum_symbol_section_destroy (GumSymbolSection * self);
 static gboolean gum_emit_range_if_module_name_matches (
     const GumRangeDetails * details, gpointer user_data);
 
+static GumDlIteratePhdrImpl gum_try_get_dl_iterate_phdr (void);
+static gboolean gum_try_query_dl_generation (guint64 * generation);
+static gint gum_store_dl_generation (struct dl_phdr_info * info, gsize size,
+    gpointer user_data);
+static GumProcMapsSnapshot * gum_proc_maps_snapshot_obtain (void);
+static GumProcMapsSnapshot * gum_proc_maps_snapshot_new (guint64 dl_generation,
+    guint layout_generation);
+static gboolean gum_proc_maps_snapshot_collect (const GumRangeDetails * details,
+    gpointer user_data);
+static gboolean gum_proc_maps_snapshot_emit (GumProcMapsSnapshot * self,
+    GumPageProtection prot, GumFoundRangeFunc func, gpointer user_data);
+static void gum_proc_maps_snapshot_unref (GumProcMapsSnapshot * self);
+
 static gchar * gum_resolve_module_name (const gchar * name, GumAddress * base);
 static gboolean gum_store_module_path_and_base_if_name_matches (
     const GumModuleDetails * details, gpointer user_data);
 
 static GumElfModule * gum_open_elf_module (const gchar * name);
 
+static gint gum_thread_id_compare (gconstpointer element_a,
+    gconstpointer element_b);
 static gboolean gum_thread_read_state (GumThreadId tid, GumThreadState * state);
 static GumThreadState gum_thread_state_from_proc_status_character (gchar c);
 static GumPageProtection gum_page_protection_from_proc_perms_string (
@@ -290,6 +355,12 @@ static gchar * gum_libc_name;
 
 static gboolean gum_is_regset_supported = TRUE;
 
+static GumDlIteratePhdrImpl gum_dl_iterate_phdr_impl = NULL;
+static gint gum_dl_iterate_phdr_state = 0;
+
+static GMutex gum_proc_maps_mutex;
+static GumProcMapsSnapshot * gum_proc_maps_snapshot = NULL;
+
 const gchar *
 gum_process_query_libc_name (void)
 {
@@ -697,6 +768,211 @@ gum_put_ack (gint fd,
   GUM_TEMP_FAILURE_RETRY (gum_libc_write (fd, &value, sizeof (value)));
 }
 
+GumThreadSuspension *
+_gum_process_suspend_threads (const GumThreadId * thread_ids,
+                              guint n_threads)
+{
+  GumThreadSuspension * suspension = NULL;
+  GumSuspendThreadsContext * ctx;
+  gint fd;
+  gssize child;
+  gpointer stack, tls;
+  GumUserDesc * desc;
+  int prev_dumpable;
+  gboolean attached, stopped;
+  guint i;
+
+  ctx = g_new0 (GumSuspendThreadsContext, 1);
+  if (socketpair (AF_UNIX, SOCK_STREAM, 0, ctx->fd) != 0)
+  {
+    g_free (ctx);
+    return NULL;
+  }
+  ctx->thread_ids = g_memdup (thread_ids, n_threads * sizeof (GumThreadId));
+  ctx->n_threads = n_threads;
+
+  fd = ctx->fd[0];
+
+  stack = gum_alloc_n_pages (1, GUM_PAGE_RW);
+  tls = gum_alloc_n_pages (1, GUM_PAGE_RW);
+
+#if defined (HAVE_I386) && GLIB_SIZEOF_VOID_P == 4
+  GumUserDesc segment;
+  gint gs;
+
+  asm volatile (
+      "movw %%gs, %w0"
+      : "=q" (gs)
+  );
+
+  segment.entry_number = (gs & 0xffff) >> 3;
+  segment.base_addr = GPOINTER_TO_SIZE (tls);
+  segment.limit = 0xfffff;
+  segment.seg_32bit = 1;
+  segment.contents = 0;
+  segment.read_exec_only = 0;
+  segment.limit_in_pages = 1;
+  segment.seg_not_present = 0;
+  segment.useable = 1;
+
+  desc = &segment;
+#else
+  desc = tls;
+#endif
+
+#if defined (HAVE_I386)
+  {
+    GumTcbHead * head = tls;
+
+    head->tcb = tls;
+    head->dtv = GSIZE_TO_POINTER (GPOINTER_TO_SIZE (tls) + 1024);
+    head->self = tls;
+  }
+#endif
+
+  prev_dumpable = prctl (PR_GET_DUMPABLE);
+  if (prev_dumpable != -1 && prev_dumpable != 1)
+    prctl (PR_SET_DUMPABLE, 1);
+
+  /*
+   * Same ptrace()-from-a-sibling-process-group trick as
+   * gum_process_modify_thread() above, except a single helper attaches to
+   * every target thread and stays attached until the caller resumes, so
+   * the per-suspension cost is one clone() regardless of thread count.
+   */
+  child = gum_libc_clone (
+      gum_do_suspend_threads,
+      stack + gum_query_page_size (),
+      CLONE_VM | CLONE_SETTLS,
+      ctx,
+      NULL,
+      desc,
+      NULL);
+  g_assert (child > 0);
+
+  prctl (PR_SET_PTRACER, child);
+  gum_put_ack (fd, GUM_ACK_PTRACER);
+
+  attached = gum_await_ack (fd, GUM_ACK_ATTACHED);
+
+  stopped = attached;
+  for (i = 0; stopped && i != n_threads; i++)
+    stopped = gum_await_thread_stopped (ctx->thread_ids[i]);
+
+  if (stopped)
+  {
+    suspension = g_slice_new (GumThreadSuspension);
+    suspension->ctx = ctx;
+    suspension->child = child;
+    suspension->stack = stack;
+    suspension->tls = tls;
+    suspension->prev_dumpable = prev_dumpable;
+
+    return suspension;
+  }
+
+  if (attached)
+  {
+    gum_put_ack (fd, GUM_ACK_RESUME);
+    gum_await_ack (fd, GUM_ACK_DETACHED);
+  }
+
+  if (prev_dumpable != -1 && prev_dumpable != 1)
+    prctl (PR_SET_DUMPABLE, prev_dumpable);
+
+  waitpid (child, NULL, __WCLONE);
+
+  gum_free_pages (tls);
+  gum_free_pages (stack);
+
+  close (ctx->fd[0]);
+  close (ctx->fd[1]);
+  g_free (ctx->thread_ids);
+  g_free (ctx);
+
+  return NULL;
+}
+
+void
+_gum_process_resume_threads (GumThreadSuspension * suspension)
+{
+  GumSuspendThreadsContext * ctx = suspension->ctx;
+  gint fd = ctx->fd[0];
+
+  gum_put_ack (fd, GUM_ACK_RESUME);
+  gum_await_ack (fd, GUM_ACK_DETACHED);
+
+  if (suspension->prev_dumpable != -1 && suspension->prev_dumpable != 1)
+    prctl (PR_SET_DUMPABLE, suspension->prev_dumpable);
+
+  waitpid (suspension->child, NULL, __WCLONE);
+
+  gum_free_pages (suspension->tls);
+  gum_free_pages (suspension->stack);
+
+  close (ctx->fd[0]);
+  close (ctx->fd[1]);
+  g_free (ctx->thread_ids);
+  g_free (ctx);
+
+  g_slice_free (GumThreadSuspension, suspension);
+}
+
+static gint
+gum_do_suspend_threads (gpointer data)
+{
+  GumSuspendThreadsContext * ctx = data;
+  gint fd;
+  guint n_attached, i;
+  gssize res;
+
+  fd = ctx->fd[1];
+
+  gum_await_ack (fd, GUM_ACK_PTRACER);
+
+  n_attached = 0;
+  for (i = 0; i != ctx->n_threads; i++)
+  {
+    res = gum_libc_ptrace (PTRACE_ATTACH, ctx->thread_ids[i], NULL, NULL);
+    if (res < 0)
+      goto detach;
+    n_attached++;
+  }
+  gum_put_ack (fd, GUM_ACK_ATTACHED);
+
+  gum_await_ack (fd, GUM_ACK_RESUME);
+
+detach:
+  {
+    for (i = 0; i != n_attached; i++)
+      gum_libc_ptrace (PTRACE_DETACH, ctx->thread_ids[i], NULL, NULL);
+
+    gum_put_ack (fd, (n_attached == ctx->n_threads)
+        ? GUM_ACK_DETACHED
+        : GUM_ACK_FAILED_TO_ATTACH);
+
+    return 0;
+  }
+}
+
+static gboolean
+gum_await_thread_stopped (GumThreadId thread_id)
+{
+  GumThreadState state;
+
+  while (gum_thread_read_state (thread_id, &state))
+  {
+    if (state == GUM_THREAD_STOPPED)
+      return TRUE;
+    if (state == GUM_THREAD_UNINTERRUPTIBLE)
+      return FALSE;
+
+    g_usleep (G_USEC_PER_SEC / 100);
+  }
+
+  return FALSE;
+}
+
 void
 _gum_process_enumerate_threads (GumFoundThreadFunc func,
                                 gpointer user_data)
@@ -734,6 +1010,129 @@ gum_store_cpu_context (GumThreadId thread_id,
   memcpy (user_data, cpu_context, sizeof (GumCpuContext));
 }
 
+/*
+ * Reusable thread enumeration for callers polling the task list at a high
+ * rate: the session keeps two sorted ID arrays and swaps them on each
+ * refresh, so steady-state refreshes of a large process perform no
+ * allocations and report only the threads that appeared or vanished since
+ * the previous refresh. The first refresh reports every thread as added.
+ */
+
+struct _GumLinuxThreadEnumSession
+{
+  GArray * current;
+  GArray * previous;
+};
+
+GumLinuxThreadEnumSession *
+gum_linux_thread_enum_session_new (void)
+{
+  GumLinuxThreadEnumSession * session;
+
+  session = g_slice_new (GumLinuxThreadEnumSession);
+  session->current = g_array_new (FALSE, FALSE, sizeof (GumThreadId));
+  session->previous = g_array_new (FALSE, FALSE, sizeof (GumThreadId));
+
+  return session;
+}
+
+void
+gum_linux_thread_enum_session_refresh (GumLinuxThreadEnumSession * self,
+                                       GumLinuxThreadChangeFunc func,
+                                       gpointer user_data)
+{
+  GArray * cur, * prev;
+  GDir * dir;
+  const gchar * name;
+  guint i, j;
+
+  cur = self->previous;
+  prev = self->current;
+
+  g_array_set_size (cur, 0);
+
+  dir = g_dir_open ("/proc/self/task", 0, NULL);
+  g_assert (dir != NULL);
+
+  while ((name = g_dir_read_name (dir)) != NULL)
+  {
+    GumThreadId id = atoi (name);
+
+    g_array_append_val (cur, id);
+  }
+
+  g_dir_close (dir);
+
+  g_array_sort (cur, gum_thread_id_compare);
+
+  self->current = cur;
+  self->previous = prev;
+
+  if (func == NULL)
+    return;
+
+  i = 0;
+  j = 0;
+  while (i != cur->len && j != prev->len)
+  {
+    GumThreadId a = g_array_index (cur, GumThreadId, i);
+    GumThreadId b = g_array_index (prev, GumThreadId, j);
+
+    if (a == b)
+    {
+      i++;
+      j++;
+    }
+    else if (a < b)
+    {
+      func (GUM_LINUX_THREAD_ADDED, a, user_data);
+      i++;
+    }
+    else
+    {
+      func (GUM_LINUX_THREAD_REMOVED, b, user_data);
+      j++;
+    }
+  }
+  for (; i != cur->len; i++)
+    func (GUM_LINUX_THREAD_ADDED, g_array_index (cur, GumThreadId, i),
+        user_data);
+  for (; j != prev->len; j++)
+    func (GUM_LINUX_THREAD_REMOVED, g_array_index (prev, GumThreadId, j),
+        user_data);
+}
+
+guint
+gum_linux_thread_enum_session_get_threads (GumLinuxThreadEnumSession * self,
+                                           const GumThreadId ** ids)
+{
+  *ids = (const GumThreadId *) self->current->data;
+
+  return self->current->len;
+}
+
+void
+gum_linux_thread_enum_session_free (GumLinuxThreadEnumSession * self)
+{
+  g_array_unref (self->previous);
+  g_array_unref (self->current);
+
+  g_slice_free (GumLinuxThreadEnumSession, self);
+}
+
+static gint
+gum_thread_id_compare (gconstpointer element_a,
+                       gconstpointer element_b)
+{
+  GumThreadId a = *(const GumThreadId *) element_a;
+  GumThreadId b = *(const GumThreadId *) element_b;
+
+  if (a == b)
+    return 0;
+
+  return (a < b) ? -1 : 1;
+}
+
 #ifdef HAVE_ANDROID
 
 void
@@ -749,20 +1148,9 @@ void
 gum_process_enumerate_modules (GumFoundModuleFunc func,
                                gpointer user_data)
 {
-  static gsize iterate_phdr_value = 0;
   GumDlIteratePhdrImpl iterate_phdr;
 
-  if (g_once_init_enter (&iterate_phdr_value))
-  {
-    GumAddress impl;
-
-    impl = gum_module_find_export_by_name (gum_process_query_libc_name (),
-        "dl_iterate_phdr");
-
-    g_once_init_leave (&iterate_phdr_value, impl + 1);
-  }
-
-  iterate_phdr = GSIZE_TO_POINTER (iterate_phdr_value - 1);
+  iterate_phdr = gum_try_get_dl_iterate_phdr ();
   if (iterate_phdr != NULL)
   {
     gum_process_enumerate_modules_by_using_libc (iterate_phdr, func, user_data);
@@ -1242,12 +1630,236 @@ gum_try_translate_vdso_name (gchar * name)
   return FALSE;
 }
 
+static GumDlIteratePhdrImpl
+gum_try_get_dl_iterate_phdr (void)
+{
+  if (g_atomic_int_get (&gum_dl_iterate_phdr_state) != 2)
+  {
+    GumAddress impl;
+
+    /*
+     * Resolving the export enumerates modules and ranges itself, so if a
+     * resolve is already in flight, possibly further up our own stack, we
+     * report the implementation as unavailable for now and callers fall
+     * back to parsing /proc/self/maps directly.
+     */
+    if (!g_atomic_int_compare_and_exchange (&gum_dl_iterate_phdr_state, 0, 1))
+      return NULL;
+
+    impl = gum_module_find_export_by_name (gum_process_query_libc_name (),
+        "dl_iterate_phdr");
+    gum_dl_iterate_phdr_impl = GSIZE_TO_POINTER (impl);
+
+    g_atomic_int_set (&gum_dl_iterate_phdr_state, 2);
+  }
+
+  return gum_dl_iterate_phdr_impl;
+}
+
+static gboolean
+gum_try_query_dl_generation (guint64 * generation)
+{
+  GumDlIteratePhdrImpl iterate_phdr;
+  GumQueryDlGenerationOperation op;
+
+  iterate_phdr = gum_try_get_dl_iterate_phdr ();
+  if (iterate_phdr == NULL)
+    return FALSE;
+
+  op.available = FALSE;
+  op.generation = 0;
+
+  iterate_phdr (gum_store_dl_generation, &op);
+
+  if (!op.available)
+    return FALSE;
+
+  *generation = op.generation;
+
+  return TRUE;
+}
+
+static gint
+gum_store_dl_generation (struct dl_phdr_info * info,
+                         gsize size,
+                         gpointer user_data)
+{
+  GumQueryDlGenerationOperation * op = user_data;
+
+  if (size >= G_STRUCT_OFFSET (struct dl_phdr_info, dlpi_subs) +
+      sizeof (info->dlpi_subs))
+  {
+    op->available = TRUE;
+    op->generation = ((guint64) info->dlpi_adds << 32) |
+        ((guint64) info->dlpi_subs & G_GUINT64_CONSTANT (0xffffffff));
+  }
+
+  return 1;
+}
+
+gboolean
+_gum_process_try_query_module_generation (guint64 * generation)
+{
+  return gum_try_query_dl_generation (generation);
+}
+
 void
 _gum_process_enumerate_ranges (GumPageProtection prot,
                                GumFoundRangeFunc func,
                                gpointer user_data)
 {
-  gum_linux_enumerate_ranges (getpid (), prot, func, user_data);
+  GumProcMapsSnapshot * snapshot;
+
+  snapshot = gum_proc_maps_snapshot_obtain ();
+  if (snapshot == NULL)
+  {
+    gum_linux_enumerate_ranges (getpid (), prot, func, user_data);
+    return;
+  }
+
+  gum_proc_maps_snapshot_emit (snapshot, prot, func, user_data);
+
+  gum_proc_maps_snapshot_unref (snapshot);
+}
+
+/*
+ * Parsing /proc/self/maps dominates when ranges are enumerated over and
+ * over, so we keep the most recent parse around and serve it as long as
+ * the loader's add/sub counters and our own allocation generation say the
+ * layout has not changed. When either moves, or when the counters cannot
+ * be queried at all, we fall back to a fresh parse.
+ */
+
+static GumProcMapsSnapshot *
+gum_proc_maps_snapshot_obtain (void)
+{
+  guint64 dl_generation;
+  guint layout_generation;
+  GumProcMapsSnapshot * snapshot;
+
+  if (!gum_try_query_dl_generation (&dl_generation))
+    return NULL;
+
+  layout_generation = _gum_memory_query_layout_generation ();
+
+  g_mutex_lock (&gum_proc_maps_mutex);
+  snapshot = gum_proc_maps_snapshot;
+  if (snapshot != NULL &&
+      snapshot->dl_generation == dl_generation &&
+      snapshot->layout_generation == layout_generation)
+  {
+    g_atomic_int_inc (&snapshot->ref_count);
+    g_mutex_unlock (&gum_proc_maps_mutex);
+
+    return snapshot;
+  }
+  g_mutex_unlock (&gum_proc_maps_mutex);
+
+  snapshot = gum_proc_maps_snapshot_new (dl_generation, layout_generation);
+
+  g_mutex_lock (&gum_proc_maps_mutex);
+  if (gum_proc_maps_snapshot != NULL)
+    gum_proc_maps_snapshot_unref (gum_proc_maps_snapshot);
+  g_atomic_int_inc (&snapshot->ref_count);
+  gum_proc_maps_snapshot = snapshot;
+  g_mutex_unlock (&gum_proc_maps_mutex);
+
+  return snapshot;
+}
+
+static GumProcMapsSnapshot *
+gum_proc_maps_snapshot_new (guint64 dl_generation,
+                            guint layout_generation)
+{
+  GumProcMapsSnapshot * snapshot;
+
+  snapshot = g_slice_new (GumProcMapsSnapshot);
+  snapshot->ref_count = 1;
+  snapshot->dl_generation = dl_generation;
+  snapshot->layout_generation = layout_generation;
+  snapshot->entries = g_array_new (FALSE, FALSE, sizeof (GumProcMapsEntry));
+  snapshot->file_paths = g_string_chunk_new (512);
+
+  gum_linux_enumerate_ranges (getpid (), GUM_PAGE_NO_ACCESS,
+      gum_proc_maps_snapshot_collect, snapshot);
+
+  return snapshot;
+}
+
+static gboolean
+gum_proc_maps_snapshot_collect (const GumRangeDetails * details,
+                                gpointer user_data)
+{
+  GumProcMapsSnapshot * snapshot = user_data;
+  GumProcMapsEntry entry;
+
+  entry.range = *details->range;
+  entry.protection = details->protection;
+  if (details->file != NULL)
+  {
+    entry.file_offset = details->file->offset;
+    entry.file_path = g_string_chunk_insert (snapshot->file_paths,
+        details->file->path);
+  }
+  else
+  {
+    entry.file_offset = 0;
+    entry.file_path = NULL;
+  }
+
+  g_array_append_val (snapshot->entries, entry);
+
+  return TRUE;
+}
+
+static gboolean
+gum_proc_maps_snapshot_emit (GumProcMapsSnapshot * self,
+                             GumPageProtection prot,
+                             GumFoundRangeFunc func,
+                             gpointer user_data)
+{
+  guint i;
+
+  for (i = 0; i != self->entries->len; i++)
+  {
+    GumProcMapsEntry * entry =
+        &g_array_index (self->entries, GumProcMapsEntry, i);
+    GumRangeDetails details;
+    GumFileMapping file;
+
+    if ((entry->protection & prot) != prot)
+      continue;
+
+    details.range = &entry->range;
+    details.protection = entry->protection;
+    if (entry->file_path != NULL)
+    {
+      file.path = entry->file_path;
+      file.offset = entry->file_offset;
+      file.size = 0;
+      details.file = &file;
+    }
+    else
+    {
+      details.file = NULL;
+    }
+
+    if (!func (&details, user_data))
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+static void
+gum_proc_maps_snapshot_unref (GumProcMapsSnapshot * self)
+{
+  if (!g_atomic_int_dec_and_test (&self->ref_count))
+    return;
+
+  g_string_chunk_free (self->file_paths);
+  g_array_free (self->entries, TRUE);
+  g_slice_free (GumProcMapsSnapshot, self);
 }
 
 void
@@ -1693,8 +2305,8 @@ gum_module_find_base_address (const gchar * module_name)
 }
 
 GumAddress
-gum_module_find_export_by_name (const gchar * module_name,
-                                const gchar * symbol_name)
+_gum_module_find_export_by_name (const gchar * module_name,
+                                 const gchar * symbol_name)
 {
   GumAddress result;
   void * module;
@@ -41,6 +41,19 @@ gum_stalker_exclude (GumStalker * self,
 {
 }
 
+void
+gum_stalker_exclude_module_map (GumStalker * self,
+                                GumModuleMap * map)
+{
+}
+
+void
+gum_stalker_set_event_mask_for_range (GumStalker * self,
+                                      const GumMemoryRange * range,
+                                      GumEventType mask)
+{
+}
+
 gint
 gum_stalker_get_trust_threshold (GumStalker * self)
 {
@@ -53,6 +66,58 @@ gum_stalker_set_trust_threshold (GumStalker * self,
 {
 }
 
+gboolean
+gum_stalker_get_trusts_immutable_code (GumStalker * self)
+{
+  return FALSE;
+}
+
+void
+gum_stalker_set_trusts_immutable_code (GumStalker * self,
+                                       gboolean trusts_immutable_code)
+{
+}
+
+void
+gum_stalker_set_coverage_bitmap (GumStalker * self,
+                                 guint8 * bitmap,
+                                 gsize size)
+{
+}
+
+gsize
+gum_stalker_get_code_memory_limit (GumStalker * self)
+{
+  return 0;
+}
+
+void
+gum_stalker_set_code_memory_limit (GumStalker * self,
+                                   gsize limit)
+{
+}
+
+void
+gum_stalker_set_background_compilation (GumStalker * self,
+                                        gboolean enabled)
+{
+}
+
+gboolean
+gum_stalker_query_stats (GumStalker * self,
+                         GumThreadId thread_id,
+                         GumStalkerStats * stats)
+{
+  return FALSE;
+}
+
+void
+gum_stalker_prefetch (GumStalker * self,
+                      gconstpointer address,
+                      gint recycle_count)
+{
+}
+
 void
 gum_stalker_flush (GumStalker * self)
 {
@@ -147,3 +212,12 @@ gum_stalker_iterator_put_callout (GumStalkerIterator * self,
                                   GDestroyNotify data_destroy)
 {
 }
+
+void
+gum_stalker_iterator_put_callout_with_flags (GumStalkerIterator * self,
+                                             GumStalkerCallout callout,
+                                             gpointer data,
+                                             GDestroyNotify data_destroy,
+                                             GumStalkerCalloutFlags flags)
+{
+}
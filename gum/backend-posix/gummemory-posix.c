@@ -144,9 +144,14 @@ gum_try_alloc_in_range_if_near_enough (const GumRangeDetails * details,
   ctx->result = mmap (GSIZE_TO_POINTER (base_address), ctx->size,
       ctx->posix_page_prot, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
   if (ctx->result == MAP_FAILED)
+  {
     ctx->result = NULL;
+  }
   else
+  {
+    _gum_memory_bump_layout_generation ();
     return FALSE;
+  }
 
   return TRUE;
 }
@@ -223,15 +228,24 @@ gum_allocate_page_aligned (gpointer address,
   gpointer result;
 
   result = mmap (address, size, prot, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (result == MAP_FAILED)
+    return NULL;
+
+  _gum_memory_bump_layout_generation ();
 
-  return (result != MAP_FAILED) ? result : NULL;
+  return result;
 }
 
 gboolean
 gum_memory_free (gpointer address,
                  gsize size)
 {
-  return munmap (address, size) == 0;
+  if (munmap (address, size) != 0)
+    return FALSE;
+
+  _gum_memory_bump_layout_generation ();
+
+  return TRUE;
 }
 
 gboolean
@@ -274,6 +288,12 @@ gum_enumerate_free_ranges (GumFoundRangeFunc func,
 {
   GumEnumerateFreeRangesContext ctx = { func, user_data, 0 };
 
+  /*
+   * We are about to claim one of the gaps with MAP_FIXED, so make sure any
+   * cached view of the address space is refreshed before we trust it.
+   */
+  _gum_memory_bump_layout_generation ();
+
   _gum_process_enumerate_ranges (GUM_PAGE_NO_ACCESS, gum_emit_free_range, &ctx);
 }
 
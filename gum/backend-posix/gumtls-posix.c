@@ -8,6 +8,31 @@
 
 #include <pthread.h>
 
+/*
+ * Two pthread_getspecific calls per hook invocation are a measurable
+ * slice of the interceptor's minimal overhead, so the first few keys are
+ * served from a small set of compiler-TLS slots addressed directly off
+ * the thread pointer. The initial-exec model keeps each access to a
+ * single thread-pointer-relative load and never allocates on first use,
+ * which also keeps it safe from awkward contexts. Keys beyond the fixed
+ * slots fall back to pthread keys.
+ */
+#if defined (HAVE_LINUX) && defined (__GNUC__)
+# define GUM_TLS_HAVE_COMPILER_TLS 1
+#endif
+
+#ifdef GUM_TLS_HAVE_COMPILER_TLS
+
+# define GUM_TLS_NUM_STATIC_SLOTS 8
+# define GUM_TLS_STATIC_KEY_FLAG \
+    ((gsize) 1 << ((8 * GLIB_SIZEOF_VOID_P) - 1))
+
+static __thread gpointer gum_tls_static_slots[GUM_TLS_NUM_STATIC_SLOTS]
+    __attribute__ ((tls_model ("initial-exec")));
+static volatile gint gum_tls_static_slot_allocated[GUM_TLS_NUM_STATIC_SLOTS];
+
+#endif
+
 void
 _gum_tls_init (void)
 {
@@ -28,6 +53,19 @@ gum_tls_key_new (void)
 {
   pthread_key_t key;
 
+#ifdef GUM_TLS_HAVE_COMPILER_TLS
+  guint i;
+
+  for (i = 0; i != GUM_TLS_NUM_STATIC_SLOTS; i++)
+  {
+    if (g_atomic_int_compare_and_exchange (&gum_tls_static_slot_allocated[i],
+        FALSE, TRUE))
+    {
+      return GUM_TLS_STATIC_KEY_FLAG | i;
+    }
+  }
+#endif
+
   pthread_key_create (&key, NULL);
 
   return key;
@@ -36,12 +74,33 @@ gum_tls_key_new (void)
 void
 gum_tls_key_free (GumTlsKey key)
 {
+#ifdef GUM_TLS_HAVE_COMPILER_TLS
+  if ((key & GUM_TLS_STATIC_KEY_FLAG) != 0)
+  {
+    /*
+     * Static slots are retired, not recycled: we can only clear the
+     * calling thread's copy here, so handing the slot to a new key could
+     * expose stale values left behind by other threads. pthread keys
+     * guarantee NULL in every thread upon reuse, and gum_tls_key_new()
+     * falls back to them once the static slots are gone.
+     */
+    gum_tls_static_slots[key & ~GUM_TLS_STATIC_KEY_FLAG] = NULL;
+
+    return;
+  }
+#endif
+
   pthread_key_delete (key);
 }
 
 gpointer
 gum_tls_key_get_value (GumTlsKey key)
 {
+#ifdef GUM_TLS_HAVE_COMPILER_TLS
+  if ((key & GUM_TLS_STATIC_KEY_FLAG) != 0)
+    return gum_tls_static_slots[key & ~GUM_TLS_STATIC_KEY_FLAG];
+#endif
+
   return pthread_getspecific (key);
 }
 
@@ -49,5 +108,13 @@ void
 gum_tls_key_set_value (GumTlsKey key,
                        gpointer value)
 {
+#ifdef GUM_TLS_HAVE_COMPILER_TLS
+  if ((key & GUM_TLS_STATIC_KEY_FLAG) != 0)
+  {
+    gum_tls_static_slots[key & ~GUM_TLS_STATIC_KEY_FLAG] = value;
+    return;
+  }
+#endif
+
   pthread_setspecific (key, value);
 }
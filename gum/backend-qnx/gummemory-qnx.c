@@ -32,7 +32,7 @@ gum_memory_is_readable (gconstpointer address,
   return size >= len && (prot & GUM_PAGE_READ) != 0;
 }
 
-static gboolean
+gboolean
 gum_memory_is_writable (gconstpointer address,
                         gsize len)
 {
@@ -161,7 +161,12 @@ gum_try_mprotect (gpointer address,
     close (fd);
   }
 
-  return result == 0;
+  if (result != 0)
+    return FALSE;
+
+  _gum_memory_bump_layout_generation ();
+
+  return TRUE;
 }
 
 void
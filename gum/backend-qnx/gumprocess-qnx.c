@@ -225,6 +225,51 @@ gum_process_modify_thread (GumThreadId thread_id,
   return success;
 }
 
+struct _GumThreadSuspension
+{
+  GumThreadId * thread_ids;
+  guint n_threads;
+};
+
+GumThreadSuspension *
+_gum_process_suspend_threads (const GumThreadId * thread_ids,
+                              guint n_threads)
+{
+  GumThreadSuspension * suspension;
+  guint i;
+
+  for (i = 0; i != n_threads; i++)
+  {
+    if (ThreadCtl (_NTO_TCTL_ONE_THREAD_HOLD, (void *) thread_ids[i]) == -1)
+      goto failure;
+  }
+
+  suspension = g_slice_new (GumThreadSuspension);
+  suspension->thread_ids =
+      g_memdup (thread_ids, n_threads * sizeof (GumThreadId));
+  suspension->n_threads = n_threads;
+
+  return suspension;
+
+failure:
+  while (i != 0)
+    ThreadCtl (_NTO_TCTL_ONE_THREAD_CONT, (void *) thread_ids[--i]);
+
+  return NULL;
+}
+
+void
+_gum_process_resume_threads (GumThreadSuspension * suspension)
+{
+  guint i;
+
+  for (i = 0; i != suspension->n_threads; i++)
+    ThreadCtl (_NTO_TCTL_ONE_THREAD_CONT, (void *) suspension->thread_ids[i]);
+
+  g_free (suspension->thread_ids);
+  g_slice_free (GumThreadSuspension, suspension);
+}
+
 void
 _gum_process_enumerate_threads (GumFoundThreadFunc func,
                                 gpointer user_data)
@@ -339,6 +384,12 @@ _gum_process_enumerate_ranges (GumPageProtection prot,
   gum_qnx_enumerate_ranges (getpid (), prot, func, user_data);
 }
 
+gboolean
+_gum_process_try_query_module_generation (guint64 * generation)
+{
+  return FALSE;
+}
+
 void
 gum_process_enumerate_malloc_ranges (GumFoundMallocRangeFunc func,
                                      gpointer user_data)
@@ -704,8 +755,8 @@ gum_module_find_base_address (const gchar * module_name)
 }
 
 GumAddress
-gum_module_find_export_by_name (const gchar * module_name,
-                                const gchar * symbol_name)
+_gum_module_find_export_by_name (const gchar * module_name,
+                                 const gchar * symbol_name)
 {
   GumAddress result;
   void * module;
@@ -49,6 +49,18 @@ gum_memory_is_readable (gconstpointer address,
   return (prot & GUM_PAGE_READ) != 0;
 }
 
+gboolean
+gum_memory_is_writable (gconstpointer address,
+                        gsize len)
+{
+  GumPageProtection prot;
+
+  if (!gum_memory_get_protection (address, len, &prot))
+    return FALSE;
+
+  return (prot & GUM_PAGE_WRITE) != 0;
+}
+
 guint8 *
 gum_memory_read (gconstpointer address,
                  gsize len,
@@ -114,7 +126,12 @@ gum_try_mprotect (gpointer address,
 
   win_page_prot = gum_page_protection_to_windows (page_prot);
 
-  return VirtualProtect (address, size, win_page_prot, &old_protect);
+  if (!VirtualProtect (address, size, win_page_prot, &old_protect))
+    return FALSE;
+
+  _gum_memory_bump_layout_generation ();
+
+  return TRUE;
 }
 
 void
@@ -181,6 +198,9 @@ gum_try_alloc_n_pages_near (guint n_pages,
   }
   while (result == NULL);
 
+  if (result != NULL)
+    _gum_memory_bump_layout_generation ();
+
   return result;
 }
 
@@ -200,6 +220,8 @@ gum_free_pages (gpointer mem)
 
   success = VirtualFree (mem, 0, MEM_RELEASE);
   g_assert (success);
+
+  _gum_memory_bump_layout_generation ();
 }
 
 gpointer
@@ -244,7 +266,10 @@ gum_memory_allocate (gpointer address,
     aligned_base = GUM_ALIGN_POINTER (gpointer, base, alignment);
     base = VirtualAlloc (aligned_base, size, allocation_type, win_prot);
     if (base != NULL)
+    {
+      _gum_memory_bump_layout_generation ();
       break;
+    }
   }
 
   return base;
@@ -268,6 +293,9 @@ gum_virtual_alloc (gpointer address,
     result = VirtualAlloc (NULL, size, allocation_type, page_protection);
   }
 
+  if (result != NULL)
+    _gum_memory_bump_layout_generation ();
+
   return result;
 }
 
@@ -275,14 +303,24 @@ gboolean
 gum_memory_free (gpointer address,
                  gsize size)
 {
-  return VirtualFree (address, 0, MEM_RELEASE);
+  if (!VirtualFree (address, 0, MEM_RELEASE))
+    return FALSE;
+
+  _gum_memory_bump_layout_generation ();
+
+  return TRUE;
 }
 
 gboolean
 gum_memory_release (gpointer address,
                     gsize size)
 {
-  return VirtualFree (address, size, MEM_DECOMMIT);
+  if (!VirtualFree (address, size, MEM_DECOMMIT))
+    return FALSE;
+
+  _gum_memory_bump_layout_generation ();
+
+  return TRUE;
 }
 
 gboolean
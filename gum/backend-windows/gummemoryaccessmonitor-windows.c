@@ -173,6 +173,13 @@ gum_memory_access_monitor_new (const GumMemoryRange * ranges,
   return monitor;
 }
 
+void
+gum_memory_access_monitor_set_needs_from (GumMemoryAccessMonitor * self,
+                                          gboolean needs_from)
+{
+  /* The guard-page implementation always reports `from`. */
+}
+
 gboolean
 gum_memory_access_monitor_enable (GumMemoryAccessMonitor * self,
                                   GError ** error)
@@ -133,6 +133,72 @@ beach:
   return success;
 }
 
+struct _GumThreadSuspension
+{
+  HANDLE * threads;
+  guint n_threads;
+};
+
+GumThreadSuspension *
+_gum_process_suspend_threads (const GumThreadId * thread_ids,
+                              guint n_threads)
+{
+  GumThreadSuspension * suspension;
+  HANDLE * threads;
+  guint n_suspended, i;
+
+  threads = g_new (HANDLE, n_threads);
+
+  for (n_suspended = 0; n_suspended != n_threads; n_suspended++)
+  {
+    HANDLE thread;
+
+    thread = OpenThread (THREAD_SUSPEND_RESUME, FALSE,
+        thread_ids[n_suspended]);
+    if (thread == NULL)
+      goto failure;
+
+    if (SuspendThread (thread) == (DWORD) -1)
+    {
+      CloseHandle (thread);
+      goto failure;
+    }
+
+    threads[n_suspended] = thread;
+  }
+
+  suspension = g_slice_new (GumThreadSuspension);
+  suspension->threads = threads;
+  suspension->n_threads = n_threads;
+
+  return suspension;
+
+failure:
+  for (i = 0; i != n_suspended; i++)
+  {
+    ResumeThread (threads[i]);
+    CloseHandle (threads[i]);
+  }
+  g_free (threads);
+
+  return NULL;
+}
+
+void
+_gum_process_resume_threads (GumThreadSuspension * suspension)
+{
+  guint i;
+
+  for (i = 0; i != suspension->n_threads; i++)
+  {
+    ResumeThread (suspension->threads[i]);
+    CloseHandle (suspension->threads[i]);
+  }
+
+  g_free (suspension->threads);
+  g_slice_free (GumThreadSuspension, suspension);
+}
+
 void
 _gum_process_enumerate_threads (GumFoundThreadFunc func,
                                 gpointer user_data)
@@ -337,6 +403,12 @@ _gum_process_enumerate_ranges (GumPageProtection prot,
   }
 }
 
+gboolean
+_gum_process_try_query_module_generation (guint64 * generation)
+{
+  return FALSE;
+}
+
 void
 gum_process_enumerate_malloc_ranges (GumFoundMallocRangeFunc func,
                                      gpointer user_data)
@@ -680,8 +752,8 @@ gum_module_find_base_address (const gchar * module_name)
 }
 
 GumAddress
-gum_module_find_export_by_name (const gchar * module_name,
-                                const gchar * symbol_name)
+_gum_module_find_export_by_name (const gchar * module_name,
+                                 const gchar * symbol_name)
 {
   if (module_name == NULL)
   {
@@ -26,6 +26,13 @@
 #define GUM_FRAME_OFFSET_TOP \
     (GUM_FRAME_OFFSET_NEXT_HOP + sizeof (gpointer))
 
+typedef enum _GumPrologueState
+{
+  GUM_PROLOGUE_UNKNOWN,
+  GUM_PROLOGUE_RELOCATABLE,
+  GUM_PROLOGUE_NOT_RELOCATABLE
+} GumPrologueState;
+
 struct _GumInterceptorBackend
 {
   GumCodeAllocator * allocator;
@@ -35,6 +42,17 @@ struct _GumInterceptorBackend
 
   GumCodeSlice * enter_thunk;
   GumCodeSlice * leave_thunk;
+  GumCodeSlice * probe_thunk;
+
+  /*
+   * Relocatability classifications from previous attach attempts, keyed
+   * by function address. Mass attach sessions that revisit functions —
+   * retries after a partial bring-up, or detach/re-attach cycles — skip
+   * the relocator probe entirely. Detaching restores the original
+   * prologue bytes, so a classification stays valid for the lifetime of
+   * the process unless third-party code rewrites the prologue.
+   */
+  GHashTable * prologue_states;
 };
 
 static void gum_interceptor_backend_create_thunks (
@@ -45,6 +63,8 @@ static void gum_interceptor_backend_destroy_thunks (
 static void gum_emit_enter_thunk (GumX86Writer * cw);
 static void gum_emit_leave_thunk (GumX86Writer * cw);
 
+static void gum_emit_probe_thunk (GumX86Writer * cw);
+
 static void gum_emit_prolog (GumX86Writer * cw,
     gssize stack_displacement);
 static void gum_emit_epilog (GumX86Writer * cw);
@@ -60,6 +80,8 @@ _gum_interceptor_backend_create (GumCodeAllocator * allocator)
   gum_x86_writer_init (&backend->writer, NULL);
   gum_x86_relocator_init (&backend->relocator, NULL, &backend->writer);
 
+  backend->prologue_states = g_hash_table_new (NULL, NULL);
+
   gum_interceptor_backend_create_thunks (backend);
 
   return backend;
@@ -70,6 +92,8 @@ _gum_interceptor_backend_destroy (GumInterceptorBackend * backend)
 {
   gum_interceptor_backend_destroy_thunks (backend);
 
+  g_hash_table_unref (backend->prologue_states);
+
   gum_x86_relocator_clear (&backend->relocator);
   gum_x86_writer_clear (&backend->writer);
 
@@ -103,11 +127,22 @@ _gum_interceptor_backend_create_trampoline (GumInterceptorBackend * self,
 {
   GumX86Writer * cw = &self->writer;
   GumX86Relocator * rl = &self->relocator;
+  GumPrologueState state;
   GumAddress function_ctx_ptr;
   guint reloc_bytes;
 
-  if (!gum_x86_relocator_can_relocate (ctx->function_address,
-      GUM_INTERCEPTOR_REDIRECT_CODE_SIZE, NULL))
+  state = GPOINTER_TO_INT (g_hash_table_lookup (self->prologue_states,
+      ctx->function_address));
+  if (state == GUM_PROLOGUE_UNKNOWN)
+  {
+    state = gum_x86_relocator_can_relocate (ctx->function_address,
+        GUM_INTERCEPTOR_REDIRECT_CODE_SIZE, NULL)
+        ? GUM_PROLOGUE_RELOCATABLE
+        : GUM_PROLOGUE_NOT_RELOCATABLE;
+    g_hash_table_insert (self->prologue_states, ctx->function_address,
+        GINT_TO_POINTER (state));
+  }
+  if (state == GUM_PROLOGUE_NOT_RELOCATABLE)
     return FALSE;
 
   if (!gum_interceptor_backend_prepare_trampoline (self, ctx))
@@ -116,17 +151,28 @@ _gum_interceptor_backend_create_trampoline (GumInterceptorBackend * self,
   gum_x86_writer_reset (cw, ctx->trampoline_slice->data);
 
   function_ctx_ptr = GUM_ADDRESS (gum_x86_writer_cur (cw));
-  gum_x86_writer_put_bytes (cw, (guint8 *) &ctx, sizeof (GumFunctionContext *));
+  gum_x86_writer_put_bytes (cw, (guint8 *) &ctx,
+      sizeof (GumFunctionContext *));
 
-  ctx->on_enter_trampoline = gum_x86_writer_cur (cw);
+  if (ctx->probe_func != NULL)
+  {
+    ctx->on_enter_trampoline = gum_x86_writer_cur (cw);
+
+    gum_x86_writer_put_push_near_ptr (cw, function_ctx_ptr);
+    gum_x86_writer_put_jmp_address (cw, GUM_ADDRESS (self->probe_thunk->data));
+  }
+  else
+  {
+    ctx->on_enter_trampoline = gum_x86_writer_cur (cw);
 
-  gum_x86_writer_put_push_near_ptr (cw, function_ctx_ptr);
-  gum_x86_writer_put_jmp_address (cw, GUM_ADDRESS (self->enter_thunk->data));
+    gum_x86_writer_put_push_near_ptr (cw, function_ctx_ptr);
+    gum_x86_writer_put_jmp_address (cw, GUM_ADDRESS (self->enter_thunk->data));
 
-  ctx->on_leave_trampoline = gum_x86_writer_cur (cw);
+    ctx->on_leave_trampoline = gum_x86_writer_cur (cw);
 
-  gum_x86_writer_put_push_near_ptr (cw, function_ctx_ptr);
-  gum_x86_writer_put_jmp_address (cw, GUM_ADDRESS (self->leave_thunk->data));
+    gum_x86_writer_put_push_near_ptr (cw, function_ctx_ptr);
+    gum_x86_writer_put_jmp_address (cw, GUM_ADDRESS (self->leave_thunk->data));
+  }
 
   gum_x86_writer_flush (cw);
   g_assert (gum_x86_writer_offset (cw) <= ctx->trampoline_slice->size);
@@ -229,11 +275,19 @@ gum_interceptor_backend_create_thunks (GumInterceptorBackend * self)
   gum_emit_leave_thunk (cw);
   gum_x86_writer_flush (cw);
   g_assert (gum_x86_writer_offset (cw) <= self->leave_thunk->size);
+
+  self->probe_thunk = gum_code_allocator_alloc_slice (self->allocator);
+  gum_x86_writer_reset (cw, self->probe_thunk->data);
+  gum_emit_probe_thunk (cw);
+  gum_x86_writer_flush (cw);
+  g_assert (gum_x86_writer_offset (cw) <= self->probe_thunk->size);
 }
 
 static void
 gum_interceptor_backend_destroy_thunks (GumInterceptorBackend * self)
 {
+  gum_code_slice_free (self->probe_thunk);
+
   gum_code_slice_free (self->leave_thunk);
 
   gum_code_slice_free (self->enter_thunk);
@@ -284,6 +338,129 @@ gum_emit_leave_thunk (GumX86Writer * cw)
   gum_emit_epilog (cw);
 }
 
+/*
+ * Probes bypass the invocation machinery: spill only the caller-saved
+ * integer registers, call the plain C function, and continue into the
+ * relocated prologue. The thunk is shared between all probes; each hook
+ * merely pushes its GumFunctionContext, from which the probe function
+ * and data are loaded at runtime, and the final ret consumes the slot
+ * holding the context after it has been rewritten to point at the
+ * hook's on_invoke trampoline.
+ */
+static void
+gum_emit_probe_thunk (GumX86Writer * cw)
+{
+#if GLIB_SIZEOF_VOID_P == 8
+  const guint num_saved_regs = 10;
+#else
+  const guint num_saved_regs = 4;
+#endif
+  const gssize ctx_offset =
+      (num_saved_regs + /* cpu flags */ 1) * sizeof (gpointer);
+
+  gum_x86_writer_put_pushfx (cw);
+  gum_x86_writer_put_cld (cw); /* C ABI mandates this */
+
+  gum_x86_writer_put_push_reg (cw, GUM_REG_XAX);
+  gum_x86_writer_put_push_reg (cw, GUM_REG_XCX);
+  gum_x86_writer_put_push_reg (cw, GUM_REG_XDX);
+#if GLIB_SIZEOF_VOID_P == 8
+  gum_x86_writer_put_push_reg (cw, GUM_REG_XSI);
+  gum_x86_writer_put_push_reg (cw, GUM_REG_XDI);
+  gum_x86_writer_put_push_reg (cw, GUM_REG_R8);
+  gum_x86_writer_put_push_reg (cw, GUM_REG_R9);
+  gum_x86_writer_put_push_reg (cw, GUM_REG_R10);
+  gum_x86_writer_put_push_reg (cw, GUM_REG_R11);
+#endif
+  gum_x86_writer_put_push_reg (cw, GUM_REG_XBX);
+
+  gum_x86_writer_put_mov_reg_reg (cw, GUM_REG_XBX, GUM_REG_XSP);
+  gum_x86_writer_put_and_reg_u32 (cw, GUM_REG_XSP, (guint32) ~(16 - 1));
+
+#if GLIB_SIZEOF_VOID_P == 8
+  if (cw->target_abi == GUM_ABI_WINDOWS)
+  {
+    gum_x86_writer_put_mov_reg_reg_offset_ptr (cw, GUM_REG_RAX, GUM_REG_RBX,
+        ctx_offset);
+
+    gum_x86_writer_put_mov_reg_reg (cw, GUM_REG_R9, GUM_REG_R8);
+    gum_x86_writer_put_mov_reg_reg (cw, GUM_REG_R8, GUM_REG_RDX);
+    gum_x86_writer_put_mov_reg_reg (cw, GUM_REG_RDX, GUM_REG_RCX);
+    gum_x86_writer_put_mov_reg_reg_offset_ptr (cw, GUM_REG_RCX, GUM_REG_RAX,
+        G_STRUCT_OFFSET (GumFunctionContext, probe_data));
+    gum_x86_writer_put_mov_reg_reg_offset_ptr (cw, GUM_REG_RAX, GUM_REG_RAX,
+        G_STRUCT_OFFSET (GumFunctionContext, probe_func));
+
+    gum_x86_writer_put_sub_reg_imm (cw, GUM_REG_RSP, 0x20);
+    gum_x86_writer_put_call_reg (cw, GUM_REG_RAX);
+  }
+  else
+  {
+    gum_x86_writer_put_mov_reg_reg_offset_ptr (cw, GUM_REG_RAX, GUM_REG_RBX,
+        ctx_offset);
+
+    gum_x86_writer_put_mov_reg_reg (cw, GUM_REG_RCX, GUM_REG_RDX);
+    gum_x86_writer_put_mov_reg_reg (cw, GUM_REG_RDX, GUM_REG_RSI);
+    gum_x86_writer_put_mov_reg_reg (cw, GUM_REG_RSI, GUM_REG_RDI);
+    gum_x86_writer_put_mov_reg_reg_offset_ptr (cw, GUM_REG_RDI, GUM_REG_RAX,
+        G_STRUCT_OFFSET (GumFunctionContext, probe_data));
+    gum_x86_writer_put_mov_reg_reg_offset_ptr (cw, GUM_REG_RAX, GUM_REG_RAX,
+        G_STRUCT_OFFSET (GumFunctionContext, probe_func));
+
+    gum_x86_writer_put_call_reg (cw, GUM_REG_RAX);
+  }
+#else
+  {
+    const gssize caller_args_offset =
+        ctx_offset + /* function context */ 4 + /* return address */ 4;
+    guint i;
+
+    /* the caller's arguments live above our saved state */
+    for (i = 3; i != 0; i--)
+    {
+      gum_x86_writer_put_mov_reg_reg_offset_ptr (cw, GUM_REG_EAX, GUM_REG_EBX,
+          caller_args_offset + ((i - 1) * sizeof (gpointer)));
+      gum_x86_writer_put_push_reg (cw, GUM_REG_EAX);
+    }
+    gum_x86_writer_put_mov_reg_reg_offset_ptr (cw, GUM_REG_EAX, GUM_REG_EBX,
+        ctx_offset);
+    gum_x86_writer_put_mov_reg_reg_offset_ptr (cw, GUM_REG_ECX, GUM_REG_EAX,
+        G_STRUCT_OFFSET (GumFunctionContext, probe_data));
+    gum_x86_writer_put_push_reg (cw, GUM_REG_ECX);
+    gum_x86_writer_put_mov_reg_reg_offset_ptr (cw, GUM_REG_EAX, GUM_REG_EAX,
+        G_STRUCT_OFFSET (GumFunctionContext, probe_func));
+
+    gum_x86_writer_put_call_reg (cw, GUM_REG_EAX);
+  }
+#endif
+
+  gum_x86_writer_put_mov_reg_reg_offset_ptr (cw, GUM_REG_XAX, GUM_REG_XBX,
+      ctx_offset);
+  gum_x86_writer_put_mov_reg_reg_offset_ptr (cw, GUM_REG_XAX, GUM_REG_XAX,
+      G_STRUCT_OFFSET (GumFunctionContext, on_invoke_trampoline));
+  gum_x86_writer_put_mov_reg_offset_ptr_reg (cw, GUM_REG_XBX, ctx_offset,
+      GUM_REG_XAX);
+
+  gum_x86_writer_put_mov_reg_reg (cw, GUM_REG_XSP, GUM_REG_XBX);
+
+  gum_x86_writer_put_pop_reg (cw, GUM_REG_XBX);
+#if GLIB_SIZEOF_VOID_P == 8
+  gum_x86_writer_put_pop_reg (cw, GUM_REG_R11);
+  gum_x86_writer_put_pop_reg (cw, GUM_REG_R10);
+  gum_x86_writer_put_pop_reg (cw, GUM_REG_R9);
+  gum_x86_writer_put_pop_reg (cw, GUM_REG_R8);
+  gum_x86_writer_put_pop_reg (cw, GUM_REG_XDI);
+  gum_x86_writer_put_pop_reg (cw, GUM_REG_XSI);
+#endif
+  gum_x86_writer_put_pop_reg (cw, GUM_REG_XDX);
+  gum_x86_writer_put_pop_reg (cw, GUM_REG_XCX);
+  gum_x86_writer_put_pop_reg (cw, GUM_REG_XAX);
+
+  gum_x86_writer_put_popfx (cw);
+
+  gum_x86_writer_put_ret (cw);
+}
+
 static void
 gum_emit_prolog (GumX86Writer * cw,
                  gssize stack_displacement)
@@ -12,8 +12,10 @@
 #include "gumx86reader.h"
 #include "gumx86writer.h"
 #include "gummemory.h"
+#include "gummodulemap.h"
 #include "gumx86relocator.h"
 #include "gumspinlock.h"
+#include "gumstats.h"
 #include "gumtls.h"
 #ifdef HAVE_WINDOWS
 # include "gumexceptor.h"
@@ -21,6 +23,11 @@
 
 #include <stdlib.h>
 #include <string.h>
+#ifdef HAVE_LINUX
+# include <sys/mman.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
 #ifdef HAVE_WINDOWS
 # define VC_EXTRALEAN
 # include <windows.h>
@@ -28,15 +35,30 @@
 # include <tchar.h>
 #endif
 
-#define GUM_CODE_ALIGNMENT                     8
+/*
+ * Blocks start on their own cacheline so that runtime updates to the
+ * GumExecBlock header preceding the code never dirty lines holding
+ * instructions.
+ */
+#define GUM_CODE_ALIGNMENT                    64
 #define GUM_DATA_ALIGNMENT                     8
 #define GUM_CODE_SLAB_SIZE_IN_PAGES         1024
 #define GUM_EXEC_BLOCK_MIN_SIZE             2048
+#define GUM_COLD_STUB_MAX_SIZE               256
+#define GUM_IC_ENTRIES                         4
+#define GUM_IC_MISS_THRESHOLD                  8
+#define GUM_EVENT_BATCH_CAPACITY             256
+#define GUM_EXEC_CTX_POOL_CAPACITY             4
+#define GUM_PROBE_FILTER_BITS               4096
+#define GUM_PROBE_FILTER_WORD_BITS          (8 * sizeof (gsize))
+#define GUM_PROBE_FILTER_NUM_WORDS \
+    (GUM_PROBE_FILTER_BITS / GUM_PROBE_FILTER_WORD_BITS)
 
 typedef struct _GumInfectContext GumInfectContext;
 typedef struct _GumDisinfectContext GumDisinfectContext;
 
 typedef struct _GumCallProbe GumCallProbe;
+typedef struct _GumEventMaskOverride GumEventMaskOverride;
 typedef struct _GumSlab GumSlab;
 
 typedef struct _GumExecFrame GumExecFrame;
@@ -54,6 +76,8 @@ typedef struct _GumGeneratorContext GumGeneratorContext;
 typedef struct _GumCalloutEntry GumCalloutEntry;
 typedef struct _GumInstruction GumInstruction;
 typedef struct _GumBranchTarget GumBranchTarget;
+typedef guint GumColdStubKind;
+typedef struct _GumColdStub GumColdStub;
 
 typedef guint GumVirtualizationRequirements;
 
@@ -74,15 +98,24 @@ struct _GumStalker
 
   GMutex mutex;
   GSList * contexts;
+  GSList * exec_ctx_pool;
+  guint exec_ctx_pool_size;
   GumTlsKey exec_ctx;
 
   GArray * exclusions;
+  GArray * event_mask_overrides;
   gint trust_threshold;
+  gboolean trusts_immutable_code;
+  gsize code_memory_limit;
+  gboolean background_compilation;
+  guint8 * coverage_bitmap;
+  gsize coverage_mask;
   volatile gboolean any_probes_attached;
   volatile gint last_probe_id;
   GumSpinlock probe_lock;
   GHashTable * probe_target_by_id;
   GHashTable * probe_array_by_address;
+  volatile gsize probe_filter[GUM_PROBE_FILTER_NUM_WORDS];
 
 #ifdef HAVE_WINDOWS
   GumExceptor * exceptor;
@@ -115,11 +148,20 @@ struct _GumCallProbe
   GDestroyNotify user_notify;
 };
 
+struct _GumEventMaskOverride
+{
+  GumMemoryRange range;
+  GumEventType mask;
+};
+
 struct _GumSlab
 {
   guint8 * data;
   guint offset;
   guint size;
+  guint64 last_used;
+  gboolean has_backpatch_targets;
+  gboolean hugepage;
   GumSlab * next;
 };
 
@@ -152,6 +194,7 @@ struct _GumExecCtx
 
   GumX86Writer code_writer;
   GumX86Relocator relocator;
+  GArray * cold_stubs;
 
   GumStalkerTransformer * transformer;
   void (* transform_block_impl) (GumStalkerTransformer * self,
@@ -161,8 +204,20 @@ struct _GumExecCtx
   GumEventSink * sink;
   gboolean sink_started;
   GumEventType sink_mask;
+  GumEventType active_mask;
   void (* sink_process_impl) (GumEventSink * self, const GumEvent * event,
       GumCpuContext * cpu_context);
+  void (* sink_process_batch_impl) (GumEventSink * self,
+      const GumEvent * events, guint n_events);
+  guint event_batch_len;
+  GumEvent event_batch[GUM_EVENT_BATCH_CAPACITY];
+  gsize coverage_prev;
+
+  GMutex compile_mutex;
+  GAsyncQueue * compile_requests;
+  GThread * compile_worker;
+
+  GumStalkerStats stats;
 
   gboolean unfollow_called_while_still_following;
   GumExecBlock * current_block;
@@ -182,6 +237,7 @@ struct _GumExecCtx
 
   GumSlab * code_slab;
   GumSlab first_code_slab;
+  guint64 usage_counter;
   gpointer last_prolog_minimal;
   gpointer last_epilog_minimal;
   gpointer last_prolog_full;
@@ -224,6 +280,7 @@ enum _GumExecBlockState
 enum _GumExecBlockFlags
 {
   GUM_EXEC_ACTIVATION_TARGET = (1 << 0),
+  GUM_EXEC_IMMUTABLE_SOURCE  = (1 << 1),
 };
 
 enum _GumPrologType
@@ -292,6 +349,26 @@ struct _GumBranchTarget
   guint8 scale;
 };
 
+enum _GumColdStubKind
+{
+  GUM_COLD_STUB_CALL_EVENT,
+  GUM_COLD_STUB_RET_EVENT,
+  GUM_COLD_STUB_EXEC_EVENT,
+  GUM_COLD_STUB_BLOCK_EVENT
+};
+
+struct _GumColdStub
+{
+  GumColdStubKind kind;
+  gconstpointer entry_label;
+  gconstpointer resume_label;
+  gpointer location;
+  GumBranchTarget target;
+  gpointer range_begin;
+  gpointer range_end;
+  GumCodeContext cc;
+};
+
 enum _GumVirtualizationRequirements
 {
   GUM_REQUIRE_NOTHING         = 0,
@@ -330,16 +407,31 @@ G_GNUC_INTERNAL void _gum_stalker_do_deactivate (GumStalker * self,
     gpointer * ret_addr_ptr);
 
 static void gum_stalker_free_probe_array (gpointer data);
+static void gum_stalker_probe_filter_compute (gpointer target_address,
+    guint * first_bit, guint * second_bit);
+static void gum_stalker_probe_filter_add (GumStalker * self,
+    gpointer target_address);
+static gboolean gum_stalker_probe_filter_may_contain (GumStalker * self,
+    gpointer target_address);
+static void gum_stalker_probe_filter_rebuild (GumStalker * self);
 
 static GumExecCtx * gum_stalker_create_exec_ctx (GumStalker * self,
     GumThreadId thread_id, GumStalkerTransformer * transformer,
     GumEventSink * sink);
 static void gum_stalker_destroy_exec_ctx (GumStalker * self, GumExecCtx * ctx);
+static GumExecCtx * gum_stalker_obtain_recycled_exec_ctx (GumStalker * self);
+static void gum_stalker_recycle_exec_ctx (GumStalker * self, GumExecCtx * ctx);
 static GumExecCtx * gum_stalker_get_exec_ctx (GumStalker * self);
 static void gum_stalker_invalidate_caches (GumStalker * self);
 
 static void gum_exec_ctx_dispose_callouts (GumExecCtx * ctx);
+static void gum_exec_ctx_reset (GumExecCtx * ctx);
 static void gum_exec_ctx_free (GumExecCtx * ctx);
+static void gum_exec_ctx_emit_event (GumExecCtx * ctx, const GumEvent * ev,
+    GumCpuContext * cpu_context);
+static void gum_exec_ctx_flush_event_batch (GumExecCtx * ctx);
+static void gum_exec_ctx_write_coverage_code (GumExecCtx * ctx,
+    gpointer real_address, GumX86Writer * cw);
 static gboolean gum_exec_ctx_maybe_unfollow (GumExecCtx * ctx,
     gpointer resume_at);
 static void gum_exec_ctx_unfollow (GumExecCtx * ctx, gpointer resume_at);
@@ -350,9 +442,15 @@ static gpointer GUM_THUNK gum_exec_ctx_replace_current_block_with (
 
 static GumExecBlock * gum_exec_ctx_obtain_block_for (GumExecCtx * ctx,
     gpointer real_address, gpointer * code_address);
+static GumExecBlock * gum_exec_ctx_obtain_block_unlocked (GumExecCtx * ctx,
+    gpointer real_address, gpointer * code_address);
+static gpointer gum_exec_ctx_compile_worker (gpointer data);
+static void gum_exec_ctx_maybe_queue_for_compilation (GumExecCtx * ctx,
+    const GumBranchTarget * target);
 
 static void gum_stalker_invoke_callout (GumCpuContext * cpu_context,
     GumCalloutEntry * entry);
+static void gum_stalker_invoke_minimal_callout (GumCalloutEntry * entry);
 
 static void gum_exec_ctx_write_prolog (GumExecCtx * ctx, GumPrologType type,
     GumX86Writer * cw);
@@ -396,6 +494,14 @@ static void gum_exec_ctx_load_real_register_from_ic_frame_into (
     GumExecCtx * ctx, GumCpuReg target_register, GumCpuReg source_register,
     gpointer ip, GumGeneratorContext * gc);
 
+static void gum_slab_bind_to_local_node (gpointer data, gsize size);
+static gboolean gum_slab_advise_huge_pages (gpointer data, gsize size);
+static void gum_exec_ctx_maybe_evict_code_slab (GumExecCtx * ctx);
+static gboolean gum_exec_ctx_slab_is_evictable (GumExecCtx * ctx,
+    GumSlab * slab);
+static gboolean gum_exec_block_is_in_slab (gpointer key, gpointer value,
+    gpointer user_data);
+
 static GumExecBlock * gum_exec_block_new (GumExecCtx * ctx);
 static GumExecBlock * gum_exec_block_obtain (GumExecCtx * ctx,
     gpointer real_address, gpointer * code_address);
@@ -409,6 +515,11 @@ static void gum_exec_block_backpatch_jmp (GumExecBlock * block,
     gpointer code_start, GumPrologType opened_prolog);
 static void gum_exec_block_backpatch_ret (GumExecBlock * block,
     gpointer code_start);
+static gpointer * gum_exec_block_write_inline_cache_table (GumExecBlock * block,
+    GumX86Writer * cw);
+static void gum_exec_block_write_inline_cache_lookup (GumExecBlock * block,
+    gpointer * ic_entries, GumX86Writer * cw,
+    gconstpointer resolve_dynamically);
 
 static GumVirtualizationRequirements gum_exec_block_virtualize_branch_insn (
     GumExecBlock * block, GumGeneratorContext * gc);
@@ -445,8 +556,20 @@ static void gum_exec_block_write_exec_event_code (GumExecBlock * block,
     GumGeneratorContext * gc, GumCodeContext cc);
 static void gum_exec_block_write_block_event_code (GumExecBlock * block,
     GumGeneratorContext * gc, GumCodeContext cc);
+static GumColdStub * gum_exec_block_request_cold_stub (GumExecBlock * block,
+    GumColdStubKind kind, GumGeneratorContext * gc, GumCodeContext cc);
+static void gum_exec_block_write_cold_stubs (GumExecBlock * block,
+    GumGeneratorContext * gc);
+static void gum_exec_block_write_cold_call_event_code (GumExecBlock * block,
+    const GumColdStub * stub, GumGeneratorContext * gc);
+static void gum_exec_block_write_cold_ret_event_code (GumExecBlock * block,
+    const GumColdStub * stub, GumGeneratorContext * gc);
+static void gum_exec_block_write_cold_exec_event_code (GumExecBlock * block,
+    const GumColdStub * stub, GumGeneratorContext * gc);
+static void gum_exec_block_write_cold_block_event_code (GumExecBlock * block,
+    const GumColdStub * stub, GumGeneratorContext * gc);
 static void gum_exec_block_write_unfollow_check_code (GumExecBlock * block,
-    GumGeneratorContext * gc, GumCodeContext cc);
+    gpointer location, GumGeneratorContext * gc, GumCodeContext cc);
 
 static void gum_exec_block_write_call_probe_code (GumExecBlock * block,
     const GumBranchTarget * target, GumGeneratorContext * gc);
@@ -508,7 +631,10 @@ static void
 gum_stalker_init (GumStalker * self)
 {
   self->exclusions = g_array_new (FALSE, FALSE, sizeof (GumMemoryRange));
+  self->event_mask_overrides =
+      g_array_new (FALSE, FALSE, sizeof (GumEventMaskOverride));
   self->trust_threshold = 1;
+  self->trusts_immutable_code = FALSE;
 
   gum_spinlock_init (&self->probe_lock);
   self->probe_target_by_id =
@@ -520,6 +646,8 @@ gum_stalker_init (GumStalker * self)
   self->cpu_features = gum_query_cpu_features ();
   g_mutex_init (&self->mutex);
   self->contexts = NULL;
+  self->exec_ctx_pool = NULL;
+  self->exec_ctx_pool_size = 0;
   self->exec_ctx = gum_tls_key_new ();
 
 #ifdef HAVE_WINDOWS
@@ -612,8 +740,17 @@ gum_stalker_finalize (GObject * object)
   g_hash_table_unref (self->probe_array_by_address);
   g_hash_table_unref (self->probe_target_by_id);
 
+  g_array_free (self->event_mask_overrides, TRUE);
   g_array_free (self->exclusions, TRUE);
 
+  while (self->exec_ctx_pool != NULL)
+  {
+    gum_exec_ctx_free (self->exec_ctx_pool->data);
+    self->exec_ctx_pool = g_slist_delete_link (self->exec_ctx_pool,
+        self->exec_ctx_pool);
+  }
+  self->exec_ctx_pool_size = 0;
+
   g_assert (self->contexts == NULL);
   gum_tls_key_free (self->exec_ctx);
   g_mutex_clear (&self->mutex);
@@ -627,11 +764,115 @@ gum_stalker_new (void)
   return g_object_new (GUM_TYPE_STALKER, NULL);
 }
 
+static gint
+gum_memory_range_compare_base (gconstpointer a,
+                               gconstpointer b)
+{
+  const GumMemoryRange * range_a = a;
+  const GumMemoryRange * range_b = b;
+
+  if (range_a->base_address < range_b->base_address)
+    return -1;
+  if (range_a->base_address > range_b->base_address)
+    return 1;
+  return 0;
+}
+
+static void
+gum_stalker_coalesce_exclusions (GumStalker * self)
+{
+  GArray * exclusions = self->exclusions;
+  guint i;
+
+  g_array_sort (exclusions, gum_memory_range_compare_base);
+
+  i = 1;
+  while (i < exclusions->len)
+  {
+    GumMemoryRange * prev = &g_array_index (exclusions, GumMemoryRange, i - 1);
+    GumMemoryRange * cur = &g_array_index (exclusions, GumMemoryRange, i);
+    GumAddress prev_end = prev->base_address + prev->size;
+    GumAddress cur_end = cur->base_address + cur->size;
+
+    if (cur->base_address <= prev_end)
+    {
+      if (cur_end > prev_end)
+        prev->size = cur_end - prev->base_address;
+      g_array_remove_index (exclusions, i);
+    }
+    else
+    {
+      i++;
+    }
+  }
+}
+
 void
 gum_stalker_exclude (GumStalker * self,
                      const GumMemoryRange * range)
 {
   g_array_append_val (self->exclusions, *range);
+
+  gum_stalker_coalesce_exclusions (self);
+}
+
+void
+gum_stalker_exclude_module_map (GumStalker * self,
+                                GumModuleMap * map)
+{
+  GArray * modules = gum_module_map_get_values (map);
+  guint i;
+
+  for (i = 0; i != modules->len; i++)
+  {
+    const GumModuleDetails * d =
+        &g_array_index (modules, GumModuleDetails, i);
+
+    g_array_append_val (self->exclusions, *d->range);
+  }
+
+  gum_stalker_coalesce_exclusions (self);
+}
+
+/*
+ * Overrides apply at translation time: blocks whose start address falls
+ * inside the given range are instrumented according to the override mask
+ * rather than the sink's process-wide mask. The first matching override
+ * wins. Like exclusions, overrides must be in place before the code they
+ * cover gets translated; already-compiled blocks are unaffected.
+ */
+void
+gum_stalker_set_event_mask_for_range (GumStalker * self,
+                                      const GumMemoryRange * range,
+                                      GumEventType mask)
+{
+  GumEventMaskOverride override;
+
+  override.range = *range;
+  override.mask = mask;
+
+  g_array_append_val (self->event_mask_overrides, override);
+}
+
+static GumEventType
+gum_stalker_query_sink_mask_for (GumStalker * self,
+                                 GumEventType sink_mask,
+                                 gconstpointer address)
+{
+  GArray * overrides = self->event_mask_overrides;
+  GumAddress needle = GUM_ADDRESS (address);
+  guint i;
+
+  for (i = 0; i != overrides->len; i++)
+  {
+    GumEventMaskOverride * o =
+        &g_array_index (overrides, GumEventMaskOverride, i);
+
+    if (GUM_MEMORY_RANGE_INCLUDES (&o->range, needle))
+      return o->mask;
+  }
+
+  return sink_mask;
 }
 
 static gboolean
@@ -639,13 +880,21 @@ gum_stalker_is_excluding (GumStalker * self,
                           gconstpointer address)
 {
   GArray * exclusions = self->exclusions;
-  guint i;
+  GumAddress needle = GUM_ADDRESS (address);
+  guint lower, upper;
 
-  for (i = 0; i != exclusions->len; i++)
+  lower = 0;
+  upper = exclusions->len;
+  while (lower != upper)
   {
-    GumMemoryRange * r = &g_array_index (exclusions, GumMemoryRange, i);
+    guint middle = (lower + upper) / 2;
+    GumMemoryRange * r = &g_array_index (exclusions, GumMemoryRange, middle);
 
-    if (GUM_MEMORY_RANGE_INCLUDES (r, GUM_ADDRESS (address)))
+    if (needle < r->base_address)
+      upper = middle;
+    else if (needle >= r->base_address + r->size)
+      lower = middle + 1;
+    else
       return TRUE;
   }
 
@@ -665,6 +914,103 @@ gum_stalker_set_trust_threshold (GumStalker * self,
   self->trust_threshold = trust_threshold;
 }
 
+gboolean
+gum_stalker_get_trusts_immutable_code (GumStalker * self)
+{
+  return self->trusts_immutable_code;
+}
+
+/*
+ * When enabled, a block whose source range lives on non-writable pages at
+ * compile time is trusted immediately, bypassing the recycle-count warmup
+ * and snapshot comparison governed by the trust threshold. Code that is
+ * made writable and patched afterwards will not be picked up, just like
+ * code mutated after reaching the trust threshold, so this is only meant
+ * for processes that do not rewrite their own text.
+ */
+void
+gum_stalker_set_trusts_immutable_code (GumStalker * self,
+                                       gboolean trusts_immutable_code)
+{
+  self->trusts_immutable_code = trusts_immutable_code;
+}
+
+void
+gum_stalker_set_coverage_bitmap (GumStalker * self,
+                                 guint8 * bitmap,
+                                 gsize size)
+{
+  g_assert (bitmap == NULL || (size != 0 && (size & (size - 1)) == 0));
+
+  self->coverage_bitmap = bitmap;
+  self->coverage_mask = size - 1;
+}
+
+gsize
+gum_stalker_get_code_memory_limit (GumStalker * self)
+{
+  return self->code_memory_limit;
+}
+
+void
+gum_stalker_set_code_memory_limit (GumStalker * self,
+                                   gsize limit)
+{
+  self->code_memory_limit = limit;
+}
+
+void
+gum_stalker_set_background_compilation (GumStalker * self,
+                                        gboolean enabled)
+{
+  self->background_compilation = enabled;
+}
+
+gboolean
+gum_stalker_query_stats (GumStalker * self,
+                         GumThreadId thread_id,
+                         GumStalkerStats * stats)
+{
+  gboolean found = FALSE;
+  GSList * cur;
+
+  GUM_STALKER_LOCK (self);
+
+  for (cur = self->contexts; cur != NULL; cur = cur->next)
+  {
+    GumExecCtx * ctx = cur->data;
+
+    if (ctx->thread_id == thread_id &&
+        g_atomic_int_get (&ctx->state) == GUM_EXEC_CTX_ACTIVE)
+    {
+      *stats = ctx->stats;
+      found = TRUE;
+      break;
+    }
+  }
+
+  GUM_STALKER_UNLOCK (self);
+
+  return found;
+}
+
+void
+gum_stalker_prefetch (GumStalker * self,
+                      gconstpointer address,
+                      gint recycle_count)
+{
+  GumExecCtx * ctx;
+  GumExecBlock * block;
+  gpointer code_address;
+
+  ctx = gum_stalker_get_exec_ctx (self);
+  g_assert (ctx != NULL);
+
+  block = gum_exec_ctx_obtain_block_for (ctx, (gpointer) address,
+      &code_address);
+  block->recycle_count = recycle_count;
+}
+
 void
 gum_stalker_flush (GumStalker * self)
 {
@@ -677,6 +1023,8 @@ gum_stalker_flush (GumStalker * self)
   {
     GumExecCtx * ctx = cur->data;
 
+    gum_exec_ctx_flush_event_batch (ctx);
+
     sinks = g_slist_prepend (sinks, g_object_ref (ctx->sink));
   }
 
@@ -700,6 +1048,7 @@ gum_stalker_stop (GumStalker * self)
   gum_spinlock_acquire (&self->probe_lock);
   g_hash_table_remove_all (self->probe_target_by_id);
   g_hash_table_remove_all (self->probe_array_by_address);
+  gum_stalker_probe_filter_rebuild (self);
   self->any_probes_attached = FALSE;
   gum_spinlock_release (&self->probe_lock);
 
@@ -1162,6 +1511,8 @@ gum_stalker_add_call_probe (GumStalker * self,
 
   g_array_append_val (probes, probe);
 
+  gum_stalker_probe_filter_add (self, target_address);
+
   self->any_probes_attached = TRUE;
 
   gum_spinlock_release (&self->probe_lock);
@@ -1212,6 +1563,8 @@ gum_stalker_remove_call_probe (GumStalker * self,
     if (probes->len == 0)
       g_hash_table_remove (self->probe_array_by_address, target_address);
 
+    gum_stalker_probe_filter_rebuild (self);
+
     self->any_probes_attached =
         g_hash_table_size (self->probe_array_by_address) != 0;
   }
@@ -1237,33 +1590,114 @@ gum_stalker_free_probe_array (gpointer data)
   g_array_free (probes, TRUE);
 }
 
+static void
+gum_stalker_probe_filter_compute (gpointer target_address,
+                                  guint * first_bit,
+                                  guint * second_bit)
+{
+  guint h = (guint) ((GPOINTER_TO_SIZE (target_address) >> 2) * 2654435761U);
+
+  *first_bit = h & (GUM_PROBE_FILTER_BITS - 1);
+  *second_bit = (h >> 16) & (GUM_PROBE_FILTER_BITS - 1);
+}
+
+static void
+gum_stalker_probe_filter_add (GumStalker * self,
+                              gpointer target_address)
+{
+  guint first_bit, second_bit;
+
+  gum_stalker_probe_filter_compute (target_address, &first_bit, &second_bit);
+
+  self->probe_filter[first_bit / GUM_PROBE_FILTER_WORD_BITS] |=
+      (gsize) 1 << (first_bit % GUM_PROBE_FILTER_WORD_BITS);
+  self->probe_filter[second_bit / GUM_PROBE_FILTER_WORD_BITS] |=
+      (gsize) 1 << (second_bit % GUM_PROBE_FILTER_WORD_BITS);
+}
+
+static gboolean
+gum_stalker_probe_filter_may_contain (GumStalker * self,
+                                      gpointer target_address)
+{
+  guint first_bit, second_bit;
+
+  gum_stalker_probe_filter_compute (target_address, &first_bit, &second_bit);
+
+  if ((self->probe_filter[first_bit / GUM_PROBE_FILTER_WORD_BITS] &
+      ((gsize) 1 << (first_bit % GUM_PROBE_FILTER_WORD_BITS))) == 0)
+    return FALSE;
+
+  return (self->probe_filter[second_bit / GUM_PROBE_FILTER_WORD_BITS] &
+      ((gsize) 1 << (second_bit % GUM_PROBE_FILTER_WORD_BITS))) != 0;
+}
+
+static void
+gum_stalker_probe_filter_rebuild (GumStalker * self)
+{
+  GHashTableIter iter;
+  gpointer target_address;
+  guint i;
+
+  for (i = 0; i != GUM_PROBE_FILTER_NUM_WORDS; i++)
+    self->probe_filter[i] = 0;
+
+  g_hash_table_iter_init (&iter, self->probe_array_by_address);
+  while (g_hash_table_iter_next (&iter, &target_address, NULL))
+    gum_stalker_probe_filter_add (self, target_address);
+}
+
+
 static GumExecCtx *
 gum_stalker_create_exec_ctx (GumStalker * self,
                              GumThreadId thread_id,
                              GumStalkerTransformer * transformer,
                              GumEventSink * sink)
 {
-  guint base_size;
-  const guint thunk_size = 1;
   GumExecCtx * ctx;
 
-  base_size = sizeof (GumExecCtx) / self->page_size;
-  if (sizeof (GumExecCtx) % self->page_size != 0)
-    base_size++;
-  base_size += thunk_size;
-
-  ctx = (GumExecCtx *)
-      gum_alloc_n_pages (base_size + GUM_CODE_SLAB_SIZE_IN_PAGES + 1,
-          GUM_PAGE_RWX);
+  ctx = gum_stalker_obtain_recycled_exec_ctx (self);
+  if (ctx == NULL)
+  {
+    guint base_size;
+    const guint thunk_size = 1;
+
+    base_size = sizeof (GumExecCtx) / self->page_size;
+    if (sizeof (GumExecCtx) % self->page_size != 0)
+      base_size++;
+    base_size += thunk_size;
+
+    ctx = (GumExecCtx *)
+        gum_alloc_n_pages (base_size + GUM_CODE_SLAB_SIZE_IN_PAGES + 1,
+            GUM_PAGE_RWX);
+    gum_slab_bind_to_local_node (ctx,
+        (base_size + GUM_CODE_SLAB_SIZE_IN_PAGES + 1) * self->page_size);
+    ctx->first_code_slab.hugepage = gum_slab_advise_huge_pages (ctx,
+        (base_size + GUM_CODE_SLAB_SIZE_IN_PAGES + 1) * self->page_size);
+
+    gum_x86_writer_init (&ctx->code_writer, NULL);
+    gum_x86_relocator_init (&ctx->relocator, NULL, &ctx->code_writer);
+    ctx->cold_stubs = g_array_new (FALSE, FALSE, sizeof (GumColdStub));
+
+    ctx->infect_thunk = (guint8 *) ctx +
+        (base_size - thunk_size) * self->page_size;
+
+    ctx->code_slab = &ctx->first_code_slab;
+    ctx->first_code_slab.data = (guint8 *) ctx + (base_size * self->page_size);
+    ctx->first_code_slab.size = GUM_CODE_SLAB_SIZE_IN_PAGES * self->page_size;
+
+    ctx->frames =
+        (GumExecFrame *) (ctx->code_slab->data + ctx->code_slab->size);
+    ctx->first_frame = (GumExecFrame *) (ctx->code_slab->data +
+        ctx->code_slab->size + self->page_size - sizeof (GumExecFrame));
+
+    ctx->mappings = gum_metal_hash_table_new (NULL, NULL);
+  }
 
   ctx->state = GUM_EXEC_CTX_ACTIVE;
 
   ctx->stalker = g_object_ref (self);
   ctx->thread_id = thread_id;
 
-  gum_x86_writer_init (&ctx->code_writer, NULL);
-  gum_x86_relocator_init (&ctx->relocator, NULL, &ctx->code_writer);
-
   if (transformer != NULL)
     ctx->transformer = g_object_ref (transformer);
   else
@@ -1279,28 +1713,34 @@ gum_stalker_create_exec_ctx (GumStalker * self,
     ctx->sink = gum_event_sink_make_default ();
 
   ctx->sink_mask = gum_event_sink_query_mask (ctx->sink);
+  ctx->active_mask = ctx->sink_mask;
   ctx->sink_process_impl = GUM_EVENT_SINK_GET_IFACE (ctx->sink)->process;
+  ctx->sink_process_batch_impl =
+      GUM_EVENT_SINK_GET_IFACE (ctx->sink)->process_batch;
+  ctx->event_batch_len = 0;
+  ctx->coverage_prev = 0;
 
-  ctx->infect_thunk = (guint8 *) ctx +
-      (base_size - thunk_size) * self->page_size;
-
-  ctx->code_slab = &ctx->first_code_slab;
-  ctx->first_code_slab.data = (guint8 *) ctx + (base_size * self->page_size);
-  ctx->first_code_slab.size = GUM_CODE_SLAB_SIZE_IN_PAGES * self->page_size;
+  ctx->stats.slab_bytes = ctx->first_code_slab.size;
+  ctx->stats.slab_count = 1;
+  ctx->stats.slab_huge_bytes =
+      ctx->first_code_slab.hugepage ? ctx->first_code_slab.size : 0;
 
-  ctx->frames = (GumExecFrame *) (ctx->code_slab->data + ctx->code_slab->size);
-  ctx->first_frame = (GumExecFrame *) (ctx->code_slab->data +
-      ctx->code_slab->size + self->page_size - sizeof (GumExecFrame));
   ctx->current_frame = ctx->first_frame;
 
-  ctx->mappings = gum_metal_hash_table_new (NULL, NULL);
-
   GUM_STALKER_LOCK (self);
   self->contexts = g_slist_prepend (self->contexts, ctx);
   GUM_STALKER_UNLOCK (self);
 
   gum_exec_ctx_ensure_inline_helpers_reachable (ctx);
 
+  if (self->background_compilation && self->trust_threshold >= 0)
+  {
+    g_mutex_init (&ctx->compile_mutex);
+    ctx->compile_requests = g_async_queue_new ();
+    ctx->compile_worker = g_thread_new ("gum-stalker-compile",
+        gum_exec_ctx_compile_worker, ctx);
+  }
+
   return ctx;
 }
 
@@ -1320,16 +1760,79 @@ gum_stalker_destroy_exec_ctx (GumStalker * self,
   if (entry == NULL)
     return;
 
+  if (ctx->compile_worker != NULL)
+  {
+    g_async_queue_push (ctx->compile_requests, ctx);
+    g_thread_join (ctx->compile_worker);
+    ctx->compile_worker = NULL;
+
+    g_async_queue_unref (ctx->compile_requests);
+    ctx->compile_requests = NULL;
+    g_mutex_clear (&ctx->compile_mutex);
+  }
+
   gum_exec_ctx_dispose_callouts (ctx);
 
   if (ctx->sink_started)
   {
+    gum_exec_ctx_flush_event_batch (ctx);
+
     gum_event_sink_stop (ctx->sink);
 
     ctx->sink_started = FALSE;
   }
 
-  gum_exec_ctx_free (ctx);
+  gum_stalker_recycle_exec_ctx (self, ctx);
+}
+
+static GumExecCtx *
+gum_stalker_obtain_recycled_exec_ctx (GumStalker * self)
+{
+  GumExecCtx * ctx = NULL;
+
+  GUM_STALKER_LOCK (self);
+
+  if (self->exec_ctx_pool != NULL)
+  {
+    ctx = self->exec_ctx_pool->data;
+    self->exec_ctx_pool = g_slist_delete_link (self->exec_ctx_pool,
+        self->exec_ctx_pool);
+    self->exec_ctx_pool_size--;
+  }
+
+  GUM_STALKER_UNLOCK (self);
+
+  return ctx;
+}
+
+/*
+ * Thread-churn-heavy targets follow and unfollow short-lived threads at a
+ * high rate, so instead of returning each context's pages to the system we
+ * keep a few stripped-down contexts around for the next follow. The pooled
+ * context retains its page allocation, writer/relocator state and mappings
+ * table; everything tied to the particular follow is released up front.
+ */
+static void
+gum_stalker_recycle_exec_ctx (GumStalker * self,
+                              GumExecCtx * ctx)
+{
+  gboolean pooled = FALSE;
+
+  gum_exec_ctx_reset (ctx);
+
+  GUM_STALKER_LOCK (self);
+
+  if (self->exec_ctx_pool_size != GUM_EXEC_CTX_POOL_CAPACITY)
+  {
+    self->exec_ctx_pool = g_slist_prepend (self->exec_ctx_pool, ctx);
+    self->exec_ctx_pool_size++;
+    pooled = TRUE;
+  }
+
+  GUM_STALKER_UNLOCK (self);
+
+  if (!pooled)
+    gum_exec_ctx_free (ctx);
 }
 
 static GumExecCtx *
@@ -1393,11 +1896,11 @@ gum_exec_ctx_finalize_callouts (GumExecCtx * ctx)
 }
 
 static void
-gum_exec_ctx_free (GumExecCtx * ctx)
+gum_exec_ctx_reset (GumExecCtx * ctx)
 {
   GumSlab * slab;
 
-  gum_metal_hash_table_unref (ctx->mappings);
+  gum_metal_hash_table_remove_all (ctx->mappings);
 
   slab = ctx->code_slab;
   while (slab != &ctx->first_code_slab)
@@ -1406,15 +1909,77 @@ gum_exec_ctx_free (GumExecCtx * ctx)
     gum_free_pages (slab);
     slab = next;
   }
+  ctx->code_slab = &ctx->first_code_slab;
+  ctx->first_code_slab.offset = 0;
+  ctx->first_code_slab.last_used = 0;
+  ctx->first_code_slab.has_backpatch_targets = FALSE;
+  ctx->usage_counter = 0;
+
+  ctx->last_prolog_minimal = NULL;
+  ctx->last_epilog_minimal = NULL;
+  ctx->last_prolog_full = NULL;
+  ctx->last_epilog_full = NULL;
+  ctx->last_stack_push = NULL;
+  ctx->last_stack_pop_and_go = NULL;
 
   g_object_unref (ctx->sink);
+  ctx->sink = NULL;
   gum_exec_ctx_finalize_callouts (ctx);
   g_object_unref (ctx->transformer);
+  ctx->transformer = NULL;
+
+  g_object_unref (ctx->stalker);
+  ctx->stalker = NULL;
+
+  ctx->invalidate_pending = FALSE;
+  ctx->destroy_pending_since = 0;
+  ctx->unfollow_called_while_still_following = FALSE;
+  ctx->current_block = NULL;
+  ctx->pending_return_location = NULL;
+  ctx->pending_calls = 0;
+  ctx->current_frame = ctx->first_frame;
+  ctx->resume_at = NULL;
+  ctx->return_at = NULL;
+  ctx->app_stack = NULL;
+  ctx->activation_target = NULL;
+  ctx->infect_body = NULL;
+
+#ifdef HAVE_WINDOWS
+  ctx->previous_pc = 0;
+  ctx->previous_dr0 = 0;
+  ctx->previous_dr7 = 0;
+#endif
+
+  memset (&ctx->stats, 0, sizeof (ctx->stats));
+}
+
+static void
+gum_exec_ctx_free (GumExecCtx * ctx)
+{
+  GumSlab * slab;
+
+  gum_metal_hash_table_unref (ctx->mappings);
+
+  slab = ctx->code_slab;
+  while (slab != &ctx->first_code_slab)
+  {
+    GumSlab * next = slab->next;
+    gum_free_pages (slab);
+    slab = next;
+  }
+
+  if (ctx->sink != NULL)
+    g_object_unref (ctx->sink);
+  gum_exec_ctx_finalize_callouts (ctx);
+  if (ctx->transformer != NULL)
+    g_object_unref (ctx->transformer);
 
   gum_x86_relocator_clear (&ctx->relocator);
   gum_x86_writer_clear (&ctx->code_writer);
+  g_array_free (ctx->cold_stubs, TRUE);
 
-  g_object_unref (ctx->stalker);
+  if (ctx->stalker != NULL)
+    g_object_unref (ctx->stalker);
 
   gum_free_pages (ctx);
 }
@@ -1483,7 +2048,8 @@ gum_exec_ctx_may_now_backpatch (GumExecCtx * ctx,
   if ((target_block->flags & GUM_EXEC_ACTIVATION_TARGET) != 0)
     return FALSE;
 
-  if (target_block->recycle_count < ctx->stalker->trust_threshold)
+  if (target_block->recycle_count < ctx->stalker->trust_threshold &&
+      (target_block->flags & GUM_EXEC_IMMUTABLE_SOURCE) == 0)
     return FALSE;
 
   return TRUE;
@@ -1507,6 +2073,21 @@ static guint total_transitions = 0;
       \
       return gum_exec_ctx_replace_current_block_with (ctx, start_address); \
     }
+#define GUM_DEFINE_INDIRECT_ENTRYGATE(name) \
+    static guint total_##name##s = 0; \
+    \
+    static gpointer GUM_THUNK \
+    GUM_ENTRYGATE (name) ( \
+        GumExecCtx * ctx, \
+        gpointer start_address) \
+    { \
+      if (counters_enabled) \
+        total_##name##s++; \
+      \
+      ctx->stats.indirect_lookups++; \
+      \
+      return gum_exec_ctx_replace_current_block_with (ctx, start_address); \
+    }
 #define GUM_PRINT_ENTRYGATE_COUNTER(name) \
     g_printerr ("\t" G_STRINGIFY (name) "s: %u\n", total_##name##s)
 
@@ -1515,19 +2096,33 @@ GUM_DEFINE_ENTRYGATE (sysenter_slow_path)
 #endif
 
 GUM_DEFINE_ENTRYGATE (call_imm)
-GUM_DEFINE_ENTRYGATE (call_reg)
-GUM_DEFINE_ENTRYGATE (call_mem)
+GUM_DEFINE_INDIRECT_ENTRYGATE (call_reg)
+GUM_DEFINE_INDIRECT_ENTRYGATE (call_mem)
 GUM_DEFINE_ENTRYGATE (post_call_invoke)
 GUM_DEFINE_ENTRYGATE (excluded_call_imm)
-GUM_DEFINE_ENTRYGATE (ret_slow_path)
+static guint total_ret_slow_paths = 0;
+
+static gpointer GUM_THUNK
+GUM_ENTRYGATE (ret_slow_path) (
+    GumExecCtx * ctx,
+    gpointer start_address)
+{
+  if (counters_enabled)
+    total_ret_slow_paths++;
+
+  ctx->stats.indirect_lookups++;
+  ctx->stats.ret_mispredicts++;
+
+  return gum_exec_ctx_replace_current_block_with (ctx, start_address);
+}
 
 GUM_DEFINE_ENTRYGATE (jmp_imm)
-GUM_DEFINE_ENTRYGATE (jmp_mem)
-GUM_DEFINE_ENTRYGATE (jmp_reg)
+GUM_DEFINE_INDIRECT_ENTRYGATE (jmp_mem)
+GUM_DEFINE_INDIRECT_ENTRYGATE (jmp_reg)
 
 GUM_DEFINE_ENTRYGATE (jmp_cond_imm)
-GUM_DEFINE_ENTRYGATE (jmp_cond_mem)
-GUM_DEFINE_ENTRYGATE (jmp_cond_reg)
+GUM_DEFINE_INDIRECT_ENTRYGATE (jmp_cond_mem)
+GUM_DEFINE_INDIRECT_ENTRYGATE (jmp_cond_reg)
 GUM_DEFINE_ENTRYGATE (jmp_cond_jcxz)
 
 GUM_DEFINE_ENTRYGATE (jmp_continuation)
@@ -1587,6 +2182,25 @@ gum_exec_ctx_obtain_block_for (GumExecCtx * ctx,
                                gpointer * code_address)
 {
   GumExecBlock * block;
+
+  if (ctx->compile_requests == NULL)
+    return gum_exec_ctx_obtain_block_unlocked (ctx, real_address,
+        code_address);
+
+  g_mutex_lock (&ctx->compile_mutex);
+  block = gum_exec_ctx_obtain_block_unlocked (ctx, real_address, code_address);
+  g_mutex_unlock (&ctx->compile_mutex);
+
+  return block;
+}
+
+static GumExecBlock *
+gum_exec_ctx_obtain_block_unlocked (GumExecCtx * ctx,
+                                    gpointer real_address,
+                                    gpointer * code_address)
+{
+  GumExecBlock * block;
+  gint64 translation_started_at;
   GumX86Writer * cw;
   GumX86Relocator * rl;
   GumGeneratorContext gc;
@@ -1599,11 +2213,14 @@ gum_exec_ctx_obtain_block_for (GumExecCtx * ctx,
     block = gum_exec_block_obtain (ctx, real_address, code_address);
     if (block != NULL)
     {
-      if (block->recycle_count >= ctx->stalker->trust_threshold ||
+      if ((block->flags & GUM_EXEC_IMMUTABLE_SOURCE) != 0 ||
+          block->recycle_count >= ctx->stalker->trust_threshold ||
           memcmp (real_address, block->real_snapshot,
             block->real_end - block->real_begin) == 0)
       {
         block->recycle_count++;
+        block->slab->last_used = ++ctx->usage_counter;
+        ctx->stats.blocks_recycled++;
         return block;
       }
       else
@@ -1613,6 +2230,11 @@ gum_exec_ctx_obtain_block_for (GumExecCtx * ctx,
     }
   }
 
+  translation_started_at = g_get_monotonic_time ();
+
+  ctx->active_mask = gum_stalker_query_sink_mask_for (ctx->stalker,
+      ctx->sink_mask, real_address);
+
   block = gum_exec_block_new (ctx);
   block->real_begin = real_address;
   *code_address = block->code_begin;
@@ -1625,9 +2247,13 @@ gum_exec_ctx_obtain_block_for (GumExecCtx * ctx,
 
   gum_x86_writer_reset (cw, block->code_begin);
   gum_x86_relocator_reset (rl, real_address, cw);
+  g_array_set_size (ctx->cold_stubs, 0);
 
   gum_ensure_code_readable (real_address, ctx->stalker->page_size);
 
+  if (ctx->stalker->coverage_bitmap != NULL)
+    gum_exec_ctx_write_coverage_code (ctx, real_address, cw);
+
   gc.instruction = NULL;
   gc.relocator = rl;
   gc.code_writer = cw;
@@ -1666,6 +2292,8 @@ gum_exec_ctx_obtain_block_for (GumExecCtx * ctx,
 
   gum_x86_writer_put_breakpoint (cw); /* Should never get here */
 
+  gum_exec_block_write_cold_stubs (block, &gc);
+
   all_labels_resolved = gum_x86_writer_flush (cw);
   if (!all_labels_resolved)
     g_error ("Failed to resolve labels");
@@ -1675,6 +2303,10 @@ gum_exec_ctx_obtain_block_for (GumExecCtx * ctx,
 
   gum_exec_block_commit (block);
 
+  ctx->stats.blocks_compiled++;
+  ctx->stats.translation_time_us +=
+      g_get_monotonic_time () - translation_started_at;
+
   if ((ctx->sink_mask & GUM_COMPILE) != 0)
   {
     GumEvent ev;
@@ -1683,12 +2315,55 @@ gum_exec_ctx_obtain_block_for (GumExecCtx * ctx,
     ev.compile.begin = block->real_begin;
     ev.compile.end = block->real_end;
 
-    ctx->sink_process_impl (ctx->sink, &ev, NULL);
+    gum_exec_ctx_emit_event (ctx, &ev, NULL);
   }
 
   return block;
 }
 
+static gpointer
+gum_exec_ctx_compile_worker (gpointer data)
+{
+  GumExecCtx * ctx = data;
+
+  while (TRUE)
+  {
+    gpointer address, code_address;
+
+    address = g_async_queue_pop (ctx->compile_requests);
+    if (address == (gpointer) ctx)
+      break;
+
+    if (g_atomic_int_get (&ctx->state) != GUM_EXEC_CTX_ACTIVE)
+      continue;
+
+    g_mutex_lock (&ctx->compile_mutex);
+
+    if (gum_metal_hash_table_lookup (ctx->mappings, address) == NULL)
+      gum_exec_ctx_obtain_block_unlocked (ctx, address, &code_address);
+
+    g_mutex_unlock (&ctx->compile_mutex);
+  }
+
+  return NULL;
+}
+
+static void
+gum_exec_ctx_maybe_queue_for_compilation (GumExecCtx * ctx,
+                                          const GumBranchTarget * target)
+{
+  if (ctx->compile_requests == NULL)
+    return;
+
+  if (target->is_indirect || target->base != X86_REG_INVALID)
+    return;
+
+  if (target->absolute_address == NULL)
+    return;
+
+  g_async_queue_push (ctx->compile_requests, target->absolute_address);
+}
+
 gboolean
 gum_stalker_iterator_next (GumStalkerIterator * self,
                            const cs_insn ** insn)
@@ -1750,10 +2425,10 @@ gum_stalker_iterator_keep (GumStalkerIterator * self)
   const cs_insn * insn = gc->instruction->ci;
   GumVirtualizationRequirements requirements;
 
-  if ((ec->sink_mask & GUM_EXEC) != 0)
+  if ((ec->active_mask & GUM_EXEC) != 0)
     gum_exec_block_write_exec_event_code (block, gc, GUM_CODE_INTERRUPTIBLE);
 
-  if ((ec->sink_mask & GUM_BLOCK) != 0 &&
+  if ((ec->active_mask & GUM_BLOCK) != 0 &&
       gum_x86_relocator_eob (rl) &&
       insn->id != X86_INS_CALL)
   {
@@ -1796,7 +2471,78 @@ gum_stalker_iterator_keep (GumStalkerIterator * self)
     gum_exec_block_write_single_step_transfer_code (block, gc);
   }
 
-  self->requirements = requirements;
+  self->requirements = requirements;
+}
+
+static void
+gum_exec_ctx_write_coverage_code (GumExecCtx * ctx,
+                                  gpointer real_address,
+                                  GumX86Writer * cw)
+{
+  GumStalker * stalker = ctx->stalker;
+  gsize cur_id, next_prev;
+
+  cur_id = ((GPOINTER_TO_SIZE (real_address) >> 1) * 2654435761U) &
+      stalker->coverage_mask;
+  next_prev = cur_id >> 1;
+
+  gum_x86_writer_put_lea_reg_reg_offset (cw, GUM_REG_XSP, GUM_REG_XSP,
+      -GUM_RED_ZONE_SIZE);
+  gum_x86_writer_put_pushfx (cw);
+  gum_x86_writer_put_push_reg (cw, GUM_REG_XAX);
+  gum_x86_writer_put_push_reg (cw, GUM_REG_XBX);
+
+  gum_x86_writer_put_mov_reg_address (cw, GUM_REG_XAX,
+      GUM_ADDRESS (&ctx->coverage_prev));
+  gum_x86_writer_put_mov_reg_reg_ptr (cw, GUM_REG_XBX, GUM_REG_XAX);
+  gum_x86_writer_put_mov_reg_ptr_u32 (cw, GUM_REG_XAX, (guint32) next_prev);
+  gum_x86_writer_put_mov_reg_u32 (cw, GUM_REG_EAX, (guint32) cur_id);
+  gum_x86_writer_put_xor_reg_reg (cw, GUM_REG_XBX, GUM_REG_XAX);
+  gum_x86_writer_put_mov_reg_address (cw, GUM_REG_XAX,
+      GUM_ADDRESS (stalker->coverage_bitmap));
+  gum_x86_writer_put_add_reg_reg (cw, GUM_REG_XAX, GUM_REG_XBX);
+  gum_x86_writer_put_inc_reg_ptr (cw, GUM_PTR_BYTE, GUM_REG_XAX);
+
+  gum_x86_writer_put_pop_reg (cw, GUM_REG_XBX);
+  gum_x86_writer_put_pop_reg (cw, GUM_REG_XAX);
+  gum_x86_writer_put_popfx (cw);
+  gum_x86_writer_put_lea_reg_reg_offset (cw, GUM_REG_XSP, GUM_REG_XSP,
+      GUM_RED_ZONE_SIZE);
+}
+
+static void
+gum_exec_ctx_emit_event (GumExecCtx * ctx,
+                         const GumEvent * ev,
+                         GumCpuContext * cpu_context)
+{
+  if (ctx->compile_worker != NULL && g_thread_self () == ctx->compile_worker)
+  {
+    ctx->sink_process_impl (ctx->sink, ev, cpu_context);
+    return;
+  }
+
+  if (ctx->sink_process_batch_impl != NULL)
+  {
+    ctx->event_batch[ctx->event_batch_len++] = *ev;
+
+    if (ctx->event_batch_len == GUM_EVENT_BATCH_CAPACITY)
+      gum_exec_ctx_flush_event_batch (ctx);
+  }
+  else
+  {
+    ctx->sink_process_impl (ctx->sink, ev, cpu_context);
+  }
+}
+
+static void
+gum_exec_ctx_flush_event_batch (GumExecCtx * ctx)
+{
+  if (ctx->event_batch_len == 0)
+    return;
+
+  ctx->sink_process_batch_impl (ctx->sink, ctx->event_batch,
+      ctx->event_batch_len);
+  ctx->event_batch_len = 0;
 }
 
 static void
@@ -1816,7 +2562,7 @@ gum_exec_ctx_emit_call_event (GumExecCtx * ctx,
 
   GUM_CPU_CONTEXT_XIP (cpu_context) = GPOINTER_TO_SIZE (location);
 
-  ctx->sink_process_impl (ctx->sink, &ev, cpu_context);
+  gum_exec_ctx_emit_event (ctx, &ev, cpu_context);
 }
 
 static void
@@ -1835,7 +2581,7 @@ gum_exec_ctx_emit_ret_event (GumExecCtx * ctx,
 
   GUM_CPU_CONTEXT_XIP (cpu_context) = GPOINTER_TO_SIZE (location);
 
-  ctx->sink_process_impl (ctx->sink, &ev, cpu_context);
+  gum_exec_ctx_emit_event (ctx, &ev, cpu_context);
 }
 
 static void
@@ -1852,7 +2598,7 @@ gum_exec_ctx_emit_exec_event (GumExecCtx * ctx,
 
   GUM_CPU_CONTEXT_XIP (cpu_context) = GPOINTER_TO_SIZE (location);
 
-  ctx->sink_process_impl (ctx->sink, &ev, cpu_context);
+  gum_exec_ctx_emit_event (ctx, &ev, cpu_context);
 }
 
 static void
@@ -1872,7 +2618,7 @@ gum_exec_ctx_emit_block_event (GumExecCtx * ctx,
 
   GUM_CPU_CONTEXT_XIP (cpu_context) = GPOINTER_TO_SIZE (location);
 
-  ctx->sink_process_impl (ctx->sink, &ev, cpu_context);
+  gum_exec_ctx_emit_event (ctx, &ev, cpu_context);
 }
 
 void
@@ -1880,6 +2626,17 @@ gum_stalker_iterator_put_callout (GumStalkerIterator * self,
                                   GumStalkerCallout callout,
                                   gpointer data,
                                   GDestroyNotify data_destroy)
+{
+  gum_stalker_iterator_put_callout_with_flags (self, callout, data,
+      data_destroy, GUM_STALKER_CALLOUT_DEFAULT);
+}
+
+void
+gum_stalker_iterator_put_callout_with_flags (GumStalkerIterator * self,
+                                             GumStalkerCallout callout,
+                                             gpointer data,
+                                             GDestroyNotify data_destroy,
+                                             GumStalkerCalloutFlags flags)
 {
   GumCalloutEntry * entry;
   GumExecCtx * ec = self->exec_context;
@@ -1894,12 +2651,23 @@ gum_stalker_iterator_put_callout (GumStalkerIterator * self,
   entry->pc = gc->instruction->begin;
   entry->exec_context = ec;
 
-  gum_exec_block_open_prolog (block, GUM_PROLOG_FULL, gc);
+  if ((flags & GUM_STALKER_CALLOUT_NO_CONTEXT) != 0)
+  {
+    gum_exec_block_open_prolog (block, GUM_PROLOG_MINIMAL, gc);
 
-  gum_x86_writer_put_call_address_with_aligned_arguments (cw,
-      GUM_CALL_CAPI, GUM_ADDRESS (gum_stalker_invoke_callout), 2,
-      GUM_ARG_REGISTER, GUM_REG_XBX,
-      GUM_ARG_ADDRESS, GUM_ADDRESS (entry));
+    gum_x86_writer_put_call_address_with_aligned_arguments (cw,
+        GUM_CALL_CAPI, GUM_ADDRESS (gum_stalker_invoke_minimal_callout), 1,
+        GUM_ARG_ADDRESS, GUM_ADDRESS (entry));
+  }
+  else
+  {
+    gum_exec_block_open_prolog (block, GUM_PROLOG_FULL, gc);
+
+    gum_x86_writer_put_call_address_with_aligned_arguments (cw,
+        GUM_CALL_CAPI, GUM_ADDRESS (gum_stalker_invoke_callout), 2,
+        GUM_ARG_REGISTER, GUM_REG_XBX,
+        GUM_ARG_ADDRESS, GUM_ADDRESS (entry));
+  }
 
   gum_exec_block_close_prolog (block, gc);
 
@@ -1926,6 +2694,21 @@ gum_stalker_invoke_callout (GumCpuContext * cpu_context,
   gum_spinlock_release (&ec->callout_lock);
 }
 
+static void
+gum_stalker_invoke_minimal_callout (GumCalloutEntry * entry)
+{
+  GumExecCtx * ec = entry->exec_context;
+
+  gum_spinlock_acquire (&ec->callout_lock);
+
+  if (entry->callout != NULL)
+  {
+    entry->callout (NULL, entry->data);
+  }
+
+  gum_spinlock_release (&ec->callout_lock);
+}
+
 static void
 gum_exec_ctx_write_prolog (GumExecCtx * ctx,
                            GumPrologType type,
@@ -2310,6 +3093,12 @@ gum_exec_ctx_write_stack_pop_and_go_helper (GumExecCtx * ctx,
   gum_x86_writer_put_jcc_short_label (cw, X86_INS_JNE,
       resolve_dynamically, GUM_UNLIKELY);
 
+  if (counters_enabled)
+  {
+    gum_x86_writer_put_lock_inc_imm32_ptr (cw,
+        &ctx->stats.ret_predictions);
+  }
+
   /* Replace return address */
   gum_x86_writer_put_mov_reg_reg_offset_ptr (cw, GUM_REG_XCX,
       GUM_REG_XAX, G_STRUCT_OFFSET (GumExecFrame, code_address));
@@ -2688,6 +3477,10 @@ gum_exec_block_new (GumExecCtx * ctx)
 
     slab->offset += block->code_begin - (slab->data + slab->offset);
 
+    slab->last_used = ++ctx->usage_counter;
+
+    gum_stats_add (GUM_STAT_STALKER_BLOCKS_COMPILED, 1);
+
     return block;
   }
 
@@ -2698,7 +3491,13 @@ gum_exec_block_new (GumExecCtx * ctx)
     return gum_exec_block_new (ctx);
   }
 
+  gum_exec_ctx_maybe_evict_code_slab (ctx);
+
   slab = gum_alloc_n_pages (GUM_CODE_SLAB_SIZE_IN_PAGES, GUM_PAGE_RWX);
+  gum_slab_bind_to_local_node (slab,
+      GUM_CODE_SLAB_SIZE_IN_PAGES * ctx->stalker->page_size);
+  slab->hugepage = gum_slab_advise_huge_pages (slab,
+      GUM_CODE_SLAB_SIZE_IN_PAGES * ctx->stalker->page_size);
   slab->data = (guint8 *) (slab + 1);
   slab->offset = 0;
   slab->size = (GUM_CODE_SLAB_SIZE_IN_PAGES * ctx->stalker->page_size)
@@ -2706,6 +3505,11 @@ gum_exec_block_new (GumExecCtx * ctx)
   slab->next = ctx->code_slab;
   ctx->code_slab = slab;
 
+  ctx->stats.slab_bytes += slab->size;
+  ctx->stats.slab_count++;
+  if (slab->hugepage)
+    ctx->stats.slab_huge_bytes += slab->size;
+
   gum_exec_ctx_ensure_inline_helpers_reachable (ctx);
 
   return gum_exec_block_new (ctx);
@@ -2725,11 +3529,149 @@ gum_exec_block_obtain (GumExecCtx * ctx,
   return block;
 }
 
+/*
+ * Request that pages of a freshly allocated slab be homed on the NUMA node
+ * of the thread that faults them in, regardless of any interleaving policy
+ * inherited from the process. Slabs are populated by the thread that
+ * compiles into them, which outside of background compilation is the
+ * followed thread itself, so local homing keeps translated code on the
+ * node that executes it.
+ */
+static void
+gum_slab_bind_to_local_node (gpointer data,
+                             gsize size)
+{
+#if defined (HAVE_LINUX) && defined (__NR_mbind)
+  const gulong mpol_preferred = 1;
+
+  syscall (__NR_mbind, data, size, mpol_preferred, NULL, 0, 0);
+#endif
+}
+
+/*
+ * Ask the kernel to back a slab with transparent huge pages. A 2M mapping
+ * covers 512x the code of a 4K one per iTLB entry, which matters once the
+ * translated working set reaches hundreds of megabytes. The advice is
+ * best-effort: kernels without THP, or regions the kernel declines to
+ * collapse, simply stay on regular pages.
+ */
+static gboolean
+gum_slab_advise_huge_pages (gpointer data,
+                            gsize size)
+{
+#if defined (HAVE_LINUX) && defined (MADV_HUGEPAGE)
+  return madvise (data, size, MADV_HUGEPAGE) == 0;
+#else
+  return FALSE;
+#endif
+}
+
+static void
+gum_exec_ctx_maybe_evict_code_slab (GumExecCtx * ctx)
+{
+  gsize limit = ctx->stalker->code_memory_limit;
+  gsize total;
+  GumSlab * slab, * prev, * victim, * victim_prev;
+
+  if (limit == 0)
+    return;
+
+  total = 0;
+  for (slab = ctx->code_slab; slab != NULL; slab = slab->next)
+    total += slab->size;
+  if (total < limit)
+    return;
+
+  victim = NULL;
+  victim_prev = NULL;
+  for (prev = ctx->code_slab, slab = prev->next; slab != NULL;
+      prev = slab, slab = slab->next)
+  {
+    if (!gum_exec_ctx_slab_is_evictable (ctx, slab))
+      continue;
+
+    if (victim == NULL || slab->last_used < victim->last_used)
+    {
+      victim = slab;
+      victim_prev = prev;
+    }
+  }
+  if (victim == NULL)
+    return;
+
+  gum_metal_hash_table_foreach_remove (ctx->mappings,
+      gum_exec_block_is_in_slab, victim);
+
+  victim_prev->next = victim->next;
+  ctx->stats.slab_bytes -= victim->size;
+  ctx->stats.slab_count--;
+  if (victim->hugepage)
+    ctx->stats.slab_huge_bytes -= victim->size;
+  gum_free_pages (victim);
+}
+
+static gboolean
+gum_exec_ctx_slab_is_evictable (GumExecCtx * ctx,
+                                GumSlab * slab)
+{
+  gpointer * helpers[] = {
+    &ctx->last_prolog_minimal,
+    &ctx->last_epilog_minimal,
+    &ctx->last_prolog_full,
+    &ctx->last_epilog_full,
+    &ctx->last_stack_push,
+    &ctx->last_stack_pop_and_go
+  };
+  guint i;
+  GumExecFrame * frame;
+
+  if (slab == &ctx->first_code_slab)
+    return FALSE;
+
+  if (slab->has_backpatch_targets)
+    return FALSE;
+
+  if (ctx->current_block != NULL && ctx->current_block->slab == slab)
+    return FALSE;
+
+  for (i = 0; i != G_N_ELEMENTS (helpers); i++)
+  {
+    guint8 * helper = *helpers[i];
+
+    if (helper >= slab->data && helper < slab->data + slab->size)
+      return FALSE;
+  }
+
+  for (frame = ctx->current_frame; frame <= ctx->first_frame; frame++)
+  {
+    guint8 * code = frame->code_address;
+
+    if (code >= slab->data && code < slab->data + slab->size)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+static gboolean
+gum_exec_block_is_in_slab (gpointer key,
+                           gpointer value,
+                           gpointer user_data)
+{
+  GumExecBlock * block = value;
+  GumSlab * slab = user_data;
+
+  return block->slab == slab;
+}
+
 static gboolean
 gum_exec_block_is_full (GumExecBlock * block)
 {
   guint8 * slab_end = block->slab->data + block->slab->size;
-  return slab_end - block->code_end < GUM_EXEC_BLOCK_MIN_SIZE;
+  gsize cold_reservation =
+      block->ctx->cold_stubs->len * GUM_COLD_STUB_MAX_SIZE;
+  return (gsize) (slab_end - block->code_end) <
+      GUM_EXEC_BLOCK_MIN_SIZE + cold_reservation;
 }
 
 static void
@@ -2739,6 +3681,13 @@ gum_exec_block_commit (GumExecBlock * block)
   guint8 * aligned_end;
 
   real_size = block->real_end - block->real_begin;
+
+  if (block->ctx->stalker->trusts_immutable_code &&
+      !gum_memory_is_writable (block->real_begin, real_size))
+  {
+    block->flags |= GUM_EXEC_IMMUTABLE_SOURCE;
+  }
+
   block->real_snapshot = block->code_end;
   memcpy (block->real_snapshot, block->real_begin, real_size);
   block->slab->offset += real_size;
@@ -2764,10 +3713,15 @@ gum_exec_block_backpatch_call (GumExecBlock * block,
 
   ctx = block->ctx;
 
+  if (ctx->compile_requests != NULL)
+    g_mutex_lock (&ctx->compile_mutex);
+
   if (gum_exec_ctx_may_now_backpatch (ctx, block))
   {
     GumX86Writer * cw = &ctx->code_writer;
 
+    block->slab->has_backpatch_targets = TRUE;
+
     gum_x86_writer_reset (cw, code_start);
 
     if (opened_prolog == GUM_PROLOG_NONE)
@@ -2806,6 +3760,9 @@ gum_exec_block_backpatch_call (GumExecBlock * block,
 
     gum_x86_writer_flush (cw);
   }
+
+  if (ctx->compile_requests != NULL)
+    g_mutex_unlock (&ctx->compile_mutex);
 }
 
 static void
@@ -2822,10 +3779,15 @@ gum_exec_block_backpatch_jmp (GumExecBlock * block,
 
   ctx = block->ctx;
 
+  if (ctx->compile_requests != NULL)
+    g_mutex_lock (&ctx->compile_mutex);
+
   if (gum_exec_ctx_may_now_backpatch (ctx, block))
   {
     GumX86Writer * cw = &ctx->code_writer;
 
+    block->slab->has_backpatch_targets = TRUE;
+
     gum_x86_writer_reset (cw, code_start);
 
     if (opened_prolog != GUM_PROLOG_NONE)
@@ -2836,6 +3798,9 @@ gum_exec_block_backpatch_jmp (GumExecBlock * block,
     gum_x86_writer_put_jmp_address (cw, GUM_ADDRESS (block->code_begin));
     gum_x86_writer_flush (cw);
   }
+
+  if (ctx->compile_requests != NULL)
+    g_mutex_unlock (&ctx->compile_mutex);
 }
 
 static void
@@ -2851,14 +3816,22 @@ gum_exec_block_backpatch_ret (GumExecBlock * block,
 
   ctx = block->ctx;
 
+  if (ctx->compile_requests != NULL)
+    g_mutex_lock (&ctx->compile_mutex);
+
   if (gum_exec_ctx_may_now_backpatch (ctx, block))
   {
     GumX86Writer * cw = &ctx->code_writer;
 
+    block->slab->has_backpatch_targets = TRUE;
+
     gum_x86_writer_reset (cw, code_start);
     gum_x86_writer_put_jmp_address (cw, GUM_ADDRESS (block->code_begin));
     gum_x86_writer_flush (cw);
   }
+
+  if (ctx->compile_requests != NULL)
+    g_mutex_unlock (&ctx->compile_mutex);
 }
 
 static void
@@ -2874,17 +3847,97 @@ gum_exec_block_backpatch_inline_cache (GumExecBlock * block,
 
   ctx = block->ctx;
 
+  if (ctx->compile_requests != NULL)
+    g_mutex_lock (&ctx->compile_mutex);
+
   if (gum_exec_ctx_may_now_backpatch (ctx, block))
   {
-    guint offset;
+    gsize * num_misses;
+    guint i;
+
+    block->slab->has_backpatch_targets = TRUE;
+
+    for (i = 0; i != GUM_IC_ENTRIES; i++)
+    {
+      if (ic_entries[(2 * i) + 0] == block->real_begin)
+        goto beach;
 
-    offset = (ic_entries[0] == NULL) ? 0 : 2;
+      if (ic_entries[(2 * i) + 0] == NULL)
+      {
+        ic_entries[(2 * i) + 1] = block->code_begin;
+        ic_entries[(2 * i) + 0] = block->real_begin;
+        goto beach;
+      }
+    }
 
-    if (ic_entries[offset + 0] == NULL)
+    /*
+     * The cache is full and we are still missing: tolerate a few misses, then
+     * evict the oldest entry so the working set can rotate in.
+     */
+    num_misses = (gsize *) &ic_entries[2 * GUM_IC_ENTRIES];
+    (*num_misses)++;
+    if (*num_misses < GUM_IC_MISS_THRESHOLD)
+      goto beach;
+    *num_misses = 0;
+
+    for (i = 0; i != GUM_IC_ENTRIES - 1; i++)
     {
-      ic_entries[offset + 0] = block->real_begin;
-      ic_entries[offset + 1] = block->code_begin;
+      ic_entries[(2 * i) + 0] = ic_entries[(2 * (i + 1)) + 0];
+      ic_entries[(2 * i) + 1] = ic_entries[(2 * (i + 1)) + 1];
     }
+
+    ic_entries[(2 * (GUM_IC_ENTRIES - 1)) + 0] = block->real_begin;
+    ic_entries[(2 * (GUM_IC_ENTRIES - 1)) + 1] = block->code_begin;
+  }
+
+beach:
+  if (ctx->compile_requests != NULL)
+    g_mutex_unlock (&ctx->compile_mutex);
+}
+
+static gpointer *
+gum_exec_block_write_inline_cache_table (GumExecBlock * block,
+                                         GumX86Writer * cw)
+{
+  gpointer null_ptr = NULL;
+  gpointer * ic_entries;
+  guint i;
+
+  ic_entries = gum_x86_writer_cur (cw);
+
+  for (i = 0; i != (2 * GUM_IC_ENTRIES) + 1; i++)
+    gum_x86_writer_put_bytes (cw, (guint8 *) &null_ptr, sizeof (null_ptr));
+
+  return ic_entries;
+}
+
+static void
+gum_exec_block_write_inline_cache_lookup (GumExecBlock * block,
+                                          gpointer * ic_entries,
+                                          GumX86Writer * cw,
+                                          gconstpointer resolve_dynamically)
+{
+  guint i;
+
+  for (i = 0; i != GUM_IC_ENTRIES; i++)
+  {
+    gconstpointer try_next = (i != GUM_IC_ENTRIES - 1)
+        ? (gconstpointer) (ic_entries + i + 1)
+        : resolve_dynamically;
+
+    if (i != 0)
+      gum_x86_writer_put_label (cw, ic_entries + i);
+
+    gum_x86_writer_put_mov_reg_near_ptr (cw, GUM_REG_XAX,
+        GUM_ADDRESS (&ic_entries[(2 * i) + 0]));
+    gum_x86_writer_put_cmp_reg_offset_ptr_reg (cw, GUM_REG_XSP, 0,
+        GUM_REG_XAX);
+    gum_x86_writer_put_jcc_short_label (cw, X86_INS_JNE, try_next,
+        GUM_NO_HINT);
+    gum_x86_writer_put_pop_reg (cw, GUM_REG_XAX);
+    gum_exec_ctx_write_epilog (block->ctx, GUM_PROLOG_IC, cw);
+    gum_x86_writer_put_jmp_near_ptr (cw,
+        GUM_ADDRESS (&ic_entries[(2 * i) + 1]));
   }
 }
 
@@ -2968,7 +4021,7 @@ gum_exec_block_virtualize_branch_insn (GumExecBlock * block,
   {
     gboolean target_is_excluded = FALSE;
 
-    if ((ctx->sink_mask & GUM_CALL) != 0)
+    if ((ctx->active_mask & GUM_CALL) != 0)
     {
       gum_exec_block_write_call_event_code (block, &target, gc,
           GUM_CODE_INTERRUPTIBLE);
@@ -3103,7 +4156,7 @@ static GumVirtualizationRequirements
 gum_exec_block_virtualize_ret_insn (GumExecBlock * block,
                                     GumGeneratorContext * gc)
 {
-  if ((block->ctx->sink_mask & GUM_RET) != 0)
+  if ((block->ctx->active_mask & GUM_RET) != 0)
     gum_exec_block_write_ret_event_code (block, gc, GUM_CODE_INTERRUPTIBLE);
 
   gum_x86_relocator_skip_one_no_label (gc->relocator);
@@ -3233,7 +4286,6 @@ gum_exec_block_write_call_invoke_code (GumExecBlock * block,
   gconstpointer push_application_retaddr = cw->code + 1;
   gconstpointer perform_stack_push = cw->code + 2;
   gconstpointer look_in_cache = cw->code + 3;
-  gconstpointer try_second = cw->code + 4;
   gconstpointer resolve_dynamically = cw->code + 5;
   gconstpointer beach = cw->code + 6;
   gpointer ret_real_address, ret_code_address;
@@ -3241,6 +4293,8 @@ gum_exec_block_write_call_invoke_code (GumExecBlock * block,
   call_code_start = cw->code;
   opened_prolog = gc->opened_prolog;
 
+  gum_exec_ctx_maybe_queue_for_compilation (block->ctx, target);
+
   can_backpatch_statically = block->ctx->stalker->trust_threshold >= 0 &&
       !target->is_indirect &&
       target->base == X86_REG_INVALID;
@@ -3248,10 +4302,6 @@ gum_exec_block_write_call_invoke_code (GumExecBlock * block,
   if (block->ctx->stalker->trust_threshold >= 0 &&
       !can_backpatch_statically)
   {
-    gpointer null_ptr = NULL;
-    gpointer ic1_real, ic1_code;
-    gpointer ic2_real, ic2_code;
-
     if (opened_prolog == GUM_PROLOG_NONE)
     {
       gum_exec_block_open_prolog (block, GUM_PROLOG_IC, gc);
@@ -3278,38 +4328,14 @@ gum_exec_block_write_call_invoke_code (GumExecBlock * block,
 
     gum_x86_writer_put_jmp_short_label (cw, look_in_cache);
 
-    ic_entries = gum_x86_writer_cur (cw);
-    ic1_real = ic_entries;
-    gum_x86_writer_put_bytes (cw, (guint8 *) &null_ptr, sizeof (null_ptr));
-    ic1_code = gum_x86_writer_cur (cw);
-    gum_x86_writer_put_bytes (cw, (guint8 *) &null_ptr, sizeof (null_ptr));
-    ic2_real = gum_x86_writer_cur (cw);
-    gum_x86_writer_put_bytes (cw, (guint8 *) &null_ptr, sizeof (null_ptr));
-    ic2_code = gum_x86_writer_cur (cw);
-    gum_x86_writer_put_bytes (cw, (guint8 *) &null_ptr, sizeof (null_ptr));
+    ic_entries = gum_exec_block_write_inline_cache_table (block, cw);
 
     gum_x86_writer_put_label (cw, look_in_cache);
 
     gum_exec_ctx_write_push_branch_target_address (block->ctx, target, gc);
 
-    gum_x86_writer_put_mov_reg_near_ptr (cw, GUM_REG_XAX,
-        GUM_ADDRESS (ic1_real));
-    gum_x86_writer_put_cmp_reg_offset_ptr_reg (cw, GUM_REG_XSP, 0, GUM_REG_XAX);
-    gum_x86_writer_put_jcc_short_label (cw, X86_INS_JNE, try_second,
-        GUM_NO_HINT);
-    gum_x86_writer_put_pop_reg (cw, GUM_REG_XAX);
-    gum_exec_ctx_write_epilog (block->ctx, GUM_PROLOG_IC, cw);
-    gum_x86_writer_put_jmp_near_ptr (cw, GUM_ADDRESS (ic1_code));
-
-    gum_x86_writer_put_label (cw, try_second);
-    gum_x86_writer_put_mov_reg_near_ptr (cw, GUM_REG_XAX,
-        GUM_ADDRESS (ic2_real));
-    gum_x86_writer_put_cmp_reg_offset_ptr_reg (cw, GUM_REG_XSP, 0, GUM_REG_XAX);
-    gum_x86_writer_put_jcc_short_label (cw, X86_INS_JNE, resolve_dynamically,
-        GUM_NO_HINT);
-    gum_x86_writer_put_pop_reg (cw, GUM_REG_XAX);
-    gum_exec_ctx_write_epilog (block->ctx, GUM_PROLOG_IC, cw);
-    gum_x86_writer_put_jmp_near_ptr (cw, GUM_ADDRESS (ic2_code));
+    gum_exec_block_write_inline_cache_lookup (block, ic_entries, cw,
+        resolve_dynamically);
 
     gum_x86_writer_put_label (cw, resolve_dynamically);
     gum_x86_writer_put_pop_reg (cw, GUM_REG_XAX);
@@ -3451,12 +4477,13 @@ gum_exec_block_write_jmp_transfer_code (GumExecBlock * block,
   gboolean can_backpatch_statically;
   gpointer * ic_entries = NULL;
   gconstpointer look_in_cache = cw->code + 1;
-  gconstpointer try_second = cw->code + 2;
   gconstpointer resolve_dynamically = cw->code + 3;
 
   code_start = cw->code;
   opened_prolog = gc->opened_prolog;
 
+  gum_exec_ctx_maybe_queue_for_compilation (block->ctx, target);
+
   can_backpatch_statically = block->ctx->stalker->trust_threshold >= 0 &&
       !target->is_indirect &&
       target->base == X86_REG_INVALID;
@@ -3464,47 +4491,19 @@ gum_exec_block_write_jmp_transfer_code (GumExecBlock * block,
   if (block->ctx->stalker->trust_threshold >= 0 &&
       !can_backpatch_statically)
   {
-    gpointer null_ptr = NULL;
-    gpointer ic1_real, ic1_code;
-    gpointer ic2_real, ic2_code;
-
     gum_exec_block_close_prolog (block, gc);
 
     gum_x86_writer_put_jmp_short_label (cw, look_in_cache);
 
-    ic_entries = gum_x86_writer_cur (cw);
-    ic1_real = ic_entries;
-    gum_x86_writer_put_bytes (cw, (guint8 *) &null_ptr, sizeof (null_ptr));
-    ic1_code = gum_x86_writer_cur (cw);
-    gum_x86_writer_put_bytes (cw, (guint8 *) &null_ptr, sizeof (null_ptr));
-    ic2_real = gum_x86_writer_cur (cw);
-    gum_x86_writer_put_bytes (cw, (guint8 *) &null_ptr, sizeof (null_ptr));
-    ic2_code = gum_x86_writer_cur (cw);
-    gum_x86_writer_put_bytes (cw, (guint8 *) &null_ptr, sizeof (null_ptr));
+    ic_entries = gum_exec_block_write_inline_cache_table (block, cw);
 
     gum_x86_writer_put_label (cw, look_in_cache);
     gum_exec_block_open_prolog (block, GUM_PROLOG_IC, gc);
 
     gum_exec_ctx_write_push_branch_target_address (block->ctx, target, gc);
 
-    gum_x86_writer_put_mov_reg_near_ptr (cw, GUM_REG_XAX,
-        GUM_ADDRESS (ic1_real));
-    gum_x86_writer_put_cmp_reg_offset_ptr_reg (cw, GUM_REG_XSP, 0, GUM_REG_XAX);
-    gum_x86_writer_put_jcc_short_label (cw, X86_INS_JNE, try_second,
-        GUM_NO_HINT);
-    gum_x86_writer_put_pop_reg (cw, GUM_REG_XAX);
-    gum_exec_ctx_write_epilog (block->ctx, GUM_PROLOG_IC, cw);
-    gum_x86_writer_put_jmp_near_ptr (cw, GUM_ADDRESS (ic1_code));
-
-    gum_x86_writer_put_label (cw, try_second);
-    gum_x86_writer_put_mov_reg_near_ptr (cw, GUM_REG_XAX,
-        GUM_ADDRESS (ic2_real));
-    gum_x86_writer_put_cmp_reg_offset_ptr_reg (cw, GUM_REG_XSP, 0, GUM_REG_XAX);
-    gum_x86_writer_put_jcc_short_label (cw, X86_INS_JNE, resolve_dynamically,
-        GUM_NO_HINT);
-    gum_x86_writer_put_pop_reg (cw, GUM_REG_XAX);
-    gum_exec_ctx_write_epilog (block->ctx, GUM_PROLOG_IC, cw);
-    gum_x86_writer_put_jmp_near_ptr (cw, GUM_ADDRESS (ic2_code));
+    gum_exec_block_write_inline_cache_lookup (block, ic_entries, cw,
+        resolve_dynamically);
 
     gum_x86_writer_put_label (cw, resolve_dynamically);
     gum_x86_writer_put_pop_reg (cw, GUM_REG_XAX);
@@ -3600,7 +4599,7 @@ gum_exec_block_write_sysenter_continuation_code (GumExecBlock * block,
   gum_x86_writer_put_mov_reg_near_ptr (cw, GUM_REG_EDX,
       GUM_ADDRESS (saved_ret_addr));
 
-  if ((block->ctx->sink_mask & GUM_RET) != 0)
+  if ((block->ctx->active_mask & GUM_RET) != 0)
   {
     gum_exec_block_write_ret_event_code (block, gc, GUM_CODE_UNINTERRUPTIBLE);
     gum_exec_block_close_prolog (block, gc);
@@ -3679,76 +4678,189 @@ gum_exec_block_write_call_event_code (GumExecBlock * block,
                                       const GumBranchTarget * target,
                                       GumGeneratorContext * gc,
                                       GumCodeContext cc)
+{
+  GumColdStub * stub;
+
+  stub = gum_exec_block_request_cold_stub (block, GUM_COLD_STUB_CALL_EVENT,
+      gc, cc);
+  stub->target = *target;
+}
+
+static void
+gum_exec_block_write_ret_event_code (GumExecBlock * block,
+                                     GumGeneratorContext * gc,
+                                     GumCodeContext cc)
+{
+  gum_exec_block_request_cold_stub (block, GUM_COLD_STUB_RET_EVENT, gc, cc);
+}
+
+static void
+gum_exec_block_write_exec_event_code (GumExecBlock * block,
+                                      GumGeneratorContext * gc,
+                                      GumCodeContext cc)
+{
+  gum_exec_block_request_cold_stub (block, GUM_COLD_STUB_EXEC_EVENT, gc, cc);
+}
+
+static void
+gum_exec_block_write_block_event_code (GumExecBlock * block,
+                                       GumGeneratorContext * gc,
+                                       GumCodeContext cc)
+{
+  GumColdStub * stub;
+
+  stub = gum_exec_block_request_cold_stub (block, GUM_COLD_STUB_BLOCK_EVENT,
+      gc, cc);
+  stub->range_begin = (gpointer) gc->relocator->input_start;
+  stub->range_end = (gpointer) gc->relocator->input_cur;
+}
+
+/*
+ * Event glue — context save, emit call, unfollow check, context restore —
+ * dwarfs the translated instructions it surrounds, so emitting it inline
+ * would leave the frontend fetching mostly glue. We instead emit a lone
+ * near jump here and defer the glue itself to a cold area past the block's
+ * terminator, keeping the hot stream almost pure translated code.
+ */
+
+static GumColdStub *
+gum_exec_block_request_cold_stub (GumExecBlock * block,
+                                  GumColdStubKind kind,
+                                  GumGeneratorContext * gc,
+                                  GumCodeContext cc)
+{
+  GArray * stubs = block->ctx->cold_stubs;
+  GumX86Writer * cw = gc->code_writer;
+  GumColdStub stub = { 0, };
+
+  stub.kind = kind;
+  stub.entry_label = cw->code;
+  stub.resume_label = cw->code + 1;
+  stub.location = gc->instruction->begin;
+  stub.cc = cc;
+
+  gum_x86_writer_put_jmp_near_label (cw, stub.entry_label);
+  gum_x86_writer_put_label (cw, stub.resume_label);
+
+  g_array_append_val (stubs, stub);
+
+  return &g_array_index (stubs, GumColdStub, stubs->len - 1);
+}
+
+static void
+gum_exec_block_write_cold_stubs (GumExecBlock * block,
+                                 GumGeneratorContext * gc)
+{
+  GArray * stubs = block->ctx->cold_stubs;
+  GumX86Writer * cw = gc->code_writer;
+  guint i;
+
+  for (i = 0; i != stubs->len; i++)
+  {
+    GumColdStub * stub = &g_array_index (stubs, GumColdStub, i);
+
+    gum_x86_writer_put_label (cw, stub->entry_label);
+
+    gc->opened_prolog = GUM_PROLOG_NONE;
+    gc->accumulated_stack_delta = 0;
+
+    switch (stub->kind)
+    {
+      case GUM_COLD_STUB_CALL_EVENT:
+        gum_exec_block_write_cold_call_event_code (block, stub, gc);
+        break;
+      case GUM_COLD_STUB_RET_EVENT:
+        gum_exec_block_write_cold_ret_event_code (block, stub, gc);
+        break;
+      case GUM_COLD_STUB_EXEC_EVENT:
+        gum_exec_block_write_cold_exec_event_code (block, stub, gc);
+        break;
+      case GUM_COLD_STUB_BLOCK_EVENT:
+        gum_exec_block_write_cold_block_event_code (block, stub, gc);
+        break;
+      default:
+        g_assert_not_reached ();
+    }
+
+    gum_exec_block_write_unfollow_check_code (block, stub->location, gc,
+        stub->cc);
+
+    gum_exec_block_close_prolog (block, gc);
+
+    gum_x86_writer_put_jmp_near_label (cw, stub->resume_label);
+  }
+
+  g_array_set_size (stubs, 0);
+}
+
+static void
+gum_exec_block_write_cold_call_event_code (GumExecBlock * block,
+                                           const GumColdStub * stub,
+                                           GumGeneratorContext * gc)
 {
   GumX86Writer * cw = gc->code_writer;
 
   gum_exec_block_open_prolog (block, GUM_PROLOG_FULL, gc);
 
-  gum_exec_ctx_write_push_branch_target_address (block->ctx, target, gc);
+  gum_exec_ctx_write_push_branch_target_address (block->ctx, &stub->target,
+      gc);
   gum_x86_writer_put_pop_reg (cw, GUM_REG_XDX);
 
   gum_x86_writer_put_call_address_with_aligned_arguments (cw, GUM_CALL_CAPI,
       GUM_ADDRESS (gum_exec_ctx_emit_call_event), 4,
       GUM_ARG_ADDRESS, GUM_ADDRESS (block->ctx),
-      GUM_ARG_ADDRESS, GUM_ADDRESS (gc->instruction->begin),
+      GUM_ARG_ADDRESS, GUM_ADDRESS (stub->location),
       GUM_ARG_REGISTER, GUM_REG_XDX,
       GUM_ARG_REGISTER, GUM_REG_XBX);
-
-  gum_exec_block_write_unfollow_check_code (block, gc, cc);
 }
 
 static void
-gum_exec_block_write_ret_event_code (GumExecBlock * block,
-                                     GumGeneratorContext * gc,
-                                     GumCodeContext cc)
+gum_exec_block_write_cold_ret_event_code (GumExecBlock * block,
+                                          const GumColdStub * stub,
+                                          GumGeneratorContext * gc)
 {
   gum_exec_block_open_prolog (block, GUM_PROLOG_FULL, gc);
 
   gum_x86_writer_put_call_address_with_aligned_arguments (gc->code_writer,
       GUM_CALL_CAPI, GUM_ADDRESS (gum_exec_ctx_emit_ret_event), 3,
       GUM_ARG_ADDRESS, GUM_ADDRESS (block->ctx),
-      GUM_ARG_ADDRESS, GUM_ADDRESS (gc->instruction->begin),
+      GUM_ARG_ADDRESS, GUM_ADDRESS (stub->location),
       GUM_ARG_REGISTER, GUM_REG_XBX);
-
-  gum_exec_block_write_unfollow_check_code (block, gc, cc);
 }
 
 static void
-gum_exec_block_write_exec_event_code (GumExecBlock * block,
-                                      GumGeneratorContext * gc,
-                                      GumCodeContext cc)
+gum_exec_block_write_cold_exec_event_code (GumExecBlock * block,
+                                           const GumColdStub * stub,
+                                           GumGeneratorContext * gc)
 {
   gum_exec_block_open_prolog (block, GUM_PROLOG_FULL, gc);
 
   gum_x86_writer_put_call_address_with_aligned_arguments (gc->code_writer,
       GUM_CALL_CAPI, GUM_ADDRESS (gum_exec_ctx_emit_exec_event), 3,
       GUM_ARG_ADDRESS, GUM_ADDRESS (block->ctx),
-      GUM_ARG_ADDRESS, GUM_ADDRESS (gc->instruction->begin),
+      GUM_ARG_ADDRESS, GUM_ADDRESS (stub->location),
       GUM_ARG_REGISTER, GUM_REG_XBX);
-
-  gum_exec_block_write_unfollow_check_code (block, gc, cc);
 }
 
 static void
-gum_exec_block_write_block_event_code (GumExecBlock * block,
-                                       GumGeneratorContext * gc,
-                                       GumCodeContext cc)
+gum_exec_block_write_cold_block_event_code (GumExecBlock * block,
+                                            const GumColdStub * stub,
+                                            GumGeneratorContext * gc)
 {
   gum_exec_block_open_prolog (block, GUM_PROLOG_FULL, gc);
 
   gum_x86_writer_put_call_address_with_aligned_arguments (gc->code_writer,
       GUM_CALL_CAPI, GUM_ADDRESS (gum_exec_ctx_emit_block_event), 5,
       GUM_ARG_ADDRESS, GUM_ADDRESS (block->ctx),
-      GUM_ARG_ADDRESS, GUM_ADDRESS (gc->instruction->begin),
-      GUM_ARG_ADDRESS, GUM_ADDRESS (gc->relocator->input_start),
-      GUM_ARG_ADDRESS, GUM_ADDRESS (gc->relocator->input_cur),
+      GUM_ARG_ADDRESS, GUM_ADDRESS (stub->location),
+      GUM_ARG_ADDRESS, GUM_ADDRESS (stub->range_begin),
+      GUM_ARG_ADDRESS, GUM_ADDRESS (stub->range_end),
       GUM_ARG_REGISTER, GUM_REG_XBX);
-
-  gum_exec_block_write_unfollow_check_code (block, gc, cc);
 }
 
 static void
 gum_exec_block_write_unfollow_check_code (GumExecBlock * block,
+                                          gpointer location,
                                           GumGeneratorContext * gc,
                                           GumCodeContext cc)
 {
@@ -3763,7 +4875,7 @@ gum_exec_block_write_unfollow_check_code (GumExecBlock * block,
   gum_x86_writer_put_call_address_with_aligned_arguments (cw, GUM_CALL_CAPI,
       GUM_ADDRESS (gum_exec_ctx_maybe_unfollow), 2,
       GUM_ARG_ADDRESS, GUM_ADDRESS (ctx),
-      GUM_ARG_ADDRESS, GUM_ADDRESS (gc->instruction->begin));
+      GUM_ARG_ADDRESS, GUM_ADDRESS (location));
   gum_x86_writer_put_test_reg_reg (cw, GUM_REG_EAX, GUM_REG_EAX);
   gum_x86_writer_put_jcc_near_label (cw, X86_INS_JE, beach, GUM_LIKELY);
 
@@ -3829,10 +4941,18 @@ gum_exec_block_write_call_probe_code (GumExecBlock * block,
   {
     GumStalker * stalker = block->ctx->stalker;
 
-    gum_spinlock_acquire (&stalker->probe_lock);
-    skip_probing = g_hash_table_lookup (stalker->probe_array_by_address,
-        target->absolute_address) == NULL;
-    gum_spinlock_release (&stalker->probe_lock);
+    if (!gum_stalker_probe_filter_may_contain (stalker,
+        target->absolute_address))
+    {
+      skip_probing = TRUE;
+    }
+    else
+    {
+      gum_spinlock_acquire (&stalker->probe_lock);
+      skip_probing = g_hash_table_lookup (stalker->probe_array_by_address,
+          target->absolute_address) == NULL;
+      gum_spinlock_release (&stalker->probe_lock);
+    }
   }
 
   if (!skip_probing)
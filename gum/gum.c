@@ -683,6 +683,12 @@ gum_do_query_cpu_features (void)
   GumCpuFeatures features = 0;
   guint a, b, c, d;
 
+  if (gum_get_cpuid (1, &a, &b, &c, &d))
+  {
+    if ((d & (1 << 26)) != 0)
+      features |= GUM_CPU_SSE2;
+  }
+
   if (gum_get_cpuid (7, &a, &b, &c, &d))
   {
     if ((b & (1 << 5)) != 0)
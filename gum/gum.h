@@ -15,30 +15,40 @@
 #include <gum/gumcodeallocator.h>
 #include <gum/gumcodesegment.h>
 #include <gum/gumdarwinmodule.h>
+#include <gum/gumdebuglog.h>
+#include <gum/gumdrcovsink.h>
 #include <gum/gumevent.h>
+#include <gum/gumeventcodec.h>
 #include <gum/gumeventsink.h>
 #include <gum/gumexceptor.h>
+#include <gum/gumfunctionindex.h>
 #include <gum/gumfunction.h>
 #include <gum/guminterceptor.h>
 #include <gum/guminvocationcontext.h>
 #include <gum/guminvocationlistener.h>
 #include <gum/gumkernel.h>
 #include <gum/gumlibc.h>
+#include <gum/gumlz4writer.h>
 #include <gum/gummemory.h>
 #include <gum/gummemoryaccessmonitor.h>
 #include <gum/gummemorymap.h>
+#include <gum/gummemorysnapshot.h>
 #include <gum/gummetalarray.h>
 #include <gum/gummetalhash.h>
 #include <gum/gummoduleapiresolver.h>
+#include <gum/gummodulecoverage.h>
 #include <gum/gummodulemap.h>
+#include <gum/gummoduleobserver.h>
 #include <gum/gumprintf.h>
 #include <gum/gumprocess.h>
 #include <gum/gumreturnaddress.h>
 #include <gum/gumspinlock.h>
 #include <gum/gumstalker.h>
+#include <gum/gumstats.h>
 #include <gum/gumsymbolutil.h>
 #include <gum/gumsysinternals.h>
 #include <gum/gumtls.h>
+#include <gum/gumtracesink.h>
 
 G_BEGIN_DECLS
 
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2010-2020 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#include "gumadaptivelock.h"
+
+#if defined (HAVE_WINDOWS)
+# include <windows.h>
+#elif defined (HAVE_LINUX)
+# include <linux/futex.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+enum
+{
+  GUM_ADAPTIVE_LOCK_FREE      = 0,
+  GUM_ADAPTIVE_LOCK_HELD      = 1,
+  GUM_ADAPTIVE_LOCK_CONTENDED = 2,
+};
+
+#define GUM_ADAPTIVE_LOCK_MAX_SPINS 128
+
+static gint gum_adaptive_lock_swap (GumAdaptiveLock * self, gint value);
+static void gum_adaptive_lock_wait (GumAdaptiveLock * self);
+static void gum_adaptive_lock_wake (GumAdaptiveLock * self);
+
+void
+gum_adaptive_lock_init (GumAdaptiveLock * lock)
+{
+  lock->state = GUM_ADAPTIVE_LOCK_FREE;
+}
+
+void
+gum_adaptive_lock_acquire (GumAdaptiveLock * lock)
+{
+  guint i;
+
+  for (i = 0; i != GUM_ADAPTIVE_LOCK_MAX_SPINS; i++)
+  {
+    if (g_atomic_int_compare_and_exchange (&lock->state,
+        GUM_ADAPTIVE_LOCK_FREE, GUM_ADAPTIVE_LOCK_HELD))
+    {
+      return;
+    }
+  }
+
+  /*
+   * From here on we advertise contention so the holder knows to wake us,
+   * and we leave the contended marker behind on acquire since we cannot
+   * tell whether other waiters remain parked.
+   */
+  while (gum_adaptive_lock_swap (lock, GUM_ADAPTIVE_LOCK_CONTENDED) !=
+      GUM_ADAPTIVE_LOCK_FREE)
+  {
+    gum_adaptive_lock_wait (lock);
+  }
+}
+
+void
+gum_adaptive_lock_release (GumAdaptiveLock * lock)
+{
+  if (gum_adaptive_lock_swap (lock, GUM_ADAPTIVE_LOCK_FREE) ==
+      GUM_ADAPTIVE_LOCK_CONTENDED)
+  {
+    gum_adaptive_lock_wake (lock);
+  }
+}
+
+static gint
+gum_adaptive_lock_swap (GumAdaptiveLock * self,
+                        gint value)
+{
+  gint old;
+
+  do
+    old = g_atomic_int_get (&self->state);
+  while (!g_atomic_int_compare_and_exchange (&self->state, old, value));
+
+  return old;
+}
+
+#if defined (HAVE_WINDOWS) && _WIN32_WINNT >= 0x0602
+
+static void
+gum_adaptive_lock_wait (GumAdaptiveLock * self)
+{
+  gint expected = GUM_ADAPTIVE_LOCK_CONTENDED;
+
+  WaitOnAddress (&self->state, &expected, sizeof (self->state), INFINITE);
+}
+
+static void
+gum_adaptive_lock_wake (GumAdaptiveLock * self)
+{
+  WakeByAddressSingle ((PVOID) &self->state);
+}
+
+#elif defined (HAVE_LINUX)
+
+static void
+gum_adaptive_lock_wait (GumAdaptiveLock * self)
+{
+  syscall (__NR_futex, &self->state, FUTEX_WAIT_PRIVATE,
+      GUM_ADAPTIVE_LOCK_CONTENDED, NULL, NULL, 0);
+}
+
+static void
+gum_adaptive_lock_wake (GumAdaptiveLock * self)
+{
+  syscall (__NR_futex, &self->state, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+#else
+
+static void
+gum_adaptive_lock_wait (GumAdaptiveLock * self)
+{
+  g_thread_yield ();
+}
+
+static void
+gum_adaptive_lock_wake (GumAdaptiveLock * self)
+{
+}
+
+#endif
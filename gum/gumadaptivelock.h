@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2010-2020 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#ifndef __GUM_ADAPTIVE_LOCK_H__
+#define __GUM_ADAPTIVE_LOCK_H__
+
+#include <glib.h>
+
+#define GUM_ADAPTIVE_LOCK_INIT { 0 }
+
+G_BEGIN_DECLS
+
+typedef struct _GumAdaptiveLock GumAdaptiveLock;
+
+/*
+ * Spins briefly and then parks the waiting thread in the kernel, so a
+ * preempted holder does not cost each waiter its scheduler quantum the
+ * way GumSpinlock does. Use the pure spinlock instead for code that
+ * cannot call into the OS.
+ */
+struct _GumAdaptiveLock
+{
+  volatile gint state;
+};
+
+void gum_adaptive_lock_init (GumAdaptiveLock * lock);
+
+void gum_adaptive_lock_acquire (GumAdaptiveLock * lock);
+void gum_adaptive_lock_release (GumAdaptiveLock * lock);
+
+G_END_DECLS
+
+#endif
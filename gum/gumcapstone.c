@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2020 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#include "gumcapstone.h"
+
+#define GUM_CAPSTONE_CACHE_CAPACITY 4
+
+typedef struct _GumCapstoneCacheEntry GumCapstoneCacheEntry;
+
+struct _GumCapstoneCacheEntry
+{
+  cs_arch arch;
+  cs_mode mode;
+  csh handle;
+  gboolean in_use;
+};
+
+static void gum_capstone_cache_free (gpointer data);
+
+static GPrivate gum_capstone_cache_key =
+    G_PRIVATE_INIT (gum_capstone_cache_free);
+
+/*
+ * Borrows a per-thread cached capstone handle for the given arch and mode,
+ * opening one on first use. Borrowed handles always start out with detail
+ * disabled; callers wanting detail enable it after borrowing. Hand the
+ * handle back with gum_capstone_release () instead of cs_close ().
+ */
+csh
+gum_capstone_borrow (cs_arch arch,
+                     cs_mode mode)
+{
+  GumCapstoneCacheEntry * cache, * entry, * slot;
+  guint i;
+  csh handle;
+
+  cache = g_private_get (&gum_capstone_cache_key);
+  if (cache == NULL)
+  {
+    cache = g_new0 (GumCapstoneCacheEntry, GUM_CAPSTONE_CACHE_CAPACITY);
+    g_private_set (&gum_capstone_cache_key, cache);
+  }
+
+  slot = NULL;
+
+  for (i = 0; i != GUM_CAPSTONE_CACHE_CAPACITY; i++)
+  {
+    entry = &cache[i];
+
+    if (entry->in_use)
+      continue;
+
+    if (entry->handle != 0 && entry->arch == arch && entry->mode == mode)
+    {
+      entry->in_use = TRUE;
+      return entry->handle;
+    }
+
+    if (slot == NULL || (slot->handle != 0 && entry->handle == 0))
+      slot = entry;
+  }
+
+  if (cs_open (arch, mode, &handle) != CS_ERR_OK)
+    return 0;
+
+  if (slot != NULL)
+  {
+    if (slot->handle != 0)
+      cs_close (&slot->handle);
+
+    slot->arch = arch;
+    slot->mode = mode;
+    slot->handle = handle;
+    slot->in_use = TRUE;
+  }
+
+  return handle;
+}
+
+void
+gum_capstone_release (csh handle)
+{
+  GumCapstoneCacheEntry * cache;
+  guint i;
+
+  if (handle == 0)
+    return;
+
+  cache = g_private_get (&gum_capstone_cache_key);
+
+  if (cache != NULL)
+  {
+    for (i = 0; i != GUM_CAPSTONE_CACHE_CAPACITY; i++)
+    {
+      GumCapstoneCacheEntry * entry = &cache[i];
+
+      if (entry->handle == handle && entry->in_use)
+      {
+        cs_option (handle, CS_OPT_DETAIL, CS_OPT_OFF);
+        entry->in_use = FALSE;
+        return;
+      }
+    }
+  }
+
+  cs_close (&handle);
+}
+
+static void
+gum_capstone_cache_free (gpointer data)
+{
+  GumCapstoneCacheEntry * cache = data;
+  guint i;
+
+  for (i = 0; i != GUM_CAPSTONE_CACHE_CAPACITY; i++)
+  {
+    GumCapstoneCacheEntry * entry = &cache[i];
+
+    if (entry->handle != 0)
+      cs_close (&entry->handle);
+  }
+
+  g_free (cache);
+}
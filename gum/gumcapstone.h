@@ -0,0 +1,21 @@
+/*
+ * Copyright (C) 2020 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#ifndef __GUM_CAPSTONE_H__
+#define __GUM_CAPSTONE_H__
+
+#include <gum/gumdefs.h>
+
+#include <capstone.h>
+
+G_BEGIN_DECLS
+
+GUM_API csh gum_capstone_borrow (cs_arch arch, cs_mode mode);
+GUM_API void gum_capstone_release (csh handle);
+
+G_END_DECLS
+
+#endif
@@ -6,14 +6,15 @@
 
 #include "gumcloak.h"
 
+#include "gumadaptivelock.h"
 #include "gumlibc.h"
 #include "gummetalarray.h"
-#include "gumspinlock.h"
 
 #include <stdlib.h>
 #include <string.h>
 
 typedef struct _GumCloakedRange GumCloakedRange;
+typedef struct _GumCloakSnapshot GumCloakSnapshot;
 
 struct _GumCloakedRange
 {
@@ -21,6 +22,26 @@ struct _GumCloakedRange
   const guint8 * end;
 };
 
+/*
+ * Range and thread checks run inside allocation, enumeration, and fault
+ * handling hot paths, so the read side operates on an immutable sorted
+ * snapshot published with an atomic pointer swap: readers binary-search
+ * it without taking the lock, and writers pay the cost of rebuilding it.
+ * Superseded snapshots are parked on a retired list and reclaimed once
+ * the reader count drains to zero, so a writer never waits on readers;
+ * this matters because a reader may itself trigger a write by allocating
+ * memory. The thread IDs live in the same allocation, right after the
+ * ranges.
+ */
+struct _GumCloakSnapshot
+{
+  guint length;
+  guint n_threads;
+  GumThreadId * thread_ids;
+  GumCloakSnapshot * next_retired;
+  GumCloakedRange ranges[1];
+};
+
 static gint gum_cloak_index_of_thread (GumThreadId id);
 static gint gum_thread_id_compare (gconstpointer element_a,
     gconstpointer element_b);
@@ -30,22 +51,50 @@ static gint gum_fd_compare (gconstpointer element_a, gconstpointer element_b);
 static void gum_cloak_add_range_unlocked (const GumMemoryRange * range);
 static void gum_cloak_remove_range_unlocked (const GumMemoryRange * range);
 
-static GumSpinlock cloak_lock = GUM_SPINLOCK_INIT;
+static void gum_cloak_publish_snapshot (void);
+static const GumCloakSnapshot * gum_cloak_acquire_snapshot (void);
+static void gum_cloak_release_snapshot (void);
+static guint gum_cloak_snapshot_find_first_ending_above (
+    const GumCloakSnapshot * self, const guint8 * address);
+static gint gum_cloaked_range_compare (gconstpointer element_a,
+    gconstpointer element_b);
+
+static GumAdaptiveLock cloak_lock = GUM_ADAPTIVE_LOCK_INIT;
 static GumMetalArray cloaked_threads;
 static GumMetalArray cloaked_ranges;
 static GumMetalArray cloaked_fds;
 
+static GumCloakSnapshot * cloak_snapshot = NULL;
+static GumCloakSnapshot * cloak_retired_snapshots = NULL;
+static volatile gint cloak_snapshot_readers = 0;
+
 void
 _gum_cloak_init (void)
 {
   gum_metal_array_init (&cloaked_threads, sizeof (GumThreadId));
   gum_metal_array_init (&cloaked_ranges, sizeof (GumCloakedRange));
   gum_metal_array_init (&cloaked_fds, sizeof (gint));
+
+  gum_cloak_publish_snapshot ();
 }
 
 void
 _gum_cloak_deinit (void)
 {
+  GumCloakSnapshot * snapshot;
+
+  snapshot = g_atomic_pointer_get (&cloak_snapshot);
+  g_atomic_pointer_set (&cloak_snapshot, NULL);
+  if (snapshot != NULL)
+    gum_free_pages (snapshot);
+
+  while (cloak_retired_snapshots != NULL)
+  {
+    snapshot = cloak_retired_snapshots;
+    cloak_retired_snapshots = snapshot->next_retired;
+    gum_free_pages (snapshot);
+  }
+
   gum_metal_array_free (&cloaked_fds);
   gum_metal_array_free (&cloaked_ranges);
   gum_metal_array_free (&cloaked_threads);
@@ -57,7 +106,7 @@ gum_cloak_add_thread (GumThreadId id)
   GumThreadId * element, * elements;
   gint i;
 
-  gum_spinlock_acquire (&cloak_lock);
+  gum_adaptive_lock_acquire (&cloak_lock);
 
   element = NULL;
 
@@ -76,7 +125,9 @@ gum_cloak_add_thread (GumThreadId id)
 
   *element = id;
 
-  gum_spinlock_release (&cloak_lock);
+  gum_cloak_publish_snapshot ();
+
+  gum_adaptive_lock_release (&cloak_lock);
 }
 
 void
@@ -84,25 +135,36 @@ gum_cloak_remove_thread (GumThreadId id)
 {
   gint index_;
 
-  gum_spinlock_acquire (&cloak_lock);
+  gum_adaptive_lock_acquire (&cloak_lock);
 
   index_ = gum_cloak_index_of_thread (id);
   if (index_ != -1)
+  {
     gum_metal_array_remove_at (&cloaked_threads, index_);
 
-  gum_spinlock_release (&cloak_lock);
+    gum_cloak_publish_snapshot ();
+  }
+
+  gum_adaptive_lock_release (&cloak_lock);
 }
 
 gboolean
 gum_cloak_has_thread (GumThreadId id)
 {
   gboolean result;
+  const GumCloakSnapshot * snapshot;
 
-  gum_spinlock_acquire (&cloak_lock);
+  snapshot = gum_cloak_acquire_snapshot ();
+  if (snapshot == NULL)
+  {
+    gum_cloak_release_snapshot ();
+    return FALSE;
+  }
 
-  result = gum_cloak_index_of_thread (id) != -1;
+  result = bsearch (&id, snapshot->thread_ids, snapshot->n_threads,
+      sizeof (GumThreadId), gum_thread_id_compare) != NULL;
 
-  gum_spinlock_release (&cloak_lock);
+  gum_cloak_release_snapshot ();
 
   return result;
 }
@@ -114,14 +176,14 @@ gum_cloak_enumerate_threads (GumCloakFoundThreadFunc func,
   guint length, size, i;
   GumThreadId * threads;
 
-  gum_spinlock_acquire (&cloak_lock);
+  gum_adaptive_lock_acquire (&cloak_lock);
 
   length = cloaked_threads.length;
   size = length * cloaked_threads.element_size;
   threads = g_alloca (size);
   gum_memcpy (threads, cloaked_threads.data, size);
 
-  gum_spinlock_release (&cloak_lock);
+  gum_adaptive_lock_release (&cloak_lock);
 
   for (i = 0; i != length; i++)
   {
@@ -162,21 +224,25 @@ gum_thread_id_compare (gconstpointer element_a,
 void
 gum_cloak_add_range (const GumMemoryRange * range)
 {
-  gum_spinlock_acquire (&cloak_lock);
+  gum_adaptive_lock_acquire (&cloak_lock);
 
   gum_cloak_add_range_unlocked (range);
 
-  gum_spinlock_release (&cloak_lock);
+  gum_cloak_publish_snapshot ();
+
+  gum_adaptive_lock_release (&cloak_lock);
 }
 
 void
 gum_cloak_remove_range (const GumMemoryRange * range)
 {
-  gum_spinlock_acquire (&cloak_lock);
+  gum_adaptive_lock_acquire (&cloak_lock);
 
   gum_cloak_remove_range_unlocked (range);
 
-  gum_spinlock_release (&cloak_lock);
+  gum_cloak_publish_snapshot ();
+
+  gum_adaptive_lock_release (&cloak_lock);
 }
 
 static void
@@ -293,6 +359,34 @@ gum_cloak_clip_range (const GumMemoryRange * range)
 {
   GArray * chunks;
   gboolean found_match, dirty;
+  const GumCloakSnapshot * snapshot;
+  const guint8 * range_start, * range_end;
+  guint first_index;
+
+  snapshot = gum_cloak_acquire_snapshot ();
+  if (snapshot == NULL)
+  {
+    gum_cloak_release_snapshot ();
+    return NULL;
+  }
+
+  /*
+   * Even with heavy cloaking nearly every enumerated range leaves the
+   * snapshot untouched, so overlap is ruled out with one binary search
+   * before any allocation happens: the snapshot's intervals are disjoint
+   * and sorted, making the first interval ending above our start the only
+   * possible intersector.
+   */
+  range_start = GSIZE_TO_POINTER (range->base_address);
+  range_end = range_start + range->size;
+  first_index = gum_cloak_snapshot_find_first_ending_above (snapshot,
+      range_start);
+  if (first_index == snapshot->length ||
+      snapshot->ranges[first_index].start >= range_end)
+  {
+    gum_cloak_release_snapshot ();
+    return NULL;
+  }
 
   chunks = g_array_sized_new (FALSE, FALSE, sizeof (GumMemoryRange), 2);
   g_array_append_val (chunks, *range);
@@ -305,8 +399,6 @@ gum_cloak_clip_range (const GumMemoryRange * range)
 
     found_match = FALSE;
 
-    gum_spinlock_acquire (&cloak_lock);
-
     for (chunk_index = 0;
         chunk_index != chunks->len && !found_match;
         chunk_index++)
@@ -314,20 +406,16 @@ gum_cloak_clip_range (const GumMemoryRange * range)
       GumMemoryRange * chunk;
       const guint8 * chunk_start, * chunk_end;
       guint cloaked_index;
-      GumCloakedRange threads;
-      GumCloakedRange ranges;
 
       chunk = &g_array_index (chunks, GumMemoryRange, chunk_index);
       chunk_start = GSIZE_TO_POINTER (chunk->base_address);
       chunk_end = chunk_start + chunk->size;
 
-      gum_metal_array_get_extents (&cloaked_threads,
-          (gpointer *) &threads.start, (gpointer *) &threads.end);
-      gum_metal_array_get_extents (&cloaked_ranges,
-          (gpointer *) &ranges.start, (gpointer *) &ranges.end);
+      cloaked_index = gum_cloak_snapshot_find_first_ending_above (snapshot,
+          chunk_start);
 
-      for (cloaked_index = 0;
-          cloaked_index != 2 + cloaked_ranges.length && !found_match;
+      for (;
+          cloaked_index != snapshot->length && !found_match;
           cloaked_index++)
       {
         const GumCloakedRange * cloaked;
@@ -335,19 +423,10 @@ gum_cloak_clip_range (const GumMemoryRange * range)
         gsize bottom_remainder, top_remainder;
         gboolean chunk_available;
 
-        if (cloaked_index == 0)
-        {
-          cloaked = &threads;
-        }
-        else if (cloaked_index == 1)
-        {
-          cloaked = &ranges;
-        }
-        else
-        {
-          cloaked = gum_metal_array_element_at (&cloaked_ranges,
-              cloaked_index - 2);
-        }
+        cloaked = &snapshot->ranges[cloaked_index];
+
+        if (cloaked->start >= chunk_end)
+          break;
 
         lower_bound = MAX (cloaked->start, chunk_start);
         upper_bound = MIN (cloaked->end, chunk_end);
@@ -388,19 +467,17 @@ gum_cloak_clip_range (const GumMemoryRange * range)
             }
             else
             {
-              gum_spinlock_release (&cloak_lock);
               g_array_insert_val (chunks, chunk_index + 1, top);
-              gum_spinlock_acquire (&cloak_lock);
             }
           }
         }
       }
     }
-
-    gum_spinlock_release (&cloak_lock);
   }
   while (found_match);
 
+  gum_cloak_release_snapshot ();
+
   if (!dirty)
   {
     g_array_free (chunks, TRUE);
@@ -417,14 +494,14 @@ gum_cloak_enumerate_ranges (GumCloakFoundRangeFunc func,
   guint length, size, i;
   GumCloakedRange * ranges;
 
-  gum_spinlock_acquire (&cloak_lock);
+  gum_adaptive_lock_acquire (&cloak_lock);
 
   length = cloaked_ranges.length;
   size = length * cloaked_ranges.element_size;
   ranges = g_alloca (size);
   gum_memcpy (ranges, cloaked_ranges.data, size);
 
-  gum_spinlock_release (&cloak_lock);
+  gum_adaptive_lock_release (&cloak_lock);
 
   for (i = 0; i != length; i++)
   {
@@ -445,7 +522,7 @@ gum_cloak_add_file_descriptor (gint fd)
   gint * element, * elements;
   gint i;
 
-  gum_spinlock_acquire (&cloak_lock);
+  gum_adaptive_lock_acquire (&cloak_lock);
 
   element = NULL;
 
@@ -464,7 +541,7 @@ gum_cloak_add_file_descriptor (gint fd)
 
   *element = fd;
 
-  gum_spinlock_release (&cloak_lock);
+  gum_adaptive_lock_release (&cloak_lock);
 }
 
 void
@@ -472,13 +549,13 @@ gum_cloak_remove_file_descriptor (gint fd)
 {
   gint index_;
 
-  gum_spinlock_acquire (&cloak_lock);
+  gum_adaptive_lock_acquire (&cloak_lock);
 
   index_ = gum_cloak_index_of_fd (fd);
   if (index_ != -1)
     gum_metal_array_remove_at (&cloaked_fds, index_);
 
-  gum_spinlock_release (&cloak_lock);
+  gum_adaptive_lock_release (&cloak_lock);
 }
 
 gboolean
@@ -486,11 +563,11 @@ gum_cloak_has_file_descriptor (gint fd)
 {
   gboolean result;
 
-  gum_spinlock_acquire (&cloak_lock);
+  gum_adaptive_lock_acquire (&cloak_lock);
 
   result = gum_cloak_index_of_fd (fd) != -1;
 
-  gum_spinlock_release (&cloak_lock);
+  gum_adaptive_lock_release (&cloak_lock);
 
   return result;
 }
@@ -502,14 +579,14 @@ gum_cloak_enumerate_file_descriptors (GumCloakFoundFDFunc func,
   guint length, size, i;
   gint * fds;
 
-  gum_spinlock_acquire (&cloak_lock);
+  gum_adaptive_lock_acquire (&cloak_lock);
 
   length = cloaked_fds.length;
   size = length * cloaked_fds.element_size;
   fds = g_alloca (size);
   gum_memcpy (fds, cloaked_fds.data, size);
 
-  gum_spinlock_release (&cloak_lock);
+  gum_adaptive_lock_release (&cloak_lock);
 
   for (i = 0; i != length; i++)
   {
@@ -546,3 +623,156 @@ gum_fd_compare (gconstpointer element_a,
     return -1;
   return 1;
 }
+
+/*
+ * Must be called with cloak_lock held. The new snapshot also covers the
+ * extents of our own bookkeeping arrays and of the snapshot itself, which
+ * clip previously special-cased on every query. Entries are sorted and
+ * coalesced so readers can binary-search disjoint intervals. The sorted
+ * thread IDs are copied into the tail of the same allocation.
+ */
+static void
+gum_cloak_publish_snapshot (void)
+{
+  guint n_entries, n_threads, size_in_bytes, page_size, size_in_pages;
+  guint length, i;
+  GumCloakSnapshot * snapshot, * old;
+  GumCloakedRange * entry;
+  GumThreadId * thread_ids;
+  GumMemoryRange extents;
+
+  n_entries = cloaked_ranges.length + 3;
+  n_threads = cloaked_threads.length;
+
+  size_in_bytes = sizeof (GumCloakSnapshot) +
+      ((n_entries - 1) * sizeof (GumCloakedRange)) +
+      (n_threads * sizeof (GumThreadId));
+  page_size = gum_query_page_size ();
+  size_in_pages = size_in_bytes / page_size;
+  if (size_in_bytes % page_size != 0)
+    size_in_pages++;
+
+  snapshot = gum_alloc_n_pages (size_in_pages, GUM_PAGE_RW);
+  snapshot->next_retired = NULL;
+
+  thread_ids = (GumThreadId *) (snapshot->ranges + n_entries);
+  gum_memcpy (thread_ids, cloaked_threads.data,
+      n_threads * sizeof (GumThreadId));
+  snapshot->n_threads = n_threads;
+  snapshot->thread_ids = thread_ids;
+
+  entry = snapshot->ranges;
+
+  for (i = 0; i != cloaked_ranges.length; i++)
+  {
+    *entry++ = *(GumCloakedRange *)
+        gum_metal_array_element_at (&cloaked_ranges, i);
+  }
+
+  gum_metal_array_get_extents (&cloaked_threads,
+      (gpointer *) &entry->start, (gpointer *) &entry->end);
+  entry++;
+
+  gum_metal_array_get_extents (&cloaked_ranges,
+      (gpointer *) &entry->start, (gpointer *) &entry->end);
+  entry++;
+
+  gum_query_page_allocation_range (snapshot, size_in_pages * page_size,
+      &extents);
+  entry->start = GSIZE_TO_POINTER (extents.base_address);
+  entry->end = entry->start + extents.size;
+
+  qsort (snapshot->ranges, n_entries, sizeof (GumCloakedRange),
+      gum_cloaked_range_compare);
+
+  length = 0;
+  for (i = 0; i != n_entries; i++)
+  {
+    GumCloakedRange * cur = &snapshot->ranges[i];
+
+    if (length != 0 && cur->start <= snapshot->ranges[length - 1].end)
+    {
+      if (cur->end > snapshot->ranges[length - 1].end)
+        snapshot->ranges[length - 1].end = cur->end;
+    }
+    else
+    {
+      snapshot->ranges[length++] = *cur;
+    }
+  }
+  snapshot->length = length;
+
+  old = g_atomic_pointer_get (&cloak_snapshot);
+  g_atomic_pointer_set (&cloak_snapshot, snapshot);
+
+  if (old != NULL)
+  {
+    old->next_retired = cloak_retired_snapshots;
+    cloak_retired_snapshots = old;
+  }
+
+  /*
+   * Any reader arriving from here on can only observe the new snapshot,
+   * so a drained reader count means the retired ones are unreachable.
+   * We never wait for that to happen: a reader may be the one doing
+   * this write, by way of an allocation made while holding a snapshot.
+   */
+  if (g_atomic_int_get (&cloak_snapshot_readers) == 0)
+  {
+    while (cloak_retired_snapshots != NULL)
+    {
+      GumCloakSnapshot * retired = cloak_retired_snapshots;
+
+      cloak_retired_snapshots = retired->next_retired;
+      gum_free_pages (retired);
+    }
+  }
+}
+
+static const GumCloakSnapshot *
+gum_cloak_acquire_snapshot (void)
+{
+  g_atomic_int_inc (&cloak_snapshot_readers);
+
+  return g_atomic_pointer_get (&cloak_snapshot);
+}
+
+static void
+gum_cloak_release_snapshot (void)
+{
+  g_atomic_int_add (&cloak_snapshot_readers, -1);
+}
+
+static guint
+gum_cloak_snapshot_find_first_ending_above (const GumCloakSnapshot * self,
+                                            const guint8 * address)
+{
+  guint lower = 0;
+  guint upper = self->length;
+
+  while (lower != upper)
+  {
+    guint middle = (lower + upper) / 2;
+
+    if (self->ranges[middle].end > address)
+      upper = middle;
+    else
+      lower = middle + 1;
+  }
+
+  return lower;
+}
+
+static gint
+gum_cloaked_range_compare (gconstpointer element_a,
+                           gconstpointer element_b)
+{
+  const GumCloakedRange * a = element_a;
+  const GumCloakedRange * b = element_b;
+
+  if (a->start == b->start)
+    return 0;
+  if (a->start < b->start)
+    return -1;
+  return 1;
+}
@@ -32,6 +32,20 @@
 # define GUM_MAX_CODE_DEFLECTOR_THUNK_SIZE 64
 #endif
 
+/*
+ * Free slices are bucketed by 128 MB address-space windows, the smallest
+ * branch range any architecture we support cares about, so near
+ * allocations only probe the windows a short branch can actually reach.
+ */
+#define GUM_CODE_REGION_SHIFT 27
+
+/*
+ * Batches whose slices have all been freed are kept around in writable
+ * form so repeated attach/detach cycles reuse the same pages instead of
+ * growing the footprint; gum_code_allocator_trim() releases them.
+ */
+#define GUM_CODE_MAX_RECYCLED_BATCHES 4
+
 typedef struct _GumCodePages GumCodePages;
 typedef struct _GumCodeSliceElement GumCodeSliceElement;
 typedef struct _GumCodeDeflectorDispatcher GumCodeDeflectorDispatcher;
@@ -98,8 +112,21 @@ struct _GumInsertDeflectorContext
 
 static GumCodeSlice * gum_code_allocator_try_alloc_batch_near (
     GumCodeAllocator * self, const GumAddressSpec * spec);
+static gpointer gum_code_region_key (gconstpointer address);
+static void gum_code_allocator_add_free_slice (GumCodeAllocator * self,
+    GumCodeSliceElement * element);
+static void gum_code_allocator_remove_free_slice (GumCodeAllocator * self,
+    GList * link);
+static void gum_code_allocator_clear_free_slices (GumCodeAllocator * self);
+static GumCodePages * gum_code_allocator_try_obtain_recycled_pages (
+    GumCodeAllocator * self, const GumAddressSpec * spec);
+static void gum_code_allocator_release_recycled_pages (
+    GumCodeAllocator * self);
 
+static gboolean gum_code_pages_is_near (const GumCodePages * self,
+    const GumAddressSpec * spec);
 static void gum_code_pages_unref (GumCodePages * self);
+static void gum_code_pages_release (GumCodePages * self);
 
 static gboolean gum_code_slice_is_near (const GumCodeSlice * self,
     const GumAddressSpec * spec);
@@ -136,7 +163,9 @@ gum_code_allocator_init (GumCodeAllocator * allocator,
 
   allocator->uncommitted_pages = NULL;
   allocator->dirty_pages = g_hash_table_new (NULL, NULL);
-  allocator->free_slices = NULL;
+  allocator->free_slices_by_region = g_hash_table_new (NULL, NULL);
+  allocator->recycled_pages = NULL;
+  allocator->n_recycled_pages = 0;
 
   allocator->dispatchers = NULL;
 }
@@ -149,12 +178,14 @@ gum_code_allocator_free (GumCodeAllocator * allocator)
   g_slist_free (allocator->dispatchers);
   allocator->dispatchers = NULL;
 
-  g_list_foreach (allocator->free_slices, (GFunc) gum_code_pages_unref, NULL);
+  gum_code_allocator_clear_free_slices (allocator);
+  gum_code_allocator_release_recycled_pages (allocator);
+  g_hash_table_unref (allocator->free_slices_by_region);
   g_hash_table_unref (allocator->dirty_pages);
   g_slist_free (allocator->uncommitted_pages);
   allocator->uncommitted_pages = NULL;
   allocator->dirty_pages = NULL;
-  allocator->free_slices = NULL;
+  allocator->free_slices_by_region = NULL;
 }
 
 GumCodeSlice *
@@ -168,23 +199,68 @@ gum_code_allocator_try_alloc_slice_near (GumCodeAllocator * self,
                                          const GumAddressSpec * spec,
                                          gsize alignment)
 {
-  GList * cur;
+  if (spec != NULL)
+  {
+    gsize near_address = GPOINTER_TO_SIZE (spec->near_address);
+    gsize first_region, last_region, region;
+
+    first_region = (near_address > spec->max_distance)
+        ? (near_address - spec->max_distance) >> GUM_CODE_REGION_SHIFT
+        : 0;
+    last_region = (near_address < G_MAXSIZE - spec->max_distance)
+        ? (near_address + spec->max_distance) >> GUM_CODE_REGION_SHIFT
+        : G_MAXSIZE >> GUM_CODE_REGION_SHIFT;
 
-  for (cur = self->free_slices; cur != NULL; cur = cur->next)
+    for (region = first_region; region <= last_region; region++)
+    {
+      GList * cur;
+
+      cur = g_hash_table_lookup (self->free_slices_by_region,
+          GSIZE_TO_POINTER (region));
+
+      for (; cur != NULL; cur = cur->next)
+      {
+        GumCodeSliceElement * element = (GumCodeSliceElement *) cur;
+        GumCodeSlice * slice = &element->slice;
+
+        if (gum_code_slice_is_near (slice, spec) &&
+            gum_code_slice_is_aligned (slice, alignment))
+        {
+          GumCodePages * pages = element->parent.data;
+
+          gum_code_allocator_remove_free_slice (self, cur);
+
+          g_hash_table_add (self->dirty_pages, pages);
+
+          return slice;
+        }
+      }
+    }
+  }
+  else
   {
-    GumCodeSliceElement * element = (GumCodeSliceElement *) cur;
-    GumCodeSlice * slice = &element->slice;
+    GHashTableIter iter;
+    GList * cur;
 
-    if (gum_code_slice_is_near (slice, spec) &&
-        gum_code_slice_is_aligned (slice, alignment))
+    g_hash_table_iter_init (&iter, self->free_slices_by_region);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &cur))
     {
-      GumCodePages * pages = element->parent.data;
+      for (; cur != NULL; cur = cur->next)
+      {
+        GumCodeSliceElement * element = (GumCodeSliceElement *) cur;
+        GumCodeSlice * slice = &element->slice;
 
-      self->free_slices = g_list_remove_link (self->free_slices, cur);
+        if (gum_code_slice_is_aligned (slice, alignment))
+        {
+          GumCodePages * pages = element->parent.data;
 
-      g_hash_table_add (self->dirty_pages, pages);
+          gum_code_allocator_remove_free_slice (self, &element->parent);
 
-      return slice;
+          g_hash_table_add (self->dirty_pages, pages);
+
+          return slice;
+        }
+      }
     }
   }
 
@@ -223,18 +299,73 @@ gum_code_allocator_commit (GumCodeAllocator * self)
   g_slist_free (self->uncommitted_pages);
   self->uncommitted_pages = NULL;
 
+  gum_clear_cache_begin_batch ();
   g_hash_table_iter_init (&iter, self->dirty_pages);
   while (g_hash_table_iter_next (&iter, (gpointer *) &pages, NULL))
   {
-    gum_clear_cache (pages->data, pages->size);
+    gum_clear_cache_schedule (pages->data, pages->size);
   }
+  gum_clear_cache_commit_batch ();
   g_hash_table_remove_all (self->dirty_pages);
 
   if (!rwx_supported)
   {
-    g_list_foreach (self->free_slices, (GFunc) gum_code_pages_unref, NULL);
-    self->free_slices = NULL;
+    gum_code_allocator_clear_free_slices (self);
+  }
+}
+
+void
+gum_code_allocator_trim (GumCodeAllocator * self)
+{
+  GHashTable * n_free_slices;
+  GHashTableIter iter;
+  GList * cur;
+  GSList * doomed, * d;
+
+  n_free_slices = g_hash_table_new (NULL, NULL);
+
+  g_hash_table_iter_init (&iter, self->free_slices_by_region);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &cur))
+  {
+    for (; cur != NULL; cur = cur->next)
+    {
+      GumCodePages * pages = cur->data;
+
+      g_hash_table_insert (n_free_slices, pages, GSIZE_TO_POINTER (
+          GPOINTER_TO_SIZE (g_hash_table_lookup (n_free_slices, pages)) + 1));
+    }
+  }
+
+  doomed = NULL;
+  g_hash_table_iter_init (&iter, self->free_slices_by_region);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &cur))
+  {
+    for (; cur != NULL; cur = cur->next)
+    {
+      GumCodePages * pages = cur->data;
+
+      if (GPOINTER_TO_SIZE (g_hash_table_lookup (n_free_slices, pages)) ==
+              self->slices_per_batch &&
+          g_hash_table_lookup (self->dirty_pages, pages) == NULL)
+      {
+        doomed = g_slist_prepend (doomed, cur);
+      }
+    }
+  }
+
+  for (d = doomed; d != NULL; d = d->next)
+  {
+    GList * link = d->data;
+    GumCodePages * pages = link->data;
+
+    gum_code_allocator_remove_free_slice (self, link);
+    gum_code_pages_unref (pages);
   }
+  g_slist_free (doomed);
+
+  g_hash_table_unref (n_free_slices);
+
+  gum_code_allocator_release_recycled_pages (self);
 }
 
 static GumCodeSlice *
@@ -242,58 +373,65 @@ gum_code_allocator_try_alloc_batch_near (GumCodeAllocator * self,
                                          const GumAddressSpec * spec)
 {
   GumCodeSlice * result = NULL;
-  gboolean rwx_supported, code_segment_supported;
-  gsize page_size, size_in_pages, size_in_bytes;
-  GumCodeSegment * segment;
-  gpointer data;
+  gboolean rwx_supported;
   GumCodePages * pages;
   guint i;
 
   rwx_supported = gum_query_is_rwx_supported ();
-  code_segment_supported = gum_code_segment_is_supported ();
 
-  page_size = gum_query_page_size ();
-  size_in_pages = self->pages_per_batch;
-  size_in_bytes = size_in_pages * page_size;
-
-  if (rwx_supported || !code_segment_supported)
+  pages = gum_code_allocator_try_obtain_recycled_pages (self, spec);
+  if (pages == NULL)
   {
-    GumPageProtection protection;
-    GumMemoryRange range;
+    gboolean code_segment_supported;
+    gsize size_in_pages, size_in_bytes;
+    GumCodeSegment * segment;
+    gpointer data;
 
-    protection = rwx_supported ? GUM_PAGE_RWX : GUM_PAGE_RW;
+    code_segment_supported = gum_code_segment_is_supported ();
 
-    segment = NULL;
-    if (spec != NULL)
+    size_in_pages = self->pages_per_batch;
+    size_in_bytes = size_in_pages * gum_query_page_size ();
+
+    if (rwx_supported || !code_segment_supported)
     {
-      data = gum_try_alloc_n_pages_near (size_in_pages, protection, spec);
-      if (data == NULL)
-        return NULL;
+      GumPageProtection protection;
+      GumMemoryRange range;
+
+      protection = rwx_supported ? GUM_PAGE_RWX : GUM_PAGE_RW;
+
+      segment = NULL;
+      if (spec != NULL)
+      {
+        data = gum_try_alloc_n_pages_near (size_in_pages, protection, spec);
+        if (data == NULL)
+          return NULL;
+      }
+      else
+      {
+        data = gum_alloc_n_pages (size_in_pages, protection);
+      }
+
+      gum_query_page_allocation_range (data, size_in_bytes, &range);
+      gum_cloak_add_range (&range);
     }
     else
     {
-      data = gum_alloc_n_pages (size_in_pages, protection);
+      segment = gum_code_segment_new (size_in_bytes, spec);
+      if (segment == NULL)
+        return NULL;
+      data = gum_code_segment_get_address (segment);
     }
 
-    gum_query_page_allocation_range (data, size_in_bytes, &range);
-    gum_cloak_add_range (&range);
-  }
-  else
-  {
-    segment = gum_code_segment_new (size_in_bytes, spec);
-    if (segment == NULL)
-      return NULL;
-    data = gum_code_segment_get_address (segment);
-  }
+    pages = g_slice_alloc (self->pages_metadata_size);
 
-  pages = g_slice_alloc (self->pages_metadata_size);
-  pages->ref_count = self->slices_per_batch;
+    pages->segment = segment;
+    pages->data = data;
+    pages->size = size_in_bytes;
 
-  pages->segment = segment;
-  pages->data = data;
-  pages->size = size_in_bytes;
+    pages->allocator = self;
+  }
 
-  pages->allocator = self;
+  pages->ref_count = self->slices_per_batch;
 
   for (i = self->slices_per_batch; i != 0; i--)
   {
@@ -303,7 +441,7 @@ gum_code_allocator_try_alloc_batch_near (GumCodeAllocator * self,
     GumCodeSlice * slice;
 
     slice = &element->slice;
-    slice->data = (guint8 *) data + (slice_index * self->slice_size);
+    slice->data = (guint8 *) pages->data + (slice_index * self->slice_size);
     slice->size = self->slice_size;
 
     link = &element->parent;
@@ -316,10 +454,7 @@ gum_code_allocator_try_alloc_batch_near (GumCodeAllocator * self,
     }
     else
     {
-      if (self->free_slices != NULL)
-        self->free_slices->prev = link;
-      link->next = self->free_slices;
-      self->free_slices = link;
+      gum_code_allocator_add_free_slice (self, element);
     }
   }
 
@@ -331,28 +466,175 @@ gum_code_allocator_try_alloc_batch_near (GumCodeAllocator * self,
   return result;
 }
 
+static gpointer
+gum_code_region_key (gconstpointer address)
+{
+  return GSIZE_TO_POINTER (
+      GPOINTER_TO_SIZE (address) >> GUM_CODE_REGION_SHIFT);
+}
+
+static void
+gum_code_allocator_add_free_slice (GumCodeAllocator * self,
+                                   GumCodeSliceElement * element)
+{
+  gpointer key = gum_code_region_key (element->slice.data);
+  GList * link = &element->parent;
+  GList * head;
+
+  head = g_hash_table_lookup (self->free_slices_by_region, key);
+  if (head != NULL)
+    head->prev = link;
+  link->prev = NULL;
+  link->next = head;
+
+  g_hash_table_insert (self->free_slices_by_region, key, link);
+}
+
+static void
+gum_code_allocator_remove_free_slice (GumCodeAllocator * self,
+                                      GList * link)
+{
+  GumCodeSliceElement * element = (GumCodeSliceElement *) link;
+  gpointer key = gum_code_region_key (element->slice.data);
+
+  if (link->prev == NULL)
+  {
+    if (link->next != NULL)
+    {
+      link->next->prev = NULL;
+      g_hash_table_insert (self->free_slices_by_region, key, link->next);
+    }
+    else
+    {
+      g_hash_table_remove (self->free_slices_by_region, key);
+    }
+  }
+  else
+  {
+    link->prev->next = link->next;
+    if (link->next != NULL)
+      link->next->prev = link->prev;
+  }
+
+  link->prev = NULL;
+  link->next = NULL;
+}
+
+static void
+gum_code_allocator_clear_free_slices (GumCodeAllocator * self)
+{
+  GHashTableIter iter;
+  GList * head;
+
+  g_hash_table_iter_init (&iter, self->free_slices_by_region);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &head))
+  {
+    g_list_foreach (head, (GFunc) gum_code_pages_unref, NULL);
+  }
+  g_hash_table_remove_all (self->free_slices_by_region);
+}
+
+static GumCodePages *
+gum_code_allocator_try_obtain_recycled_pages (GumCodeAllocator * self,
+                                              const GumAddressSpec * spec)
+{
+  GSList * cur;
+
+  for (cur = self->recycled_pages; cur != NULL; cur = cur->next)
+  {
+    GumCodePages * pages = cur->data;
+
+    if (gum_code_pages_is_near (pages, spec))
+    {
+      self->recycled_pages = g_slist_remove (self->recycled_pages, pages);
+      self->n_recycled_pages--;
+
+      return pages;
+    }
+  }
+
+  return NULL;
+}
+
+static void
+gum_code_allocator_release_recycled_pages (GumCodeAllocator * self)
+{
+  g_slist_foreach (self->recycled_pages, (GFunc) gum_code_pages_release, NULL);
+  g_slist_free (self->recycled_pages);
+  self->recycled_pages = NULL;
+  self->n_recycled_pages = 0;
+}
+
+static gboolean
+gum_code_pages_is_near (const GumCodePages * self,
+                        const GumAddressSpec * spec)
+{
+  gssize near_address;
+  gssize pages_start, pages_end;
+  gsize distance_start, distance_end;
+
+  if (spec == NULL)
+    return TRUE;
+
+  near_address = (gssize) spec->near_address;
+
+  pages_start = (gssize) self->data;
+  pages_end = pages_start + self->size - 1;
+
+  distance_start = ABS (near_address - pages_start);
+  distance_end = ABS (near_address - pages_end);
+
+  return distance_start <= spec->max_distance &&
+      distance_end <= spec->max_distance;
+}
+
 static void
 gum_code_pages_unref (GumCodePages * self)
 {
   self->ref_count--;
   if (self->ref_count == 0)
   {
-    if (self->segment != NULL)
+    GumCodeAllocator * allocator = self->allocator;
+
+    if (self->segment == NULL &&
+        !gum_query_is_rwx_supported () &&
+        allocator->n_recycled_pages < GUM_CODE_MAX_RECYCLED_BATCHES)
     {
-      gum_code_segment_free (self->segment);
+      /*
+       * Nothing executes here anymore, so it is safe to make the batch
+       * writable again and hand it to the next allocation as-is.
+       */
+      gum_mprotect (self->data, self->size, GUM_PAGE_RW);
+
+      allocator->recycled_pages =
+          g_slist_prepend (allocator->recycled_pages, self);
+      allocator->n_recycled_pages++;
     }
     else
     {
-      GumMemoryRange range;
+      gum_code_pages_release (self);
+    }
+  }
+}
 
-      gum_free_pages (self->data);
+static void
+gum_code_pages_release (GumCodePages * self)
+{
+  if (self->segment != NULL)
+  {
+    gum_code_segment_free (self->segment);
+  }
+  else
+  {
+    GumMemoryRange range;
 
-      gum_query_page_allocation_range (self->data, self->size, &range);
-      gum_cloak_remove_range (&range);
-    }
+    gum_free_pages (self->data);
 
-    g_slice_free1 (self->allocator->pages_metadata_size, self);
+    gum_query_page_allocation_range (self->data, self->size, &range);
+    gum_cloak_remove_range (&range);
   }
+
+  g_slice_free1 (self->allocator->pages_metadata_size, self);
 }
 
 void
@@ -369,13 +651,7 @@ gum_code_slice_free (GumCodeSlice * slice)
 
   if (gum_query_is_rwx_supported ())
   {
-    GumCodeAllocator * allocator = pages->allocator;
-    GList * link = &element->parent;
-
-    if (allocator->free_slices != NULL)
-      allocator->free_slices->prev = link;
-    link->next = allocator->free_slices;
-    allocator->free_slices = link;
+    gum_code_allocator_add_free_slice (pages->allocator, element);
   }
   else
   {
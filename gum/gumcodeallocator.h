@@ -22,7 +22,9 @@ struct _GumCodeAllocator
 
   GSList * uncommitted_pages;
   GHashTable * dirty_pages;
-  GList * free_slices;
+  GHashTable * free_slices_by_region;
+  GSList * recycled_pages;
+  guint n_recycled_pages;
 
   GSList * dispatchers;
 };
@@ -47,6 +49,7 @@ GumCodeSlice * gum_code_allocator_alloc_slice (GumCodeAllocator * self);
 GumCodeSlice * gum_code_allocator_try_alloc_slice_near (GumCodeAllocator * self,
     const GumAddressSpec * spec, gsize alignment);
 void gum_code_allocator_commit (GumCodeAllocator * self);
+void gum_code_allocator_trim (GumCodeAllocator * self);
 void gum_code_slice_free (GumCodeSlice * slice);
 
 GumCodeDeflector * gum_code_allocator_alloc_deflector (GumCodeAllocator * self,
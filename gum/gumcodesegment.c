@@ -6,7 +6,7 @@
 
 #include "gumcodesegment.h"
 
-#ifndef HAVE_DARWIN
+#if !defined (HAVE_DARWIN) && !defined (HAVE_LINUX)
 
 #include <gio/gio.h>
 
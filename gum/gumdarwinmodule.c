@@ -54,6 +54,7 @@ typedef struct _GumEmitInitOffsetsContext GumEmitInitOffsetsContext;
 typedef struct _GumEmitTermPointersContext GumEmitTermPointersContext;
 
 typedef struct _GumExportsTrieForeachContext GumExportsTrieForeachContext;
+typedef struct _GumDarwinExportIndexEntry GumDarwinExportIndexEntry;
 
 typedef struct _GumFatHeader GumFatHeader;
 typedef struct _GumFatArch32 GumFatArch32;
@@ -132,6 +133,12 @@ struct _GumEmitTermPointersContext
   gsize pointer_size;
 };
 
+struct _GumDarwinExportIndexEntry
+{
+  gchar * name;
+  GumDarwinExportDetails details;
+};
+
 struct _GumExportsTrieForeachContext
 {
   GumFoundDarwinExportFunc func;
@@ -512,9 +519,12 @@ static gboolean gum_add_text_range_if_text_section (
     const GumDarwinSectionDetails * details, gpointer user_data);
 static gboolean gum_section_flags_indicate_text_section (guint32 flags);
 
-static gboolean gum_exports_trie_find (const guint8 * exports,
-    const guint8 * exports_end, const gchar * name,
-    GumDarwinExportDetails * details);
+static void gum_darwin_module_ensure_export_index (GumDarwinModule * self);
+static gboolean gum_collect_export_into_index (
+    const GumDarwinExportDetails * details, gpointer user_data);
+static void gum_darwin_export_index_entry_clear (gpointer element);
+static gint gum_darwin_export_index_entry_compare (gconstpointer a,
+    gconstpointer b);
 static gboolean gum_exports_trie_foreach (const guint8 * exports,
     const guint8 * exports_end, GumFoundDarwinExportFunc func,
     gpointer user_data);
@@ -662,10 +672,15 @@ gum_darwin_module_finalize (GObject * object)
   g_ptr_array_unref (self->dependencies);
   g_ptr_array_unref (self->reexports);
 
+  if (self->export_index != NULL)
+    g_array_unref (self->export_index);
+
   g_free (self->rebases_malloc_data);
   g_free (self->binds_malloc_data);
   g_free (self->lazy_binds_malloc_data);
   g_free (self->exports_malloc_data);
+  g_free (self->symbols_malloc_data);
+  g_free (self->strings_malloc_data);
 
   g_array_unref (self->segments);
   g_array_unref (self->text_ranges);
@@ -838,8 +853,34 @@ gum_darwin_module_resolve_export (GumDarwinModule * self,
 
   if (self->exports != NULL)
   {
-    return gum_exports_trie_find (self->exports, self->exports_end, name,
-        details);
+    GArray * index;
+    guint lower, upper;
+
+    gum_darwin_module_ensure_export_index (self);
+    index = self->export_index;
+
+    lower = 0;
+    upper = index->len;
+    while (lower != upper)
+    {
+      guint middle = (lower + upper) / 2;
+      GumDarwinExportIndexEntry * entry =
+          &g_array_index (index, GumDarwinExportIndexEntry, middle);
+      gint comparison = strcmp (name, entry->name);
+
+      if (comparison == 0)
+      {
+        *details = entry->details;
+        return TRUE;
+      }
+
+      if (comparison < 0)
+        upper = middle;
+      else
+        lower = middle + 1;
+    }
+
+    return FALSE;
   }
   else if (self->filetype == GUM_DARWIN_MODULE_FILETYPE_DYLINKER)
   {
@@ -1074,8 +1115,20 @@ gum_darwin_module_enumerate_exports (GumDarwinModule * self,
 
   if (self->exports != NULL)
   {
-    gum_exports_trie_foreach (self->exports, self->exports_end, func,
-        user_data);
+    GArray * index;
+    guint i;
+
+    gum_darwin_module_ensure_export_index (self);
+    index = self->export_index;
+
+    for (i = 0; i != index->len; i++)
+    {
+      GumDarwinExportIndexEntry * entry =
+          &g_array_index (index, GumDarwinExportIndexEntry, i);
+
+      if (!func (&entry->details, user_data))
+        return;
+    }
   }
   else if (self->filetype == GUM_DARWIN_MODULE_FILETYPE_DYLINKER)
   {
@@ -1118,8 +1171,6 @@ gum_darwin_module_enumerate_symbols (GumDarwinModule * self,
   const GumSymtabCommand * symtab;
   GumAddress slide;
   const guint8 * symbols, * strings;
-  gpointer symbols_malloc_data = NULL;
-  gpointer strings_malloc_data = NULL;
   gsize symbol_index;
 
   if (GUM_DARWIN_MODULE_HAS_HEADER_ONLY (self) ||
@@ -1141,6 +1192,11 @@ gum_darwin_module_enumerate_symbols (GumDarwinModule * self,
     symbols = (guint8 *) image->linkedit + symtab->symoff;
     strings = (guint8 *) image->linkedit + symtab->stroff;
   }
+  else if (self->symbols != NULL)
+  {
+    symbols = self->symbols;
+    strings = self->strings;
+  }
   else
   {
     GumAddress linkedit;
@@ -1154,12 +1210,32 @@ gum_darwin_module_enumerate_symbols (GumDarwinModule * self,
         ? sizeof (GumNList64)
         : sizeof (GumNList32);
 
+    /*
+     * We keep the symbol and string tables around for the lifetime of the
+     * module, as lookups like gum_darwin_module_resolve_symbol_address() walk
+     * them once per query, and fetching them from a remote task costs a
+     * Mach VM round-trip each time.
+     */
     gum_darwin_module_read_and_assign (self, linkedit + symtab->symoff,
-        symtab->nsyms * symbol_size, &symbols, NULL, &symbols_malloc_data);
+        symtab->nsyms * symbol_size, &self->symbols, NULL,
+        &self->symbols_malloc_data);
     gum_darwin_module_read_and_assign (self, linkedit + symtab->stroff,
-        symtab->strsize, &strings, NULL, &strings_malloc_data);
-    if (symbols == NULL || strings == NULL)
+        symtab->strsize, &self->strings, NULL, &self->strings_malloc_data);
+    if (self->symbols == NULL || self->strings == NULL)
+    {
+      g_free (self->symbols_malloc_data);
+      self->symbols_malloc_data = NULL;
+      self->symbols = NULL;
+
+      g_free (self->strings_malloc_data);
+      self->strings_malloc_data = NULL;
+      self->strings = NULL;
+
       goto beach;
+    }
+
+    symbols = self->symbols;
+    strings = self->strings;
   }
 
   for (symbol_index = 0; symbol_index != symtab->nsyms; symbol_index++)
@@ -1200,8 +1276,7 @@ gum_darwin_module_enumerate_symbols (GumDarwinModule * self,
   }
 
 beach:
-  g_free (strings_malloc_data);
-  g_free (symbols_malloc_data);
+  return;
 }
 
 GumAddress
@@ -2807,77 +2882,62 @@ gum_darwin_module_image_free (GumDarwinModuleImage * image)
   g_slice_free (GumDarwinModuleImage, image);
 }
 
-static gboolean
-gum_exports_trie_find (const guint8 * exports,
-                       const guint8 * exports_end,
-                       const gchar * name,
-                       GumDarwinExportDetails * details)
+/*
+ * The export trie is decoded once and kept as a sorted array on the module,
+ * so that subsequent lookups and enumerations are a binary search or a
+ * linear scan over flat memory instead of a fresh trie walk. Entries own
+ * their name copies; reexport symbol pointers reference the trie data,
+ * which the module keeps alive for its entire lifetime.
+ */
+static void
+gum_darwin_module_ensure_export_index (GumDarwinModule * self)
 {
-  const gchar * s;
-  const guint8 * p;
+  if (self->export_index != NULL)
+    return;
 
-  if (exports == exports_end)
-    return FALSE;
+  self->export_index =
+      g_array_new (FALSE, FALSE, sizeof (GumDarwinExportIndexEntry));
+  g_array_set_clear_func (self->export_index,
+      gum_darwin_export_index_entry_clear);
 
-  s = name;
-  p = exports;
-  while (p != NULL)
-  {
-    gint64 terminal_size;
-    const guint8 * children;
-    guint8 child_count, i;
-    guint64 node_offset;
+  gum_exports_trie_foreach (self->exports, self->exports_end,
+      gum_collect_export_into_index, self->export_index);
 
-    terminal_size = gum_read_uleb128 (&p, exports_end);
+  g_array_sort (self->export_index, gum_darwin_export_index_entry_compare);
+}
 
-    if (*s == '\0' && terminal_size != 0)
-    {
-      gum_darwin_export_details_init_from_node (details, name, p, exports_end);
-      return TRUE;
-    }
+static gboolean
+gum_collect_export_into_index (const GumDarwinExportDetails * details,
+                               gpointer user_data)
+{
+  GArray * index = user_data;
+  GumDarwinExportIndexEntry entry;
 
-    children = p + terminal_size;
-    child_count = *children++;
-    p = children;
-    node_offset = 0;
-    for (i = 0; i != child_count; i++)
-    {
-      const gchar * symbol_cur;
-      gboolean matching_edge;
+  entry.name = g_strdup (details->name);
+  entry.details = *details;
+  entry.details.name = entry.name;
 
-      symbol_cur = s;
-      matching_edge = TRUE;
-      while (*p != '\0')
-      {
-        if (matching_edge)
-        {
-          if (*p != *symbol_cur)
-            matching_edge = FALSE;
-          symbol_cur++;
-        }
-        p++;
-      }
-      p++;
+  g_array_append_val (index, entry);
 
-      if (matching_edge)
-      {
-        node_offset = gum_read_uleb128 (&p, exports_end);
-        s = symbol_cur;
-        break;
-      }
-      else
-      {
-        gum_skip_uleb128 (&p, exports_end);
-      }
-    }
+  return TRUE;
+}
 
-    if (node_offset != 0)
-      p = exports + node_offset;
-    else
-      p = NULL;
-  }
+static void
+gum_darwin_export_index_entry_clear (gpointer element)
+{
+  GumDarwinExportIndexEntry * entry = element;
 
-  return FALSE;
+  g_free (entry->name);
+}
+
+static gint
+gum_darwin_export_index_entry_compare (gconstpointer a,
+                                       gconstpointer b)
+{
+  const GumDarwinExportIndexEntry * entry_a = a;
+  const GumDarwinExportIndexEntry * entry_b = b;
+
+  return strcmp (entry_a->name, entry_b->name);
 }
 
 static gboolean
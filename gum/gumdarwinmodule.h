@@ -125,6 +125,12 @@ struct _GumDarwinModule
   const guint8 * exports;
   const guint8 * exports_end;
   gpointer exports_malloc_data;
+  GArray * export_index;
+
+  const guint8 * symbols;
+  gpointer symbols_malloc_data;
+  const guint8 * strings;
+  gpointer strings_malloc_data;
 
   GPtrArray * dependencies;
   GPtrArray * reexports;
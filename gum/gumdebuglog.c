@@ -0,0 +1,404 @@
+/*
+ * Copyright (C) 2020 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#include "gumdebuglog.h"
+
+#include "gum-init.h"
+#include "gumprintf.h"
+#include "gumtls.h"
+
+#include <string.h>
+
+#define GUM_DEBUG_LOG_RING_CAPACITY  256
+#define GUM_DEBUG_LOG_MAX_ARGS         4
+#define GUM_DEBUG_LOG_MAX_MESSAGE    512
+#define GUM_DEBUG_LOG_MAX_SPECIFIER   16
+#define GUM_DEBUG_LOG_DRAIN_INTERVAL (10 * G_TIME_SPAN_MILLISECOND)
+
+typedef struct _GumDebugLogEntry GumDebugLogEntry;
+typedef struct _GumDebugLogRing GumDebugLogRing;
+
+struct _GumDebugLogEntry
+{
+  const gchar * format;
+  gsize args[GUM_DEBUG_LOG_MAX_ARGS];
+};
+
+/*
+ * Single-producer, single-consumer ring: the owning thread appends at head,
+ * the drainer consumes at tail. Recording takes no locks and performs no
+ * allocations, so it is safe from hook callbacks, exceptor handlers, and
+ * allocator hooks; only the format-string pointer and pointer-sized argument
+ * words are captured, with formatting deferred to the drainer. Each thread's
+ * ring is allocated on its first gum_debug_log() call, so threads that must
+ * never allocate should log once during setup.
+ */
+struct _GumDebugLogRing
+{
+  GumDebugLogEntry entries[GUM_DEBUG_LOG_RING_CAPACITY];
+  volatile gint head;
+  volatile gint tail;
+  volatile gint dropped;
+};
+
+static void gum_debug_log_ensure_initialized (void);
+static void gum_debug_log_deinitialize (void);
+static GumDebugLogRing * gum_debug_log_get_ring (void);
+static guint gum_debug_log_count_arguments (const gchar * format);
+static void gum_debug_log_drain_ring (GumDebugLogRing * ring,
+    GumDebugLogSink sink, gpointer sink_data);
+static void gum_debug_log_format_entry (const GumDebugLogEntry * entry,
+    gchar * message, gsize size);
+static gpointer gum_debug_log_drain_loop (gpointer data);
+
+static GumTlsKey gum_debug_log_ring_key;
+
+static GMutex gum_debug_log_mutex;
+static GMutex gum_debug_log_drain_mutex;
+static GSList * gum_debug_log_rings = NULL;
+static GumDebugLogSink gum_debug_log_sink = NULL;
+static gpointer gum_debug_log_sink_data = NULL;
+static GThread * gum_debug_log_drain_thread = NULL;
+static volatile gint gum_debug_log_drain_stop = 0;
+
+static void
+gum_debug_log_ensure_initialized (void)
+{
+  static gsize initialized = FALSE;
+
+  if (g_once_init_enter (&initialized))
+  {
+    gum_debug_log_ring_key = gum_tls_key_new ();
+
+    _gum_register_destructor (gum_debug_log_deinitialize);
+
+    g_once_init_leave (&initialized, TRUE);
+  }
+}
+
+static void
+gum_debug_log_deinitialize (void)
+{
+  gum_debug_log_set_sink (NULL, NULL);
+
+  g_mutex_lock (&gum_debug_log_mutex);
+
+  g_slist_free_full (gum_debug_log_rings, g_free);
+  gum_debug_log_rings = NULL;
+
+  g_mutex_unlock (&gum_debug_log_mutex);
+
+  gum_tls_key_free (gum_debug_log_ring_key);
+}
+
+void
+gum_debug_log_set_sink (GumDebugLogSink sink,
+                        gpointer user_data)
+{
+  GThread * thread_to_join = NULL;
+
+  gum_debug_log_ensure_initialized ();
+
+  g_mutex_lock (&gum_debug_log_mutex);
+
+  gum_debug_log_sink = sink;
+  gum_debug_log_sink_data = user_data;
+
+  if (sink != NULL && gum_debug_log_drain_thread == NULL)
+  {
+    g_atomic_int_set (&gum_debug_log_drain_stop, 0);
+    gum_debug_log_drain_thread = g_thread_new ("gum-debug-log",
+        gum_debug_log_drain_loop, NULL);
+  }
+  else if (sink == NULL && gum_debug_log_drain_thread != NULL)
+  {
+    g_atomic_int_set (&gum_debug_log_drain_stop, 1);
+    thread_to_join = gum_debug_log_drain_thread;
+    gum_debug_log_drain_thread = NULL;
+  }
+
+  g_mutex_unlock (&gum_debug_log_mutex);
+
+  if (thread_to_join != NULL)
+    g_thread_join (thread_to_join);
+}
+
+void
+gum_debug_log (const gchar * format,
+               ...)
+{
+  GumDebugLogRing * ring;
+  gint head, tail;
+  GumDebugLogEntry * entry;
+  guint n_args, i;
+  va_list args;
+
+  ring = gum_debug_log_get_ring ();
+  if (ring == NULL)
+    return;
+
+  head = g_atomic_int_get (&ring->head);
+  tail = g_atomic_int_get (&ring->tail);
+  if (head - tail == GUM_DEBUG_LOG_RING_CAPACITY)
+  {
+    g_atomic_int_inc ((gint *) &ring->dropped);
+    return;
+  }
+
+  entry = &ring->entries[head & (GUM_DEBUG_LOG_RING_CAPACITY - 1)];
+  entry->format = format;
+
+  n_args = gum_debug_log_count_arguments (format);
+
+  va_start (args, format);
+  for (i = 0; i != n_args; i++)
+    entry->args[i] = va_arg (args, gsize);
+  va_end (args);
+
+  g_atomic_int_set (&ring->head, head + 1);
+}
+
+void
+gum_debug_log_flush (void)
+{
+  GSList * rings, * cur;
+  GumDebugLogSink sink;
+  gpointer sink_data;
+
+  gum_debug_log_ensure_initialized ();
+
+  g_mutex_lock (&gum_debug_log_mutex);
+  rings = gum_debug_log_rings;
+  sink = gum_debug_log_sink;
+  sink_data = gum_debug_log_sink_data;
+  g_mutex_unlock (&gum_debug_log_mutex);
+
+  g_mutex_lock (&gum_debug_log_drain_mutex);
+
+  for (cur = rings; cur != NULL; cur = cur->next)
+    gum_debug_log_drain_ring (cur->data, sink, sink_data);
+
+  g_mutex_unlock (&gum_debug_log_drain_mutex);
+}
+
+static GumDebugLogRing *
+gum_debug_log_get_ring (void)
+{
+  GumDebugLogRing * ring;
+
+  gum_debug_log_ensure_initialized ();
+
+  ring = gum_tls_key_get_value (gum_debug_log_ring_key);
+  if (ring == NULL)
+  {
+    ring = g_malloc0 (sizeof (GumDebugLogRing));
+
+    gum_tls_key_set_value (gum_debug_log_ring_key, ring);
+
+    g_mutex_lock (&gum_debug_log_mutex);
+    gum_debug_log_rings = g_slist_prepend (gum_debug_log_rings, ring);
+    g_mutex_unlock (&gum_debug_log_mutex);
+  }
+
+  return ring;
+}
+
+static guint
+gum_debug_log_count_arguments (const gchar * format)
+{
+  guint n = 0;
+  const gchar * p;
+
+  for (p = format; *p != '\0'; p++)
+  {
+    if (*p != '%')
+      continue;
+
+    p++;
+    if (*p == '\0')
+      break;
+    if (*p == '%')
+      continue;
+
+    n++;
+    if (n == GUM_DEBUG_LOG_MAX_ARGS)
+      break;
+  }
+
+  return n;
+}
+
+static void
+gum_debug_log_drain_ring (GumDebugLogRing * ring,
+                          GumDebugLogSink sink,
+                          gpointer sink_data)
+{
+  gint dropped;
+
+  while (TRUE)
+  {
+    gint head, tail;
+    const GumDebugLogEntry * entry;
+    gchar message[GUM_DEBUG_LOG_MAX_MESSAGE];
+
+    head = g_atomic_int_get (&ring->head);
+    tail = g_atomic_int_get (&ring->tail);
+    if (tail == head)
+      break;
+
+    entry = &ring->entries[tail & (GUM_DEBUG_LOG_RING_CAPACITY - 1)];
+
+    if (sink != NULL)
+    {
+      gum_debug_log_format_entry (entry, message, sizeof (message));
+      sink (message, sink_data);
+    }
+
+    g_atomic_int_set (&ring->tail, tail + 1);
+  }
+
+  dropped = g_atomic_int_get (&ring->dropped);
+  if (dropped != 0 && sink != NULL)
+  {
+    gchar message[64];
+
+    g_atomic_int_add ((gint *) &ring->dropped, -dropped);
+
+    gum_snprintf (message, sizeof (message), "<%d messages dropped>",
+        dropped);
+    sink (message, sink_data);
+  }
+}
+
+/*
+ * Arguments were captured as raw pointer-sized words, so the format string
+ * is re-parsed here and each specifier is rendered individually with the
+ * stored word cast according to its conversion. Floating-point conversions
+ * cannot be supported as their arguments do not travel in integer slots;
+ * %s arguments must outlive draining, which in practice means string
+ * literals or other stable storage.
+ */
+static void
+gum_debug_log_format_entry (const GumDebugLogEntry * entry,
+                            gchar * message,
+                            gsize size)
+{
+  gsize offset = 0;
+  guint arg_index = 0;
+  const gchar * p;
+
+  message[0] = '\0';
+
+  for (p = entry->format; *p != '\0' && offset < size - 1; p++)
+  {
+    gchar specifier[GUM_DEBUG_LOG_MAX_SPECIFIER];
+    guint specifier_len;
+    gboolean is_wide;
+    gchar conversion;
+    gsize arg;
+    gint n;
+
+    if (*p != '%')
+    {
+      message[offset++] = *p;
+      message[offset] = '\0';
+      continue;
+    }
+
+    p++;
+    if (*p == '%')
+    {
+      message[offset++] = '%';
+      message[offset] = '\0';
+      continue;
+    }
+
+    specifier[0] = '%';
+    specifier_len = 1;
+    is_wide = FALSE;
+    conversion = '\0';
+    while (*p != '\0' && specifier_len < GUM_DEBUG_LOG_MAX_SPECIFIER - 1)
+    {
+      specifier[specifier_len++] = *p;
+
+      if (*p == 'l' || *p == 'z' || *p == 'j' || *p == 't')
+        is_wide = TRUE;
+
+      if (strchr ("diouxXpsc", *p) != NULL)
+      {
+        conversion = *p;
+        break;
+      }
+
+      p++;
+    }
+    specifier[specifier_len] = '\0';
+
+    if (conversion == '\0' || arg_index == GUM_DEBUG_LOG_MAX_ARGS)
+      break;
+    arg = entry->args[arg_index++];
+
+    switch (conversion)
+    {
+      case 'd':
+      case 'i':
+        if (is_wide)
+          n = gum_snprintf (message + offset, size - offset, specifier,
+              (gssize) arg);
+        else
+          n = gum_snprintf (message + offset, size - offset, specifier,
+              (gint) arg);
+        break;
+      case 'o':
+      case 'u':
+      case 'x':
+      case 'X':
+        if (is_wide)
+          n = gum_snprintf (message + offset, size - offset, specifier,
+              arg);
+        else
+          n = gum_snprintf (message + offset, size - offset, specifier,
+              (guint) arg);
+        break;
+      case 'p':
+        n = gum_snprintf (message + offset, size - offset, specifier,
+            (gpointer) arg);
+        break;
+      case 's':
+        n = gum_snprintf (message + offset, size - offset, specifier,
+            (arg != 0) ? (const gchar *) arg : "(null)");
+        break;
+      case 'c':
+        n = gum_snprintf (message + offset, size - offset, specifier,
+            (gint) arg);
+        break;
+      default:
+        n = 0;
+        break;
+    }
+
+    if (n < 0)
+      break;
+    offset = MIN (offset + n, size - 1);
+  }
+
+  message[MIN (offset, size - 1)] = '\0';
+}
+
+static gpointer
+gum_debug_log_drain_loop (gpointer data)
+{
+  while (g_atomic_int_get (&gum_debug_log_drain_stop) == 0)
+  {
+    gum_debug_log_flush ();
+
+    g_usleep (GUM_DEBUG_LOG_DRAIN_INTERVAL);
+  }
+
+  gum_debug_log_flush ();
+
+  return NULL;
+}
@@ -0,0 +1,24 @@
+/*
+ * Copyright (C) 2020 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#ifndef __GUM_DEBUG_LOG_H__
+#define __GUM_DEBUG_LOG_H__
+
+#include <gum/gumdefs.h>
+
+G_BEGIN_DECLS
+
+typedef void (* GumDebugLogSink) (const gchar * message, gpointer user_data);
+
+GUM_API void gum_debug_log_set_sink (GumDebugLogSink sink,
+    gpointer user_data);
+
+GUM_API void gum_debug_log (const gchar * format, ...);
+GUM_API void gum_debug_log_flush (void);
+
+G_END_DECLS
+
+#endif
@@ -160,6 +160,7 @@ enum _GumCpuFeatures
   GUM_CPU_VFP2    = 1 << 1,
   GUM_CPU_VFP3    = 1 << 2,
   GUM_CPU_PTRAUTH = 1 << 3,
+  GUM_CPU_SSE2    = 1 << 4,
 };
 
 enum _GumInstructionEncoding
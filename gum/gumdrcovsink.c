@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2020 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#include "gumdrcovsink.h"
+
+#include "gumlz4writer.h"
+#include "gummodulemap.h"
+
+#include <stdio.h>
+#include <string.h>
+
+typedef struct _GumDrcovBasicBlock GumDrcovBasicBlock;
+
+#pragma pack (push, 1)
+
+struct _GumDrcovBasicBlock
+{
+  guint32 start;
+  guint16 size;
+  guint16 mod_id;
+};
+
+#pragma pack (pop)
+
+struct _GumDrcovEventSink
+{
+  GObject parent;
+
+  gchar * path;
+  GumEventType mask;
+  GumModuleMap * modules;
+  GHashTable * seen;
+  GArray * blocks;
+};
+
+static void gum_drcov_event_sink_iface_init (gpointer g_iface,
+    gpointer iface_data);
+static void gum_drcov_event_sink_finalize (GObject * object);
+static GumEventType gum_drcov_event_sink_query_mask (GumEventSink * sink);
+static void gum_drcov_event_sink_start (GumEventSink * sink);
+static void gum_drcov_event_sink_process (GumEventSink * sink,
+    const GumEvent * event, GumCpuContext * cpu_context);
+static void gum_drcov_event_sink_process_batch (GumEventSink * sink,
+    const GumEvent * events, guint n_events);
+static void gum_drcov_event_sink_record (GumDrcovEventSink * self,
+    gpointer begin, gpointer end);
+static void gum_drcov_event_sink_flush (GumEventSink * sink);
+
+G_DEFINE_TYPE_EXTENDED (GumDrcovEventSink,
+                        gum_drcov_event_sink,
+                        G_TYPE_OBJECT,
+                        0,
+                        G_IMPLEMENT_INTERFACE (GUM_TYPE_EVENT_SINK,
+                            gum_drcov_event_sink_iface_init))
+
+GumEventSink *
+gum_drcov_event_sink_new (const gchar * path,
+                          GumEventType mask)
+{
+  GumDrcovEventSink * sink;
+
+  g_assert ((mask & ~(GUM_COMPILE | GUM_BLOCK)) == 0);
+
+  sink = g_object_new (GUM_TYPE_DRCOV_EVENT_SINK, NULL);
+  sink->path = g_strdup (path);
+  sink->mask = (mask != GUM_NOTHING) ? mask : GUM_COMPILE;
+
+  return GUM_EVENT_SINK (sink);
+}
+
+static void
+gum_drcov_event_sink_class_init (GumDrcovEventSinkClass * klass)
+{
+  GObjectClass * object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gum_drcov_event_sink_finalize;
+}
+
+static void
+gum_drcov_event_sink_iface_init (gpointer g_iface,
+                                 gpointer iface_data)
+{
+  GumEventSinkInterface * iface = g_iface;
+
+  iface->query_mask = gum_drcov_event_sink_query_mask;
+  iface->start = gum_drcov_event_sink_start;
+  iface->process = gum_drcov_event_sink_process;
+  iface->process_batch = gum_drcov_event_sink_process_batch;
+  iface->flush = gum_drcov_event_sink_flush;
+  iface->stop = gum_drcov_event_sink_flush;
+}
+
+static void
+gum_drcov_event_sink_init (GumDrcovEventSink * self)
+{
+  self->seen = g_hash_table_new (NULL, NULL);
+  self->blocks = g_array_new (FALSE, FALSE, sizeof (GumDrcovBasicBlock));
+}
+
+static void
+gum_drcov_event_sink_finalize (GObject * object)
+{
+  GumDrcovEventSink * self = GUM_DRCOV_EVENT_SINK (object);
+
+  g_clear_object (&self->modules);
+  g_array_free (self->blocks, TRUE);
+  g_hash_table_unref (self->seen);
+  g_free (self->path);
+
+  G_OBJECT_CLASS (gum_drcov_event_sink_parent_class)->finalize (object);
+}
+
+static GumEventType
+gum_drcov_event_sink_query_mask (GumEventSink * sink)
+{
+  return GUM_DRCOV_EVENT_SINK (sink)->mask;
+}
+
+static void
+gum_drcov_event_sink_start (GumEventSink * sink)
+{
+  GumDrcovEventSink * self = GUM_DRCOV_EVENT_SINK (sink);
+
+  if (self->modules == NULL)
+    self->modules = gum_module_map_new ();
+}
+
+static void
+gum_drcov_event_sink_process (GumEventSink * sink,
+                              const GumEvent * event,
+                              GumCpuContext * cpu_context)
+{
+  GumDrcovEventSink * self = GUM_DRCOV_EVENT_SINK (sink);
+
+  if (event->type != GUM_COMPILE && event->type != GUM_BLOCK)
+    return;
+
+  gum_drcov_event_sink_record (self, event->compile.begin,
+      event->compile.end);
+}
+
+static void
+gum_drcov_event_sink_process_batch (GumEventSink * sink,
+                                    const GumEvent * events,
+                                    guint n_events)
+{
+  guint i;
+
+  for (i = 0; i != n_events; i++)
+    gum_drcov_event_sink_process (sink, &events[i], NULL);
+}
+
+static void
+gum_drcov_event_sink_record (GumDrcovEventSink * self,
+                             gpointer begin,
+                             gpointer end)
+{
+  const GumModuleDetails * module;
+  GArray * modules;
+  guint mod_id;
+  GumDrcovBasicBlock bb;
+
+  if (!g_hash_table_add (self->seen, begin))
+    return;
+
+  module = gum_module_map_find (self->modules, GUM_ADDRESS (begin));
+  if (module == NULL)
+    return;
+
+  modules = gum_module_map_get_values (self->modules);
+  mod_id = module - (const GumModuleDetails *) modules->data;
+
+  bb.start = (guint32) (GUM_ADDRESS (begin) - module->range->base_address);
+  bb.size = (guint16) ((guint8 *) end - (guint8 *) begin);
+  bb.mod_id = (guint16) mod_id;
+
+  g_array_append_val (self->blocks, bb);
+}
+
+static void
+gum_drcov_event_sink_flush (GumEventSink * sink)
+{
+  GumDrcovEventSink * self = GUM_DRCOV_EVENT_SINK (sink);
+  GString * output;
+  GArray * modules;
+  guint i;
+
+  if (self->modules == NULL)
+    return;
+
+  modules = gum_module_map_get_values (self->modules);
+
+  output = g_string_sized_new (4096);
+
+  g_string_append (output, "DRCOV VERSION: 2\n");
+  g_string_append (output, "DRCOV FLAVOR: frida\n");
+  g_string_append_printf (output, "Module Table: version 2, count %u\n",
+      modules->len);
+  g_string_append (output, "Columns: id, base, end, entry, checksum, "
+      "timestamp, path\n");
+
+  for (i = 0; i != modules->len; i++)
+  {
+    GumModuleDetails * m = &g_array_index (modules, GumModuleDetails, i);
+
+    g_string_append_printf (output, "%3u, 0x%" G_GINT64_MODIFIER "x, "
+        "0x%" G_GINT64_MODIFIER "x, 0x0000000000000000, 0x00000000, "
+        "0x00000000, %s\n",
+        i,
+        m->range->base_address,
+        m->range->base_address + m->range->size,
+        m->path);
+  }
+
+  g_string_append_printf (output, "BB Table: %u bbs\n", self->blocks->len);
+  g_string_append_len (output, (const gchar *) self->blocks->data,
+      self->blocks->len * sizeof (GumDrcovBasicBlock));
+
+  if (g_str_has_suffix (self->path, ".lz4"))
+  {
+    GumLz4Writer * writer;
+
+    writer = gum_lz4_writer_open (self->path);
+    if (writer != NULL)
+    {
+      gum_lz4_writer_write (writer, output->str, output->len);
+      gum_lz4_writer_close (writer);
+    }
+  }
+  else
+  {
+    FILE * file;
+
+    file = fopen (self->path, "wb");
+    if (file != NULL)
+    {
+      fwrite (output->str, output->len, 1, file);
+      fclose (file);
+    }
+  }
+
+  g_string_free (output, TRUE);
+}
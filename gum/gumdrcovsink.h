@@ -0,0 +1,23 @@
+/*
+ * Copyright (C) 2020 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#ifndef __GUM_DRCOV_SINK_H__
+#define __GUM_DRCOV_SINK_H__
+
+#include <gum/gumeventsink.h>
+
+G_BEGIN_DECLS
+
+#define GUM_TYPE_DRCOV_EVENT_SINK (gum_drcov_event_sink_get_type ())
+G_DECLARE_FINAL_TYPE (GumDrcovEventSink, gum_drcov_event_sink, GUM,
+    DRCOV_EVENT_SINK, GObject)
+
+GUM_API GumEventSink * gum_drcov_event_sink_new (const gchar * path,
+    GumEventType mask);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2020 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#include "gumeventcodec.h"
+
+#include "gumleb.h"
+
+static void gum_event_encoder_put_uleb128 (GumEventEncoder * self,
+    guint64 value);
+static void gum_event_encoder_put_sleb128 (GumEventEncoder * self,
+    gint64 value);
+
+void
+gum_event_encoder_init (GumEventEncoder * encoder)
+{
+  encoder->bytes = g_byte_array_new ();
+  encoder->last_location = 0;
+  encoder->last_depth = 0;
+}
+
+void
+gum_event_encoder_clear (GumEventEncoder * encoder)
+{
+  g_byte_array_free (encoder->bytes, TRUE);
+  encoder->bytes = NULL;
+}
+
+void
+gum_event_encoder_reset (GumEventEncoder * encoder)
+{
+  g_byte_array_set_size (encoder->bytes, 0);
+  encoder->last_location = 0;
+  encoder->last_depth = 0;
+}
+
+void
+gum_event_encoder_encode (GumEventEncoder * self,
+                          const GumEvent * ev)
+{
+  guint8 tag;
+  GumEventType type = ev->type;
+
+  tag = 0;
+  while ((type >>= 1) != 0)
+    tag++;
+  tag++;
+
+  g_byte_array_append (self->bytes, &tag, 1);
+
+  switch (ev->type)
+  {
+    case GUM_CALL:
+    case GUM_RET:
+    {
+      GumAddress location = GUM_ADDRESS (ev->call.location);
+      GumAddress target = GUM_ADDRESS (ev->call.target);
+
+      gum_event_encoder_put_sleb128 (self,
+          (gint64) (location - self->last_location));
+      gum_event_encoder_put_sleb128 (self, (gint64) (target - location));
+      gum_event_encoder_put_sleb128 (self,
+          ev->call.depth - self->last_depth);
+
+      self->last_location = location;
+      self->last_depth = ev->call.depth;
+
+      break;
+    }
+    case GUM_EXEC:
+    {
+      GumAddress location = GUM_ADDRESS (ev->exec.location);
+
+      gum_event_encoder_put_sleb128 (self,
+          (gint64) (location - self->last_location));
+
+      self->last_location = location;
+
+      break;
+    }
+    case GUM_BLOCK:
+    case GUM_COMPILE:
+    {
+      GumAddress begin = GUM_ADDRESS (ev->block.begin);
+      GumAddress end = GUM_ADDRESS (ev->block.end);
+
+      gum_event_encoder_put_sleb128 (self,
+          (gint64) (begin - self->last_location));
+      gum_event_encoder_put_uleb128 (self, end - begin);
+
+      self->last_location = begin;
+
+      break;
+    }
+    default:
+      g_assert_not_reached ();
+  }
+}
+
+void
+gum_event_encoder_encode_batch (GumEventEncoder * self,
+                                const GumEvent * events,
+                                guint n_events)
+{
+  guint i;
+
+  for (i = 0; i != n_events; i++)
+    gum_event_encoder_encode (self, &events[i]);
+}
+
+const guint8 *
+gum_event_encoder_peek (GumEventEncoder * self,
+                        gsize * size)
+{
+  if (size != NULL)
+    *size = self->bytes->len;
+
+  return self->bytes->data;
+}
+
+void
+gum_event_decoder_init (GumEventDecoder * decoder,
+                        const guint8 * data,
+                        gsize size)
+{
+  decoder->cur = data;
+  decoder->end = data + size;
+  decoder->last_location = 0;
+  decoder->last_depth = 0;
+}
+
+gboolean
+gum_event_decoder_next (GumEventDecoder * self,
+                        GumEvent * ev)
+{
+  guint8 tag;
+  GumEventType type;
+
+  if (self->cur == self->end)
+    return FALSE;
+
+  tag = *self->cur++;
+  type = 1 << (tag - 1);
+
+  ev->type = type;
+
+  switch (type)
+  {
+    case GUM_CALL:
+    case GUM_RET:
+    {
+      GumAddress location, target;
+
+      location = self->last_location +
+          (GumAddress) gum_read_sleb128 (&self->cur, self->end);
+      target = location +
+          (GumAddress) gum_read_sleb128 (&self->cur, self->end);
+
+      ev->call.location = GSIZE_TO_POINTER (location);
+      ev->call.target = GSIZE_TO_POINTER (target);
+      ev->call.depth = self->last_depth +
+          (gint) gum_read_sleb128 (&self->cur, self->end);
+
+      self->last_location = location;
+      self->last_depth = ev->call.depth;
+
+      break;
+    }
+    case GUM_EXEC:
+    {
+      GumAddress location;
+
+      location = self->last_location +
+          (GumAddress) gum_read_sleb128 (&self->cur, self->end);
+
+      ev->exec.location = GSIZE_TO_POINTER (location);
+
+      self->last_location = location;
+
+      break;
+    }
+    case GUM_BLOCK:
+    case GUM_COMPILE:
+    {
+      GumAddress begin, end;
+
+      begin = self->last_location +
+          (GumAddress) gum_read_sleb128 (&self->cur, self->end);
+      end = begin + gum_read_uleb128 (&self->cur, self->end);
+
+      ev->block.begin = GSIZE_TO_POINTER (begin);
+      ev->block.end = GSIZE_TO_POINTER (end);
+
+      self->last_location = begin;
+
+      break;
+    }
+    default:
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+static void
+gum_event_encoder_put_uleb128 (GumEventEncoder * self,
+                               guint64 value)
+{
+  do
+  {
+    guint8 byte = value & 0x7f;
+
+    value >>= 7;
+    if (value != 0)
+      byte |= 0x80;
+
+    g_byte_array_append (self->bytes, &byte, 1);
+  }
+  while (value != 0);
+}
+
+static void
+gum_event_encoder_put_sleb128 (GumEventEncoder * self,
+                               gint64 value)
+{
+  gboolean more = TRUE;
+
+  while (more)
+  {
+    guint8 byte = value & 0x7f;
+
+    value >>= 7;
+    if ((value == 0 && (byte & 0x40) == 0) ||
+        (value == -1 && (byte & 0x40) != 0))
+    {
+      more = FALSE;
+    }
+    else
+    {
+      byte |= 0x80;
+    }
+
+    g_byte_array_append (self->bytes, &byte, 1);
+  }
+}
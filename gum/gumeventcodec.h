@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2020 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#ifndef __GUM_EVENT_CODEC_H__
+#define __GUM_EVENT_CODEC_H__
+
+#include <gum/gumevent.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GumEventEncoder GumEventEncoder;
+typedef struct _GumEventDecoder GumEventDecoder;
+
+struct _GumEventEncoder
+{
+  GByteArray * bytes;
+  GumAddress last_location;
+  gint last_depth;
+};
+
+struct _GumEventDecoder
+{
+  const guint8 * cur;
+  const guint8 * end;
+  GumAddress last_location;
+  gint last_depth;
+};
+
+GUM_API void gum_event_encoder_init (GumEventEncoder * encoder);
+GUM_API void gum_event_encoder_clear (GumEventEncoder * encoder);
+GUM_API void gum_event_encoder_reset (GumEventEncoder * encoder);
+GUM_API void gum_event_encoder_encode (GumEventEncoder * self,
+    const GumEvent * ev);
+GUM_API void gum_event_encoder_encode_batch (GumEventEncoder * self,
+    const GumEvent * events, guint n_events);
+GUM_API const guint8 * gum_event_encoder_peek (GumEventEncoder * self,
+    gsize * size);
+
+GUM_API void gum_event_decoder_init (GumEventDecoder * decoder,
+    const guint8 * data, gsize size);
+GUM_API gboolean gum_event_decoder_next (GumEventDecoder * self,
+    GumEvent * ev);
+
+G_END_DECLS
+
+#endif
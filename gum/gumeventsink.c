@@ -6,17 +6,158 @@
 
 #include "gumeventsink.h"
 
+#include "gumprocess.h"
+
+#define GUM_CALL_SUMMARY_INITIAL_SIZE 1024
+#define GUM_FILTER_CHUNK_SIZE 64
+
+typedef struct _GumCallSummaryTable GumCallSummaryTable;
+
 struct _GumDefaultEventSink
 {
   GObject parent;
 };
 
+struct _GumRingEventSink
+{
+  GObject parent;
+
+  GumEventType mask;
+  GumEvent * events;
+  guint capacity;
+  guint index_mask;
+  gboolean drop_when_full;
+  volatile gint head;
+  volatile gint tail;
+  volatile gint lost;
+};
+
+struct _GumCallSummaryTable
+{
+  GumCallSummaryTable * next;
+  GumThreadId thread_id;
+  GumCallSummaryEntry * slots;
+  guint size;
+  guint occupied;
+};
+
+struct _GumCallSummaryEventSink
+{
+  GObject parent;
+
+  GumCallSummaryFunc func;
+  gpointer data;
+  GDestroyNotify data_destroy;
+
+  GumCallSummaryTable * tables;
+};
+
+struct _GumTeeEventSink
+{
+  GObject parent;
+
+  GumEventType mask_ceiling;
+  GMutex mutex;
+  GPtrArray * sinks;
+  GSList * retired;
+  gboolean started;
+};
+
+struct _GumFilterEventSink
+{
+  GObject parent;
+
+  GumEventSink * inner;
+  GumEventType mask;
+  gboolean have_range;
+  GumMemoryRange range;
+};
+
+struct _GumSamplerEventSink
+{
+  GObject parent;
+
+  GumEventSink * inner;
+  guint interval;
+  volatile gint counter;
+};
+
 static void gum_default_event_sink_iface_init (gpointer g_iface,
     gpointer iface_data);
 static GumEventType gum_default_event_sink_query_mask (GumEventSink * sink);
 static void gum_default_event_sink_process (GumEventSink * sink,
     const GumEvent * event, GumCpuContext * cpu_context);
 
+static void gum_ring_event_sink_iface_init (gpointer g_iface,
+    gpointer iface_data);
+static void gum_ring_event_sink_finalize (GObject * object);
+static GumEventType gum_ring_event_sink_query_mask (GumEventSink * sink);
+static void gum_ring_event_sink_process (GumEventSink * sink,
+    const GumEvent * event, GumCpuContext * cpu_context);
+static void gum_ring_event_sink_process_batch (GumEventSink * sink,
+    const GumEvent * events, guint n_events);
+static void gum_ring_event_sink_append (GumRingEventSink * self,
+    const GumEvent * ev);
+static gboolean gum_ring_event_sink_try_append (GumRingEventSink * self,
+    const GumEvent * ev);
+
+static void gum_call_summary_event_sink_iface_init (gpointer g_iface,
+    gpointer iface_data);
+static void gum_call_summary_event_sink_finalize (GObject * object);
+static GumEventType gum_call_summary_event_sink_query_mask (
+    GumEventSink * sink);
+static void gum_call_summary_event_sink_process (GumEventSink * sink,
+    const GumEvent * event, GumCpuContext * cpu_context);
+static void gum_call_summary_event_sink_process_batch (GumEventSink * sink,
+    const GumEvent * events, guint n_events);
+static void gum_call_summary_event_sink_flush (GumEventSink * sink);
+static GumCallSummaryTable * gum_call_summary_event_sink_get_table (
+    GumCallSummaryEventSink * self);
+static void gum_call_summary_table_add (GumCallSummaryTable * table,
+    GumAddress target);
+static void gum_call_summary_table_grow (GumCallSummaryTable * table);
+
+static void gum_tee_event_sink_iface_init (gpointer g_iface,
+    gpointer iface_data);
+static void gum_tee_event_sink_dispose (GObject * object);
+static void gum_tee_event_sink_finalize (GObject * object);
+static GumEventType gum_tee_event_sink_query_mask (GumEventSink * sink);
+static void gum_tee_event_sink_start (GumEventSink * sink);
+static void gum_tee_event_sink_process (GumEventSink * sink,
+    const GumEvent * event, GumCpuContext * cpu_context);
+static void gum_tee_event_sink_process_batch (GumEventSink * sink,
+    const GumEvent * events, guint n_events);
+static void gum_tee_event_sink_flush (GumEventSink * sink);
+static void gum_tee_event_sink_stop (GumEventSink * sink);
+
+static void gum_filter_event_sink_iface_init (gpointer g_iface,
+    gpointer iface_data);
+static void gum_filter_event_sink_dispose (GObject * object);
+static GumEventType gum_filter_event_sink_query_mask (GumEventSink * sink);
+static void gum_filter_event_sink_start (GumEventSink * sink);
+static void gum_filter_event_sink_process (GumEventSink * sink,
+    const GumEvent * event, GumCpuContext * cpu_context);
+static void gum_filter_event_sink_process_batch (GumEventSink * sink,
+    const GumEvent * events, guint n_events);
+static void gum_filter_event_sink_flush (GumEventSink * sink);
+static void gum_filter_event_sink_stop (GumEventSink * sink);
+static gboolean gum_filter_event_sink_matches (GumFilterEventSink * self,
+    const GumEvent * ev);
+
+static void gum_sampler_event_sink_iface_init (gpointer g_iface,
+    gpointer iface_data);
+static void gum_sampler_event_sink_dispose (GObject * object);
+static GumEventType gum_sampler_event_sink_query_mask (GumEventSink * sink);
+static void gum_sampler_event_sink_start (GumEventSink * sink);
+static void gum_sampler_event_sink_process (GumEventSink * sink,
+    const GumEvent * event, GumCpuContext * cpu_context);
+static void gum_sampler_event_sink_process_batch (GumEventSink * sink,
+    const GumEvent * events, guint n_events);
+static void gum_sampler_event_sink_flush (GumEventSink * sink);
+static void gum_sampler_event_sink_stop (GumEventSink * sink);
+
+static GumAddress gum_event_get_address (const GumEvent * ev);
+
 G_DEFINE_INTERFACE (GumEventSink, gum_event_sink, G_TYPE_OBJECT)
 
 G_DEFINE_TYPE_EXTENDED (GumDefaultEventSink,
@@ -26,6 +167,41 @@ G_DEFINE_TYPE_EXTENDED (GumDefaultEventSink,
                         G_IMPLEMENT_INTERFACE (GUM_TYPE_EVENT_SINK,
                             gum_default_event_sink_iface_init))
 
+G_DEFINE_TYPE_EXTENDED (GumRingEventSink,
+                        gum_ring_event_sink,
+                        G_TYPE_OBJECT,
+                        0,
+                        G_IMPLEMENT_INTERFACE (GUM_TYPE_EVENT_SINK,
+                            gum_ring_event_sink_iface_init))
+
+G_DEFINE_TYPE_EXTENDED (GumCallSummaryEventSink,
+                        gum_call_summary_event_sink,
+                        G_TYPE_OBJECT,
+                        0,
+                        G_IMPLEMENT_INTERFACE (GUM_TYPE_EVENT_SINK,
+                            gum_call_summary_event_sink_iface_init))
+
+G_DEFINE_TYPE_EXTENDED (GumTeeEventSink,
+                        gum_tee_event_sink,
+                        G_TYPE_OBJECT,
+                        0,
+                        G_IMPLEMENT_INTERFACE (GUM_TYPE_EVENT_SINK,
+                            gum_tee_event_sink_iface_init))
+
+G_DEFINE_TYPE_EXTENDED (GumFilterEventSink,
+                        gum_filter_event_sink,
+                        G_TYPE_OBJECT,
+                        0,
+                        G_IMPLEMENT_INTERFACE (GUM_TYPE_EVENT_SINK,
+                            gum_filter_event_sink_iface_init))
+
+G_DEFINE_TYPE_EXTENDED (GumSamplerEventSink,
+                        gum_sampler_event_sink,
+                        G_TYPE_OBJECT,
+                        0,
+                        G_IMPLEMENT_INTERFACE (GUM_TYPE_EVENT_SINK,
+                            gum_sampler_event_sink_iface_init))
+
 static void
 gum_event_sink_default_init (GumEventSinkInterface * iface)
 {
@@ -62,6 +238,28 @@ gum_event_sink_process (GumEventSink * self,
   iface->process (self, event, cpu_context);
 }
 
+void
+gum_event_sink_process_batch (GumEventSink * self,
+                              const GumEvent * events,
+                              guint n_events)
+{
+  GumEventSinkInterface * iface = GUM_EVENT_SINK_GET_IFACE (self);
+
+  if (iface->process_batch != NULL)
+  {
+    iface->process_batch (self, events, n_events);
+  }
+  else
+  {
+    guint i;
+
+    g_assert (iface->process != NULL);
+
+    for (i = 0; i != n_events; i++)
+      iface->process (self, &events[i], NULL);
+  }
+}
+
 void
 gum_event_sink_flush (GumEventSink * self)
 {
@@ -119,3 +317,975 @@ gum_default_event_sink_process (GumEventSink * sink,
 {
 }
 
+GumEventSink *
+gum_ring_event_sink_new (GumEventType mask,
+                         guint capacity,
+                         gboolean drop_when_full)
+{
+  GumRingEventSink * sink;
+  guint rounded_capacity;
+
+  g_assert (capacity != 0);
+
+  rounded_capacity = 1;
+  while (rounded_capacity < capacity)
+    rounded_capacity <<= 1;
+
+  sink = g_object_new (GUM_TYPE_RING_EVENT_SINK, NULL);
+  sink->mask = mask;
+  sink->events = g_new (GumEvent, rounded_capacity);
+  sink->capacity = rounded_capacity;
+  sink->index_mask = rounded_capacity - 1;
+  sink->drop_when_full = drop_when_full;
+
+  return GUM_EVENT_SINK (sink);
+}
+
+guint
+gum_ring_event_sink_drain (GumRingEventSink * self,
+                           GumEvent * events,
+                           guint max_events)
+{
+  guint head, tail, available, n, i;
+
+  head = (guint) g_atomic_int_get (&self->head);
+  tail = (guint) g_atomic_int_get (&self->tail);
+
+  available = head - tail;
+  n = MIN (available, max_events);
+
+  for (i = 0; i != n; i++)
+    events[i] = self->events[(tail + i) & self->index_mask];
+
+  g_atomic_int_set (&self->tail, (gint) (tail + n));
+
+  return n;
+}
+
+guint
+gum_ring_event_sink_get_lost (GumRingEventSink * self)
+{
+  return (guint) g_atomic_int_get (&self->lost);
+}
+
+static void
+gum_ring_event_sink_class_init (GumRingEventSinkClass * klass)
+{
+  GObjectClass * object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gum_ring_event_sink_finalize;
+}
+
+static void
+gum_ring_event_sink_iface_init (gpointer g_iface,
+                                gpointer iface_data)
+{
+  GumEventSinkInterface * iface = g_iface;
+
+  iface->query_mask = gum_ring_event_sink_query_mask;
+  iface->process = gum_ring_event_sink_process;
+  iface->process_batch = gum_ring_event_sink_process_batch;
+}
+
+static void
+gum_ring_event_sink_init (GumRingEventSink * self)
+{
+}
+
+static void
+gum_ring_event_sink_finalize (GObject * object)
+{
+  GumRingEventSink * self = GUM_RING_EVENT_SINK (object);
+
+  g_free (self->events);
+
+  G_OBJECT_CLASS (gum_ring_event_sink_parent_class)->finalize (object);
+}
+
+static GumEventType
+gum_ring_event_sink_query_mask (GumEventSink * sink)
+{
+  return GUM_RING_EVENT_SINK (sink)->mask;
+}
+
+static void
+gum_ring_event_sink_process (GumEventSink * sink,
+                             const GumEvent * event,
+                             GumCpuContext * cpu_context)
+{
+  gum_ring_event_sink_append (GUM_RING_EVENT_SINK (sink), event);
+}
+
+static void
+gum_ring_event_sink_process_batch (GumEventSink * sink,
+                                   const GumEvent * events,
+                                   guint n_events)
+{
+  GumRingEventSink * self = GUM_RING_EVENT_SINK (sink);
+  guint i;
+
+  for (i = 0; i != n_events; i++)
+    gum_ring_event_sink_append (self, &events[i]);
+}
+
+static void
+gum_ring_event_sink_append (GumRingEventSink * self,
+                            const GumEvent * ev)
+{
+  while (!gum_ring_event_sink_try_append (self, ev))
+  {
+    if (self->drop_when_full)
+    {
+      g_atomic_int_inc (&self->lost);
+      return;
+    }
+
+    g_thread_yield ();
+  }
+}
+
+static gboolean
+gum_ring_event_sink_try_append (GumRingEventSink * self,
+                                const GumEvent * ev)
+{
+  guint head, tail;
+
+  head = (guint) g_atomic_int_get (&self->head);
+  tail = (guint) g_atomic_int_get (&self->tail);
+
+  if (head - tail == self->capacity)
+    return FALSE;
+
+  self->events[head & self->index_mask] = *ev;
+
+  g_atomic_int_set (&self->head, (gint) (head + 1));
+
+  return TRUE;
+}
+
+GumEventSink *
+gum_call_summary_event_sink_new (GumCallSummaryFunc func,
+                                 gpointer data,
+                                 GDestroyNotify data_destroy)
+{
+  GumCallSummaryEventSink * sink;
+
+  sink = g_object_new (GUM_TYPE_CALL_SUMMARY_EVENT_SINK, NULL);
+  sink->func = func;
+  sink->data = data;
+  sink->data_destroy = data_destroy;
+
+  return GUM_EVENT_SINK (sink);
+}
+
+static void
+gum_call_summary_event_sink_class_init (GumCallSummaryEventSinkClass * klass)
+{
+  GObjectClass * object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gum_call_summary_event_sink_finalize;
+}
+
+static void
+gum_call_summary_event_sink_iface_init (gpointer g_iface,
+                                        gpointer iface_data)
+{
+  GumEventSinkInterface * iface = g_iface;
+
+  iface->query_mask = gum_call_summary_event_sink_query_mask;
+  iface->process = gum_call_summary_event_sink_process;
+  iface->process_batch = gum_call_summary_event_sink_process_batch;
+  iface->flush = gum_call_summary_event_sink_flush;
+  iface->stop = gum_call_summary_event_sink_flush;
+}
+
+static void
+gum_call_summary_event_sink_init (GumCallSummaryEventSink * self)
+{
+}
+
+static void
+gum_call_summary_event_sink_finalize (GObject * object)
+{
+  GumCallSummaryEventSink * self = GUM_CALL_SUMMARY_EVENT_SINK (object);
+  GumCallSummaryTable * table;
+
+  table = self->tables;
+  while (table != NULL)
+  {
+    GumCallSummaryTable * next = table->next;
+
+    g_free (table->slots);
+    g_slice_free (GumCallSummaryTable, table);
+
+    table = next;
+  }
+
+  if (self->data_destroy != NULL)
+    self->data_destroy (self->data);
+
+  G_OBJECT_CLASS (gum_call_summary_event_sink_parent_class)->finalize (object);
+}
+
+static GumEventType
+gum_call_summary_event_sink_query_mask (GumEventSink * sink)
+{
+  return GUM_CALL;
+}
+
+static void
+gum_call_summary_event_sink_process (GumEventSink * sink,
+                                     const GumEvent * event,
+                                     GumCpuContext * cpu_context)
+{
+  GumCallSummaryEventSink * self = GUM_CALL_SUMMARY_EVENT_SINK (sink);
+
+  if (event->type != GUM_CALL)
+    return;
+
+  gum_call_summary_table_add (gum_call_summary_event_sink_get_table (self),
+      GUM_ADDRESS (event->call.target));
+}
+
+static void
+gum_call_summary_event_sink_process_batch (GumEventSink * sink,
+                                           const GumEvent * events,
+                                           guint n_events)
+{
+  GumCallSummaryEventSink * self = GUM_CALL_SUMMARY_EVENT_SINK (sink);
+  GumCallSummaryTable * table = NULL;
+  guint i;
+
+  for (i = 0; i != n_events; i++)
+  {
+    const GumEvent * ev = &events[i];
+
+    if (ev->type != GUM_CALL)
+      continue;
+
+    if (table == NULL)
+      table = gum_call_summary_event_sink_get_table (self);
+
+    gum_call_summary_table_add (table, GUM_ADDRESS (ev->call.target));
+  }
+}
+
+static void
+gum_call_summary_event_sink_flush (GumEventSink * sink)
+{
+  GumCallSummaryEventSink * self = GUM_CALL_SUMMARY_EVENT_SINK (sink);
+  GArray * summary;
+  GHashTable * index_by_target;
+  GumCallSummaryTable * table;
+  guint i;
+
+  if (self->func == NULL)
+    return;
+
+  summary = g_array_new (FALSE, FALSE, sizeof (GumCallSummaryEntry));
+  index_by_target = g_hash_table_new (NULL, NULL);
+
+  for (table = g_atomic_pointer_get (&self->tables);
+      table != NULL;
+      table = table->next)
+  {
+    for (i = 0; i != table->size; i++)
+    {
+      GumCallSummaryEntry * slot = &table->slots[i];
+      gpointer index_plus_one;
+
+      if (slot->count == 0)
+        continue;
+
+      index_plus_one = g_hash_table_lookup (index_by_target,
+          GSIZE_TO_POINTER (slot->target));
+      if (index_plus_one != NULL)
+      {
+        GumCallSummaryEntry * entry = &g_array_index (summary,
+            GumCallSummaryEntry, GPOINTER_TO_SIZE (index_plus_one) - 1);
+
+        entry->count += slot->count;
+      }
+      else
+      {
+        g_array_append_val (summary, *slot);
+        g_hash_table_insert (index_by_target, GSIZE_TO_POINTER (slot->target),
+            GSIZE_TO_POINTER (summary->len));
+      }
+
+      slot->count = 0;
+    }
+  }
+
+  if (summary->len != 0)
+  {
+    self->func ((const GumCallSummaryEntry *) summary->data, summary->len,
+        self->data);
+  }
+
+  g_hash_table_unref (index_by_target);
+  g_array_free (summary, TRUE);
+}
+
+static GumCallSummaryTable *
+gum_call_summary_event_sink_get_table (GumCallSummaryEventSink * self)
+{
+  GumThreadId thread_id = gum_process_get_current_thread_id ();
+  GumCallSummaryTable * table;
+
+  for (table = g_atomic_pointer_get (&self->tables);
+      table != NULL;
+      table = table->next)
+  {
+    if (table->thread_id == thread_id)
+      return table;
+  }
+
+  table = g_slice_new (GumCallSummaryTable);
+  table->thread_id = thread_id;
+  table->slots = g_new0 (GumCallSummaryEntry, GUM_CALL_SUMMARY_INITIAL_SIZE);
+  table->size = GUM_CALL_SUMMARY_INITIAL_SIZE;
+  table->occupied = 0;
+
+  do
+  {
+    table->next = g_atomic_pointer_get (&self->tables);
+  }
+  while (!g_atomic_pointer_compare_and_exchange (&self->tables, table->next,
+      table));
+
+  return table;
+}
+
+static void
+gum_call_summary_table_add (GumCallSummaryTable * table,
+                            GumAddress target)
+{
+  GumCallSummaryEntry * slots = table->slots;
+  guint mask = table->size - 1;
+  guint i = ((guint) (target >> 2) * 2654435761U) & mask;
+
+  while (TRUE)
+  {
+    GumCallSummaryEntry * slot = &slots[i];
+
+    if (slot->target == target)
+    {
+      slot->count++;
+      return;
+    }
+
+    if (slot->target == 0)
+    {
+      slot->target = target;
+      slot->count = 1;
+      table->occupied++;
+
+      if (table->occupied * 4 >= table->size * 3)
+        gum_call_summary_table_grow (table);
+
+      return;
+    }
+
+    i = (i + 1) & mask;
+  }
+}
+
+static void
+gum_call_summary_table_grow (GumCallSummaryTable * table)
+{
+  GumCallSummaryEntry * old_slots = table->slots;
+  guint old_size = table->size;
+  guint new_size = old_size * 2;
+  guint new_mask = new_size - 1;
+  GumCallSummaryEntry * new_slots;
+  guint i;
+
+  new_slots = g_new0 (GumCallSummaryEntry, new_size);
+
+  for (i = 0; i != old_size; i++)
+  {
+    GumCallSummaryEntry * slot = &old_slots[i];
+    guint j;
+
+    if (slot->target == 0)
+      continue;
+
+    j = ((guint) (slot->target >> 2) * 2654435761U) & new_mask;
+    while (new_slots[j].target != 0)
+      j = (j + 1) & new_mask;
+    new_slots[j] = *slot;
+  }
+
+  table->slots = new_slots;
+  table->size = new_size;
+
+  g_free (old_slots);
+}
+
+/*
+ * Fans events out to `sinks`, so one follow can feed e.g. a file trace and a
+ * live aggregation at the same time instead of instrumenting twice. Batches
+ * are forwarded as-is, so the events are buffered once by the producer and
+ * each child consumes the same batch.
+ *
+ * Takes a reference on each sink.
+ */
+GumEventSink *
+gum_tee_event_sink_new (GumEventSink ** sinks,
+                        guint n_sinks)
+{
+  g_assert (n_sinks != 0);
+
+  return gum_tee_event_sink_new_with_mask (GUM_NOTHING, sinks, n_sinks);
+}
+
+/*
+ * Like gum_tee_event_sink_new(), but with a fixed event mask instead of the
+ * union of the children's masks, and children may be attached and detached
+ * while the session is live. Stalker captures the mask when translating
+ * each block, so declaring the union of event types any future consumer may
+ * need up front means the translated code is shared by all of them:
+ * attaching a tracer to a long-running coverage session costs no
+ * recompilation, and each child narrows the stream to its own mask by
+ * wrapping itself in a filter sink. May be created empty.
+ */
+GumEventSink *
+gum_tee_event_sink_new_with_mask (GumEventType mask,
+                                  GumEventSink ** sinks,
+                                  guint n_sinks)
+{
+  GumTeeEventSink * sink;
+  guint i;
+
+  sink = g_object_new (GUM_TYPE_TEE_EVENT_SINK, NULL);
+  sink->mask_ceiling = mask;
+  for (i = 0; i != n_sinks; i++)
+    g_ptr_array_add (sink->sinks, g_object_ref (sinks[i]));
+
+  return GUM_EVENT_SINK (sink);
+}
+
+/*
+ * Membership changes swap in a new snapshot of the child array, so event
+ * delivery never takes the lock: a delivery racing with the change may
+ * briefly see the old snapshot. Retired snapshots keep their references
+ * until the tee is disposed.
+ */
+void
+gum_tee_event_sink_add (GumTeeEventSink * self,
+                        GumEventSink * sink)
+{
+  GPtrArray * old_sinks, * new_sinks;
+  guint i;
+
+  g_mutex_lock (&self->mutex);
+
+  old_sinks = self->sinks;
+
+  new_sinks = g_ptr_array_new_full (old_sinks->len + 1, g_object_unref);
+  for (i = 0; i != old_sinks->len; i++)
+  {
+    g_ptr_array_add (new_sinks,
+        g_object_ref (g_ptr_array_index (old_sinks, i)));
+  }
+  g_ptr_array_add (new_sinks, g_object_ref (sink));
+
+  self->retired = g_slist_prepend (self->retired, old_sinks);
+  g_atomic_pointer_set (&self->sinks, new_sinks);
+
+  if (self->started)
+    gum_event_sink_start (sink);
+
+  g_mutex_unlock (&self->mutex);
+}
+
+gboolean
+gum_tee_event_sink_remove (GumTeeEventSink * self,
+                           GumEventSink * sink)
+{
+  gboolean found = FALSE;
+  GPtrArray * old_sinks, * new_sinks;
+  guint i;
+
+  g_mutex_lock (&self->mutex);
+
+  old_sinks = self->sinks;
+
+  new_sinks = g_ptr_array_new_full (old_sinks->len, g_object_unref);
+  for (i = 0; i != old_sinks->len; i++)
+  {
+    GumEventSink * cur = g_ptr_array_index (old_sinks, i);
+
+    if (cur == sink && !found)
+    {
+      found = TRUE;
+      continue;
+    }
+
+    g_ptr_array_add (new_sinks, g_object_ref (cur));
+  }
+
+  if (found)
+  {
+    self->retired = g_slist_prepend (self->retired, old_sinks);
+    g_atomic_pointer_set (&self->sinks, new_sinks);
+
+    if (self->started)
+      gum_event_sink_stop (sink);
+  }
+  else
+  {
+    g_ptr_array_unref (new_sinks);
+  }
+
+  g_mutex_unlock (&self->mutex);
+
+  return found;
+}
+
+static void
+gum_tee_event_sink_class_init (GumTeeEventSinkClass * klass)
+{
+  GObjectClass * object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = gum_tee_event_sink_dispose;
+  object_class->finalize = gum_tee_event_sink_finalize;
+}
+
+static void
+gum_tee_event_sink_iface_init (gpointer g_iface,
+                               gpointer iface_data)
+{
+  GumEventSinkInterface * iface = g_iface;
+
+  iface->query_mask = gum_tee_event_sink_query_mask;
+  iface->start = gum_tee_event_sink_start;
+  iface->process = gum_tee_event_sink_process;
+  iface->process_batch = gum_tee_event_sink_process_batch;
+  iface->flush = gum_tee_event_sink_flush;
+  iface->stop = gum_tee_event_sink_stop;
+}
+
+static void
+gum_tee_event_sink_init (GumTeeEventSink * self)
+{
+  g_mutex_init (&self->mutex);
+  self->sinks = g_ptr_array_new_with_free_func (g_object_unref);
+}
+
+static void
+gum_tee_event_sink_dispose (GObject * object)
+{
+  GumTeeEventSink * self = GUM_TEE_EVENT_SINK (object);
+
+  g_clear_pointer (&self->sinks, g_ptr_array_unref);
+  g_slist_free_full (g_steal_pointer (&self->retired),
+      (GDestroyNotify) g_ptr_array_unref);
+
+  G_OBJECT_CLASS (gum_tee_event_sink_parent_class)->dispose (object);
+}
+
+static void
+gum_tee_event_sink_finalize (GObject * object)
+{
+  GumTeeEventSink * self = GUM_TEE_EVENT_SINK (object);
+
+  g_mutex_clear (&self->mutex);
+
+  G_OBJECT_CLASS (gum_tee_event_sink_parent_class)->finalize (object);
+}
+
+static GumEventType
+gum_tee_event_sink_query_mask (GumEventSink * sink)
+{
+  GumTeeEventSink * self = GUM_TEE_EVENT_SINK (sink);
+  GPtrArray * sinks;
+  GumEventType mask = GUM_NOTHING;
+  guint i;
+
+  if (self->mask_ceiling != GUM_NOTHING)
+    return self->mask_ceiling;
+
+  sinks = g_atomic_pointer_get (&self->sinks);
+  for (i = 0; i != sinks->len; i++)
+    mask |= gum_event_sink_query_mask (g_ptr_array_index (sinks, i));
+
+  return mask;
+}
+
+static void
+gum_tee_event_sink_start (GumEventSink * sink)
+{
+  GumTeeEventSink * self = GUM_TEE_EVENT_SINK (sink);
+  GPtrArray * sinks;
+  guint i;
+
+  g_mutex_lock (&self->mutex);
+
+  self->started = TRUE;
+
+  sinks = self->sinks;
+  for (i = 0; i != sinks->len; i++)
+    gum_event_sink_start (g_ptr_array_index (sinks, i));
+
+  g_mutex_unlock (&self->mutex);
+}
+
+static void
+gum_tee_event_sink_process (GumEventSink * sink,
+                            const GumEvent * event,
+                            GumCpuContext * cpu_context)
+{
+  GumTeeEventSink * self = GUM_TEE_EVENT_SINK (sink);
+  GPtrArray * sinks;
+  guint i;
+
+  sinks = g_atomic_pointer_get (&self->sinks);
+  for (i = 0; i != sinks->len; i++)
+    gum_event_sink_process (g_ptr_array_index (sinks, i), event, cpu_context);
+}
+
+static void
+gum_tee_event_sink_process_batch (GumEventSink * sink,
+                                  const GumEvent * events,
+                                  guint n_events)
+{
+  GumTeeEventSink * self = GUM_TEE_EVENT_SINK (sink);
+  GPtrArray * sinks;
+  guint i;
+
+  sinks = g_atomic_pointer_get (&self->sinks);
+  for (i = 0; i != sinks->len; i++)
+    gum_event_sink_process_batch (g_ptr_array_index (sinks, i), events,
+        n_events);
+}
+
+static void
+gum_tee_event_sink_flush (GumEventSink * sink)
+{
+  GumTeeEventSink * self = GUM_TEE_EVENT_SINK (sink);
+  GPtrArray * sinks;
+  guint i;
+
+  g_mutex_lock (&self->mutex);
+
+  sinks = self->sinks;
+  for (i = 0; i != sinks->len; i++)
+    gum_event_sink_flush (g_ptr_array_index (sinks, i));
+
+  g_mutex_unlock (&self->mutex);
+}
+
+static void
+gum_tee_event_sink_stop (GumEventSink * sink)
+{
+  GumTeeEventSink * self = GUM_TEE_EVENT_SINK (sink);
+  GPtrArray * sinks;
+  guint i;
+
+  g_mutex_lock (&self->mutex);
+
+  self->started = FALSE;
+
+  sinks = self->sinks;
+  for (i = 0; i != sinks->len; i++)
+    gum_event_sink_stop (g_ptr_array_index (sinks, i));
+
+  g_mutex_unlock (&self->mutex);
+}
+
+/*
+ * Forwards only events whose type is in `mask` and, when `range` is
+ * non-NULL, whose address falls inside it. Matching events are gathered
+ * into stack-local chunks and forwarded batch-wise, so the inner sink
+ * still gets the batched fast path.
+ */
+GumEventSink *
+gum_filter_event_sink_new (GumEventSink * inner,
+                           GumEventType mask,
+                           const GumMemoryRange * range)
+{
+  GumFilterEventSink * sink;
+
+  sink = g_object_new (GUM_TYPE_FILTER_EVENT_SINK, NULL);
+  sink->inner = g_object_ref (inner);
+  sink->mask = mask;
+  if (range != NULL)
+  {
+    sink->have_range = TRUE;
+    sink->range = *range;
+  }
+
+  return GUM_EVENT_SINK (sink);
+}
+
+static void
+gum_filter_event_sink_class_init (GumFilterEventSinkClass * klass)
+{
+  GObjectClass * object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = gum_filter_event_sink_dispose;
+}
+
+static void
+gum_filter_event_sink_iface_init (gpointer g_iface,
+                                  gpointer iface_data)
+{
+  GumEventSinkInterface * iface = g_iface;
+
+  iface->query_mask = gum_filter_event_sink_query_mask;
+  iface->start = gum_filter_event_sink_start;
+  iface->process = gum_filter_event_sink_process;
+  iface->process_batch = gum_filter_event_sink_process_batch;
+  iface->flush = gum_filter_event_sink_flush;
+  iface->stop = gum_filter_event_sink_stop;
+}
+
+static void
+gum_filter_event_sink_init (GumFilterEventSink * self)
+{
+}
+
+static void
+gum_filter_event_sink_dispose (GObject * object)
+{
+  GumFilterEventSink * self = GUM_FILTER_EVENT_SINK (object);
+
+  g_clear_object (&self->inner);
+
+  G_OBJECT_CLASS (gum_filter_event_sink_parent_class)->dispose (object);
+}
+
+static GumEventType
+gum_filter_event_sink_query_mask (GumEventSink * sink)
+{
+  GumFilterEventSink * self = GUM_FILTER_EVENT_SINK (sink);
+
+  return self->mask & gum_event_sink_query_mask (self->inner);
+}
+
+static void
+gum_filter_event_sink_start (GumEventSink * sink)
+{
+  gum_event_sink_start (GUM_FILTER_EVENT_SINK (sink)->inner);
+}
+
+static void
+gum_filter_event_sink_process (GumEventSink * sink,
+                               const GumEvent * event,
+                               GumCpuContext * cpu_context)
+{
+  GumFilterEventSink * self = GUM_FILTER_EVENT_SINK (sink);
+
+  if (!gum_filter_event_sink_matches (self, event))
+    return;
+
+  gum_event_sink_process (self->inner, event, cpu_context);
+}
+
+static void
+gum_filter_event_sink_process_batch (GumEventSink * sink,
+                                     const GumEvent * events,
+                                     guint n_events)
+{
+  GumFilterEventSink * self = GUM_FILTER_EVENT_SINK (sink);
+  GumEvent chunk[GUM_FILTER_CHUNK_SIZE];
+  guint n, i;
+
+  n = 0;
+  for (i = 0; i != n_events; i++)
+  {
+    const GumEvent * ev = &events[i];
+
+    if (!gum_filter_event_sink_matches (self, ev))
+      continue;
+
+    chunk[n++] = *ev;
+
+    if (n == GUM_FILTER_CHUNK_SIZE)
+    {
+      gum_event_sink_process_batch (self->inner, chunk, n);
+      n = 0;
+    }
+  }
+
+  if (n != 0)
+    gum_event_sink_process_batch (self->inner, chunk, n);
+}
+
+static void
+gum_filter_event_sink_flush (GumEventSink * sink)
+{
+  gum_event_sink_flush (GUM_FILTER_EVENT_SINK (sink)->inner);
+}
+
+static void
+gum_filter_event_sink_stop (GumEventSink * sink)
+{
+  gum_event_sink_stop (GUM_FILTER_EVENT_SINK (sink)->inner);
+}
+
+static gboolean
+gum_filter_event_sink_matches (GumFilterEventSink * self,
+                               const GumEvent * ev)
+{
+  if ((ev->type & self->mask) == 0)
+    return FALSE;
+
+  if (self->have_range &&
+      !GUM_MEMORY_RANGE_INCLUDES (&self->range, gum_event_get_address (ev)))
+  {
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/*
+ * Forwards one event in `interval` to the inner sink, for cheap statistical
+ * profiles where a full trace is not needed. The counter is shared across
+ * threads, so the sampling is uniform process-wide rather than per thread.
+ */
+GumEventSink *
+gum_sampler_event_sink_new (GumEventSink * inner,
+                            guint interval)
+{
+  GumSamplerEventSink * sink;
+
+  g_assert (interval != 0);
+
+  sink = g_object_new (GUM_TYPE_SAMPLER_EVENT_SINK, NULL);
+  sink->inner = g_object_ref (inner);
+  sink->interval = interval;
+
+  return GUM_EVENT_SINK (sink);
+}
+
+static void
+gum_sampler_event_sink_class_init (GumSamplerEventSinkClass * klass)
+{
+  GObjectClass * object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = gum_sampler_event_sink_dispose;
+}
+
+static void
+gum_sampler_event_sink_iface_init (gpointer g_iface,
+                                   gpointer iface_data)
+{
+  GumEventSinkInterface * iface = g_iface;
+
+  iface->query_mask = gum_sampler_event_sink_query_mask;
+  iface->start = gum_sampler_event_sink_start;
+  iface->process = gum_sampler_event_sink_process;
+  iface->process_batch = gum_sampler_event_sink_process_batch;
+  iface->flush = gum_sampler_event_sink_flush;
+  iface->stop = gum_sampler_event_sink_stop;
+}
+
+static void
+gum_sampler_event_sink_init (GumSamplerEventSink * self)
+{
+}
+
+static void
+gum_sampler_event_sink_dispose (GObject * object)
+{
+  GumSamplerEventSink * self = GUM_SAMPLER_EVENT_SINK (object);
+
+  g_clear_object (&self->inner);
+
+  G_OBJECT_CLASS (gum_sampler_event_sink_parent_class)->dispose (object);
+}
+
+static GumEventType
+gum_sampler_event_sink_query_mask (GumEventSink * sink)
+{
+  return gum_event_sink_query_mask (GUM_SAMPLER_EVENT_SINK (sink)->inner);
+}
+
+static void
+gum_sampler_event_sink_start (GumEventSink * sink)
+{
+  gum_event_sink_start (GUM_SAMPLER_EVENT_SINK (sink)->inner);
+}
+
+static void
+gum_sampler_event_sink_process (GumEventSink * sink,
+                                const GumEvent * event,
+                                GumCpuContext * cpu_context)
+{
+  GumSamplerEventSink * self = GUM_SAMPLER_EVENT_SINK (sink);
+
+  if ((guint) (g_atomic_int_add (&self->counter, 1)) % self->interval != 0)
+    return;
+
+  gum_event_sink_process (self->inner, event, cpu_context);
+}
+
+static void
+gum_sampler_event_sink_process_batch (GumEventSink * sink,
+                                      const GumEvent * events,
+                                      guint n_events)
+{
+  GumSamplerEventSink * self = GUM_SAMPLER_EVENT_SINK (sink);
+  GumEvent chunk[GUM_FILTER_CHUNK_SIZE];
+  guint base, n, i;
+
+  if (n_events == 0)
+    return;
+
+  base = (guint) g_atomic_int_add (&self->counter, (gint) n_events);
+
+  n = 0;
+  for (i = 0; i != n_events; i++)
+  {
+    if ((base + i) % self->interval != 0)
+      continue;
+
+    chunk[n++] = events[i];
+
+    if (n == GUM_FILTER_CHUNK_SIZE)
+    {
+      gum_event_sink_process_batch (self->inner, chunk, n);
+      n = 0;
+    }
+  }
+
+  if (n != 0)
+    gum_event_sink_process_batch (self->inner, chunk, n);
+}
+
+static void
+gum_sampler_event_sink_flush (GumEventSink * sink)
+{
+  gum_event_sink_flush (GUM_SAMPLER_EVENT_SINK (sink)->inner);
+}
+
+static void
+gum_sampler_event_sink_stop (GumEventSink * sink)
+{
+  gum_event_sink_stop (GUM_SAMPLER_EVENT_SINK (sink)->inner);
+}
+
+static GumAddress
+gum_event_get_address (const GumEvent * ev)
+{
+  switch (ev->type)
+  {
+    case GUM_CALL:
+      return GUM_ADDRESS (ev->call.location);
+    case GUM_RET:
+      return GUM_ADDRESS (ev->ret.location);
+    case GUM_EXEC:
+      return GUM_ADDRESS (ev->exec.location);
+    case GUM_BLOCK:
+      return GUM_ADDRESS (ev->block.begin);
+    case GUM_COMPILE:
+      return GUM_ADDRESS (ev->compile.begin);
+    default:
+      return 0;
+  }
+}
+
@@ -10,6 +10,7 @@
 #include <glib-object.h>
 #include <gum/gumdefs.h>
 #include <gum/gumevent.h>
+#include <gum/gummemory.h>
 
 G_BEGIN_DECLS
 
@@ -20,6 +21,37 @@ G_DECLARE_INTERFACE (GumEventSink, gum_event_sink, GUM, EVENT_SINK, GObject)
 G_DECLARE_FINAL_TYPE (GumDefaultEventSink, gum_default_event_sink, GUM,
     DEFAULT_EVENT_SINK, GObject)
 
+#define GUM_TYPE_RING_EVENT_SINK (gum_ring_event_sink_get_type ())
+G_DECLARE_FINAL_TYPE (GumRingEventSink, gum_ring_event_sink, GUM,
+    RING_EVENT_SINK, GObject)
+
+#define GUM_TYPE_CALL_SUMMARY_EVENT_SINK \
+    (gum_call_summary_event_sink_get_type ())
+G_DECLARE_FINAL_TYPE (GumCallSummaryEventSink, gum_call_summary_event_sink,
+    GUM, CALL_SUMMARY_EVENT_SINK, GObject)
+
+#define GUM_TYPE_TEE_EVENT_SINK (gum_tee_event_sink_get_type ())
+G_DECLARE_FINAL_TYPE (GumTeeEventSink, gum_tee_event_sink, GUM,
+    TEE_EVENT_SINK, GObject)
+
+#define GUM_TYPE_FILTER_EVENT_SINK (gum_filter_event_sink_get_type ())
+G_DECLARE_FINAL_TYPE (GumFilterEventSink, gum_filter_event_sink, GUM,
+    FILTER_EVENT_SINK, GObject)
+
+#define GUM_TYPE_SAMPLER_EVENT_SINK (gum_sampler_event_sink_get_type ())
+G_DECLARE_FINAL_TYPE (GumSamplerEventSink, gum_sampler_event_sink, GUM,
+    SAMPLER_EVENT_SINK, GObject)
+
+typedef struct _GumCallSummaryEntry GumCallSummaryEntry;
+typedef void (* GumCallSummaryFunc) (const GumCallSummaryEntry * entries,
+    guint n_entries, gpointer user_data);
+
+struct _GumCallSummaryEntry
+{
+  GumAddress target;
+  guint count;
+};
+
 struct _GumEventSinkInterface
 {
   GTypeInterface parent;
@@ -28,6 +60,8 @@ struct _GumEventSinkInterface
   void (* start) (GumEventSink * self);
   void (* process) (GumEventSink * self, const GumEvent * event,
       GumCpuContext * cpu_context);
+  void (* process_batch) (GumEventSink * self, const GumEvent * events,
+      guint n_events);
   void (* flush) (GumEventSink * self);
   void (* stop) (GumEventSink * self);
 };
@@ -36,11 +70,35 @@ GUM_API GumEventType gum_event_sink_query_mask (GumEventSink * self);
 GUM_API void gum_event_sink_start (GumEventSink * self);
 GUM_API void gum_event_sink_process (GumEventSink * self,
     const GumEvent * event, GumCpuContext * cpu_context);
+GUM_API void gum_event_sink_process_batch (GumEventSink * self,
+    const GumEvent * events, guint n_events);
 GUM_API void gum_event_sink_flush (GumEventSink * self);
 GUM_API void gum_event_sink_stop (GumEventSink * self);
 
 GUM_API GumEventSink * gum_event_sink_make_default (void);
 
+GUM_API GumEventSink * gum_ring_event_sink_new (GumEventType mask,
+    guint capacity, gboolean drop_when_full);
+GUM_API guint gum_ring_event_sink_drain (GumRingEventSink * self,
+    GumEvent * events, guint max_events);
+GUM_API guint gum_ring_event_sink_get_lost (GumRingEventSink * self);
+
+GUM_API GumEventSink * gum_call_summary_event_sink_new (
+    GumCallSummaryFunc func, gpointer data, GDestroyNotify data_destroy);
+
+GUM_API GumEventSink * gum_tee_event_sink_new (GumEventSink ** sinks,
+    guint n_sinks);
+GUM_API GumEventSink * gum_tee_event_sink_new_with_mask (GumEventType mask,
+    GumEventSink ** sinks, guint n_sinks);
+GUM_API void gum_tee_event_sink_add (GumTeeEventSink * self,
+    GumEventSink * sink);
+GUM_API gboolean gum_tee_event_sink_remove (GumTeeEventSink * self,
+    GumEventSink * sink);
+GUM_API GumEventSink * gum_filter_event_sink_new (GumEventSink * inner,
+    GumEventType mask, const GumMemoryRange * range);
+GUM_API GumEventSink * gum_sampler_event_sink_new (GumEventSink * inner,
+    guint interval);
+
 G_END_DECLS
 
 #endif
@@ -8,10 +8,13 @@
 #include "gumexceptor.h"
 
 #include "gumexceptorbackend.h"
+#include "gumstats.h"
+#include "gumtls.h"
 
 #include <string.h>
 
 typedef struct _GumExceptionHandlerEntry GumExceptionHandlerEntry;
+typedef struct _GumExceptionHandlerSnapshot GumExceptionHandlerSnapshot;
 
 #define GUM_EXCEPTOR_LOCK()   (g_mutex_lock (&self->mutex))
 #define GUM_EXCEPTOR_UNLOCK() (g_mutex_unlock (&self->mutex))
@@ -23,7 +26,9 @@ struct _GumExceptor
   GMutex mutex;
 
   GSList * handlers;
-  GHashTable * scopes;
+  GumExceptionHandlerSnapshot * handler_snapshot;
+  GumExceptionHandlerSnapshot * retired_snapshots;
+  volatile gint dispatch_count;
 
   GumExceptorBackend * backend;
 };
@@ -32,6 +37,22 @@ struct _GumExceptionHandlerEntry
 {
   GumExceptionHandler func;
   gpointer user_data;
+  GumMemoryRange range;
+};
+
+/*
+ * Dispatch happens inside the signal/exception path, where fault-heavy
+ * workloads arrive at thousands of events per second and must not
+ * serialize on a mutex. Handlers are therefore also kept in an immutable
+ * snapshot array swapped atomically on add/remove, so dispatch walks it
+ * wait-free; superseded snapshots are parked on a retired list that
+ * writers reclaim once no dispatch is in flight.
+ */
+struct _GumExceptionHandlerSnapshot
+{
+  guint length;
+  GumExceptionHandlerSnapshot * next_retired;
+  GumExceptionHandlerEntry entries[1];
 };
 
 static void gum_exceptor_dispose (GObject * object);
@@ -39,6 +60,8 @@ static void gum_exceptor_finalize (GObject * object);
 static void the_exceptor_weak_notify (gpointer data,
     GObject * where_the_object_was);
 
+static void gum_exceptor_publish_handler_snapshot (GumExceptor * self);
+
 static gboolean gum_exceptor_handle_exception (GumExceptionDetails * details,
     GumExceptor * self);
 static gboolean gum_exceptor_handle_scope_exception (
@@ -51,6 +74,8 @@ G_DEFINE_TYPE (GumExceptor, gum_exceptor, G_TYPE_OBJECT)
 G_LOCK_DEFINE_STATIC (the_exceptor);
 static GumExceptor * the_exceptor = NULL;
 
+static GumTlsKey gum_exceptor_scope_key;
+
 static void
 gum_exceptor_class_init (GumExceptorClass * klass)
 {
@@ -58,6 +83,8 @@ gum_exceptor_class_init (GumExceptorClass * klass)
 
   object_class->dispose = gum_exceptor_dispose;
   object_class->finalize = gum_exceptor_finalize;
+
+  gum_exceptor_scope_key = gum_tls_key_new ();
 }
 
 static void
@@ -65,8 +92,6 @@ gum_exceptor_init (GumExceptor * self)
 {
   g_mutex_init (&self->mutex);
 
-  self->scopes = g_hash_table_new (NULL, NULL);
-
   gum_exceptor_add (self, gum_exceptor_handle_scope_exception, self);
 
   self->backend = gum_exceptor_backend_new (
@@ -90,7 +115,16 @@ gum_exceptor_finalize (GObject * object)
 
   gum_exceptor_remove (self, gum_exceptor_handle_scope_exception, self);
 
-  g_hash_table_unref (self->scopes);
+  g_free (self->handler_snapshot);
+  self->handler_snapshot = NULL;
+
+  while (self->retired_snapshots != NULL)
+  {
+    GumExceptionHandlerSnapshot * retired = self->retired_snapshots;
+
+    self->retired_snapshots = retired->next_retired;
+    g_free (retired);
+  }
 
   g_mutex_clear (&self->mutex);
 
@@ -137,15 +171,40 @@ void
 gum_exceptor_add (GumExceptor * self,
                   GumExceptionHandler func,
                   gpointer user_data)
+{
+  gum_exceptor_add_with_range (self, NULL, func, user_data);
+}
+
+/*
+ * Only invokes the handler for memory-access exceptions whose faulting
+ * address falls within the given range, evaluated before the callback so
+ * irrelevant handlers aren't called at all. Passing NULL matches any
+ * exception.
+ */
+void
+gum_exceptor_add_with_range (GumExceptor * self,
+                             const GumMemoryRange * range,
+                             GumExceptionHandler func,
+                             gpointer user_data)
 {
   GumExceptionHandlerEntry * entry;
 
   entry = g_slice_new (GumExceptionHandlerEntry);
   entry->func = func;
   entry->user_data = user_data;
+  if (range != NULL)
+  {
+    entry->range = *range;
+  }
+  else
+  {
+    entry->range.base_address = 0;
+    entry->range.size = 0;
+  }
 
   GUM_EXCEPTOR_LOCK ();
   self->handlers = g_slist_append (self->handlers, entry);
+  gum_exceptor_publish_handler_snapshot (self);
   GUM_EXCEPTOR_UNLOCK ();
 }
 
@@ -172,95 +231,140 @@ gum_exceptor_remove (GumExceptor * self,
   g_assert (matching_entry != NULL);
 
   self->handlers = g_slist_remove (self->handlers, matching_entry);
+  gum_exceptor_publish_handler_snapshot (self);
 
   GUM_EXCEPTOR_UNLOCK ();
 
   g_slice_free (GumExceptionHandlerEntry, matching_entry);
 }
 
+/*
+ * Must be called with the exceptor lock held. Retired snapshots are only
+ * reclaimed when no dispatch is in flight; we never wait for that, as
+ * dispatch may run for a long time inside a handler.
+ */
+static void
+gum_exceptor_publish_handler_snapshot (GumExceptor * self)
+{
+  GumExceptionHandlerSnapshot * snapshot, * old;
+  guint length, i;
+  GSList * cur;
+
+  length = g_slist_length (self->handlers);
+
+  snapshot = g_malloc (sizeof (GumExceptionHandlerSnapshot) +
+      ((length > 1 ? length - 1 : 0) * sizeof (GumExceptionHandlerEntry)));
+  snapshot->length = length;
+  snapshot->next_retired = NULL;
+
+  for (i = 0, cur = self->handlers; cur != NULL; cur = cur->next, i++)
+    snapshot->entries[i] = *(GumExceptionHandlerEntry *) cur->data;
+
+  old = g_atomic_pointer_get (&self->handler_snapshot);
+  g_atomic_pointer_set (&self->handler_snapshot, snapshot);
+
+  if (old != NULL)
+  {
+    old->next_retired = self->retired_snapshots;
+    self->retired_snapshots = old;
+  }
+
+  if (g_atomic_int_get (&self->dispatch_count) == 0)
+  {
+    while (self->retired_snapshots != NULL)
+    {
+      GumExceptionHandlerSnapshot * retired = self->retired_snapshots;
+
+      self->retired_snapshots = retired->next_retired;
+      g_free (retired);
+    }
+  }
+}
+
 static gboolean
 gum_exceptor_handle_exception (GumExceptionDetails * details,
                                GumExceptor * self)
 {
   gboolean handled = FALSE;
-  GSList * invoked = NULL;
-  GumExceptionHandlerEntry e;
+  GumExceptionHandlerSnapshot * snapshot;
+  guint i;
 
-  do
-  {
-    GSList * cur;
+  g_atomic_int_inc (&self->dispatch_count);
+
+  snapshot = g_atomic_pointer_get (&self->handler_snapshot);
 
-    e.func = NULL;
-    e.user_data = NULL;
+  for (i = 0; snapshot != NULL && !handled && i != snapshot->length; i++)
+  {
+    GumExceptionHandlerEntry * entry = &snapshot->entries[i];
 
-    GUM_EXCEPTOR_LOCK ();
-    for (cur = self->handlers; e.func == NULL && cur != NULL; cur = cur->next)
+    if (entry->range.size != 0)
     {
-      GumExceptionHandlerEntry * entry = (GumExceptionHandlerEntry *) cur->data;
+      GumAddress address;
 
-      if (g_slist_find (invoked, entry) == NULL)
+      if (details->memory.operation == GUM_MEMOP_INVALID)
+        continue;
+
+      address = GUM_ADDRESS (details->memory.address);
+      if (address < entry->range.base_address ||
+          address >= entry->range.base_address + entry->range.size)
       {
-        invoked = g_slist_prepend (invoked, entry);
-        e = *entry;
+        continue;
       }
     }
-    GUM_EXCEPTOR_UNLOCK ();
 
-    if (e.func != NULL)
-      handled = e.func (details, e.user_data);
+    handled = entry->func (details, entry->user_data);
   }
-  while (!handled && e.func != NULL);
 
-  g_slist_free (invoked);
+  if (handled)
+    gum_stats_add (GUM_STAT_EXCEPTOR_EXCEPTIONS_HANDLED, 1);
+
+  g_atomic_int_add (&self->dispatch_count, -1);
 
   return handled;
 }
 
+/*
+ * Scope push/pop is purely thread-local: the stack lives in a TLS slot with
+ * the scopes themselves chained on the caller's stack, so guarding a memory
+ * access costs two TLS operations and no shared state. This matters because
+ * a scope is set up around every guarded access, however small.
+ */
 void
 _gum_exceptor_prepare_try (GumExceptor * self,
                            GumExceptorScope * scope)
 {
-  gpointer thread_id_key;
-
-  thread_id_key = GSIZE_TO_POINTER (gum_process_get_current_thread_id ());
-
   scope->exception_occurred = FALSE;
 #ifdef HAVE_ANDROID
   /* Workaround for Bionic bug up to and including Android L */
   sigprocmask (SIG_SETMASK, NULL, &scope->mask);
 #endif
 
-  GUM_EXCEPTOR_LOCK ();
-  scope->next = g_hash_table_lookup (self->scopes, thread_id_key);
-  g_hash_table_insert (self->scopes, thread_id_key, scope);
-  GUM_EXCEPTOR_UNLOCK ();
+  scope->next = gum_tls_key_get_value (gum_exceptor_scope_key);
+  gum_tls_key_set_value (gum_exceptor_scope_key, scope);
 }
 
 gboolean
 gum_exceptor_catch (GumExceptor * self,
                     GumExceptorScope * scope)
 {
-  gpointer thread_id_key;
-
-  thread_id_key = GSIZE_TO_POINTER (gum_process_get_current_thread_id ());
-
-  GUM_EXCEPTOR_LOCK ();
-  g_hash_table_insert (self->scopes, thread_id_key, scope->next);
-  GUM_EXCEPTOR_UNLOCK ();
+  gum_tls_key_set_value (gum_exceptor_scope_key, scope->next);
 
   return scope->exception_occurred;
 }
 
+/*
+ * Since scope state is thread-local it can only be observed from the thread
+ * it belongs to, which is fine for the intended use: exception handlers
+ * asking whether the faulting thread -- i.e. the current one -- is inside a
+ * guarded region.
+ */
 gboolean
 gum_exceptor_has_scope (GumExceptor * self, GumThreadId thread_id)
 {
-  GumExceptorScope * scope;
-
-  GUM_EXCEPTOR_LOCK ();
-  scope = g_hash_table_lookup (self->scopes, GSIZE_TO_POINTER (thread_id));
-  GUM_EXCEPTOR_UNLOCK ();
+  if (thread_id != gum_process_get_current_thread_id ())
+    return FALSE;
 
-  return scope != NULL;
+  return gum_tls_key_get_value (gum_exceptor_scope_key) != NULL;
 }
 
 gchar *
@@ -316,14 +420,13 @@ static gboolean
 gum_exceptor_handle_scope_exception (GumExceptionDetails * details,
                                      gpointer user_data)
 {
-  GumExceptor * self = GUM_EXCEPTOR (user_data);
   GumExceptorScope * scope;
   GumCpuContext * context = &details->context;
 
-  GUM_EXCEPTOR_LOCK ();
-  scope = g_hash_table_lookup (self->scopes,
-      GSIZE_TO_POINTER (details->thread_id));
-  GUM_EXCEPTOR_UNLOCK ();
+  if (details->thread_id != gum_process_get_current_thread_id ())
+    return FALSE;
+
+  scope = gum_tls_key_get_value (gum_exceptor_scope_key);
   if (scope == NULL)
     return FALSE;
 
@@ -86,6 +86,9 @@ GUM_API GumExceptor * gum_exceptor_obtain (void);
 
 GUM_API void gum_exceptor_add (GumExceptor * self, GumExceptionHandler func,
     gpointer user_data);
+GUM_API void gum_exceptor_add_with_range (GumExceptor * self,
+    const GumMemoryRange * range, GumExceptionHandler func,
+    gpointer user_data);
 GUM_API void gum_exceptor_remove (GumExceptor * self, GumExceptionHandler func,
     gpointer user_data);
 
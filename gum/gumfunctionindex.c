@@ -0,0 +1,363 @@
+/*
+ * Copyright (C) 2021 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#include "gumfunctionindex.h"
+
+#include "gummemory.h"
+#include "gumprocess.h"
+
+#include <string.h>
+
+typedef struct _GumFunctionIndexBuilder GumFunctionIndexBuilder;
+
+/*
+ * Builds a sorted index of likely function entry points for a module's
+ * executable ranges without relying on symbols, combining two sources:
+ *
+ * 1) Prologue heuristics: per-architecture byte patterns scanned with the
+ *    regular pattern-matching machinery, so the SIMD-accelerated search is
+ *    used where available.
+ * 2) Call-target harvesting: direct call instructions are decoded and any
+ *    target landing inside the module's text is recorded, which also finds
+ *    functions with nonstandard prologues.
+ *
+ * The result is heuristic: data mistaken for code may yield false entries,
+ * and leaf functions that are only called indirectly and lack a standard
+ * prologue are missed. Intended for stripped binaries where
+ * gum_find_functions_matching() has nothing to work with.
+ */
+struct _GumFunctionIndex
+{
+  GObject parent;
+
+  GArray * starts;
+
+  GumMemoryRange * ranges;
+  guint n_ranges;
+};
+
+struct _GumFunctionIndexBuilder
+{
+  GHashTable * starts;
+  const GumMemoryRange * ranges;
+  guint n_ranges;
+};
+
+static void gum_function_index_finalize (GObject * object);
+
+static gboolean gum_function_index_collect_range (
+    const GumRangeDetails * details, gpointer user_data);
+static gboolean gum_function_index_on_prologue_match (guint pattern_index,
+    GumAddress address, gsize size, gpointer user_data);
+static void gum_function_index_harvest_call_targets (
+    GumFunctionIndexBuilder * builder, const GumMemoryRange * range);
+static gboolean gum_function_index_builder_contains (
+    GumFunctionIndexBuilder * builder, GumAddress address);
+static void gum_function_index_builder_add (GumFunctionIndexBuilder * builder,
+    GumAddress address);
+static gint gum_address_compare (gconstpointer a, gconstpointer b);
+
+G_DEFINE_TYPE (GumFunctionIndex, gum_function_index, G_TYPE_OBJECT)
+
+static void
+gum_function_index_class_init (GumFunctionIndexClass * klass)
+{
+  GObjectClass * object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gum_function_index_finalize;
+}
+
+static void
+gum_function_index_init (GumFunctionIndex * self)
+{
+  self->starts = g_array_new (FALSE, FALSE, sizeof (GumAddress));
+}
+
+static void
+gum_function_index_finalize (GObject * object)
+{
+  GumFunctionIndex * self = GUM_FUNCTION_INDEX (object);
+
+  g_free (self->ranges);
+  g_array_unref (self->starts);
+
+  G_OBJECT_CLASS (gum_function_index_parent_class)->finalize (object);
+}
+
+GumFunctionIndex *
+gum_function_index_new_for_module (const gchar * module_name)
+{
+  GumFunctionIndex * index;
+  GumFunctionIndexBuilder builder;
+  GArray * ranges;
+  GumMatchPatternSet * prologues;
+  GHashTableIter iter;
+  gpointer address;
+  guint i;
+
+  ranges = g_array_new (FALSE, FALSE, sizeof (GumMemoryRange));
+  gum_module_enumerate_ranges (module_name, GUM_PAGE_EXECUTE,
+      gum_function_index_collect_range, ranges);
+  if (ranges->len == 0)
+  {
+    g_array_unref (ranges);
+    return NULL;
+  }
+
+  index = g_object_new (GUM_TYPE_FUNCTION_INDEX, NULL);
+  index->n_ranges = ranges->len;
+  index->ranges = (GumMemoryRange *) g_array_free (ranges, FALSE);
+
+  builder.starts = g_hash_table_new (NULL, NULL);
+  builder.ranges = index->ranges;
+  builder.n_ranges = index->n_ranges;
+
+  prologues = NULL;
+#if defined (HAVE_I386) || defined (HAVE_ARM) || defined (HAVE_ARM64)
+  prologues = gum_match_pattern_set_new ();
+#endif
+#if defined (HAVE_I386)
+# if GLIB_SIZEOF_VOID_P == 8
+  gum_match_pattern_set_add (prologues,
+      gum_match_pattern_new_from_string ("55 48 89 e5"));
+  gum_match_pattern_set_add (prologues,
+      gum_match_pattern_new_from_string ("55 48 8b ec"));
+# else
+  gum_match_pattern_set_add (prologues,
+      gum_match_pattern_new_from_string ("55 89 e5"));
+  gum_match_pattern_set_add (prologues,
+      gum_match_pattern_new_from_string ("55 8b ec"));
+# endif
+#elif defined (HAVE_ARM64)
+  gum_match_pattern_set_add (prologues,
+      gum_match_pattern_new_from_string ("fd 7b ?? a9"));
+  gum_match_pattern_set_add (prologues,
+      gum_match_pattern_new_from_string ("7f 23 03 d5"));
+#elif defined (HAVE_ARM)
+  gum_match_pattern_set_add (prologues,
+      gum_match_pattern_new_from_string ("?? 4? 2d e9"));
+#endif
+
+  for (i = 0; i != index->n_ranges; i++)
+  {
+    const GumMemoryRange * range = &index->ranges[i];
+
+    gum_ensure_code_readable (GSIZE_TO_POINTER (range->base_address),
+        range->size);
+
+    if (prologues != NULL)
+    {
+      gum_memory_scan_set (range, prologues,
+          gum_function_index_on_prologue_match, &builder);
+    }
+
+    gum_function_index_harvest_call_targets (&builder, range);
+  }
+
+  if (prologues != NULL)
+    gum_match_pattern_set_free (prologues);
+
+  g_hash_table_iter_init (&iter, builder.starts);
+  while (g_hash_table_iter_next (&iter, &address, NULL))
+  {
+    GumAddress start = GUM_ADDRESS (GPOINTER_TO_SIZE (address));
+    g_array_append_val (index->starts, start);
+  }
+  g_hash_table_unref (builder.starts);
+
+  g_array_sort (index->starts, gum_address_compare);
+
+  return index;
+}
+
+guint
+gum_function_index_get_count (GumFunctionIndex * self)
+{
+  return self->starts->len;
+}
+
+GumAddress
+gum_function_index_get_nth (GumFunctionIndex * self,
+                            guint index)
+{
+  g_return_val_if_fail (index < self->starts->len, 0);
+
+  return g_array_index (self->starts, GumAddress, index);
+}
+
+/*
+ * Finds the greatest detected function start at or below `address`, i.e.
+ * the function presumed to contain it. Binary search, so suitable for
+ * resolving large numbers of code addresses.
+ */
+gboolean
+gum_function_index_find_containing (GumFunctionIndex * self,
+                                    GumAddress address,
+                                    GumAddress * start)
+{
+  gint lower, upper;
+
+  if (self->starts->len == 0 ||
+      g_array_index (self->starts, GumAddress, 0) > address)
+  {
+    return FALSE;
+  }
+
+  lower = 0;
+  upper = self->starts->len - 1;
+  while (lower < upper)
+  {
+    gint middle = lower + ((upper - lower + 1) / 2);
+
+    if (g_array_index (self->starts, GumAddress, middle) <= address)
+      lower = middle;
+    else
+      upper = middle - 1;
+  }
+
+  if (start != NULL)
+    *start = g_array_index (self->starts, GumAddress, lower);
+
+  return TRUE;
+}
+
+void
+gum_function_index_enumerate (GumFunctionIndex * self,
+                              GumFoundFunctionStartFunc func,
+                              gpointer user_data)
+{
+  guint i;
+
+  for (i = 0; i != self->starts->len; i++)
+  {
+    if (!func (g_array_index (self->starts, GumAddress, i), user_data))
+      return;
+  }
+}
+
+static gboolean
+gum_function_index_collect_range (const GumRangeDetails * details,
+                                  gpointer user_data)
+{
+  GArray * ranges = user_data;
+
+  g_array_append_val (ranges, *details->range);
+
+  return TRUE;
+}
+
+static gboolean
+gum_function_index_on_prologue_match (guint pattern_index,
+                                      GumAddress address,
+                                      gsize size,
+                                      gpointer user_data)
+{
+  GumFunctionIndexBuilder * builder = user_data;
+
+#if defined (HAVE_ARM64) || defined (HAVE_ARM)
+  if (address % 4 != 0)
+    return TRUE;
+#endif
+
+  gum_function_index_builder_add (builder, address);
+
+  return TRUE;
+}
+
+static void
+gum_function_index_harvest_call_targets (GumFunctionIndexBuilder * builder,
+                                         const GumMemoryRange * range)
+{
+#if defined (HAVE_I386)
+  const guint8 * code = GSIZE_TO_POINTER (range->base_address);
+  gsize i;
+
+  if (range->size < 5)
+    return;
+
+  for (i = 0; i != range->size - 4; i++)
+  {
+    gint32 distance;
+    GumAddress target;
+
+    if (code[i] != 0xe8)
+      continue;
+
+    memcpy (&distance, code + i + 1, sizeof (distance));
+    target = range->base_address + i + 5 + distance;
+
+    if (gum_function_index_builder_contains (builder, target))
+      gum_function_index_builder_add (builder, target);
+  }
+#elif defined (HAVE_ARM64) || defined (HAVE_ARM)
+  const guint32 * code = GSIZE_TO_POINTER (range->base_address);
+  gsize n_insns = range->size / 4;
+  gsize i;
+
+  for (i = 0; i != n_insns; i++)
+  {
+    guint32 insn = code[i];
+    gint32 distance;
+    GumAddress target;
+
+# if defined (HAVE_ARM64)
+    if ((insn & 0xfc000000) != 0x94000000)
+      continue;
+
+    distance = (gint32) (insn << 6) >> 6;
+    target = range->base_address + (i * 4) + ((gint64) distance * 4);
+# else
+    if ((insn & 0xff000000) != 0xeb000000)
+      continue;
+
+    distance = (gint32) (insn << 8) >> 8;
+    target = range->base_address + (i * 4) + 8 + ((gint64) distance * 4);
+# endif
+
+    if (gum_function_index_builder_contains (builder, target))
+      gum_function_index_builder_add (builder, target);
+  }
+#else
+  (void) builder;
+  (void) range;
+#endif
+}
+
+static gboolean
+gum_function_index_builder_contains (GumFunctionIndexBuilder * builder,
+                                     GumAddress address)
+{
+  guint i;
+
+  for (i = 0; i != builder->n_ranges; i++)
+  {
+    if (GUM_MEMORY_RANGE_INCLUDES (&builder->ranges[i], address))
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+static void
+gum_function_index_builder_add (GumFunctionIndexBuilder * builder,
+                                GumAddress address)
+{
+  g_hash_table_add (builder->starts, GSIZE_TO_POINTER ((gsize) address));
+}
+
+static gint
+gum_address_compare (gconstpointer a,
+                     gconstpointer b)
+{
+  GumAddress address_a = *(const GumAddress *) a;
+  GumAddress address_b = *(const GumAddress *) b;
+
+  if (address_a < address_b)
+    return -1;
+  if (address_a > address_b)
+    return 1;
+  return 0;
+}
@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2021 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#ifndef __GUM_FUNCTION_INDEX_H__
+#define __GUM_FUNCTION_INDEX_H__
+
+#include <glib-object.h>
+#include <gum/gumdefs.h>
+
+G_BEGIN_DECLS
+
+#define GUM_TYPE_FUNCTION_INDEX (gum_function_index_get_type ())
+G_DECLARE_FINAL_TYPE (GumFunctionIndex, gum_function_index, GUM,
+    FUNCTION_INDEX, GObject)
+
+typedef gboolean (* GumFoundFunctionStartFunc) (GumAddress address,
+    gpointer user_data);
+
+GUM_API GumFunctionIndex * gum_function_index_new_for_module (
+    const gchar * module_name);
+
+GUM_API guint gum_function_index_get_count (GumFunctionIndex * self);
+GUM_API GumAddress gum_function_index_get_nth (GumFunctionIndex * self,
+    guint index);
+GUM_API gboolean gum_function_index_find_containing (GumFunctionIndex * self,
+    GumAddress address, GumAddress * start);
+GUM_API void gum_function_index_enumerate (GumFunctionIndex * self,
+    GumFoundFunctionStartFunc func, gpointer user_data);
+
+G_END_DECLS
+
+#endif
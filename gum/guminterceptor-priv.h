@@ -48,6 +48,9 @@ struct _GumFunctionContext
   gpointer replacement_function;
   gpointer replacement_data;
 
+  GumProbeFunc probe_func;
+  gpointer probe_data;
+
   GumFunctionContextBackendData backend_data;
 
   GumInterceptor * interceptor;
@@ -9,10 +9,12 @@
 
 #include "guminterceptor-priv.h"
 
+#include "gumadaptivelock.h"
 #include "gumcodesegment.h"
 #include "gumlibc.h"
 #include "gummemory.h"
 #include "gumprocess.h"
+#include "gumstats.h"
 #include "gumtls.h"
 
 #include <string.h>
@@ -26,6 +28,13 @@
 #define GUM_INTERCEPTOR_LOCK(o) g_rec_mutex_lock (&(o)->mutex)
 #define GUM_INTERCEPTOR_UNLOCK(o) g_rec_mutex_unlock (&(o)->mutex)
 
+#define GUM_FUNCTION_CONTEXT_MAP_INITIAL_SIZE 64
+#define GUM_FUNCTION_CONTEXT_MAP_TOMBSTONE (GSIZE_TO_POINTER (1))
+
+#define GUM_HOOK_BUDGET_MIN_CALLS 16
+
+typedef struct _GumFunctionContextMap GumFunctionContextMap;
+typedef struct _GumFunctionContextMapEntry GumFunctionContextMapEntry;
 typedef struct _GumInterceptorTransaction GumInterceptorTransaction;
 typedef struct _GumDestroyTask GumDestroyTask;
 typedef struct _GumPrologueWrite GumPrologueWrite;
@@ -37,6 +46,8 @@ typedef struct _ListenerInvocationState ListenerInvocationState;
 
 typedef void (* GumPrologueWriteFunc) (GumInterceptor * self,
     GumFunctionContext * ctx, gpointer prologue);
+typedef void (* GumPageRunFunc) (gpointer start, gsize size,
+    gpointer user_data);
 
 struct _GumInterceptorTransaction
 {
@@ -48,6 +59,27 @@ struct _GumInterceptorTransaction
   GumInterceptor * interceptor;
 };
 
+struct _GumFunctionContextMapEntry
+{
+  gpointer address;
+  GumFunctionContext * ctx;
+};
+
+/*
+ * Open-addressing mirror of function_by_address, so that the hottest
+ * lookups probe a flat power-of-two array with inline keys instead of
+ * chasing GHashTable nodes. Entries are published atomically and stale
+ * tables are retired through the transaction machinery, allowing lookups
+ * without taking the interceptor lock.
+ */
+struct _GumFunctionContextMap
+{
+  gsize size;
+  gsize n_entries;
+  gsize n_removed;
+  GumFunctionContextMapEntry * entries;
+};
+
 struct _GumInterceptor
 {
   GObject parent;
@@ -55,12 +87,17 @@ struct _GumInterceptor
   GRecMutex mutex;
 
   GHashTable * function_by_address;
+  volatile GumFunctionContextMap * function_map;
 
   GumInterceptorBackend * backend;
   GumCodeAllocator allocator;
 
   volatile guint selected_thread_id;
 
+  volatile guint hook_budget;
+  GumInterceptorHookBudgetFunc hook_budget_func;
+  gpointer hook_budget_data;
+
   GumInterceptorTransaction current_transaction;
 };
 
@@ -82,6 +119,10 @@ struct _ListenerEntry
   GumInvocationListenerInterface * listener_interface;
   GumInvocationListener * listener_instance;
   gpointer function_data;
+
+  guint64 total_cost;
+  guint64 n_calls;
+  gboolean budget_reported;
 };
 
 struct _InterceptorThreadContext
@@ -94,6 +135,8 @@ struct _InterceptorThreadContext
   GumInvocationStack * stack;
 
   GArray * listener_data_slots;
+
+  InterceptorThreadContext * next_in_pool;
 };
 
 struct _GumInvocationStackEntry
@@ -128,6 +171,9 @@ static void gum_interceptor_finalize (GObject * object);
 static void the_interceptor_weak_notify (gpointer data,
     GObject * where_the_object_was);
 
+static gboolean gum_interceptor_collect_api_match (
+    const GumApiDetails * details, gpointer user_data);
+
 static GumFunctionContext * gum_interceptor_instrument (GumInterceptor * self,
     gpointer function_address);
 static void gum_interceptor_activate (GumInterceptor * self,
@@ -149,6 +195,19 @@ static void gum_interceptor_transaction_schedule_prologue_write (
     GumInterceptorTransaction * self, GumFunctionContext * ctx,
     GumPrologueWriteFunc func);
 
+static GumFunctionContextMap * gum_function_context_map_new (gsize size);
+static gsize gum_function_context_map_hash (gpointer address);
+static void gum_function_context_map_add (GumFunctionContextMap * map,
+    gpointer address, GumFunctionContext * ctx);
+static GumFunctionContext * gum_interceptor_map_lookup (GumInterceptor * self,
+    gpointer function_address);
+static void gum_interceptor_map_insert (GumInterceptor * self,
+    GumFunctionContext * ctx);
+static void gum_interceptor_map_remove (GumInterceptor * self,
+    GumFunctionContext * ctx);
+static void gum_interceptor_map_publish (GumInterceptor * self,
+    GumFunctionContextMap * new_map, GumFunctionContext * ctx);
+
 static GumFunctionContext * gum_function_context_new (
     GumInterceptor * interceptor, gpointer function_address);
 static void gum_function_context_finalize (GumFunctionContext * function_ctx);
@@ -162,7 +221,11 @@ static void gum_function_context_add_listener (
     gpointer function_data);
 static void gum_function_context_remove_listener (
     GumFunctionContext * function_ctx, GumInvocationListener * listener);
+static void gum_function_context_remove_all_listeners (
+    GumFunctionContext * function_ctx);
 static void listener_entry_free (ListenerEntry * entry);
+static void gum_function_context_account_listener_cost (
+    GumFunctionContext * function_ctx, ListenerEntry * entry, gint64 cost);
 static gboolean gum_function_context_has_listener (
     GumFunctionContext * function_ctx, GumInvocationListener * listener);
 static ListenerEntry ** gum_function_context_find_listener (
@@ -175,6 +238,7 @@ static void gum_function_context_fixup_cpu_context (
 static InterceptorThreadContext * get_interceptor_thread_context (void);
 static void release_interceptor_thread_context (
     InterceptorThreadContext * context);
+static InterceptorThreadContext * interceptor_thread_context_obtain (void);
 static InterceptorThreadContext * interceptor_thread_context_new (void);
 static void interceptor_thread_context_destroy (
     InterceptorThreadContext * context);
@@ -183,6 +247,8 @@ static gpointer interceptor_thread_context_get_listener_data (
     gsize required_size);
 static void interceptor_thread_context_forget_listener_data (
     InterceptorThreadContext * self, GumInvocationListener * listener);
+static void interceptor_thread_context_forget_all_listener_data (
+    InterceptorThreadContext * self);
 static GumInvocationStackEntry * gum_invocation_stack_push (
     GumInvocationStack * stack, GumFunctionContext * function_ctx,
     gpointer caller_ret_addr);
@@ -197,16 +263,25 @@ static gboolean gum_interceptor_has (GumInterceptor * self,
 
 static gpointer gum_page_address_from_pointer (gpointer ptr);
 static gint gum_page_address_compare (gconstpointer a, gconstpointer b);
+static void gum_page_list_foreach_run (GList * sorted_page_addresses,
+    guint page_size, GumPageRunFunc func, gpointer user_data);
+static void gum_page_run_mprotect (gpointer start, gsize size,
+    gpointer user_data);
+static void gum_page_run_clear_cache (gpointer start, gsize size,
+    gpointer user_data);
 
 G_DEFINE_TYPE (GumInterceptor, gum_interceptor, G_TYPE_OBJECT)
 
 static GMutex _gum_interceptor_lock;
 static GumInterceptor * _the_interceptor = NULL;
 
-static GumSpinlock gum_interceptor_thread_context_lock = GUM_SPINLOCK_INIT;
+static GumAdaptiveLock gum_interceptor_thread_context_lock =
+    GUM_ADAPTIVE_LOCK_INIT;
 static GHashTable * gum_interceptor_thread_contexts;
 static GPrivate gum_interceptor_context_private =
     G_PRIVATE_INIT ((GDestroyNotify) release_interceptor_thread_context);
+static InterceptorThreadContext * gum_interceptor_context_pool = NULL;
+static GumTlsKey gum_interceptor_context_key;
 static GumTlsKey gum_interceptor_guard_key;
 
 static GumInvocationStack _gum_interceptor_empty_stack = { NULL, 0 };
@@ -226,6 +301,7 @@ _gum_interceptor_init (void)
   gum_interceptor_thread_contexts = g_hash_table_new_full (NULL, NULL,
       (GDestroyNotify) interceptor_thread_context_destroy, NULL);
 
+  gum_interceptor_context_key = gum_tls_key_new ();
   gum_interceptor_guard_key = gum_tls_key_new ();
 }
 
@@ -233,6 +309,9 @@ void
 _gum_interceptor_deinit (void)
 {
   gum_tls_key_free (gum_interceptor_guard_key);
+  gum_tls_key_free (gum_interceptor_context_key);
+
+  gum_interceptor_context_pool = NULL;
 
   g_hash_table_unref (gum_interceptor_thread_contexts);
   gum_interceptor_thread_contexts = NULL;
@@ -245,6 +324,8 @@ gum_interceptor_init (GumInterceptor * self)
 
   self->function_by_address = g_hash_table_new_full (NULL, NULL, NULL,
       (GDestroyNotify) gum_function_context_destroy);
+  self->function_map =
+      gum_function_context_map_new (GUM_FUNCTION_CONTEXT_MAP_INITIAL_SIZE);
 
   gum_code_allocator_init (&self->allocator, GUM_INTERCEPTOR_CODE_SLICE_SIZE);
   self->backend = _gum_interceptor_backend_create (&self->allocator);
@@ -281,6 +362,7 @@ gum_interceptor_finalize (GObject * object)
   g_rec_mutex_clear (&self->mutex);
 
   g_hash_table_unref (self->function_by_address);
+  g_free ((gpointer) self->function_map);
 
   gum_code_allocator_free (&self->allocator);
 
@@ -347,6 +429,9 @@ gum_interceptor_attach (GumInterceptor * self,
   if (function_ctx == NULL)
     goto wrong_signature;
 
+  if (function_ctx->probe_func != NULL)
+    goto already_attached;
+
   if (gum_function_context_has_listener (function_ctx, listener))
     goto already_attached;
 
@@ -379,6 +464,74 @@ beach:
   }
 }
 
+/*
+ * Resolves `query` through `resolver` and attaches `listener` to every match
+ * inside a single transaction, so the code rewrites for the whole batch are
+ * applied and flushed together instead of once per function. Matches that
+ * cannot be instrumented or already carry this listener are skipped.
+ *
+ * Returns an array of the function addresses that were attached, to be freed
+ * with g_array_free(), or NULL with `error` set if the query is invalid.
+ * Detaching remains per-listener via gum_interceptor_detach(). Callers with
+ * multiple patterns can wrap several calls in their own explicit
+ * begin/end transaction pair to coalesce everything into one flush.
+ */
+GArray *
+gum_interceptor_attach_matching (GumInterceptor * self,
+                                 GumApiResolver * resolver,
+                                 const gchar * query,
+                                 GumInvocationListener * listener,
+                                 gpointer listener_function_data,
+                                 GError ** error)
+{
+  GArray * addresses, * attached;
+  GError * e = NULL;
+  guint i;
+
+  addresses = g_array_new (FALSE, FALSE, sizeof (gpointer));
+  gum_api_resolver_enumerate_matches (resolver, query,
+      gum_interceptor_collect_api_match, addresses, &e);
+  if (e != NULL)
+  {
+    g_array_free (addresses, TRUE);
+    g_propagate_error (error, e);
+    return NULL;
+  }
+
+  attached = g_array_new (FALSE, FALSE, sizeof (gpointer));
+
+  gum_interceptor_begin_transaction (self);
+
+  for (i = 0; i != addresses->len; i++)
+  {
+    gpointer function_address = g_array_index (addresses, gpointer, i);
+
+    if (gum_interceptor_attach (self, function_address, listener,
+        listener_function_data) == GUM_ATTACH_OK)
+    {
+      g_array_append_val (attached, function_address);
+    }
+  }
+
+  gum_interceptor_end_transaction (self);
+
+  g_array_free (addresses, TRUE);
+
+  return attached;
+}
+
+static gboolean
+gum_interceptor_collect_api_match (const GumApiDetails * details,
+                                   gpointer user_data)
+{
+  GArray * addresses = user_data;
+  gpointer address = GSIZE_TO_POINTER (details->address);
+
+  g_array_append_val (addresses, address);
+
+  return TRUE;
+}
+
 void
 gum_interceptor_detach (GumInterceptor * self,
                         GumInvocationListener * listener)
@@ -409,17 +562,190 @@ gum_interceptor_detach (GumInterceptor * self,
     }
   }
 
-  gum_spinlock_acquire (&gum_interceptor_thread_context_lock);
+  gum_adaptive_lock_acquire (&gum_interceptor_thread_context_lock);
   g_hash_table_iter_init (&iter, gum_interceptor_thread_contexts);
   while (g_hash_table_iter_next (&iter, (gpointer *) &thread_ctx, NULL))
     interceptor_thread_context_forget_listener_data (thread_ctx, listener);
-  gum_spinlock_release (&gum_interceptor_thread_context_lock);
+  gum_adaptive_lock_release (&gum_interceptor_thread_context_lock);
+
+  gum_interceptor_transaction_end (&self->current_transaction);
+  GUM_INTERCEPTOR_UNLOCK (self);
+  gum_interceptor_unignore_current_thread (self);
+}
+
+void
+gum_interceptor_detach_all (GumInterceptor * self)
+{
+  GHashTableIter iter;
+  GumFunctionContext * function_ctx;
+  InterceptorThreadContext * thread_ctx;
+
+  gum_interceptor_ignore_current_thread (self);
+  GUM_INTERCEPTOR_LOCK (self);
+  gum_interceptor_transaction_begin (&self->current_transaction);
+  self->current_transaction.is_dirty = TRUE;
+
+  g_hash_table_iter_init (&iter, self->function_by_address);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &function_ctx))
+  {
+    gum_function_context_remove_all_listeners (function_ctx);
+
+    if (gum_function_context_is_empty (function_ctx))
+    {
+      g_hash_table_iter_remove (&iter);
+    }
+  }
+
+  gum_adaptive_lock_acquire (&gum_interceptor_thread_context_lock);
+  g_hash_table_iter_init (&iter, gum_interceptor_thread_contexts);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &thread_ctx, NULL))
+    interceptor_thread_context_forget_all_listener_data (thread_ctx);
+  gum_adaptive_lock_release (&gum_interceptor_thread_context_lock);
 
   gum_interceptor_transaction_end (&self->current_transaction);
   GUM_INTERCEPTOR_UNLOCK (self);
   gum_interceptor_unignore_current_thread (self);
 }
 
+GumAttachReturn
+gum_interceptor_attach_probe (GumInterceptor * self,
+                              gpointer function_address,
+                              GumProbeFunc func,
+                              gpointer data)
+{
+  GumAttachReturn result = GUM_ATTACH_OK;
+  GumFunctionContext * function_ctx;
+
+#if !defined (HAVE_I386) && !defined (HAVE_ARM64)
+  return GUM_ATTACH_WRONG_SIGNATURE;
+#endif
+
+  if (gum_process_get_code_signing_policy () == GUM_CODE_SIGNING_REQUIRED)
+    goto policy_violation;
+
+  gum_interceptor_ignore_current_thread (self);
+  GUM_INTERCEPTOR_LOCK (self);
+  gum_interceptor_transaction_begin (&self->current_transaction);
+  self->current_transaction.is_dirty = TRUE;
+
+  function_address = gum_interceptor_resolve (self, function_address);
+
+  /*
+   * A probe owns its target exclusively: its trampoline bypasses the
+   * invocation machinery, so listeners and replacements cannot coexist
+   * with it on the same function.
+   */
+  if (gum_interceptor_has (self, function_address))
+    goto already_attached;
+
+  function_ctx = gum_function_context_new (self, function_address);
+
+  function_ctx->probe_func = func;
+  function_ctx->probe_data = data;
+
+  if (!_gum_interceptor_backend_create_trampoline (self->backend,
+      function_ctx))
+  {
+    gum_function_context_finalize (function_ctx);
+    goto wrong_signature;
+  }
+
+  g_hash_table_insert (self->function_by_address, function_address,
+      function_ctx);
+  gum_interceptor_map_insert (self, function_ctx);
+
+  gum_interceptor_transaction_schedule_prologue_write (
+      &self->current_transaction, function_ctx, gum_interceptor_activate);
+
+  goto beach;
+
+policy_violation:
+  {
+    return GUM_ATTACH_POLICY_VIOLATION;
+  }
+wrong_signature:
+  {
+    result = GUM_ATTACH_WRONG_SIGNATURE;
+    goto beach;
+  }
+already_attached:
+  {
+    result = GUM_ATTACH_ALREADY_ATTACHED;
+    goto beach;
+  }
+beach:
+  {
+    gum_interceptor_transaction_end (&self->current_transaction);
+    GUM_INTERCEPTOR_UNLOCK (self);
+    gum_interceptor_unignore_current_thread (self);
+
+    return result;
+  }
+}
+
+void
+gum_interceptor_detach_probe (GumInterceptor * self,
+                              gpointer function_address)
+{
+  GumFunctionContext * function_ctx;
+
+  GUM_INTERCEPTOR_LOCK (self);
+  gum_interceptor_transaction_begin (&self->current_transaction);
+  self->current_transaction.is_dirty = TRUE;
+
+  function_address = gum_interceptor_resolve (self, function_address);
+
+  function_ctx = gum_interceptor_map_lookup (self, function_address);
+  if (function_ctx == NULL || function_ctx->probe_func == NULL)
+    goto beach;
+
+  function_ctx->probe_func = NULL;
+  function_ctx->probe_data = NULL;
+
+  g_hash_table_remove (self->function_by_address, function_address);
+
+beach:
+  gum_interceptor_transaction_end (&self->current_transaction);
+  GUM_INTERCEPTOR_UNLOCK (self);
+}
+
+/*
+ * Redirects an existing probe to a new callback without touching the
+ * trampoline: its generated code loads the callback from the
+ * GumFunctionContext on every hit, so this is a pointer store instead of a
+ * detach + attach with its patch/flush cycle. Returns FALSE when the
+ * function does not currently have a probe.
+ */
+gboolean
+gum_interceptor_retarget_probe (GumInterceptor * self,
+                                gpointer function_address,
+                                GumProbeFunc func,
+                                gpointer data)
+{
+  gboolean success = FALSE;
+  GumFunctionContext * function_ctx;
+
+  g_return_val_if_fail (func != NULL, FALSE);
+
+  GUM_INTERCEPTOR_LOCK (self);
+
+  function_address = gum_interceptor_resolve (self, function_address);
+
+  function_ctx = gum_interceptor_map_lookup (self, function_address);
+  if (function_ctx == NULL || function_ctx->probe_func == NULL)
+    goto beach;
+
+  g_atomic_pointer_set (&function_ctx->probe_data, data);
+  g_atomic_pointer_set (&function_ctx->probe_func, func);
+
+  success = TRUE;
+
+beach:
+  GUM_INTERCEPTOR_UNLOCK (self);
+
+  return success;
+}
+
 GumReplaceReturn
 gum_interceptor_replace (GumInterceptor * self,
                          gpointer function_address,
@@ -442,7 +768,8 @@ gum_interceptor_replace (GumInterceptor * self,
   if (function_ctx == NULL)
     goto wrong_signature;
 
-  if (function_ctx->replacement_function != NULL)
+  if (function_ctx->replacement_function != NULL ||
+      function_ctx->probe_func != NULL)
     goto already_replaced;
 
   function_ctx->replacement_data = replacement_data;
@@ -485,8 +812,7 @@ gum_interceptor_revert (GumInterceptor * self,
 
   function_address = gum_interceptor_resolve (self, function_address);
 
-  function_ctx = (GumFunctionContext *) g_hash_table_lookup (
-      self->function_by_address, function_address);
+  function_ctx = gum_interceptor_map_lookup (self, function_address);
   if (function_ctx == NULL)
     goto beach;
 
@@ -503,6 +829,89 @@ beach:
   GUM_INTERCEPTOR_UNLOCK (self);
 }
 
+/*
+ * Swaps the replacement of an already-replaced function. The invocation
+ * path reads the replacement from the GumFunctionContext on every call, so
+ * this needs no transaction and performs zero code-page writes — retargeting
+ * thousands of hooks is just as many pointer stores. Returns FALSE when the
+ * function is not currently replaced.
+ *
+ * A call racing the swap may observe the new replacement_data with the old
+ * replacement function (or vice versa); callers that need the pair to
+ * change atomically should keep such state reachable from a single object
+ * behind replacement_data instead.
+ */
+gboolean
+gum_interceptor_retarget (GumInterceptor * self,
+                          gpointer function_address,
+                          gpointer replacement_function,
+                          gpointer replacement_data)
+{
+  gboolean success = FALSE;
+  GumFunctionContext * function_ctx;
+
+  g_return_val_if_fail (replacement_function != NULL, FALSE);
+
+  GUM_INTERCEPTOR_LOCK (self);
+
+  function_address = gum_interceptor_resolve (self, function_address);
+
+  function_ctx = gum_interceptor_map_lookup (self, function_address);
+  if (function_ctx == NULL || function_ctx->replacement_function == NULL)
+    goto beach;
+
+  g_atomic_pointer_set (&function_ctx->replacement_data, replacement_data);
+  g_atomic_pointer_set (&function_ctx->replacement_function,
+      replacement_function);
+
+  success = TRUE;
+
+beach:
+  GUM_INTERCEPTOR_UNLOCK (self);
+
+  return success;
+}
+
+/*
+ * Reports how a function ended up instrumented: how many prologue bytes
+ * were overwritten, how far away its trampoline landed, and whether the
+ * redirect had to go through a deflector — choices the arch backends make
+ * internally at attach time. Lets deployments verify their policy against
+ * what the host CPU and address space actually allowed, instead of
+ * discovering pathological cases in production profiles.
+ */
+gboolean
+gum_interceptor_query_instrumentation (GumInterceptor * self,
+                                       gpointer function_address,
+                                       GumInstrumentationReport * report)
+{
+  gboolean success = FALSE;
+  GumFunctionContext * function_ctx;
+
+  GUM_INTERCEPTOR_LOCK (self);
+
+  function_address = gum_interceptor_resolve (self, function_address);
+
+  function_ctx = gum_interceptor_map_lookup (self, function_address);
+  if (function_ctx != NULL && function_ctx->trampoline_slice != NULL)
+  {
+    report->redirect_size = function_ctx->overwritten_prologue_len;
+    report->trampoline_distance =
+        (guint8 *) function_ctx->trampoline_slice->data -
+        (guint8 *) function_ctx->function_address;
+    report->uses_deflector = function_ctx->trampoline_deflector != NULL;
+    report->has_replacement = function_ctx->replacement_function != NULL;
+    report->n_listeners =
+        ((GPtrArray *) function_ctx->listener_entries)->len;
+
+    success = TRUE;
+  }
+
+  GUM_INTERCEPTOR_UNLOCK (self);
+
+  return success;
+}
+
 void
 gum_interceptor_begin_transaction (GumInterceptor * self)
 {
@@ -559,7 +968,7 @@ gum_interceptor_get_current_stack (void)
 {
   InterceptorThreadContext * context;
 
-  context = g_private_get (&gum_interceptor_context_private);
+  context = gum_tls_key_get_value (gum_interceptor_context_key);
   if (context == NULL)
     return &_gum_interceptor_empty_stack;
 
@@ -597,6 +1006,30 @@ gum_interceptor_unignore_other_threads (GumInterceptor * self)
   self->selected_thread_id = 0;
 }
 
+/*
+ * Enables monitoring-grade accounting of what each attached listener costs
+ * the target. When enabled, on_enter and on_leave callbacks are timed and
+ * aggregated per function and listener; once a listener's average cost at a
+ * given function exceeds the budget, func is invoked exactly once for that
+ * pair. The callback runs synchronously from the hook path, so it should
+ * record the offender and defer any detach to another thread. A budget of
+ * zero disables accounting.
+ */
+void
+gum_interceptor_set_hook_budget (GumInterceptor * self,
+                                 guint budget_in_microseconds,
+                                 GumInterceptorHookBudgetFunc func,
+                                 gpointer user_data)
+{
+  GUM_INTERCEPTOR_LOCK (self);
+
+  self->hook_budget_func = func;
+  self->hook_budget_data = user_data;
+  self->hook_budget = budget_in_microseconds;
+
+  GUM_INTERCEPTOR_UNLOCK (self);
+}
+
 gpointer
 gum_invocation_stack_translate (GumInvocationStack * self,
                                 gpointer return_address)
@@ -615,6 +1048,31 @@ gum_invocation_stack_translate (GumInvocationStack * self,
   return return_address;
 }
 
+guint
+gum_invocation_stack_get_depth (GumInvocationStack * self)
+{
+  return self->len;
+}
+
+/*
+ * Frames are indexed from the innermost invocation and outwards, so n == 0
+ * is the current frame and n == 1 its parent. The enter/leave thunks keep
+ * the underlying array up to date, making this a plain lookup.
+ */
+GumInvocationContext *
+gum_invocation_stack_peek_nth (GumInvocationStack * self,
+                               guint n)
+{
+  GumInvocationStackEntry * entry;
+
+  if (n >= self->len)
+    return NULL;
+
+  entry = &g_array_index (self, GumInvocationStackEntry, self->len - 1 - n);
+
+  return &entry->invocation_context;
+}
+
 void
 gum_interceptor_save (GumInvocationState * state)
 {
@@ -687,8 +1145,7 @@ gum_interceptor_instrument (GumInterceptor * self,
 {
   GumFunctionContext * ctx;
 
-  ctx = (GumFunctionContext *) g_hash_table_lookup (self->function_by_address,
-      function_address);
+  ctx = gum_interceptor_map_lookup (self, function_address);
   if (ctx != NULL)
     return ctx;
 
@@ -703,6 +1160,7 @@ gum_interceptor_instrument (GumInterceptor * self,
   }
 
   g_hash_table_insert (self->function_by_address, function_address, ctx);
+  gum_interceptor_map_insert (self, ctx);
 
   gum_interceptor_transaction_schedule_prologue_write (
       &self->current_transaction, ctx, gum_interceptor_activate);
@@ -814,18 +1272,16 @@ gum_interceptor_transaction_end (GumInterceptorTransaction * self)
   rwx_supported = gum_query_is_rwx_supported ();
   code_segment_supported = gum_code_segment_is_supported ();
 
+  gum_clear_cache_begin_batch ();
+
   if (rwx_supported || !code_segment_supported)
   {
     GumPageProtection protection;
 
     protection = rwx_supported ? GUM_PAGE_RWX : GUM_PAGE_RW;
 
-    for (cur = addresses; cur != NULL; cur = cur->next)
-    {
-      gpointer target_page = cur->data;
-
-      gum_mprotect (target_page, page_size, protection);
-    }
+    gum_page_list_foreach_run (addresses, page_size, gum_page_run_mprotect,
+        GUINT_TO_POINTER (protection));
 
     for (cur = addresses; cur != NULL; cur = cur->next)
     {
@@ -850,20 +1306,12 @@ gum_interceptor_transaction_end (GumInterceptorTransaction * self)
 
     if (!rwx_supported)
     {
-      for (cur = addresses; cur != NULL; cur = cur->next)
-      {
-        gpointer target_page = cur->data;
-
-        gum_mprotect (target_page, page_size, GUM_PAGE_RX);
-      }
+      gum_page_list_foreach_run (addresses, page_size, gum_page_run_mprotect,
+          GUINT_TO_POINTER (GUM_PAGE_RX));
     }
 
-    for (cur = addresses; cur != NULL; cur = cur->next)
-    {
-      gpointer target_page = cur->data;
-
-      gum_clear_cache (target_page, page_size);
-    }
+    gum_page_list_foreach_run (addresses, page_size, gum_page_run_clear_cache,
+        NULL);
   }
   else
   {
@@ -914,20 +1362,31 @@ gum_interceptor_transaction_end (GumInterceptorTransaction * self)
     gum_code_segment_realize (segment);
 
     source_offset = 0;
-    for (cur = addresses; cur != NULL; cur = cur->next)
+    cur = addresses;
+    while (cur != NULL)
     {
-      gpointer target_page = cur->data;
+      guint8 * target_page = cur->data;
+      gsize run_size = page_size;
 
-      gum_code_segment_map (segment, source_offset, page_size, target_page);
+      cur = cur->next;
+      while (cur != NULL && (guint8 *) cur->data == target_page + run_size)
+      {
+        run_size += page_size;
+        cur = cur->next;
+      }
 
-      gum_clear_cache (target_page, page_size);
+      gum_code_segment_map (segment, source_offset, run_size, target_page);
 
-      source_offset += page_size;
+      gum_clear_cache_schedule (target_page, run_size);
+
+      source_offset += run_size;
     }
 
     gum_code_segment_free (segment);
   }
 
+  gum_clear_cache_commit_batch ();
+
   g_list_free (addresses);
 
   while ((task = g_queue_pop_head (self->pending_destroy_tasks)) != NULL)
@@ -1009,6 +1468,152 @@ gum_interceptor_transaction_schedule_prologue_write (
   }
 }
 
+static GumFunctionContextMap *
+gum_function_context_map_new (gsize size)
+{
+  GumFunctionContextMap * map;
+
+  map = g_malloc0 (sizeof (GumFunctionContextMap) +
+      (size * sizeof (GumFunctionContextMapEntry)));
+  map->size = size;
+  map->entries = (GumFunctionContextMapEntry *) (map + 1);
+
+  return map;
+}
+
+static gsize
+gum_function_context_map_hash (gpointer address)
+{
+  return (GPOINTER_TO_SIZE (address) >> 4) * 2654435761U;
+}
+
+static void
+gum_function_context_map_add (GumFunctionContextMap * map,
+                              gpointer address,
+                              GumFunctionContext * ctx)
+{
+  const gsize mask = map->size - 1;
+  gsize i;
+
+  i = gum_function_context_map_hash (address) & mask;
+  while (map->entries[i].address != NULL)
+    i = (i + 1) & mask;
+
+  map->entries[i].ctx = ctx;
+  g_atomic_pointer_set (&map->entries[i].address, address);
+
+  map->n_entries++;
+}
+
+static GumFunctionContext *
+gum_interceptor_map_lookup (GumInterceptor * self,
+                            gpointer function_address)
+{
+  GumFunctionContextMap * map;
+  gsize mask, i;
+
+  map = (GumFunctionContextMap *) g_atomic_pointer_get (&self->function_map);
+  mask = map->size - 1;
+
+  for (i = gum_function_context_map_hash (function_address) & mask; ;
+      i = (i + 1) & mask)
+  {
+    GumFunctionContextMapEntry * entry = &map->entries[i];
+    gpointer address = g_atomic_pointer_get (&entry->address);
+
+    if (address == function_address)
+      return entry->ctx;
+
+    if (address == NULL)
+      return NULL;
+
+    /* tombstones are skipped */
+  }
+}
+
+static void
+gum_interceptor_map_insert (GumInterceptor * self,
+                            GumFunctionContext * ctx)
+{
+  GumFunctionContextMap * map = (GumFunctionContextMap *) self->function_map;
+
+  if ((map->n_entries + map->n_removed + 1) * 4 >= map->size * 3)
+  {
+    GumFunctionContextMap * new_map;
+    gsize new_size, i;
+
+    new_size = ((map->n_entries + 1) * 4 >= map->size * 3)
+        ? map->size * 2
+        : map->size;
+
+    new_map = gum_function_context_map_new (new_size);
+    for (i = 0; i != map->size; i++)
+    {
+      GumFunctionContextMapEntry * entry = &map->entries[i];
+
+      if (entry->address != NULL &&
+          entry->address != GUM_FUNCTION_CONTEXT_MAP_TOMBSTONE)
+      {
+        gum_function_context_map_add (new_map, entry->address, entry->ctx);
+      }
+    }
+    gum_function_context_map_add (new_map, ctx->function_address, ctx);
+
+    gum_interceptor_map_publish (self, new_map, ctx);
+  }
+  else
+  {
+    gum_function_context_map_add (map, ctx->function_address, ctx);
+  }
+}
+
+static void
+gum_interceptor_map_remove (GumInterceptor * self,
+                            GumFunctionContext * ctx)
+{
+  GumFunctionContextMap * map = (GumFunctionContextMap *) self->function_map;
+  const gsize mask = map->size - 1;
+  gsize i;
+
+  /*
+   * Linear probing cannot unlink entries in place without disturbing
+   * concurrent readers, so removal leaves a tombstone that lookups skip
+   * and the next growth rebuild prunes. This keeps bulk teardown O(1)
+   * per hook.
+   */
+  for (i = gum_function_context_map_hash (ctx->function_address) & mask;
+      map->entries[i].address != NULL;
+      i = (i + 1) & mask)
+  {
+    GumFunctionContextMapEntry * entry = &map->entries[i];
+
+    if (entry->address == ctx->function_address)
+    {
+      g_atomic_pointer_set (&entry->address,
+          GUM_FUNCTION_CONTEXT_MAP_TOMBSTONE);
+
+      map->n_entries--;
+      map->n_removed++;
+
+      return;
+    }
+  }
+}
+
+static void
+gum_interceptor_map_publish (GumInterceptor * self,
+                             GumFunctionContextMap * new_map,
+                             GumFunctionContext * ctx)
+{
+  GumFunctionContextMap * old_map = (GumFunctionContextMap *)
+      self->function_map;
+
+  g_atomic_pointer_set (&self->function_map, new_map);
+
+  gum_interceptor_transaction_schedule_destroy (&self->current_transaction,
+      ctx, g_free, old_map);
+}
+
 static GumFunctionContext *
 gum_function_context_new (GumInterceptor * interceptor,
                           gpointer function_address)
@@ -1046,6 +1651,8 @@ gum_function_context_destroy (GumFunctionContext * function_ctx)
   g_assert (!function_ctx->destroyed);
   function_ctx->destroyed = TRUE;
 
+  gum_interceptor_map_remove (function_ctx->interceptor, function_ctx);
+
   if (function_ctx->activated)
   {
     gum_interceptor_transaction_schedule_prologue_write (transaction,
@@ -1071,6 +1678,9 @@ gum_function_context_is_empty (GumFunctionContext * function_ctx)
   if (function_ctx->replacement_function != NULL)
     return FALSE;
 
+  if (function_ctx->probe_func != NULL)
+    return FALSE;
+
   return gum_function_context_find_taken_listener_slot (function_ctx) == NULL;
 }
 
@@ -1087,6 +1697,9 @@ gum_function_context_add_listener (GumFunctionContext * function_ctx,
   entry->listener_interface = GUM_INVOCATION_LISTENER_GET_IFACE (listener);
   entry->listener_instance = listener;
   entry->function_data = function_data;
+  entry->total_cost = 0;
+  entry->n_calls = 0;
+  entry->budget_reported = FALSE;
 
   old_entries =
       (GPtrArray *) g_atomic_pointer_get (&function_ctx->listener_entries);
@@ -1117,35 +1730,118 @@ listener_entry_free (ListenerEntry * entry)
   g_slice_free (ListenerEntry, entry);
 }
 
+/*
+ * Accounting is intentionally lock-free: concurrent invocations may lose
+ * the occasional sample, which is fine for spotting hooks that blow their
+ * budget by orders of magnitude. The first few calls are excluded from
+ * judgement so lazy initialization and cold caches don't trip the alarm.
+ */
+static void
+gum_function_context_account_listener_cost (GumFunctionContext * function_ctx,
+                                            ListenerEntry * entry,
+                                            gint64 cost)
+{
+  GumInterceptor * interceptor = function_ctx->interceptor;
+  guint64 average;
+
+  entry->total_cost += cost;
+  entry->n_calls++;
+
+  if (entry->budget_reported || entry->n_calls < GUM_HOOK_BUDGET_MIN_CALLS)
+    return;
+
+  average = entry->total_cost / entry->n_calls;
+  if (average <= interceptor->hook_budget)
+    return;
+
+  entry->budget_reported = TRUE;
+
+  if (interceptor->hook_budget_func != NULL)
+  {
+    interceptor->hook_budget_func (function_ctx->function_address,
+        entry->listener_instance, (guint) average,
+        interceptor->hook_budget_data);
+  }
+}
+
 static void
 gum_function_context_remove_listener (GumFunctionContext * function_ctx,
                                       GumInvocationListener * listener)
 {
-  ListenerEntry ** slot;
   gboolean has_on_leave_listener;
-  GPtrArray * listener_entries;
+  GPtrArray * old_entries, * new_entries;
   guint i;
 
-  slot = gum_function_context_find_listener (function_ctx, listener);
-  g_assert (slot != NULL);
-  listener_entry_free (*slot);
-  *slot = NULL;
+  g_assert (gum_function_context_has_listener (function_ctx, listener));
 
-  has_on_leave_listener = FALSE;
-  listener_entries =
+  old_entries =
       (GPtrArray *) g_atomic_pointer_get (&function_ctx->listener_entries);
-  for (i = 0; i != listener_entries->len; i++)
+  new_entries = g_ptr_array_new_full (old_entries->len,
+      (GDestroyNotify) listener_entry_free);
+
+  has_on_leave_listener = FALSE;
+  for (i = 0; i != old_entries->len; i++)
   {
-    ListenerEntry * entry = g_ptr_array_index (listener_entries, i);
-    if (entry != NULL && entry->listener_interface->on_leave != NULL)
+    ListenerEntry * old_entry = g_ptr_array_index (old_entries, i);
+    ListenerEntry * new_entry = NULL;
+
+    if (old_entry != NULL && old_entry->listener_instance != listener)
     {
-      has_on_leave_listener = TRUE;
-      break;
+      new_entry = g_slice_dup (ListenerEntry, old_entry);
+
+      if (new_entry->listener_interface->on_leave != NULL)
+        has_on_leave_listener = TRUE;
     }
+
+    /*
+     * Keep the slot layout stable so invocations that are in flight can
+     * still use their index into listener_invocation_data on leave.
+     */
+    g_ptr_array_add (new_entries, new_entry);
   }
+
+  g_atomic_pointer_set (&function_ctx->listener_entries, new_entries);
+  gum_interceptor_transaction_schedule_destroy (
+      &function_ctx->interceptor->current_transaction, function_ctx,
+      (GDestroyNotify) g_ptr_array_unref, old_entries);
+
   function_ctx->has_on_leave_listener = has_on_leave_listener;
 }
 
+static void
+gum_function_context_remove_all_listeners (GumFunctionContext * function_ctx)
+{
+  GumInterceptorTransaction * transaction =
+      &function_ctx->interceptor->current_transaction;
+  GPtrArray * old_entries, * new_entries;
+  guint i;
+
+  old_entries =
+      (GPtrArray *) g_atomic_pointer_get (&function_ctx->listener_entries);
+  new_entries = g_ptr_array_new_full (old_entries->len,
+      (GDestroyNotify) listener_entry_free);
+
+  for (i = 0; i != old_entries->len; i++)
+  {
+    ListenerEntry * old_entry = g_ptr_array_index (old_entries, i);
+
+    if (old_entry != NULL)
+    {
+      gum_interceptor_transaction_schedule_destroy (transaction, function_ctx,
+          g_object_unref, g_object_ref (old_entry->listener_instance));
+    }
+
+    /* preserve the slot layout for invocations that are in flight */
+    g_ptr_array_add (new_entries, NULL);
+  }
+
+  g_atomic_pointer_set (&function_ctx->listener_entries, new_entries);
+  gum_interceptor_transaction_schedule_destroy (transaction, function_ctx,
+      (GDestroyNotify) g_ptr_array_unref, old_entries);
+
+  function_ctx->has_on_leave_listener = FALSE;
+}
+
 static gboolean
 gum_function_context_has_listener (GumFunctionContext * function_ctx,
                                    GumInvocationListener * listener)
@@ -1223,6 +1919,8 @@ _gum_function_context_begin_invocation (GumFunctionContext * function_ctx,
   }
   gum_tls_key_set_value (gum_interceptor_guard_key, interceptor);
 
+  gum_stats_add (GUM_STAT_INTERCEPTOR_HITS, 1);
+
   interceptor_ctx = get_interceptor_thread_context ();
   stack = interceptor_ctx->stack;
 
@@ -1300,8 +1998,19 @@ _gum_function_context_begin_invocation (GumFunctionContext * function_ctx,
 
       if (listener_entry->listener_interface->on_enter != NULL)
       {
+        gint64 started_at = 0;
+
+        if (interceptor->hook_budget != 0)
+          started_at = g_get_monotonic_time ();
+
         listener_entry->listener_interface->on_enter (
             listener_entry->listener_instance, invocation_ctx);
+
+        if (started_at != 0)
+        {
+          gum_function_context_account_listener_cost (function_ctx,
+              listener_entry, g_get_monotonic_time () - started_at);
+        }
       }
     }
 
@@ -1410,8 +2119,19 @@ _gum_function_context_end_invocation (GumFunctionContext * function_ctx,
 
     if (listener_entry->listener_interface->on_leave != NULL)
     {
+      gint64 started_at = 0;
+
+      if (function_ctx->interceptor->hook_budget != 0)
+        started_at = g_get_monotonic_time ();
+
       listener_entry->listener_interface->on_leave (
           listener_entry->listener_instance, invocation_ctx);
+
+      if (started_at != 0)
+      {
+        gum_function_context_account_listener_cost (function_ctx,
+            listener_entry, g_get_monotonic_time () - started_at);
+      }
     }
   }
 
@@ -1457,30 +2177,73 @@ get_interceptor_thread_context (void)
 {
   InterceptorThreadContext * context;
 
-  context = g_private_get (&gum_interceptor_context_private);
+  context = gum_tls_key_get_value (gum_interceptor_context_key);
   if (context == NULL)
   {
-    context = interceptor_thread_context_new ();
+    context = interceptor_thread_context_obtain ();
 
-    gum_spinlock_acquire (&gum_interceptor_thread_context_lock);
-    g_hash_table_add (gum_interceptor_thread_contexts, context);
-    gum_spinlock_release (&gum_interceptor_thread_context_lock);
+    gum_tls_key_set_value (gum_interceptor_context_key, context);
 
+    /*
+     * The GPrivate slot exists only for its destructor, which recycles the
+     * context when the thread exits.
+     */
     g_private_set (&gum_interceptor_context_private, context);
   }
 
   return context;
 }
 
+static InterceptorThreadContext *
+interceptor_thread_context_obtain (void)
+{
+  InterceptorThreadContext * context;
+
+  gum_adaptive_lock_acquire (&gum_interceptor_thread_context_lock);
+  context = gum_interceptor_context_pool;
+  if (context != NULL)
+    gum_interceptor_context_pool = context->next_in_pool;
+  gum_adaptive_lock_release (&gum_interceptor_thread_context_lock);
+
+  if (context != NULL)
+  {
+    context->next_in_pool = NULL;
+    return context;
+  }
+
+  context = interceptor_thread_context_new ();
+
+  gum_adaptive_lock_acquire (&gum_interceptor_thread_context_lock);
+  g_hash_table_add (gum_interceptor_thread_contexts, context);
+  gum_adaptive_lock_release (&gum_interceptor_thread_context_lock);
+
+  return context;
+}
+
 static void
 release_interceptor_thread_context (InterceptorThreadContext * context)
 {
   if (gum_interceptor_thread_contexts == NULL)
     return;
 
-  gum_spinlock_acquire (&gum_interceptor_thread_context_lock);
-  g_hash_table_remove (gum_interceptor_thread_contexts, context);
-  gum_spinlock_release (&gum_interceptor_thread_context_lock);
+  /*
+   * Contexts stay registered so that detach can still forget listener
+   * data held by idle ones; the dying thread merely parks its context
+   * for the next thread to come along. Clear the native TLS slot first:
+   * a hook firing later during this thread's teardown must grab a fresh
+   * context instead of one that another thread may have claimed from the
+   * pool in the meantime.
+   */
+  gum_tls_key_set_value (gum_interceptor_context_key, NULL);
+
+  context->ignore_level = 0;
+  g_array_set_size (context->stack, 0);
+  g_array_set_size (context->listener_data_slots, 0);
+
+  gum_adaptive_lock_acquire (&gum_interceptor_thread_context_lock);
+  context->next_in_pool = gum_interceptor_context_pool;
+  gum_interceptor_context_pool = context;
+  gum_adaptive_lock_release (&gum_interceptor_thread_context_lock);
 }
 
 static GumPointCut
@@ -1685,6 +2448,21 @@ interceptor_thread_context_forget_listener_data (
   }
 }
 
+static void
+interceptor_thread_context_forget_all_listener_data (
+    InterceptorThreadContext * self)
+{
+  guint i;
+
+  for (i = 0; i != self->listener_data_slots->len; i++)
+  {
+    ListenerDataSlot * slot;
+
+    slot = &g_array_index (self->listener_data_slots, ListenerDataSlot, i);
+    slot->owner = NULL;
+  }
+}
+
 static GumInvocationStackEntry *
 gum_invocation_stack_push (GumInvocationStack * stack,
                            GumFunctionContext * function_ctx,
@@ -1757,8 +2535,7 @@ static gboolean
 gum_interceptor_has (GumInterceptor * self,
                      gpointer function_address)
 {
-  return g_hash_table_lookup (self->function_by_address,
-      function_address) != NULL;
+  return gum_interceptor_map_lookup (self, function_address) != NULL;
 }
 
 static gpointer
@@ -1774,3 +2551,44 @@ gum_page_address_compare (gconstpointer a,
 {
   return GPOINTER_TO_SIZE (a) - GPOINTER_TO_SIZE (b);
 }
+
+static void
+gum_page_list_foreach_run (GList * sorted_page_addresses,
+                           guint page_size,
+                           GumPageRunFunc func,
+                           gpointer user_data)
+{
+  GList * cur = sorted_page_addresses;
+
+  while (cur != NULL)
+  {
+    guint8 * start = cur->data;
+    guint8 * end = start + page_size;
+
+    cur = cur->next;
+    while (cur != NULL && (guint8 *) cur->data == end)
+    {
+      end += page_size;
+      cur = cur->next;
+    }
+
+    func (start, end - start, user_data);
+  }
+}
+
+static void
+gum_page_run_mprotect (gpointer start,
+                       gsize size,
+                       gpointer user_data)
+{
+  gum_mprotect (start, size, GPOINTER_TO_UINT (user_data));
+}
+
+static void
+gum_page_run_clear_cache (gpointer start,
+                          gsize size,
+                          gpointer user_data)
+{
+  gum_clear_cache_schedule (start, size);
+}
+
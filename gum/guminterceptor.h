@@ -9,6 +9,7 @@
 #define __GUM_INTERCEPTOR_H__
 
 #include <glib-object.h>
+#include <gum/gumapiresolver.h>
 #include <gum/gumdefs.h>
 #include <gum/guminvocationlistener.h>
 
@@ -21,6 +22,12 @@ G_DECLARE_FINAL_TYPE (GumInterceptor, gum_interceptor, GUM, INTERCEPTOR,
 typedef GArray GumInvocationStack;
 typedef guint GumInvocationState;
 
+typedef void (* GumProbeFunc) (gpointer user_data, gpointer arg0,
+    gpointer arg1, gpointer arg2);
+typedef void (* GumInterceptorHookBudgetFunc) (gpointer function_address,
+    GumInvocationListener * listener, guint average_cost_in_microseconds,
+    gpointer user_data);
+
 typedef enum
 {
   GUM_ATTACH_OK               =  0,
@@ -37,19 +44,52 @@ typedef enum
   GUM_REPLACE_POLICY_VIOLATION = -3
 } GumReplaceReturn;
 
+typedef struct _GumInstrumentationReport GumInstrumentationReport;
+
+struct _GumInstrumentationReport
+{
+  guint redirect_size;
+  gssize trampoline_distance;
+  gboolean uses_deflector;
+  gboolean has_replacement;
+  guint n_listeners;
+};
+
 GUM_API GumInterceptor * gum_interceptor_obtain (void);
 
 GUM_API GumAttachReturn gum_interceptor_attach (GumInterceptor * self,
     gpointer function_address, GumInvocationListener * listener,
     gpointer listener_function_data);
+GUM_API GArray * gum_interceptor_attach_matching (GumInterceptor * self,
+    GumApiResolver * resolver, const gchar * query,
+    GumInvocationListener * listener, gpointer listener_function_data,
+    GError ** error);
 GUM_API void gum_interceptor_detach (GumInterceptor * self,
     GumInvocationListener * listener);
+GUM_API void gum_interceptor_detach_all (GumInterceptor * self);
+
+GUM_API GumAttachReturn gum_interceptor_attach_probe (GumInterceptor * self,
+    gpointer function_address, GumProbeFunc func, gpointer data);
+GUM_API void gum_interceptor_detach_probe (GumInterceptor * self,
+    gpointer function_address);
+GUM_API gboolean gum_interceptor_retarget_probe (GumInterceptor * self,
+    gpointer function_address, GumProbeFunc func, gpointer data);
 
 GUM_API GumReplaceReturn gum_interceptor_replace (GumInterceptor * self,
     gpointer function_address, gpointer replacement_function,
     gpointer replacement_data);
 GUM_API void gum_interceptor_revert (GumInterceptor * self,
     gpointer function_address);
+GUM_API gboolean gum_interceptor_retarget (GumInterceptor * self,
+    gpointer function_address, gpointer replacement_function,
+    gpointer replacement_data);
+
+GUM_API gboolean gum_interceptor_query_instrumentation (GumInterceptor * self,
+    gpointer function_address, GumInstrumentationReport * report);
+
+GUM_API void gum_interceptor_set_hook_budget (GumInterceptor * self,
+    guint budget_in_microseconds, GumInterceptorHookBudgetFunc func,
+    gpointer user_data);
 
 GUM_API void gum_interceptor_begin_transaction (GumInterceptor * self);
 GUM_API void gum_interceptor_end_transaction (GumInterceptor * self);
@@ -66,6 +106,9 @@ GUM_API void gum_interceptor_unignore_other_threads (GumInterceptor * self);
 
 GUM_API gpointer gum_invocation_stack_translate (GumInvocationStack * self,
     gpointer return_address);
+GUM_API guint gum_invocation_stack_get_depth (GumInvocationStack * self);
+GUM_API GumInvocationContext * gum_invocation_stack_peek_nth (
+    GumInvocationStack * self, guint n);
 
 GUM_API void gum_interceptor_save (GumInvocationState * state);
 GUM_API void gum_interceptor_restore (GumInvocationState * state);
@@ -55,6 +55,30 @@ gum_kernel_write (GumAddress address,
   return FALSE;
 }
 
+void
+gum_kernel_read_batch (const GumMemoryRange * ranges,
+                       guint num_ranges,
+                       guint8 ** blocks,
+                       gsize * n_bytes_read)
+{
+  guint i;
+
+  for (i = 0; i != num_ranges; i++)
+  {
+    blocks[i] = NULL;
+    if (n_bytes_read != NULL)
+      n_bytes_read[i] = 0;
+  }
+}
+
+guint
+gum_kernel_write_batch (const GumMemoryRange * ranges,
+                        const guint8 ** blocks,
+                        guint num_ranges)
+{
+  return 0;
+}
+
 void
 gum_kernel_scan (const GumMemoryRange * range,
                  const GumMatchPattern * pattern,
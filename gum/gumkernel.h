@@ -34,6 +34,10 @@ GUM_API guint8 * gum_kernel_read (GumAddress address, gsize len,
     gsize * n_bytes_read);
 GUM_API gboolean gum_kernel_write (GumAddress address, const guint8 * bytes,
     gsize len);
+GUM_API void gum_kernel_read_batch (const GumMemoryRange * ranges,
+    guint num_ranges, guint8 ** blocks, gsize * n_bytes_read);
+GUM_API guint gum_kernel_write_batch (const GumMemoryRange * ranges,
+    const guint8 ** blocks, guint num_ranges);
 GUM_API void gum_kernel_scan (const GumMemoryRange * range,
     const GumMatchPattern * pattern, GumMemoryScanMatchFunc func,
     gpointer user_data);
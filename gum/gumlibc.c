@@ -11,10 +11,28 @@ gum_memset (gpointer dst,
             gint c,
             gsize n)
 {
-  gsize offset;
+  guint8 * p = dst;
+  guint8 * end = p + n;
+
+  if (n >= 2 * sizeof (gsize))
+  {
+    gsize pattern, i;
+    guint8 * aligned_end;
+
+    pattern = (guint8) c;
+    for (i = 8; i != sizeof (gsize) * 8; i <<= 1)
+      pattern |= pattern << i;
+
+    while ((GPOINTER_TO_SIZE (p) % sizeof (gsize)) != 0)
+      *p++ = c;
+
+    aligned_end = p + ((end - p) / sizeof (gsize) * sizeof (gsize));
+    for (; p != aligned_end; p += sizeof (gsize))
+      *((gsize *) p) = pattern;
+  }
 
-  for (offset = 0; offset != n; offset++)
-    ((guint8 *) dst)[offset] = c;
+  while (p != end)
+    *p++ = c;
 
   return dst;
 }
@@ -0,0 +1,492 @@
+/*
+ * Copyright (C) 2020 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#include "gumlz4writer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define GUM_LZ4_BLOCK_CAPACITY (64 * 1024)
+#define GUM_LZ4_HASH_LOG 12
+#define GUM_LZ4_MIN_MATCH 4
+#define GUM_LZ4_LAST_LITERALS 5
+#define GUM_LZ4_MATCH_FIND_LIMIT 12
+
+typedef struct _GumLz4Block GumLz4Block;
+
+struct _GumLz4Block
+{
+  guint8 data[GUM_LZ4_BLOCK_CAPACITY];
+  gsize length;
+  gboolean pending;
+};
+
+/*
+ * Writes a standard LZ4 frame (independent 64 KB blocks, no checksums), so
+ * the output can be unpacked with any stock lz4 tool. Compression and I/O
+ * happen on a dedicated worker thread: the producer memcpys into one of two
+ * buffers and only ever blocks when both are waiting on the worker, which in
+ * practice means it never blocks at all on event-sized writes.
+ */
+struct _GumLz4Writer
+{
+  FILE * file;
+
+  GumLz4Block blocks[2];
+  guint fill_index;
+  guint64 logical_offset;
+
+  guint8 scratch[GUM_LZ4_BLOCK_CAPACITY];
+
+  GThread * worker;
+  GMutex mutex;
+  GCond cond;
+  gboolean closing;
+};
+
+static void gum_lz4_writer_write_frame_header (GumLz4Writer * self);
+static void gum_lz4_writer_submit_block (GumLz4Writer * self,
+    GumLz4Block * block);
+static gpointer gum_lz4_writer_run_worker (gpointer data);
+static void gum_lz4_writer_emit_block (GumLz4Writer * self,
+    GumLz4Block * block);
+static guint32 gum_lz4_compress_block (const guint8 * src, guint32 src_size,
+    guint8 * dst, guint32 dst_capacity);
+static guint32 gum_lz4_hash (guint32 sequence);
+static guint32 gum_lz4_read32 (const guint8 * p);
+static guint32 gum_xxh32 (const guint8 * data, gsize size, guint32 seed);
+
+GumLz4Writer *
+gum_lz4_writer_open (const gchar * path)
+{
+  GumLz4Writer * writer;
+  FILE * file;
+
+  file = fopen (path, "wb");
+  if (file == NULL)
+    return NULL;
+
+  writer = g_malloc0 (sizeof (GumLz4Writer));
+  writer->file = file;
+  g_mutex_init (&writer->mutex);
+  g_cond_init (&writer->cond);
+
+  gum_lz4_writer_write_frame_header (writer);
+
+  writer->worker = g_thread_new ("gum-lz4-writer",
+      gum_lz4_writer_run_worker, writer);
+
+  return writer;
+}
+
+void
+gum_lz4_writer_close (GumLz4Writer * self)
+{
+  GumLz4Block * block;
+  guint32 end_mark;
+
+  g_mutex_lock (&self->mutex);
+
+  block = &self->blocks[self->fill_index];
+  if (block->length != 0)
+    gum_lz4_writer_submit_block (self, block);
+
+  self->closing = TRUE;
+  g_cond_broadcast (&self->cond);
+
+  g_mutex_unlock (&self->mutex);
+
+  g_thread_join (self->worker);
+
+  end_mark = GUINT32_TO_LE (0);
+  fwrite (&end_mark, sizeof (end_mark), 1, self->file);
+  fclose (self->file);
+
+  g_cond_clear (&self->cond);
+  g_mutex_clear (&self->mutex);
+
+  g_free (self);
+}
+
+void
+gum_lz4_writer_write (GumLz4Writer * self,
+                      gconstpointer data,
+                      gsize size)
+{
+  const guint8 * cur = data;
+  gsize remaining = size;
+
+  g_mutex_lock (&self->mutex);
+
+  self->logical_offset += size;
+
+  while (remaining != 0)
+  {
+    GumLz4Block * block = &self->blocks[self->fill_index];
+    gsize n;
+
+    while (block->pending)
+      g_cond_wait (&self->cond, &self->mutex);
+
+    n = MIN (remaining, GUM_LZ4_BLOCK_CAPACITY - block->length);
+    memcpy (block->data + block->length, cur, n);
+    block->length += n;
+    cur += n;
+    remaining -= n;
+
+    if (block->length == GUM_LZ4_BLOCK_CAPACITY)
+      gum_lz4_writer_submit_block (self, block);
+  }
+
+  g_mutex_unlock (&self->mutex);
+}
+
+/*
+ * Returns the offset in the *decompressed* stream, i.e. what ftell() would
+ * have reported had the same bytes been written straight to disk. This lets
+ * formats that record absolute offsets, like the trace container's trailer,
+ * stay valid after a round-trip through lz4.
+ */
+guint64
+gum_lz4_writer_tell (GumLz4Writer * self)
+{
+  guint64 offset;
+
+  g_mutex_lock (&self->mutex);
+  offset = self->logical_offset;
+  g_mutex_unlock (&self->mutex);
+
+  return offset;
+}
+
+void
+gum_lz4_writer_flush (GumLz4Writer * self)
+{
+  GumLz4Block * block;
+
+  g_mutex_lock (&self->mutex);
+
+  block = &self->blocks[self->fill_index];
+  if (block->length != 0)
+    gum_lz4_writer_submit_block (self, block);
+
+  while (self->blocks[0].pending || self->blocks[1].pending)
+    g_cond_wait (&self->cond, &self->mutex);
+
+  g_mutex_unlock (&self->mutex);
+
+  fflush (self->file);
+}
+
+static void
+gum_lz4_writer_write_frame_header (GumLz4Writer * self)
+{
+  guint8 header[7];
+
+  header[0] = 0x04;
+  header[1] = 0x22;
+  header[2] = 0x4d;
+  header[3] = 0x18;
+  header[4] = 0x60; /* version 01, independent blocks */
+  header[5] = 0x40; /* 64 KB max block size */
+  header[6] = (guint8) (gum_xxh32 (header + 4, 2, 0) >> 8);
+
+  fwrite (header, sizeof (header), 1, self->file);
+}
+
+static void
+gum_lz4_writer_submit_block (GumLz4Writer * self,
+                             GumLz4Block * block)
+{
+  block->pending = TRUE;
+  self->fill_index = (self->fill_index + 1) % G_N_ELEMENTS (self->blocks);
+  g_cond_broadcast (&self->cond);
+}
+
+static gpointer
+gum_lz4_writer_run_worker (gpointer data)
+{
+  GumLz4Writer * self = data;
+  guint drain_index = 0;
+
+  g_mutex_lock (&self->mutex);
+
+  while (TRUE)
+  {
+    GumLz4Block * block = &self->blocks[drain_index];
+
+    while (!block->pending && !self->closing)
+      g_cond_wait (&self->cond, &self->mutex);
+
+    if (!block->pending)
+      break;
+
+    g_mutex_unlock (&self->mutex);
+    gum_lz4_writer_emit_block (self, block);
+    g_mutex_lock (&self->mutex);
+
+    block->length = 0;
+    block->pending = FALSE;
+    g_cond_broadcast (&self->cond);
+
+    drain_index = (drain_index + 1) % G_N_ELEMENTS (self->blocks);
+  }
+
+  g_mutex_unlock (&self->mutex);
+
+  return NULL;
+}
+
+static void
+gum_lz4_writer_emit_block (GumLz4Writer * self,
+                           GumLz4Block * block)
+{
+  guint32 compressed_size, word;
+
+  compressed_size = gum_lz4_compress_block (block->data,
+      (guint32) block->length, self->scratch, (guint32) block->length - 1);
+
+  if (compressed_size != 0)
+  {
+    word = GUINT32_TO_LE (compressed_size);
+    fwrite (&word, sizeof (word), 1, self->file);
+    fwrite (self->scratch, compressed_size, 1, self->file);
+  }
+  else
+  {
+    word = GUINT32_TO_LE ((guint32) block->length | 0x80000000U);
+    fwrite (&word, sizeof (word), 1, self->file);
+    fwrite (block->data, block->length, 1, self->file);
+  }
+}
+
+/*
+ * Greedy single-pass LZ4 block compressor. Returns zero when the input does
+ * not fit in dst_capacity, in which case the caller stores the block raw.
+ */
+static guint32
+gum_lz4_compress_block (const guint8 * src,
+                        guint32 src_size,
+                        guint8 * dst,
+                        guint32 dst_capacity)
+{
+  guint32 table[1 << GUM_LZ4_HASH_LOG];
+  const guint8 * ip = src;
+  const guint8 * anchor = src;
+  const guint8 * iend = src + src_size;
+  guint8 * op = dst;
+  guint8 * oend = dst + dst_capacity;
+
+  if (src_size >= GUM_LZ4_MATCH_FIND_LIMIT + 1)
+  {
+    const guint8 * mflimit = iend - GUM_LZ4_MATCH_FIND_LIMIT;
+    const guint8 * matchlimit = iend - GUM_LZ4_LAST_LITERALS;
+
+    memset (table, 0, sizeof (table));
+
+    while (ip < mflimit)
+    {
+      guint32 h = gum_lz4_hash (gum_lz4_read32 (ip));
+      const guint8 * match = src + table[h] - 1;
+      gboolean have_candidate = table[h] != 0;
+
+      table[h] = (guint32) (ip - src) + 1;
+
+      if (have_candidate &&
+          (gsize) (ip - match) <= 0xffff &&
+          gum_lz4_read32 (match) == gum_lz4_read32 (ip))
+      {
+        const guint8 * mip = ip + GUM_LZ4_MIN_MATCH;
+        const guint8 * mref = match + GUM_LZ4_MIN_MATCH;
+        guint32 literal_length, match_length, offset, code;
+        guint8 * token;
+
+        while (mip < matchlimit && *mip == *mref)
+        {
+          mip++;
+          mref++;
+        }
+
+        literal_length = (guint32) (ip - anchor);
+        match_length = (guint32) (mip - ip);
+        offset = (guint32) (ip - match);
+
+        if (op + 1 + literal_length + (literal_length / 255) + 1 + 2 +
+            (match_length / 255) + 1 > oend)
+          return 0;
+
+        token = op++;
+        if (literal_length >= 15)
+        {
+          code = literal_length - 15;
+          *token = 15 << 4;
+          while (code >= 255)
+          {
+            *op++ = 255;
+            code -= 255;
+          }
+          *op++ = (guint8) code;
+        }
+        else
+        {
+          *token = (guint8) (literal_length << 4);
+        }
+
+        memcpy (op, anchor, literal_length);
+        op += literal_length;
+
+        *op++ = (guint8) (offset & 0xff);
+        *op++ = (guint8) (offset >> 8);
+
+        code = match_length - GUM_LZ4_MIN_MATCH;
+        if (code >= 15)
+        {
+          *token |= 15;
+          code -= 15;
+          while (code >= 255)
+          {
+            *op++ = 255;
+            code -= 255;
+          }
+          *op++ = (guint8) code;
+        }
+        else
+        {
+          *token |= (guint8) code;
+        }
+
+        ip = mip;
+        anchor = ip;
+      }
+      else
+      {
+        ip++;
+      }
+    }
+  }
+
+  {
+    guint32 literal_length = (guint32) (iend - anchor);
+    guint8 * token;
+
+    if (op + 1 + literal_length + (literal_length / 255) + 1 > oend)
+      return 0;
+
+    token = op++;
+    if (literal_length >= 15)
+    {
+      guint32 code = literal_length - 15;
+
+      *token = 15 << 4;
+      while (code >= 255)
+      {
+        *op++ = 255;
+        code -= 255;
+      }
+      *op++ = (guint8) code;
+    }
+    else
+    {
+      *token = (guint8) (literal_length << 4);
+    }
+
+    memcpy (op, anchor, literal_length);
+    op += literal_length;
+  }
+
+  return (guint32) (op - dst);
+}
+
+static guint32
+gum_lz4_hash (guint32 sequence)
+{
+  return (sequence * 2654435761U) >> (32 - GUM_LZ4_HASH_LOG);
+}
+
+static guint32
+gum_lz4_read32 (const guint8 * p)
+{
+  guint32 v;
+
+  memcpy (&v, p, sizeof (v));
+
+  return v;
+}
+
+static guint32
+gum_xxh32 (const guint8 * data,
+           gsize size,
+           guint32 seed)
+{
+  const guint32 prime1 = 2654435761U;
+  const guint32 prime2 = 2246822519U;
+  const guint32 prime3 = 3266489917U;
+  const guint32 prime4 = 668265263U;
+  const guint32 prime5 = 374761393U;
+  const guint8 * p = data;
+  const guint8 * end = data + size;
+  guint32 h;
+
+#define GUM_XXH_ROTL(x, r) (((x) << (r)) | ((x) >> (32 - (r))))
+#define GUM_XXH_READ32(p) \
+    ((guint32) (p)[0] | ((guint32) (p)[1] << 8) | \
+     ((guint32) (p)[2] << 16) | ((guint32) (p)[3] << 24))
+
+  if (size >= 16)
+  {
+    guint32 v1 = seed + prime1 + prime2;
+    guint32 v2 = seed + prime2;
+    guint32 v3 = seed;
+    guint32 v4 = seed - prime1;
+
+    do
+    {
+      v1 = GUM_XXH_ROTL (v1 + GUM_XXH_READ32 (p) * prime2, 13) * prime1;
+      p += 4;
+      v2 = GUM_XXH_ROTL (v2 + GUM_XXH_READ32 (p) * prime2, 13) * prime1;
+      p += 4;
+      v3 = GUM_XXH_ROTL (v3 + GUM_XXH_READ32 (p) * prime2, 13) * prime1;
+      p += 4;
+      v4 = GUM_XXH_ROTL (v4 + GUM_XXH_READ32 (p) * prime2, 13) * prime1;
+      p += 4;
+    }
+    while (p + 16 <= end);
+
+    h = GUM_XXH_ROTL (v1, 1) + GUM_XXH_ROTL (v2, 7) + GUM_XXH_ROTL (v3, 12) +
+        GUM_XXH_ROTL (v4, 18);
+  }
+  else
+  {
+    h = seed + prime5;
+  }
+
+  h += (guint32) size;
+
+  while (p + 4 <= end)
+  {
+    h += GUM_XXH_READ32 (p) * prime3;
+    h = GUM_XXH_ROTL (h, 17) * prime4;
+    p += 4;
+  }
+
+  while (p < end)
+  {
+    h += *p * prime5;
+    h = GUM_XXH_ROTL (h, 11) * prime1;
+    p++;
+  }
+
+  h ^= h >> 15;
+  h *= prime2;
+  h ^= h >> 13;
+  h *= prime3;
+  h ^= h >> 16;
+
+#undef GUM_XXH_ROTL
+#undef GUM_XXH_READ32
+
+  return h;
+}
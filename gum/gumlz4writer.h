@@ -0,0 +1,26 @@
+/*
+ * Copyright (C) 2020 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#ifndef __GUM_LZ4_WRITER_H__
+#define __GUM_LZ4_WRITER_H__
+
+#include <gum/gumdefs.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GumLz4Writer GumLz4Writer;
+
+GUM_API GumLz4Writer * gum_lz4_writer_open (const gchar * path);
+GUM_API void gum_lz4_writer_close (GumLz4Writer * writer);
+
+GUM_API void gum_lz4_writer_write (GumLz4Writer * self, gconstpointer data,
+    gsize size);
+GUM_API guint64 gum_lz4_writer_tell (GumLz4Writer * self);
+GUM_API void gum_lz4_writer_flush (GumLz4Writer * self);
+
+G_END_DECLS
+
+#endif
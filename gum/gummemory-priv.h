@@ -16,6 +16,9 @@ struct _GumMatchPattern
 {
   GPtrArray * tokens;
   guint size;
+
+  guint8 * compiled_bytes;
+  guint8 * compiled_masks;
 };
 
 enum _GumMatchType
@@ -33,11 +36,19 @@ struct _GumMatchToken
   guint offset;
 };
 
+typedef void (* GumMemoryLayoutChangedFunc) (guint generation,
+    gpointer user_data);
+
 G_BEGIN_DECLS
 
 G_GNUC_INTERNAL void _gum_memory_backend_init (void);
 G_GNUC_INTERNAL void _gum_memory_backend_deinit (void);
 G_GNUC_INTERNAL guint _gum_memory_backend_query_page_size (void);
+G_GNUC_INTERNAL guint _gum_memory_query_layout_generation (void);
+G_GNUC_INTERNAL void _gum_memory_bump_layout_generation (void);
+G_GNUC_INTERNAL guint _gum_memory_register_layout_listener (
+    GumMemoryLayoutChangedFunc func, gpointer user_data);
+G_GNUC_INTERNAL void _gum_memory_unregister_layout_listener (guint id);
 G_GNUC_INTERNAL gint _gum_page_protection_to_posix (
     GumPageProtection page_prot);
 
@@ -10,12 +10,25 @@
 #include "gumcodesegment.h"
 #include "gumlibc.h"
 #include "gummemory-priv.h"
+#include "gumstats.h"
 
 #ifdef HAVE_PTRAUTH
 # include <ptrauth.h>
 #endif
 #include <string.h>
 
+#if defined (HAVE_I386)
+# include <immintrin.h>
+# ifdef _MSC_VER
+#  define GUM_SCAN_TARGET(isa)
+# else
+#  define GUM_SCAN_TARGET(isa) __attribute__ ((target (isa)))
+# endif
+#elif defined (HAVE_ARM64) || (defined (HAVE_ARM) && defined (__ARM_NEON))
+# include <arm_neon.h>
+# define HAVE_SCAN_NEON 1
+#endif
+
 #if defined (HAVE_IOS) && !defined (HAVE_I386)
 # include "backend-darwin/gumdarwin.h"
 # include <mach/mach.h>
@@ -29,7 +42,7 @@
 #define MSPACES                   1
 #define ONLY_MSPACES              1
 #define USE_LOCKS                 1
-#define FOOTERS                   0
+#define FOOTERS                   1
 #define INSECURE                  1
 #define NO_MALLINFO               0
 #ifdef HAVE_LIBC_MALLINFO
@@ -48,6 +61,123 @@
 # pragma warning (pop)
 #endif
 
+typedef const guint8 * (* GumScanFindFunc) (const guint8 * haystack,
+    gsize size, guint8 byte, guint8 mask);
+typedef struct _GumScanMatch GumScanMatch;
+typedef struct _GumScanRangesOperation GumScanRangesOperation;
+typedef struct _GumScanRangesCollectContext GumScanRangesCollectContext;
+
+struct _GumScanMatch
+{
+  GumAddress address;
+  gsize size;
+};
+
+struct _GumScanRangesOperation
+{
+  const GumMemoryRange * ranges;
+  guint n_ranges;
+  const GumMatchPattern * pattern;
+  gint next_range;
+  GArray ** matches;
+};
+
+struct _GumScanRangesCollectContext
+{
+  GArray * matches;
+};
+
+static gpointer gum_scan_ranges_worker (gpointer data);
+static gboolean gum_scan_ranges_collect (GumAddress address, gsize size,
+    gpointer user_data);
+
+typedef struct _GumAcNode GumAcNode;
+typedef struct _GumAcOutput GumAcOutput;
+typedef struct _GumScanSetFallbackContext GumScanSetFallbackContext;
+
+struct _GumAcOutput
+{
+  guint pattern_index;
+  guint anchor_offset;
+  guint anchor_len;
+};
+
+struct _GumAcNode
+{
+  gint32 next[256];
+  gint32 failure;
+  GArray * outputs;
+};
+
+struct _GumMatchPatternSet
+{
+  GPtrArray * patterns;
+  GArray * nodes;
+  GArray * fallbacks;
+};
+
+struct _GumScanSetFallbackContext
+{
+  guint pattern_index;
+  GumMemoryScanSetMatchFunc func;
+  gpointer user_data;
+  gboolean carry_on;
+};
+
+struct _GumMemoryScanSession
+{
+  GumMemoryRange range;
+  const GumMatchPattern * pattern;
+  GumMemoryScanMatchFunc func;
+  gpointer user_data;
+  gsize offset;
+  gboolean cancelled;
+};
+
+typedef struct _GumScanSessionStepContext GumScanSessionStepContext;
+
+struct _GumScanSessionStepContext
+{
+  GumMemoryScanSession * session;
+  GumAddress limit;
+};
+
+static gboolean gum_memory_scan_session_deliver (GumAddress address,
+    gsize size, gpointer user_data);
+
+struct _GumScanSnapshot
+{
+  GumMemoryRange range;
+  gsize value_size;
+  GArray * offsets;
+  guint8 * values;
+};
+
+static gboolean gum_scan_snapshot_collect (GumAddress address, gsize size,
+    gpointer user_data);
+static gboolean gum_scan_value_satisfies (const guint8 * current,
+    const guint8 * recorded, gsize value_size, GumScanPredicate predicate);
+
+static void gum_match_pattern_set_compile (GumMatchPatternSet * self);
+static gint32 gum_match_pattern_set_add_node (GumMatchPatternSet * self);
+static void gum_match_pattern_set_add_output (GumMatchPatternSet * self,
+    gint32 state, const GumAcOutput * output);
+static gboolean gum_scan_set_fallback_collect (GumAddress address, gsize size,
+    gpointer user_data);
+
+static GumScanFindFunc gum_scan_get_find_func (void);
+static const guint8 * gum_scan_find_scalar (const guint8 * haystack,
+    gsize size, guint8 byte, guint8 mask);
+#if defined (HAVE_I386)
+static const guint8 * gum_scan_find_sse2 (const guint8 * haystack, gsize size,
+    guint8 byte, guint8 mask);
+static const guint8 * gum_scan_find_avx2 (const guint8 * haystack, gsize size,
+    guint8 byte, guint8 mask);
+#elif defined (HAVE_SCAN_NEON)
+static const guint8 * gum_scan_find_neon (const guint8 * haystack, gsize size,
+    guint8 byte, guint8 mask);
+#endif
+
 static GumMatchPattern * gum_match_pattern_new (void);
 static void gum_match_pattern_update_computed_size (GumMatchPattern * self);
 static GumMatchToken * gum_match_pattern_get_longest_token (
@@ -56,9 +186,15 @@ static gboolean gum_match_pattern_try_match_on (const GumMatchPattern * self,
     guint8 * bytes);
 static gint gum_memcmp_mask (const guint8 * haystack, const guint8 * needle,
     const guint8 * mask, guint len);
+#if defined (HAVE_I386)
+static guint gum_memcmp_mask_sse2 (const guint8 * haystack,
+    const guint8 * needle, const guint8 * mask, guint len);
+static gboolean gum_scan_have_sse2 (void);
+#endif
 static GumMatchToken * gum_match_pattern_push_token (GumMatchPattern * self,
     GumMatchType type);
 static gboolean gum_match_pattern_seal (GumMatchPattern * self);
+static void gum_match_pattern_compile (GumMatchPattern * self);
 
 static GumMatchToken * gum_match_token_new (GumMatchType type);
 static void gum_match_token_free (GumMatchToken * token);
@@ -66,11 +202,29 @@ static void gum_match_token_append (GumMatchToken * self, guint8 byte);
 static void gum_match_token_append_with_mask (GumMatchToken * self,
     guint8 byte, guint8 mask);
 
+/*
+ * Allocations are spread across a few arenas with per-thread binding, so
+ * threads hitting the internal heap simultaneously do not all serialize
+ * on a single mspace lock. FOOTERS is enabled so that each chunk records
+ * its owning mspace, which lets a block be freed or reallocated from any
+ * thread regardless of which arena it came from.
+ */
+#define GUM_HEAP_NUM_ARENAS 4
+
+static guint gum_heap_arena_index_for_current_thread (void);
+
 static guint gum_heap_ref_count = 0;
-static mspace gum_mspace_main = NULL;
-static mspace gum_mspace_internal = NULL;
+static mspace gum_mspaces_main[GUM_HEAP_NUM_ARENAS];
+static mspace gum_mspaces_internal[GUM_HEAP_NUM_ARENAS];
+static GPrivate gum_heap_arena_index_key;
+static volatile gint gum_heap_arena_seq = 0;
 static guint gum_cached_page_size;
 
+#define GUM_MSPACE_MAIN \
+    (gum_mspaces_main[gum_heap_arena_index_for_current_thread ()])
+#define GUM_MSPACE_INTERNAL \
+    (gum_mspaces_internal[gum_heap_arena_index_for_current_thread ()])
+
 #ifdef HAVE_ANDROID
 G_LOCK_DEFINE_STATIC (gum_softened_code_pages);
 static GHashTable * gum_softened_code_pages;
@@ -82,6 +236,8 @@ G_DEFINE_BOXED_TYPE (GumMemoryRange, gum_memory_range, gum_memory_range_copy,
 void
 gum_internal_heap_ref (void)
 {
+  guint i;
+
   if (gum_heap_ref_count++ > 0)
     return;
 
@@ -91,22 +247,30 @@ gum_internal_heap_ref (void)
 
   _gum_cloak_init ();
 
-  gum_mspace_main = create_mspace (0, TRUE);
-  gum_mspace_internal = create_mspace (0, TRUE);
+  for (i = 0; i != GUM_HEAP_NUM_ARENAS; i++)
+  {
+    gum_mspaces_main[i] = create_mspace (0, TRUE);
+    gum_mspaces_internal[i] = create_mspace (0, TRUE);
+  }
 }
 
 void
 gum_internal_heap_unref (void)
 {
+  guint i;
+
   g_assert (gum_heap_ref_count != 0);
   if (--gum_heap_ref_count > 0)
     return;
 
-  destroy_mspace (gum_mspace_internal);
-  gum_mspace_internal = NULL;
+  for (i = 0; i != GUM_HEAP_NUM_ARENAS; i++)
+  {
+    destroy_mspace (gum_mspaces_internal[i]);
+    gum_mspaces_internal[i] = NULL;
 
-  destroy_mspace (gum_mspace_main);
-  gum_mspace_main = NULL;
+    destroy_mspace (gum_mspaces_main[i]);
+    gum_mspaces_main[i] = NULL;
+  }
 
   (void) DESTROY_LOCK (&malloc_global_mutex);
 
@@ -297,107 +461,1275 @@ gum_memory_patch_code (gpointer address,
     scratch_page = gum_code_segment_get_address (segment);
     memcpy (scratch_page, start_page, range_size);
 
-    apply (scratch_page + page_offset, apply_data);
+    apply (scratch_page + page_offset, apply_data);
+
+    gum_code_segment_realize (segment);
+    gum_code_segment_map (segment, 0, range_size, start_page);
+
+    gum_code_segment_free (segment);
+
+    gum_clear_cache (address, size);
+  }
+
+  return TRUE;
+}
+
+static gint
+gum_code_patch_compare (gconstpointer a,
+                        gconstpointer b)
+{
+  const GumCodePatch * patch_a = a;
+  const GumCodePatch * patch_b = b;
+
+  if (patch_a->address < patch_b->address)
+    return -1;
+  if (patch_a->address > patch_b->address)
+    return 1;
+  return 0;
+}
+
+static gboolean
+gum_memory_patch_code_in_pages (guint8 * start_page,
+                                gsize range_size,
+                                const GumCodePatch * patches,
+                                guint n_patches)
+{
+  gboolean rwx_supported;
+  guint i;
+
+  rwx_supported = gum_query_is_rwx_supported ();
+
+  if (rwx_supported || !gum_code_segment_is_supported ())
+  {
+    GumPageProtection protection;
+
+    protection = rwx_supported ? GUM_PAGE_RWX : GUM_PAGE_RW;
+
+    if (!gum_try_mprotect (start_page, range_size, protection))
+      return FALSE;
+
+    for (i = 0; i != n_patches; i++)
+      memcpy (patches[i].address, patches[i].bytes, patches[i].size);
+
+    gum_clear_cache (start_page, range_size);
+
+    if (!gum_try_mprotect (start_page, range_size, GUM_PAGE_RX))
+      return FALSE;
+  }
+  else
+  {
+    GumCodeSegment * segment;
+    guint8 * scratch_page;
+
+    segment = gum_code_segment_new (range_size, NULL);
+    scratch_page = gum_code_segment_get_address (segment);
+    memcpy (scratch_page, start_page, range_size);
+
+    for (i = 0; i != n_patches; i++)
+    {
+      memcpy (scratch_page + ((guint8 *) patches[i].address - start_page),
+          patches[i].bytes, patches[i].size);
+    }
+
+    gum_code_segment_realize (segment);
+    gum_code_segment_map (segment, 0, range_size, start_page);
+
+    gum_code_segment_free (segment);
+
+    gum_clear_cache (start_page, range_size);
+  }
+
+  return TRUE;
+}
+
+/*
+ * Applies a set of small code patches with one protection round-trip per
+ * contiguous run of pages instead of one per patch. The patches are sorted
+ * and those whose page ranges touch or overlap are coalesced, so hundreds
+ * of patches within the same function or module typically cost a single
+ * unprotect, write, restore, and cache flush.
+ */
+gboolean
+gum_memory_patch_code_batch (const GumCodePatch * patches,
+                             guint n_patches)
+{
+  gboolean success = TRUE;
+  GumCodePatch * sorted;
+  gsize page_size;
+  guint start, i;
+
+  if (n_patches == 0)
+    return TRUE;
+
+  sorted = g_memdup (patches, n_patches * sizeof (GumCodePatch));
+  for (i = 0; i != n_patches; i++)
+    sorted[i].address = gum_strip_code_pointer (sorted[i].address);
+  qsort (sorted, n_patches, sizeof (GumCodePatch), gum_code_patch_compare);
+
+  page_size = gum_query_page_size ();
+
+  start = 0;
+  while (start != n_patches && success)
+  {
+    guint8 * start_page, * end_page;
+    guint end;
+
+    start_page = GSIZE_TO_POINTER (
+        GPOINTER_TO_SIZE (sorted[start].address) & ~(page_size - 1));
+    end_page = GSIZE_TO_POINTER (
+        (GPOINTER_TO_SIZE (sorted[start].address) + sorted[start].size - 1) &
+        ~(page_size - 1));
+
+    for (end = start + 1; end != n_patches; end++)
+    {
+      guint8 * patch_start_page, * patch_end_page;
+
+      patch_start_page = GSIZE_TO_POINTER (
+          GPOINTER_TO_SIZE (sorted[end].address) & ~(page_size - 1));
+      if (patch_start_page > end_page + page_size)
+        break;
+
+      patch_end_page = GSIZE_TO_POINTER (
+          (GPOINTER_TO_SIZE (sorted[end].address) + sorted[end].size - 1) &
+          ~(page_size - 1));
+      if (patch_end_page > end_page)
+        end_page = patch_end_page;
+    }
+
+    success = gum_memory_patch_code_in_pages (start_page,
+        (end_page + page_size) - start_page, sorted + start, end - start);
+
+    start = end;
+  }
+
+  g_free (sorted);
+
+  return success;
+}
+
+gboolean
+gum_memory_mark_code (gpointer address,
+                      gsize size)
+{
+  gboolean success;
+
+  if (gum_code_segment_is_supported ())
+  {
+    gsize page_size;
+    guint8 * start_page, * end_page;
+
+    page_size = gum_query_page_size ();
+    start_page =
+        GSIZE_TO_POINTER (GPOINTER_TO_SIZE (address) & ~(page_size - 1));
+    end_page = GSIZE_TO_POINTER (
+        (GPOINTER_TO_SIZE (address) + size - 1) & ~(page_size - 1));
+
+    success = gum_code_segment_mark (start_page,
+        end_page - start_page + page_size, NULL);
+  }
+  else
+  {
+    success = gum_try_mprotect (address, size, GUM_PAGE_RX);
+  }
+
+  gum_clear_cache (address, size);
+
+  return success;
+}
+
+typedef struct _GumClearCacheBatch GumClearCacheBatch;
+
+struct _GumClearCacheBatch
+{
+  guint level;
+  GArray * ranges;
+};
+
+static void gum_clear_cache_batch_free (gpointer data);
+static gint gum_memory_range_compare_base (gconstpointer a, gconstpointer b);
+
+static GPrivate gum_clear_cache_batch_key =
+    G_PRIVATE_INIT (gum_clear_cache_batch_free);
+
+/*
+ * Patching code typically dirties many small ranges back to back, and each
+ * gum_clear_cache() round-trip has a fixed cost that dominates on arm64.
+ * While a batch is open on the current thread, gum_clear_cache_schedule()
+ * records ranges instead of flushing them; when the outermost batch is
+ * committed the ranges are sorted, merged where adjacent, and flushed in as
+ * few calls as possible. Without an open batch, scheduling a range flushes
+ * it right away.
+ */
+
+void
+gum_clear_cache_begin_batch (void)
+{
+  GumClearCacheBatch * batch;
+
+  batch = g_private_get (&gum_clear_cache_batch_key);
+  if (batch == NULL)
+  {
+    batch = g_slice_new (GumClearCacheBatch);
+    batch->level = 0;
+    batch->ranges = g_array_new (FALSE, FALSE, sizeof (GumMemoryRange));
+
+    g_private_set (&gum_clear_cache_batch_key, batch);
+  }
+
+  batch->level++;
+}
+
+void
+gum_clear_cache_schedule (gpointer address,
+                          gsize size)
+{
+  GumClearCacheBatch * batch;
+  GumMemoryRange range;
+
+  batch = g_private_get (&gum_clear_cache_batch_key);
+  if (batch == NULL || batch->level == 0)
+  {
+    gum_clear_cache (address, size);
+    return;
+  }
+
+  range.base_address = GUM_ADDRESS (address);
+  range.size = size;
+  g_array_append_val (batch->ranges, range);
+}
+
+void
+gum_clear_cache_commit_batch (void)
+{
+  GumClearCacheBatch * batch;
+  GArray * ranges;
+  guint i;
+
+  batch = g_private_get (&gum_clear_cache_batch_key);
+  g_assert (batch != NULL && batch->level != 0);
+
+  batch->level--;
+  if (batch->level != 0)
+    return;
+
+  ranges = batch->ranges;
+  if (ranges->len == 0)
+    return;
+
+  g_array_sort (ranges, gum_memory_range_compare_base);
+
+  i = 0;
+  while (i != ranges->len)
+  {
+    GumMemoryRange * range = &g_array_index (ranges, GumMemoryRange, i);
+    GumAddress end = range->base_address + range->size;
+    guint j;
+
+    for (j = i + 1; j != ranges->len; j++)
+    {
+      GumMemoryRange * next = &g_array_index (ranges, GumMemoryRange, j);
+
+      if (next->base_address > end)
+        break;
+
+      end = MAX (end, next->base_address + next->size);
+    }
+
+    gum_clear_cache (GSIZE_TO_POINTER (range->base_address),
+        end - range->base_address);
+
+    i = j;
+  }
+
+  g_array_set_size (ranges, 0);
+}
+
+static void
+gum_clear_cache_batch_free (gpointer data)
+{
+  GumClearCacheBatch * batch = data;
+
+  g_array_free (batch->ranges, TRUE);
+  g_slice_free (GumClearCacheBatch, batch);
+}
+
+static gint
+gum_memory_range_compare_base (gconstpointer a,
+                               gconstpointer b)
+{
+  const GumMemoryRange * range_a = a;
+  const GumMemoryRange * range_b = b;
+
+  if (range_a->base_address < range_b->base_address)
+    return -1;
+
+  if (range_a->base_address > range_b->base_address)
+    return 1;
+
+  return 0;
+}
+
+/*
+ * Applies one protection change across many ranges with as few kernel
+ * round-trips as possible: each range is page-aligned, the set is sorted,
+ * and runs that touch or overlap are merged before being handed to
+ * gum_try_mprotect(). A caller toggling protection on hundreds of page
+ * runs per pass, like an unpacker walking a dump, thus issues a handful
+ * of syscalls instead of one per range.
+ */
+gboolean
+gum_try_mprotect_batch (const GumMemoryRange * ranges,
+                        guint n_ranges,
+                        GumPageProtection page_prot)
+{
+  gboolean success = TRUE;
+  GArray * sorted;
+  gsize page_size;
+  guint i;
+
+  if (n_ranges == 0)
+    return TRUE;
+
+  page_size = gum_query_page_size ();
+
+  sorted = g_array_sized_new (FALSE, FALSE, sizeof (GumMemoryRange), n_ranges);
+  for (i = 0; i != n_ranges; i++)
+  {
+    GumMemoryRange aligned;
+    GumAddress end;
+
+    if (ranges[i].size == 0)
+      continue;
+
+    aligned.base_address =
+        ranges[i].base_address & ~((GumAddress) page_size - 1);
+    end = (ranges[i].base_address + ranges[i].size + page_size - 1) &
+        ~((GumAddress) page_size - 1);
+    aligned.size = end - aligned.base_address;
+
+    g_array_append_val (sorted, aligned);
+  }
+
+  g_array_sort (sorted, gum_memory_range_compare_base);
+
+  i = 0;
+  while (i != sorted->len && success)
+  {
+    GumMemoryRange * range = &g_array_index (sorted, GumMemoryRange, i);
+    GumAddress end = range->base_address + range->size;
+    guint j;
+
+    for (j = i + 1; j != sorted->len; j++)
+    {
+      GumMemoryRange * next = &g_array_index (sorted, GumMemoryRange, j);
+
+      if (next->base_address > end)
+        break;
+
+      end = MAX (end, next->base_address + next->size);
+    }
+
+    success = gum_try_mprotect (GSIZE_TO_POINTER (range->base_address),
+        end - range->base_address, page_prot);
+
+    i = j;
+  }
+
+  g_array_free (sorted, TRUE);
+
+  return success;
+}
+
+void
+gum_memory_scan (const GumMemoryRange * range,
+                 const GumMatchPattern * pattern,
+                 GumMemoryScanMatchFunc func,
+                 gpointer user_data)
+{
+  GumMatchToken * needle;
+  guint8 * needle_data, * mask_data = NULL;
+  guint needle_len;
+  guint8 first_byte, first_mask;
+  GumScanFindFunc find;
+  guint8 * cur, * end_address;
+
+  needle = gum_match_pattern_get_longest_token (pattern, GUM_MATCH_EXACT);
+  if (needle == NULL)
+  {
+    needle = gum_match_pattern_get_longest_token (pattern, GUM_MATCH_MASK);
+    mask_data = (guint8 *) needle->masks->data;
+  }
+
+  needle_data = (guint8 *) needle->bytes->data;
+  needle_len = needle->bytes->len;
+
+  first_mask = (mask_data != NULL) ? mask_data[0] : 0xff;
+  first_byte = needle_data[0] & first_mask;
+
+  find = gum_scan_get_find_func ();
+
+  gum_stats_add (GUM_STAT_MEMORY_SCAN_BYTES, range->size);
+
+  cur = GSIZE_TO_POINTER (range->base_address);
+  end_address = cur + range->size - (pattern->size - needle->offset) + 1;
+
+  while (cur < end_address)
+  {
+    guint8 * start;
+
+    cur = (guint8 *) find (cur, end_address - cur, first_byte, first_mask);
+    if (cur == NULL)
+      break;
+
+    if (mask_data == NULL)
+    {
+      if (memcmp (cur, needle_data, needle_len) != 0)
+      {
+        cur++;
+        continue;
+      }
+    }
+    else
+    {
+      if (gum_memcmp_mask ((guint8 *) cur, (guint8 *) needle_data,
+          (guint8 *) mask_data, needle_len) != 0)
+      {
+        cur++;
+        continue;
+      }
+    }
+
+    start = cur - needle->offset;
+
+    if (gum_match_pattern_try_match_on (pattern, start))
+    {
+      if (!func (GUM_ADDRESS (start), pattern->size, user_data))
+        return;
+
+      cur = start + pattern->size;
+    }
+    else
+    {
+      cur++;
+    }
+  }
+}
+
+void
+gum_memory_scan_ranges (const GumMemoryRange * ranges,
+                        guint n_ranges,
+                        const GumMatchPattern * pattern,
+                        GumMemoryScanMatchFunc func,
+                        gpointer user_data)
+{
+  GumScanRangesOperation op;
+  guint n_workers, i;
+  gboolean carry_on;
+
+  if (n_ranges == 0)
+    return;
+
+  op.ranges = ranges;
+  op.n_ranges = n_ranges;
+  op.pattern = pattern;
+  op.next_range = 0;
+  op.matches = g_new (GArray *, n_ranges);
+  for (i = 0; i != n_ranges; i++)
+    op.matches[i] = g_array_new (FALSE, FALSE, sizeof (GumScanMatch));
+
+  n_workers = MIN (n_ranges, g_get_num_processors ());
+
+  if (n_workers > 1)
+  {
+    GThread ** workers;
+
+    workers = g_new (GThread *, n_workers);
+    for (i = 0; i != n_workers; i++)
+    {
+      workers[i] = g_thread_new ("gum-memory-scan",
+          gum_scan_ranges_worker, &op);
+    }
+    for (i = 0; i != n_workers; i++)
+      g_thread_join (workers[i]);
+    g_free (workers);
+  }
+  else
+  {
+    gum_scan_ranges_worker (&op);
+  }
+
+  carry_on = TRUE;
+
+  for (i = 0; i != n_ranges; i++)
+  {
+    GArray * matches = op.matches[i];
+    guint match_index;
+
+    for (match_index = 0;
+        carry_on && match_index != matches->len;
+        match_index++)
+    {
+      GumScanMatch * match;
+
+      match = &g_array_index (matches, GumScanMatch, match_index);
+      carry_on = func (match->address, match->size, user_data);
+    }
+
+    g_array_free (matches, TRUE);
+  }
+
+  g_free (op.matches);
+}
+
+static gpointer
+gum_scan_ranges_worker (gpointer data)
+{
+  GumScanRangesOperation * op = data;
+  gint index;
+
+  while ((index = g_atomic_int_add (&op->next_range, 1)) <
+      (gint) op->n_ranges)
+  {
+    GumScanRangesCollectContext ctx;
+
+    ctx.matches = op->matches[index];
+
+    gum_memory_scan (&op->ranges[index], op->pattern,
+        gum_scan_ranges_collect, &ctx);
+  }
+
+  return NULL;
+}
+
+static gboolean
+gum_scan_ranges_collect (GumAddress address,
+                         gsize size,
+                         gpointer user_data)
+{
+  GumScanRangesCollectContext * ctx = user_data;
+  GumScanMatch match;
+
+  match.address = address;
+  match.size = size;
+  g_array_append_val (ctx->matches, match);
+
+  return TRUE;
+}
+
+GumMemoryScanSession *
+gum_memory_scan_session_new (const GumMemoryRange * range,
+                             const GumMatchPattern * pattern,
+                             GumMemoryScanMatchFunc func,
+                             gpointer user_data)
+{
+  GumMemoryScanSession * session;
+
+  session = g_slice_new (GumMemoryScanSession);
+  session->range = *range;
+  session->pattern = pattern;
+  session->func = func;
+  session->user_data = user_data;
+  session->offset = 0;
+  session->cancelled = FALSE;
+
+  return session;
+}
+
+gboolean
+gum_memory_scan_session_step (GumMemoryScanSession * self,
+                              gsize max_bytes)
+{
+  gsize chunk_size, window_size;
+  GumMemoryRange window;
+  GumScanSessionStepContext ctx;
+
+  if (self->cancelled || self->offset >= self->range.size)
+    return FALSE;
+
+  chunk_size = MIN (max_bytes, self->range.size - self->offset);
+
+  /*
+   * Extend the window so matches straddling the chunk boundary are seen
+   * now; matches starting beyond the chunk are filtered out and found by
+   * a later step.
+   */
+  window_size = MIN (chunk_size + self->pattern->size - 1,
+      self->range.size - self->offset);
+
+  window.base_address = self->range.base_address + self->offset;
+  window.size = window_size;
+
+  ctx.session = self;
+  ctx.limit = window.base_address + chunk_size;
+
+  gum_memory_scan (&window, self->pattern, gum_memory_scan_session_deliver,
+      &ctx);
+
+  self->offset += chunk_size;
+
+  return !self->cancelled && self->offset < self->range.size;
+}
+
+void
+gum_memory_scan_session_cancel (GumMemoryScanSession * self)
+{
+  self->cancelled = TRUE;
+}
+
+gdouble
+gum_memory_scan_session_get_progress (GumMemoryScanSession * self)
+{
+  if (self->range.size == 0)
+    return 1.0;
+
+  return (gdouble) self->offset / (gdouble) self->range.size;
+}
+
+void
+gum_memory_scan_session_free (GumMemoryScanSession * self)
+{
+  g_slice_free (GumMemoryScanSession, self);
+}
+
+static gboolean
+gum_memory_scan_session_deliver (GumAddress address,
+                                 gsize size,
+                                 gpointer user_data)
+{
+  GumScanSessionStepContext * ctx = user_data;
+  GumMemoryScanSession * session = ctx->session;
+
+  if (address >= ctx->limit)
+    return FALSE;
+
+  if (!session->func (address, size, session->user_data))
+  {
+    session->cancelled = TRUE;
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+GumScanSnapshot *
+gum_scan_snapshot_capture (const GumMemoryRange * range,
+                           const GumMatchPattern * pattern,
+                           gsize value_size)
+{
+  GumScanSnapshot * snapshot;
+  const guint8 * base;
+  guint i;
+
+  snapshot = g_slice_new (GumScanSnapshot);
+  snapshot->range = *range;
+  snapshot->value_size = (pattern != NULL) ? pattern->size : value_size;
+  snapshot->offsets = g_array_new (FALSE, FALSE, sizeof (gsize));
+
+  if (pattern != NULL)
+  {
+    gum_memory_scan (range, pattern, gum_scan_snapshot_collect, snapshot);
+  }
+  else
+  {
+    gsize offset;
+
+    g_assert (value_size != 0);
+
+    for (offset = 0; offset + value_size <= range->size;
+        offset += value_size)
+    {
+      g_array_append_val (snapshot->offsets, offset);
+    }
+  }
+
+  snapshot->values =
+      g_malloc ((gsize) snapshot->offsets->len * snapshot->value_size);
+
+  base = GSIZE_TO_POINTER (range->base_address);
+  for (i = 0; i != snapshot->offsets->len; i++)
+  {
+    gsize offset = g_array_index (snapshot->offsets, gsize, i);
+
+    memcpy (snapshot->values + (gsize) i * snapshot->value_size,
+        base + offset, snapshot->value_size);
+  }
+
+  return snapshot;
+}
+
+guint
+gum_scan_snapshot_rescan (GumScanSnapshot * self,
+                          GumScanPredicate predicate)
+{
+  const guint8 * base;
+  guint kept, i;
+
+  base = GSIZE_TO_POINTER (self->range.base_address);
+  kept = 0;
+
+  for (i = 0; i != self->offsets->len; i++)
+  {
+    gsize offset = g_array_index (self->offsets, gsize, i);
+    const guint8 * current = base + offset;
+    const guint8 * recorded = self->values + (gsize) i * self->value_size;
+
+    if (gum_scan_value_satisfies (current, recorded, self->value_size,
+        predicate))
+    {
+      g_array_index (self->offsets, gsize, kept) = offset;
+      memcpy (self->values + (gsize) kept * self->value_size, current,
+          self->value_size);
+      kept++;
+    }
+  }
+
+  g_array_set_size (self->offsets, kept);
+
+  return kept;
+}
+
+guint
+gum_scan_snapshot_get_size (GumScanSnapshot * self)
+{
+  return self->offsets->len;
+}
+
+void
+gum_scan_snapshot_enumerate (GumScanSnapshot * self,
+                             GumMemoryScanMatchFunc func,
+                             gpointer user_data)
+{
+  guint i;
+
+  for (i = 0; i != self->offsets->len; i++)
+  {
+    gsize offset = g_array_index (self->offsets, gsize, i);
+
+    if (!func (self->range.base_address + offset, self->value_size,
+        user_data))
+    {
+      return;
+    }
+  }
+}
+
+void
+gum_scan_snapshot_free (GumScanSnapshot * self)
+{
+  g_free (self->values);
+  g_array_free (self->offsets, TRUE);
+
+  g_slice_free (GumScanSnapshot, self);
+}
+
+static gboolean
+gum_scan_snapshot_collect (GumAddress address,
+                           gsize size,
+                           gpointer user_data)
+{
+  GumScanSnapshot * self = user_data;
+  gsize offset = address - self->range.base_address;
+
+  g_array_append_val (self->offsets, offset);
+
+  return TRUE;
+}
+
+static gboolean
+gum_scan_value_satisfies (const guint8 * current,
+                          const guint8 * recorded,
+                          gsize value_size,
+                          GumScanPredicate predicate)
+{
+  gint comparison;
+
+  if (value_size <= sizeof (guint64))
+  {
+    guint64 current_value = 0, recorded_value = 0;
+
+    memcpy (&current_value, current, value_size);
+    memcpy (&recorded_value, recorded, value_size);
+
+    if (current_value == recorded_value)
+      comparison = 0;
+    else
+      comparison = (current_value > recorded_value) ? 1 : -1;
+  }
+  else
+  {
+    comparison = memcmp (current, recorded, value_size);
+  }
+
+  switch (predicate)
+  {
+    case GUM_SCAN_CHANGED:
+      return comparison != 0;
+    case GUM_SCAN_UNCHANGED:
+      return comparison == 0;
+    case GUM_SCAN_INCREASED:
+      return comparison > 0;
+    case GUM_SCAN_DECREASED:
+      return comparison < 0;
+    default:
+      g_assert_not_reached ();
+  }
+
+  return FALSE;
+}
+
+GumMatchPatternSet *
+gum_match_pattern_set_new (void)
+{
+  GumMatchPatternSet * set;
+
+  set = g_slice_new (GumMatchPatternSet);
+  set->patterns =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) gum_match_pattern_free);
+  set->nodes = NULL;
+  set->fallbacks = NULL;
+
+  return set;
+}
+
+guint
+gum_match_pattern_set_add (GumMatchPatternSet * self,
+                           GumMatchPattern * pattern)
+{
+  g_assert (self->nodes == NULL);
+
+  g_ptr_array_add (self->patterns, pattern);
+
+  return self->patterns->len - 1;
+}
+
+void
+gum_match_pattern_set_free (GumMatchPatternSet * set)
+{
+  if (set->nodes != NULL)
+  {
+    guint i;
+
+    for (i = 0; i != set->nodes->len; i++)
+    {
+      GumAcNode * node = &g_array_index (set->nodes, GumAcNode, i);
+
+      if (node->outputs != NULL)
+        g_array_free (node->outputs, TRUE);
+    }
+
+    g_array_free (set->nodes, TRUE);
+    g_array_free (set->fallbacks, TRUE);
+  }
+
+  g_ptr_array_free (set->patterns, TRUE);
+
+  g_slice_free (GumMatchPatternSet, set);
+}
+
+void
+gum_memory_scan_set (const GumMemoryRange * range,
+                     GumMatchPatternSet * set,
+                     GumMemoryScanSetMatchFunc func,
+                     gpointer user_data)
+{
+  const guint8 * base;
+  gint32 state;
+  gsize i;
+
+  gum_match_pattern_set_compile (set);
+
+  base = GSIZE_TO_POINTER (range->base_address);
+  state = 0;
+
+  for (i = 0; i != range->size; i++)
+  {
+    GumAcNode * node;
+
+    state = g_array_index (set->nodes, GumAcNode, state).next[base[i]];
+
+    node = &g_array_index (set->nodes, GumAcNode, state);
+    if (node->outputs != NULL)
+    {
+      guint output_index;
+
+      for (output_index = 0; output_index != node->outputs->len;
+          output_index++)
+      {
+        GumAcOutput * output;
+        gssize start;
+        GumMatchPattern * pattern;
+
+        output = &g_array_index (node->outputs, GumAcOutput, output_index);
+
+        start = (gssize) (i + 1) - output->anchor_len - output->anchor_offset;
+        if (start < 0)
+          continue;
+
+        pattern = g_ptr_array_index (set->patterns, output->pattern_index);
+        if ((gsize) start + pattern->size > range->size)
+          continue;
+
+        if (gum_match_pattern_try_match_on (pattern,
+            (guint8 *) (base + start)))
+        {
+          if (!func (output->pattern_index, GUM_ADDRESS (base + start),
+              pattern->size, user_data))
+          {
+            return;
+          }
+        }
+      }
+    }
+  }
+
+  for (i = 0; i != set->fallbacks->len; i++)
+  {
+    GumScanSetFallbackContext ctx;
+
+    ctx.pattern_index = g_array_index (set->fallbacks, guint, i);
+    ctx.func = func;
+    ctx.user_data = user_data;
+    ctx.carry_on = TRUE;
+
+    gum_memory_scan (range,
+        g_ptr_array_index (set->patterns, ctx.pattern_index),
+        gum_scan_set_fallback_collect, &ctx);
+
+    if (!ctx.carry_on)
+      return;
+  }
+}
+
+static void
+gum_match_pattern_set_compile (GumMatchPatternSet * self)
+{
+  guint i;
+  GQueue queue = G_QUEUE_INIT;
+  guint c;
+
+  if (self->nodes != NULL)
+    return;
+
+  self->nodes = g_array_new (FALSE, FALSE, sizeof (GumAcNode));
+  self->fallbacks = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  gum_match_pattern_set_add_node (self);
+
+  for (i = 0; i != self->patterns->len; i++)
+  {
+    GumMatchPattern * pattern;
+    GumMatchToken * anchor;
+    GumAcOutput output;
+    gint32 state;
+    guint byte_index;
+
+    pattern = g_ptr_array_index (self->patterns, i);
+
+    anchor = gum_match_pattern_get_longest_token (pattern, GUM_MATCH_EXACT);
+    if (anchor == NULL)
+    {
+      g_array_append_val (self->fallbacks, i);
+      continue;
+    }
+
+    state = 0;
+
+    for (byte_index = 0; byte_index != anchor->bytes->len; byte_index++)
+    {
+      guint8 byte = g_array_index (anchor->bytes, guint8, byte_index);
+      gint32 next_state;
+
+      next_state = g_array_index (self->nodes, GumAcNode, state).next[byte];
+      if (next_state == -1)
+      {
+        next_state = gum_match_pattern_set_add_node (self);
+        g_array_index (self->nodes, GumAcNode, state).next[byte] = next_state;
+      }
+
+      state = next_state;
+    }
+
+    output.pattern_index = i;
+    output.anchor_offset = anchor->offset;
+    output.anchor_len = anchor->bytes->len;
+    gum_match_pattern_set_add_output (self, state, &output);
+  }
+
+  for (c = 0; c != 256; c++)
+  {
+    GumAcNode * root = &g_array_index (self->nodes, GumAcNode, 0);
+    gint32 state = root->next[c];
+
+    if (state == -1)
+    {
+      root->next[c] = 0;
+    }
+    else
+    {
+      g_array_index (self->nodes, GumAcNode, state).failure = 0;
+      g_queue_push_tail (&queue, GINT_TO_POINTER (state));
+    }
+  }
+
+  while (!g_queue_is_empty (&queue))
+  {
+    gint32 r = GPOINTER_TO_INT (g_queue_pop_head (&queue));
+
+    for (c = 0; c != 256; c++)
+    {
+      gint32 state, fallback_state;
+
+      state = g_array_index (self->nodes, GumAcNode, r).next[c];
+      fallback_state = g_array_index (self->nodes, GumAcNode,
+          g_array_index (self->nodes, GumAcNode, r).failure).next[c];
+
+      if (state == -1)
+      {
+        g_array_index (self->nodes, GumAcNode, r).next[c] = fallback_state;
+      }
+      else
+      {
+        GumAcNode * fallback_node;
+
+        g_array_index (self->nodes, GumAcNode, state).failure =
+            fallback_state;
+
+        fallback_node =
+            &g_array_index (self->nodes, GumAcNode, fallback_state);
+        if (fallback_node->outputs != NULL)
+        {
+          guint output_index;
+
+          for (output_index = 0; output_index != fallback_node->outputs->len;
+              output_index++)
+          {
+            GumAcOutput output = g_array_index (fallback_node->outputs,
+                GumAcOutput, output_index);
+
+            gum_match_pattern_set_add_output (self, state, &output);
+          }
+        }
+
+        g_queue_push_tail (&queue, GINT_TO_POINTER (state));
+      }
+    }
+  }
+}
+
+static gint32
+gum_match_pattern_set_add_node (GumMatchPatternSet * self)
+{
+  GumAcNode node;
+  guint c;
+
+  for (c = 0; c != 256; c++)
+    node.next[c] = -1;
+  node.failure = 0;
+  node.outputs = NULL;
+
+  g_array_append_val (self->nodes, node);
+
+  return self->nodes->len - 1;
+}
+
+static void
+gum_match_pattern_set_add_output (GumMatchPatternSet * self,
+                                  gint32 state,
+                                  const GumAcOutput * output)
+{
+  GumAcNode * node = &g_array_index (self->nodes, GumAcNode, state);
+
+  if (node->outputs == NULL)
+    node->outputs = g_array_new (FALSE, FALSE, sizeof (GumAcOutput));
 
-    gum_code_segment_realize (segment);
-    gum_code_segment_map (segment, 0, range_size, start_page);
+  g_array_append_val (node->outputs, *output);
+}
 
-    gum_code_segment_free (segment);
+static gboolean
+gum_scan_set_fallback_collect (GumAddress address,
+                               gsize size,
+                               gpointer user_data)
+{
+  GumScanSetFallbackContext * ctx = user_data;
 
-    gum_clear_cache (address, size);
-  }
+  ctx->carry_on = ctx->func (ctx->pattern_index, address, size,
+      ctx->user_data);
 
-  return TRUE;
+  return ctx->carry_on;
 }
 
-gboolean
-gum_memory_mark_code (gpointer address,
-                      gsize size)
+static GumScanFindFunc
+gum_scan_get_find_func (void)
 {
-  gboolean success;
+  static gsize cached_func = 0;
 
-  if (gum_code_segment_is_supported ())
+  if (g_once_init_enter (&cached_func))
   {
-    gsize page_size;
-    guint8 * start_page, * end_page;
-
-    page_size = gum_query_page_size ();
-    start_page =
-        GSIZE_TO_POINTER (GPOINTER_TO_SIZE (address) & ~(page_size - 1));
-    end_page = GSIZE_TO_POINTER (
-        (GPOINTER_TO_SIZE (address) + size - 1) & ~(page_size - 1));
+    GumScanFindFunc func = gum_scan_find_scalar;
+#if defined (HAVE_I386)
+    GumCpuFeatures features = gum_query_cpu_features ();
+
+    if ((features & GUM_CPU_AVX2) != 0)
+      func = gum_scan_find_avx2;
+    else if ((features & GUM_CPU_SSE2) != 0)
+      func = gum_scan_find_sse2;
+#elif defined (HAVE_SCAN_NEON)
+    func = gum_scan_find_neon;
+#endif
 
-    success = gum_code_segment_mark (start_page,
-        end_page - start_page + page_size, NULL);
+    g_once_init_leave (&cached_func, GPOINTER_TO_SIZE (func));
   }
-  else
+
+  return GSIZE_TO_POINTER (cached_func);
+}
+
+static const guint8 *
+gum_scan_find_scalar (const guint8 * haystack,
+                      gsize size,
+                      guint8 byte,
+                      guint8 mask)
+{
+  const guint8 * cur, * end;
+
+  if (mask == 0xff)
+    return memchr (haystack, byte, size);
+
+  for (cur = haystack, end = haystack + size; cur != end; cur++)
   {
-    success = gum_try_mprotect (address, size, GUM_PAGE_RX);
+    if ((*cur & mask) == byte)
+      return cur;
   }
 
-  gum_clear_cache (address, size);
+  return NULL;
+}
 
-  return success;
+#if defined (HAVE_I386)
+
+static guint
+gum_scan_count_trailing_zeros (guint32 value)
+{
+#ifdef _MSC_VER
+  unsigned long index;
+
+  _BitScanForward (&index, value);
+
+  return index;
+#else
+  return __builtin_ctz (value);
+#endif
 }
 
-void
-gum_memory_scan (const GumMemoryRange * range,
-                 const GumMatchPattern * pattern,
-                 GumMemoryScanMatchFunc func,
-                 gpointer user_data)
+GUM_SCAN_TARGET ("sse2")
+static const guint8 *
+gum_scan_find_sse2 (const guint8 * haystack,
+                    gsize size,
+                    guint8 byte,
+                    guint8 mask)
 {
-  GumMatchToken * needle;
-  guint8 * needle_data, * mask_data = NULL;
-  guint needle_len;
-  guint8 * cur, * end_address;
+  const guint8 * cur = haystack;
+  const guint8 * end = haystack + size;
+  __m128i needle, vmask;
 
-  needle = gum_match_pattern_get_longest_token (pattern, GUM_MATCH_EXACT);
-  if (needle == NULL)
+  needle = _mm_set1_epi8 ((char) byte);
+  vmask = _mm_set1_epi8 ((char) mask);
+
+  while (end - cur >= 16)
   {
-    needle = gum_match_pattern_get_longest_token (pattern, GUM_MATCH_MASK);
-    mask_data = (guint8 *) needle->masks->data;
+    __m128i chunk, eq;
+    guint32 bits;
+
+    chunk = _mm_loadu_si128 ((const __m128i *) cur);
+    eq = _mm_cmpeq_epi8 (_mm_and_si128 (chunk, vmask), needle);
+    bits = _mm_movemask_epi8 (eq);
+    if (bits != 0)
+      return cur + gum_scan_count_trailing_zeros (bits);
+
+    cur += 16;
   }
 
-  needle_data = (guint8 *) needle->bytes->data;
-  needle_len = needle->bytes->len;
+  return gum_scan_find_scalar (cur, end - cur, byte, mask);
+}
 
-  cur = GSIZE_TO_POINTER (range->base_address);
-  end_address = cur + range->size - (pattern->size - needle->offset) + 1;
+GUM_SCAN_TARGET ("avx2")
+static const guint8 *
+gum_scan_find_avx2 (const guint8 * haystack,
+                    gsize size,
+                    guint8 byte,
+                    guint8 mask)
+{
+  const guint8 * cur = haystack;
+  const guint8 * end = haystack + size;
+  __m256i needle, vmask;
+
+  needle = _mm256_set1_epi8 ((char) byte);
+  vmask = _mm256_set1_epi8 ((char) mask);
 
-  for (; cur < end_address; cur++)
+  while (end - cur >= 32)
   {
-    guint8 * start;
+    __m256i chunk, eq;
+    guint32 bits;
 
-    if (mask_data == NULL)
-    {
-      if (cur[0] != needle_data[0] ||
-          memcmp (cur, needle_data, needle_len) != 0)
-      {
-        continue;
-      }
-    }
-    else
+    chunk = _mm256_loadu_si256 ((const __m256i *) cur);
+    eq = _mm256_cmpeq_epi8 (_mm256_and_si256 (chunk, vmask), needle);
+    bits = _mm256_movemask_epi8 (eq);
+    if (bits != 0)
     {
-      if ((cur[0] & mask_data[0]) != (needle_data[0] & mask_data[0]) ||
-          gum_memcmp_mask ((guint8 *) cur, (guint8 *) needle_data,
-              (guint8 *) mask_data, needle_len) != 0)
-      {
-        continue;
-      }
+      _mm256_zeroupper ();
+      return cur + gum_scan_count_trailing_zeros (bits);
     }
 
-    start = cur - needle->offset;
+    cur += 32;
+  }
 
-    if (gum_match_pattern_try_match_on (pattern, start))
+  _mm256_zeroupper ();
+
+  return gum_scan_find_scalar (cur, end - cur, byte, mask);
+}
+
+#elif defined (HAVE_SCAN_NEON)
+
+static const guint8 *
+gum_scan_find_neon (const guint8 * haystack,
+                    gsize size,
+                    guint8 byte,
+                    guint8 mask)
+{
+  const guint8 * cur = haystack;
+  const guint8 * end = haystack + size;
+  uint8x16_t needle, vmask;
+
+  needle = vdupq_n_u8 (byte);
+  vmask = vdupq_n_u8 (mask);
+
+  while (end - cur >= 16)
+  {
+    uint8x16_t eq;
+    uint64_t bits;
+
+    eq = vceqq_u8 (vandq_u8 (vld1q_u8 (cur), vmask), needle);
+    bits = vget_lane_u64 (vreinterpret_u64_u8 (
+        vshrn_n_u16 (vreinterpretq_u16_u8 (eq), 4)), 0);
+    if (bits != 0)
     {
-      if (!func (GUM_ADDRESS (start), pattern->size, user_data))
-        return;
+#ifdef _MSC_VER
+      unsigned long index;
 
-      cur = start + pattern->size - 1;
+      _BitScanForward64 (&index, bits);
+
+      return cur + (index >> 2);
+#else
+      return cur + (__builtin_ctzll (bits) >> 2);
+#endif
     }
+
+    cur += 16;
   }
+
+  return gum_scan_find_scalar (cur, end - cur, byte, mask);
 }
 
+#endif
+
 GumMatchPattern *
 gum_match_pattern_new_from_string (const gchar * match_combined_str)
 {
@@ -514,6 +1846,8 @@ gum_match_pattern_new (void)
   pattern->tokens =
       g_ptr_array_new_with_free_func ((GDestroyNotify) gum_match_token_free);
   pattern->size = 0;
+  pattern->compiled_bytes = NULL;
+  pattern->compiled_masks = NULL;
 
   return pattern;
 }
@@ -521,6 +1855,9 @@ gum_match_pattern_new (void)
 void
 gum_match_pattern_free (GumMatchPattern * pattern)
 {
+  g_free (pattern->compiled_masks);
+  g_free (pattern->compiled_bytes);
+
   g_ptr_array_free (pattern->tokens, TRUE);
 
   g_slice_free (GumMatchPattern, pattern);
@@ -569,52 +1906,27 @@ gum_match_pattern_try_match_on (const GumMatchPattern * self,
                                 guint8 * bytes)
 {
   guint i;
-  gboolean no_masks = TRUE;
-
-  for (i = 0; i != self->tokens->len; i++)
-  {
-    GumMatchToken * token;
-
-    token = (GumMatchToken *) g_ptr_array_index (self->tokens, i);
-    if (token->type == GUM_MATCH_EXACT)
-    {
-      gchar * p;
-
-      p = (gchar *) bytes + token->offset;
-      if (p == token->bytes->data ||
-          memcmp (p, token->bytes->data, token->bytes->len) != 0)
-      {
-        return FALSE;
-      }
-    }
-    else if (token->type == GUM_MATCH_MASK)
-    {
-      no_masks = FALSE;
-    }
-  }
 
-  if (no_masks)
-    return TRUE;
+  if (bytes == self->compiled_bytes || bytes == self->compiled_masks)
+    return FALSE;
 
   for (i = 0; i != self->tokens->len; i++)
   {
     GumMatchToken * token;
 
     token = (GumMatchToken *) g_ptr_array_index (self->tokens, i);
-    if (token->type == GUM_MATCH_MASK)
+    if (token->type == GUM_MATCH_EXACT &&
+        (gchar *) bytes + token->offset == token->bytes->data)
     {
-      gchar * p;
-
-      p = (gchar *) bytes + token->offset;
-      if (gum_memcmp_mask ((guint8 *) p, (guint8 *) token->bytes->data,
-          (guint8 *) token->masks->data, token->masks->len) != 0)
-      {
-        return FALSE;
-      }
+      return FALSE;
     }
   }
 
-  return TRUE;
+  if (self->compiled_masks == NULL)
+    return memcmp (bytes, self->compiled_bytes, self->size) == 0;
+
+  return gum_memcmp_mask (bytes, self->compiled_bytes, self->compiled_masks,
+      self->size) == 0;
 }
 
 static gint
@@ -623,11 +1935,45 @@ gum_memcmp_mask (const guint8 * haystack,
                  const guint8 * mask,
                  guint len)
 {
-  guint i;
+  guint i = 0;
+
+#if defined (HAVE_I386)
+  if (len >= 16 && gum_scan_have_sse2 ())
+    i = gum_memcmp_mask_sse2 (haystack, needle, mask, len);
+#elif defined (HAVE_SCAN_NEON)
+  while (len - i >= 16)
+  {
+    uint8x16_t m, eq;
+    guint64 bits;
+
+    m = vld1q_u8 (mask + i);
+    eq = vceqq_u8 (vandq_u8 (vld1q_u8 (haystack + i), m),
+        vandq_u8 (vld1q_u8 (needle + i), m));
+    bits = vget_lane_u64 (vreinterpret_u64_u8 (
+        vshrn_n_u16 (vreinterpretq_u16_u8 (eq), 4)), 0);
+    if (bits != G_MAXUINT64)
+      break;
+
+    i += 16;
+  }
+#endif
+
+  while (len - i >= sizeof (gsize))
+  {
+    gsize hv, nv, mv;
 
-  for (i = 0; i != len; i++)
+    memcpy (&hv, haystack + i, sizeof (gsize));
+    memcpy (&nv, needle + i, sizeof (gsize));
+    memcpy (&mv, mask + i, sizeof (gsize));
+    if (((hv ^ nv) & mv) != 0)
+      break;
+
+    i += sizeof (gsize);
+  }
+
+  for (; i != len; i++)
   {
-    guint8 value = *(haystack++) & mask[i];
+    guint8 value = haystack[i] & mask[i];
     guint8 test_value = needle[i] & mask[i];
     if (value != test_value)
       return value - test_value;
@@ -636,6 +1982,56 @@ gum_memcmp_mask (const guint8 * haystack,
   return 0;
 }
 
+#if defined (HAVE_I386)
+
+/*
+ * Compares as many leading 16-byte blocks as match, and returns the
+ * offset of the first block containing a mismatch (or of the tail), for
+ * the scalar loops to pinpoint and order.
+ */
+GUM_SCAN_TARGET ("sse2")
+static guint
+gum_memcmp_mask_sse2 (const guint8 * haystack,
+                      const guint8 * needle,
+                      const guint8 * mask,
+                      guint len)
+{
+  guint i = 0;
+
+  while (len - i >= 16)
+  {
+    __m128i m, eq;
+
+    m = _mm_loadu_si128 ((const __m128i *) (mask + i));
+    eq = _mm_cmpeq_epi8 (
+        _mm_and_si128 (_mm_loadu_si128 ((const __m128i *) (haystack + i)), m),
+        _mm_and_si128 (_mm_loadu_si128 ((const __m128i *) (needle + i)), m));
+    if (_mm_movemask_epi8 (eq) != 0xffff)
+      break;
+
+    i += 16;
+  }
+
+  return i;
+}
+
+static gboolean
+gum_scan_have_sse2 (void)
+{
+  static gsize cached_result = 0;
+
+  if (g_once_init_enter (&cached_result))
+  {
+    gboolean have_it = (gum_query_cpu_features () & GUM_CPU_SSE2) != 0;
+
+    g_once_init_leave (&cached_result, have_it ? 2 : 1);
+  }
+
+  return cached_result == 2;
+}
+
+#endif
+
 static GumMatchToken *
 gum_match_pattern_push_token (GumMatchPattern * self,
                               GumMatchType type)
@@ -670,9 +2066,81 @@ gum_match_pattern_seal (GumMatchPattern * self)
   if (token->type == GUM_MATCH_WILDCARD)
     return FALSE;
 
+  gum_match_pattern_compile (self);
+
   return TRUE;
 }
 
+/*
+ * Walking the token list once per candidate is pure interpretation
+ * overhead, so fold the pattern's structure into a flat needle, and,
+ * when any byte is not matched verbatim, a companion mask covering the
+ * whole pattern. A candidate is then verified with a single
+ * SIMD-accelerated compare instead of one pass per token.
+ */
+static void
+gum_match_pattern_compile (GumMatchPattern * self)
+{
+  gboolean any_masked = FALSE;
+  guint i;
+
+  self->compiled_bytes = g_malloc0 (self->size);
+
+  for (i = 0; i != self->tokens->len; i++)
+  {
+    GumMatchToken * token;
+
+    token = (GumMatchToken *) g_ptr_array_index (self->tokens, i);
+    if (token->type == GUM_MATCH_EXACT)
+    {
+      memcpy (self->compiled_bytes + token->offset, token->bytes->data,
+          token->bytes->len);
+    }
+    else
+    {
+      any_masked = TRUE;
+    }
+  }
+
+  if (!any_masked)
+    return;
+
+  self->compiled_masks = g_malloc0 (self->size);
+
+  for (i = 0; i != self->tokens->len; i++)
+  {
+    GumMatchToken * token;
+
+    token = (GumMatchToken *) g_ptr_array_index (self->tokens, i);
+    switch (token->type)
+    {
+      case GUM_MATCH_EXACT:
+        memset (self->compiled_masks + token->offset, 0xff,
+            token->bytes->len);
+        break;
+      case GUM_MATCH_MASK:
+      {
+        guint8 * needle = self->compiled_bytes + token->offset;
+        const guint8 * bytes = (const guint8 *) token->bytes->data;
+        const guint8 * masks = (const guint8 *) token->masks->data;
+        guint j;
+
+        for (j = 0; j != token->bytes->len; j++)
+          needle[j] = bytes[j] & masks[j];
+
+        memcpy (self->compiled_masks + token->offset, masks,
+            token->masks->len);
+
+        break;
+      }
+      case GUM_MATCH_WILDCARD:
+        break;
+      default:
+        g_assert_not_reached ();
+    }
+  }
+}
+
 static GumMatchToken *
 gum_match_token_new (GumMatchType type)
 {
@@ -766,31 +2234,161 @@ gum_mprotect (gpointer address,
     g_abort ();
 }
 
+typedef struct _GumMemoryLayoutListener GumMemoryLayoutListener;
+
+struct _GumMemoryLayoutListener
+{
+  guint id;
+  GumMemoryLayoutChangedFunc func;
+  gpointer user_data;
+};
+
+static gint gum_memory_layout_generation = 0;
+static GSList * gum_memory_layout_listeners = NULL;
+static guint gum_memory_layout_next_listener_id = 1;
+G_LOCK_DEFINE_STATIC (gum_memory_layout_listeners);
+
+/*
+ * Bumped whenever we change the process' memory layout, so consumers that
+ * cache derived views of it, like the maps snapshot on Linux, know when
+ * to refresh. Long-lived caches can either poll the counter or register a
+ * listener and get told right away, which keeps them from re-validating on
+ * every query.
+ */
+
+guint
+_gum_memory_query_layout_generation (void)
+{
+  return g_atomic_int_get (&gum_memory_layout_generation);
+}
+
+void
+_gum_memory_bump_layout_generation (void)
+{
+  guint generation;
+  GSList * cur;
+
+  generation = g_atomic_int_add (&gum_memory_layout_generation, 1) + 1;
+
+  G_LOCK (gum_memory_layout_listeners);
+
+  for (cur = gum_memory_layout_listeners; cur != NULL; cur = cur->next)
+  {
+    GumMemoryLayoutListener * listener = cur->data;
+
+    listener->func (generation, listener->user_data);
+  }
+
+  G_UNLOCK (gum_memory_layout_listeners);
+}
+
+/*
+ * Listeners run on whatever thread mutated the layout, with the registry
+ * lock held, potentially deep inside our own allocators. They must
+ * therefore be cheap and reentrancy-safe; marking a cached view dirty is
+ * the intended use. Heavier reactions belong in the next query against
+ * that cache.
+ */
+
+guint
+_gum_memory_register_layout_listener (GumMemoryLayoutChangedFunc func,
+                                      gpointer user_data)
+{
+  GumMemoryLayoutListener * listener;
+  guint id;
+
+  listener = g_slice_new (GumMemoryLayoutListener);
+  listener->func = func;
+  listener->user_data = user_data;
+
+  G_LOCK (gum_memory_layout_listeners);
+
+  id = gum_memory_layout_next_listener_id++;
+  listener->id = id;
+  gum_memory_layout_listeners =
+      g_slist_prepend (gum_memory_layout_listeners, listener);
+
+  G_UNLOCK (gum_memory_layout_listeners);
+
+  return id;
+}
+
+void
+_gum_memory_unregister_layout_listener (guint id)
+{
+  GSList * cur;
+
+  G_LOCK (gum_memory_layout_listeners);
+
+  for (cur = gum_memory_layout_listeners; cur != NULL; cur = cur->next)
+  {
+    GumMemoryLayoutListener * listener = cur->data;
+
+    if (listener->id == id)
+    {
+      gum_memory_layout_listeners =
+          g_slist_remove (gum_memory_layout_listeners, listener);
+      g_slice_free (GumMemoryLayoutListener, listener);
+      break;
+    }
+  }
+
+  G_UNLOCK (gum_memory_layout_listeners);
+}
+
 guint
 gum_peek_private_memory_usage (void)
 {
   guint total = 0;
   struct mallinfo info;
+  guint i;
 
-  info = mspace_mallinfo (gum_mspace_main);
-  total += (guint) info.uordblks;
+  for (i = 0; i != GUM_HEAP_NUM_ARENAS; i++)
+  {
+    info = mspace_mallinfo (gum_mspaces_main[i]);
+    total += (guint) info.uordblks;
 
-  info = mspace_mallinfo (gum_mspace_internal);
-  total += (guint) info.uordblks;
+    info = mspace_mallinfo (gum_mspaces_internal[i]);
+    total += (guint) info.uordblks;
+  }
 
   return total;
 }
 
+/*
+ * Each thread is bound to one of the arenas on its first allocation,
+ * assigned round-robin, with the first arena doubling as the shared
+ * fallback for allocations made before the heap is initialized enough
+ * for binding to matter. Frees are routed by the chunk footer, so any
+ * arena's blocks may be released from any thread.
+ */
+static guint
+gum_heap_arena_index_for_current_thread (void)
+{
+  gpointer value;
+  guint index;
+
+  value = g_private_get (&gum_heap_arena_index_key);
+  if (value != NULL)
+    return GPOINTER_TO_UINT (value) - 1;
+
+  index = (guint) g_atomic_int_add (&gum_heap_arena_seq, 1) %
+      GUM_HEAP_NUM_ARENAS;
+  g_private_set (&gum_heap_arena_index_key, GUINT_TO_POINTER (index + 1));
+
+  return index;
+}
+
 gpointer
 gum_malloc (gsize size)
 {
-  return mspace_malloc (gum_mspace_main, size);
+  return mspace_malloc (GUM_MSPACE_MAIN, size);
 }
 
 gpointer
 gum_malloc0 (gsize size)
 {
-  return mspace_calloc (gum_mspace_main, 1, size);
+  return mspace_calloc (GUM_MSPACE_MAIN, 1, size);
 }
 
 gsize
@@ -803,21 +2401,21 @@ gpointer
 gum_calloc (gsize count,
             gsize size)
 {
-  return mspace_calloc (gum_mspace_main, count, size);
+  return mspace_calloc (GUM_MSPACE_MAIN, count, size);
 }
 
 gpointer
 gum_realloc (gpointer mem,
              gsize size)
 {
-  return mspace_realloc (gum_mspace_main, mem, size);
+  return mspace_realloc (GUM_MSPACE_MAIN, mem, size);
 }
 
 gpointer
 gum_memalign (gsize alignment,
               gsize size)
 {
-  return mspace_memalign (gum_mspace_main, alignment, size);
+  return mspace_memalign (GUM_MSPACE_MAIN, alignment, size);
 }
 
 gpointer
@@ -826,7 +2424,7 @@ gum_memdup (gconstpointer mem,
 {
   gpointer result;
 
-  result = mspace_malloc (gum_mspace_main, byte_size);
+  result = mspace_malloc (GUM_MSPACE_MAIN, byte_size);
   memcpy (result, mem, byte_size);
 
   return result;
@@ -835,33 +2433,33 @@ gum_memdup (gconstpointer mem,
 void
 gum_free (gpointer mem)
 {
-  mspace_free (gum_mspace_main, mem);
+  mspace_free (GUM_MSPACE_MAIN, mem);
 }
 
 gpointer
 gum_internal_malloc (size_t size)
 {
-  return mspace_malloc (gum_mspace_internal, size);
+  return mspace_malloc (GUM_MSPACE_INTERNAL, size);
 }
 
 gpointer
 gum_internal_calloc (size_t count,
                      size_t size)
 {
-  return mspace_calloc (gum_mspace_internal, count, size);
+  return mspace_calloc (GUM_MSPACE_INTERNAL, count, size);
 }
 
 gpointer
 gum_internal_realloc (gpointer mem,
                       size_t size)
 {
-  return mspace_realloc (gum_mspace_internal, mem, size);
+  return mspace_realloc (GUM_MSPACE_INTERNAL, mem, size);
 }
 
 void
 gum_internal_free (gpointer mem)
 {
-  mspace_free (gum_mspace_internal, mem);
+  mspace_free (GUM_MSPACE_INTERNAL, mem);
 }
 
 gpointer
@@ -28,7 +28,12 @@ typedef guint GumMemoryOperation;
 typedef guint GumPageProtection;
 typedef struct _GumAddressSpec GumAddressSpec;
 typedef struct _GumMemoryRange GumMemoryRange;
+typedef struct _GumCodePatch GumCodePatch;
 typedef struct _GumMatchPattern GumMatchPattern;
+typedef struct _GumMatchPatternSet GumMatchPatternSet;
+typedef struct _GumMemoryScanSession GumMemoryScanSession;
+typedef struct _GumScanSnapshot GumScanSnapshot;
+typedef guint GumScanPredicate;
 
 typedef gboolean (* GumMemoryIsNearFunc) (gpointer memory, gpointer address);
 
@@ -62,6 +67,14 @@ enum _GumPageProtection
   GUM_PAGE_EXECUTE   = (1 << 2),
 };
 
+enum _GumScanPredicate
+{
+  GUM_SCAN_CHANGED,
+  GUM_SCAN_UNCHANGED,
+  GUM_SCAN_INCREASED,
+  GUM_SCAN_DECREASED
+};
+
 struct _GumAddressSpec
 {
   gpointer near_address;
@@ -74,9 +87,18 @@ struct _GumMemoryRange
   gsize size;
 };
 
+struct _GumCodePatch
+{
+  gpointer address;
+  const guint8 * bytes;
+  gsize size;
+};
+
 typedef void (* GumMemoryPatchApplyFunc) (gpointer mem, gpointer user_data);
 typedef gboolean (* GumMemoryScanMatchFunc) (GumAddress address, gsize size,
     gpointer user_data);
+typedef gboolean (* GumMemoryScanSetMatchFunc) (guint pattern_index,
+    GumAddress address, gsize size, gpointer user_data);
 
 GUM_API void gum_internal_heap_ref (void);
 GUM_API void gum_internal_heap_unref (void);
@@ -90,30 +112,70 @@ GUM_API guint gum_query_page_size (void);
 GUM_API gboolean gum_query_is_rwx_supported (void);
 GUM_API GumRwxSupport gum_query_rwx_support (void);
 GUM_API gboolean gum_memory_is_readable (gconstpointer address, gsize len);
+GUM_API gboolean gum_memory_is_writable (gconstpointer address, gsize len);
 GUM_API guint8 * gum_memory_read (gconstpointer address, gsize len,
     gsize * n_bytes_read);
 GUM_API gboolean gum_memory_write (gpointer address, const guint8 * bytes,
     gsize len);
 GUM_API gboolean gum_memory_patch_code (gpointer address, gsize size,
     GumMemoryPatchApplyFunc apply, gpointer apply_data);
+GUM_API gboolean gum_memory_patch_code_batch (const GumCodePatch * patches,
+    guint n_patches);
 GUM_API gboolean gum_memory_mark_code (gpointer address, gsize size);
 
 GUM_API void gum_memory_scan (const GumMemoryRange * range,
     const GumMatchPattern * pattern, GumMemoryScanMatchFunc func,
     gpointer user_data);
+GUM_API void gum_memory_scan_ranges (const GumMemoryRange * ranges,
+    guint n_ranges, const GumMatchPattern * pattern,
+    GumMemoryScanMatchFunc func, gpointer user_data);
 
 GUM_API GumMatchPattern * gum_match_pattern_new_from_string (
     const gchar * match_combined_str);
 GUM_API void gum_match_pattern_free (GumMatchPattern * pattern);
 
+GUM_API GumMatchPatternSet * gum_match_pattern_set_new (void);
+GUM_API guint gum_match_pattern_set_add (GumMatchPatternSet * self,
+    GumMatchPattern * pattern);
+GUM_API void gum_match_pattern_set_free (GumMatchPatternSet * set);
+
+GUM_API void gum_memory_scan_set (const GumMemoryRange * range,
+    GumMatchPatternSet * set, GumMemoryScanSetMatchFunc func,
+    gpointer user_data);
+
+GUM_API GumMemoryScanSession * gum_memory_scan_session_new (
+    const GumMemoryRange * range, const GumMatchPattern * pattern,
+    GumMemoryScanMatchFunc func, gpointer user_data);
+GUM_API gboolean gum_memory_scan_session_step (GumMemoryScanSession * self,
+    gsize max_bytes);
+GUM_API void gum_memory_scan_session_cancel (GumMemoryScanSession * self);
+GUM_API gdouble gum_memory_scan_session_get_progress (
+    GumMemoryScanSession * self);
+GUM_API void gum_memory_scan_session_free (GumMemoryScanSession * self);
+
+GUM_API GumScanSnapshot * gum_scan_snapshot_capture (
+    const GumMemoryRange * range, const GumMatchPattern * pattern,
+    gsize value_size);
+GUM_API guint gum_scan_snapshot_rescan (GumScanSnapshot * self,
+    GumScanPredicate predicate);
+GUM_API guint gum_scan_snapshot_get_size (GumScanSnapshot * self);
+GUM_API void gum_scan_snapshot_enumerate (GumScanSnapshot * self,
+    GumMemoryScanMatchFunc func, gpointer user_data);
+GUM_API void gum_scan_snapshot_free (GumScanSnapshot * self);
+
 GUM_API void gum_ensure_code_readable (gconstpointer address, gsize size);
 
 GUM_API void gum_mprotect (gpointer address, gsize size,
     GumPageProtection page_prot);
 GUM_API gboolean gum_try_mprotect (gpointer address, gsize size,
     GumPageProtection page_prot);
+GUM_API gboolean gum_try_mprotect_batch (const GumMemoryRange * ranges,
+    guint n_ranges, GumPageProtection page_prot);
 
 GUM_API void gum_clear_cache (gpointer address, gsize size);
+GUM_API void gum_clear_cache_begin_batch (void);
+GUM_API void gum_clear_cache_schedule (gpointer address, gsize size);
+GUM_API void gum_clear_cache_commit_batch (void);
 
 #define gum_new(struct_type, n_structs) \
     ((struct_type *) gum_malloc (n_structs * sizeof (struct_type)))
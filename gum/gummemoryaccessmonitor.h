@@ -39,6 +39,9 @@ GUM_API GumMemoryAccessMonitor * gum_memory_access_monitor_new (
     GumMemoryAccessNotify func, gpointer data,
     GDestroyNotify data_destroy);
 
+GUM_API void gum_memory_access_monitor_set_needs_from (
+    GumMemoryAccessMonitor * self, gboolean needs_from);
+
 GUM_API gboolean gum_memory_access_monitor_enable (
     GumMemoryAccessMonitor * self, GError ** error);
 GUM_API void gum_memory_access_monitor_disable (GumMemoryAccessMonitor * self);
@@ -6,8 +6,13 @@
 
 #include "gummemorymap.h"
 
+#include "gummemory-priv.h"
 #include "gumprocess-priv.h"
 
+#include <string.h>
+
+#define GUM_MEMORY_MAP_FILTER_SIZE 2048
+
 typedef struct _GumUpdateMemoryRangesContext GumUpdateMemoryRangesContext;
 
 struct _GumMemoryMap
@@ -18,6 +23,20 @@ struct _GumMemoryMap
   GArray * ranges;
   gsize ranges_min;
   gsize ranges_max;
+  gsize page_size;
+
+  gboolean has_dl_generation;
+  guint64 dl_generation;
+  guint layout_listener;
+  gint layout_dirty;
+
+  /*
+   * One-hash Bloom filter over page numbers, rebuilt on every update: a
+   * clear bit proves no range covers any page hashing to it, so the
+   * backtracers' per-stack-word queries usually resolve with a couple of
+   * L1-resident bit probes instead of a range search.
+   */
+  guint8 filter[GUM_MEMORY_MAP_FILTER_SIZE];
 };
 
 struct _GumUpdateMemoryRangesContext
@@ -28,6 +47,12 @@ struct _GumUpdateMemoryRangesContext
 
 static void gum_memory_map_finalize (GObject * object);
 
+static void gum_memory_map_on_layout_changed (guint generation,
+    gpointer user_data);
+static gboolean gum_memory_map_filter_may_contain (GumMemoryMap * self,
+    GumAddress start, GumAddress end);
+static void gum_memory_map_filter_add_range (GumMemoryMap * self,
+    const GumMemoryRange * range);
 static gboolean gum_memory_map_add_range (const GumRangeDetails * details,
     gpointer user_data);
 
@@ -45,6 +70,11 @@ static void
 gum_memory_map_init (GumMemoryMap * self)
 {
   self->ranges = g_array_new (FALSE, FALSE, sizeof (GumMemoryRange));
+  self->page_size = gum_query_page_size ();
+
+  self->layout_listener = _gum_memory_register_layout_listener (
+      gum_memory_map_on_layout_changed, self);
+  self->layout_dirty = TRUE;
 }
 
 static void
@@ -52,11 +82,22 @@ gum_memory_map_finalize (GObject * object)
 {
   GumMemoryMap * self = GUM_MEMORY_MAP (object);
 
+  _gum_memory_unregister_layout_listener (self->layout_listener);
+
   g_array_free (self->ranges, TRUE);
 
   G_OBJECT_CLASS (gum_memory_map_parent_class)->finalize (object);
 }
 
+static void
+gum_memory_map_on_layout_changed (guint generation,
+                                  gpointer user_data)
+{
+  GumMemoryMap * self = user_data;
+
+  g_atomic_int_set (&self->layout_dirty, TRUE);
+}
+
 GumMemoryMap *
 gum_memory_map_new (GumPageProtection prot)
 {
@@ -76,27 +117,127 @@ gum_memory_map_contains (GumMemoryMap * self,
 {
   const GumAddress start = range->base_address;
   const GumAddress end = range->base_address + range->size;
-  guint i;
+  GumMemoryRange * r;
+  guint lower, upper;
 
   if (start < self->ranges_min)
     return FALSE;
   else if (end > self->ranges_max)
     return FALSE;
 
-  for (i = 0; i < self->ranges->len; i++)
+  if (!gum_memory_map_filter_may_contain (self, start, end))
+    return FALSE;
+
+  lower = 0;
+  upper = self->ranges->len;
+  while (lower != upper)
   {
-    GumMemoryRange * r = &g_array_index (self->ranges, GumMemoryRange, i);
-    if (start >= r->base_address && end <= r->base_address + r->size)
-      return TRUE;
+    guint middle = (lower + upper) / 2;
+
+    r = &g_array_index (self->ranges, GumMemoryRange, middle);
+    if (r->base_address > start)
+      upper = middle;
+    else
+      lower = middle + 1;
   }
 
-  return FALSE;
+  if (lower == 0)
+    return FALSE;
+
+  r = &g_array_index (self->ranges, GumMemoryRange, lower - 1);
+
+  return start >= r->base_address && end <= r->base_address + r->size;
+}
+
+/*
+ * Batch variant for callers probing many ranges at once: the map is
+ * refreshed at most once up front instead of per query, and the individual
+ * lookups then run against the flattened sorted array like
+ * gum_memory_map_contains().
+ */
+gboolean
+gum_memory_map_contains_all (GumMemoryMap * self,
+                             const GumMemoryRange * ranges,
+                             guint n_ranges)
+{
+  guint i;
+
+  gum_memory_map_update_if_stale (self);
+
+  for (i = 0; i != n_ranges; i++)
+  {
+    if (!gum_memory_map_contains (self, &ranges[i]))
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+/*
+ * The returned array is sorted by base address and stays valid until the
+ * next gum_memory_map_update().
+ */
+const GumMemoryRange *
+gum_memory_map_get_ranges (GumMemoryMap * self,
+                           guint * n_ranges)
+{
+  *n_ranges = self->ranges->len;
+
+  return (const GumMemoryRange *) self->ranges->data;
+}
+
+static gboolean
+gum_memory_map_filter_may_contain (GumMemoryMap * self,
+                                   GumAddress start,
+                                   GumAddress end)
+{
+  const guint n_bits = GUM_MEMORY_MAP_FILTER_SIZE * 8;
+  gsize first, last, page;
+
+  first = start / self->page_size;
+  last = (end - 1) / self->page_size;
+
+  for (page = first; page <= last; page++)
+  {
+    guint bit = page & (n_bits - 1);
+
+    if ((self->filter[bit >> 3] & (1 << (bit & 7))) == 0)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+static void
+gum_memory_map_filter_add_range (GumMemoryMap * self,
+                                 const GumMemoryRange * range)
+{
+  const guint n_bits = GUM_MEMORY_MAP_FILTER_SIZE * 8;
+  gsize first, n, i;
+
+  first = range->base_address / self->page_size;
+
+  n = (range->size + self->page_size - 1) / self->page_size;
+  if (n > n_bits)
+    n = n_bits;
+
+  for (i = 0; i != n; i++)
+  {
+    guint bit = (first + i) & (n_bits - 1);
+
+    self->filter[bit >> 3] |= 1 << (bit & 7);
+  }
 }
 
 void
 gum_memory_map_update (GumMemoryMap * self)
 {
   GumUpdateMemoryRangesContext ctx;
+  guint i;
+
+  self->has_dl_generation =
+      _gum_process_try_query_module_generation (&self->dl_generation);
+  g_atomic_int_set (&self->layout_dirty, FALSE);
 
   ctx.ranges = self->ranges;
   ctx.prev_range_index = -1;
@@ -106,6 +247,13 @@ gum_memory_map_update (GumMemoryMap * self)
   _gum_process_enumerate_ranges (self->protection, gum_memory_map_add_range,
       &ctx);
 
+  memset (self->filter, 0, sizeof (self->filter));
+  for (i = 0; i != self->ranges->len; i++)
+  {
+    gum_memory_map_filter_add_range (self,
+        &g_array_index (self->ranges, GumMemoryRange, i));
+  }
+
   if (self->ranges->len > 0)
   {
     GumMemoryRange * first_range, * last_range;
@@ -124,6 +272,32 @@ gum_memory_map_update (GumMemoryMap * self)
   }
 }
 
+/*
+ * Rebuilds only when the loader's module generation has moved, or our own
+ * layout listener has flagged the map dirty, since the last build, so
+ * callers can refresh eagerly before a burst of queries without paying
+ * for an enumeration each time. Mappings made behind our back without the
+ * loader's involvement are not detected, same as for a plain stale map.
+ */
+void
+gum_memory_map_update_if_stale (GumMemoryMap * self)
+{
+  guint64 dl_generation = 0;
+  gboolean has_dl_generation;
+
+  has_dl_generation =
+      _gum_process_try_query_module_generation (&dl_generation);
+
+  if (has_dl_generation == self->has_dl_generation &&
+      (!has_dl_generation || dl_generation == self->dl_generation) &&
+      !g_atomic_int_get (&self->layout_dirty))
+  {
+    return;
+  }
+
+  gum_memory_map_update (self);
+}
+
 static gboolean
 gum_memory_map_add_range (const GumRangeDetails * details,
                           gpointer user_data)
@@ -19,8 +19,14 @@ GUM_API GumMemoryMap * gum_memory_map_new (GumPageProtection prot);
 
 GUM_API gboolean gum_memory_map_contains (GumMemoryMap * self,
     const GumMemoryRange * range);
+GUM_API gboolean gum_memory_map_contains_all (GumMemoryMap * self,
+    const GumMemoryRange * ranges, guint n_ranges);
+
+GUM_API const GumMemoryRange * gum_memory_map_get_ranges (GumMemoryMap * self,
+    guint * n_ranges);
 
 GUM_API void gum_memory_map_update (GumMemoryMap * self);
+GUM_API void gum_memory_map_update_if_stale (GumMemoryMap * self);
 
 G_END_DECLS
 
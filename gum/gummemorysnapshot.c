@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2020 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#include "gummemorysnapshot.h"
+
+#include <string.h>
+#ifdef HAVE_LINUX
+# include <signal.h>
+# include <sys/uio.h>
+# include <sys/wait.h>
+# include <unistd.h>
+#endif
+
+/*
+ * Point-in-time view of selected memory ranges that reads and scans can
+ * run against while the process keeps mutating.
+ *
+ * On Linux the capture is a fork(): the kernel's copy-on-write machinery
+ * makes the child a snapshot of the entire address space for the cost of
+ * duplicating page tables, and the parent reads from it on demand with
+ * process_vm_readv(). The child parks itself in pause() and never runs
+ * any user code. Everywhere else the selected ranges are copied eagerly
+ * at capture time, which is still coherent but costs a memcpy of the
+ * snapshotted ranges up front.
+ */
+
+struct _GumMemorySnapshot
+{
+  GumMemoryRange * ranges;
+  guint n_ranges;
+
+#ifdef HAVE_LINUX
+  pid_t child;
+#else
+  guint8 ** copies;
+#endif
+};
+
+static gssize gum_memory_snapshot_resolve (GumMemorySnapshot * self,
+    GumAddress address, gsize size);
+
+GumMemorySnapshot *
+gum_memory_snapshot_capture (const GumMemoryRange * ranges,
+                             guint n_ranges)
+{
+  GumMemorySnapshot * snapshot;
+
+  snapshot = g_slice_new0 (GumMemorySnapshot);
+  snapshot->ranges = g_memdup (ranges, n_ranges * sizeof (GumMemoryRange));
+  snapshot->n_ranges = n_ranges;
+
+#ifdef HAVE_LINUX
+  snapshot->child = fork ();
+  if (snapshot->child == 0)
+  {
+    while (TRUE)
+      pause ();
+  }
+  if (snapshot->child == -1)
+  {
+    g_free (snapshot->ranges);
+    g_slice_free (GumMemorySnapshot, snapshot);
+    return NULL;
+  }
+#else
+  {
+    guint i;
+
+    snapshot->copies = g_new (guint8 *, n_ranges);
+    for (i = 0; i != n_ranges; i++)
+    {
+      snapshot->copies[i] = g_memdup (
+          GSIZE_TO_POINTER (ranges[i].base_address), ranges[i].size);
+    }
+  }
+#endif
+
+  return snapshot;
+}
+
+/*
+ * Maps an address in the snapshotted process image to the index of the
+ * containing range, or -1 if [address, address + size) is not fully
+ * inside any captured range.
+ */
+static gssize
+gum_memory_snapshot_resolve (GumMemorySnapshot * self,
+                             GumAddress address,
+                             gsize size)
+{
+  guint i;
+
+  for (i = 0; i != self->n_ranges; i++)
+  {
+    const GumMemoryRange * r = &self->ranges[i];
+
+    if (address >= r->base_address &&
+        address + size <= r->base_address + r->size)
+    {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+gboolean
+gum_memory_snapshot_read (GumMemorySnapshot * self,
+                          GumAddress address,
+                          gsize size,
+                          gpointer buffer)
+{
+  gssize range_index;
+
+  range_index = gum_memory_snapshot_resolve (self, address, size);
+  if (range_index == -1)
+    return FALSE;
+
+#ifdef HAVE_LINUX
+  {
+    struct iovec local, remote;
+
+    local.iov_base = buffer;
+    local.iov_len = size;
+    remote.iov_base = GSIZE_TO_POINTER (address);
+    remote.iov_len = size;
+
+    return process_vm_readv (self->child, &local, 1, &remote, 1, 0) ==
+        (gssize) size;
+  }
+#else
+  {
+    const GumMemoryRange * r = &self->ranges[range_index];
+
+    memcpy (buffer, self->copies[range_index] +
+        (address - r->base_address), size);
+
+    return TRUE;
+  }
+#endif
+}
+
+typedef struct _GumMemorySnapshotScanContext GumMemorySnapshotScanContext;
+
+struct _GumMemorySnapshotScanContext
+{
+  GumAddress base_address;
+  const guint8 * buffer;
+  GumMemoryScanMatchFunc func;
+  gpointer user_data;
+};
+
+static gboolean
+gum_memory_snapshot_emit_match (GumAddress address,
+                                gsize size,
+                                gpointer user_data)
+{
+  GumMemorySnapshotScanContext * ctx = user_data;
+
+  return ctx->func (
+      ctx->base_address + (address - GUM_ADDRESS (ctx->buffer)), size,
+      ctx->user_data);
+}
+
+void
+gum_memory_snapshot_scan (GumMemorySnapshot * self,
+                          const GumMemoryRange * range,
+                          const GumMatchPattern * pattern,
+                          GumMemoryScanMatchFunc func,
+                          gpointer user_data)
+{
+  guint8 * buffer;
+  GumMemoryRange view;
+  GumMemorySnapshotScanContext ctx;
+
+  buffer = g_malloc (range->size);
+  if (!gum_memory_snapshot_read (self, range->base_address, range->size,
+      buffer))
+  {
+    g_free (buffer);
+    return;
+  }
+
+  view.base_address = GUM_ADDRESS (buffer);
+  view.size = range->size;
+
+  ctx.base_address = range->base_address;
+  ctx.buffer = buffer;
+  ctx.func = func;
+  ctx.user_data = user_data;
+
+  gum_memory_scan (&view, pattern, gum_memory_snapshot_emit_match, &ctx);
+
+  g_free (buffer);
+}
+
+void
+gum_memory_snapshot_free (GumMemorySnapshot * self)
+{
+#ifdef HAVE_LINUX
+  kill (self->child, SIGKILL);
+  waitpid (self->child, NULL, 0);
+#else
+  {
+    guint i;
+
+    for (i = 0; i != self->n_ranges; i++)
+      g_free (self->copies[i]);
+    g_free (self->copies);
+  }
+#endif
+
+  g_free (self->ranges);
+
+  g_slice_free (GumMemorySnapshot, self);
+}
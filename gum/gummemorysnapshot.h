@@ -0,0 +1,27 @@
+/*
+ * Copyright (C) 2020 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#ifndef __GUM_MEMORY_SNAPSHOT_H__
+#define __GUM_MEMORY_SNAPSHOT_H__
+
+#include <gum/gummemory.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GumMemorySnapshot GumMemorySnapshot;
+
+GUM_API GumMemorySnapshot * gum_memory_snapshot_capture (
+    const GumMemoryRange * ranges, guint n_ranges);
+GUM_API gboolean gum_memory_snapshot_read (GumMemorySnapshot * self,
+    GumAddress address, gsize size, gpointer buffer);
+GUM_API void gum_memory_snapshot_scan (GumMemorySnapshot * self,
+    const GumMemoryRange * range, const GumMatchPattern * pattern,
+    GumMemoryScanMatchFunc func, gpointer user_data);
+GUM_API void gum_memory_snapshot_free (GumMemorySnapshot * self);
+
+G_END_DECLS
+
+#endif
@@ -202,6 +202,54 @@ gum_metal_hash_table_lookup_node (GumMetalHashTable    *hash_table,
   return node_index;
 }
 
+/*
+ * Read-only counterpart of lookup_node: probes without the tombstone
+ * bookkeeping, which only matters when the result is used as an insertion
+ * slot. Lookups dominate in our hot users (gumcloak, the interceptor's
+ * thread registry), so they get the leaner loop.
+ */
+static inline guint
+gum_metal_hash_table_find_node (GumMetalHashTable    *hash_table,
+                        gconstpointer  key)
+{
+  guint node_index;
+  guint node_hash;
+  guint hash_value;
+  guint step = 0;
+
+  hash_value = hash_table->hash_func (key);
+  if (G_UNLIKELY (!HASH_IS_REAL (hash_value)))
+    hash_value = 2;
+
+  node_index = hash_value % hash_table->mod;
+  node_hash = hash_table->hashes[node_index];
+
+  while (!HASH_IS_UNUSED (node_hash))
+    {
+      if (node_hash == hash_value)
+        {
+          gpointer node_key = hash_table->keys[node_index];
+
+          if (hash_table->key_equal_func)
+            {
+              if (hash_table->key_equal_func (node_key, key))
+                return node_index;
+            }
+          else if (node_key == key)
+            {
+              return node_index;
+            }
+        }
+
+      step++;
+      node_index += step;
+      node_index &= hash_table->mask;
+      node_hash = hash_table->hashes[node_index];
+    }
+
+  return node_index;
+}
+
 static void
 gum_metal_hash_table_remove_node (GumMetalHashTable   *hash_table,
                           gint          i,
@@ -574,11 +622,10 @@ gum_metal_hash_table_lookup (GumMetalHashTable    *hash_table,
                      gconstpointer  key)
 {
   guint node_index;
-  guint node_hash;
 
   g_return_val_if_fail (hash_table != NULL, NULL);
 
-  node_index = gum_metal_hash_table_lookup_node (hash_table, key, &node_hash);
+  node_index = gum_metal_hash_table_find_node (hash_table, key);
 
   return HASH_IS_REAL (hash_table->hashes[node_index])
     ? hash_table->values[node_index]
@@ -592,11 +639,10 @@ gum_metal_hash_table_lookup_extended (GumMetalHashTable    *hash_table,
                               gpointer      *value)
 {
   guint node_index;
-  guint node_hash;
 
   g_return_val_if_fail (hash_table != NULL, FALSE);
 
-  node_index = gum_metal_hash_table_lookup_node (hash_table, lookup_key, &node_hash);
+  node_index = gum_metal_hash_table_find_node (hash_table, lookup_key);
 
   if (!HASH_IS_REAL (hash_table->hashes[node_index]))
     return FALSE;
@@ -654,11 +700,10 @@ gum_metal_hash_table_contains (GumMetalHashTable    *hash_table,
                        gconstpointer  key)
 {
   guint node_index;
-  guint node_hash;
 
   g_return_val_if_fail (hash_table != NULL, FALSE);
 
-  node_index = gum_metal_hash_table_lookup_node (hash_table, key, &node_hash);
+  node_index = gum_metal_hash_table_find_node (hash_table, key);
 
   return HASH_IS_REAL (hash_table->hashes[node_index]);
 }
@@ -8,11 +8,15 @@
 #include "gummoduleapiresolver.h"
 
 #include "gumprocess.h"
+#include "gumprocess-priv.h"
 
 #include <gio/gio.h>
+#include <string.h>
 
 typedef struct _GumModuleMetadata GumModuleMetadata;
 typedef struct _GumFunctionMetadata GumFunctionMetadata;
+typedef struct _GumCollectFunctionsOperation GumCollectFunctionsOperation;
+typedef struct _GumCollectModulesOperation GumCollectModulesOperation;
 
 struct _GumModuleApiResolver
 {
@@ -21,6 +25,8 @@ struct _GumModuleApiResolver
   GRegex * query_pattern;
 
   GHashTable * module_by_name;
+  guint64 generation;
+  gboolean has_generation;
 };
 
 struct _GumModuleMetadata
@@ -29,16 +35,32 @@ struct _GumModuleMetadata
 
   gchar * name;
   gchar * path;
+  GumAddress base_address;
 
   GHashTable * import_by_name;
   GHashTable * export_by_name;
+  GumExportTable * export_table;
+  GStringChunk * names;
 };
 
 struct _GumFunctionMetadata
 {
-  gchar * name;
+  const gchar * name;
+  const gchar * name_lowered;
   GumAddress address;
-  gchar * module;
+  const gchar * module;
+};
+
+struct _GumCollectFunctionsOperation
+{
+  GHashTable * table;
+  GStringChunk * names;
+};
+
+struct _GumCollectModulesOperation
+{
+  GHashTable * current;
+  GHashTable * previous;
 };
 
 static void gum_module_api_resolver_iface_init (gpointer g_iface,
@@ -48,20 +70,23 @@ static void gum_module_api_resolver_enumerate_matches (
     GumApiResolver * resolver, const gchar * query, GumFoundApiFunc func,
     gpointer user_data, GError ** error);
 
-static GHashTable * gum_module_api_resolver_create_snapshot (void);
+static void gum_module_api_resolver_maybe_refresh (
+    GumModuleApiResolver * self);
+static GHashTable * gum_module_api_resolver_create_snapshot (
+    GHashTable * previous);
 static gboolean gum_module_api_resolver_collect_module (
     const GumModuleDetails * details, gpointer user_data);
 
 static void gum_module_metadata_unref (GumModuleMetadata * module);
+static GStringChunk * gum_module_metadata_get_names (GumModuleMetadata * self);
 static GHashTable * gum_module_metadata_get_imports (GumModuleMetadata * self);
 static GHashTable * gum_module_metadata_get_exports (GumModuleMetadata * self);
 static gboolean gum_module_metadata_collect_import (
     const GumImportDetails * details, gpointer user_data);
-static gboolean gum_module_metadata_collect_export (
-    const GumExportDetails * details, gpointer user_data);
 
-static GumFunctionMetadata * gum_function_metadata_new (const gchar * name,
-    GumAddress address, const gchar * module);
+static GumFunctionMetadata * gum_function_metadata_new (
+    GumCollectFunctionsOperation * op, const gchar * name, GumAddress address,
+    const gchar * module);
 static void gum_function_metadata_free (GumFunctionMetadata * function);
 
 G_DEFINE_TYPE_EXTENDED (GumModuleApiResolver,
@@ -94,7 +119,10 @@ gum_module_api_resolver_init (GumModuleApiResolver * self)
   self->query_pattern =
       g_regex_new ("(imports|exports):(.+)!([^\\n\\r\\/]+)(\\/i)?", 0, 0, NULL);
 
-  self->module_by_name = gum_module_api_resolver_create_snapshot ();
+  self->has_generation =
+      _gum_process_try_query_module_generation (&self->generation);
+
+  self->module_by_name = gum_module_api_resolver_create_snapshot (NULL);
 }
 
 static void
@@ -127,12 +155,15 @@ gum_module_api_resolver_enumerate_matches (GumApiResolver * resolver,
   gboolean ignore_case;
   gchar * collection, * module_query, * function_query;
   gboolean no_wildcards_in_function_query;
+  gsize function_query_prefix_len;
   GPatternSpec * module_spec, * function_spec;
   GHashTableIter module_iter;
   GHashTable * seen_modules;
   gboolean carry_on;
   GumModuleMetadata * module;
 
+  gum_module_api_resolver_maybe_refresh (self);
+
   g_regex_match (self->query_pattern, query, 0, &query_info);
   if (!g_match_info_matches (query_info))
     goto invalid_query;
@@ -163,6 +194,13 @@ gum_module_api_resolver_enumerate_matches (GumApiResolver * resolver,
       strchr (function_query, '*') == NULL &&
       strchr (function_query, '?') == NULL;
 
+  /*
+   * Any match must start with the literal portion preceding the first
+   * wildcard, which lets us reject most names with a plain byte comparison
+   * instead of a full pattern match.
+   */
+  function_query_prefix_len = strcspn (function_query, "*?");
+
   module_spec = g_pattern_spec_new (module_query);
   function_spec = g_pattern_spec_new (function_query);
 
@@ -226,13 +264,31 @@ gum_module_api_resolver_enumerate_matches (GumApiResolver * resolver,
       while (carry_on &&
           g_hash_table_iter_next (&function_iter, NULL, (gpointer *) &function))
       {
-        const gchar * function_name = function->name;
-        gchar * function_name_copy = NULL;
+        const gchar * function_name;
 
         if (ignore_case)
         {
-          function_name_copy = g_utf8_strdown (function_name, -1);
-          function_name = function_name_copy;
+          if (function->name_lowered == NULL)
+          {
+            gchar * lowered;
+
+            lowered = g_utf8_strdown (function->name, -1);
+            function->name_lowered = g_string_chunk_insert (
+                gum_module_metadata_get_names (module), lowered);
+            g_free (lowered);
+          }
+
+          function_name = function->name_lowered;
+        }
+        else
+        {
+          function_name = function->name;
+        }
+
+        if (strncmp (function_name, function_query,
+            function_query_prefix_len) != 0)
+        {
+          continue;
         }
 
         if (g_pattern_match_string (function_spec, function_name))
@@ -250,8 +306,6 @@ gum_module_api_resolver_enumerate_matches (GumApiResolver * resolver,
 
           g_free ((gpointer) details.name);
         }
-
-        g_free (function_name_copy);
       }
     }
 
@@ -278,36 +332,84 @@ invalid_query:
   }
 }
 
+/*
+ * When the loader exposes a generation counter, a long-lived resolver can
+ * detect module load/unload and resync. Modules still present at the same
+ * base keep their cached import/export tables, so a refresh only pays for
+ * modules that actually changed.
+ */
+static void
+gum_module_api_resolver_maybe_refresh (GumModuleApiResolver * self)
+{
+  guint64 generation;
+  GHashTable * previous;
+
+  if (!self->has_generation)
+    return;
+
+  if (!_gum_process_try_query_module_generation (&generation))
+    return;
+
+  if (generation == self->generation)
+    return;
+
+  self->generation = generation;
+
+  previous = self->module_by_name;
+  self->module_by_name = gum_module_api_resolver_create_snapshot (previous);
+  g_hash_table_unref (previous);
+}
+
 static GHashTable *
-gum_module_api_resolver_create_snapshot (void)
+gum_module_api_resolver_create_snapshot (GHashTable * previous)
 {
-  GHashTable * module_by_name;
+  GumCollectModulesOperation op;
 
-  module_by_name = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+  op.current = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
       (GDestroyNotify) gum_module_metadata_unref);
+  op.previous = previous;
 
-  gum_process_enumerate_modules (gum_module_api_resolver_collect_module,
-      module_by_name);
+  gum_process_enumerate_modules (gum_module_api_resolver_collect_module, &op);
 
-  return module_by_name;
+  return op.current;
 }
 
 static gboolean
 gum_module_api_resolver_collect_module (const GumModuleDetails * details,
                                         gpointer user_data)
 {
-  GHashTable * module_by_name = user_data;
-  GumModuleMetadata * module;
+  GumCollectModulesOperation * op = user_data;
+  GumModuleMetadata * module = NULL;
+
+  if (op->previous != NULL)
+  {
+    module = g_hash_table_lookup (op->previous, details->path);
+    if (module != NULL &&
+        module->base_address == details->range->base_address)
+    {
+      module->ref_count += 2;
+    }
+    else
+    {
+      module = NULL;
+    }
+  }
 
-  module = g_slice_new (GumModuleMetadata);
-  module->ref_count = 2;
-  module->name = g_strdup (details->name);
-  module->path = g_strdup (details->path);
-  module->import_by_name = NULL;
-  module->export_by_name = NULL;
+  if (module == NULL)
+  {
+    module = g_slice_new (GumModuleMetadata);
+    module->ref_count = 2;
+    module->name = g_strdup (details->name);
+    module->path = g_strdup (details->path);
+    module->base_address = details->range->base_address;
+    module->import_by_name = NULL;
+    module->export_by_name = NULL;
+    module->export_table = NULL;
+    module->names = NULL;
+  }
 
-  g_hash_table_insert (module_by_name, g_strdup (module->name), module);
-  g_hash_table_insert (module_by_name, g_strdup (module->path), module);
+  g_hash_table_insert (op->current, g_strdup (module->name), module);
+  g_hash_table_insert (op->current, g_strdup (module->path), module);
 
   return TRUE;
 }
@@ -321,9 +423,15 @@ gum_module_metadata_unref (GumModuleMetadata * module)
     if (module->export_by_name != NULL)
       g_hash_table_unref (module->export_by_name);
 
+    if (module->export_table != NULL)
+      gum_export_table_free (module->export_table);
+
     if (module->import_by_name != NULL)
       g_hash_table_unref (module->import_by_name);
 
+    if (module->names != NULL)
+      g_string_chunk_free (module->names);
+
     g_free (module->path);
     g_free (module->name);
 
@@ -331,15 +439,30 @@ gum_module_metadata_unref (GumModuleMetadata * module)
   }
 }
 
+static GStringChunk *
+gum_module_metadata_get_names (GumModuleMetadata * self)
+{
+  if (self->names == NULL)
+    self->names = g_string_chunk_new (1024);
+
+  return self->names;
+}
+
 static GHashTable *
 gum_module_metadata_get_imports (GumModuleMetadata * self)
 {
   if (self->import_by_name == NULL)
   {
+    GumCollectFunctionsOperation op;
+
     self->import_by_name = g_hash_table_new_full (g_str_hash, g_str_equal,
-        g_free, (GDestroyNotify) gum_function_metadata_free);
+        NULL, (GDestroyNotify) gum_function_metadata_free);
+
+    op.table = self->import_by_name;
+    op.names = gum_module_metadata_get_names (self);
+
     gum_module_enumerate_imports (self->path,
-        gum_module_metadata_collect_import, self->import_by_name);
+        gum_module_metadata_collect_import, &op);
   }
 
   return self->import_by_name;
@@ -350,62 +473,73 @@ gum_module_metadata_get_exports (GumModuleMetadata * self)
 {
   if (self->export_by_name == NULL)
   {
+    guint i;
+
     self->export_by_name = g_hash_table_new_full (g_str_hash, g_str_equal,
-        g_free, (GDestroyNotify) gum_function_metadata_free);
-    gum_module_enumerate_exports (self->path,
-        gum_module_metadata_collect_export, self->export_by_name);
-  }
+        NULL, (GDestroyNotify) gum_function_metadata_free);
 
-  return self->export_by_name;
-}
+    /*
+     * The packed table is kept alive alongside the hash so function names
+     * can point straight into its string arena instead of being copied.
+     */
+    self->export_table = gum_module_collect_exports (self->path);
 
-static gboolean
-gum_module_metadata_collect_import (const GumImportDetails * details,
-                                    gpointer user_data)
-{
-  GHashTable * import_by_name = user_data;
+    for (i = 0; i != self->export_table->n_entries; i++)
+    {
+      const GumExportTableEntry * entry = &self->export_table->entries[i];
+      GumFunctionMetadata * function;
 
-  if (details->type == GUM_IMPORT_FUNCTION && details->address != 0)
-  {
-    GumFunctionMetadata * function;
+      if (entry->type != GUM_EXPORT_FUNCTION)
+        continue;
 
-    function = gum_function_metadata_new (details->name, details->address,
-        details->module);
-    g_hash_table_insert (import_by_name, g_strdup (function->name), function);
+      function = g_slice_new (GumFunctionMetadata);
+      function->name =
+          gum_export_table_entry_get_name (self->export_table, entry);
+      function->name_lowered = NULL;
+      function->address = entry->address;
+      function->module = NULL;
+
+      g_hash_table_insert (self->export_by_name, (gpointer) function->name,
+          function);
+    }
   }
 
-  return TRUE;
+  return self->export_by_name;
 }
 
 static gboolean
-gum_module_metadata_collect_export (const GumExportDetails * details,
+gum_module_metadata_collect_import (const GumImportDetails * details,
                                     gpointer user_data)
 {
-  GHashTable * export_by_name = user_data;
+  GumCollectFunctionsOperation * op = user_data;
 
-  if (details->type == GUM_EXPORT_FUNCTION)
+  if (details->type == GUM_IMPORT_FUNCTION && details->address != 0)
   {
     GumFunctionMetadata * function;
 
-    function = gum_function_metadata_new (details->name, details->address,
-        NULL);
-    g_hash_table_insert (export_by_name, g_strdup (function->name), function);
+    function = gum_function_metadata_new (op, details->name, details->address,
+        details->module);
+    g_hash_table_insert (op->table, (gpointer) function->name, function);
   }
 
   return TRUE;
 }
 
 static GumFunctionMetadata *
-gum_function_metadata_new (const gchar * name,
+gum_function_metadata_new (GumCollectFunctionsOperation * op,
+                           const gchar * name,
                            GumAddress address,
                            const gchar * module)
 {
   GumFunctionMetadata * function;
 
   function = g_slice_new (GumFunctionMetadata);
-  function->name = g_strdup (name);
+  function->name = g_string_chunk_insert (op->names, name);
+  function->name_lowered = NULL;
   function->address = address;
-  function->module = g_strdup (module);
+  function->module = (module != NULL)
+      ? g_string_chunk_insert_const (op->names, module)
+      : NULL;
 
   return function;
 }
@@ -413,8 +547,5 @@ gum_function_metadata_new (const gchar * name,
 static void
 gum_function_metadata_free (GumFunctionMetadata * function)
 {
-  g_free (function->module);
-  g_free (function->name);
-
   g_slice_free (GumFunctionMetadata, function);
 }
@@ -0,0 +1,346 @@
+/*
+ * Copyright (C) 2021 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#include "gummodulecoverage.h"
+
+#include "gummemory.h"
+
+#ifdef HAVE_I386
+# include "gumcodeallocator.h"
+# include "gumx86relocator.h"
+# include "gumx86writer.h"
+#endif
+
+#include <string.h>
+
+#define GUM_COVERAGE_REDIRECT_CODE_SIZE 5
+#define GUM_COVERAGE_MAX_PROLOGUE_SIZE 16
+#define GUM_COVERAGE_STUB_SLICE_SIZE 128
+#define GUM_COVERAGE_JMP_MAX_DISTANCE (G_MAXINT32 - 16384)
+
+typedef struct _GumModuleCoverageEntry GumModuleCoverageEntry;
+
+struct _GumModuleCoverageEntry
+{
+  GumAddress address;
+#ifdef HAVE_I386
+  GumCodeSlice * stub;
+#endif
+  guint8 overwritten[GUM_COVERAGE_MAX_PROLOGUE_SIZE];
+  guint8 redirect[GUM_COVERAGE_MAX_PROLOGUE_SIZE];
+  guint prologue_len;
+};
+
+/*
+ * Statically rewrites one module's function prologues in place so only that
+ * module pays any tracing cost, unlike Stalker which translates every block
+ * a followed thread executes. Each likely function start -- discovered with
+ * GumFunctionIndex, so no symbols are needed -- gets its prologue relocated
+ * into a per-function stub that sets a hit flag and jumps back; the original
+ * entry is patched with a jmp to the stub. Code that never enters the module
+ * runs at native speed, and instrumented functions pay four instructions per
+ * call.
+ *
+ * The same caveats as for interceptor-style hooking apply: functions whose
+ * first instructions cannot be relocated are skipped, as are entries whose
+ * prologues would overlap, and branches targeting the interior of a patched
+ * prologue will misbehave. Since the function index is heuristic, coverage
+ * should be treated as approximate. Only implemented for x86 so far;
+ * gum_module_coverage_new() returns NULL elsewhere.
+ */
+struct _GumModuleCoverage
+{
+  GObject parent;
+
+  GArray * entries;
+  guint8 * cells;
+
+#ifdef HAVE_I386
+  GumCodeAllocator allocator;
+#endif
+};
+
+static void gum_module_coverage_dispose (GObject * object);
+static void gum_module_coverage_finalize (GObject * object);
+
+G_DEFINE_TYPE (GumModuleCoverage, gum_module_coverage, G_TYPE_OBJECT)
+
+static void
+gum_module_coverage_class_init (GumModuleCoverageClass * klass)
+{
+  GObjectClass * object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = gum_module_coverage_dispose;
+  object_class->finalize = gum_module_coverage_finalize;
+}
+
+static void
+gum_module_coverage_init (GumModuleCoverage * self)
+{
+  self->entries = g_array_new (FALSE, FALSE,
+      sizeof (GumModuleCoverageEntry));
+}
+
+static void
+gum_module_coverage_dispose (GObject * object)
+{
+#ifdef HAVE_I386
+  GumModuleCoverage * self = GUM_MODULE_COVERAGE (object);
+
+  if (self->entries->len != 0)
+  {
+    GumCodePatch * patches;
+    guint i;
+
+    patches = g_new (GumCodePatch, self->entries->len);
+
+    for (i = 0; i != self->entries->len; i++)
+    {
+      GumModuleCoverageEntry * entry =
+          &g_array_index (self->entries, GumModuleCoverageEntry, i);
+
+      patches[i].address = GSIZE_TO_POINTER (entry->address);
+      patches[i].bytes = entry->overwritten;
+      patches[i].size = entry->prologue_len;
+    }
+
+    gum_memory_patch_code_batch (patches, self->entries->len);
+
+    g_free (patches);
+
+    for (i = 0; i != self->entries->len; i++)
+    {
+      GumModuleCoverageEntry * entry =
+          &g_array_index (self->entries, GumModuleCoverageEntry, i);
+
+      gum_code_slice_free (entry->stub);
+    }
+
+    g_array_set_size (self->entries, 0);
+  }
+#endif
+
+  G_OBJECT_CLASS (gum_module_coverage_parent_class)->dispose (object);
+}
+
+static void
+gum_module_coverage_finalize (GObject * object)
+{
+  GumModuleCoverage * self = GUM_MODULE_COVERAGE (object);
+
+#ifdef HAVE_I386
+  gum_code_allocator_free (&self->allocator);
+#endif
+
+  g_free (self->cells);
+  g_array_unref (self->entries);
+
+  G_OBJECT_CLASS (gum_module_coverage_parent_class)->finalize (object);
+}
+
+GumModuleCoverage *
+gum_module_coverage_new (const gchar * module_name)
+{
+#ifdef HAVE_I386
+  GumModuleCoverage * self;
+  GumFunctionIndex * index;
+  GumX86Writer cw;
+  GumX86Relocator rl;
+  GumCodePatch * patches;
+  GumAddress prev_end;
+  guint count, i;
+
+  index = gum_function_index_new_for_module (module_name);
+  if (index == NULL)
+    return NULL;
+
+  self = g_object_new (GUM_TYPE_MODULE_COVERAGE, NULL);
+  gum_code_allocator_init (&self->allocator, GUM_COVERAGE_STUB_SLICE_SIZE);
+
+  count = gum_function_index_get_count (index);
+  self->cells = g_malloc0 (MAX (count, 1));
+
+  gum_x86_writer_init (&cw, NULL);
+  gum_x86_relocator_init (&rl, NULL, &cw);
+
+  prev_end = 0;
+
+  for (i = 0; i != count; i++)
+  {
+    GumAddress address = gum_function_index_get_nth (index, i);
+    gpointer function_address = GSIZE_TO_POINTER (address);
+    GumModuleCoverageEntry entry = { 0, };
+    GumCodeSlice * stub;
+    guint8 * cell;
+    guint reloc_bytes, padding;
+    static const guint8 set_cell_code[] = { 0xc6, 0x00, 0x01 };
+
+    if (address < prev_end)
+      continue;
+
+    if (!gum_x86_relocator_can_relocate (function_address,
+        GUM_COVERAGE_REDIRECT_CODE_SIZE, NULL))
+    {
+      continue;
+    }
+
+#if GLIB_SIZEOF_VOID_P == 4
+    stub = gum_code_allocator_alloc_slice (&self->allocator);
+#else
+    {
+      GumAddressSpec spec;
+
+      spec.near_address = function_address;
+      spec.max_distance = GUM_COVERAGE_JMP_MAX_DISTANCE;
+      stub = gum_code_allocator_try_alloc_slice_near (&self->allocator,
+          &spec, 0);
+    }
+#endif
+    if (stub == NULL)
+      continue;
+
+    cell = &self->cells[self->entries->len];
+
+    gum_x86_writer_reset (&cw, stub->data);
+
+    gum_x86_writer_put_push_reg (&cw, GUM_REG_XAX);
+    gum_x86_writer_put_mov_reg_address (&cw, GUM_REG_XAX,
+        GUM_ADDRESS (cell));
+    gum_x86_writer_put_bytes (&cw, set_cell_code, sizeof (set_cell_code));
+    gum_x86_writer_put_pop_reg (&cw, GUM_REG_XAX);
+
+    gum_x86_relocator_reset (&rl, function_address, &cw);
+
+    do
+    {
+      reloc_bytes = gum_x86_relocator_read_one (&rl, NULL);
+      if (reloc_bytes == 0)
+        break;
+    }
+    while (reloc_bytes < GUM_COVERAGE_REDIRECT_CODE_SIZE);
+
+    if (reloc_bytes < GUM_COVERAGE_REDIRECT_CODE_SIZE ||
+        reloc_bytes > GUM_COVERAGE_MAX_PROLOGUE_SIZE)
+    {
+      gum_code_slice_free (stub);
+      continue;
+    }
+
+    gum_x86_relocator_write_all (&rl);
+
+    if (!gum_x86_relocator_eoi (&rl))
+    {
+      gum_x86_writer_put_jmp_address (&cw, address + reloc_bytes);
+    }
+
+    gum_x86_writer_flush (&cw);
+    g_assert (gum_x86_writer_offset (&cw) <= stub->size);
+
+    entry.address = address;
+    entry.stub = stub;
+    entry.prologue_len = reloc_bytes;
+    memcpy (entry.overwritten, function_address, reloc_bytes);
+
+    entry.redirect[0] = 0xe9;
+    {
+      gint32 distance = (gint32) (GPOINTER_TO_SIZE (stub->data) -
+          (address + GUM_COVERAGE_REDIRECT_CODE_SIZE));
+      memcpy (entry.redirect + 1, &distance, sizeof (distance));
+    }
+    for (padding = GUM_COVERAGE_REDIRECT_CODE_SIZE; padding != reloc_bytes;
+        padding++)
+    {
+      entry.redirect[padding] = 0x90;
+    }
+
+    g_array_append_val (self->entries, entry);
+
+    prev_end = address + reloc_bytes;
+  }
+
+  gum_x86_relocator_clear (&rl);
+  gum_x86_writer_clear (&cw);
+
+  g_object_unref (index);
+
+  if (self->entries->len == 0)
+  {
+    g_object_unref (self);
+    return NULL;
+  }
+
+  gum_code_allocator_commit (&self->allocator);
+
+  patches = g_new (GumCodePatch, self->entries->len);
+
+  for (i = 0; i != self->entries->len; i++)
+  {
+    GumModuleCoverageEntry * entry =
+        &g_array_index (self->entries, GumModuleCoverageEntry, i);
+
+    patches[i].address = GSIZE_TO_POINTER (entry->address);
+    patches[i].bytes = entry->redirect;
+    patches[i].size = entry->prologue_len;
+  }
+
+  gum_memory_patch_code_batch (patches, self->entries->len);
+
+  g_free (patches);
+
+  return self;
+#else
+  (void) module_name;
+
+  return NULL;
+#endif
+}
+
+guint
+gum_module_coverage_get_count (GumModuleCoverage * self)
+{
+  return self->entries->len;
+}
+
+guint
+gum_module_coverage_get_hit_count (GumModuleCoverage * self)
+{
+  guint n, i;
+
+  n = 0;
+  for (i = 0; i != self->entries->len; i++)
+  {
+    if (self->cells[i] != 0)
+      n++;
+  }
+
+  return n;
+}
+
+void
+gum_module_coverage_enumerate_hits (GumModuleCoverage * self,
+                                    GumFoundFunctionStartFunc func,
+                                    gpointer user_data)
+{
+  guint i;
+
+  for (i = 0; i != self->entries->len; i++)
+  {
+    GumModuleCoverageEntry * entry =
+        &g_array_index (self->entries, GumModuleCoverageEntry, i);
+
+    if (self->cells[i] == 0)
+      continue;
+
+    if (!func (entry->address, user_data))
+      return;
+  }
+}
+
+void
+gum_module_coverage_reset (GumModuleCoverage * self)
+{
+  memset (self->cells, 0, self->entries->len);
+}
@@ -0,0 +1,30 @@
+/*
+ * Copyright (C) 2021 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#ifndef __GUM_MODULE_COVERAGE_H__
+#define __GUM_MODULE_COVERAGE_H__
+
+#include <glib-object.h>
+#include <gum/gumfunctionindex.h>
+
+G_BEGIN_DECLS
+
+#define GUM_TYPE_MODULE_COVERAGE (gum_module_coverage_get_type ())
+G_DECLARE_FINAL_TYPE (GumModuleCoverage, gum_module_coverage, GUM,
+    MODULE_COVERAGE, GObject)
+
+GUM_API GumModuleCoverage * gum_module_coverage_new (
+    const gchar * module_name);
+
+GUM_API guint gum_module_coverage_get_count (GumModuleCoverage * self);
+GUM_API guint gum_module_coverage_get_hit_count (GumModuleCoverage * self);
+GUM_API void gum_module_coverage_enumerate_hits (GumModuleCoverage * self,
+    GumFoundFunctionStartFunc func, gpointer user_data);
+GUM_API void gum_module_coverage_reset (GumModuleCoverage * self);
+
+G_END_DECLS
+
+#endif
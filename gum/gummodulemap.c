@@ -6,23 +6,52 @@
 
 #include "gummodulemap.h"
 
+#include "gumprocess-priv.h"
+
 #include <stdlib.h>
 
+typedef struct _GumModuleMapSnapshot GumModuleMapSnapshot;
+typedef struct _GumModuleMapUpdateOperation GumModuleMapUpdateOperation;
+
+/*
+ * Lookups run on an immutable snapshot that is swapped atomically, so
+ * find() never takes a lock and never observes a half-built array.
+ * Superseded snapshots are parked until finalize, which means details
+ * handed out by find() stay valid for the lifetime of the map even if
+ * it is updated concurrently.
+ */
+struct _GumModuleMapSnapshot
+{
+  guint64 generation;
+  gboolean has_generation;
+
+  GArray * modules;
+};
+
 struct _GumModuleMap
 {
   GObject parent;
 
-  GArray * modules;
+  GumModuleMapSnapshot * current;
+  GSList * retired;
+  GMutex mutex;
 
   GumModuleMapFilterFunc filter_func;
   gpointer filter_data;
   GDestroyNotify filter_data_destroy;
 };
 
+struct _GumModuleMapUpdateOperation
+{
+  GumModuleMap * map;
+  GumModuleMapSnapshot * snapshot;
+};
+
 static void gum_module_map_dispose (GObject * object);
 static void gum_module_map_finalize (GObject * object);
 
-static void gum_module_map_clear (GumModuleMap * self);
+static GumModuleMapSnapshot * gum_module_map_snapshot_new (void);
+static void gum_module_map_snapshot_free (GumModuleMapSnapshot * snapshot);
 static gboolean gum_add_module (const GumModuleDetails * details,
     gpointer user_data);
 
@@ -45,7 +74,9 @@ gum_module_map_class_init (GumModuleMapClass * klass)
 static void
 gum_module_map_init (GumModuleMap * self)
 {
-  self->modules = g_array_new (FALSE, FALSE, sizeof (GumModuleDetails));
+  self->current = gum_module_map_snapshot_new ();
+  self->retired = NULL;
+  g_mutex_init (&self->mutex);
 }
 
 static void
@@ -68,8 +99,11 @@ gum_module_map_finalize (GObject * object)
 {
   GumModuleMap * self = GUM_MODULE_MAP (object);
 
-  gum_module_map_clear (self);
-  g_array_free (self->modules, TRUE);
+  g_slist_foreach (self->retired, (GFunc) gum_module_map_snapshot_free, NULL);
+  g_slist_free (self->retired);
+  gum_module_map_snapshot_free (self->current);
+
+  g_mutex_clear (&self->mutex);
 
   G_OBJECT_CLASS (gum_module_map_parent_class)->finalize (object);
 }
@@ -107,7 +141,11 @@ const GumModuleDetails *
 gum_module_map_find (GumModuleMap * self,
                      GumAddress address)
 {
-  return bsearch (&address, self->modules->data, self->modules->len,
+  GumModuleMapSnapshot * snapshot;
+
+  snapshot = g_atomic_pointer_get (&self->current);
+
+  return bsearch (&address, snapshot->modules->data, snapshot->modules->len,
       sizeof (GumModuleDetails),
       (GCompareFunc) gum_module_details_compare_to_key);
 }
@@ -115,37 +153,89 @@ gum_module_map_find (GumModuleMap * self,
 void
 gum_module_map_update (GumModuleMap * self)
 {
-  gum_module_map_clear (self);
-  gum_process_enumerate_modules (gum_add_module, self);
-  g_array_sort (self->modules, (GCompareFunc) gum_module_details_compare_base);
+  guint64 generation = 0;
+  gboolean has_generation;
+  GumModuleMapSnapshot * snapshot, * previous;
+  GumModuleMapUpdateOperation op;
+
+  has_generation = _gum_process_try_query_module_generation (&generation);
+
+  /*
+   * When the loader exposes a generation counter we can tell that nothing
+   * was loaded or unloaded since the last rebuild, making update() cheap
+   * enough to call eagerly.
+   */
+  previous = g_atomic_pointer_get (&self->current);
+  if (has_generation && previous->has_generation &&
+      previous->generation == generation)
+  {
+    return;
+  }
+
+  snapshot = gum_module_map_snapshot_new ();
+  snapshot->generation = generation;
+  snapshot->has_generation = has_generation;
+
+  op.map = self;
+  op.snapshot = snapshot;
+  gum_process_enumerate_modules (gum_add_module, &op);
+
+  g_array_sort (snapshot->modules,
+      (GCompareFunc) gum_module_details_compare_base);
+
+  g_mutex_lock (&self->mutex);
+  self->retired = g_slist_prepend (self->retired, self->current);
+  g_atomic_pointer_set (&self->current, snapshot);
+  g_mutex_unlock (&self->mutex);
 }
 
 GArray *
 gum_module_map_get_values (GumModuleMap * self)
 {
-  return self->modules;
+  GumModuleMapSnapshot * snapshot;
+
+  snapshot = g_atomic_pointer_get (&self->current);
+
+  return snapshot->modules;
+}
+
+static GumModuleMapSnapshot *
+gum_module_map_snapshot_new (void)
+{
+  GumModuleMapSnapshot * snapshot;
+
+  snapshot = g_slice_new (GumModuleMapSnapshot);
+  snapshot->generation = 0;
+  snapshot->has_generation = FALSE;
+  snapshot->modules = g_array_new (FALSE, FALSE, sizeof (GumModuleDetails));
+
+  return snapshot;
 }
 
 static void
-gum_module_map_clear (GumModuleMap * self)
+gum_module_map_snapshot_free (GumModuleMapSnapshot * snapshot)
 {
   guint i;
 
-  for (i = 0; i < self->modules->len; i++)
+  for (i = 0; i < snapshot->modules->len; i++)
   {
-    GumModuleDetails * d = &g_array_index (self->modules, GumModuleDetails, i);
+    GumModuleDetails * d =
+        &g_array_index (snapshot->modules, GumModuleDetails, i);
     g_free ((gchar *) d->name);
     g_slice_free (GumMemoryRange, (GumMemoryRange *) d->range);
     g_free ((gchar *) d->path);
   }
-  g_array_set_size (self->modules, 0);
+  g_array_free (snapshot->modules, TRUE);
+
+  g_slice_free (GumModuleMapSnapshot, snapshot);
 }
 
 static gboolean
 gum_add_module (const GumModuleDetails * details,
                 gpointer user_data)
 {
-  GumModuleMap * self = user_data;
+  GumModuleMapUpdateOperation * op = user_data;
+  GumModuleMap * self = op->map;
   GumModuleDetails copy;
 
   if (self->filter_func != NULL)
@@ -158,7 +248,7 @@ gum_add_module (const GumModuleDetails * details,
   copy.range = g_slice_dup (GumMemoryRange, details->range);
   copy.path = g_strdup (details->path);
 
-  g_array_append_val (self->modules, copy);
+  g_array_append_val (op->snapshot->modules, copy);
 
   return TRUE;
 }
@@ -0,0 +1,440 @@
+/*
+ * Copyright (C) 2020 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#include "gummoduleobserver.h"
+
+#include "guminterceptor.h"
+#include "gummoduleapiresolver.h"
+#include "gumprocess.h"
+
+typedef struct _GumModuleHookSpec GumModuleHookSpec;
+typedef struct _GumModuleObserverApplyOperation GumModuleObserverApplyOperation;
+typedef struct _GumModuleObserverSyncOperation GumModuleObserverSyncOperation;
+
+struct _GumModuleObserver
+{
+  GObject parent;
+
+  gboolean disposed;
+
+  GMutex mutex;
+  GumInterceptor * interceptor;
+  GPtrArray * specs;
+  guint next_spec_id;
+  GHashTable * known_modules;
+  gboolean monitoring;
+};
+
+struct _GumModuleHookSpec
+{
+  guint id;
+  gchar * query;
+  GumInvocationListener * listener;
+  gpointer listener_function_data;
+};
+
+struct _GumModuleObserverApplyOperation
+{
+  GumModuleObserver * self;
+  GumModuleHookSpec * spec;
+};
+
+struct _GumModuleObserverSyncOperation
+{
+  GumModuleObserver * self;
+  gboolean found_new_module;
+};
+
+static void gum_module_observer_listener_iface_init (gpointer g_iface,
+    gpointer iface_data);
+static void gum_module_observer_dispose (GObject * object);
+static void gum_module_observer_finalize (GObject * object);
+static void the_module_observer_weak_notify (gpointer data,
+    GObject * where_the_object_was);
+
+static void gum_module_observer_ensure_monitoring (GumModuleObserver * self);
+static void gum_module_observer_attach_to_loader_entrypoint (
+    GumModuleObserver * self, const gchar * module_name,
+    const gchar * symbol_name);
+static gboolean gum_module_observer_remember_module (
+    const GumModuleDetails * details, gpointer user_data);
+static gboolean gum_module_observer_collect_new_module (
+    const GumModuleDetails * details, gpointer user_data);
+static void gum_module_observer_apply_specs (GumModuleObserver * self);
+static gboolean gum_module_observer_attach_match (
+    const GumApiDetails * details, gpointer user_data);
+
+static void gum_module_observer_on_leave (GumInvocationListener * listener,
+    GumInvocationContext * context);
+
+static GumModuleHookSpec * gum_module_hook_spec_new (const gchar * query,
+    GumInvocationListener * listener, gpointer listener_function_data);
+static void gum_module_hook_spec_free (GumModuleHookSpec * spec);
+
+G_DEFINE_TYPE_EXTENDED (GumModuleObserver,
+                        gum_module_observer,
+                        G_TYPE_OBJECT,
+                        0,
+                        G_IMPLEMENT_INTERFACE (GUM_TYPE_INVOCATION_LISTENER,
+                            gum_module_observer_listener_iface_init))
+
+static GMutex _gum_module_observer_lock;
+static GumModuleObserver * _the_module_observer = NULL;
+
+static void
+gum_module_observer_class_init (GumModuleObserverClass * klass)
+{
+  GObjectClass * gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->dispose = gum_module_observer_dispose;
+  gobject_class->finalize = gum_module_observer_finalize;
+}
+
+static void
+gum_module_observer_listener_iface_init (gpointer g_iface,
+                                         gpointer iface_data)
+{
+  GumInvocationListenerInterface * iface = g_iface;
+
+  iface->on_enter = NULL;
+  iface->on_leave = gum_module_observer_on_leave;
+}
+
+static void
+gum_module_observer_init (GumModuleObserver * self)
+{
+  g_mutex_init (&self->mutex);
+
+  self->interceptor = gum_interceptor_obtain ();
+
+  self->specs = g_ptr_array_new_with_free_func (
+      (GDestroyNotify) gum_module_hook_spec_free);
+  self->next_spec_id = 1;
+
+  self->known_modules = g_hash_table_new_full (g_str_hash, g_str_equal,
+      g_free, NULL);
+}
+
+static void
+gum_module_observer_dispose (GObject * object)
+{
+  GumModuleObserver * self = GUM_MODULE_OBSERVER (object);
+
+  if (!self->disposed)
+  {
+    guint i;
+
+    self->disposed = TRUE;
+
+    if (self->monitoring)
+    {
+      gum_interceptor_detach (self->interceptor,
+          GUM_INVOCATION_LISTENER (self));
+      self->monitoring = FALSE;
+    }
+
+    for (i = 0; i != self->specs->len; i++)
+    {
+      GumModuleHookSpec * spec = g_ptr_array_index (self->specs, i);
+
+      gum_interceptor_detach (self->interceptor, spec->listener);
+    }
+    g_ptr_array_unref (self->specs);
+    self->specs = NULL;
+
+    g_hash_table_unref (self->known_modules);
+    self->known_modules = NULL;
+
+    g_object_unref (self->interceptor);
+    self->interceptor = NULL;
+  }
+
+  G_OBJECT_CLASS (gum_module_observer_parent_class)->dispose (object);
+}
+
+static void
+gum_module_observer_finalize (GObject * object)
+{
+  GumModuleObserver * self = GUM_MODULE_OBSERVER (object);
+
+  g_mutex_clear (&self->mutex);
+
+  G_OBJECT_CLASS (gum_module_observer_parent_class)->finalize (object);
+}
+
+GumModuleObserver *
+gum_module_observer_obtain (void)
+{
+  GumModuleObserver * observer;
+
+  g_mutex_lock (&_gum_module_observer_lock);
+
+  if (_the_module_observer != NULL)
+  {
+    observer = GUM_MODULE_OBSERVER (g_object_ref (_the_module_observer));
+  }
+  else
+  {
+    _the_module_observer = g_object_new (GUM_TYPE_MODULE_OBSERVER, NULL);
+    g_object_weak_ref (G_OBJECT (_the_module_observer),
+        the_module_observer_weak_notify, NULL);
+
+    observer = _the_module_observer;
+  }
+
+  g_mutex_unlock (&_gum_module_observer_lock);
+
+  return observer;
+}
+
+static void
+the_module_observer_weak_notify (gpointer data,
+                                 GObject * where_the_object_was)
+{
+  g_mutex_lock (&_gum_module_observer_lock);
+
+  g_assert (_the_module_observer == (GumModuleObserver *) where_the_object_was);
+  _the_module_observer = NULL;
+
+  g_mutex_unlock (&_gum_module_observer_lock);
+}
+
+/*
+ * Registers an ApiResolver-style query whose matches should be hooked with
+ * the given listener. The spec is applied to all modules loaded so far, and
+ * re-applied from inside the loader as new modules show up, so hooks land
+ * before the code that requested the load gets a chance to call into it.
+ *
+ * Returns the spec's id, or 0 if the query is malformed.
+ */
+guint
+gum_module_observer_add_hook_spec (GumModuleObserver * self,
+                                   const gchar * query,
+                                   GumInvocationListener * listener,
+                                   gpointer listener_function_data,
+                                   GError ** error)
+{
+  GumModuleHookSpec * spec;
+  GumModuleObserverApplyOperation op;
+  GumApiResolver * resolver;
+  GError * e = NULL;
+  guint id;
+
+  spec = gum_module_hook_spec_new (query, listener, listener_function_data);
+
+  op.self = self;
+  op.spec = spec;
+
+  resolver = gum_module_api_resolver_new ();
+
+  gum_interceptor_begin_transaction (self->interceptor);
+  gum_api_resolver_enumerate_matches (resolver, query,
+      gum_module_observer_attach_match, &op, &e);
+  gum_interceptor_end_transaction (self->interceptor);
+
+  g_object_unref (resolver);
+
+  if (e != NULL)
+  {
+    gum_interceptor_detach (self->interceptor, listener);
+    gum_module_hook_spec_free (spec);
+    g_propagate_error (error, e);
+    return 0;
+  }
+
+  g_mutex_lock (&self->mutex);
+
+  id = self->next_spec_id++;
+  spec->id = id;
+  g_ptr_array_add (self->specs, spec);
+
+  gum_module_observer_ensure_monitoring (self);
+
+  g_mutex_unlock (&self->mutex);
+
+  return id;
+}
+
+void
+gum_module_observer_remove_hook_spec (GumModuleObserver * self,
+                                      guint id)
+{
+  guint i;
+
+  g_mutex_lock (&self->mutex);
+
+  for (i = 0; i != self->specs->len; i++)
+  {
+    GumModuleHookSpec * spec = g_ptr_array_index (self->specs, i);
+
+    if (spec->id == id)
+    {
+      gum_interceptor_detach (self->interceptor, spec->listener);
+      g_ptr_array_remove_index (self->specs, i);
+      break;
+    }
+  }
+
+  g_mutex_unlock (&self->mutex);
+}
+
+static void
+gum_module_observer_ensure_monitoring (GumModuleObserver * self)
+{
+  if (self->monitoring)
+    return;
+  self->monitoring = TRUE;
+
+  gum_process_enumerate_modules (gum_module_observer_remember_module, self);
+
+  gum_interceptor_begin_transaction (self->interceptor);
+
+#if defined (HAVE_WINDOWS)
+  gum_module_observer_attach_to_loader_entrypoint (self, "ntdll.dll",
+      "LdrLoadDll");
+#else
+  gum_module_observer_attach_to_loader_entrypoint (self, NULL, "dlopen");
+# if defined (HAVE_ANDROID)
+  gum_module_observer_attach_to_loader_entrypoint (self, NULL,
+      "android_dlopen_ext");
+# elif defined (HAVE_LINUX)
+  gum_module_observer_attach_to_loader_entrypoint (self, NULL, "dlmopen");
+# endif
+#endif
+
+  gum_interceptor_end_transaction (self->interceptor);
+}
+
+static void
+gum_module_observer_attach_to_loader_entrypoint (GumModuleObserver * self,
+                                                 const gchar * module_name,
+                                                 const gchar * symbol_name)
+{
+  GumAddress entrypoint;
+
+  entrypoint = gum_module_find_export_by_name (module_name, symbol_name);
+  if (entrypoint == 0)
+    return;
+
+  gum_interceptor_attach (self->interceptor, GSIZE_TO_POINTER (entrypoint),
+      GUM_INVOCATION_LISTENER (self), NULL);
+}
+
+static gboolean
+gum_module_observer_remember_module (const GumModuleDetails * details,
+                                     gpointer user_data)
+{
+  GumModuleObserver * self = user_data;
+
+  g_hash_table_add (self->known_modules, g_strdup (details->path));
+
+  return TRUE;
+}
+
+static gboolean
+gum_module_observer_collect_new_module (const GumModuleDetails * details,
+                                        gpointer user_data)
+{
+  GumModuleObserverSyncOperation * op = user_data;
+
+  if (!g_hash_table_contains (op->self->known_modules, details->path))
+  {
+    g_hash_table_add (op->self->known_modules, g_strdup (details->path));
+    op->found_new_module = TRUE;
+  }
+
+  return TRUE;
+}
+
+/*
+ * All specs are re-resolved in one go and the resulting attachments are
+ * batched in a single interceptor transaction, so a load that pulls in a
+ * dozen hooked APIs pays for one code-rewriting pass rather than twelve.
+ * Matches hooked on a previous pass come back as ALREADY_ATTACHED, which we
+ * deliberately ignore.
+ */
+static void
+gum_module_observer_apply_specs (GumModuleObserver * self)
+{
+  GumApiResolver * resolver;
+  guint i;
+
+  resolver = gum_module_api_resolver_new ();
+
+  gum_interceptor_begin_transaction (self->interceptor);
+
+  for (i = 0; i != self->specs->len; i++)
+  {
+    GumModuleObserverApplyOperation op;
+
+    op.self = self;
+    op.spec = g_ptr_array_index (self->specs, i);
+
+    gum_api_resolver_enumerate_matches (resolver, op.spec->query,
+        gum_module_observer_attach_match, &op, NULL);
+  }
+
+  gum_interceptor_end_transaction (self->interceptor);
+
+  g_object_unref (resolver);
+}
+
+static gboolean
+gum_module_observer_attach_match (const GumApiDetails * details,
+                                  gpointer user_data)
+{
+  GumModuleObserverApplyOperation * op = user_data;
+  GumModuleHookSpec * spec = op->spec;
+
+  gum_interceptor_attach (op->self->interceptor,
+      GSIZE_TO_POINTER (details->address), spec->listener,
+      spec->listener_function_data);
+
+  return TRUE;
+}
+
+static void
+gum_module_observer_on_leave (GumInvocationListener * listener,
+                              GumInvocationContext * context)
+{
+  GumModuleObserver * self = GUM_MODULE_OBSERVER (listener);
+  GumModuleObserverSyncOperation op;
+
+  g_mutex_lock (&self->mutex);
+
+  op.self = self;
+  op.found_new_module = FALSE;
+  gum_process_enumerate_modules (gum_module_observer_collect_new_module, &op);
+
+  if (op.found_new_module && self->specs->len != 0)
+    gum_module_observer_apply_specs (self);
+
+  g_mutex_unlock (&self->mutex);
+}
+
+static GumModuleHookSpec *
+gum_module_hook_spec_new (const gchar * query,
+                          GumInvocationListener * listener,
+                          gpointer listener_function_data)
+{
+  GumModuleHookSpec * spec;
+
+  spec = g_slice_new (GumModuleHookSpec);
+  spec->id = 0;
+  spec->query = g_strdup (query);
+  spec->listener = g_object_ref (listener);
+  spec->listener_function_data = listener_function_data;
+
+  return spec;
+}
+
+static void
+gum_module_hook_spec_free (GumModuleHookSpec * spec)
+{
+  g_free (spec->query);
+  g_object_unref (spec->listener);
+  g_slice_free (GumModuleHookSpec, spec);
+}
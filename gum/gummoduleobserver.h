@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 2020 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#ifndef __GUM_MODULE_OBSERVER_H__
+#define __GUM_MODULE_OBSERVER_H__
+
+#include <gum/guminvocationlistener.h>
+
+G_BEGIN_DECLS
+
+#define GUM_TYPE_MODULE_OBSERVER (gum_module_observer_get_type ())
+G_DECLARE_FINAL_TYPE (GumModuleObserver, gum_module_observer, GUM,
+    MODULE_OBSERVER, GObject)
+
+GUM_API GumModuleObserver * gum_module_observer_obtain (void);
+
+GUM_API guint gum_module_observer_add_hook_spec (GumModuleObserver * self,
+    const gchar * query, GumInvocationListener * listener,
+    gpointer listener_function_data, GError ** error);
+GUM_API void gum_module_observer_remove_hook_spec (GumModuleObserver * self,
+    guint id);
+
+G_END_DECLS
+
+#endif
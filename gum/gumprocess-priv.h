@@ -13,8 +13,16 @@ G_BEGIN_DECLS
 
 G_GNUC_INTERNAL void _gum_process_enumerate_threads (GumFoundThreadFunc func,
     gpointer user_data);
+G_GNUC_INTERNAL GumThreadSuspension * _gum_process_suspend_threads (
+    const GumThreadId * thread_ids, guint n_threads);
+G_GNUC_INTERNAL void _gum_process_resume_threads (
+    GumThreadSuspension * suspension);
 G_GNUC_INTERNAL void _gum_process_enumerate_ranges (GumPageProtection prot,
     GumFoundRangeFunc func, gpointer user_data);
+G_GNUC_INTERNAL gboolean _gum_process_try_query_module_generation (
+    guint64 * generation);
+G_GNUC_INTERNAL GumAddress _gum_module_find_export_by_name (
+    const gchar * module_name, const gchar * symbol_name);
 
 G_END_DECLS
 
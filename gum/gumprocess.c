@@ -11,6 +11,7 @@
 typedef struct _GumEmitThreadsContext GumEmitThreadsContext;
 typedef struct _GumEmitRangesContext GumEmitRangesContext;
 typedef struct _GumResolveSymbolContext GumResolveSymbolContext;
+typedef struct _GumCollectExportsContext GumCollectExportsContext;
 
 struct _GumEmitThreadsContext
 {
@@ -30,15 +31,29 @@ struct _GumResolveSymbolContext
   GumAddress result;
 };
 
+struct _GumCollectExportsContext
+{
+  GArray * entries;
+  GString * strings;
+};
+
 static gboolean gum_emit_thread_if_not_cloaked (
     const GumThreadDetails * details, gpointer user_data);
 static gboolean gum_emit_range_if_not_cloaked (const GumRangeDetails * details,
     gpointer user_data);
 static gboolean gum_store_address_if_name_matches (
     const GumSymbolDetails * details, gpointer user_data);
+static gboolean gum_collect_export_into_table (
+    const GumExportDetails * details, gpointer user_data);
+static gint gum_export_table_entry_compare (gconstpointer element_a,
+    gconstpointer element_b, gpointer user_data);
 
 static GumCodeSigningPolicy gum_code_signing_policy = GUM_CODE_SIGNING_OPTIONAL;
 
+static GMutex gum_export_cache_mutex;
+static GHashTable * gum_export_cache_tables = NULL;
+static guint64 gum_export_cache_generation;
+
 G_DEFINE_BOXED_TYPE (GumModuleDetails, gum_module_details,
     gum_module_details_copy, gum_module_details_free)
 
@@ -85,6 +100,45 @@ gum_process_enumerate_threads (GumFoundThreadFunc func,
   _gum_process_enumerate_threads (gum_emit_thread_if_not_cloaked, &ctx);
 }
 
+/*
+ * Suspends the given threads as a batch and returns a handle representing
+ * the stopped set, so whole-process operations pay the platform's
+ * coordination cost once instead of once per thread. The calling thread is
+ * silently skipped if present. Returns NULL if any thread could not be
+ * suspended, in which case no thread is left suspended.
+ */
+GumThreadSuspension *
+gum_process_suspend_threads (const GumThreadId * thread_ids,
+                             guint n_threads)
+{
+  GumThreadSuspension * suspension;
+  GArray * ids;
+  GumThreadId current_thread_id;
+  guint i;
+
+  current_thread_id = gum_process_get_current_thread_id ();
+
+  ids = g_array_sized_new (FALSE, FALSE, sizeof (GumThreadId), n_threads);
+  for (i = 0; i != n_threads; i++)
+  {
+    if (thread_ids[i] != current_thread_id)
+      g_array_append_val (ids, thread_ids[i]);
+  }
+
+  suspension = _gum_process_suspend_threads (
+      (const GumThreadId *) ids->data, ids->len);
+
+  g_array_free (ids, TRUE);
+
+  return suspension;
+}
+
+void
+gum_process_resume_threads (GumThreadSuspension * suspension)
+{
+  _gum_process_resume_threads (suspension);
+}
+
 static gboolean
 gum_emit_thread_if_not_cloaked (const GumThreadDetails * details,
                                 gpointer user_data)
@@ -172,6 +226,162 @@ gum_store_address_if_name_matches (const GumSymbolDetails * details,
   return carry_on;
 }
 
+/*
+ * Services lookups from a cached per-module export table -- the same sorted
+ * snapshot the module API resolver uses -- so repeated binding against the
+ * same module costs one binary search instead of a loader round-trip per
+ * call. The cache is invalidated wholesale whenever the loader's module
+ * generation changes; when the backend cannot report a generation, or the
+ * caller asked for a process-wide lookup, we defer to the backend directly.
+ * A miss in the table also falls through to the backend, since some loaders
+ * resolve names the export walk does not surface, e.g. forwarded exports.
+ */
+GumAddress
+gum_module_find_export_by_name (const gchar * module_name,
+                                const gchar * symbol_name)
+{
+  GumAddress result;
+  guint64 generation;
+  GumExportTable * table;
+  const GumExportTableEntry * entry;
+
+  if (module_name == NULL ||
+      !_gum_process_try_query_module_generation (&generation))
+  {
+    return _gum_module_find_export_by_name (module_name, symbol_name);
+  }
+
+  g_mutex_lock (&gum_export_cache_mutex);
+
+  if (gum_export_cache_tables == NULL)
+  {
+    gum_export_cache_tables = g_hash_table_new_full (g_str_hash, g_str_equal,
+        g_free, (GDestroyNotify) gum_export_table_free);
+    gum_export_cache_generation = generation;
+  }
+  else if (generation != gum_export_cache_generation)
+  {
+    g_hash_table_remove_all (gum_export_cache_tables);
+    gum_export_cache_generation = generation;
+  }
+
+  table = g_hash_table_lookup (gum_export_cache_tables, module_name);
+  if (table == NULL)
+  {
+    table = gum_module_collect_exports (module_name);
+    g_hash_table_insert (gum_export_cache_tables, g_strdup (module_name),
+        table);
+  }
+
+  entry = gum_export_table_find (table, symbol_name);
+  result = (entry != NULL) ? entry->address : 0;
+
+  g_mutex_unlock (&gum_export_cache_mutex);
+
+  if (result == 0)
+    result = _gum_module_find_export_by_name (module_name, symbol_name);
+
+  return result;
+}
+
+GumExportTable *
+gum_module_collect_exports (const gchar * module_name)
+{
+  GumExportTable * table;
+  GumCollectExportsContext ctx;
+
+  ctx.entries = g_array_new (FALSE, FALSE, sizeof (GumExportTableEntry));
+  ctx.strings = g_string_sized_new (4096);
+
+  gum_module_enumerate_exports (module_name, gum_collect_export_into_table,
+      &ctx);
+
+  g_array_sort_with_data (ctx.entries, gum_export_table_entry_compare,
+      ctx.strings->str);
+
+  table = g_slice_new (GumExportTable);
+  table->n_entries = ctx.entries->len;
+  table->entries = (GumExportTableEntry *) g_array_free (ctx.entries, FALSE);
+  table->strings_size = ctx.strings->len;
+  table->strings = g_string_free (ctx.strings, FALSE);
+
+  return table;
+}
+
+static gboolean
+gum_collect_export_into_table (const GumExportDetails * details,
+                               gpointer user_data)
+{
+  GumCollectExportsContext * ctx = user_data;
+  GumExportTableEntry entry;
+
+  entry.name_offset = (guint32) ctx->strings->len;
+  entry.type = details->type;
+  entry.address = details->address;
+  g_array_append_val (ctx->entries, entry);
+
+  g_string_append_len (ctx->strings, details->name,
+      strlen (details->name) + 1);
+
+  return TRUE;
+}
+
+static gint
+gum_export_table_entry_compare (gconstpointer element_a,
+                                gconstpointer element_b,
+                                gpointer user_data)
+{
+  const GumExportTableEntry * a = element_a;
+  const GumExportTableEntry * b = element_b;
+  const gchar * strings = user_data;
+
+  return strcmp (strings + a->name_offset, strings + b->name_offset);
+}
+
+const GumExportTableEntry *
+gum_export_table_find (const GumExportTable * self,
+                       const gchar * name)
+{
+  gint lower, upper;
+
+  lower = 0;
+  upper = (gint) self->n_entries - 1;
+
+  while (lower <= upper)
+  {
+    gint middle = (lower + upper) / 2;
+    const GumExportTableEntry * entry = &self->entries[middle];
+    gint comparison;
+
+    comparison = strcmp (name, self->strings + entry->name_offset);
+    if (comparison == 0)
+      return entry;
+
+    if (comparison < 0)
+      upper = middle - 1;
+    else
+      lower = middle + 1;
+  }
+
+  return NULL;
+}
+
+const gchar *
+gum_export_table_entry_get_name (const GumExportTable * self,
+                                 const GumExportTableEntry * entry)
+{
+  return self->strings + entry->name_offset;
+}
+
+void
+gum_export_table_free (GumExportTable * self)
+{
+  g_free (self->entries);
+  g_free (self->strings);
+
+  g_slice_free (GumExportTable, self);
+}
+
 const gchar *
 gum_code_signing_policy_to_string (GumCodeSigningPolicy policy)
 {
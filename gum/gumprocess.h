@@ -20,12 +20,15 @@ typedef guint GumProcessId;
 typedef gsize GumThreadId;
 typedef guint GumThreadState;
 typedef struct _GumThreadDetails GumThreadDetails;
+typedef struct _GumThreadSuspension GumThreadSuspension;
 typedef struct _GumModuleDetails GumModuleDetails;
 typedef guint GumImportType;
 typedef guint GumExportType;
 typedef guint GumSymbolType;
 typedef struct _GumImportDetails GumImportDetails;
 typedef struct _GumExportDetails GumExportDetails;
+typedef struct _GumExportTable GumExportTable;
+typedef struct _GumExportTableEntry GumExportTableEntry;
 typedef struct _GumSymbolDetails GumSymbolDetails;
 typedef struct _GumSymbolSection GumSymbolSection;
 typedef struct _GumRangeDetails GumRangeDetails;
@@ -109,6 +112,26 @@ struct _GumExportDetails
   GumAddress address;
 };
 
+struct _GumExportTableEntry
+{
+  guint32 name_offset;
+  guint32 type;
+  GumAddress address;
+};
+
+/*
+ * Packed export snapshot: entries are sorted by name, with names stored as
+ * offsets into one shared string arena, so consumers can keep and query it
+ * without any further allocations or copies.
+ */
+struct _GumExportTable
+{
+  GumExportTableEntry * entries;
+  guint n_entries;
+  gchar * strings;
+  gsize strings_size;
+};
+
 struct _GumSymbolDetails
 {
   gboolean is_global;
@@ -173,6 +196,9 @@ GUM_API gboolean gum_process_modify_thread (GumThreadId thread_id,
     GumModifyThreadFunc func, gpointer user_data);
 GUM_API void gum_process_enumerate_threads (GumFoundThreadFunc func,
     gpointer user_data);
+GUM_API GumThreadSuspension * gum_process_suspend_threads (
+    const GumThreadId * thread_ids, guint n_threads);
+GUM_API void gum_process_resume_threads (GumThreadSuspension * suspension);
 GUM_API void gum_process_enumerate_modules (GumFoundModuleFunc func,
     gpointer user_data);
 GUM_API void gum_process_enumerate_ranges (GumPageProtection prot,
@@ -189,6 +215,13 @@ GUM_API void gum_module_enumerate_imports (const gchar * module_name,
     GumFoundImportFunc func, gpointer user_data);
 GUM_API void gum_module_enumerate_exports (const gchar * module_name,
     GumFoundExportFunc func, gpointer user_data);
+GUM_API GumExportTable * gum_module_collect_exports (
+    const gchar * module_name);
+GUM_API const GumExportTableEntry * gum_export_table_find (
+    const GumExportTable * self, const gchar * name);
+GUM_API const gchar * gum_export_table_entry_get_name (
+    const GumExportTable * self, const GumExportTableEntry * entry);
+GUM_API void gum_export_table_free (GumExportTable * self);
 GUM_API void gum_module_enumerate_symbols (const gchar * module_name,
     GumFoundSymbolFunc func, gpointer user_data);
 GUM_API void gum_module_enumerate_ranges (const gchar * module_name,
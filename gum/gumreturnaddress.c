@@ -30,6 +30,41 @@ gum_return_address_details_from_address (GumReturnAddress address,
   return FALSE;
 }
 
+void
+gum_return_address_array_load_details (const GumReturnAddressArray * array,
+                                       GumReturnAddressDetails * details,
+                                       gboolean * resolved)
+{
+  guint i, j;
+
+  for (i = 0; i != array->len; i++)
+  {
+    GumReturnAddress address = array->items[i];
+    gboolean already_resolved = FALSE;
+
+    /*
+     * Backtraces tend to repeat addresses, so resolve each distinct address
+     * only once and copy the result into any later duplicates.
+     */
+    for (j = 0; j != i; j++)
+    {
+      if (array->items[j] == address)
+      {
+        details[i] = details[j];
+        resolved[i] = resolved[j];
+        already_resolved = TRUE;
+        break;
+      }
+    }
+
+    if (already_resolved)
+      continue;
+
+    resolved[i] =
+        gum_return_address_details_from_address (address, &details[i]);
+  }
+}
+
 gboolean
 gum_return_address_array_is_equal (const GumReturnAddressArray * array1,
                                    const GumReturnAddressArray * array2)
@@ -33,6 +33,10 @@ G_BEGIN_DECLS
 GUM_API gboolean gum_return_address_details_from_address (
     GumReturnAddress address, GumReturnAddressDetails * details);
 
+GUM_API void gum_return_address_array_load_details (
+    const GumReturnAddressArray * array, GumReturnAddressDetails * details,
+    gboolean * resolved);
+
 GUM_API gboolean gum_return_address_array_is_equal (
     const GumReturnAddressArray * array1,
     const GumReturnAddressArray * array2);
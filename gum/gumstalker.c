@@ -6,6 +6,16 @@
 
 #include "gumstalker.h"
 
+#include "guminterceptor.h"
+#include "gumprocess.h"
+
+#define GUM_TYPE_THREAD_SPAWN_MONITOR (gum_thread_spawn_monitor_get_type ())
+G_DECLARE_FINAL_TYPE (GumThreadSpawnMonitor, gum_thread_spawn_monitor, GUM,
+    THREAD_SPAWN_MONITOR, GObject)
+
+typedef struct _GumFollowAllOperation GumFollowAllOperation;
+typedef struct _GumThreadStartRoutine GumThreadStartRoutine;
+
 struct _GumDefaultStalkerTransformer
 {
   GObject parent;
@@ -20,6 +30,46 @@ struct _GumCallbackStalkerTransformer
   GDestroyNotify data_destroy;
 };
 
+struct _GumThreadSpawnMonitor
+{
+  GObject parent;
+
+  GumStalker * stalker;
+  GumStalkerTransformer * transformer;
+  GumEventSink * sink;
+  GumInterceptor * interceptor;
+};
+
+struct _GumFollowAllOperation
+{
+  GumStalker * stalker;
+  GumStalkerTransformer * transformer;
+  GumEventSink * sink;
+  GumThreadId current_thread_id;
+};
+
+struct _GumThreadStartRoutine
+{
+  GumThreadSpawnMonitor * monitor;
+  gpointer func;
+  gpointer data;
+};
+
+static void gum_thread_spawn_monitor_iface_init (gpointer g_iface,
+    gpointer iface_data);
+static void gum_thread_spawn_monitor_dispose (GObject * object);
+static void gum_thread_spawn_monitor_on_enter (
+    GumInvocationListener * listener, GumInvocationContext * context);
+static void gum_thread_spawn_monitor_on_leave (
+    GumInvocationListener * listener, GumInvocationContext * context);
+#ifndef HAVE_WINDOWS
+static gpointer gum_thread_start_routine_invoke (gpointer data);
+#endif
+static gboolean gum_stalker_follow_enumerated_thread (
+    const GumThreadDetails * details, gpointer user_data);
+static gboolean gum_stalker_unfollow_enumerated_thread (
+    const GumThreadDetails * details, gpointer user_data);
+
 static void gum_default_stalker_transformer_iface_init (gpointer g_iface,
     gpointer iface_data);
 static void gum_default_stalker_transformer_transform_block (
@@ -50,6 +100,13 @@ G_DEFINE_TYPE_EXTENDED (GumCallbackStalkerTransformer,
                         G_IMPLEMENT_INTERFACE (GUM_TYPE_STALKER_TRANSFORMER,
                             gum_callback_stalker_transformer_iface_init))
 
+G_DEFINE_TYPE_EXTENDED (GumThreadSpawnMonitor,
+                        gum_thread_spawn_monitor,
+                        G_TYPE_OBJECT,
+                        0,
+                        G_IMPLEMENT_INTERFACE (GUM_TYPE_INVOCATION_LISTENER,
+                            gum_thread_spawn_monitor_iface_init))
+
 static void
 gum_stalker_transformer_default_init (GumStalkerTransformerInterface * iface)
 {
@@ -171,3 +228,212 @@ gum_callback_stalker_transformer_transform_block (
 
   self->callback (iterator, output, self->data);
 }
+
+/*
+ * Follows every thread in the process with a shared transformer and sink.
+ *
+ * A thread-creation hook is installed before the thread list is
+ * snapshotted, so a thread spawned while the snapshot is being followed is
+ * picked up by the hook instead of slipping through the gap; threads
+ * created afterwards start life followed, before their start routine runs
+ * a single instruction. The hook relies on pthread_create and is therefore
+ * POSIX-only; elsewhere only the threads present at call time are
+ * followed. Balance with gum_stalker_unfollow_all().
+ */
+void
+gum_stalker_follow_all (GumStalker * self,
+                        GumStalkerTransformer * transformer,
+                        GumEventSink * sink)
+{
+  GumThreadSpawnMonitor * monitor;
+  GumFollowAllOperation op;
+
+  monitor = g_object_new (GUM_TYPE_THREAD_SPAWN_MONITOR, NULL);
+  monitor->stalker = g_object_ref (self);
+  monitor->transformer =
+      (transformer != NULL) ? g_object_ref (transformer) : NULL;
+  monitor->sink = (sink != NULL) ? g_object_ref (sink) : NULL;
+  monitor->interceptor = gum_interceptor_obtain ();
+
+#ifndef HAVE_WINDOWS
+  {
+    GumAddress create_impl;
+
+    create_impl = gum_module_find_export_by_name (NULL, "pthread_create");
+    if (create_impl != 0)
+    {
+      gum_interceptor_attach (monitor->interceptor,
+          GSIZE_TO_POINTER (create_impl), GUM_INVOCATION_LISTENER (monitor),
+          NULL);
+    }
+  }
+#endif
+
+  g_object_set_data_full (G_OBJECT (self), "gum-thread-spawn-monitor",
+      monitor, g_object_unref);
+
+  op.stalker = self;
+  op.transformer = transformer;
+  op.sink = sink;
+  op.current_thread_id = gum_process_get_current_thread_id ();
+  gum_process_enumerate_threads (gum_stalker_follow_enumerated_thread, &op);
+
+  gum_stalker_follow_me (self, transformer, sink);
+}
+
+void
+gum_stalker_unfollow_all (GumStalker * self)
+{
+  GumThreadSpawnMonitor * monitor;
+  GumFollowAllOperation op;
+
+  monitor = g_object_steal_data (G_OBJECT (self), "gum-thread-spawn-monitor");
+  if (monitor != NULL)
+  {
+    gum_interceptor_detach (monitor->interceptor,
+        GUM_INVOCATION_LISTENER (monitor));
+    g_object_unref (monitor);
+  }
+
+  if (gum_stalker_is_following_me (self))
+    gum_stalker_unfollow_me (self);
+
+  op.stalker = self;
+  op.transformer = NULL;
+  op.sink = NULL;
+  op.current_thread_id = gum_process_get_current_thread_id ();
+  gum_process_enumerate_threads (gum_stalker_unfollow_enumerated_thread, &op);
+}
+
+static gboolean
+gum_stalker_follow_enumerated_thread (const GumThreadDetails * details,
+                                      gpointer user_data)
+{
+  GumFollowAllOperation * op = user_data;
+
+  if (details->id != op->current_thread_id)
+  {
+    gum_stalker_follow (op->stalker, details->id, op->transformer, op->sink);
+  }
+
+  return TRUE;
+}
+
+static gboolean
+gum_stalker_unfollow_enumerated_thread (const GumThreadDetails * details,
+                                        gpointer user_data)
+{
+  GumFollowAllOperation * op = user_data;
+
+  if (details->id != op->current_thread_id)
+    gum_stalker_unfollow (op->stalker, details->id);
+
+  return TRUE;
+}
+
+static void
+gum_thread_spawn_monitor_class_init (GumThreadSpawnMonitorClass * klass)
+{
+  GObjectClass * object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = gum_thread_spawn_monitor_dispose;
+}
+
+static void
+gum_thread_spawn_monitor_iface_init (gpointer g_iface,
+                                     gpointer iface_data)
+{
+  GumInvocationListenerInterface * iface = g_iface;
+
+  iface->on_enter = gum_thread_spawn_monitor_on_enter;
+  iface->on_leave = gum_thread_spawn_monitor_on_leave;
+}
+
+static void
+gum_thread_spawn_monitor_init (GumThreadSpawnMonitor * self)
+{
+}
+
+static void
+gum_thread_spawn_monitor_dispose (GObject * object)
+{
+  GumThreadSpawnMonitor * self = GUM_THREAD_SPAWN_MONITOR (object);
+
+  g_clear_object (&self->interceptor);
+  g_clear_object (&self->sink);
+  g_clear_object (&self->transformer);
+  g_clear_object (&self->stalker);
+
+  G_OBJECT_CLASS (gum_thread_spawn_monitor_parent_class)->dispose (object);
+}
+
+/*
+ * Redirects the new thread through a start routine that follows it first,
+ * so no instruction of the user's routine executes untraced. The routine
+ * wrapper runs on the new thread; the creator only swaps two arguments.
+ */
+static void
+gum_thread_spawn_monitor_on_enter (GumInvocationListener * listener,
+                                   GumInvocationContext * context)
+{
+#ifndef HAVE_WINDOWS
+  GumThreadSpawnMonitor * self = GUM_THREAD_SPAWN_MONITOR (listener);
+  GumThreadStartRoutine * routine;
+
+  routine = g_slice_new (GumThreadStartRoutine);
+  routine->monitor = g_object_ref (self);
+  routine->func = gum_invocation_context_get_nth_argument (context, 2);
+  routine->data = gum_invocation_context_get_nth_argument (context, 3);
+
+  gum_invocation_context_replace_nth_argument (context, 2,
+      GUM_FUNCPTR_TO_POINTER (gum_thread_start_routine_invoke));
+  gum_invocation_context_replace_nth_argument (context, 3, routine);
+
+  *GUM_IC_GET_INVOCATION_DATA (context, GumThreadStartRoutine *) = routine;
+#endif
+}
+
+static void
+gum_thread_spawn_monitor_on_leave (GumInvocationListener * listener,
+                                   GumInvocationContext * context)
+{
+#ifndef HAVE_WINDOWS
+  if (GPOINTER_TO_SIZE (gum_invocation_context_get_return_value (context))
+      != 0)
+  {
+    GumThreadStartRoutine * routine;
+
+    routine =
+        *GUM_IC_GET_INVOCATION_DATA (context, GumThreadStartRoutine *);
+    g_object_unref (routine->monitor);
+    g_slice_free (GumThreadStartRoutine, routine);
+  }
+#endif
+}
+
+#ifndef HAVE_WINDOWS
+
+static gpointer
+gum_thread_start_routine_invoke (gpointer data)
+{
+  GumThreadStartRoutine * routine = data;
+  GumThreadSpawnMonitor * monitor = routine->monitor;
+  gpointer (* func) (gpointer) = GUM_POINTER_TO_FUNCPTR (
+      gpointer (*) (gpointer), routine->func);
+  gpointer arg = routine->data;
+  gpointer result;
+
+  gum_stalker_follow_me (monitor->stalker, monitor->transformer,
+      monitor->sink);
+
+  result = func (arg);
+
+  gum_stalker_unfollow_me (monitor->stalker);
+
+  g_object_unref (monitor);
+  g_slice_free (GumThreadStartRoutine, routine);
+
+  return result;
+}
+
+#endif
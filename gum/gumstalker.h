@@ -17,6 +17,7 @@
 #include <gum/arch-mips/gummipswriter.h>
 #include <gum/gumdefs.h>
 #include <gum/gumeventsink.h>
+#include <gum/gummodulemap.h>
 #include <gum/gumprocess.h>
 
 G_BEGIN_DECLS
@@ -48,10 +49,37 @@ typedef void (* GumStalkerTransformerCallback) (GumStalkerIterator * iterator,
 typedef void (* GumStalkerCallout) (GumCpuContext * cpu_context,
     gpointer user_data);
 
+typedef enum _GumStalkerCalloutFlags
+{
+  GUM_STALKER_CALLOUT_DEFAULT    = 0,
+
+  /*
+   * The callout does not inspect or modify the CPU context, so the backend
+   * only needs to preserve the registers clobbered by the call itself and
+   * invokes the callout with a NULL cpu_context.
+   */
+  GUM_STALKER_CALLOUT_NO_CONTEXT = 1 << 0,
+} GumStalkerCalloutFlags;
+
 typedef guint GumProbeId;
 typedef struct _GumCallSite GumCallSite;
 typedef void (* GumCallProbeCallback) (GumCallSite * site, gpointer user_data);
 
+typedef struct _GumStalkerStats GumStalkerStats;
+
+struct _GumStalkerStats
+{
+  guint blocks_compiled;
+  guint blocks_recycled;
+  gsize slab_bytes;
+  guint slab_count;
+  gsize slab_huge_bytes;
+  guint indirect_lookups;
+  guint ret_predictions;
+  guint ret_mispredicts;
+  guint64 translation_time_us;
+};
+
 struct _GumStalkerTransformerInterface
 {
   GTypeInterface parent;
@@ -89,15 +117,37 @@ GUM_API GumStalker * gum_stalker_new (void);
 
 GUM_API void gum_stalker_exclude (GumStalker * self,
     const GumMemoryRange * range);
+GUM_API void gum_stalker_exclude_module_map (GumStalker * self,
+    GumModuleMap * map);
+
+GUM_API void gum_stalker_set_event_mask_for_range (GumStalker * self,
+    const GumMemoryRange * range, GumEventType mask);
 
 GUM_API gint gum_stalker_get_trust_threshold (GumStalker * self);
 GUM_API void gum_stalker_set_trust_threshold (GumStalker * self,
     gint trust_threshold);
 
+GUM_API gboolean gum_stalker_get_trusts_immutable_code (GumStalker * self);
+GUM_API void gum_stalker_set_trusts_immutable_code (GumStalker * self,
+    gboolean trusts_immutable_code);
+
+GUM_API void gum_stalker_set_coverage_bitmap (GumStalker * self,
+    guint8 * bitmap, gsize size);
+
+GUM_API gsize gum_stalker_get_code_memory_limit (GumStalker * self);
+GUM_API void gum_stalker_set_code_memory_limit (GumStalker * self,
+    gsize limit);
+
+GUM_API void gum_stalker_set_background_compilation (GumStalker * self,
+    gboolean enabled);
+
 GUM_API void gum_stalker_flush (GumStalker * self);
 GUM_API void gum_stalker_stop (GumStalker * self);
 GUM_API gboolean gum_stalker_garbage_collect (GumStalker * self);
 
+GUM_API void gum_stalker_prefetch (GumStalker * self, gconstpointer address,
+    gint recycle_count);
+
 GUM_API void gum_stalker_follow_me (GumStalker * self,
     GumStalkerTransformer * transformer, GumEventSink * sink);
 GUM_API void gum_stalker_unfollow_me (GumStalker * self);
@@ -106,6 +156,9 @@ GUM_API gboolean gum_stalker_is_following_me (GumStalker * self);
 GUM_API void gum_stalker_follow (GumStalker * self, GumThreadId thread_id,
     GumStalkerTransformer * transformer, GumEventSink * sink);
 GUM_API void gum_stalker_unfollow (GumStalker * self, GumThreadId thread_id);
+GUM_API void gum_stalker_follow_all (GumStalker * self,
+    GumStalkerTransformer * transformer, GumEventSink * sink);
+GUM_API void gum_stalker_unfollow_all (GumStalker * self);
 
 GUM_API void gum_stalker_activate (GumStalker * self, gconstpointer target);
 GUM_API void gum_stalker_deactivate (GumStalker * self);
@@ -135,6 +188,12 @@ GUM_API gboolean gum_stalker_iterator_next (GumStalkerIterator * self,
 GUM_API void gum_stalker_iterator_keep (GumStalkerIterator * self);
 GUM_API void gum_stalker_iterator_put_callout (GumStalkerIterator * self,
     GumStalkerCallout callout, gpointer data, GDestroyNotify data_destroy);
+GUM_API void gum_stalker_iterator_put_callout_with_flags (
+    GumStalkerIterator * self, GumStalkerCallout callout, gpointer data,
+    GDestroyNotify data_destroy, GumStalkerCalloutFlags flags);
+
+GUM_API gboolean gum_stalker_query_stats (GumStalker * self,
+    GumThreadId thread_id, GumStalkerStats * stats);
 
 GUM_API void gum_stalker_set_counters_enabled (gboolean enabled);
 GUM_API void gum_stalker_dump_counters (void);
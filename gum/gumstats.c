@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2020 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#include "gumstats.h"
+
+/*
+ * Always-on counters cheap enough for the hottest paths in the library:
+ * each counter is sharded across cache-line-sized slots, picked by a
+ * hash of the caller's stack page so threads on different stacks bump
+ * different lines, and summed only when somebody asks. Reads are
+ * lock-free and may observe a snapshot that is slightly behind
+ * concurrent writers, which is fine for monitoring purposes.
+ */
+
+#define GUM_STATS_NUM_SHARDS 16
+#define GUM_STATS_SHARD_SIZE 64
+
+typedef struct _GumStatsShard GumStatsShard;
+
+struct _GumStatsShard
+{
+  gsize counters[GUM_STAT_COUNT];
+  guint8 padding[GUM_STATS_SHARD_SIZE -
+      ((GUM_STAT_COUNT * sizeof (gsize)) % GUM_STATS_SHARD_SIZE)];
+};
+
+G_STATIC_ASSERT (GUM_STAT_COUNT * sizeof (gsize) < GUM_STATS_SHARD_SIZE);
+
+static GumStatsShard gum_stats_shards[GUM_STATS_NUM_SHARDS];
+
+static const gchar * gum_stats_names[GUM_STAT_COUNT] =
+{
+  "interceptor-hits",
+  "memory-scan-bytes",
+  "stalker-blocks-compiled",
+  "exceptor-exceptions-handled",
+};
+
+void
+gum_stats_add (GumStatId id,
+               gsize delta)
+{
+  guint shard_index;
+
+  shard_index = (GPOINTER_TO_SIZE (&delta) / 4096) &
+      (GUM_STATS_NUM_SHARDS - 1);
+
+  g_atomic_pointer_add (&gum_stats_shards[shard_index].counters[id],
+      (gssize) delta);
+}
+
+gsize
+gum_stats_get (GumStatId id)
+{
+  gsize total = 0;
+  guint i;
+
+  for (i = 0; i != GUM_STATS_NUM_SHARDS; i++)
+  {
+    total += (gsize) g_atomic_pointer_get (
+        &gum_stats_shards[i].counters[id]);
+  }
+
+  return total;
+}
+
+void
+gum_stats_snapshot (gsize * counters,
+                    guint n_counters)
+{
+  guint id;
+
+  for (id = 0; id != n_counters && id != GUM_STAT_COUNT; id++)
+    counters[id] = gum_stats_get (id);
+}
+
+const gchar *
+gum_stats_get_name (GumStatId id)
+{
+  return gum_stats_names[id];
+}
@@ -0,0 +1,31 @@
+/*
+ * Copyright (C) 2020 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#ifndef __GUM_STATS_H__
+#define __GUM_STATS_H__
+
+#include <gum/gumdefs.h>
+
+G_BEGIN_DECLS
+
+typedef enum _GumStatId
+{
+  GUM_STAT_INTERCEPTOR_HITS,
+  GUM_STAT_MEMORY_SCAN_BYTES,
+  GUM_STAT_STALKER_BLOCKS_COMPILED,
+  GUM_STAT_EXCEPTOR_EXCEPTIONS_HANDLED,
+
+  GUM_STAT_COUNT
+} GumStatId;
+
+GUM_API void gum_stats_add (GumStatId id, gsize delta);
+GUM_API gsize gum_stats_get (GumStatId id);
+GUM_API void gum_stats_snapshot (gsize * counters, guint n_counters);
+GUM_API const gchar * gum_stats_get_name (GumStatId id);
+
+G_END_DECLS
+
+#endif
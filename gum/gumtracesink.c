@@ -0,0 +1,616 @@
+/*
+ * Copyright (C) 2020 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#include "gumtracesink.h"
+
+#include "gumlz4writer.h"
+#include "gummodulemap.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define GUM_TRACE_MAGIC "GUMTRACE"
+#define GUM_TRACE_VERSION 1
+#define GUM_TRACE_CHUNK_CAPACITY (64 * 1024)
+
+typedef struct _GumTraceFileHeader GumTraceFileHeader;
+typedef struct _GumTraceChunkHeader GumTraceChunkHeader;
+typedef struct _GumTraceModuleRecord GumTraceModuleRecord;
+typedef struct _GumTraceThreadRecord GumTraceThreadRecord;
+typedef struct _GumTraceFileTrailer GumTraceFileTrailer;
+typedef struct _GumTraceThreadState GumTraceThreadState;
+
+#pragma pack (push, 1)
+
+struct _GumTraceFileHeader
+{
+  gchar magic[8];
+  guint32 version;
+  guint32 reserved;
+};
+
+struct _GumTraceChunkHeader
+{
+  guint64 thread_id;
+  guint32 n_events;
+  guint32 size;
+};
+
+struct _GumTraceModuleRecord
+{
+  guint64 base_address;
+  guint64 size;
+  guint32 path_length;
+};
+
+struct _GumTraceThreadRecord
+{
+  guint64 thread_id;
+  guint64 n_events;
+};
+
+struct _GumTraceFileTrailer
+{
+  guint64 module_table_offset;
+  guint64 thread_index_offset;
+  guint32 n_modules;
+  guint32 n_threads;
+  gchar magic[8];
+};
+
+#pragma pack (pop)
+
+struct _GumTraceThreadState
+{
+  GumEventEncoder encoder;
+  guint32 pending_events;
+  guint64 n_events;
+};
+
+struct _GumTraceEventSink
+{
+  GObject parent;
+
+  gchar * path;
+  GumEventType mask;
+  FILE * file;
+  GumLz4Writer * lz4;
+  GMutex mutex;
+  GHashTable * state_by_thread_id;
+  GumModuleMap * modules;
+};
+
+struct _GumTraceReader
+{
+  GMappedFile * file;
+  const guint8 * data;
+  gsize size;
+  const GumTraceFileTrailer * trailer;
+  const guint8 * events_begin;
+  const guint8 * events_end;
+};
+
+static void gum_trace_event_sink_iface_init (gpointer g_iface,
+    gpointer iface_data);
+static void gum_trace_event_sink_finalize (GObject * object);
+static GumEventType gum_trace_event_sink_query_mask (GumEventSink * sink);
+static void gum_trace_event_sink_start (GumEventSink * sink);
+static void gum_trace_event_sink_process (GumEventSink * sink,
+    const GumEvent * event, GumCpuContext * cpu_context);
+static void gum_trace_event_sink_process_batch (GumEventSink * sink,
+    const GumEvent * events, guint n_events);
+static void gum_trace_event_sink_flush (GumEventSink * sink);
+static void gum_trace_event_sink_stop (GumEventSink * sink);
+static gboolean gum_trace_event_sink_is_open (GumTraceEventSink * self);
+static void gum_trace_event_sink_write (GumTraceEventSink * self,
+    gconstpointer data, gsize size);
+static guint64 gum_trace_event_sink_tell (GumTraceEventSink * self);
+static GumTraceThreadState * gum_trace_event_sink_get_state (
+    GumTraceEventSink * self, GumThreadId thread_id);
+static void gum_trace_event_sink_write_chunk (GumTraceEventSink * self,
+    GumThreadId thread_id, GumTraceThreadState * state);
+static void gum_trace_event_sink_write_pending (GumTraceEventSink * self);
+static void gum_trace_event_sink_finish_file (GumTraceEventSink * self);
+static void gum_trace_thread_state_free (gpointer data);
+
+G_DEFINE_TYPE_EXTENDED (GumTraceEventSink,
+                        gum_trace_event_sink,
+                        G_TYPE_OBJECT,
+                        0,
+                        G_IMPLEMENT_INTERFACE (GUM_TYPE_EVENT_SINK,
+                            gum_trace_event_sink_iface_init))
+
+GumEventSink *
+gum_trace_event_sink_new (const gchar * path,
+                          GumEventType mask)
+{
+  GumTraceEventSink * sink;
+
+  sink = g_object_new (GUM_TYPE_TRACE_EVENT_SINK, NULL);
+  sink->path = g_strdup (path);
+  sink->mask = mask;
+
+  return GUM_EVENT_SINK (sink);
+}
+
+static void
+gum_trace_event_sink_class_init (GumTraceEventSinkClass * klass)
+{
+  GObjectClass * object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gum_trace_event_sink_finalize;
+}
+
+static void
+gum_trace_event_sink_iface_init (gpointer g_iface,
+                                 gpointer iface_data)
+{
+  GumEventSinkInterface * iface = g_iface;
+
+  iface->query_mask = gum_trace_event_sink_query_mask;
+  iface->start = gum_trace_event_sink_start;
+  iface->process = gum_trace_event_sink_process;
+  iface->process_batch = gum_trace_event_sink_process_batch;
+  iface->flush = gum_trace_event_sink_flush;
+  iface->stop = gum_trace_event_sink_stop;
+}
+
+static void
+gum_trace_event_sink_init (GumTraceEventSink * self)
+{
+  g_mutex_init (&self->mutex);
+  self->state_by_thread_id = g_hash_table_new_full (NULL, NULL, NULL,
+      gum_trace_thread_state_free);
+}
+
+static void
+gum_trace_event_sink_finalize (GObject * object)
+{
+  GumTraceEventSink * self = GUM_TRACE_EVENT_SINK (object);
+
+  gum_trace_event_sink_finish_file (self);
+
+  g_clear_object (&self->modules);
+  g_hash_table_unref (self->state_by_thread_id);
+  g_mutex_clear (&self->mutex);
+  g_free (self->path);
+
+  G_OBJECT_CLASS (gum_trace_event_sink_parent_class)->finalize (object);
+}
+
+static GumEventType
+gum_trace_event_sink_query_mask (GumEventSink * sink)
+{
+  return GUM_TRACE_EVENT_SINK (sink)->mask;
+}
+
+static void
+gum_trace_event_sink_start (GumEventSink * sink)
+{
+  GumTraceEventSink * self = GUM_TRACE_EVENT_SINK (sink);
+  GumTraceFileHeader header;
+
+  if (gum_trace_event_sink_is_open (self))
+    return;
+
+  /*
+   * A path ending in ".lz4" opts in to transparent compression: the exact
+   * same container is produced, wrapped in a standard LZ4 frame. Decompress
+   * with any lz4 tool before handing the result to GumTraceReader.
+   */
+  if (g_str_has_suffix (self->path, ".lz4"))
+    self->lz4 = gum_lz4_writer_open (self->path);
+  else
+    self->file = fopen (self->path, "wb");
+  if (!gum_trace_event_sink_is_open (self))
+    return;
+
+  memcpy (header.magic, GUM_TRACE_MAGIC, sizeof (header.magic));
+  header.version = GUM_TRACE_VERSION;
+  header.reserved = 0;
+  gum_trace_event_sink_write (self, &header, sizeof (header));
+
+  if (self->modules == NULL)
+    self->modules = gum_module_map_new ();
+}
+
+static void
+gum_trace_event_sink_process (GumEventSink * sink,
+                              const GumEvent * event,
+                              GumCpuContext * cpu_context)
+{
+  gum_trace_event_sink_process_batch (sink, event, 1);
+}
+
+static void
+gum_trace_event_sink_process_batch (GumEventSink * sink,
+                                    const GumEvent * events,
+                                    guint n_events)
+{
+  GumTraceEventSink * self = GUM_TRACE_EVENT_SINK (sink);
+  GumThreadId thread_id = gum_process_get_current_thread_id ();
+  GumTraceThreadState * state;
+  gsize size;
+
+  g_mutex_lock (&self->mutex);
+
+  if (!gum_trace_event_sink_is_open (self))
+    goto beach;
+
+  state = gum_trace_event_sink_get_state (self, thread_id);
+
+  gum_event_encoder_encode_batch (&state->encoder, events, n_events);
+  state->pending_events += n_events;
+  state->n_events += n_events;
+
+  gum_event_encoder_peek (&state->encoder, &size);
+  if (size >= GUM_TRACE_CHUNK_CAPACITY)
+    gum_trace_event_sink_write_chunk (self, thread_id, state);
+
+beach:
+  g_mutex_unlock (&self->mutex);
+}
+
+static void
+gum_trace_event_sink_flush (GumEventSink * sink)
+{
+  GumTraceEventSink * self = GUM_TRACE_EVENT_SINK (sink);
+
+  g_mutex_lock (&self->mutex);
+
+  if (gum_trace_event_sink_is_open (self))
+  {
+    gum_trace_event_sink_write_pending (self);
+
+    if (self->lz4 != NULL)
+      gum_lz4_writer_flush (self->lz4);
+    else
+      fflush (self->file);
+  }
+
+  g_mutex_unlock (&self->mutex);
+}
+
+static void
+gum_trace_event_sink_stop (GumEventSink * sink)
+{
+  gum_trace_event_sink_finish_file (GUM_TRACE_EVENT_SINK (sink));
+}
+
+static gboolean
+gum_trace_event_sink_is_open (GumTraceEventSink * self)
+{
+  return self->file != NULL || self->lz4 != NULL;
+}
+
+static void
+gum_trace_event_sink_write (GumTraceEventSink * self,
+                            gconstpointer data,
+                            gsize size)
+{
+  if (self->lz4 != NULL)
+    gum_lz4_writer_write (self->lz4, data, size);
+  else
+    fwrite (data, size, 1, self->file);
+}
+
+static guint64
+gum_trace_event_sink_tell (GumTraceEventSink * self)
+{
+  if (self->lz4 != NULL)
+    return gum_lz4_writer_tell (self->lz4);
+
+  return (guint64) ftell (self->file);
+}
+
+static GumTraceThreadState *
+gum_trace_event_sink_get_state (GumTraceEventSink * self,
+                                GumThreadId thread_id)
+{
+  GumTraceThreadState * state;
+
+  state = g_hash_table_lookup (self->state_by_thread_id,
+      GSIZE_TO_POINTER (thread_id));
+  if (state == NULL)
+  {
+    state = g_slice_new0 (GumTraceThreadState);
+    gum_event_encoder_init (&state->encoder);
+    g_hash_table_insert (self->state_by_thread_id,
+        GSIZE_TO_POINTER (thread_id), state);
+  }
+
+  return state;
+}
+
+static void
+gum_trace_event_sink_write_chunk (GumTraceEventSink * self,
+                                  GumThreadId thread_id,
+                                  GumTraceThreadState * state)
+{
+  GumTraceChunkHeader header;
+  const guint8 * data;
+  gsize size;
+
+  data = gum_event_encoder_peek (&state->encoder, &size);
+  if (size == 0)
+    return;
+
+  header.thread_id = thread_id;
+  header.n_events = state->pending_events;
+  header.size = (guint32) size;
+
+  gum_trace_event_sink_write (self, &header, sizeof (header));
+  gum_trace_event_sink_write (self, data, size);
+
+  gum_event_encoder_reset (&state->encoder);
+  state->pending_events = 0;
+}
+
+static void
+gum_trace_event_sink_write_pending (GumTraceEventSink * self)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+
+  g_hash_table_iter_init (&iter, self->state_by_thread_id);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+  {
+    gum_trace_event_sink_write_chunk (self, GPOINTER_TO_SIZE (key), value);
+  }
+}
+
+static void
+gum_trace_event_sink_finish_file (GumTraceEventSink * self)
+{
+  GumTraceFileTrailer trailer;
+  GArray * modules;
+  GHashTableIter iter;
+  gpointer key, value;
+  guint i;
+
+  g_mutex_lock (&self->mutex);
+
+  if (!gum_trace_event_sink_is_open (self))
+    goto beach;
+
+  gum_trace_event_sink_write_pending (self);
+
+  trailer.module_table_offset = gum_trace_event_sink_tell (self);
+  trailer.n_modules = 0;
+
+  if (self->modules != NULL)
+  {
+    modules = gum_module_map_get_values (self->modules);
+    trailer.n_modules = modules->len;
+
+    for (i = 0; i != modules->len; i++)
+    {
+      GumModuleDetails * m = &g_array_index (modules, GumModuleDetails, i);
+      GumTraceModuleRecord record;
+
+      record.base_address = m->range->base_address;
+      record.size = m->range->size;
+      record.path_length = (guint32) strlen (m->path);
+
+      gum_trace_event_sink_write (self, &record, sizeof (record));
+      gum_trace_event_sink_write (self, m->path, record.path_length);
+    }
+  }
+
+  trailer.thread_index_offset = gum_trace_event_sink_tell (self);
+  trailer.n_threads = g_hash_table_size (self->state_by_thread_id);
+
+  g_hash_table_iter_init (&iter, self->state_by_thread_id);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+  {
+    GumTraceThreadState * state = value;
+    GumTraceThreadRecord record;
+
+    record.thread_id = GPOINTER_TO_SIZE (key);
+    record.n_events = state->n_events;
+
+    gum_trace_event_sink_write (self, &record, sizeof (record));
+  }
+
+  memcpy (trailer.magic, GUM_TRACE_MAGIC, sizeof (trailer.magic));
+  gum_trace_event_sink_write (self, &trailer, sizeof (trailer));
+
+  if (self->lz4 != NULL)
+  {
+    gum_lz4_writer_close (self->lz4);
+    self->lz4 = NULL;
+  }
+  else
+  {
+    fclose (self->file);
+    self->file = NULL;
+  }
+
+beach:
+  g_mutex_unlock (&self->mutex);
+}
+
+static void
+gum_trace_thread_state_free (gpointer data)
+{
+  GumTraceThreadState * state = data;
+
+  gum_event_encoder_clear (&state->encoder);
+
+  g_slice_free (GumTraceThreadState, state);
+}
+
+GumTraceReader *
+gum_trace_reader_open (const gchar * path)
+{
+  GumTraceReader * reader;
+  GMappedFile * file;
+  const guint8 * data;
+  gsize size;
+  const GumTraceFileHeader * header;
+  const GumTraceFileTrailer * trailer;
+
+  file = g_mapped_file_new (path, FALSE, NULL);
+  if (file == NULL)
+    return NULL;
+
+  data = (const guint8 *) g_mapped_file_get_contents (file);
+  size = g_mapped_file_get_length (file);
+
+  if (size < sizeof (GumTraceFileHeader) + sizeof (GumTraceFileTrailer))
+    goto invalid_file;
+
+  header = (const GumTraceFileHeader *) data;
+  if (memcmp (header->magic, GUM_TRACE_MAGIC, sizeof (header->magic)) != 0 ||
+      header->version != GUM_TRACE_VERSION)
+    goto invalid_file;
+
+  trailer = (const GumTraceFileTrailer *)
+      (data + size - sizeof (GumTraceFileTrailer));
+  if (memcmp (trailer->magic, GUM_TRACE_MAGIC, sizeof (trailer->magic)) != 0)
+    goto invalid_file;
+
+  if (trailer->module_table_offset > size ||
+      trailer->thread_index_offset > size ||
+      trailer->module_table_offset < sizeof (GumTraceFileHeader) ||
+      trailer->thread_index_offset < trailer->module_table_offset)
+    goto invalid_file;
+
+  reader = g_slice_new (GumTraceReader);
+  reader->file = file;
+  reader->data = data;
+  reader->size = size;
+  reader->trailer = trailer;
+  reader->events_begin = data + sizeof (GumTraceFileHeader);
+  reader->events_end = data + trailer->module_table_offset;
+
+  return reader;
+
+invalid_file:
+  {
+    g_mapped_file_unref (file);
+
+    return NULL;
+  }
+}
+
+void
+gum_trace_reader_close (GumTraceReader * reader)
+{
+  g_mapped_file_unref (reader->file);
+
+  g_slice_free (GumTraceReader, reader);
+}
+
+guint
+gum_trace_reader_get_module_count (GumTraceReader * self)
+{
+  return self->trailer->n_modules;
+}
+
+gboolean
+gum_trace_reader_get_module (GumTraceReader * self,
+                             guint index,
+                             GumMemoryRange * range,
+                             const gchar ** path)
+{
+  const guint8 * cur = self->data + self->trailer->module_table_offset;
+  guint i;
+
+  if (index >= self->trailer->n_modules)
+    return FALSE;
+
+  for (i = 0; i != index; i++)
+  {
+    const GumTraceModuleRecord * record = (const GumTraceModuleRecord *) cur;
+
+    cur += sizeof (GumTraceModuleRecord) + record->path_length;
+  }
+
+  {
+    const GumTraceModuleRecord * record = (const GumTraceModuleRecord *) cur;
+
+    if (range != NULL)
+    {
+      range->base_address = record->base_address;
+      range->size = record->size;
+    }
+
+    if (path != NULL)
+      *path = (const gchar *) (cur + sizeof (GumTraceModuleRecord));
+  }
+
+  return TRUE;
+}
+
+guint
+gum_trace_reader_get_thread_count (GumTraceReader * self)
+{
+  return self->trailer->n_threads;
+}
+
+gboolean
+gum_trace_reader_get_thread (GumTraceReader * self,
+                             guint index,
+                             GumThreadId * thread_id,
+                             guint64 * n_events)
+{
+  const GumTraceThreadRecord * record;
+
+  if (index >= self->trailer->n_threads)
+    return FALSE;
+
+  record = (const GumTraceThreadRecord *)
+      (self->data + self->trailer->thread_index_offset) + index;
+
+  if (thread_id != NULL)
+    *thread_id = (GumThreadId) record->thread_id;
+
+  if (n_events != NULL)
+    *n_events = record->n_events;
+
+  return TRUE;
+}
+
+void
+gum_trace_reader_iter_init (GumTraceReaderIter * iter,
+                            GumTraceReader * reader)
+{
+  iter->reader = reader;
+  iter->chunk = reader->events_begin;
+  gum_event_decoder_init (&iter->decoder, NULL, 0);
+  iter->thread_id = 0;
+}
+
+gboolean
+gum_trace_reader_iter_next (GumTraceReaderIter * iter,
+                            GumThreadId * thread_id,
+                            GumEvent * ev)
+{
+  while (!gum_event_decoder_next (&iter->decoder, ev))
+  {
+    const GumTraceChunkHeader * header;
+    const guint8 * payload;
+
+    if (iter->chunk + sizeof (GumTraceChunkHeader) > iter->reader->events_end)
+      return FALSE;
+
+    header = (const GumTraceChunkHeader *) iter->chunk;
+    payload = iter->chunk + sizeof (GumTraceChunkHeader);
+
+    if (payload + header->size > iter->reader->events_end)
+      return FALSE;
+
+    gum_event_decoder_init (&iter->decoder, payload, header->size);
+    iter->thread_id = (GumThreadId) header->thread_id;
+    iter->chunk = payload + header->size;
+  }
+
+  if (thread_id != NULL)
+    *thread_id = iter->thread_id;
+
+  return TRUE;
+}
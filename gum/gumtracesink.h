@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2020 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#ifndef __GUM_TRACE_SINK_H__
+#define __GUM_TRACE_SINK_H__
+
+#include <gum/gumeventcodec.h>
+#include <gum/gumeventsink.h>
+#include <gum/gumprocess.h>
+
+G_BEGIN_DECLS
+
+#define GUM_TYPE_TRACE_EVENT_SINK (gum_trace_event_sink_get_type ())
+G_DECLARE_FINAL_TYPE (GumTraceEventSink, gum_trace_event_sink, GUM,
+    TRACE_EVENT_SINK, GObject)
+
+typedef struct _GumTraceReader GumTraceReader;
+typedef struct _GumTraceReaderIter GumTraceReaderIter;
+
+struct _GumTraceReaderIter
+{
+  /*< private >*/
+  GumTraceReader * reader;
+  const guint8 * chunk;
+  GumEventDecoder decoder;
+  GumThreadId thread_id;
+};
+
+GUM_API GumEventSink * gum_trace_event_sink_new (const gchar * path,
+    GumEventType mask);
+
+GUM_API GumTraceReader * gum_trace_reader_open (const gchar * path);
+GUM_API void gum_trace_reader_close (GumTraceReader * reader);
+
+GUM_API guint gum_trace_reader_get_module_count (GumTraceReader * self);
+GUM_API gboolean gum_trace_reader_get_module (GumTraceReader * self,
+    guint index, GumMemoryRange * range, const gchar ** path);
+
+GUM_API guint gum_trace_reader_get_thread_count (GumTraceReader * self);
+GUM_API gboolean gum_trace_reader_get_thread (GumTraceReader * self,
+    guint index, GumThreadId * thread_id, guint64 * n_events);
+
+GUM_API void gum_trace_reader_iter_init (GumTraceReaderIter * iter,
+    GumTraceReader * reader);
+GUM_API gboolean gum_trace_reader_iter_next (GumTraceReaderIter * iter,
+    GumThreadId * thread_id, GumEvent * ev);
+
+G_END_DECLS
+
+#endif
@@ -15,6 +15,33 @@
 #include "gumbacktracer.h"
 
 typedef struct _GumAllocationTrackerBlock GumAllocationTrackerBlock;
+typedef struct _GumAllocationTrackerShard GumAllocationTrackerShard;
+
+/*
+ * Notifications are sharded to keep allocator-heavy multi-threaded workloads
+ * from serializing on a single lock: blocks are sharded by address, and size
+ * groups by size, so any given size lives in exactly one shard and queries
+ * can simply concatenate the per-shard results.
+ */
+#define GUM_ALLOCATION_TRACKER_NUM_SHARDS 16
+
+#define GUM_ALLOCATION_TRACKER_SHARD_FOR_ADDRESS(self, address) \
+    (&(self)->shards[(GPOINTER_TO_SIZE (address) >> 4) & \
+        (GUM_ALLOCATION_TRACKER_NUM_SHARDS - 1)])
+#define GUM_ALLOCATION_TRACKER_SHARD_FOR_SIZE(self, size) \
+    (&(self)->shards[(((size) >> 4) ^ (size)) & \
+        (GUM_ALLOCATION_TRACKER_NUM_SHARDS - 1)])
+
+#define GUM_ALLOCATION_TRACKER_SHARD_FOR_STACK_HASH(self, hash) \
+    (&(self)->shards[(hash) & (GUM_ALLOCATION_TRACKER_NUM_SHARDS - 1)])
+
+struct _GumAllocationTrackerShard
+{
+  GMutex mutex;
+  GHashTable * known_blocks_ht;
+  GHashTable * block_groups_ht;
+  GHashTable * stack_summaries_ht;
+};
 
 struct _GumAllocationTracker
 {
@@ -22,17 +49,14 @@ struct _GumAllocationTracker
 
   gboolean disposed;
 
-  GMutex mutex;
-
   volatile gint enabled;
 
   GumAllocationTrackerFilterFunction filter_func;
   gpointer filter_func_user_data;
 
-  guint block_count;
-  guint block_total_size;
-  GHashTable * known_blocks_ht;
-  GHashTable * block_groups_ht;
+  volatile gint block_count;
+  volatile gint block_total_size;
+  GumAllocationTrackerShard shards[GUM_ALLOCATION_TRACKER_NUM_SHARDS];
 
   GumBacktracerInterface * backtracer_iface;
   GumBacktracer * backtracer_instance;
@@ -50,9 +74,6 @@ struct _GumAllocationTrackerBlock
   GumReturnAddress return_addresses[1];
 };
 
-#define GUM_ALLOCATION_TRACKER_LOCK(o) g_mutex_lock (&(o)->mutex)
-#define GUM_ALLOCATION_TRACKER_UNLOCK(o) g_mutex_unlock (&(o)->mutex)
-
 static void gum_allocation_tracker_constructed (GObject * object);
 static void gum_allocation_tracker_set_property (GObject * object,
     guint property_id, const GValue * value, GParamSpec * pspec);
@@ -66,6 +87,23 @@ static void gum_allocation_tracker_size_stats_add_block (
 static void gum_allocation_tracker_size_stats_remove_block (
     GumAllocationTracker * self, guint size);
 
+static void gum_allocation_tracker_stack_stats_add_block (
+    GumAllocationTracker * self, const GumReturnAddressArray * return_addresses,
+    guint size);
+static void gum_allocation_tracker_stack_stats_remove_block (
+    GumAllocationTracker * self, const GumReturnAddressArray * return_addresses,
+    guint size);
+static void gum_allocation_tracker_stack_stats_resize_block (
+    GumAllocationTracker * self, const GumReturnAddressArray * return_addresses,
+    guint old_size, guint new_size);
+static void gum_allocation_tracker_block_capture_return_addresses (
+    const GumAllocationTrackerBlock * block, GumReturnAddressArray * array);
+static void gum_allocation_stack_summary_free (
+    GumAllocationStackSummary * summary);
+static guint gum_return_address_array_hash (gconstpointer key);
+static gboolean gum_return_address_array_equal (gconstpointer a,
+    gconstpointer b);
+
 G_DEFINE_TYPE (GumAllocationTracker, gum_allocation_tracker, G_TYPE_OBJECT)
 
 static void
@@ -89,25 +127,38 @@ gum_allocation_tracker_class_init (GumAllocationTrackerClass * klass)
 static void
 gum_allocation_tracker_init (GumAllocationTracker * self)
 {
-  g_mutex_init (&self->mutex);
+  guint i;
+
+  for (i = 0; i != GUM_ALLOCATION_TRACKER_NUM_SHARDS; i++)
+    g_mutex_init (&self->shards[i].mutex);
 }
 
 static void
 gum_allocation_tracker_constructed (GObject * object)
 {
   GumAllocationTracker * self = GUM_ALLOCATION_TRACKER (object);
+  guint i;
 
-  if (self->backtracer_instance != NULL)
+  for (i = 0; i != GUM_ALLOCATION_TRACKER_NUM_SHARDS; i++)
   {
-    self->known_blocks_ht = g_hash_table_new_full (NULL, NULL, NULL, g_free);
-  }
-  else
-  {
-    self->known_blocks_ht = g_hash_table_new (NULL, NULL);
-  }
+    GumAllocationTrackerShard * shard = &self->shards[i];
 
-  self->block_groups_ht = g_hash_table_new_full (NULL, NULL, NULL,
-      (GDestroyNotify) gum_allocation_group_free);
+    if (self->backtracer_instance != NULL)
+    {
+      shard->known_blocks_ht = g_hash_table_new_full (NULL, NULL, NULL,
+          g_free);
+      shard->stack_summaries_ht = g_hash_table_new_full (
+          gum_return_address_array_hash, gum_return_address_array_equal, NULL,
+          (GDestroyNotify) gum_allocation_stack_summary_free);
+    }
+    else
+    {
+      shard->known_blocks_ht = g_hash_table_new (NULL, NULL);
+    }
+
+    shard->block_groups_ht = g_hash_table_new_full (NULL, NULL, NULL,
+        (GDestroyNotify) gum_allocation_group_free);
+  }
 }
 
 static void
@@ -168,14 +219,23 @@ gum_allocation_tracker_dispose (GObject * object)
   {
     self->disposed = TRUE;
 
+    guint i;
+
     g_clear_object (&self->backtracer_instance);
     self->backtracer_iface = NULL;
 
-    g_hash_table_unref (self->known_blocks_ht);
-    self->known_blocks_ht = NULL;
+    for (i = 0; i != GUM_ALLOCATION_TRACKER_NUM_SHARDS; i++)
+    {
+      GumAllocationTrackerShard * shard = &self->shards[i];
+
+      g_hash_table_unref (shard->known_blocks_ht);
+      shard->known_blocks_ht = NULL;
+
+      g_hash_table_unref (shard->block_groups_ht);
+      shard->block_groups_ht = NULL;
 
-    g_hash_table_unref (self->block_groups_ht);
-    self->block_groups_ht = NULL;
+      g_clear_pointer (&shard->stack_summaries_ht, g_hash_table_unref);
+    }
   }
 
   G_OBJECT_CLASS (gum_allocation_tracker_parent_class)->dispose (object);
@@ -185,8 +245,10 @@ static void
 gum_allocation_tracker_finalize (GObject * object)
 {
   GumAllocationTracker * self = GUM_ALLOCATION_TRACKER (object);
+  guint i;
 
-  g_mutex_clear (&self->mutex);
+  for (i = 0; i != GUM_ALLOCATION_TRACKER_NUM_SHARDS; i++)
+    g_mutex_clear (&self->shards[i].mutex);
 
   G_OBJECT_CLASS (gum_allocation_tracker_parent_class)->finalize (object);
 }
@@ -220,11 +282,21 @@ gum_allocation_tracker_set_filter_function (
 void
 gum_allocation_tracker_begin (GumAllocationTracker * self)
 {
-  GUM_ALLOCATION_TRACKER_LOCK (self);
-  self->block_count = 0;
-  self->block_total_size = 0;
-  g_hash_table_remove_all (self->known_blocks_ht);
-  GUM_ALLOCATION_TRACKER_UNLOCK (self);
+  guint i;
+
+  g_atomic_int_set (&self->block_count, 0);
+  g_atomic_int_set (&self->block_total_size, 0);
+
+  for (i = 0; i != GUM_ALLOCATION_TRACKER_NUM_SHARDS; i++)
+  {
+    GumAllocationTrackerShard * shard = &self->shards[i];
+
+    g_mutex_lock (&shard->mutex);
+    g_hash_table_remove_all (shard->known_blocks_ht);
+    if (shard->stack_summaries_ht != NULL)
+      g_hash_table_remove_all (shard->stack_summaries_ht);
+    g_mutex_unlock (&shard->mutex);
+  }
 
   g_atomic_int_set (&self->enabled, TRUE);
 }
@@ -232,60 +304,77 @@ gum_allocation_tracker_begin (GumAllocationTracker * self)
 void
 gum_allocation_tracker_end (GumAllocationTracker * self)
 {
+  guint i;
+
   g_atomic_int_set (&self->enabled, FALSE);
 
-  GUM_ALLOCATION_TRACKER_LOCK (self);
-  self->block_count = 0;
-  self->block_total_size = 0;
-  g_hash_table_remove_all (self->known_blocks_ht);
-  g_hash_table_remove_all (self->block_groups_ht);
-  GUM_ALLOCATION_TRACKER_UNLOCK (self);
+  g_atomic_int_set (&self->block_count, 0);
+  g_atomic_int_set (&self->block_total_size, 0);
+
+  for (i = 0; i != GUM_ALLOCATION_TRACKER_NUM_SHARDS; i++)
+  {
+    GumAllocationTrackerShard * shard = &self->shards[i];
+
+    g_mutex_lock (&shard->mutex);
+    g_hash_table_remove_all (shard->known_blocks_ht);
+    g_hash_table_remove_all (shard->block_groups_ht);
+    if (shard->stack_summaries_ht != NULL)
+      g_hash_table_remove_all (shard->stack_summaries_ht);
+    g_mutex_unlock (&shard->mutex);
+  }
 }
 
 guint
 gum_allocation_tracker_peek_block_count (GumAllocationTracker * self)
 {
-  return self->block_count;
+  return g_atomic_int_get (&self->block_count);
 }
 
 guint
 gum_allocation_tracker_peek_block_total_size (GumAllocationTracker * self)
 {
-  return self->block_total_size;
+  return g_atomic_int_get (&self->block_total_size);
 }
 
 GList *
 gum_allocation_tracker_peek_block_list (GumAllocationTracker * self)
 {
   GList * blocks = NULL;
-  GHashTableIter iter;
-  gpointer key, value;
+  guint shard_index;
 
-  GUM_ALLOCATION_TRACKER_LOCK (self);
-  g_hash_table_iter_init (&iter, self->known_blocks_ht);
-  while (g_hash_table_iter_next (&iter, &key, &value))
+  for (shard_index = 0; shard_index != GUM_ALLOCATION_TRACKER_NUM_SHARDS;
+      shard_index++)
   {
-    if (self->backtracer_instance != NULL)
+    GumAllocationTrackerShard * shard = &self->shards[shard_index];
+    GHashTableIter iter;
+    gpointer key, value;
+
+    g_mutex_lock (&shard->mutex);
+    g_hash_table_iter_init (&iter, shard->known_blocks_ht);
+    while (g_hash_table_iter_next (&iter, &key, &value))
     {
-      GumAllocationTrackerBlock * tb = (GumAllocationTrackerBlock *) value;
-      GumAllocationBlock * block;
-      guint i;
+      if (self->backtracer_instance != NULL)
+      {
+        GumAllocationTrackerBlock * tb = (GumAllocationTrackerBlock *) value;
+        GumAllocationBlock * block;
+        guint i;
 
-      block = gum_allocation_block_new (key, tb->size);
+        block = gum_allocation_block_new (key, tb->size);
 
-      for (i = 0; tb->return_addresses[i] != NULL; i++)
-        block->return_addresses.items[i] = tb->return_addresses[i];
-      block->return_addresses.len = i;
+        for (i = 0; tb->return_addresses[i] != NULL; i++)
+          block->return_addresses.items[i] = tb->return_addresses[i];
+        block->return_addresses.len = i;
 
-      blocks = g_list_prepend (blocks, block);
-    }
-    else
-    {
-      blocks = g_list_prepend (blocks,
-          gum_allocation_block_new (key, GPOINTER_TO_UINT (value)));
+        blocks = g_list_prepend (blocks, block);
+      }
+      else
+      {
+        blocks = g_list_prepend (blocks,
+            gum_allocation_block_new (key, GPOINTER_TO_UINT (value)));
+      }
     }
+    g_mutex_unlock (&shard->mutex);
   }
-  GUM_ALLOCATION_TRACKER_UNLOCK (self);
 
   return blocks;
 }
@@ -293,17 +382,74 @@ gum_allocation_tracker_peek_block_list (GumAllocationTracker * self)
 GList *
 gum_allocation_tracker_peek_block_groups (GumAllocationTracker * self)
 {
-  GList * groups, * cur;
+  GList * groups = NULL;
+  guint shard_index;
+
+  for (shard_index = 0; shard_index != GUM_ALLOCATION_TRACKER_NUM_SHARDS;
+      shard_index++)
+  {
+    GumAllocationTrackerShard * shard = &self->shards[shard_index];
+    GList * shard_groups, * cur;
 
-  GUM_ALLOCATION_TRACKER_LOCK (self);
-  groups = g_hash_table_get_values (self->block_groups_ht);
-  for (cur = groups; cur != NULL; cur = cur->next)
-    cur->data = gum_allocation_group_copy ((GumAllocationGroup *) cur->data);
-  GUM_ALLOCATION_TRACKER_UNLOCK (self);
+    g_mutex_lock (&shard->mutex);
+    shard_groups = g_hash_table_get_values (shard->block_groups_ht);
+    for (cur = shard_groups; cur != NULL; cur = cur->next)
+      cur->data = gum_allocation_group_copy ((GumAllocationGroup *) cur->data);
+    g_mutex_unlock (&shard->mutex);
+
+    groups = g_list_concat (groups, shard_groups);
+  }
 
   return groups;
 }
 
+/*
+ * Allocations are folded by backtrace as they happen, so peeking costs
+ * a copy of the aggregate per unique stack instead of one entry per live
+ * block. The result is ready to be symbolicated and rendered as a
+ * flamegraph. Only available when the tracker was created with a
+ * backtracer.
+ */
+GList *
+gum_allocation_tracker_peek_stack_summaries (GumAllocationTracker * self)
+{
+  GList * summaries = NULL;
+  guint shard_index;
+
+  g_assert (self->backtracer_instance != NULL);
+
+  for (shard_index = 0; shard_index != GUM_ALLOCATION_TRACKER_NUM_SHARDS;
+      shard_index++)
+  {
+    GumAllocationTrackerShard * shard = &self->shards[shard_index];
+    GList * shard_summaries, * cur;
+
+    g_mutex_lock (&shard->mutex);
+    shard_summaries = g_hash_table_get_values (shard->stack_summaries_ht);
+    for (cur = shard_summaries; cur != NULL; cur = cur->next)
+    {
+      cur->data = g_slice_dup (GumAllocationStackSummary,
+          (GumAllocationStackSummary *) cur->data);
+    }
+    g_mutex_unlock (&shard->mutex);
+
+    summaries = g_list_concat (summaries, shard_summaries);
+  }
+
+  return summaries;
+}
+
+void
+gum_allocation_stack_summary_list_free (GList * summaries)
+{
+  GList * cur;
+
+  for (cur = summaries; cur != NULL; cur = cur->next)
+    gum_allocation_stack_summary_free (cur->data);
+
+  g_list_free (summaries);
+}
+
 void
 gum_allocation_tracker_on_malloc (GumAllocationTracker * self,
                                   gpointer address,
@@ -336,14 +482,17 @@ gum_allocation_tracker_on_malloc_full (GumAllocationTracker * self,
                                        const GumCpuContext * cpu_context)
 {
   gpointer value;
+  GumAllocationTrackerShard * shard;
+  GumReturnAddressArray return_addresses;
 
   if (!g_atomic_int_get (&self->enabled))
     return;
 
+  return_addresses.len = 0;
+
   if (self->backtracer_instance != NULL)
   {
     gboolean do_backtrace = TRUE;
-    GumReturnAddressArray return_addresses;
     GumAllocationTrackerBlock * block;
 
     if (self->filter_func != NULL)
@@ -381,13 +530,18 @@ gum_allocation_tracker_on_malloc_full (GumAllocationTracker * self,
     value = GUINT_TO_POINTER (size);
   }
 
-  GUM_ALLOCATION_TRACKER_LOCK (self);
-
-  g_hash_table_insert (self->known_blocks_ht, address, value);
+  shard = GUM_ALLOCATION_TRACKER_SHARD_FOR_ADDRESS (self, address);
+  g_mutex_lock (&shard->mutex);
+  g_hash_table_insert (shard->known_blocks_ht, address, value);
+  g_mutex_unlock (&shard->mutex);
 
   gum_allocation_tracker_size_stats_add_block (self, size);
 
-  GUM_ALLOCATION_TRACKER_UNLOCK (self);
+  if (return_addresses.len > 0)
+  {
+    gum_allocation_tracker_stack_stats_add_block (self, &return_addresses,
+        size);
+  }
 }
 
 void
@@ -395,29 +549,54 @@ gum_allocation_tracker_on_free_full (GumAllocationTracker * self,
                                      gpointer address,
                                      const GumCpuContext * cpu_context)
 {
+  GumAllocationTrackerShard * shard;
   gpointer value;
+  gboolean found = FALSE;
+  guint size = 0;
+  GumReturnAddressArray return_addresses;
 
   if (!g_atomic_int_get (&self->enabled))
     return;
 
-  GUM_ALLOCATION_TRACKER_LOCK (self);
+  return_addresses.len = 0;
+
+  shard = GUM_ALLOCATION_TRACKER_SHARD_FOR_ADDRESS (self, address);
 
-  value = g_hash_table_lookup (self->known_blocks_ht, address);
+  g_mutex_lock (&shard->mutex);
+
+  value = g_hash_table_lookup (shard->known_blocks_ht, address);
   if (value != NULL)
   {
-    guint size;
-
     if (self->backtracer_instance != NULL)
-      size = ((GumAllocationTrackerBlock *) value)->size;
+    {
+      GumAllocationTrackerBlock * block = value;
+
+      size = block->size;
+      gum_allocation_tracker_block_capture_return_addresses (block,
+          &return_addresses);
+    }
     else
+    {
       size = GPOINTER_TO_UINT (value);
+    }
 
-    gum_allocation_tracker_size_stats_remove_block (self, size);
+    g_hash_table_remove (shard->known_blocks_ht, address);
 
-    g_hash_table_remove (self->known_blocks_ht, address);
+    found = TRUE;
   }
 
-  GUM_ALLOCATION_TRACKER_UNLOCK (self);
+  g_mutex_unlock (&shard->mutex);
+
+  if (found)
+  {
+    gum_allocation_tracker_size_stats_remove_block (self, size);
+
+    if (return_addresses.len > 0)
+    {
+      gum_allocation_tracker_stack_stats_remove_block (self, &return_addresses,
+          size);
+    }
+  }
 }
 
 void
@@ -434,16 +613,21 @@ gum_allocation_tracker_on_realloc_full (GumAllocationTracker * self,
   {
     if (new_size != 0)
     {
+      GumAllocationTrackerShard * old_shard, * new_shard;
       gpointer value;
+      guint old_size = 0;
+      GumReturnAddressArray return_addresses;
 
-      GUM_ALLOCATION_TRACKER_LOCK (self);
+      return_addresses.len = 0;
+
+      old_shard = GUM_ALLOCATION_TRACKER_SHARD_FOR_ADDRESS (self, old_address);
+
+      g_mutex_lock (&old_shard->mutex);
 
-      value = g_hash_table_lookup (self->known_blocks_ht, old_address);
+      value = g_hash_table_lookup (old_shard->known_blocks_ht, old_address);
       if (value != NULL)
       {
-        guint old_size;
-
-        g_hash_table_steal (self->known_blocks_ht, old_address);
+        g_hash_table_steal (old_shard->known_blocks_ht, old_address);
 
         if (self->backtracer_instance != NULL)
         {
@@ -451,24 +635,39 @@ gum_allocation_tracker_on_realloc_full (GumAllocationTracker * self,
 
           block = (GumAllocationTrackerBlock *) value;
 
-          g_hash_table_insert (self->known_blocks_ht, new_address, block);
-
           old_size = block->size;
           block->size = new_size;
+
+          gum_allocation_tracker_block_capture_return_addresses (block,
+              &return_addresses);
         }
         else
         {
-          g_hash_table_insert (self->known_blocks_ht, new_address,
-              GUINT_TO_POINTER (new_size));
-
           old_size = GPOINTER_TO_UINT (value);
+          value = GUINT_TO_POINTER (new_size);
         }
+      }
+
+      g_mutex_unlock (&old_shard->mutex);
+
+      if (value != NULL)
+      {
+        new_shard =
+            GUM_ALLOCATION_TRACKER_SHARD_FOR_ADDRESS (self, new_address);
+
+        g_mutex_lock (&new_shard->mutex);
+        g_hash_table_insert (new_shard->known_blocks_ht, new_address, value);
+        g_mutex_unlock (&new_shard->mutex);
 
         gum_allocation_tracker_size_stats_remove_block (self, old_size);
         gum_allocation_tracker_size_stats_add_block (self, new_size);
-      }
 
-      GUM_ALLOCATION_TRACKER_UNLOCK (self);
+        if (return_addresses.len > 0)
+        {
+          gum_allocation_tracker_stack_stats_resize_block (self,
+              &return_addresses, old_size, new_size);
+        }
+      }
     }
     else
     {
@@ -486,17 +685,23 @@ static void
 gum_allocation_tracker_size_stats_add_block (GumAllocationTracker * self,
                                              guint size)
 {
+  GumAllocationTrackerShard * shard;
   GumAllocationGroup * group;
 
-  self->block_count++;
-  self->block_total_size += size;
+  g_atomic_int_add (&self->block_count, 1);
+  g_atomic_int_add (&self->block_total_size, size);
 
-  group = g_hash_table_lookup (self->block_groups_ht, GUINT_TO_POINTER (size));
+  shard = GUM_ALLOCATION_TRACKER_SHARD_FOR_SIZE (self, size);
+
+  g_mutex_lock (&shard->mutex);
+
+  group = g_hash_table_lookup (shard->block_groups_ht,
+      GUINT_TO_POINTER (size));
 
   if (group == NULL)
   {
     group = gum_allocation_group_new (size);
-    g_hash_table_insert (self->block_groups_ht, GUINT_TO_POINTER (size),
+    g_hash_table_insert (shard->block_groups_ht, GUINT_TO_POINTER (size),
         group);
   }
 
@@ -504,17 +709,153 @@ gum_allocation_tracker_size_stats_add_block (GumAllocationTracker * self,
   if (group->alive_now > group->alive_peak)
     group->alive_peak = group->alive_now;
   group->total_peak++;
+
+  g_mutex_unlock (&shard->mutex);
 }
 
 static void
 gum_allocation_tracker_size_stats_remove_block (GumAllocationTracker * self,
                                                 guint size)
 {
+  GumAllocationTrackerShard * shard;
   GumAllocationGroup * group;
 
-  self->block_count--;
-  self->block_total_size -= size;
+  g_atomic_int_add (&self->block_count, -1);
+  g_atomic_int_add (&self->block_total_size, -((gint) size));
+
+  shard = GUM_ALLOCATION_TRACKER_SHARD_FOR_SIZE (self, size);
+
+  g_mutex_lock (&shard->mutex);
 
-  group = g_hash_table_lookup (self->block_groups_ht, GUINT_TO_POINTER (size));
+  group = g_hash_table_lookup (shard->block_groups_ht,
+      GUINT_TO_POINTER (size));
   group->alive_now--;
+
+  g_mutex_unlock (&shard->mutex);
+}
+
+static void
+gum_allocation_tracker_stack_stats_add_block (
+    GumAllocationTracker * self,
+    const GumReturnAddressArray * return_addresses,
+    guint size)
+{
+  guint hash;
+  GumAllocationTrackerShard * shard;
+  GumAllocationStackSummary * summary;
+
+  hash = gum_return_address_array_hash (return_addresses);
+  shard = GUM_ALLOCATION_TRACKER_SHARD_FOR_STACK_HASH (self, hash);
+
+  g_mutex_lock (&shard->mutex);
+
+  summary = g_hash_table_lookup (shard->stack_summaries_ht, return_addresses);
+
+  if (summary == NULL)
+  {
+    summary = g_slice_new0 (GumAllocationStackSummary);
+    summary->return_addresses = *return_addresses;
+    g_hash_table_insert (shard->stack_summaries_ht,
+        &summary->return_addresses, summary);
+  }
+
+  summary->live_count++;
+  summary->live_size += size;
+
+  g_mutex_unlock (&shard->mutex);
+}
+
+static void
+gum_allocation_tracker_stack_stats_remove_block (
+    GumAllocationTracker * self,
+    const GumReturnAddressArray * return_addresses,
+    guint size)
+{
+  guint hash;
+  GumAllocationTrackerShard * shard;
+  GumAllocationStackSummary * summary;
+
+  hash = gum_return_address_array_hash (return_addresses);
+  shard = GUM_ALLOCATION_TRACKER_SHARD_FOR_STACK_HASH (self, hash);
+
+  g_mutex_lock (&shard->mutex);
+
+  summary = g_hash_table_lookup (shard->stack_summaries_ht, return_addresses);
+  if (summary != NULL)
+  {
+    summary->live_count--;
+    summary->live_size -= size;
+
+    if (summary->live_count == 0)
+    {
+      g_hash_table_remove (shard->stack_summaries_ht,
+          &summary->return_addresses);
+    }
+  }
+
+  g_mutex_unlock (&shard->mutex);
+}
+
+static void
+gum_allocation_tracker_stack_stats_resize_block (
+    GumAllocationTracker * self,
+    const GumReturnAddressArray * return_addresses,
+    guint old_size,
+    guint new_size)
+{
+  guint hash;
+  GumAllocationTrackerShard * shard;
+  GumAllocationStackSummary * summary;
+
+  hash = gum_return_address_array_hash (return_addresses);
+  shard = GUM_ALLOCATION_TRACKER_SHARD_FOR_STACK_HASH (self, hash);
+
+  g_mutex_lock (&shard->mutex);
+
+  summary = g_hash_table_lookup (shard->stack_summaries_ht, return_addresses);
+  if (summary != NULL)
+  {
+    summary->live_size -= old_size;
+    summary->live_size += new_size;
+  }
+
+  g_mutex_unlock (&shard->mutex);
+}
+
+static void
+gum_allocation_tracker_block_capture_return_addresses (
+    const GumAllocationTrackerBlock * block,
+    GumReturnAddressArray * array)
+{
+  guint i;
+
+  for (i = 0; block->return_addresses[i] != NULL; i++)
+    array->items[i] = block->return_addresses[i];
+  array->len = i;
+}
+
+static void
+gum_allocation_stack_summary_free (GumAllocationStackSummary * summary)
+{
+  g_slice_free (GumAllocationStackSummary, summary);
+}
+
+static guint
+gum_return_address_array_hash (gconstpointer key)
+{
+  const GumReturnAddressArray * array = key;
+  guint hash, i;
+
+  hash = array->len;
+  for (i = 0; i != array->len; i++)
+    hash = (hash * 31) + GPOINTER_TO_SIZE (array->items[i]);
+
+  return hash;
+}
+
+static gboolean
+gum_return_address_array_equal (gconstpointer a,
+                                gconstpointer b)
+{
+  return gum_return_address_array_is_equal (a, b);
 }
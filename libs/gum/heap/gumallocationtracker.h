@@ -10,6 +10,7 @@
 #include <glib-object.h>
 #include <gum/gumdefs.h>
 #include <gum/gumbacktracer.h>
+#include <gum/gumreturnaddress.h>
 
 G_BEGIN_DECLS
 
@@ -17,10 +18,19 @@ G_BEGIN_DECLS
 G_DECLARE_FINAL_TYPE (GumAllocationTracker, gum_allocation_tracker, GUM,
     ALLOCATION_TRACKER, GObject)
 
+typedef struct _GumAllocationStackSummary GumAllocationStackSummary;
+
 typedef gboolean (* GumAllocationTrackerFilterFunction) (
     GumAllocationTracker * tracker, gpointer address, guint size,
     gpointer user_data);
 
+struct _GumAllocationStackSummary
+{
+  guint live_count;
+  guint live_size;
+  GumReturnAddressArray return_addresses;
+};
+
 GUM_API GumAllocationTracker * gum_allocation_tracker_new (void);
 GUM_API GumAllocationTracker * gum_allocation_tracker_new_with_backtracer (
     GumBacktracer * backtracer);
@@ -40,6 +50,10 @@ GUM_API GList * gum_allocation_tracker_peek_block_list (
     GumAllocationTracker * self);
 GUM_API GList * gum_allocation_tracker_peek_block_groups (
     GumAllocationTracker * self);
+GUM_API GList * gum_allocation_tracker_peek_stack_summaries (
+    GumAllocationTracker * self);
+
+GUM_API void gum_allocation_stack_summary_list_free (GList * summaries);
 
 /*< Internal API */
 void gum_allocation_tracker_on_malloc (GumAllocationTracker * self,
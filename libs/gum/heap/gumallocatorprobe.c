@@ -13,8 +13,10 @@
 #include "gumsymbolutil.h"
 
 #include <gmodule.h>
+#include <math.h>
 
 #define DEFAULT_ENABLE_COUNTERS FALSE
+#define DEFAULT_SAMPLE_INTERVAL 0
 
 #define GUM_DBGCRT_UNKNOWN_BLOCK (-1)
 #define GUM_DBGCRT_NORMAL_BLOCK (1)
@@ -50,6 +52,13 @@ struct _GumAllocatorProbe
   guint malloc_count;
   guint realloc_count;
   guint free_count;
+
+  guint sample_interval;
+  volatile gint bytes_until_sample;
+
+  GumAllocatorProbeApiFilterFunc api_filter;
+  gpointer api_filter_data;
+  volatile gint untracked_hit_count;
 };
 
 enum
@@ -59,7 +68,9 @@ enum
   PROP_ENABLE_COUNTERS,
   PROP_MALLOC_COUNT,
   PROP_REALLOC_COUNT,
-  PROP_FREE_COUNT
+  PROP_FREE_COUNT,
+  PROP_SAMPLE_INTERVAL,
+  PROP_UNTRACKED_HIT_COUNT
 };
 
 struct _ThreadContext
@@ -79,6 +90,7 @@ struct _FunctionContext
 {
   HeapHandlers handlers;
   gpointer handler_data;
+  gboolean tracked;
   ThreadContext thread_contexts[GUM_MAX_THREADS];
   volatile gint thread_context_count;
 };
@@ -119,6 +131,11 @@ static void gum_allocator_probe_get_property (GObject * object,
 static void gum_allocator_probe_apply_default_suppressions (
     GumAllocatorProbe * self);
 
+static gboolean gum_allocator_probe_should_sample (GumAllocatorProbe * self,
+    guint size);
+static gint gum_allocator_probe_next_sample_threshold (
+    GumAllocatorProbe * self);
+
 static void gum_allocator_probe_on_enter (GumInvocationListener * listener,
     GumInvocationContext * context);
 static void gum_allocator_probe_on_leave (GumInvocationListener * listener,
@@ -126,7 +143,7 @@ static void gum_allocator_probe_on_leave (GumInvocationListener * listener,
 
 static void attach_to_function (GumAllocatorProbe * self,
     gpointer function_address, const HeapHandlers * function_handlers,
-    gpointer user_data);
+    gpointer user_data, gboolean tracked);
 
 static void gum_allocator_probe_on_malloc (GumAllocatorProbe * self,
     gpointer address, guint size, const GumCpuContext * cpu_context);
@@ -210,6 +227,20 @@ gum_allocator_probe_class_init (GumAllocatorProbeClass * klass)
       (GParamFlags) (G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
   g_object_class_install_property (object_class, PROP_FREE_COUNT, pspec);
 
+  pspec = g_param_spec_uint ("sample-interval", "Sample Interval",
+      "Average number of allocated bytes between sampled allocations, "
+      "or zero to track every allocation", 0, G_MAXUINT,
+      DEFAULT_SAMPLE_INTERVAL,
+      (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_SAMPLE_INTERVAL, pspec);
+
+  pspec = g_param_spec_uint ("untracked-hit-count", "Untracked Hit Count",
+      "Number of probed calls short-circuited by the API filter", 0,
+      G_MAXUINT, 0,
+      (GParamFlags) (G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_UNTRACKED_HIT_COUNT,
+      pspec);
+
   _gum_register_destructor (gum_allocator_probe_deinit);
 }
 
@@ -289,6 +320,14 @@ gum_allocator_probe_set_property (GObject * object,
     case PROP_ENABLE_COUNTERS:
       self->enable_counters = g_value_get_boolean (value);
       break;
+    case PROP_SAMPLE_INTERVAL:
+      self->sample_interval = g_value_get_uint (value);
+      if (self->sample_interval != 0)
+      {
+        g_atomic_int_set (&self->bytes_until_sample,
+            gum_allocator_probe_next_sample_threshold (self));
+      }
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -319,6 +358,13 @@ gum_allocator_probe_get_property (GObject * object,
     case PROP_FREE_COUNT:
       g_value_set_uint (value, self->free_count);
       break;
+    case PROP_SAMPLE_INTERVAL:
+      g_value_set_uint (value, self->sample_interval);
+      break;
+    case PROP_UNTRACKED_HIT_COUNT:
+      g_value_set_uint (value,
+          (guint) g_atomic_int_get (&self->untracked_hit_count));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -451,6 +497,12 @@ gum_allocator_probe_on_enter (GumInvocationListener * listener,
   self = GUM_ALLOCATOR_PROBE (listener);
   function_ctx = GUM_IC_GET_FUNC_DATA (context, FunctionContext *);
 
+  if (function_ctx != NULL && !function_ctx->tracked)
+  {
+    g_atomic_int_inc (&self->untracked_hit_count);
+    return;
+  }
+
   gum_interceptor_ignore_current_thread (self->interceptor);
 
   if (function_ctx != NULL)
@@ -475,6 +527,9 @@ gum_allocator_probe_on_leave (GumInvocationListener * listener,
   self = GUM_ALLOCATOR_PROBE (listener);
   function_ctx = GUM_IC_GET_FUNC_DATA (context, FunctionContext *);
 
+  if (function_ctx != NULL && !function_ctx->tracked)
+    return;
+
   if (function_ctx != NULL)
   {
     ThreadContext * base_thread_ctx;
@@ -500,6 +555,24 @@ gum_allocator_probe_new (void)
   return g_object_new (GUM_TYPE_ALLOCATOR_PROBE, NULL);
 }
 
+/*
+ * The filter is evaluated once per heap API at attach time. Entry points of
+ * rejected APIs stay hooked so re-attaching is not needed when the filter
+ * changes, but their hits only bump a shared counter instead of running the
+ * full probe logic; on Windows this keeps CRT-internal heaps from taxing
+ * every allocation when only the application heap is of interest. Must be
+ * configured before attaching.
+ */
+
+void
+gum_allocator_probe_set_api_filter (GumAllocatorProbe * self,
+                                    GumAllocatorProbeApiFilterFunc filter,
+                                    gpointer user_data)
+{
+  self->api_filter = filter;
+  self->api_filter_data = user_data;
+}
+
 static const HeapHandlers gum_malloc_handlers =
 {
   (HeapEnterHandler) on_malloc_enter_handler,
@@ -558,10 +631,10 @@ gum_allocator_probe_attach (GumAllocatorProbe * self)
 
 #define GUM_ATTACH_TO_API_FUNC(name) \
     attach_to_function (self, GUM_FUNCPTR_TO_POINTER (api->name), \
-        &gum_##name##_handlers, NULL)
+        &gum_##name##_handlers, NULL, tracked)
 #define GUM_ATTACH_TO_API_FUNC_WITH_DATA(name, data) \
     attach_to_function (self, GUM_FUNCPTR_TO_POINTER (api->name), \
-        &gum_##name##_handlers, data)
+        &gum_##name##_handlers, data, tracked)
 
 void
 gum_allocator_probe_attach_to_apis (GumAllocatorProbe * self,
@@ -575,6 +648,10 @@ gum_allocator_probe_attach_to_apis (GumAllocatorProbe * self,
   for (i = 0; i != apis->len; i++)
   {
     const GumHeapApi * api = gum_heap_api_list_get_nth (apis, i);
+    gboolean tracked;
+
+    tracked = (self->api_filter == NULL) ||
+        self->api_filter (api, self->api_filter_data);
 
     GUM_ATTACH_TO_API_FUNC (malloc);
     GUM_ATTACH_TO_API_FUNC (calloc);
@@ -618,6 +695,7 @@ gum_allocator_probe_detach (GumAllocatorProbe * self)
   self->malloc_count = 0;
   self->realloc_count = 0;
   self->free_count = 0;
+  g_atomic_int_set (&self->untracked_hit_count, 0);
 
   gum_interceptor_unignore_current_thread (self->interceptor);
 }
@@ -626,7 +704,8 @@ static void
 attach_to_function (GumAllocatorProbe * self,
                     gpointer function_address,
                     const HeapHandlers * function_handlers,
-                    gpointer user_data)
+                    gpointer user_data,
+                    gboolean tracked)
 {
   GumInvocationListener * listener = GUM_INVOCATION_LISTENER (self);
   FunctionContext * function_ctx;
@@ -634,6 +713,7 @@ attach_to_function (GumAllocatorProbe * self,
   function_ctx = g_new0 (FunctionContext, 1);
   function_ctx->handlers = *function_handlers;
   function_ctx->handler_data = user_data;
+  function_ctx->tracked = tracked;
   g_ptr_array_add (self->function_contexts, function_ctx);
 
   gum_interceptor_attach (self->interceptor, function_address, listener,
@@ -649,6 +729,41 @@ gum_allocator_probe_suppress (GumAllocatorProbe * self,
   gum_interceptor_attach (self->interceptor, function_address, listener, NULL);
 }
 
+/*
+ * When a sample interval is configured, allocations are picked with a
+ * probability proportional to their size, by counting down an exponentially
+ * distributed byte threshold with mean sample_interval, like tcmalloc's
+ * sampler. Unsampled allocations only pay for the counter update, so the
+ * probe can stay attached in production. Frees are always forwarded, as the
+ * tracker cheaply ignores addresses it never saw.
+ */
+static gboolean
+gum_allocator_probe_should_sample (GumAllocatorProbe * self,
+                                   guint size)
+{
+  gint previous_budget;
+
+  previous_budget = g_atomic_int_add (&self->bytes_until_sample, -(gint) size);
+  if (previous_budget - (gint) size > 0)
+    return FALSE;
+
+  g_atomic_int_set (&self->bytes_until_sample,
+      gum_allocator_probe_next_sample_threshold (self));
+
+  return TRUE;
+}
+
+static gint
+gum_allocator_probe_next_sample_threshold (GumAllocatorProbe * self)
+{
+  gdouble value;
+
+  value = -log (g_random_double_range (G_MINDOUBLE, 1.0)) *
+      (gdouble) self->sample_interval;
+
+  return (gint) CLAMP (value, 1.0, (gdouble) G_MAXINT);
+}
+
 static void
 gum_allocator_probe_on_malloc (GumAllocatorProbe * self,
                                gpointer address,
@@ -658,6 +773,12 @@ gum_allocator_probe_on_malloc (GumAllocatorProbe * self,
   if (self->enable_counters)
     self->malloc_count++;
 
+  if (self->sample_interval != 0 &&
+      !gum_allocator_probe_should_sample (self, size))
+  {
+    return;
+  }
+
   if (self->allocation_tracker != NULL)
   {
     gum_allocation_tracker_on_malloc_full (self->allocation_tracker, address,
@@ -690,6 +811,12 @@ gum_allocator_probe_on_realloc (GumAllocatorProbe * self,
   if (self->enable_counters)
     self->realloc_count++;
 
+  if (old_address == NULL && self->sample_interval != 0 &&
+      !gum_allocator_probe_should_sample (self, new_size))
+  {
+    return;
+  }
+
   if (self->allocation_tracker != NULL)
   {
     gum_allocation_tracker_on_realloc_full (self->allocation_tracker,
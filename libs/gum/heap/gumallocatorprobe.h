@@ -18,8 +18,14 @@ G_BEGIN_DECLS
 G_DECLARE_FINAL_TYPE (GumAllocatorProbe, gum_allocator_probe, GUM,
     ALLOCATOR_PROBE, GObject)
 
+typedef gboolean (* GumAllocatorProbeApiFilterFunc) (const GumHeapApi * api,
+    gpointer user_data);
+
 GUM_API GumAllocatorProbe * gum_allocator_probe_new (void);
 
+GUM_API void gum_allocator_probe_set_api_filter (GumAllocatorProbe * self,
+    GumAllocatorProbeApiFilterFunc filter, gpointer user_data);
+
 GUM_API void gum_allocator_probe_attach (GumAllocatorProbe * self);
 GUM_API void gum_allocator_probe_attach_to_apis (GumAllocatorProbe * self,
     const GumHeapApiList * apis);
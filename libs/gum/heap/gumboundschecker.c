@@ -10,6 +10,7 @@
 #include "guminterceptor.h"
 #include "gumlibc.h"
 #include "gumpagepool.h"
+#include "gumprocess.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -17,8 +18,14 @@
 #define DEFAULT_POOL_SIZE       4096
 #define DEFAULT_FRONT_ALIGNMENT   16
 
-#define GUM_BOUNDS_CHECKER_LOCK() g_mutex_lock (&self->mutex)
-#define GUM_BOUNDS_CHECKER_UNLOCK() g_mutex_unlock (&self->mutex)
+/*
+ * The backing store is split into multiple pools so threads bound to
+ * different pools do not contend on one lock. Small pools stay unsharded to
+ * preserve their exact exhaustion behavior. Each pool reserves its whole
+ * region up front, so sharding does not add mmap traffic.
+ */
+#define GUM_BOUNDS_CHECKER_MAX_POOLS       4
+#define GUM_BOUNDS_CHECKER_MIN_POOL_PAGES  2
 
 #define BLOCK_ALLOC_RETADDRS(b) \
     ((GumReturnAddressArray *) (b)->guard)
@@ -31,8 +38,6 @@ struct _GumBoundsChecker
 
   gboolean disposed;
 
-  GMutex mutex;
-
   GumBacktracerInterface * backtracer_iface;
   GumBacktracer * backtracer_instance;
   GumBoundsOutputFunc output;
@@ -47,7 +52,9 @@ struct _GumBoundsChecker
 
   guint pool_size;
   guint front_alignment;
-  GumPagePool * page_pool;
+  guint n_pools;
+  GumPagePool * pools[GUM_BOUNDS_CHECKER_MAX_POOLS];
+  GMutex pool_mutexes[GUM_BOUNDS_CHECKER_MAX_POOLS];
 };
 
 enum
@@ -76,6 +83,12 @@ static gpointer gum_bounds_checker_try_alloc (GumBoundsChecker * self,
     guint size, GumInvocationContext * ctx);
 static gboolean gum_bounds_checker_try_free (GumBoundsChecker * self,
     gpointer address, GumInvocationContext * ctx);
+static gpointer gum_bounds_checker_try_alloc_in_pool (GumBoundsChecker * self,
+    GumPagePool * pool, guint size, GumInvocationContext * ctx);
+static guint gum_bounds_checker_pool_index_for_current_thread (
+    GumBoundsChecker * self);
+static GumPagePool * gum_bounds_checker_find_pool_for_address (
+    GumBoundsChecker * self, gconstpointer address, guint * pool_index);
 
 static gboolean gum_bounds_checker_on_exception (GumExceptionDetails * details,
     gpointer user_data);
@@ -115,7 +128,10 @@ gum_bounds_checker_class_init (GumBoundsCheckerClass * klass)
 static void
 gum_bounds_checker_init (GumBoundsChecker * self)
 {
-  g_mutex_init (&self->mutex);
+  guint i;
+
+  for (i = 0; i != GUM_BOUNDS_CHECKER_MAX_POOLS; i++)
+    g_mutex_init (&self->pool_mutexes[i]);
 
   self->interceptor = gum_interceptor_obtain ();
   self->exceptor = gum_exceptor_obtain ();
@@ -154,8 +170,10 @@ static void
 gum_bounds_checker_finalize (GObject * object)
 {
   GumBoundsChecker * self = GUM_BOUNDS_CHECKER (object);
+  guint i;
 
-  g_mutex_clear (&self->mutex);
+  for (i = 0; i != GUM_BOUNDS_CHECKER_MAX_POOLS; i++)
+    g_mutex_clear (&self->pool_mutexes[i]);
 
   G_OBJECT_CLASS (gum_bounds_checker_parent_class)->finalize (object);
 }
@@ -248,7 +266,7 @@ void
 gum_bounds_checker_set_pool_size (GumBoundsChecker * self,
                                   guint pool_size)
 {
-  g_assert (self->page_pool == NULL);
+  g_assert (self->pools[0] == NULL);
   self->pool_size = pool_size;
 }
 
@@ -262,7 +280,7 @@ void
 gum_bounds_checker_set_front_alignment (GumBoundsChecker * self,
                                         guint pool_size)
 {
-  g_assert (self->page_pool == NULL);
+  g_assert (self->pools[0] == NULL);
   self->front_alignment = pool_size;
 }
 
@@ -280,14 +298,31 @@ gum_bounds_checker_attach_to_apis (GumBoundsChecker * self,
 {
   guint i;
 
+  guint pages_left, pool_index;
+
   g_assert (self->heap_apis == NULL);
   self->heap_apis = gum_heap_api_list_copy (apis);
 
-  g_assert (self->page_pool == NULL);
-  self->page_pool = gum_page_pool_new (GUM_PROTECT_MODE_ABOVE,
-      self->pool_size);
-  g_object_set (self->page_pool, "front-alignment", self->front_alignment,
-      NULL);
+  g_assert (self->pools[0] == NULL);
+
+  self->n_pools = MIN (GUM_BOUNDS_CHECKER_MAX_POOLS, self->pool_size /
+      (GUM_BOUNDS_CHECKER_MIN_POOL_PAGES * GUM_BOUNDS_CHECKER_MAX_POOLS));
+  if (self->n_pools == 0)
+    self->n_pools = 1;
+
+  pages_left = self->pool_size;
+  for (pool_index = 0; pool_index != self->n_pools; pool_index++)
+  {
+    guint n_pages;
+
+    n_pages = pages_left / (self->n_pools - pool_index);
+    pages_left -= n_pages;
+
+    self->pools[pool_index] = gum_page_pool_new (GUM_PROTECT_MODE_ABOVE,
+        n_pages);
+    g_object_set (self->pools[pool_index], "front-alignment",
+        self->front_alignment, NULL);
+  }
 
   gum_interceptor_begin_transaction (self->interceptor);
 
@@ -323,7 +358,8 @@ gum_bounds_checker_detach (GumBoundsChecker * self)
     self->attached = FALSE;
     self->detaching = TRUE;
 
-    g_assert (gum_page_pool_peek_used (self->page_pool) == 0);
+    for (i = 0; i != self->n_pools; i++)
+      g_assert (gum_page_pool_peek_used (self->pools[i]) == 0);
 
     gum_interceptor_begin_transaction (self->interceptor);
 
@@ -345,8 +381,12 @@ gum_bounds_checker_detach (GumBoundsChecker * self)
 
     gum_interceptor_end_transaction (self->interceptor);
 
-    g_object_unref (self->page_pool);
-    self->page_pool = NULL;
+    for (i = 0; i != self->n_pools; i++)
+    {
+      g_object_unref (self->pools[i]);
+      self->pools[i] = NULL;
+    }
+    self->n_pools = 0;
 
     gum_heap_api_list_free (self->heap_apis);
     self->heap_apis = NULL;
@@ -366,9 +406,7 @@ replacement_malloc (gsize size)
   if (self->detaching || self->handled_invalid_access)
     goto fallback;
 
-  GUM_BOUNDS_CHECKER_LOCK ();
   result = gum_bounds_checker_try_alloc (self, MAX (size, 1), ctx);
-  GUM_BOUNDS_CHECKER_UNLOCK ();
   if (result == NULL)
     goto fallback;
 
@@ -392,9 +430,7 @@ replacement_calloc (gsize num,
   if (self->detaching || self->handled_invalid_access)
     goto fallback;
 
-  GUM_BOUNDS_CHECKER_LOCK ();
   result = gum_bounds_checker_try_alloc (self, MAX (num * size, 1), ctx);
-  GUM_BOUNDS_CHECKER_UNLOCK ();
   if (result != NULL)
     gum_memset (result, 0, num * size);
   else
@@ -413,6 +449,9 @@ replacement_realloc (gpointer old_address,
   GumInvocationContext * ctx;
   GumBoundsChecker * self;
   gpointer result = NULL;
+  GumPagePool * old_pool;
+  guint old_pool_index;
+  gboolean found;
   GumBlockDetails old_block;
 
   ctx = gum_interceptor_get_current_invocation ();
@@ -430,29 +469,27 @@ replacement_realloc (gpointer old_address,
   if (self->detaching || self->handled_invalid_access)
     goto fallback;
 
-  GUM_BOUNDS_CHECKER_LOCK ();
+  old_pool = gum_bounds_checker_find_pool_for_address (self, old_address,
+      &old_pool_index);
+  if (old_pool == NULL)
+    goto fallback;
 
-  if (!gum_page_pool_query_block_details (self->page_pool, old_address,
-      &old_block))
-  {
-    GUM_BOUNDS_CHECKER_UNLOCK ();
+  g_mutex_lock (&self->pool_mutexes[old_pool_index]);
+  found = gum_page_pool_query_block_details (old_pool, old_address,
+      &old_block);
+  g_mutex_unlock (&self->pool_mutexes[old_pool_index]);
 
+  if (!found)
     goto fallback;
-  }
 
   result = gum_bounds_checker_try_alloc (self, new_size, ctx);
-
-  GUM_BOUNDS_CHECKER_UNLOCK ();
-
   if (result == NULL)
     result = malloc (new_size);
 
   if (result != NULL)
     gum_memcpy (result, old_address, MIN (old_block.size, new_size));
 
-  GUM_BOUNDS_CHECKER_LOCK ();
   gum_bounds_checker_try_free (self, old_address, ctx);
-  GUM_BOUNDS_CHECKER_UNLOCK ();
 
   return result;
 
@@ -470,10 +507,7 @@ replacement_free (gpointer address)
   ctx = gum_interceptor_get_current_invocation ();
   self = GUM_IC_GET_REPLACEMENT_DATA (ctx, GumBoundsChecker *);
 
-  GUM_BOUNDS_CHECKER_LOCK ();
   freed = gum_bounds_checker_try_free (self, address, ctx);
-  GUM_BOUNDS_CHECKER_UNLOCK ();
-
   if (!freed)
     free (address);
 }
@@ -482,16 +516,44 @@ static gpointer
 gum_bounds_checker_try_alloc (GumBoundsChecker * self,
                               guint size,
                               GumInvocationContext * ctx)
+{
+  gpointer result = NULL;
+  guint start, offset;
+
+  /*
+   * Allocations are served from the pool this thread hashes to, only
+   * spilling into its siblings when that pool is exhausted.
+   */
+  start = gum_bounds_checker_pool_index_for_current_thread (self);
+
+  for (offset = 0; offset != self->n_pools && result == NULL; offset++)
+  {
+    guint pool_index = (start + offset) % self->n_pools;
+
+    g_mutex_lock (&self->pool_mutexes[pool_index]);
+    result = gum_bounds_checker_try_alloc_in_pool (self,
+        self->pools[pool_index], size, ctx);
+    g_mutex_unlock (&self->pool_mutexes[pool_index]);
+  }
+
+  return result;
+}
+
+static gpointer
+gum_bounds_checker_try_alloc_in_pool (GumBoundsChecker * self,
+                                      GumPagePool * pool,
+                                      guint size,
+                                      GumInvocationContext * ctx)
 {
   gpointer result;
 
-  result = gum_page_pool_try_alloc (self->page_pool, size);
+  result = gum_page_pool_try_alloc (pool, size);
 
   if (result != NULL && self->backtracer_instance != NULL)
   {
     GumBlockDetails block;
 
-    gum_page_pool_query_block_details (self->page_pool, result, &block);
+    gum_page_pool_query_block_details (pool, result, &block);
 
     gum_mprotect (block.guard, block.guard_size, GUM_PAGE_RW);
 
@@ -512,15 +574,23 @@ gum_bounds_checker_try_free (GumBoundsChecker * self,
                              gpointer address,
                              GumInvocationContext * ctx)
 {
+  GumPagePool * pool;
+  guint pool_index;
   gboolean freed;
 
-  freed = gum_page_pool_try_free (self->page_pool, address);
+  pool = gum_bounds_checker_find_pool_for_address (self, address, &pool_index);
+  if (pool == NULL)
+    return FALSE;
+
+  g_mutex_lock (&self->pool_mutexes[pool_index]);
+
+  freed = gum_page_pool_try_free (pool, address);
 
   if (freed && self->backtracer_instance != NULL)
   {
     GumBlockDetails block;
 
-    gum_page_pool_query_block_details (self->page_pool, address, &block);
+    gum_page_pool_query_block_details (pool, address, &block);
 
     gum_mprotect (block.guard, block.guard_size, GUM_PAGE_RW);
 
@@ -531,9 +601,45 @@ gum_bounds_checker_try_free (GumBoundsChecker * self,
     gum_mprotect (block.guard, block.guard_size, GUM_PAGE_NO_ACCESS);
   }
 
+  g_mutex_unlock (&self->pool_mutexes[pool_index]);
+
   return freed;
 }
 
+static guint
+gum_bounds_checker_pool_index_for_current_thread (GumBoundsChecker * self)
+{
+  GumThreadId id = gum_process_get_current_thread_id ();
+
+  return (guint) (id % self->n_pools);
+}
+
+static GumPagePool *
+gum_bounds_checker_find_pool_for_address (GumBoundsChecker * self,
+                                          gconstpointer address,
+                                          guint * pool_index)
+{
+  guint i;
+
+  /*
+   * Pool bounds are fixed from attach to detach, so they can be read
+   * without taking any pool's lock.
+   */
+  for (i = 0; i != self->n_pools; i++)
+  {
+    guint8 * lower, * upper;
+
+    gum_page_pool_get_bounds (self->pools[i], &lower, &upper);
+    if ((const guint8 *) address >= lower && (const guint8 *) address <= upper)
+    {
+      *pool_index = i;
+      return self->pools[i];
+    }
+  }
+
+  return NULL;
+}
+
 static gboolean
 gum_bounds_checker_on_exception (GumExceptionDetails * details,
                                  gpointer user_data)
@@ -541,6 +647,8 @@ gum_bounds_checker_on_exception (GumExceptionDetails * details,
   GumBoundsChecker * self;
   GumMemoryOperation op;
   gconstpointer address;
+  GumPagePool * pool;
+  guint pool_index;
   GumBlockDetails block;
   GString * message;
   GumReturnAddressArray accessed_at = { 0, };
@@ -556,7 +664,11 @@ gum_bounds_checker_on_exception (GumExceptionDetails * details,
 
   address = details->memory.address;
 
-  if (!gum_page_pool_query_block_details (self->page_pool, address, &block))
+  pool = gum_bounds_checker_find_pool_for_address (self, address, &pool_index);
+  if (pool == NULL)
+    return FALSE;
+
+  if (!gum_page_pool_query_block_details (pool, address, &block))
     return FALSE;
 
   if (self->handled_invalid_access)
@@ -626,27 +738,35 @@ static void
 gum_bounds_checker_append_backtrace (const GumReturnAddressArray * arr,
                                      GString * s)
 {
+  GumReturnAddressDetails * details;
+  gboolean * resolved;
   guint i;
 
+  details = g_new (GumReturnAddressDetails, arr->len);
+  resolved = g_new (gboolean, arr->len);
+
+  gum_return_address_array_load_details (arr, details, resolved);
+
   for (i = 0; i != arr->len; i++)
   {
-    GumReturnAddress addr = arr->items[i];
-    GumReturnAddressDetails rad;
-
-    if (gum_return_address_details_from_address (addr, &rad))
+    if (resolved[i])
     {
+      GumReturnAddressDetails * rad = &details[i];
       gchar * file_basename;
 
-      file_basename = g_path_get_basename (rad.file_name);
+      file_basename = g_path_get_basename (rad->file_name);
       g_string_append_printf (s, "\t%p %s!%s %s:%u\n",
-          rad.address,
-          rad.module_name, rad.function_name,
-          file_basename, rad.line_number);
+          rad->address,
+          rad->module_name, rad->function_name,
+          file_basename, rad->line_number);
       g_free (file_basename);
     }
     else
     {
-      g_string_append_printf (s, "\t%p\n", addr);
+      g_string_append_printf (s, "\t%p\n", arr->items[i]);
     }
   }
+
+  g_free (resolved);
+  g_free (details);
 }
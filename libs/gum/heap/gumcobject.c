@@ -21,6 +21,7 @@ gum_cobject_new (gpointer address,
   g_strlcpy (cobject->type_name, type_name, sizeof (cobject->type_name));
   cobject->return_addresses.len = 0;
   cobject->data = NULL;
+  cobject->generation = 0;
 
   return cobject;
 }
@@ -20,6 +20,7 @@ struct _GumCObject
 
   /*< private */
   gpointer data;
+  guint64 generation;
 };
 
 #define GUM_COBJECT(b) ((GumCObject *) (b))
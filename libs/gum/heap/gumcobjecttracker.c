@@ -35,6 +35,9 @@ struct _GumCObjectTracker
   GMutex mutex;
   GHashTable * types_ht;
   GHashTable * objects_ht;
+  guint64 generation;
+  GHashTable * added_ht;
+  GList * removed;
   GumInterceptor * interceptor;
   GPtrArray * function_contexts;
 
@@ -169,6 +172,8 @@ gum_cobject_tracker_init (GumCObjectTracker * self)
   self->objects_ht = g_hash_table_new_full (g_direct_hash, g_direct_equal,
       NULL, (GDestroyNotify) gum_cobject_free);
 
+  self->added_ht = g_hash_table_new (g_direct_hash, g_direct_equal);
+
   self->interceptor = gum_interceptor_obtain ();
 
   self->function_contexts = g_ptr_array_new ();
@@ -250,6 +255,12 @@ gum_cobject_tracker_dispose (GObject * object)
     g_clear_object (&self->backtracer_instance);
     self->backtracer_iface = NULL;
 
+    gum_cobject_list_free (self->removed);
+    self->removed = NULL;
+
+    g_hash_table_unref (self->added_ht);
+    self->added_ht = NULL;
+
     g_hash_table_unref (self->objects_ht);
     self->objects_ht = NULL;
 
@@ -368,6 +379,61 @@ gum_cobject_tracker_peek_object_list (GumCObjectTracker * self)
   return result;
 }
 
+/*
+ * Starts a new change interval: subsequent gum_cobject_tracker_peek_changes()
+ * calls report only objects added or removed after this point. Also bounds
+ * the tracker's bookkeeping, so periodic leak scans should call this once
+ * per interval instead of diffing full object lists.
+ */
+void
+gum_cobject_tracker_checkpoint (GumCObjectTracker * self)
+{
+  GUM_COBJECT_TRACKER_LOCK ();
+  gum_interceptor_ignore_current_thread (self->interceptor);
+
+  self->generation++;
+  g_hash_table_remove_all (self->added_ht);
+  gum_cobject_list_free (self->removed);
+  self->removed = NULL;
+
+  gum_interceptor_unignore_current_thread (self->interceptor);
+  GUM_COBJECT_TRACKER_UNLOCK ();
+}
+
+/*
+ * Returns copies of the objects added and removed since the last checkpoint
+ * (or since tracking started), in O(changes) rather than O(live set).
+ * Objects that both appeared and vanished within the interval cancel out.
+ * Free both lists with gum_cobject_list_free().
+ */
+void
+gum_cobject_tracker_peek_changes (GumCObjectTracker * self,
+                                  GList ** added,
+                                  GList ** removed)
+{
+  GList * cur;
+
+  GUM_COBJECT_TRACKER_LOCK ();
+  gum_interceptor_ignore_current_thread (self->interceptor);
+
+  if (added != NULL)
+  {
+    *added = g_hash_table_get_values (self->added_ht);
+    for (cur = *added; cur != NULL; cur = cur->next)
+      cur->data = gum_cobject_copy ((GumCObject *) cur->data);
+  }
+
+  if (removed != NULL)
+  {
+    *removed = g_list_copy (self->removed);
+    for (cur = *removed; cur != NULL; cur = cur->next)
+      cur->data = gum_cobject_copy ((GumCObject *) cur->data);
+  }
+
+  gum_interceptor_unignore_current_thread (self->interceptor);
+  GUM_COBJECT_TRACKER_UNLOCK ();
+}
+
 static ObjectType *
 object_type_new (const gchar * name)
 {
@@ -394,7 +460,9 @@ gum_cobject_tracker_add_object (GumCObjectTracker * self,
 
   GUM_COBJECT_TRACKER_LOCK ();
 
+  cobject->generation = self->generation;
   g_hash_table_insert (self->objects_ht, cobject->address, cobject);
+  g_hash_table_insert (self->added_ht, cobject->address, cobject);
   object_type->count++;
 
   GUM_COBJECT_TRACKER_UNLOCK ();
@@ -413,6 +481,19 @@ gum_cobject_tracker_maybe_remove_object (GumCObjectTracker * self,
   {
     ObjectType * object_type = cobject->data;
     object_type->count--;
+
+    /*
+     * Objects that predate the current checkpoint are logged for the next
+     * diff; ones born within the interval simply cancel out.
+     */
+    if (cobject->generation == self->generation)
+      g_hash_table_remove (self->added_ht, address);
+    else
+    {
+      self->removed = g_list_prepend (self->removed,
+          gum_cobject_copy (cobject));
+    }
+
     g_hash_table_remove (self->objects_ht, address);
   }
 
@@ -30,6 +30,10 @@ GUM_API guint gum_cobject_tracker_peek_total_count (GumCObjectTracker * self,
     const gchar * type_name);
 GUM_API GList * gum_cobject_tracker_peek_object_list (GumCObjectTracker * self);
 
+GUM_API void gum_cobject_tracker_checkpoint (GumCObjectTracker * self);
+GUM_API void gum_cobject_tracker_peek_changes (GumCObjectTracker * self,
+    GList ** added, GList ** removed);
+
 G_END_DECLS
 
 #endif
@@ -439,32 +439,42 @@ gum_sanity_checker_print_block_leaks_details (GumSanityChecker * self,
   for (cur = blocks; cur != NULL; cur = cur->next)
   {
     GumAllocationBlock * block = (GumAllocationBlock *) cur->data;
+    GumReturnAddressDetails * details;
+    gboolean * resolved;
     guint i;
 
     gum_sanity_checker_printf (self, "\t%p\t%u\n",
         block->address, block->size);
 
+    details = g_new (GumReturnAddressDetails, block->return_addresses.len);
+    resolved = g_new (gboolean, block->return_addresses.len);
+
+    gum_return_address_array_load_details (&block->return_addresses, details,
+        resolved);
+
     for (i = 0; i != block->return_addresses.len; i++)
     {
-      GumReturnAddress addr = block->return_addresses.items[i];
-      GumReturnAddressDetails rad;
-
-      if (gum_return_address_details_from_address (addr, &rad))
+      if (resolved[i])
       {
+        GumReturnAddressDetails * rad = &details[i];
         gchar * file_basename;
 
-        file_basename = g_path_get_basename (rad.file_name);
+        file_basename = g_path_get_basename (rad->file_name);
         gum_sanity_checker_printf (self, "\t    %p %s!%s %s:%u\n",
-            rad.address,
-            rad.module_name, rad.function_name,
-            file_basename, rad.line_number);
+            rad->address,
+            rad->module_name, rad->function_name,
+            file_basename, rad->line_number);
         g_free (file_basename);
       }
       else
       {
-        gum_sanity_checker_printf (self, "\t    %p\n", addr);
+        gum_sanity_checker_printf (self, "\t    %p\n",
+            block->return_addresses.items[i]);
       }
     }
+
+    g_free (resolved);
+    g_free (details);
   }
 
   g_list_free (blocks);
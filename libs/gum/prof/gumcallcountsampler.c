@@ -8,9 +8,17 @@
 #include "gumcallcountsampler.h"
 
 #include "guminterceptor.h"
+#include "gummemory.h"
 #include "gumsymbolutil.h"
 #include "gumtls.h"
 
+/*
+ * Each thread's counter gets a cache line of its own, so bumping it does
+ * not ping-pong a line between the cores of threads calling into the
+ * same sampler.
+ */
+#define GUM_COUNTER_ALIGNMENT 64
+
 static void gum_call_count_sampler_sampler_iface_init (gpointer g_iface,
     gpointer iface_data);
 static void gum_call_count_sampler_listener_iface_init (gpointer g_iface,
@@ -33,8 +41,6 @@ struct _GumCallCountSampler
 
   GumInterceptor * interceptor;
 
-  volatile gint total_count;
-
   GumTlsKey tls_key;
   GMutex mutex;
   GSList * counters;
@@ -110,7 +116,7 @@ gum_call_count_sampler_finalize (GObject * object)
   gum_tls_key_free (self->tls_key);
   g_mutex_clear (&self->mutex);
 
-  g_slist_foreach (self->counters, (GFunc) g_free, NULL);
+  g_slist_foreach (self->counters, (GFunc) gum_free, NULL);
   g_slist_free (self->counters);
 
   G_OBJECT_CLASS (gum_call_count_sampler_parent_class)->finalize (object);
@@ -219,7 +225,17 @@ gum_call_count_sampler_add_function (GumCallCountSampler * self,
 GumSample
 gum_call_count_sampler_peek_total_count (GumCallCountSampler * self)
 {
-  return g_atomic_int_get (&self->total_count);
+  GumSample total = 0;
+  GSList * cur;
+
+  g_mutex_lock (&self->mutex);
+
+  for (cur = self->counters; cur != NULL; cur = cur->next)
+    total += *((GumSample *) cur->data);
+
+  g_mutex_unlock (&self->mutex);
+
+  return total;
 }
 
 static GumSample
@@ -251,7 +267,8 @@ gum_call_count_sampler_on_enter (GumInvocationListener * listener,
   counter = (GumSample *) gum_tls_key_get_value (self->tls_key);
   if (counter == NULL)
   {
-    counter = g_new0 (GumSample, 1);
+    counter = gum_memalign (GUM_COUNTER_ALIGNMENT, GUM_COUNTER_ALIGNMENT);
+    *counter = 0;
 
     g_mutex_lock (&self->mutex);
     self->counters = g_slist_prepend (self->counters, counter);
@@ -260,7 +277,6 @@ gum_call_count_sampler_on_enter (GumInvocationListener * listener,
     gum_tls_key_set_value (self->tls_key, counter);
   }
 
-  g_atomic_int_inc (&self->total_count);
   (*counter)++;
 }
 
@@ -10,16 +10,23 @@
 
 #include <string.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <sys/syscall.h>
 
 # define PERF_TYPE_HARDWARE       0
 # define PERF_COUNT_HW_CPU_CYCLES 0
 
+#define GUM_BARRIER() __asm__ __volatile__ ("" ::: "memory")
+
+struct perf_event_mmap_page;
+
 struct _GumCycleSampler
 {
   GObject parent;
 
   gint device;
+  volatile struct perf_event_mmap_page * metadata;
+  gsize metadata_size;
 };
 
 struct perf_event_attr
@@ -64,6 +71,37 @@ struct perf_event_attr
   guint64 __reserved_3;
 };
 
+struct perf_event_mmap_page
+{
+  guint32 version;
+  guint32 compat_version;
+
+  guint32 lock;
+  guint32 index;
+  gint64 offset;
+  guint64 time_enabled;
+  guint64 time_running;
+
+  union
+  {
+    guint64 capabilities;
+    struct
+    {
+      guint64 cap_bit0               :  1,
+              cap_bit0_is_deprecated :  1,
+              cap_user_rdpmc         :  1,
+              cap_user_time          :  1,
+              cap_user_time_zero     :  1,
+              cap_____res            : 59;
+    };
+  };
+
+  guint16 pmc_width;
+  guint16 time_shift;
+  guint32 time_mult;
+  guint64 time_offset;
+};
+
 static void gum_cycle_sampler_iface_init (gpointer g_iface,
     gpointer iface_data);
 static void gum_cycle_sampler_dispose (GObject * object);
@@ -102,6 +140,31 @@ gum_cycle_sampler_init (GumCycleSampler * self)
   attr.config = PERF_COUNT_HW_CPU_CYCLES;
 
   self->device = syscall (__NR_perf_event_open, &attr, 0, -1, -1, 0);
+
+#ifdef HAVE_I386
+  if (self->device != -1)
+  {
+    gpointer page;
+
+    /*
+     * Mapping the event's metadata page lets us read the counter with
+     * rdpmc right from user space, when the kernel permits it, instead
+     * of paying for a syscall on every sample.
+     */
+    self->metadata_size = sysconf (_SC_PAGE_SIZE);
+    page = mmap (NULL, self->metadata_size, PROT_READ, MAP_SHARED,
+        self->device, 0);
+    if (page != MAP_FAILED)
+    {
+      volatile struct perf_event_mmap_page * metadata = page;
+
+      if (metadata->cap_user_rdpmc)
+        self->metadata = metadata;
+      else
+        munmap (page, self->metadata_size);
+    }
+  }
+#endif
 }
 
 static void
@@ -109,6 +172,12 @@ gum_cycle_sampler_dispose (GObject * object)
 {
   GumCycleSampler * self = GUM_CYCLE_SAMPLER (object);
 
+  if (self->metadata != NULL)
+  {
+    munmap ((gpointer) self->metadata, self->metadata_size);
+    self->metadata = NULL;
+  }
+
   if (self->device != -1)
   {
     close (self->device);
@@ -136,6 +205,49 @@ gum_cycle_sampler_sample (GumSampler * sampler)
   GumCycleSampler * self = (GumCycleSampler *) sampler;
   long long result = 0;
 
+#ifdef HAVE_I386
+  volatile struct perf_event_mmap_page * metadata = self->metadata;
+
+  if (metadata != NULL)
+  {
+    guint32 seq, index;
+    gint64 offset;
+
+    do
+    {
+      seq = metadata->lock;
+      GUM_BARRIER ();
+
+      index = metadata->index;
+      offset = metadata->offset;
+
+      if (index != 0)
+      {
+        guint32 lo, hi;
+        guint64 count;
+        guint shift;
+
+        __asm__ __volatile__ ("rdpmc" : "=a" (lo), "=d" (hi)
+            : "c" (index - 1));
+
+        count = ((guint64) hi << 32) | lo;
+        shift = 64 - metadata->pmc_width;
+        offset += ((gint64) (count << shift)) >> shift;
+      }
+
+      GUM_BARRIER ();
+    }
+    while (metadata->lock != seq);
+
+    /*
+     * A zero index means the counter is not scheduled on this CPU right
+     * now, in which case only the slow path can observe its value.
+     */
+    if (index != 0)
+      return offset;
+  }
+#endif
+
   if (read (self->device, &result, sizeof (result)) < sizeof (result))
     return 0;
 
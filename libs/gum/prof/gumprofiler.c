@@ -8,6 +8,7 @@
 #include "gumprofiler.h"
 
 #include "guminterceptor.h"
+#include "gumprocess.h"
 #include "gumsymbolutil.h"
 
 #include <string.h>
@@ -21,6 +22,9 @@ typedef struct _GumFunctionContext GumFunctionContext;
 typedef struct _GumWorstCaseInfo GumWorstCaseInfo;
 typedef struct _GumWorstCase GumWorstCase;
 typedef struct _GumFunctionThreadContext GumFunctionThreadContext;
+typedef struct _GumCallTreeNode GumCallTreeNode;
+typedef struct _GumSampleTreeNode GumSampleTreeNode;
+typedef struct _GumSampleCapture GumSampleCapture;
 
 struct _GumProfiler
 {
@@ -33,6 +37,57 @@ struct _GumProfiler
   GumInterceptor * interceptor;
   GHashTable * function_by_address;
   GSList * stacks;
+  GSList * thread_context_caches;
+
+  gboolean stack_folding_enabled;
+  GSList * call_trees;
+
+  GCond sampling_cond;
+  gboolean sampling_stopping;
+  GThread * sampling_thread;
+  GumThreadId sampling_thread_id;
+  GumBacktracer * sampling_backtracer;
+  guint sampling_interval;
+  GHashTable * sample_tree_by_thread_id;
+};
+
+/*
+ * One node per unique call path observed by a thread, forming a tree
+ * that is written only by its owning thread: new children are published
+ * with an atomic pointer store onto a singly-linked sibling list, so the
+ * folded-stack emitter may walk a tree concurrently without locking the
+ * instrumented path.
+ */
+struct _GumCallTreeNode
+{
+  GumFunctionContext * function_ctx;
+  GumCallTreeNode * parent;
+  GumCallTreeNode * first_child;
+  GumCallTreeNode * next_sibling;
+
+  gint64 self_duration;
+};
+
+/*
+ * Like GumCallTreeNode, but built from sampled backtraces rather than
+ * instrumented calls, so the unit is hits instead of sampler durations.
+ * These trees are only ever touched by the sampler thread and the report
+ * emitters, both under the profiler lock.
+ */
+struct _GumSampleTreeNode
+{
+  gpointer address;
+  GumSampleTreeNode * first_child;
+  GumSampleTreeNode * next_sibling;
+
+  guint64 hits;
+  guint64 self_hits;
+};
+
+struct _GumSampleCapture
+{
+  GumBacktracer * backtracer;
+  GumReturnAddressArray frames;
 };
 
 struct _GumProfilerInvocation
@@ -47,6 +102,17 @@ struct _GumProfilerInvocation
 struct _GumProfilerContext
 {
   GArray * stack;
+
+  /*
+   * Private to the owning thread, so lookups need no locking: this memoizes
+   * gum_function_context_get_current_thread(), whose linear scan over the
+   * claimed slots would otherwise be paid on every enter and grow with the
+   * number of profiled threads.
+   */
+  GHashTable * thread_context_by_function;
+
+  GumCallTreeNode * call_tree_root;
+  GumCallTreeNode * call_tree_cursor;
 };
 
 struct _GumWorstCaseInfo
@@ -118,6 +184,27 @@ static void thread_context_register_child_timing (
 static void get_number_of_threads_foreach (gpointer key, gpointer value,
     gpointer user_data);
 
+static void gum_profiler_descend_call_tree (GumProfiler * self,
+    GumProfilerContext * pctx, GumFunctionContext * fctx);
+static void gum_profiler_ascend_call_tree (GumProfilerContext * pctx,
+    GumFunctionContext * fctx, GumSample duration, gboolean has_duration);
+static void gum_call_tree_node_emit_folded (GumCallTreeNode * node,
+    GString * prefix, GString * output, GHashTable * name_cache);
+static void gum_call_tree_node_free (GumCallTreeNode * node);
+
+static gpointer gum_profiler_run_sampler (gpointer data);
+static gboolean gum_profiler_collect_thread_id (
+    const GumThreadDetails * details, gpointer user_data);
+static void gum_profiler_capture_sample (GumThreadId thread_id,
+    GumCpuContext * cpu_context, gpointer user_data);
+static void gum_profiler_fold_sample (GumProfiler * self,
+    GumThreadId thread_id, const GumReturnAddressArray * frames);
+static GumProfileReportNode * gum_sample_tree_node_make_report_node (
+    GumSampleTreeNode * node);
+static void gum_sample_tree_node_emit_folded (GumSampleTreeNode * node,
+    GString * prefix, GString * output, GHashTable * name_cache);
+static void gum_sample_tree_node_free (GumSampleTreeNode * node);
+
 static GumFunctionThreadContext * gum_function_context_get_current_thread (
     GumFunctionContext * function_ctx, GumInvocationContext * context);
 
@@ -151,10 +238,13 @@ static void
 gum_profiler_init (GumProfiler * self)
 {
   g_mutex_init (&self->mutex);
+  g_cond_init (&self->sampling_cond);
 
   self->interceptor = gum_interceptor_obtain ();
   self->function_by_address = g_hash_table_new_full (g_direct_hash,
       g_direct_equal, NULL, NULL);
+  self->sample_tree_by_thread_id = g_hash_table_new_full (g_direct_hash,
+      g_direct_equal, NULL, (GDestroyNotify) gum_sample_tree_node_free);
 }
 
 static void
@@ -166,6 +256,8 @@ gum_profiler_dispose (GObject * object)
   {
     self->disposed = TRUE;
 
+    gum_profiler_stop_sampling (self);
+
     gum_interceptor_detach (self->interceptor, GUM_INVOCATION_LISTENER (self));
 
     g_hash_table_foreach (self->function_by_address,
@@ -191,8 +283,25 @@ gum_profiler_finalize (GObject * object)
     self->stacks = g_slist_delete_link (self->stacks, self->stacks);
   }
 
+  while (self->thread_context_caches != NULL)
+  {
+    GHashTable * cache = (GHashTable *) self->thread_context_caches->data;
+    g_hash_table_unref (cache);
+    self->thread_context_caches = g_slist_delete_link (
+        self->thread_context_caches, self->thread_context_caches);
+  }
+
+  while (self->call_trees != NULL)
+  {
+    gum_call_tree_node_free ((GumCallTreeNode *) self->call_trees->data);
+    self->call_trees = g_slist_delete_link (self->call_trees,
+        self->call_trees);
+  }
+
+  g_hash_table_unref (self->sample_tree_by_thread_id);
   g_hash_table_unref (self->function_by_address);
 
+  g_cond_clear (&self->sampling_cond);
   g_mutex_clear (&self->mutex);
 
   G_OBJECT_CLASS (gum_profiler_parent_class)->finalize (object);
@@ -202,6 +311,7 @@ static void
 gum_profiler_on_enter (GumInvocationListener * listener,
                        GumInvocationContext * context)
 {
+  GumProfiler * self = GUM_PROFILER (listener);
   GumProfilerInvocation * inv;
   GumFunctionContext * fctx;
   GumFunctionThreadContext * tctx;
@@ -211,25 +321,38 @@ gum_profiler_on_enter (GumInvocationListener * listener,
   inv->profiler = GUM_IC_GET_THREAD_DATA (context, GumProfilerContext);
   if (inv->profiler->stack == NULL)
   {
-    GumProfiler * self = GUM_PROFILER (listener);
-
     inv->profiler->stack = g_array_sized_new (FALSE, FALSE,
         sizeof (GumFunctionThreadContext *), GUM_MAX_CALL_DEPTH);
+    inv->profiler->thread_context_by_function =
+        g_hash_table_new (g_direct_hash, g_direct_equal);
 
     GUM_PROFILER_LOCK ();
     self->stacks = g_slist_prepend (self->stacks, inv->profiler->stack);
+    self->thread_context_caches = g_slist_prepend (
+        self->thread_context_caches,
+        inv->profiler->thread_context_by_function);
     GUM_PROFILER_UNLOCK ();
   }
 
   inv->function = GUM_IC_GET_FUNC_DATA (context, GumFunctionContext *);
-  inv->thread = gum_function_context_get_current_thread (inv->function,
-      context);
+  inv->thread = g_hash_table_lookup (
+      inv->profiler->thread_context_by_function, inv->function);
+  if (inv->thread == NULL)
+  {
+    inv->thread = gum_function_context_get_current_thread (inv->function,
+        context);
+    g_hash_table_insert (inv->profiler->thread_context_by_function,
+        inv->function, inv->thread);
+  }
 
   fctx = inv->function;
   tctx = inv->thread;
 
   g_array_append_val (inv->profiler->stack, tctx);
 
+  if (self->stack_folding_enabled)
+    gum_profiler_descend_call_tree (self, inv->profiler, fctx);
+
   tctx->total_calls++;
 
   if (tctx->recurse_count == 0)
@@ -252,10 +375,13 @@ static void
 gum_profiler_on_leave (GumInvocationListener * listener,
                        GumInvocationContext * context)
 {
+  GumProfiler * self = GUM_PROFILER (listener);
   GumProfilerInvocation * inv;
   GumFunctionContext * fctx;
   GumFunctionThreadContext * tctx;
   GArray * stack;
+  GumSample duration = 0;
+  gboolean has_duration = FALSE;
 
   inv = GUM_IC_GET_INVOCATION_DATA (context, GumProfilerInvocation);
 
@@ -265,12 +391,13 @@ gum_profiler_on_leave (GumInvocationListener * listener,
 
   if (tctx->recurse_count == 1)
   {
-    GumSample now, duration;
+    GumSample now;
     GumFunctionThreadContext * parent;
     guint i;
 
     now = fctx->sampler_interface->sample (fctx->sampler_instance);
     duration = now - inv->start_time;
+    has_duration = TRUE;
 
     tctx->total_duration += duration;
 
@@ -301,6 +428,12 @@ gum_profiler_on_leave (GumInvocationListener * listener,
 
   tctx->recurse_count--;
 
+  if (self->stack_folding_enabled)
+  {
+    gum_profiler_ascend_call_tree (inv->profiler, fctx, duration,
+        has_duration);
+  }
+
   g_array_set_size (stack, stack->len - 1);
 }
 
@@ -412,19 +545,518 @@ unstrument_and_free_function (gpointer key,
   g_free (function_ctx);
 }
 
+/*
+ * Starts periodic stack sampling alongside (or instead of) the
+ * instrumentation-based mode: a dedicated thread wakes up every
+ * interval_in_microseconds, briefly suspends each other thread in the
+ * process, captures its backtrace with the given backtracer, and folds
+ * the result into a per-thread tree. Passing NULL for backtracer picks
+ * the fuzzy one, falling back to the accurate one where unavailable.
+ *
+ * Sampled data shows up next to the instrumented data in both
+ * gum_profiler_generate_report() and
+ * gum_profiler_generate_folded_stacks(), with hit counts standing in for
+ * call counts and durations. Unlike instrumentation this leaves the
+ * profiled code untouched, so the workload is not distorted beyond the
+ * periodic suspension.
+ */
+gboolean
+gum_profiler_start_sampling (GumProfiler * self,
+                             guint interval_in_microseconds,
+                             GumBacktracer * backtracer)
+{
+  GUM_PROFILER_LOCK ();
+
+  if (self->sampling_thread != NULL)
+    goto unable_to_start;
+
+  if (backtracer != NULL)
+    self->sampling_backtracer = g_object_ref (backtracer);
+  else
+    self->sampling_backtracer = gum_backtracer_make_fuzzy ();
+  if (self->sampling_backtracer == NULL)
+    self->sampling_backtracer = gum_backtracer_make_accurate ();
+  if (self->sampling_backtracer == NULL)
+    goto unable_to_start;
+
+  self->sampling_interval = MAX (interval_in_microseconds, 1);
+  self->sampling_stopping = FALSE;
+  self->sampling_thread = g_thread_new ("gum-profiler-sampler",
+      gum_profiler_run_sampler, self);
+
+  GUM_PROFILER_UNLOCK ();
+
+  return TRUE;
+
+unable_to_start:
+  {
+    GUM_PROFILER_UNLOCK ();
+
+    return FALSE;
+  }
+}
+
+void
+gum_profiler_stop_sampling (GumProfiler * self)
+{
+  GThread * thread;
+
+  GUM_PROFILER_LOCK ();
+
+  thread = self->sampling_thread;
+  self->sampling_thread = NULL;
+
+  if (thread != NULL)
+  {
+    self->sampling_stopping = TRUE;
+    g_cond_broadcast (&self->sampling_cond);
+  }
+
+  GUM_PROFILER_UNLOCK ();
+
+  if (thread == NULL)
+    return;
+
+  g_thread_join (thread);
+
+  g_clear_object (&self->sampling_backtracer);
+}
+
+static gpointer
+gum_profiler_run_sampler (gpointer data)
+{
+  GumProfiler * self = GUM_PROFILER (data);
+  GArray * thread_ids;
+  GumSampleCapture capture;
+
+  self->sampling_thread_id = gum_process_get_current_thread_id ();
+
+  thread_ids = g_array_new (FALSE, FALSE, sizeof (GumThreadId));
+  capture.backtracer = self->sampling_backtracer;
+
+  GUM_PROFILER_LOCK ();
+
+  while (!self->sampling_stopping)
+  {
+    gint64 deadline;
+    guint i;
+
+    GUM_PROFILER_UNLOCK ();
+
+    g_array_set_size (thread_ids, 0);
+    gum_process_enumerate_threads (gum_profiler_collect_thread_id,
+        thread_ids);
+
+    for (i = 0; i != thread_ids->len; i++)
+    {
+      GumThreadId thread_id = g_array_index (thread_ids, GumThreadId, i);
+
+      if (thread_id == self->sampling_thread_id)
+        continue;
+
+      capture.frames.len = 0;
+      if (!gum_process_modify_thread (thread_id, gum_profiler_capture_sample,
+          &capture))
+        continue;
+      if (capture.frames.len == 0)
+        continue;
+
+      GUM_PROFILER_LOCK ();
+      gum_profiler_fold_sample (self, thread_id, &capture.frames);
+      GUM_PROFILER_UNLOCK ();
+    }
+
+    GUM_PROFILER_LOCK ();
+
+    deadline = g_get_monotonic_time () + self->sampling_interval;
+    while (!self->sampling_stopping &&
+        g_cond_wait_until (&self->sampling_cond, &self->mutex, deadline))
+      ;
+  }
+
+  GUM_PROFILER_UNLOCK ();
+
+  g_array_free (thread_ids, TRUE);
+
+  return NULL;
+}
+
+static gboolean
+gum_profiler_collect_thread_id (const GumThreadDetails * details,
+                                gpointer user_data)
+{
+  GArray * thread_ids = (GArray *) user_data;
+
+  g_array_append_val (thread_ids, details->id);
+
+  return TRUE;
+}
+
+/*
+ * Runs while the target thread is suspended, so it must only walk the
+ * stack: any allocation or locking here could deadlock against the
+ * suspended thread.
+ */
+static void
+gum_profiler_capture_sample (GumThreadId thread_id,
+                             GumCpuContext * cpu_context,
+                             gpointer user_data)
+{
+  GumSampleCapture * capture = (GumSampleCapture *) user_data;
+
+  gum_backtracer_generate (capture->backtracer, cpu_context,
+      &capture->frames);
+}
+
+static void
+gum_profiler_fold_sample (GumProfiler * self,
+                          GumThreadId thread_id,
+                          const GumReturnAddressArray * frames)
+{
+  GumSampleTreeNode * node;
+  guint i;
+
+  node = g_hash_table_lookup (self->sample_tree_by_thread_id,
+      GSIZE_TO_POINTER (thread_id));
+  if (node == NULL)
+  {
+    node = g_new0 (GumSampleTreeNode, 1);
+    g_hash_table_insert (self->sample_tree_by_thread_id,
+        GSIZE_TO_POINTER (thread_id), node);
+  }
+
+  node->hits++;
+
+  for (i = frames->len; i != 0; i--)
+  {
+    gpointer address = frames->items[i - 1];
+    GumSampleTreeNode * child;
+
+    for (child = node->first_child; child != NULL; child = child->next_sibling)
+    {
+      if (child->address == address)
+        break;
+    }
+
+    if (child == NULL)
+    {
+      child = g_new0 (GumSampleTreeNode, 1);
+      child->address = address;
+      child->next_sibling = node->first_child;
+      node->first_child = child;
+    }
+
+    child->hits++;
+
+    node = child;
+  }
+
+  node->self_hits++;
+}
+
 GumProfileReport *
 gum_profiler_generate_report (GumProfiler * self)
 {
   GumProfileReport * report;
+  GHashTableIter iter;
+  gpointer thread_id, tree;
 
   report = gum_profile_report_new ();
   g_hash_table_foreach (self->function_by_address, add_to_report_if_root_node,
       report);
+
+  GUM_PROFILER_LOCK ();
+
+  g_hash_table_iter_init (&iter, self->sample_tree_by_thread_id);
+  while (g_hash_table_iter_next (&iter, &thread_id, &tree))
+  {
+    GumSampleTreeNode * root = (GumSampleTreeNode *) tree;
+    GumSampleTreeNode * child;
+
+    for (child = root->first_child; child != NULL; child = child->next_sibling)
+    {
+      _gum_profile_report_append_thread_root_node (report,
+          GPOINTER_TO_UINT (thread_id),
+          gum_sample_tree_node_make_report_node (child));
+    }
+  }
+
+  GUM_PROFILER_UNLOCK ();
+
   _gum_profile_report_sort (report);
 
   return report;
 }
 
+/*
+ * Must be flipped on before the profiled code starts running: enters and
+ * leaves that straddle the switch are simply not attributed.
+ */
+void
+gum_profiler_set_stack_folding_enabled (GumProfiler * self,
+                                        gboolean enabled)
+{
+  self->stack_folding_enabled = enabled;
+}
+
+/*
+ * Emits one collapsed-stack line per call path with a positive self
+ * duration, i.e. the format flamegraph tooling consumes directly:
+ * "caller;callee;... <duration>\n". Symbol names are resolved here, at
+ * emission time, never on the instrumented path. Safe to call while
+ * profiling continues; durations of still-running invocations are
+ * attributed once they complete. Lines from sampled stacks, if sampling
+ * has been started, carry self hit counts instead of durations.
+ */
+gchar *
+gum_profiler_generate_folded_stacks (GumProfiler * self)
+{
+  GString * output, * prefix;
+  GHashTable * name_cache;
+  GSList * cur;
+  GHashTableIter iter;
+  gpointer tree;
+
+  output = g_string_new ("");
+  prefix = g_string_new ("");
+  name_cache = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+      g_free);
+
+  GUM_PROFILER_LOCK ();
+
+  for (cur = self->call_trees; cur != NULL; cur = cur->next)
+  {
+    GumCallTreeNode * root = (GumCallTreeNode *) cur->data;
+    GumCallTreeNode * child;
+
+    for (child = g_atomic_pointer_get (&root->first_child);
+        child != NULL;
+        child = child->next_sibling)
+    {
+      gum_call_tree_node_emit_folded (child, prefix, output, name_cache);
+    }
+  }
+
+  g_hash_table_iter_init (&iter, self->sample_tree_by_thread_id);
+  while (g_hash_table_iter_next (&iter, NULL, &tree))
+  {
+    GumSampleTreeNode * root = (GumSampleTreeNode *) tree;
+    GumSampleTreeNode * child;
+
+    for (child = root->first_child; child != NULL; child = child->next_sibling)
+      gum_sample_tree_node_emit_folded (child, prefix, output, name_cache);
+  }
+
+  GUM_PROFILER_UNLOCK ();
+
+  g_hash_table_unref (name_cache);
+  g_string_free (prefix, TRUE);
+
+  return g_string_free (output, FALSE);
+}
+
+static void
+gum_profiler_descend_call_tree (GumProfiler * self,
+                                GumProfilerContext * pctx,
+                                GumFunctionContext * fctx)
+{
+  GumCallTreeNode * parent, * node;
+
+  if (pctx->call_tree_root == NULL)
+  {
+    pctx->call_tree_root = g_new0 (GumCallTreeNode, 1);
+    pctx->call_tree_cursor = pctx->call_tree_root;
+
+    GUM_PROFILER_LOCK ();
+    self->call_trees = g_slist_prepend (self->call_trees,
+        pctx->call_tree_root);
+    GUM_PROFILER_UNLOCK ();
+  }
+
+  parent = pctx->call_tree_cursor;
+
+  for (node = parent->first_child; node != NULL; node = node->next_sibling)
+  {
+    if (node->function_ctx == fctx)
+      break;
+  }
+
+  if (node == NULL)
+  {
+    node = g_new0 (GumCallTreeNode, 1);
+    node->function_ctx = fctx;
+    node->parent = parent;
+    node->next_sibling = parent->first_child;
+    g_atomic_pointer_set (&parent->first_child, node);
+  }
+
+  pctx->call_tree_cursor = node;
+}
+
+static void
+gum_profiler_ascend_call_tree (GumProfilerContext * pctx,
+                               GumFunctionContext * fctx,
+                               GumSample duration,
+                               gboolean has_duration)
+{
+  GumCallTreeNode * node = pctx->call_tree_cursor;
+
+  if (node == NULL || node->function_ctx != fctx)
+    return;
+
+  if (has_duration)
+  {
+    node->self_duration += duration;
+
+    /*
+     * Our inclusive time is part of the parent's, so carve it out: what
+     * remains on the parent once it too has left is its self time.
+     */
+    if (node->parent->function_ctx != NULL)
+      node->parent->self_duration -= (gint64) duration;
+  }
+
+  pctx->call_tree_cursor = node->parent;
+}
+
+static void
+gum_call_tree_node_emit_folded (GumCallTreeNode * node,
+                                GString * prefix,
+                                GString * output,
+                                GHashTable * name_cache)
+{
+  gsize saved_length = prefix->len;
+  const gchar * name;
+  gint64 self_duration;
+  GumCallTreeNode * child;
+
+  name = g_hash_table_lookup (name_cache, node->function_ctx);
+  if (name == NULL)
+  {
+    gchar * resolved_name;
+
+    resolved_name = gum_symbol_name_from_address (
+        node->function_ctx->function_address);
+    g_hash_table_insert (name_cache, node->function_ctx, resolved_name);
+    name = resolved_name;
+  }
+
+  if (prefix->len != 0)
+    g_string_append_c (prefix, ';');
+  g_string_append (prefix, name);
+
+  self_duration = node->self_duration;
+  if (self_duration > 0)
+  {
+    g_string_append_printf (output, "%s %" G_GINT64_FORMAT "\n", prefix->str,
+        self_duration);
+  }
+
+  for (child = g_atomic_pointer_get (&node->first_child);
+      child != NULL;
+      child = child->next_sibling)
+  {
+    gum_call_tree_node_emit_folded (child, prefix, output, name_cache);
+  }
+
+  g_string_truncate (prefix, saved_length);
+}
+
+static void
+gum_call_tree_node_free (GumCallTreeNode * node)
+{
+  GumCallTreeNode * child = node->first_child;
+
+  while (child != NULL)
+  {
+    GumCallTreeNode * next = child->next_sibling;
+
+    gum_call_tree_node_free (child);
+
+    child = next;
+  }
+
+  g_free (node);
+}
+
+/*
+ * The report model keeps a single child chain per root, so each level
+ * keeps its hottest child only; the full tree is available through the
+ * folded-stacks output.
+ */
+static GumProfileReportNode *
+gum_sample_tree_node_make_report_node (GumSampleTreeNode * node)
+{
+  GumSampleTreeNode * hottest, * child;
+  GumProfileReportNode * child_node = NULL;
+
+  hottest = NULL;
+  for (child = node->first_child; child != NULL; child = child->next_sibling)
+  {
+    if (hottest == NULL || child->hits > hottest->hits)
+      hottest = child;
+  }
+
+  if (hottest != NULL)
+    child_node = gum_sample_tree_node_make_report_node (hottest);
+
+  return make_node (gum_symbol_name_from_address (node->address),
+      node->hits, node->hits, 0, g_strdup (""), child_node);
+}
+
+static void
+gum_sample_tree_node_emit_folded (GumSampleTreeNode * node,
+                                  GString * prefix,
+                                  GString * output,
+                                  GHashTable * name_cache)
+{
+  gsize saved_length = prefix->len;
+  const gchar * name;
+  GumSampleTreeNode * child;
+
+  name = g_hash_table_lookup (name_cache, node->address);
+  if (name == NULL)
+  {
+    gchar * resolved_name;
+
+    resolved_name = gum_symbol_name_from_address (node->address);
+    g_hash_table_insert (name_cache, node->address, resolved_name);
+    name = resolved_name;
+  }
+
+  if (prefix->len != 0)
+    g_string_append_c (prefix, ';');
+  g_string_append (prefix, name);
+
+  if (node->self_hits > 0)
+  {
+    g_string_append_printf (output, "%s %" G_GUINT64_FORMAT "\n", prefix->str,
+        node->self_hits);
+  }
+
+  for (child = node->first_child; child != NULL; child = child->next_sibling)
+    gum_sample_tree_node_emit_folded (child, prefix, output, name_cache);
+
+  g_string_truncate (prefix, saved_length);
+}
+
+static void
+gum_sample_tree_node_free (GumSampleTreeNode * node)
+{
+  GumSampleTreeNode * child = node->first_child;
+
+  while (child != NULL)
+  {
+    GumSampleTreeNode * next = child->next_sibling;
+
+    gum_sample_tree_node_free (child);
+
+    child = next;
+  }
+
+  g_free (node);
+}
+
 static void
 add_to_report_if_root_node (gpointer key,
                             gpointer value,
@@ -11,6 +11,7 @@
 #include "gumprofilereport.h"
 #include "gumsampler.h"
 
+#include <gum/gumbacktracer.h>
 #include <gum/guminvocationcontext.h>
 
 G_BEGIN_DECLS
@@ -41,8 +42,16 @@ GUM_API GumInstrumentReturn gum_profiler_instrument_function_with_inspector (
     GumProfiler * self, gpointer function_address, GumSampler * sampler,
     GumWorstCaseInspectorFunc inspector_func, gpointer user_data);
 
+GUM_API gboolean gum_profiler_start_sampling (GumProfiler * self,
+    guint interval_in_microseconds, GumBacktracer * backtracer);
+GUM_API void gum_profiler_stop_sampling (GumProfiler * self);
+
 GUM_API GumProfileReport * gum_profiler_generate_report (GumProfiler * self);
 
+GUM_API void gum_profiler_set_stack_folding_enabled (GumProfiler * self,
+    gboolean enabled);
+GUM_API gchar * gum_profiler_generate_folded_stacks (GumProfiler * self);
+
 GUM_API guint gum_profiler_get_number_of_threads (GumProfiler * self);
 GUM_API GumSample gum_profiler_get_total_duration_of (GumProfiler * self,
     guint thread_index, gpointer function_address);
@@ -17,12 +17,32 @@ struct _GumProfileReport
   GPtrArray * thread_root_nodes;
 };
 
+typedef struct _GumProfileReportBinaryWriter GumProfileReportBinaryWriter;
+
+struct _GumProfileReportBinaryWriter
+{
+  GumProfileReportWriteFunc write;
+  gpointer user_data;
+  GHashTable * string_ids;
+  gboolean carry_on;
+};
+
 static void gum_profile_report_finalize (GObject * object);
 
 static void gum_profile_report_node_free (GumProfileReportNode * node);
 
 static void append_node_to_xml_string (GumProfileReportNode * node,
     GString * xml);
+static void gum_profile_report_binary_write (
+    GumProfileReportBinaryWriter * self, gconstpointer data, gsize size);
+static void gum_profile_report_binary_write_u32 (
+    GumProfileReportBinaryWriter * self, guint32 value);
+static void gum_profile_report_binary_write_u64 (
+    GumProfileReportBinaryWriter * self, guint64 value);
+static void gum_profile_report_binary_write_string (
+    GumProfileReportBinaryWriter * self, const gchar * str);
+static void gum_profile_report_binary_write_node (
+    GumProfileReportBinaryWriter * self, GumProfileReportNode * node);
 static gint root_node_compare_func (gconstpointer a, gconstpointer b);
 static gint thread_compare_func (gconstpointer a, gconstpointer b);
 
@@ -113,6 +133,61 @@ gum_profile_report_emit_xml (GumProfileReport * self)
   return g_string_free (xml, FALSE);
 }
 
+/*
+ * Streams the report in a compact binary form through `write`, emitting
+ * each node as it is visited, so nothing grows with the size of the
+ * report on our side. All integers are little-endian. The layout is an
+ * 8-byte "GUMPROF1" magic, the number of threads as u32, and per thread
+ * the number of root nodes as u32 followed by the nodes depth-first.
+ * Each node is: name, total_calls u64, total_duration u64,
+ * worst_case_duration u64, worst_case_info, has_child u8. Strings are
+ * written as a u32 ID, assigned in order of first use; an ID seen for
+ * the first time is followed by its u32 length and bytes, so repeated
+ * symbol names and infos cost four bytes after their first occurrence.
+ *
+ * Counters are cumulative, so periodic deltas amount to streaming a
+ * fresh report and letting the consumer subtract the previous one.
+ *
+ * Returns FALSE if `write` asked to stop, TRUE otherwise.
+ */
+gboolean
+gum_profile_report_emit_binary (GumProfileReport * self,
+                                GumProfileReportWriteFunc write,
+                                gpointer user_data)
+{
+  GumProfileReportBinaryWriter w;
+  guint thread_idx;
+
+  w.write = write;
+  w.user_data = user_data;
+  w.string_ids = g_hash_table_new (g_str_hash, g_str_equal);
+  w.carry_on = TRUE;
+
+  gum_profile_report_binary_write (&w, "GUMPROF1", 8);
+  gum_profile_report_binary_write_u32 (&w, self->thread_root_nodes->len);
+
+  for (thread_idx = 0; thread_idx < self->thread_root_nodes->len; thread_idx++)
+  {
+    GPtrArray * root_nodes;
+    guint node_idx;
+
+    root_nodes = (GPtrArray *)
+        g_ptr_array_index (self->thread_root_nodes, thread_idx);
+
+    gum_profile_report_binary_write_u32 (&w, root_nodes->len);
+
+    for (node_idx = 0; node_idx < root_nodes->len; node_idx++)
+    {
+      gum_profile_report_binary_write_node (&w, (GumProfileReportNode *)
+          g_ptr_array_index (root_nodes, node_idx));
+    }
+  }
+
+  g_hash_table_unref (w.string_ids);
+
+  return w.carry_on;
+}
+
 GPtrArray *
 gum_profile_report_get_root_nodes_for_thread (GumProfileReport * self,
                                               guint thread_index)
@@ -188,6 +263,77 @@ append_node_to_xml_string (GumProfileReportNode * node,
   g_string_append (xml, "</Node>");
 }
 
+static void
+gum_profile_report_binary_write (GumProfileReportBinaryWriter * self,
+                                 gconstpointer data,
+                                 gsize size)
+{
+  if (!self->carry_on)
+    return;
+
+  self->carry_on = self->write (data, size, self->user_data);
+}
+
+static void
+gum_profile_report_binary_write_u32 (GumProfileReportBinaryWriter * self,
+                                     guint32 value)
+{
+  guint32 v = GUINT32_TO_LE (value);
+
+  gum_profile_report_binary_write (self, &v, sizeof (v));
+}
+
+static void
+gum_profile_report_binary_write_u64 (GumProfileReportBinaryWriter * self,
+                                     guint64 value)
+{
+  guint64 v = GUINT64_TO_LE (value);
+
+  gum_profile_report_binary_write (self, &v, sizeof (v));
+}
+
+static void
+gum_profile_report_binary_write_string (GumProfileReportBinaryWriter * self,
+                                        const gchar * str)
+{
+  gpointer existing_id;
+
+  if (g_hash_table_lookup_extended (self->string_ids, str, NULL, &existing_id))
+  {
+    gum_profile_report_binary_write_u32 (self, GPOINTER_TO_UINT (existing_id));
+  }
+  else
+  {
+    guint32 id, length;
+
+    id = g_hash_table_size (self->string_ids);
+    g_hash_table_insert (self->string_ids, (gpointer) str,
+        GUINT_TO_POINTER (id));
+
+    length = strlen (str);
+    gum_profile_report_binary_write_u32 (self, id);
+    gum_profile_report_binary_write_u32 (self, length);
+    gum_profile_report_binary_write (self, str, length);
+  }
+}
+
+static void
+gum_profile_report_binary_write_node (GumProfileReportBinaryWriter * self,
+                                      GumProfileReportNode * node)
+{
+  guint8 has_child = (node->child != NULL) ? 1 : 0;
+
+  gum_profile_report_binary_write_string (self, node->name);
+  gum_profile_report_binary_write_u64 (self, node->total_calls);
+  gum_profile_report_binary_write_u64 (self, node->total_duration);
+  gum_profile_report_binary_write_u64 (self, node->worst_case_duration);
+  gum_profile_report_binary_write_string (self, node->worst_case_info);
+  gum_profile_report_binary_write (self, &has_child, sizeof (has_child));
+
+  if (node->child != NULL)
+    gum_profile_report_binary_write_node (self, node->child);
+}
+
 static gint
 root_node_compare_func (gconstpointer a,
                         gconstpointer b)
@@ -28,10 +28,16 @@ struct _GumProfileReportNode
   GumProfileReportNode * child;
 };
 
+typedef gboolean (* GumProfileReportWriteFunc) (gconstpointer data, gsize size,
+    gpointer user_data);
+
 GUM_API GumProfileReport * gum_profile_report_new (void);
 
 GUM_API gchar * gum_profile_report_emit_xml (GumProfileReport * self);
 
+GUM_API gboolean gum_profile_report_emit_binary (GumProfileReport * self,
+    GumProfileReportWriteFunc write, gpointer user_data);
+
 GUM_API GPtrArray * gum_profile_report_get_root_nodes_for_thread (
     GumProfileReport * self, guint thread_index);
 
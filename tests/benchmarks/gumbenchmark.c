@@ -0,0 +1,471 @@
+/*
+ * Copyright (C) 2020 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+/*
+ * Microbenchmark harness for the hot paths we care about across
+ * upgrades. Each benchmark runs a fixed number of iterations and
+ * reports nanoseconds per operation as JSON on stdout, so runs are
+ * comparable; pass `--baseline <file>` with the JSON of a previous run
+ * to get per-benchmark deltas and a non-zero exit code when any
+ * benchmark regressed beyond the threshold.
+ */
+
+#include <gum/gum.h>
+#include <gum/gumapiresolver.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GUM_BENCHMARK_MAX_RESULTS         16
+#define GUM_BENCHMARK_REGRESSION_FACTOR   1.25
+
+#define GUM_BENCHMARK_ATTACH_ITERATIONS   1000
+#define GUM_BENCHMARK_CALL_ITERATIONS     200000
+#define GUM_BENCHMARK_SCAN_SIZE           (32 * 1024 * 1024)
+#define GUM_BENCHMARK_SCAN_ITERATIONS     8
+#define GUM_BENCHMARK_RESOLVER_ITERATIONS 32
+
+typedef struct _GumBenchmarkResult GumBenchmarkResult;
+
+struct _GumBenchmarkResult
+{
+  const gchar * name;
+  guint64 iterations;
+  gdouble ns_per_op;
+};
+
+#define GUM_TYPE_BENCHMARK_LISTENER (gum_benchmark_listener_get_type ())
+G_DECLARE_FINAL_TYPE (GumBenchmarkListener, gum_benchmark_listener, GUM,
+    BENCHMARK_LISTENER, GObject)
+
+struct _GumBenchmarkListener
+{
+  GObject parent;
+
+  volatile gint count;
+};
+
+static void gum_benchmark_listener_iface_init (gpointer g_iface,
+    gpointer iface_data);
+static void gum_benchmark_listener_on_enter (GumInvocationListener * listener,
+    GumInvocationContext * context);
+static void gum_benchmark_listener_on_leave (GumInvocationListener * listener,
+    GumInvocationContext * context);
+
+static void gum_benchmark_interceptor_attach (void);
+static void gum_benchmark_interceptor_per_hit (void);
+static void gum_benchmark_interceptor_replace (void);
+static void gum_benchmark_report_instrumentation (
+    GumInterceptor * interceptor, gpointer function_address);
+static void gum_benchmark_memory_scan (void);
+static void gum_benchmark_api_resolver (void);
+
+static void gum_benchmark_record (const gchar * name, guint64 iterations,
+    gint64 total_us);
+static void gum_benchmark_emit_json (void);
+static gboolean gum_benchmark_compare_with_baseline (
+    const gchar * baseline_path);
+
+static GumBenchmarkResult gum_benchmark_results[GUM_BENCHMARK_MAX_RESULTS];
+static guint gum_benchmark_result_count = 0;
+
+static volatile gint gum_benchmark_sink = 0;
+
+G_DEFINE_TYPE_EXTENDED (GumBenchmarkListener,
+                        gum_benchmark_listener,
+                        G_TYPE_OBJECT,
+                        0,
+                        G_IMPLEMENT_INTERFACE (GUM_TYPE_INVOCATION_LISTENER,
+                            gum_benchmark_listener_iface_init))
+
+gint
+main (gint argc,
+      gchar * argv[])
+{
+  const gchar * baseline_path = NULL;
+  gint i;
+
+  gum_init ();
+
+  for (i = 1; i != argc; i++)
+  {
+    if (strcmp (argv[i], "--baseline") == 0 && i + 1 != argc)
+      baseline_path = argv[++i];
+  }
+
+  gum_benchmark_interceptor_attach ();
+  gum_benchmark_interceptor_per_hit ();
+  gum_benchmark_interceptor_replace ();
+  gum_benchmark_memory_scan ();
+  gum_benchmark_api_resolver ();
+
+  gum_benchmark_emit_json ();
+
+  if (baseline_path != NULL)
+  {
+    if (!gum_benchmark_compare_with_baseline (baseline_path))
+      return 1;
+  }
+
+  return 0;
+}
+
+GUM_NOINLINE static gint
+gum_benchmark_target_function (gint x)
+{
+  gum_benchmark_sink += x;
+
+  return x + 1;
+}
+
+static void
+gum_benchmark_interceptor_attach (void)
+{
+  GumInterceptor * interceptor;
+  GumInvocationListener * listener;
+  gint64 started;
+  guint i;
+
+  interceptor = gum_interceptor_obtain ();
+  listener = g_object_new (GUM_TYPE_BENCHMARK_LISTENER, NULL);
+
+  started = g_get_monotonic_time ();
+
+  for (i = 0; i != GUM_BENCHMARK_ATTACH_ITERATIONS; i++)
+  {
+    gum_interceptor_attach (interceptor, gum_benchmark_target_function,
+        listener, NULL);
+    gum_interceptor_detach (interceptor, listener);
+  }
+
+  gum_benchmark_record ("interceptor_attach_detach",
+      GUM_BENCHMARK_ATTACH_ITERATIONS, g_get_monotonic_time () - started);
+
+  g_object_unref (listener);
+  g_object_unref (interceptor);
+}
+
+static void
+gum_benchmark_interceptor_per_hit (void)
+{
+  GumInterceptor * interceptor;
+  GumInvocationListener * listener;
+  gint64 started, direct_us, hooked_us;
+  guint i;
+
+  started = g_get_monotonic_time ();
+  for (i = 0; i != GUM_BENCHMARK_CALL_ITERATIONS; i++)
+    gum_benchmark_target_function (i);
+  direct_us = g_get_monotonic_time () - started;
+
+  gum_benchmark_record ("call_direct", GUM_BENCHMARK_CALL_ITERATIONS,
+      direct_us);
+
+  interceptor = gum_interceptor_obtain ();
+  listener = g_object_new (GUM_TYPE_BENCHMARK_LISTENER, NULL);
+
+  gum_interceptor_attach (interceptor, gum_benchmark_target_function,
+      listener, NULL);
+
+  gum_benchmark_report_instrumentation (interceptor,
+      gum_benchmark_target_function);
+
+  started = g_get_monotonic_time ();
+  for (i = 0; i != GUM_BENCHMARK_CALL_ITERATIONS; i++)
+    gum_benchmark_target_function (i);
+  hooked_us = g_get_monotonic_time () - started;
+
+  gum_interceptor_detach (interceptor, listener);
+
+  gum_benchmark_record ("call_hooked", GUM_BENCHMARK_CALL_ITERATIONS,
+      hooked_us);
+  gum_benchmark_record ("interceptor_hit_overhead",
+      GUM_BENCHMARK_CALL_ITERATIONS, MAX (hooked_us - direct_us, 0));
+
+  g_object_unref (listener);
+  g_object_unref (interceptor);
+}
+
+GUM_NOINLINE static gint
+gum_benchmark_replacement_function (gint x)
+{
+  gum_benchmark_sink += x;
+
+  return x + 1;
+}
+
+/*
+ * Replacement is the minimal-context strategy: the redirect goes straight
+ * to the replacement with no CPU-context capture or listener dispatch, so
+ * comparing call_replaced against call_hooked shows what the full-context
+ * thunks cost on this host beyond the redirect itself.
+ */
+static void
+gum_benchmark_interceptor_replace (void)
+{
+  GumInterceptor * interceptor;
+  gint64 started;
+  guint i;
+
+  interceptor = gum_interceptor_obtain ();
+
+  if (gum_interceptor_replace (interceptor, gum_benchmark_target_function,
+      gum_benchmark_replacement_function, NULL) != GUM_REPLACE_OK)
+  {
+    g_object_unref (interceptor);
+    return;
+  }
+
+  gum_benchmark_report_instrumentation (interceptor,
+      gum_benchmark_target_function);
+
+  started = g_get_monotonic_time ();
+  for (i = 0; i != GUM_BENCHMARK_CALL_ITERATIONS; i++)
+    gum_benchmark_target_function (i);
+
+  gum_benchmark_record ("call_replaced", GUM_BENCHMARK_CALL_ITERATIONS,
+      g_get_monotonic_time () - started);
+
+  gum_interceptor_revert (interceptor, gum_benchmark_target_function);
+
+  g_object_unref (interceptor);
+}
+
+static void
+gum_benchmark_report_instrumentation (GumInterceptor * interceptor,
+                                      gpointer function_address)
+{
+  GumInstrumentationReport report;
+
+  if (!gum_interceptor_query_instrumentation (interceptor, function_address,
+      &report))
+    return;
+
+  fprintf (stderr, "instrumentation: %u-byte redirect, trampoline at "
+      "%+" G_GSSIZE_FORMAT " bytes, deflector: %s, replacement: %s, "
+      "listeners: %u\n",
+      report.redirect_size,
+      report.trampoline_distance,
+      report.uses_deflector ? "yes" : "no",
+      report.has_replacement ? "yes" : "no",
+      report.n_listeners);
+}
+
+static gboolean
+gum_benchmark_scan_match (GumAddress address,
+                          gsize size,
+                          gpointer user_data)
+{
+  guint * num_matches = user_data;
+
+  (*num_matches)++;
+
+  return TRUE;
+}
+
+static void
+gum_benchmark_memory_scan (void)
+{
+  guint8 * buffer;
+  GumMemoryRange range;
+  GumMatchPattern * pattern;
+  guint num_matches, i;
+  gint64 started;
+
+  buffer = g_malloc0 (GUM_BENCHMARK_SCAN_SIZE);
+  memcpy (buffer + GUM_BENCHMARK_SCAN_SIZE - 8, "\x13\x37\x13\x37\x13\x37\x13"
+      "\x37", 8);
+
+  range.base_address = GUM_ADDRESS (buffer);
+  range.size = GUM_BENCHMARK_SCAN_SIZE;
+
+  pattern = gum_match_pattern_new_from_string ("13 37 13 37 13 37 13 37");
+
+  num_matches = 0;
+
+  started = g_get_monotonic_time ();
+
+  for (i = 0; i != GUM_BENCHMARK_SCAN_ITERATIONS; i++)
+    gum_memory_scan (&range, pattern, gum_benchmark_scan_match, &num_matches);
+
+  /* One operation here is one scanned megabyte. */
+  gum_benchmark_record ("memory_scan_per_mb",
+      (guint64) GUM_BENCHMARK_SCAN_ITERATIONS *
+          (GUM_BENCHMARK_SCAN_SIZE / (1024 * 1024)),
+      g_get_monotonic_time () - started);
+
+  if (num_matches != GUM_BENCHMARK_SCAN_ITERATIONS)
+    fprintf (stderr, "warning: unexpected scan match count\n");
+
+  gum_match_pattern_free (pattern);
+  g_free (buffer);
+}
+
+static gboolean
+gum_benchmark_count_api_match (const GumApiDetails * details,
+                               gpointer user_data)
+{
+  guint * num_matches = user_data;
+
+  (*num_matches)++;
+
+  return TRUE;
+}
+
+static void
+gum_benchmark_api_resolver (void)
+{
+  GumApiResolver * resolver;
+  guint num_matches, i;
+  gint64 started;
+
+  resolver = gum_api_resolver_make ("module");
+  if (resolver == NULL)
+    return;
+
+  num_matches = 0;
+
+  started = g_get_monotonic_time ();
+
+  for (i = 0; i != GUM_BENCHMARK_RESOLVER_ITERATIONS; i++)
+  {
+    gum_api_resolver_enumerate_matches (resolver, "exports:*!*open*",
+        gum_benchmark_count_api_match, &num_matches, NULL);
+  }
+
+  gum_benchmark_record ("api_resolver_query",
+      GUM_BENCHMARK_RESOLVER_ITERATIONS, g_get_monotonic_time () - started);
+
+  g_object_unref (resolver);
+}
+
+static void
+gum_benchmark_record (const gchar * name,
+                      guint64 iterations,
+                      gint64 total_us)
+{
+  GumBenchmarkResult * result;
+
+  g_assert (gum_benchmark_result_count != GUM_BENCHMARK_MAX_RESULTS);
+
+  result = &gum_benchmark_results[gum_benchmark_result_count++];
+  result->name = name;
+  result->iterations = iterations;
+  result->ns_per_op = (total_us * 1000.0) / iterations;
+}
+
+static void
+gum_benchmark_emit_json (void)
+{
+  guint i;
+
+  printf ("{\"benchmarks\":[");
+
+  for (i = 0; i != gum_benchmark_result_count; i++)
+  {
+    GumBenchmarkResult * result = &gum_benchmark_results[i];
+
+    printf ("%s{\"name\":\"%s\",\"iterations\":%" G_GUINT64_FORMAT
+        ",\"ns_per_op\":%.2f}",
+        (i != 0) ? "," : "",
+        result->name,
+        result->iterations,
+        result->ns_per_op);
+  }
+
+  printf ("]}\n");
+}
+
+/*
+ * Reads ns_per_op values out of a previous run's JSON with plain string
+ * scanning, deliberately avoiding a JSON dependency for a format we
+ * produce ourselves.
+ */
+static gboolean
+gum_benchmark_compare_with_baseline (const gchar * baseline_path)
+{
+  gboolean all_within_threshold = TRUE;
+  gchar * baseline;
+  guint i;
+
+  if (!g_file_get_contents (baseline_path, &baseline, NULL, NULL))
+  {
+    fprintf (stderr, "unable to read baseline: %s\n", baseline_path);
+    return FALSE;
+  }
+
+  for (i = 0; i != gum_benchmark_result_count; i++)
+  {
+    GumBenchmarkResult * result = &gum_benchmark_results[i];
+    gchar * key, * entry;
+    gdouble baseline_ns_per_op, ratio;
+
+    key = g_strdup_printf ("\"name\":\"%s\"", result->name);
+    entry = strstr (baseline, key);
+    g_free (key);
+
+    if (entry == NULL)
+      continue;
+
+    entry = strstr (entry, "\"ns_per_op\":");
+    if (entry == NULL)
+      continue;
+
+    baseline_ns_per_op = g_ascii_strtod (entry + 12, NULL);
+    if (baseline_ns_per_op <= 0.0)
+      continue;
+
+    ratio = result->ns_per_op / baseline_ns_per_op;
+
+    fprintf (stderr, "%s: %.2f ns/op vs %.2f ns/op baseline (%.2fx)\n",
+        result->name, result->ns_per_op, baseline_ns_per_op, ratio);
+
+    if (ratio > GUM_BENCHMARK_REGRESSION_FACTOR)
+    {
+      fprintf (stderr, "%s: REGRESSION beyond %.2fx threshold\n",
+          result->name, GUM_BENCHMARK_REGRESSION_FACTOR);
+      all_within_threshold = FALSE;
+    }
+  }
+
+  g_free (baseline);
+
+  return all_within_threshold;
+}
+
+static void
+gum_benchmark_listener_class_init (GumBenchmarkListenerClass * klass)
+{
+}
+
+static void
+gum_benchmark_listener_init (GumBenchmarkListener * self)
+{
+}
+
+static void
+gum_benchmark_listener_iface_init (gpointer g_iface,
+                                   gpointer iface_data)
+{
+  GumInvocationListenerInterface * iface = g_iface;
+
+  iface->on_enter = gum_benchmark_listener_on_enter;
+  iface->on_leave = gum_benchmark_listener_on_leave;
+}
+
+static void
+gum_benchmark_listener_on_enter (GumInvocationListener * listener,
+                                 GumInvocationContext * context)
+{
+  GUM_BENCHMARK_LISTENER (listener)->count++;
+}
+
+static void
+gum_benchmark_listener_on_leave (GumInvocationListener * listener,
+                                 GumInvocationContext * context)
+{
+}
@@ -589,7 +589,7 @@ TESTCASE (rip_relative_move_different_target)
     0x50,                               /* push rax           */
     0x48, 0xb8, 0xff, 0xff, 0xff, 0xff, /* mov rax, <rip>     */
                 0xff, 0xff, 0xff, 0xff,
-    0x8b, 0x90, 0x01, 0x00, 0x00, 0x00, /* mov edx, [rax + 1] */
+    0x8b, 0x50, 0x01,                   /* mov edx, [rax + 1] */
     0x58                                /* pop rax            */
   };
 
@@ -614,7 +614,7 @@ TESTCASE (rip_relative_move_same_target)
     0x51,                               /* push rcx           */
     0x48, 0xb9, 0xff, 0xff, 0xff, 0xff, /* mov rcx, <rip>     */
                 0xff, 0xff, 0xff, 0xff,
-    0x8b, 0x81, 0x01, 0x00, 0x00, 0x00, /* mov eax, [rcx + 1] */
+    0x8b, 0x41, 0x01,                   /* mov eax, [rcx + 1] */
     0x59                                /* pop rcx            */
   };
 
@@ -705,8 +705,7 @@ TESTCASE (rip_relative_cmpxchg)
     0x52,                               /* push rdx           */
     0x48, 0xba, 0xff, 0xff, 0xff, 0xff, /* mov rdx, <rip>     */
                 0xff, 0xff, 0xff, 0xff,
-    0xf0, 0x48, 0x0f, 0xb1, 0x8a,       /* lock cmpxchg [rdx + 1], rcx */
-                0x01, 0x00, 0x00, 0x00,
+    0xf0, 0x48, 0x0f, 0xb1, 0x4a, 0x01, /* lock cmpxchg [rdx + 1], rcx */
     0x5a                                /* pop rdx            */
   };
 
@@ -16,9 +16,11 @@ TESTLIST_BEGIN (stalker)
   TESTENTRY (call)
   TESTENTRY (ret)
   TESTENTRY (exec)
+  TESTENTRY (per_range_event_mask)
   TESTENTRY (call_depth)
   TESTENTRY (call_probe)
   TESTENTRY (custom_transformer)
+  TESTENTRY (minimal_callout_can_be_used_without_context)
   TESTENTRY (unfollow_should_be_allowed_before_first_transform)
   TESTENTRY (unfollow_should_be_allowed_mid_first_transform)
   TESTENTRY (unfollow_should_be_allowed_after_first_transform)
@@ -26,6 +28,8 @@ TESTLIST_BEGIN (stalker)
   TESTENTRY (unfollow_should_be_allowed_mid_second_transform)
   TESTENTRY (unfollow_should_be_allowed_after_second_transform)
   TESTENTRY (follow_me_should_support_nullable_event_sink)
+  TESTENTRY (follow_unfollow_should_be_repeatable)
+  TESTENTRY (query_stats_should_report_active_thread)
 
   TESTENTRY (unconditional_jumps)
   TESTENTRY (short_conditional_jump_true)
@@ -66,6 +70,7 @@ TESTLIST_BEGIN (stalker)
   TESTENTRY (heap_api)
   TESTENTRY (follow_syscall)
   TESTENTRY (follow_thread)
+  TESTENTRY (follow_all_threads)
   TESTENTRY (unfollow_should_handle_terminated_thread)
 #ifndef HAVE_WINDOWS
   TESTENTRY (performance)
@@ -91,6 +96,9 @@ static void pretend_workload (GumMemoryRange * runner_range);
 static void insert_extra_increment_after_xor (GumStalkerIterator * iterator,
     GumStalkerOutput * output, gpointer user_data);
 static void store_xax (GumCpuContext * cpu_context, gpointer user_data);
+static void insert_minimal_callout_after_xor (GumStalkerIterator * iterator,
+    GumStalkerOutput * output, gpointer user_data);
+static void bump_num_calls (GumCpuContext * cpu_context, gpointer user_data);
 static void unfollow_during_transform (GumStalkerIterator * iterator,
     GumStalkerOutput * output, gpointer user_data);
 static void invoke_follow_return_code (TestStalkerFixture * fixture);
@@ -161,6 +169,22 @@ TESTCASE (follow_thread)
   sdc_finalize (&channel);
 }
 
+TESTCASE (follow_all_threads)
+{
+  fixture->sink->mask = GUM_EXEC | GUM_CALL | GUM_RET;
+
+  gum_stalker_follow_all (fixture->stalker, fixture->transformer,
+      GUM_EVENT_SINK (fixture->sink));
+
+  g_assert_true (gum_stalker_is_following_me (fixture->stalker));
+  g_usleep (1);
+
+  gum_stalker_unfollow_all (fixture->stalker);
+
+  g_assert_false (gum_stalker_is_following_me (fixture->stalker));
+  g_assert_cmpuint (fixture->sink->events->len, >, 0);
+}
+
 static gpointer
 run_stalked_briefly (gpointer data)
 {
@@ -427,6 +451,35 @@ TESTCASE (exec)
   GUM_ASSERT_CMPADDR (ev->location, ==, func);
 }
 
+TESTCASE (per_range_event_mask)
+{
+  StalkerTestFunc func;
+  GumMemoryRange range;
+  gint ret;
+  guint i;
+
+  func = GUM_POINTER_TO_FUNCPTR (StalkerTestFunc,
+      test_stalker_fixture_dup_code (fixture, flat_code, sizeof (flat_code)));
+
+  range.base_address = GUM_ADDRESS (func);
+  range.size = sizeof (flat_code);
+  gum_stalker_set_event_mask_for_range (fixture->stalker, &range, GUM_NOTHING);
+
+  fixture->sink->mask = GUM_EXEC;
+  ret = test_stalker_fixture_follow_and_invoke (fixture, func, -1);
+  g_assert_cmpint (ret, ==, 2);
+
+  g_assert_cmpuint (fixture->sink->events->len, ==, INVOKER_INSN_COUNT);
+  for (i = 0; i != fixture->sink->events->len; i++)
+  {
+    GumExecEvent * ev =
+        &g_array_index (fixture->sink->events, GumEvent, i).exec;
+
+    g_assert_false (GUM_MEMORY_RANGE_INCLUDES (&range,
+        GUM_ADDRESS (ev->location)));
+  }
+}
+
 TESTCASE (call_depth)
 {
   const guint8 code[] =
@@ -652,6 +705,49 @@ store_xax (GumCpuContext * cpu_context,
   *last_xax = GUM_CPU_CONTEXT_XAX (cpu_context);
 }
 
+TESTCASE (minimal_callout_can_be_used_without_context)
+{
+  gsize num_calls = 0;
+
+  fixture->transformer = gum_stalker_transformer_make_from_callback (
+      insert_minimal_callout_after_xor, &num_calls, NULL);
+
+  invoke_flat_expecting_return_value (fixture, GUM_NOTHING, 2);
+
+  g_assert_cmpuint (num_calls, ==, 1);
+}
+
+static void
+insert_minimal_callout_after_xor (GumStalkerIterator * iterator,
+                                  GumStalkerOutput * output,
+                                  gpointer user_data)
+{
+  gsize * num_calls = user_data;
+  const cs_insn * insn;
+
+  while (gum_stalker_iterator_next (iterator, &insn))
+  {
+    gum_stalker_iterator_keep (iterator);
+
+    if (insn->id == X86_INS_XOR)
+    {
+      gum_stalker_iterator_put_callout_with_flags (iterator,
+          bump_num_calls, num_calls, NULL, GUM_STALKER_CALLOUT_NO_CONTEXT);
+    }
+  }
+}
+
+static void
+bump_num_calls (GumCpuContext * cpu_context,
+                gpointer user_data)
+{
+  gsize * num_calls = user_data;
+
+  g_assert_null (cpu_context);
+
+  (*num_calls)++;
+}
+
 TESTCASE (unfollow_should_be_allowed_before_first_transform)
 {
   UnfollowTransformContext ctx;
@@ -781,6 +877,52 @@ TESTCASE (follow_me_should_support_nullable_event_sink)
   gum_stalker_unfollow_me (fixture->stalker);
 }
 
+TESTCASE (follow_unfollow_should_be_repeatable)
+{
+  guint i;
+
+  fixture->sink->mask = GUM_EXEC | GUM_CALL | GUM_RET;
+
+  for (i = 0; i != 4; i++)
+  {
+    gpointer p;
+
+    gum_stalker_follow_me (fixture->stalker, fixture->transformer,
+        GUM_EVENT_SINK (fixture->sink));
+    p = malloc (1);
+    free (p);
+    gum_stalker_unfollow_me (fixture->stalker);
+
+    g_assert_cmpuint (fixture->sink->events->len, >, 0);
+
+    gum_fake_event_sink_reset (fixture->sink);
+  }
+}
+
+TESTCASE (query_stats_should_report_active_thread)
+{
+  GumThreadId thread_id = gum_process_get_current_thread_id ();
+  GumStalkerStats stats;
+
+  g_assert_false (gum_stalker_query_stats (fixture->stalker, thread_id,
+      &stats));
+
+  gum_stalker_follow_me (fixture->stalker, fixture->transformer,
+      GUM_EVENT_SINK (fixture->sink));
+
+  g_assert_true (gum_stalker_query_stats (fixture->stalker, thread_id,
+      &stats));
+  g_assert_cmpuint (stats.blocks_compiled, >, 0);
+  g_assert_cmpuint (stats.slab_bytes, >, 0);
+  g_assert_cmpuint (stats.slab_count, >, 0);
+  g_assert_cmpuint (stats.slab_huge_bytes, <=, stats.slab_bytes);
+
+  gum_stalker_unfollow_me (fixture->stalker);
+
+  g_assert_false (gum_stalker_query_stats (fixture->stalker, thread_id,
+      &stats));
+}
+
 TESTCASE (unconditional_jumps)
 {
   invoke_jumpy (fixture, GUM_EXEC);
@@ -11,6 +11,7 @@
 
 TESTLIST_BEGIN (backtracer)
   TESTENTRY (basics)
+  TESTENTRY (batch_resolution)
   TESTENTRY (full_cycle_with_interceptor)
   TESTENTRY (full_cycle_with_allocation_tracker)
 #if ENABLE_PERFORMANCE_TEST
@@ -58,6 +59,42 @@ TESTCASE (basics)
 #endif
 }
 
+TESTCASE (batch_resolution)
+{
+  GumReturnAddressArray ret_addrs = { 0, };
+  GumReturnAddressDetails details[GUM_MAX_BACKTRACE_DEPTH];
+  gboolean resolved[GUM_MAX_BACKTRACE_DEPTH];
+  guint i;
+
+  if (!g_test_slow ())
+  {
+    g_print ("<skipping, run in slow mode> ");
+    return;
+  }
+
+  gum_backtracer_generate (fixture->backtracer, NULL, &ret_addrs);
+  g_assert_cmpuint (ret_addrs.len, >=, 2);
+
+  if (ret_addrs.len < GUM_MAX_BACKTRACE_DEPTH)
+    ret_addrs.items[ret_addrs.len++] = ret_addrs.items[0];
+
+  gum_return_address_array_load_details (&ret_addrs, details, resolved);
+
+  for (i = 0; i != ret_addrs.len; i++)
+  {
+    GumReturnAddressDetails rad;
+
+    g_assert_cmpint (resolved[i], ==,
+        gum_return_address_details_from_address (ret_addrs.items[i], &rad));
+
+    if (resolved[i])
+    {
+      g_assert_cmpstr (details[i].function_name, ==, rad.function_name);
+      g_assert_cmpuint (details[i].line_number, ==, rad.line_number);
+    }
+  }
+}
+
 TESTCASE (full_cycle_with_interceptor)
 {
   GumInterceptor * interceptor;
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2020 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#include "testutil.h"
+
+#include <string.h>
+
+#define TESTCASE(NAME) \
+    void test_debug_log_ ## NAME (void)
+#define TESTENTRY(NAME) \
+    TESTENTRY_SIMPLE ("Core/DebugLog", test_debug_log, NAME)
+
+TESTLIST_BEGIN (debuglog)
+  TESTENTRY (messages_should_be_formatted_on_flush)
+  TESTENTRY (flush_without_sink_should_discard_messages)
+TESTLIST_END ()
+
+static void test_debug_log_append_message (const gchar * message,
+    gpointer user_data);
+
+TESTCASE (messages_should_be_formatted_on_flush)
+{
+  GString * output;
+
+  output = g_string_new (NULL);
+
+  gum_debug_log ("on_enter depth=%d target=%p name=%s", 3,
+      GSIZE_TO_POINTER (0x1234), "open");
+  gum_debug_log ("plain message with %% literal");
+
+  gum_debug_log_set_sink (test_debug_log_append_message, output);
+  gum_debug_log_flush ();
+  gum_debug_log_set_sink (NULL, NULL);
+
+  g_assert_nonnull (strstr (output->str, "on_enter depth=3"));
+  g_assert_nonnull (strstr (output->str, "name=open"));
+  g_assert_nonnull (strstr (output->str, "plain message with % literal"));
+
+  g_string_free (output, TRUE);
+}
+
+TESTCASE (flush_without_sink_should_discard_messages)
+{
+  GString * output;
+
+  output = g_string_new (NULL);
+
+  gum_debug_log ("this should be discarded");
+  gum_debug_log_flush ();
+
+  gum_debug_log_set_sink (test_debug_log_append_message, output);
+  gum_debug_log_flush ();
+  gum_debug_log_set_sink (NULL, NULL);
+
+  g_assert_null (strstr (output->str, "discarded"));
+
+  g_string_free (output, TRUE);
+}
+
+static void
+test_debug_log_append_message (const gchar * message,
+                               gpointer user_data)
+{
+  GString * output = user_data;
+
+  g_string_append (output, message);
+  g_string_append_c (output, '\n');
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2021 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#include "testutil.h"
+
+#define TESTCASE(NAME) \
+    void test_function_index_ ## NAME (void)
+#define TESTENTRY(NAME) \
+    TESTENTRY_SIMPLE ("Core/FunctionIndex", test_function_index, NAME)
+
+TESTLIST_BEGIN (function_index)
+#if defined (HAVE_I386) || defined (HAVE_ARM) || defined (HAVE_ARM64)
+  TESTENTRY (own_module_can_be_indexed)
+  TESTENTRY (containing_function_can_be_found)
+#endif
+TESTLIST_END ()
+
+#if defined (HAVE_I386) || defined (HAVE_ARM) || defined (HAVE_ARM64)
+
+TESTCASE (own_module_can_be_indexed)
+{
+  GumFunctionIndex * index;
+  guint count, i;
+
+  index = gum_function_index_new_for_module (GUM_TESTS_MODULE_NAME);
+  g_assert_nonnull (index);
+
+  count = gum_function_index_get_count (index);
+  g_assert_cmpuint (count, >, 0);
+
+  for (i = 1; i != count; i++)
+  {
+    g_assert_cmpuint (gum_function_index_get_nth (index, i - 1), <,
+        gum_function_index_get_nth (index, i));
+  }
+
+  g_object_unref (index);
+}
+
+TESTCASE (containing_function_can_be_found)
+{
+  GumFunctionIndex * index;
+  GumAddress nth, start;
+
+  index = gum_function_index_new_for_module (GUM_TESTS_MODULE_NAME);
+  g_assert_nonnull (index);
+
+  nth = gum_function_index_get_nth (index,
+      gum_function_index_get_count (index) / 2);
+  g_assert_true (gum_function_index_find_containing (index, nth + 1, &start));
+  g_assert_cmpuint (start, ==, nth);
+
+  g_assert_false (gum_function_index_find_containing (index,
+      gum_function_index_get_nth (index, 0) - 1, NULL));
+
+  g_object_unref (index);
+}
+
+#endif
@@ -25,6 +25,7 @@ TESTLIST_BEGIN (interceptor)
   TESTENTRY (attach_one)
   TESTENTRY (attach_two)
   TESTENTRY (attach_to_recursive_function)
+  TESTENTRY (invocation_stack_can_be_queried_without_traversal)
   TESTENTRY (attach_to_special_function)
 #ifdef G_OS_UNIX
   TESTENTRY (attach_to_pthread_key_create)
@@ -51,8 +52,13 @@ TESTLIST_BEGIN (interceptor)
   TESTENTRY (ignore_current_thread_nested)
   TESTENTRY (ignore_other_threads)
   TESTENTRY (detach)
+  TESTENTRY (detach_all)
   TESTENTRY (listener_ref_count)
   TESTENTRY (function_data)
+  TESTENTRY (hook_budget_overrun_is_reported)
+#ifndef HAVE_WINDOWS
+  TESTENTRY (attach_matching)
+#endif
 
   TESTENTRY (i_can_has_replaceability)
   TESTENTRY (already_replaced)
@@ -63,6 +69,12 @@ TESTLIST_BEGIN (interceptor)
 # endif
 #endif
   TESTENTRY (replace_then_attach)
+  TESTENTRY (replace_then_retarget)
+
+#if defined (HAVE_I386) || defined (HAVE_ARM64)
+  TESTENTRY (probe_one)
+  TESTENTRY (already_probed)
+#endif
 
 #ifdef HAVE_QNX
   TESTENTRY (intercept_malloc_and_create_thread)
@@ -76,8 +88,15 @@ static gpointer thread_calling_pthread_setspecific (gpointer data);
 #ifdef HAVE_WINDOWS
 static gpointer hit_target_function_repeatedly (gpointer data);
 #endif
+static void verify_invocation_stack_frames (gpointer user_data,
+    GumInvocationContext * context);
 static gpointer replacement_malloc (gsize size);
 static gpointer replacement_target_function (GString * str);
+static gpointer retargeted_target_function (GString * str);
+#if defined (HAVE_I386) || defined (HAVE_ARM64)
+static void probe_target_function (gpointer user_data, gpointer arg0,
+    gpointer arg1, gpointer arg2);
+#endif
 
 TESTCASE (attach_one)
 {
@@ -111,6 +130,54 @@ TESTCASE (attach_to_recursive_function)
   g_assert_cmpstr (fixture->result->str, ==, ">>>>>0<1<2<3<4<");
 }
 
+static void
+verify_invocation_stack_frames (gpointer user_data,
+                                GumInvocationContext * context)
+{
+  guint * n_checks = user_data;
+  GumInvocationStack * stack;
+  guint depth;
+
+  stack = gum_interceptor_get_current_stack ();
+  depth = gum_invocation_context_get_depth (context);
+
+  g_assert_cmpuint (gum_invocation_stack_get_depth (stack), ==, depth + 1);
+  g_assert_true (gum_invocation_stack_peek_nth (stack, 0) == context);
+
+  if (depth > 0)
+  {
+    GumInvocationContext * parent;
+
+    parent = gum_invocation_stack_peek_nth (stack, 1);
+    g_assert_nonnull (parent);
+    g_assert_true (parent->function == context->function);
+  }
+
+  g_assert_null (gum_invocation_stack_peek_nth (stack, depth + 1));
+
+  (*n_checks)++;
+}
+
+TESTCASE (invocation_stack_can_be_queried_without_traversal)
+{
+  TestCallbackListener * listener;
+  guint n_checks = 0;
+
+  listener = test_callback_listener_new ();
+  listener->on_enter = verify_invocation_stack_frames;
+  listener->user_data = &n_checks;
+
+  gum_interceptor_attach (fixture->interceptor, recursive_function,
+      GUM_INVOCATION_LISTENER (listener), NULL);
+  recursive_function (fixture->result, 3);
+  gum_interceptor_detach (fixture->interceptor,
+      GUM_INVOCATION_LISTENER (listener));
+
+  g_assert_cmpuint (n_checks, ==, 4);
+
+  g_object_unref (listener);
+}
+
 TESTCASE (attach_to_special_function)
 {
   interceptor_fixture_attach (fixture, 0, special_function, '>', '<');
@@ -186,6 +253,51 @@ TESTCASE (attach_to_own_api)
   g_object_unref (listener);
 }
 
+#ifndef HAVE_WINDOWS
+
+TESTCASE (attach_matching)
+{
+  GumApiResolver * resolver;
+  TestCallbackListener * listener;
+  GArray * handles;
+  GError * error = NULL;
+
+  resolver = gum_api_resolver_make ("module");
+  g_assert_nonnull (resolver);
+
+  listener = test_callback_listener_new ();
+  listener->on_enter = (TestCallbackListenerFunc) target_function;
+  listener->user_data = fixture->result;
+
+  handles = gum_interceptor_attach_matching (fixture->interceptor, resolver,
+      "bogus-query", GUM_INVOCATION_LISTENER (listener), NULL, &error);
+  g_assert_null (handles);
+  g_assert_nonnull (error);
+  g_clear_error (&error);
+
+  handles = gum_interceptor_attach_matching (fixture->interceptor, resolver,
+      "exports:*targetfunctions*!gum_test_target_function",
+      GUM_INVOCATION_LISTENER (listener), NULL, &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (handles);
+  g_assert_cmpuint (handles->len, ==, 1);
+  g_assert_true (g_array_index (handles, gpointer, 0) == target_function);
+
+  target_function (fixture->result);
+  g_assert_cmpstr (fixture->result->str, ==, "||");
+
+  gum_interceptor_detach (fixture->interceptor,
+      GUM_INVOCATION_LISTENER (listener));
+  target_function (fixture->result);
+  g_assert_cmpstr (fixture->result->str, ==, "|||");
+
+  g_array_free (handles, TRUE);
+  g_object_unref (listener);
+  g_object_unref (resolver);
+}
+
+#endif
+
 #ifdef HAVE_WINDOWS
 
 TESTCASE (attach_detach_torture)
@@ -354,6 +466,21 @@ TESTCASE (detach)
   g_assert_cmpstr (fixture->result->str, ==, "c|d");
 }
 
+TESTCASE (detach_all)
+{
+  interceptor_fixture_attach (fixture, 0, target_function, 'a', 'b');
+  interceptor_fixture_attach (fixture, 1, target_function, 'c', 'd');
+
+  target_function (fixture->result);
+  g_assert_cmpstr (fixture->result->str, ==, "ac|bd");
+
+  gum_interceptor_detach_all (fixture->interceptor);
+  g_string_truncate (fixture->result, 0);
+
+  target_function (fixture->result);
+  g_assert_cmpstr (fixture->result->str, ==, "|");
+}
+
 TESTCASE (listener_ref_count)
 {
   interceptor_fixture_attach (fixture, 0, target_function, 'a', 'b');
@@ -440,6 +567,52 @@ TESTCASE (function_data)
   g_object_unref (fd_listener);
 }
 
+static void
+dawdle_on_enter (gpointer user_data,
+                 GumInvocationContext * context)
+{
+  g_usleep (1000);
+}
+
+static void
+record_budget_overrun (gpointer function_address,
+                       GumInvocationListener * listener,
+                       guint average_cost_in_microseconds,
+                       gpointer user_data)
+{
+  guint * n_reports = user_data;
+
+  g_assert_cmpuint (average_cost_in_microseconds, >, 1);
+
+  (*n_reports)++;
+}
+
+TESTCASE (hook_budget_overrun_is_reported)
+{
+  TestCallbackListener * listener;
+  guint n_reports = 0;
+  guint i;
+
+  listener = test_callback_listener_new ();
+  listener->on_enter = dawdle_on_enter;
+
+  gum_interceptor_set_hook_budget (fixture->interceptor, 1,
+      record_budget_overrun, &n_reports);
+
+  gum_interceptor_attach (fixture->interceptor, target_function,
+      GUM_INVOCATION_LISTENER (listener), NULL);
+  for (i = 0; i != 32; i++)
+    target_function (fixture->result);
+  gum_interceptor_detach (fixture->interceptor,
+      GUM_INVOCATION_LISTENER (listener));
+
+  g_assert_cmpuint (n_reports, ==, 1);
+
+  gum_interceptor_set_hook_budget (fixture->interceptor, 0, NULL, NULL);
+
+  g_object_unref (listener);
+}
+
 #ifdef HAVE_I386
 
 TESTCASE (cpu_register_clobber)
@@ -674,6 +847,28 @@ TESTCASE (replace_then_attach)
   gum_interceptor_revert (fixture->interceptor, target_function);
 }
 
+TESTCASE (replace_then_retarget)
+{
+  g_assert_false (gum_interceptor_retarget (fixture->interceptor,
+      target_function, retargeted_target_function, NULL));
+
+  g_assert_cmpint (gum_interceptor_replace (fixture->interceptor,
+      target_function, replacement_target_function, NULL),
+      ==, GUM_REPLACE_OK);
+  target_function (fixture->result);
+  g_assert_cmpstr (fixture->result->str, ==, "/|\\");
+
+  g_assert_true (gum_interceptor_retarget (fixture->interceptor,
+      target_function, retargeted_target_function, NULL));
+  target_function (fixture->result);
+  g_assert_cmpstr (fixture->result->str, ==, "/|\\#|#");
+
+  gum_interceptor_revert (fixture->interceptor, target_function);
+
+  g_assert_false (gum_interceptor_retarget (fixture->interceptor,
+      target_function, replacement_target_function, NULL));
+}
+
 static gpointer
 replacement_target_function (GString * str)
 {
@@ -686,6 +881,18 @@ replacement_target_function (GString * str)
   return result;
 }
 
+static gpointer
+retargeted_target_function (GString * str)
+{
+  gpointer result;
+
+  g_string_append_c (str, '#');
+  result = target_function (str);
+  g_string_append_c (str, '#');
+
+  return result;
+}
+
 TESTCASE (i_can_has_replaceability)
 {
   UnsupportedFunction * unsupported_functions;
@@ -714,6 +921,49 @@ TESTCASE (already_replaced)
   gum_interceptor_revert (fixture->interceptor, target_function);
 }
 
+#if defined (HAVE_I386) || defined (HAVE_ARM64)
+
+TESTCASE (probe_one)
+{
+  g_assert_cmpint (gum_interceptor_attach_probe (fixture->interceptor,
+        target_function, probe_target_function, GSIZE_TO_POINTER ('P')), ==,
+      GUM_ATTACH_OK);
+  target_function (fixture->result);
+  g_assert_cmpstr (fixture->result->str, ==, "P|");
+
+  gum_interceptor_detach_probe (fixture->interceptor, target_function);
+  target_function (fixture->result);
+  g_assert_cmpstr (fixture->result->str, ==, "P||");
+}
+
+TESTCASE (already_probed)
+{
+  g_assert_cmpint (gum_interceptor_attach_probe (fixture->interceptor,
+        target_function, probe_target_function, GSIZE_TO_POINTER ('P')), ==,
+      GUM_ATTACH_OK);
+  g_assert_cmpint (gum_interceptor_attach_probe (fixture->interceptor,
+        target_function, probe_target_function, GSIZE_TO_POINTER ('P')), ==,
+      GUM_ATTACH_ALREADY_ATTACHED);
+  g_assert_cmpint (interceptor_fixture_try_attach (fixture, 0,
+        target_function, '>', '<'), ==, GUM_ATTACH_ALREADY_ATTACHED);
+  g_assert_cmpint (gum_interceptor_replace (fixture->interceptor,
+        target_function, malloc, NULL), ==, GUM_REPLACE_ALREADY_REPLACED);
+  gum_interceptor_detach_probe (fixture->interceptor, target_function);
+}
+
+static void
+probe_target_function (gpointer user_data,
+                       gpointer arg0,
+                       gpointer arg1,
+                       gpointer arg2)
+{
+  GString * str = (GString *) arg0;
+
+  g_string_append_c (str, (gchar) GPOINTER_TO_SIZE (user_data));
+}
+
+#endif
+
 #ifdef HAVE_QNX
 
 TESTCASE (intercept_malloc_and_create_thread)
@@ -8,6 +8,10 @@
 
 #include "gummemory-priv.h"
 
+#if defined (HAVE_LINUX)
+# include "backend-linux/gumlinux.h"
+#endif
+
 #define TESTCASE(NAME) \
     void test_memory_ ## NAME (void)
 #define TESTENTRY(NAME) \
@@ -25,10 +29,22 @@ TESTLIST_BEGIN (memory)
   TESTENTRY (scan_range_finds_three_exact_matches)
   TESTENTRY (scan_range_finds_three_wildcarded_matches)
   TESTENTRY (scan_range_finds_three_masked_matches)
+  TESTENTRY (scan_ranges_delivers_matches_in_range_order)
+  TESTENTRY (scan_set_finds_all_patterns_in_one_pass)
+  TESTENTRY (scan_session_steps_through_range_incrementally)
+  TESTENTRY (scan_snapshot_narrows_candidates_across_rescans)
+  TESTENTRY (memory_snapshot_preserves_point_in_time_view)
+#ifdef HAVE_LINUX
+  TESTENTRY (dirty_range_tracking_reports_written_pages)
+#endif
   TESTENTRY (is_memory_readable_handles_mixed_page_protections)
   TESTENTRY (alloc_n_pages_returns_aligned_rw_address)
   TESTENTRY (alloc_n_pages_near_returns_aligned_rw_address_within_range)
   TESTENTRY (mprotect_handles_page_boundaries)
+  TESTENTRY (mprotect_batch_merges_adjacent_ranges)
+  TESTENTRY (layout_listener_observes_allocations)
+  TESTENTRY (patch_code_batch_applies_grouped_writes)
+  TESTENTRY (clear_cache_batch_flushes_scheduled_ranges)
 TESTLIST_END ()
 
 typedef struct _TestForEachContext {
@@ -374,6 +390,280 @@ TESTCASE (scan_range_finds_three_masked_matches)
   gum_match_pattern_free (pattern);
 }
 
+TESTCASE (scan_ranges_delivers_matches_in_range_order)
+{
+  guint8 first_buf[] = {
+    0x13, 0x37,
+    0xc0,
+    0x13, 0x37
+  };
+  guint8 second_buf[] = {
+    0xfe, 0xed,
+    0x13, 0x37
+  };
+  GumMemoryRange ranges[2];
+  GumMatchPattern * pattern;
+  TestForEachContext ctx;
+
+  ranges[0].base_address = GUM_ADDRESS (first_buf);
+  ranges[0].size = sizeof (first_buf);
+  ranges[1].base_address = GUM_ADDRESS (second_buf);
+  ranges[1].size = sizeof (second_buf);
+
+  pattern = gum_match_pattern_new_from_string ("13 37");
+  g_assert_nonnull (pattern);
+
+  ctx.expected_address[0] = first_buf + 0;
+  ctx.expected_address[1] = first_buf + 2 + 1;
+  ctx.expected_address[2] = second_buf + 2;
+  ctx.expected_size = 2;
+
+  ctx.number_of_calls = 0;
+  ctx.value_to_return = TRUE;
+  gum_memory_scan_ranges (ranges, G_N_ELEMENTS (ranges), pattern,
+      match_found_cb, &ctx);
+  g_assert_cmpuint (ctx.number_of_calls, ==, 3);
+
+  ctx.number_of_calls = 0;
+  ctx.value_to_return = FALSE;
+  gum_memory_scan_ranges (ranges, G_N_ELEMENTS (ranges), pattern,
+      match_found_cb, &ctx);
+  g_assert_cmpuint (ctx.number_of_calls, ==, 1);
+
+  gum_match_pattern_free (pattern);
+}
+
+typedef struct _TestScanSetContext {
+  guint number_of_calls;
+  guint calls_per_pattern[2];
+} TestScanSetContext;
+
+static gboolean
+set_match_found_cb (guint pattern_index,
+                    GumAddress address,
+                    gsize size,
+                    gpointer user_data)
+{
+  TestScanSetContext * ctx = (TestScanSetContext *) user_data;
+
+  g_assert_cmpuint (pattern_index, <, 2);
+  ctx->number_of_calls++;
+  ctx->calls_per_pattern[pattern_index]++;
+
+  return TRUE;
+}
+
+TESTCASE (scan_set_finds_all_patterns_in_one_pass)
+{
+  guint8 buf[] = {
+    0x13, 0x37,
+    0xfe, 0xed, 0xfa, 0xce,
+    0x13, 0x37,
+    0xc0,
+    0xfe, 0xed, 0xfa, 0xce
+  };
+  GumMemoryRange range;
+  GumMatchPatternSet * set;
+  TestScanSetContext ctx = { 0, };
+
+  range.base_address = GUM_ADDRESS (buf);
+  range.size = sizeof (buf);
+
+  set = gum_match_pattern_set_new ();
+  g_assert_cmpuint (gum_match_pattern_set_add (set,
+      gum_match_pattern_new_from_string ("13 37")), ==, 0);
+  g_assert_cmpuint (gum_match_pattern_set_add (set,
+      gum_match_pattern_new_from_string ("fe ed fa ce")), ==, 1);
+
+  gum_memory_scan_set (&range, set, set_match_found_cb, &ctx);
+
+  g_assert_cmpuint (ctx.number_of_calls, ==, 4);
+  g_assert_cmpuint (ctx.calls_per_pattern[0], ==, 2);
+  g_assert_cmpuint (ctx.calls_per_pattern[1], ==, 2);
+
+  gum_match_pattern_set_free (set);
+}
+
+TESTCASE (scan_session_steps_through_range_incrementally)
+{
+  guint8 buf[] = {
+    0x13, 0x37,
+    0xc0,
+    0x13, 0x37,
+    0xc0, 0xc0,
+    0x13, 0x37
+  };
+  GumMemoryRange range;
+  GumMatchPattern * pattern;
+  TestForEachContext ctx;
+  GumMemoryScanSession * session;
+  guint number_of_steps = 0;
+
+  range.base_address = GUM_ADDRESS (buf);
+  range.size = sizeof (buf);
+
+  pattern = gum_match_pattern_new_from_string ("13 37");
+  g_assert_nonnull (pattern);
+
+  ctx.expected_address[0] = buf + 0;
+  ctx.expected_address[1] = buf + 3;
+  ctx.expected_address[2] = buf + 7;
+  ctx.expected_size = 2;
+  ctx.number_of_calls = 0;
+  ctx.value_to_return = TRUE;
+
+  session = gum_memory_scan_session_new (&range, pattern, match_found_cb,
+      &ctx);
+
+  while (gum_memory_scan_session_step (session, 3))
+    number_of_steps++;
+
+  g_assert_cmpuint (ctx.number_of_calls, ==, 3);
+  g_assert_cmpuint (number_of_steps, >, 0);
+  g_assert_cmpfloat (gum_memory_scan_session_get_progress (session), ==, 1.0);
+
+  gum_memory_scan_session_free (session);
+  gum_match_pattern_free (pattern);
+}
+
+TESTCASE (scan_snapshot_narrows_candidates_across_rescans)
+{
+  guint32 values[4] = { 100, 200, 300, 400 };
+  GumMemoryRange range;
+  GumScanSnapshot * snapshot;
+
+  range.base_address = GUM_ADDRESS (values);
+  range.size = sizeof (values);
+
+  snapshot = gum_scan_snapshot_capture (&range, NULL, sizeof (guint32));
+  g_assert_cmpuint (gum_scan_snapshot_get_size (snapshot), ==, 4);
+
+  values[1] = 250;
+  values[3] = 50;
+
+  g_assert_cmpuint (gum_scan_snapshot_rescan (snapshot, GUM_SCAN_CHANGED),
+      ==, 2);
+
+  values[1] = 275;
+
+  g_assert_cmpuint (gum_scan_snapshot_rescan (snapshot, GUM_SCAN_INCREASED),
+      ==, 1);
+
+  gum_scan_snapshot_free (snapshot);
+}
+
+TESTCASE (memory_snapshot_preserves_point_in_time_view)
+{
+  guint8 buf[64] = { 0, };
+  GumMemoryRange range;
+  GumMemorySnapshot * snapshot;
+  GumMatchPattern * pattern;
+  TestForEachContext ctx;
+  guint8 readback[4];
+
+  memcpy (buf + 16, "\x13\x37\x13\x37", 4);
+
+  range.base_address = GUM_ADDRESS (buf);
+  range.size = sizeof (buf);
+
+  snapshot = gum_memory_snapshot_capture (&range, 1);
+  g_assert_nonnull (snapshot);
+
+  memset (buf, 0, sizeof (buf));
+
+  g_assert_true (gum_memory_snapshot_read (snapshot,
+      range.base_address + 16, 4, readback));
+  g_assert_cmpint (memcmp (readback, "\x13\x37\x13\x37", 4), ==, 0);
+
+  g_assert_false (gum_memory_snapshot_read (snapshot,
+      range.base_address + sizeof (buf), 4, readback));
+
+  pattern = gum_match_pattern_new_from_string ("13 37 13 37");
+
+  ctx.expected_address[0] = buf + 16;
+  ctx.expected_size = 4;
+  ctx.number_of_calls = 0;
+  ctx.value_to_return = TRUE;
+  gum_memory_snapshot_scan (snapshot, &range, pattern, match_found_cb, &ctx);
+  g_assert_cmpuint (ctx.number_of_calls, ==, 1);
+
+  gum_match_pattern_free (pattern);
+  gum_memory_snapshot_free (snapshot);
+}
+
+#ifdef HAVE_LINUX
+
+typedef struct _TestDirtyRangesContext TestDirtyRangesContext;
+
+struct _TestDirtyRangesContext
+{
+  GumAddress dirty_page;
+  GumAddress clean_page;
+  gboolean found_dirty;
+  gboolean found_clean;
+};
+
+static gboolean
+dirty_range_found_cb (const GumMemoryRange * range,
+                      gpointer user_data)
+{
+  TestDirtyRangesContext * ctx = user_data;
+
+  if (ctx->dirty_page >= range->base_address &&
+      ctx->dirty_page < range->base_address + range->size)
+  {
+    ctx->found_dirty = TRUE;
+  }
+
+  if (ctx->clean_page >= range->base_address &&
+      ctx->clean_page < range->base_address + range->size)
+  {
+    ctx->found_clean = TRUE;
+  }
+
+  return TRUE;
+}
+
+TESTCASE (dirty_range_tracking_reports_written_pages)
+{
+  guint8 * pages;
+  guint page_size;
+  GumMemoryRange range;
+  TestDirtyRangesContext ctx;
+
+  if (!gum_linux_reset_dirty_tracking ())
+  {
+    g_print ("<skipping, soft-dirty tracking not available> ");
+    return;
+  }
+
+  pages = gum_alloc_n_pages (4, GUM_PAGE_RW);
+  page_size = gum_query_page_size ();
+
+  memset (pages, 0xaa, 4 * page_size);
+
+  g_assert_true (gum_linux_reset_dirty_tracking ());
+
+  pages[2 * page_size] = 0x2a;
+
+  range.base_address = GUM_ADDRESS (pages);
+  range.size = 4 * page_size;
+
+  ctx.dirty_page = GUM_ADDRESS (pages + (2 * page_size));
+  ctx.clean_page = GUM_ADDRESS (pages);
+  ctx.found_dirty = FALSE;
+  ctx.found_clean = FALSE;
+  g_assert_true (gum_linux_enumerate_dirty_ranges (&range, 1,
+      dirty_range_found_cb, &ctx));
+
+  g_assert_true (ctx.found_dirty);
+  g_assert_false (ctx.found_clean);
+
+  gum_free_pages (pages);
+}
+
+#endif
+
 TESTCASE (is_memory_readable_handles_mixed_page_protections)
 {
   guint8 * pages;
@@ -474,6 +764,124 @@ TESTCASE (mprotect_handles_page_boundaries)
   gum_free_pages (pages);
 }
 
+TESTCASE (mprotect_batch_merges_adjacent_ranges)
+{
+  guint8 * pages;
+  guint page_size;
+  GumMemoryRange ranges[3];
+
+  pages = gum_alloc_n_pages (4, GUM_PAGE_NO_ACCESS);
+  page_size = gum_query_page_size ();
+
+  ranges[0].base_address = GUM_ADDRESS (pages);
+  ranges[0].size = 1;
+  ranges[1].base_address = GUM_ADDRESS (pages + page_size);
+  ranges[1].size = page_size;
+  ranges[2].base_address = GUM_ADDRESS (pages + (3 * page_size));
+  ranges[2].size = page_size;
+
+  g_assert_true (gum_try_mprotect_batch (ranges, G_N_ELEMENTS (ranges),
+      GUM_PAGE_RW));
+
+  pages[0] = 0x13;
+  pages[page_size] = 0x37;
+  pages[3 * page_size] = 0x42;
+
+  g_assert_false (gum_memory_is_writable (pages + (2 * page_size), 1));
+
+  gum_free_pages (pages);
+}
+
+static void
+test_memory_on_layout_changed (guint generation,
+                               gpointer user_data)
+{
+  guint * n_notifications = user_data;
+
+  (*n_notifications)++;
+}
+
+TESTCASE (layout_listener_observes_allocations)
+{
+  guint n_notifications = 0;
+  guint listener_id, n_before;
+  gpointer page;
+
+  listener_id = _gum_memory_register_layout_listener (
+      test_memory_on_layout_changed, &n_notifications);
+
+  page = gum_alloc_n_pages (1, GUM_PAGE_RW);
+  g_assert_cmpuint (n_notifications, >, 0);
+  gum_free_pages (page);
+
+  n_before = n_notifications;
+  _gum_memory_unregister_layout_listener (listener_id);
+
+  page = gum_alloc_n_pages (1, GUM_PAGE_RW);
+  gum_free_pages (page);
+  g_assert_cmpuint (n_notifications, ==, n_before);
+}
+
+TESTCASE (patch_code_batch_applies_grouped_writes)
+{
+  guint8 * pages;
+  guint page_size;
+  const guint8 first[2] = { 0x13, 0x37 };
+  const guint8 second[2] = { 0xba, 0xad };
+  const guint8 third[2] = { 0xf0, 0x0d };
+  GumCodePatch patches[3];
+
+  pages = gum_alloc_n_pages (3, GUM_PAGE_RW);
+  page_size = gum_query_page_size ();
+
+  patches[0].address = pages + (2 * page_size) + 16;
+  patches[0].bytes = third;
+  patches[0].size = sizeof (third);
+  patches[1].address = pages + 4;
+  patches[1].bytes = first;
+  patches[1].size = sizeof (first);
+  patches[2].address = pages + 64;
+  patches[2].bytes = second;
+  patches[2].size = sizeof (second);
+
+  g_assert_true (gum_memory_patch_code_batch (patches, 3));
+
+  g_assert_cmphex (pages[4], ==, 0x13);
+  g_assert_cmphex (pages[5], ==, 0x37);
+  g_assert_cmphex (pages[64], ==, 0xba);
+  g_assert_cmphex (pages[65], ==, 0xad);
+  g_assert_cmphex (pages[(2 * page_size) + 16], ==, 0xf0);
+  g_assert_cmphex (pages[(2 * page_size) + 17], ==, 0x0d);
+  g_assert_cmphex (pages[66], ==, 0x00);
+
+  gum_free_pages (pages);
+}
+
+TESTCASE (clear_cache_batch_flushes_scheduled_ranges)
+{
+  guint8 * pages;
+  guint page_size;
+
+  pages = gum_alloc_n_pages (2, GUM_PAGE_RW);
+  page_size = gum_query_page_size ();
+
+  gum_clear_cache_schedule (pages, 4);
+
+  gum_clear_cache_begin_batch ();
+
+  gum_clear_cache_schedule (pages, 16);
+  gum_clear_cache_schedule (pages + 8, 16);
+  gum_clear_cache_schedule (pages + page_size, 16);
+
+  gum_clear_cache_begin_batch ();
+  gum_clear_cache_schedule (pages + 32, 16);
+  gum_clear_cache_commit_batch ();
+
+  gum_clear_cache_commit_batch ();
+
+  gum_free_pages (pages);
+}
+
 static gboolean
 match_found_cb (GumAddress address,
                 gsize size,
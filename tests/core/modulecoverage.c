@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2021 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#include "testutil.h"
+
+#define TESTCASE(NAME) \
+    void test_module_coverage_ ## NAME (void)
+#define TESTENTRY(NAME) \
+    TESTENTRY_SIMPLE ("Core/ModuleCoverage", test_module_coverage, NAME)
+
+TESTLIST_BEGIN (module_coverage)
+#ifdef HAVE_I386
+  TESTENTRY (own_module_can_be_instrumented)
+  TESTENTRY (hits_can_be_reset)
+#endif
+TESTLIST_END ()
+
+#ifdef HAVE_I386
+
+TESTCASE (own_module_can_be_instrumented)
+{
+  GumModuleCoverage * coverage;
+  guint count;
+
+  coverage = gum_module_coverage_new (GUM_TESTS_MODULE_NAME);
+  g_assert_nonnull (coverage);
+
+  count = gum_module_coverage_get_count (coverage);
+  g_assert_cmpuint (count, >, 0);
+  g_assert_cmpuint (gum_module_coverage_get_hit_count (coverage), <=, count);
+
+  g_object_unref (coverage);
+}
+
+TESTCASE (hits_can_be_reset)
+{
+  GumModuleCoverage * coverage;
+
+  coverage = gum_module_coverage_new (GUM_TESTS_MODULE_NAME);
+  g_assert_nonnull (coverage);
+
+  gum_module_coverage_reset (coverage);
+  g_assert_cmpuint (gum_module_coverage_get_hit_count (coverage), ==, 0);
+
+  g_object_unref (coverage);
+}
+
+#endif
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2020 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#include "gummoduleobserver.h"
+
+#include "interceptor-callbacklistener.h"
+#include "testutil.h"
+
+#define TESTCASE(NAME) \
+    void test_module_observer_ ## NAME ( \
+        TestModuleObserverFixture * fixture, gconstpointer data)
+#define TESTENTRY(NAME) \
+    TESTENTRY_WITH_FIXTURE ("Core/ModuleObserver", test_module_observer, \
+        NAME, TestModuleObserverFixture)
+
+typedef struct _TestModuleObserverFixture TestModuleObserverFixture;
+
+struct _TestModuleObserverFixture
+{
+  GumModuleObserver * observer;
+  TestCallbackListener * listener;
+};
+
+static void
+test_module_observer_fixture_setup (TestModuleObserverFixture * fixture,
+                                    gconstpointer data)
+{
+  fixture->observer = gum_module_observer_obtain ();
+  fixture->listener = test_callback_listener_new ();
+}
+
+static void
+test_module_observer_fixture_teardown (TestModuleObserverFixture * fixture,
+                                       gconstpointer data)
+{
+  g_object_unref (fixture->listener);
+  g_object_unref (fixture->observer);
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2020 Ole André Vadla Ravnås <oleavr@nowsecure.com>
+ *
+ * Licence: wxWindows Library Licence, Version 3.1
+ */
+
+#include "moduleobserver-fixture.c"
+
+TESTLIST_BEGIN (module_observer)
+  TESTENTRY (malformed_query_is_rejected)
+  TESTENTRY (hook_spec_ids_are_unique)
+TESTLIST_END ()
+
+TESTCASE (malformed_query_is_rejected)
+{
+  GError * error = NULL;
+  guint id;
+
+  id = gum_module_observer_add_hook_spec (fixture->observer, "oops",
+      GUM_INVOCATION_LISTENER (fixture->listener), NULL, &error);
+  g_assert_cmpuint (id, ==, 0);
+  g_assert_nonnull (error);
+  g_clear_error (&error);
+}
+
+TESTCASE (hook_spec_ids_are_unique)
+{
+  GError * error = NULL;
+  guint first, second;
+
+  first = gum_module_observer_add_hook_spec (fixture->observer,
+      "exports:gum-tests-nonexistent*!nope*",
+      GUM_INVOCATION_LISTENER (fixture->listener), NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (first, !=, 0);
+
+  second = gum_module_observer_add_hook_spec (fixture->observer,
+      "exports:gum-tests-nonexistent*!nada*",
+      GUM_INVOCATION_LISTENER (fixture->listener), NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpuint (second, !=, first);
+
+  gum_module_observer_remove_hook_spec (fixture->observer, second);
+  gum_module_observer_remove_hook_spec (fixture->observer, first);
+}
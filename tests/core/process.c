@@ -34,14 +34,17 @@
 TESTLIST_BEGIN (process)
   TESTENTRY (process_threads)
   TESTENTRY (process_threads_exclude_cloaked)
+  TESTENTRY (process_threads_batch_suspend)
   TESTENTRY (process_modules)
   TESTENTRY (process_ranges)
   TESTENTRY (process_ranges_exclude_cloaked)
+  TESTENTRY (process_ranges_reflect_layout_changes)
   TESTENTRY (thread_ranges_can_be_enumerated)
   TESTENTRY (module_can_be_loaded)
   TESTENTRY (module_imports)
   TESTENTRY (module_import_slot_should_contain_correct_value)
   TESTENTRY (module_exports)
+  TESTENTRY (module_export_table)
   TESTENTRY (module_symbols)
   TESTENTRY (module_ranges_can_be_enumerated)
   TESTENTRY (module_base)
@@ -68,6 +71,9 @@ TESTLIST_BEGIN (process)
 #if defined (HAVE_LINUX) && !defined (HAVE_ANDROID)
   TESTENTRY (linux_process_modules)
 #endif
+#ifdef HAVE_LINUX
+  TESTENTRY (linux_thread_enum_session)
+#endif
 #if defined (HAVE_LINUX) && defined (HAVE_SYS_AUXV_H)
   TESTENTRY (linux_get_cpu_from_auxv_null_32bit)
   TESTENTRY (linux_get_cpu_from_auxv_null_64bit)
@@ -197,6 +203,63 @@ TESTCASE (process_threads)
   g_thread_join (thread_a);
 }
 
+typedef struct _CounterThreadContext CounterThreadContext;
+
+struct _CounterThreadContext
+{
+  volatile gboolean started;
+  volatile gboolean done;
+  volatile guint count;
+  GumThreadId thread_id;
+};
+
+static gpointer
+counting_dummy (gpointer data)
+{
+  CounterThreadContext * ctx = data;
+
+  ctx->thread_id = gum_process_get_current_thread_id ();
+  ctx->started = TRUE;
+
+  while (!ctx->done)
+  {
+    ctx->count++;
+    g_thread_yield ();
+  }
+
+  return NULL;
+}
+
+TESTCASE (process_threads_batch_suspend)
+{
+  CounterThreadContext ctx = { FALSE, FALSE, 0, 0 };
+  GThread * thread;
+  GumThreadSuspension * suspension;
+  guint count_while_suspended;
+
+  if (!check_thread_enumeration_testable ())
+    return;
+
+  thread = g_thread_new ("process-test-counting-dummy", counting_dummy, &ctx);
+  while (!ctx.started)
+    g_thread_yield ();
+
+  suspension = gum_process_suspend_threads (&ctx.thread_id, 1);
+  g_assert_nonnull (suspension);
+
+  count_while_suspended = ctx.count;
+  g_usleep (G_USEC_PER_SEC / 20);
+  g_assert_cmpuint (ctx.count, ==, count_while_suspended);
+
+  gum_process_resume_threads (suspension);
+
+  while (ctx.count == count_while_suspended)
+    g_thread_yield ();
+
+  ctx.done = TRUE;
+  g_thread_join (thread);
+}
+
 TESTCASE (process_threads_exclude_cloaked)
 {
   volatile gboolean done = FALSE;
@@ -352,6 +415,53 @@ verify_module_bounds (const GumModuleDetails * details,
 
 #endif
 
+#ifdef HAVE_LINUX
+
+static void
+count_thread_changes (GumLinuxThreadEventType type,
+                      GumThreadId id,
+                      gpointer user_data)
+{
+  guint * num_changes = user_data;
+
+  (*num_changes)++;
+}
+
+TESTCASE (linux_thread_enum_session)
+{
+  GumLinuxThreadEnumSession * session;
+  guint num_changes, count, i;
+  const GumThreadId * ids;
+  gboolean found_self;
+
+  session = gum_linux_thread_enum_session_new ();
+
+  num_changes = 0;
+  gum_linux_thread_enum_session_refresh (session, count_thread_changes,
+      &num_changes);
+  g_assert_cmpuint (num_changes, >, 0);
+
+  count = gum_linux_thread_enum_session_get_threads (session, &ids);
+  g_assert_cmpuint (count, ==, num_changes);
+
+  found_self = FALSE;
+  for (i = 0; i != count; i++)
+  {
+    if (ids[i] == gum_process_get_current_thread_id ())
+      found_self = TRUE;
+  }
+  g_assert_true (found_self);
+
+  num_changes = 0;
+  gum_linux_thread_enum_session_refresh (session, count_thread_changes,
+      &num_changes);
+  g_assert_cmpuint (num_changes, ==, 0);
+
+  gum_linux_thread_enum_session_free (session);
+}
+
+#endif
+
 #if defined (HAVE_LINUX) && defined (HAVE_SYS_AUXV_H)
 
 TESTCASE (linux_get_cpu_from_auxv_null_32bit)
@@ -544,6 +654,34 @@ TESTCASE (process_ranges_exclude_cloaked)
   g_assert_false (ctx.found);
 }
 
+TESTCASE (process_ranges_reflect_layout_changes)
+{
+  TestForEachContext warmup_ctx;
+  TestRangeContext ctx;
+  guint8 * pages;
+
+  warmup_ctx.number_of_calls = 0;
+  warmup_ctx.value_to_return = TRUE;
+  gum_process_enumerate_ranges (GUM_PAGE_RW, range_found_cb, &warmup_ctx);
+  g_assert_cmpuint (warmup_ctx.number_of_calls, >, 1);
+
+  pages = gum_alloc_n_pages (1, GUM_PAGE_RW);
+
+  ctx.range.base_address = GUM_ADDRESS (pages);
+  ctx.range.size = gum_query_page_size ();
+  ctx.found = FALSE;
+  ctx.found_exact = FALSE;
+  gum_process_enumerate_ranges (GUM_PAGE_RW, range_check_cb, &ctx);
+  g_assert_true (ctx.found);
+
+  gum_free_pages (pages);
+
+  ctx.found = FALSE;
+  ctx.found_exact = FALSE;
+  gum_process_enumerate_ranges (GUM_PAGE_RW, range_check_cb, &ctx);
+  g_assert_false (ctx.found);
+}
+
 TESTCASE (thread_ranges_can_be_enumerated)
 {
   inspect_thread_ranges ();
@@ -733,6 +871,32 @@ TESTCASE (module_exports)
   g_assert_cmpuint (ctx.number_of_calls, ==, 1);
 }
 
+TESTCASE (module_export_table)
+{
+  GumExportTable * table;
+  guint i;
+  const GumExportTableEntry * entry;
+  const gchar * name;
+
+  table = gum_module_collect_exports (SYSTEM_MODULE_NAME);
+  g_assert_cmpuint (table->n_entries, >, 1);
+
+  for (i = 1; i != table->n_entries; i++)
+  {
+    g_assert_cmpint (strcmp (
+        gum_export_table_entry_get_name (table, &table->entries[i - 1]),
+        gum_export_table_entry_get_name (table, &table->entries[i])), <=, 0);
+  }
+
+  entry = &table->entries[table->n_entries / 2];
+  name = gum_export_table_entry_get_name (table, entry);
+
+  g_assert_true (gum_export_table_find (table, name) != NULL);
+  g_assert_null (gum_export_table_find (table, "gum_does_not_exist"));
+
+  gum_export_table_free (table);
+}
+
 TESTCASE (module_symbols)
 {
 #if defined (HAVE_DARWIN) || defined (HAVE_LINUX)
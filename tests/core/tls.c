@@ -23,11 +23,25 @@
 TESTLIST_BEGIN (tls)
   TESTENTRY (get_should_work_like_the_system_implementation)
   TESTENTRY (set_should_work_like_the_system_implementation)
+  TESTENTRY (values_should_be_thread_local)
 TESTLIST_END ()
 
+/*
+ * The first few keys may be served from compiler-TLS slots instead of the
+ * system mechanism, so burn through those to get a system-backed key.
+ */
+#define TEST_TLS_NUM_WARMUP_KEYS 8
+
+static gpointer check_value_in_other_thread (gpointer data);
+
 TESTCASE (get_should_work_like_the_system_implementation)
 {
+  GumTlsKey warmup_keys[TEST_TLS_NUM_WARMUP_KEYS];
   GumTlsKey key;
+  guint i;
+
+  for (i = 0; i != TEST_TLS_NUM_WARMUP_KEYS; i++)
+    warmup_keys[i] = gum_tls_key_new ();
 
   key = gum_tls_key_new ();
 
@@ -40,11 +54,19 @@ TESTCASE (get_should_work_like_the_system_implementation)
       ==, 0x11223344);
 
   gum_tls_key_free (key);
+
+  for (i = 0; i != TEST_TLS_NUM_WARMUP_KEYS; i++)
+    gum_tls_key_free (warmup_keys[i]);
 }
 
 TESTCASE (set_should_work_like_the_system_implementation)
 {
+  GumTlsKey warmup_keys[TEST_TLS_NUM_WARMUP_KEYS];
   GumTlsKey key;
+  guint i;
+
+  for (i = 0; i != TEST_TLS_NUM_WARMUP_KEYS; i++)
+    warmup_keys[i] = gum_tls_key_new ();
 
   key = gum_tls_key_new ();
 
@@ -57,4 +79,40 @@ TESTCASE (set_should_work_like_the_system_implementation)
 #endif
 
   gum_tls_key_free (key);
+
+  for (i = 0; i != TEST_TLS_NUM_WARMUP_KEYS; i++)
+    gum_tls_key_free (warmup_keys[i]);
+}
+
+TESTCASE (values_should_be_thread_local)
+{
+  GumTlsKey key;
+  GThread * thread;
+
+  key = gum_tls_key_new ();
+
+  gum_tls_key_set_value (key, GSIZE_TO_POINTER (0x11223344));
+
+  thread = g_thread_new ("tls-test-worker", check_value_in_other_thread,
+      GSIZE_TO_POINTER (key));
+  g_thread_join (thread);
+
+  g_assert_cmphex (GPOINTER_TO_SIZE (gum_tls_key_get_value (key)),
+      ==, 0x11223344);
+
+  gum_tls_key_free (key);
+}
+
+static gpointer
+check_value_in_other_thread (gpointer data)
+{
+  GumTlsKey key = GPOINTER_TO_SIZE (data);
+
+  g_assert_null (gum_tls_key_get_value (key));
+
+  gum_tls_key_set_value (key, GSIZE_TO_POINTER (0x55667788));
+  g_assert_cmphex (GPOINTER_TO_SIZE (gum_tls_key_get_value (key)),
+      ==, 0x55667788);
+
+  return NULL;
 }
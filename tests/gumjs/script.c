@@ -49,6 +49,7 @@ TESTLIST_BEGIN (script)
 
   TESTGROUP_BEGIN ("Interceptor")
     TESTENTRY (argument_can_be_read)
+    TESTENTRY (arguments_can_be_prefetched)
     TESTENTRY (argument_can_be_replaced)
     TESTENTRY (return_value_can_be_read)
     TESTENTRY (return_value_can_be_replaced)
@@ -83,6 +84,12 @@ TESTLIST_BEGIN (script)
     TESTENTRY (interceptor_on_leave_performance)
     TESTENTRY (interceptor_on_enter_and_leave_performance)
   TESTGROUP_END ()
+  TESTGROUP_BEGIN ("Benchmark")
+    TESTENTRY (hook_dispatch_benchmark)
+    TESTENTRY (native_function_call_benchmark)
+    TESTENTRY (memory_read_write_benchmark)
+    TESTENTRY (send_throughput_benchmark)
+  TESTGROUP_END ()
 
   TESTGROUP_BEGIN ("Memory")
     TESTENTRY (pointer_can_be_read)
@@ -93,6 +100,7 @@ TESTLIST_BEGIN (script)
     TESTENTRY (memory_can_be_copied)
     TESTENTRY (memory_can_be_duped)
     TESTENTRY (memory_can_be_protected)
+    TESTENTRY (memory_ranges_can_be_protected_in_bulk)
     TESTENTRY (code_can_be_patched)
     TESTENTRY (s8_can_be_read)
     TESTENTRY (s8_can_be_written)
@@ -150,6 +158,7 @@ TESTLIST_BEGIN (script)
     TESTENTRY (memory_can_be_scanned_synchronously)
     TESTENTRY (memory_scan_should_be_interruptible)
     TESTENTRY (memory_scan_handles_unreadable_memory)
+    TESTENTRY (memory_can_be_scanned_for_strings)
     TESTENTRY (memory_access_can_be_monitored)
     TESTENTRY (memory_access_can_be_monitored_one_range)
   TESTGROUP_END ()
@@ -224,12 +233,14 @@ TESTLIST_BEGIN (script)
 #ifdef G_OS_UNIX
     TESTENTRY (unix_fd_can_be_read_from)
     TESTENTRY (unix_fd_can_be_written_to)
+    TESTENTRY (unix_fd_can_be_pumped_to_another_fd)
 #endif
   TESTGROUP_END ()
 
   TESTGROUP_BEGIN ("Hexdump")
     TESTENTRY (basic_hexdump_functionality_is_available)
     TESTENTRY (hexdump_supports_native_pointer_conforming_object)
+    TESTENTRY (hexdump_native_path_matches_js_path)
   TESTGROUP_END ()
 
   TESTGROUP_BEGIN ("NativePointer")
@@ -320,12 +331,23 @@ TESTLIST_BEGIN (script)
 
   TESTGROUP_BEGIN ("Instruction")
     TESTENTRY (instruction_can_be_parsed)
+    TESTENTRY (instruction_block_can_be_parsed)
     TESTENTRY (instruction_can_be_generated)
     TESTENTRY (instruction_can_be_relocated)
   TESTGROUP_END ()
 
   TESTGROUP_BEGIN ("File")
     TESTENTRY (file_can_be_written_to)
+    TESTENTRY (file_can_be_read_into_buffer)
+    TESTENTRY (ring_file_can_be_written_to)
+    TESTENTRY (ring_file_wraps_when_full)
+    TESTENTRY (ring_file_recovers_after_partial_write)
+  TESTGROUP_END ()
+
+  TESTGROUP_BEGIN ("Worker")
+    TESTENTRY (worker_messages_can_be_round_tripped)
+    TESTENTRY (worker_can_be_terminated)
+    TESTENTRY (script_can_be_unloaded_while_worker_is_running)
   TESTGROUP_END ()
 
   TESTGROUP_BEGIN ("Database")
@@ -347,6 +369,7 @@ TESTLIST_BEGIN (script)
     TESTENTRY (call_can_be_probed)
 #endif
     TESTENTRY (stalker_events_can_be_parsed)
+    TESTENTRY (stalker_events_can_be_parsed_into_columns)
   TESTGROUP_END ()
 
   TESTENTRY (script_can_be_compiled_to_bytecode)
@@ -444,6 +467,11 @@ static void measure_target_function_int_overhead (void);
 static int compare_measurements (gconstpointer element_a,
     gconstpointer element_b);
 
+static void test_script_fixture_print_benchmark_result (
+    TestScriptFixture * fixture, const gchar * name, guint n_ops);
+static void print_benchmark_result (const gchar * name, guint n_ops,
+    gdouble elapsed);
+
 static gboolean check_exception_handling_testable (void);
 
 static void on_script_message (GumScript * script, const gchar * message,
@@ -751,6 +779,33 @@ TESTCASE (instruction_can_be_parsed)
 #endif
 }
 
+TESTCASE (instruction_block_can_be_parsed)
+{
+  COMPILE_AND_LOAD_SCRIPT (
+      "const block = Instruction.parseBlock(" GUM_PTR_CONST ", 4);"
+      "send(block.count > 0);"
+      "send(block.address.length === block.count);"
+      "send(block.size.length === block.count);"
+      "send(block.mnemonic.length === block.count);"
+      "send(block.opStr.length === block.count);"
+      "const first = Instruction.parse(" GUM_PTR_CONST ");"
+      "send(block.address[0].equals(first.address));"
+      "send(block.size[0] === first.size);"
+      "send(block.mnemonic[0] === first.mnemonic);"
+      "send(block.opStr[0] === first.opStr);",
+      target_function_int, target_function_int);
+  EXPECT_SEND_MESSAGE_WITH ("true");
+  EXPECT_SEND_MESSAGE_WITH ("true");
+  EXPECT_SEND_MESSAGE_WITH ("true");
+  EXPECT_SEND_MESSAGE_WITH ("true");
+  EXPECT_SEND_MESSAGE_WITH ("true");
+  EXPECT_SEND_MESSAGE_WITH ("true");
+  EXPECT_SEND_MESSAGE_WITH ("true");
+  EXPECT_SEND_MESSAGE_WITH ("true");
+  EXPECT_SEND_MESSAGE_WITH ("true");
+  EXPECT_NO_MESSAGES ();
+}
+
 TESTCASE (instruction_can_be_generated)
 {
 #if defined (HAVE_I386)
@@ -1853,6 +1908,45 @@ TESTCASE (unix_fd_can_be_written_to)
   signal (SIGPIPE, original_sigpipe_handler);
 }
 
+TESTCASE (unix_fd_can_be_pumped_to_another_fd)
+{
+  gint input_fds[2], output_fds[2];
+  const guint8 message[7] = { 0x13, 0x37, 0xca, 0xfe, 0xba, 0xbe, 0xff };
+  guint8 buffer[8];
+  gssize res;
+
+  g_assert_cmpint (socketpair (AF_UNIX, SOCK_STREAM, 0, input_fds), ==, 0);
+  g_assert_cmpint (socketpair (AF_UNIX, SOCK_STREAM, 0, output_fds), ==, 0);
+
+  res = GUM_TEMP_FAILURE_RETRY (write (input_fds[1], message,
+      sizeof (message)));
+  g_assert_cmpint (res, ==, sizeof (message));
+  close (input_fds[1]);
+
+  COMPILE_AND_LOAD_SCRIPT (
+      "async function run() {"
+      "  try {"
+      "    const input = new UnixInputStream(%d, { autoClose: false });"
+      "    const output = new UnixOutputStream(%d, { autoClose: false });"
+      "    const size = await input.pump(output);"
+      "    send(size);"
+      "  } catch (e) {"
+      "    send(`oops: ${e.stack}`);"
+      "  }"
+      "}"
+      "run();",
+      input_fds[0], output_fds[0]);
+  EXPECT_SEND_MESSAGE_WITH ("7");
+  EXPECT_NO_MESSAGES ();
+  g_assert_cmpint (read (output_fds[1], buffer, sizeof (buffer)), ==, 7);
+  g_assert_cmphex (buffer[0], ==, 0x13);
+  g_assert_cmphex (buffer[6], ==, 0xff);
+
+  close (input_fds[0]);
+  close (output_fds[0]);
+  close (output_fds[1]);
+}
+
 #endif
 
 TESTCASE (basic_hexdump_functionality_is_available)
@@ -1895,6 +1989,25 @@ TESTCASE (hexdump_supports_native_pointer_conforming_object)
           "Hello hex world!\"");
 }
 
+TESTCASE (hexdump_native_path_matches_js_path)
+{
+  guint8 bytes[256];
+  guint i;
+
+  for (i = 0; i != sizeof (bytes); i++)
+    bytes[i] = i;
+
+  COMPILE_AND_LOAD_SCRIPT (
+      "const p = " GUM_PTR_CONST ";"
+      "send(hexdump(p) === hexdump(p.readByteArray(256), { address: p }));"
+      "send(hexdump(p, { length: 64, header: false, ansi: true }) === "
+          "hexdump(p.readByteArray(64),"
+              "{ address: p, header: false, ansi: true }));",
+      bytes);
+  EXPECT_SEND_MESSAGE_WITH ("true");
+  EXPECT_SEND_MESSAGE_WITH ("true");
+}
+
 TESTCASE (native_pointer_provides_is_null)
 {
   COMPILE_AND_LOAD_SCRIPT (
@@ -2293,6 +2406,194 @@ TESTCASE (file_can_be_written_to)
   EXPECT_NO_MESSAGES ();
 }
 
+TESTCASE (file_can_be_read_into_buffer)
+{
+  if (!g_test_slow ())
+  {
+    g_print ("<skipping, run in slow mode> ");
+    return;
+  }
+
+  COMPILE_AND_LOAD_SCRIPT (
+      "const path = \"/tmp/script-readinto-test.bin\";"
+      "const out = new File(path, 'wb');"
+      "out.write(\"yo yo\");"
+      "out.close();"
+      "const f = new File(path, 'rb');"
+      "const buf = new ArrayBuffer(16);"
+      "const n = f.readInto(buf);"
+      "f.close();"
+      "send([n, String.fromCharCode.apply(null,"
+          "new Uint8Array(buf, 0, n))]);");
+  EXPECT_SEND_MESSAGE_WITH ("[5,\"yo yo\"]");
+}
+
+TESTCASE (ring_file_can_be_written_to)
+{
+  if (!g_test_slow ())
+  {
+    g_print ("<skipping, run in slow mode> ");
+    return;
+  }
+
+  COMPILE_AND_LOAD_SCRIPT (
+      "const path = \"/tmp/script-ringfile-test.ring\";"
+      "new File(path, 'wb').close();"
+      "const ring = new RingFile(path, 16);"
+      "send([ring.capacity, ring.position]);"
+      "ring.write('abc');"
+      "ring.write('defgh');"
+      "send(ring.position);"
+      "ring.flush();"
+      "ring.close();"
+      "const f = new File(path, 'rb');"
+      "const buf = new ArrayBuffer(128);"
+      "const n = f.readInto(buf);"
+      "f.close();"
+      "send([n,"
+          "String.fromCharCode.apply(null, new Uint8Array(buf, 0, 4)),"
+          "String.fromCharCode.apply(null, new Uint8Array(buf, 64, 8))]);");
+  EXPECT_SEND_MESSAGE_WITH ("[16,0]");
+  EXPECT_SEND_MESSAGE_WITH ("8");
+  EXPECT_SEND_MESSAGE_WITH ("[80,\"GNRG\",\"abcdefgh\"]");
+}
+
+TESTCASE (ring_file_wraps_when_full)
+{
+  if (!g_test_slow ())
+  {
+    g_print ("<skipping, run in slow mode> ");
+    return;
+  }
+
+  COMPILE_AND_LOAD_SCRIPT (
+      "const path = \"/tmp/script-ringfile-wrap.ring\";"
+      "new File(path, 'wb').close();"
+      "const ring = new RingFile(path, 8);"
+      "ring.write('0123456');"
+      "ring.write('abcd');"
+      "send(ring.position);"
+      "try {"
+          "ring.write('123456789');"
+      "} catch (e) {"
+          "send(e.message);"
+      "}"
+      "ring.close();"
+      "const f = new File(path, 'rb');"
+      "const buf = new ArrayBuffer(128);"
+      "const n = f.readInto(buf);"
+      "f.close();"
+      "send([n, String.fromCharCode.apply(null,"
+          "new Uint8Array(buf, 64, 8))]);");
+  EXPECT_SEND_MESSAGE_WITH ("11");
+  EXPECT_SEND_MESSAGE_WITH ("\"record is larger than the ring\"");
+  EXPECT_SEND_MESSAGE_WITH ("[72,\"bcd3456a\"]");
+}
+
+TESTCASE (ring_file_recovers_after_partial_write)
+{
+  if (!g_test_slow ())
+  {
+    g_print ("<skipping, run in slow mode> ");
+    return;
+  }
+
+  COMPILE_AND_LOAD_SCRIPT (
+      "const path = \"/tmp/script-ringfile-reopen.ring\";"
+      "new File(path, 'wb').close();"
+      "let ring = new RingFile(path, 8);"
+      "ring.write('abcd');"
+      "ring.close();"
+
+      /*
+       * Simulate a crash mid-write: scribble on the data region past the
+       * published cursor, as a torn record would have before its cursor
+       * update.
+       */
+      "let f = new File(path, 'rb');"
+      "const buf = new ArrayBuffer(128);"
+      "const n = f.readInto(buf);"
+      "f.close();"
+      "const bytes = new Uint8Array(buf, 0, n);"
+      "bytes[68] = 0x58;"
+      "bytes[69] = 0x58;"
+      "f = new File(path, 'wb');"
+      "f.write(buf.slice(0, n));"
+      "f.close();"
+
+      "ring = new RingFile(path, 32);"
+      "send([ring.capacity, ring.position]);"
+      "ring.write('ef');"
+      "send(ring.position);"
+      "ring.close();"
+      "f = new File(path, 'rb');"
+      "const buf2 = new ArrayBuffer(128);"
+      "f.readInto(buf2);"
+      "f.close();"
+      "send(String.fromCharCode.apply(null, new Uint8Array(buf2, 64, 6)));");
+  EXPECT_SEND_MESSAGE_WITH ("[8,4]");
+  EXPECT_SEND_MESSAGE_WITH ("6");
+  EXPECT_SEND_MESSAGE_WITH ("\"abcdef\"");
+}
+
+TESTCASE (worker_messages_can_be_round_tripped)
+{
+  if (!GUM_QUICK_IS_SCRIPT_BACKEND (fixture->backend))
+  {
+    g_print ("<skipping, not yet supported by the V8 runtime> ");
+    return;
+  }
+
+  COMPILE_AND_LOAD_SCRIPT (
+      "const w = new Worker("
+          "\"onMessage = m => { postMessage('pong:' + m); };\","
+          "m => { send(m); });"
+      "w.postMessage('hi');");
+  EXPECT_SEND_MESSAGE_WITH ("\"pong:hi\"");
+}
+
+TESTCASE (worker_can_be_terminated)
+{
+  if (!GUM_QUICK_IS_SCRIPT_BACKEND (fixture->backend))
+  {
+    g_print ("<skipping, not yet supported by the V8 runtime> ");
+    return;
+  }
+
+  COMPILE_AND_LOAD_SCRIPT (
+      "const w = new Worker("
+          "\"onMessage = m => { postMessage('reply:' + m); };\","
+          "m => {"
+            "send(m);"
+            "if (m === 'reply:first') {"
+              "w.terminate();"
+              "w.postMessage('second');"
+              "setTimeout(() => { send('done'); }, 100);"
+            "}"
+          "});"
+      "w.postMessage('first');");
+  EXPECT_SEND_MESSAGE_WITH ("\"reply:first\"");
+  EXPECT_SEND_MESSAGE_WITH ("\"done\"");
+  EXPECT_NO_MESSAGES ();
+}
+
+TESTCASE (script_can_be_unloaded_while_worker_is_running)
+{
+  if (!GUM_QUICK_IS_SCRIPT_BACKEND (fixture->backend))
+  {
+    g_print ("<skipping, not yet supported by the V8 runtime> ");
+    return;
+  }
+
+  COMPILE_AND_LOAD_SCRIPT (
+      "const w = new Worker(\"let x = 1;\", m => {});"
+      "send('spawned');");
+  EXPECT_SEND_MESSAGE_WITH ("\"spawned\"");
+
+  UNLOAD_SCRIPT ();
+  EXPECT_NO_MESSAGES ();
+}
+
 TESTCASE (inline_sqlite_database_can_be_queried)
 {
   COMPILE_AND_LOAD_SCRIPT (
@@ -3291,6 +3592,35 @@ TESTCASE (stalker_events_can_be_parsed)
   EXPECT_ERROR_MESSAGE_WITH (ANY_LINE_NUMBER, "Error: invalid event type");
 }
 
+TESTCASE (stalker_events_can_be_parsed_into_columns)
+{
+  GumEvent ev;
+
+  ev.type = GUM_CALL;
+  ev.call.location = GSIZE_TO_POINTER (7);
+  ev.call.target = GSIZE_TO_POINTER (12);
+  ev.call.depth = 42;
+  COMPILE_AND_LOAD_SCRIPT (
+      "const columns = Stalker.parseColumns(" GUM_PTR_CONST ".readByteArray("
+      "%" G_GSIZE_FORMAT "));"
+      "send(["
+          "columns.length,"
+          "columns.type instanceof Uint32Array,"
+          "columns.location instanceof Float64Array,"
+          "columns.target instanceof Float64Array,"
+          "columns.depth instanceof Int32Array,"
+          "columns.type[0],"
+          "columns.location[0],"
+          "columns.target[0],"
+          "columns.depth[0]"
+      "]);", &ev, sizeof (ev));
+  EXPECT_SEND_MESSAGE_WITH ("[1,true,true,true,true,1,7,12,42]");
+
+  COMPILE_AND_LOAD_SCRIPT (
+      "send(Stalker.parseColumns(new ArrayBuffer(1)));");
+  EXPECT_ERROR_MESSAGE_WITH (ANY_LINE_NUMBER, "Error: invalid buffer shape");
+}
+
 TESTCASE (frida_version_is_available)
 {
   COMPILE_AND_LOAD_SCRIPT ("send(typeof Frida.version);");
@@ -4831,6 +5161,27 @@ TESTCASE (argument_can_be_read)
   EXPECT_SEND_MESSAGE_WITH ("-42");
 }
 
+TESTCASE (arguments_can_be_prefetched)
+{
+  COMPILE_AND_LOAD_SCRIPT (
+      "Interceptor.attach(" GUM_PTR_CONST ", {"
+      "  argCount: 1,"
+      "  onEnter(args) {"
+      "    send(Array.isArray(args));"
+      "    send(args.length);"
+      "    send(args[0].toInt32());"
+      "  }"
+      "});", target_function_int);
+
+  EXPECT_NO_MESSAGES ();
+
+  target_function_int (42);
+  EXPECT_SEND_MESSAGE_WITH ("true");
+  EXPECT_SEND_MESSAGE_WITH ("1");
+  EXPECT_SEND_MESSAGE_WITH ("42");
+  EXPECT_NO_MESSAGES ();
+}
+
 TESTCASE (argument_can_be_replaced)
 {
   COMPILE_AND_LOAD_SCRIPT (
@@ -5520,6 +5871,148 @@ TESTCASE (interceptor_on_enter_and_leave_performance)
 #endif
 }
 
+/*
+ * The Benchmark group measures throughput of the hottest binding
+ * operations on whichever runtime the suite was instantiated with, so
+ * running in slow mode and comparing the #QJS and #V8 lines side by side
+ * shows where the runtimes diverge. Script-side loops report their own
+ * elapsed time through a tagged send() so the numbers exclude compilation
+ * and message-delivery overhead.
+ */
+
+#define BENCHMARK_SCRIPT_PRELUDE \
+    "function benchmark(n, f) {" \
+    "  f(Math.max((n / 10) | 0, 1));" \
+    "  const started = Date.now();" \
+    "  f(n);" \
+    "  send(['elapsed', Date.now() - started]);" \
+    "}"
+
+#define SKIP_BENCHMARK_UNLESS_SLOW() \
+    if (!g_test_slow ()) \
+    { \
+      g_print ("<skipping, run in slow mode> "); \
+      return; \
+    }
+
+TESTCASE (hook_dispatch_benchmark)
+{
+  guint n = 100000, i;
+  GTimer * timer;
+
+  SKIP_BENCHMARK_UNLESS_SLOW ();
+
+  COMPILE_AND_LOAD_SCRIPT (
+      "Interceptor.attach(" GUM_PTR_CONST ", {"
+      "  onEnter(args) {"
+      "  },"
+      "  onLeave(retval) {"
+      "  }"
+      "});", target_function_int);
+
+  for (i = 0; i != n / 10; i++)
+    target_function_int (7);
+
+  timer = g_timer_new ();
+
+  for (i = 0; i != n; i++)
+    target_function_int (7);
+
+  print_benchmark_result ("hook-dispatch", n, g_timer_elapsed (timer, NULL));
+
+  g_timer_destroy (timer);
+}
+
+TESTCASE (native_function_call_benchmark)
+{
+  guint n = 100000;
+
+  SKIP_BENCHMARK_UNLESS_SLOW ();
+
+  COMPILE_AND_LOAD_SCRIPT (
+      BENCHMARK_SCRIPT_PRELUDE
+      "const f = new NativeFunction(" GUM_PTR_CONST ", 'int', ['int']);"
+      "benchmark(%u, n => {"
+      "  for (let i = 0; i !== n; i++)"
+      "    f(7);"
+      "});",
+      target_function_int, n);
+
+  test_script_fixture_print_benchmark_result (fixture, "native-function-call",
+      n);
+}
+
+TESTCASE (memory_read_write_benchmark)
+{
+  guint n = 100000;
+
+  SKIP_BENCHMARK_UNLESS_SLOW ();
+
+  COMPILE_AND_LOAD_SCRIPT (
+      BENCHMARK_SCRIPT_PRELUDE
+      "const p = Memory.alloc(8);"
+      "benchmark(%u, n => {"
+      "  for (let i = 0; i !== n; i++)"
+      "    p.writeU32(p.readU32() + 1);"
+      "});",
+      n);
+
+  test_script_fixture_print_benchmark_result (fixture, "memory-read-write",
+      n);
+}
+
+TESTCASE (send_throughput_benchmark)
+{
+  guint n = 10000;
+
+  SKIP_BENCHMARK_UNLESS_SLOW ();
+
+  COMPILE_AND_LOAD_SCRIPT (
+      BENCHMARK_SCRIPT_PRELUDE
+      "benchmark(%u, n => {"
+      "  for (let i = 0; i !== n; i++)"
+      "    send(i);"
+      "});",
+      n);
+
+  test_script_fixture_print_benchmark_result (fixture, "send-throughput", n);
+}
+
+static void
+test_script_fixture_print_benchmark_result (TestScriptFixture * fixture,
+                                            const gchar * name,
+                                            guint n_ops)
+{
+  gdouble elapsed_ms = 0.0;
+  gboolean found = FALSE;
+
+  test_script_fixture_push_timeout (fixture, 30000);
+
+  while (!found)
+  {
+    TestScriptMessageItem * item;
+
+    item = test_script_fixture_pop_message (fixture);
+    found = sscanf (item->message,
+        "{\"type\":\"send\",\"payload\":[\"elapsed\",%lf]}", &elapsed_ms) == 1;
+    test_script_message_item_free (item);
+  }
+
+  test_script_fixture_pop_timeout (fixture);
+
+  print_benchmark_result (name, n_ops, elapsed_ms / 1000.0);
+}
+
+static void
+print_benchmark_result (const gchar * name,
+                        guint n_ops,
+                        gdouble elapsed)
+{
+  g_print ("<%s: %u ops in %.1f ms, %.0f ops/s> ",
+      name, n_ops, elapsed * 1000.0,
+      (elapsed > 0.0) ? (gdouble) n_ops / elapsed : 0.0);
+}
+
 static void
 measure_target_function_int_overhead (void)
 {
@@ -5682,6 +6175,38 @@ TESTCASE (memory_scan_handles_unreadable_memory)
   EXPECT_SEND_MESSAGE_WITH ("\"access violation accessing 0x530\"");
 }
 
+TESTCASE (memory_can_be_scanned_for_strings)
+{
+  guint8 data[34];
+  const gchar wide[] = "wide str";
+  guint i;
+
+  data[0] = 0xff;
+  memcpy (data + 1, "interesting", 11);
+  data[12] = 0x02;
+  for (i = 0; i != 8; i++)
+  {
+    data[13 + (i * 2)] = wide[i];
+    data[14 + (i * 2)] = 0x00;
+  }
+  data[29] = 0x03;
+  memcpy (data + 30, "abc", 3);
+  data[33] = 0x00;
+
+  COMPILE_AND_LOAD_SCRIPT (
+      "const p = " GUM_PTR_CONST ";"
+      "const matches = Memory.scanStrings(p, 34);"
+      "send(matches.map(m => "
+          "[m.encoding, m.content, m.address.sub(p).toInt32(), m.size]));"
+      "send(Memory.scanStrings(p, 34, 3).map(m => m.content));"
+      "send(Memory.scanStrings(p, 34, 12).length);",
+      data);
+  EXPECT_SEND_MESSAGE_WITH ("[[\"utf8\",\"interesting\",1,11],"
+      "[\"utf16\",\"wide str\",13,16]]");
+  EXPECT_SEND_MESSAGE_WITH ("[\"interesting\",\"abc\",\"wide str\"]");
+  EXPECT_SEND_MESSAGE_WITH ("0");
+}
+
 TESTCASE (memory_access_can_be_monitored)
 {
   volatile guint8 * a, * b;
@@ -5912,6 +6437,43 @@ TESTCASE (memory_can_be_protected)
   gum_free_pages (buf);
 }
 
+TESTCASE (memory_ranges_can_be_protected_in_bulk)
+{
+  guint8 * buf;
+  gsize page_size;
+  gboolean exception_on_read, exception_on_write;
+
+  page_size = gum_query_page_size ();
+  buf = gum_alloc_n_pages (2, GUM_PAGE_RW);
+
+  COMPILE_AND_LOAD_SCRIPT (
+      "send(Memory.protectRanges(["
+          "{ base: " GUM_PTR_CONST ", size: Process.pageSize },"
+          "{ base: " GUM_PTR_CONST ", size: Process.pageSize }"
+      "], 'r--'));",
+      buf, buf + page_size);
+  EXPECT_SEND_MESSAGE_WITH ("true");
+
+  if (gum_process_is_debugger_attached ())
+  {
+    g_print ("<only partially tested, debugger is attached> ");
+
+    gum_free_pages (buf);
+
+    return;
+  }
+
+  /* avoid overlapping signal handlers */
+  UNLOAD_SCRIPT ();
+
+  gum_try_read_and_write_at (buf, page_size, &exception_on_read,
+      &exception_on_write);
+  g_assert_false (exception_on_read);
+  g_assert_true (exception_on_write);
+
+  gum_free_pages (buf);
+}
+
 TESTCASE (code_can_be_patched)
 {
   guint8 * code;
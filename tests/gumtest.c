@@ -177,6 +177,7 @@ main (gint argc, gchar * argv[])
   TESTLIST_REGISTER (testutil);
   TESTLIST_REGISTER (tls);
   TESTLIST_REGISTER (cloak);
+  TESTLIST_REGISTER (debuglog);
   TESTLIST_REGISTER (memory);
   TESTLIST_REGISTER (process);
 #if !defined (HAVE_QNX) && !(defined (HAVE_ANDROID) && defined (HAVE_ARM64))
@@ -226,6 +227,9 @@ main (gint argc, gchar * argv[])
   }
 
   TESTLIST_REGISTER (api_resolver);
+  TESTLIST_REGISTER (function_index);
+  TESTLIST_REGISTER (module_coverage);
+  TESTLIST_REGISTER (module_observer);
 #if !defined (HAVE_QNX) && \
     !(defined (HAVE_MIPS))
   TESTLIST_REGISTER (backtracer);
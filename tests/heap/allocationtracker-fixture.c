@@ -10,6 +10,8 @@
 #include "fakebacktracer.h"
 #include "testutil.h"
 
+#include <string.h>
+
 #define TESTCASE(NAME) \
     void test_allocation_tracker_ ## NAME ( \
         TestAllocationTrackerFixture * fixture, gconstpointer data)
@@ -16,6 +16,7 @@ TESTLIST_BEGIN (allocation_tracker)
   TESTENTRY (block_list_sizes)
   TESTENTRY (block_list_backtraces)
   TESTENTRY (block_groups)
+  TESTENTRY (stack_summaries)
 
   TESTENTRY (filter_function)
 
@@ -288,6 +289,92 @@ TESTCASE (block_groups)
   gum_allocation_group_list_free (groups);
 }
 
+TESTCASE (stack_summaries)
+{
+  GumBacktracer * backtracer;
+  GumAllocationTracker * t;
+  GList * summaries, * cur;
+  GumReturnAddressArray expected_stack_a = { 0, };
+  GumReturnAddressArray expected_stack_b = { 0, };
+
+  backtracer = gum_fake_backtracer_new (dummy_return_addresses_a,
+      G_N_ELEMENTS (dummy_return_addresses_a));
+  t = gum_allocation_tracker_new_with_backtracer (backtracer);
+
+  expected_stack_a.len = G_N_ELEMENTS (dummy_return_addresses_a);
+  memcpy (expected_stack_a.items, dummy_return_addresses_a,
+      sizeof (dummy_return_addresses_a));
+  expected_stack_b.len = G_N_ELEMENTS (dummy_return_addresses_b);
+  memcpy (expected_stack_b.items, dummy_return_addresses_b,
+      sizeof (dummy_return_addresses_b));
+
+  gum_allocation_tracker_begin (t);
+
+  summaries = gum_allocation_tracker_peek_stack_summaries (t);
+  g_assert_cmpuint (g_list_length (summaries), ==, 0);
+
+  gum_allocation_tracker_on_malloc (t, DUMMY_BLOCK_A, 42);
+  gum_allocation_tracker_on_malloc (t, DUMMY_BLOCK_B, 24);
+
+  GUM_FAKE_BACKTRACER (backtracer)->ret_addrs = dummy_return_addresses_b;
+  GUM_FAKE_BACKTRACER (backtracer)->num_ret_addrs =
+      G_N_ELEMENTS (dummy_return_addresses_b);
+
+  gum_allocation_tracker_on_malloc (t, DUMMY_BLOCK_C, 1337);
+
+  summaries = gum_allocation_tracker_peek_stack_summaries (t);
+  g_assert_cmpuint (g_list_length (summaries), ==, 2);
+
+  for (cur = summaries; cur != NULL; cur = cur->next)
+  {
+    GumAllocationStackSummary * summary = cur->data;
+
+    if (gum_return_address_array_is_equal (&summary->return_addresses,
+        &expected_stack_a))
+    {
+      g_assert_cmpuint (summary->live_count, ==, 2);
+      g_assert_cmpuint (summary->live_size, ==, 66);
+    }
+    else if (gum_return_address_array_is_equal (&summary->return_addresses,
+        &expected_stack_b))
+    {
+      g_assert_cmpuint (summary->live_count, ==, 1);
+      g_assert_cmpuint (summary->live_size, ==, 1337);
+    }
+    else
+      g_assert_not_reached ();
+  }
+
+  gum_allocation_stack_summary_list_free (summaries);
+
+  gum_allocation_tracker_on_realloc (t, DUMMY_BLOCK_A, DUMMY_BLOCK_D, 100);
+  gum_allocation_tracker_on_free (t, DUMMY_BLOCK_C);
+
+  summaries = gum_allocation_tracker_peek_stack_summaries (t);
+  g_assert_cmpuint (g_list_length (summaries), ==, 1);
+
+  for (cur = summaries; cur != NULL; cur = cur->next)
+  {
+    GumAllocationStackSummary * summary = cur->data;
+
+    g_assert_true (gum_return_address_array_is_equal (
+        &summary->return_addresses, &expected_stack_a));
+    g_assert_cmpuint (summary->live_count, ==, 2);
+    g_assert_cmpuint (summary->live_size, ==, 124);
+  }
+
+  gum_allocation_stack_summary_list_free (summaries);
+
+  gum_allocation_tracker_on_free (t, DUMMY_BLOCK_B);
+  gum_allocation_tracker_on_free (t, DUMMY_BLOCK_D);
+
+  summaries = gum_allocation_tracker_peek_stack_summaries (t);
+  g_assert_cmpuint (g_list_length (summaries), ==, 0);
+
+  g_object_unref (t);
+  g_object_unref (backtracer);
+}
+
 TESTCASE (filter_function)
 {
   GumBacktracer * backtracer;
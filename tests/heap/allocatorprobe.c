@@ -10,12 +10,14 @@
 
 TESTLIST_BEGIN (allocator_probe)
   TESTENTRY (basics)
+  TESTENTRY (api_filtering)
   TESTENTRY (ignore_gquark)
 #ifdef _DEBUG
   TESTENTRY (nonstandard_basics)
   TESTENTRY (nonstandard_ignored)
 #endif
   TESTENTRY (full_cycle)
+  TESTENTRY (sampled_tracking)
   TESTENTRY (gtype_interop)
 TESTLIST_END ()
 
@@ -73,6 +75,38 @@ TESTCASE (basics)
   g_assert_cmpuint (free_count, ==, 0);
 }
 
+static gboolean
+reject_all_heap_apis (const GumHeapApi * api,
+                      gpointer user_data)
+{
+  return FALSE;
+}
+
+TESTCASE (api_filtering)
+{
+  guint malloc_count, realloc_count, free_count, untracked_hit_count;
+  gpointer a;
+
+  g_object_set (fixture->ap, "enable-counters", TRUE, NULL);
+  gum_allocator_probe_set_api_filter (fixture->ap, reject_all_heap_apis, NULL);
+
+  ATTACH_PROBE ();
+
+  a = malloc (42);
+  free (a);
+
+  READ_PROBE_COUNTERS ();
+  g_assert_cmpuint (malloc_count, ==, 0);
+  g_assert_cmpuint (realloc_count, ==, 0);
+  g_assert_cmpuint (free_count, ==, 0);
+
+  g_object_get (fixture->ap, "untracked-hit-count", &untracked_hit_count,
+      NULL);
+  g_assert_cmpuint (untracked_hit_count, >=, 2);
+
+  DETACH_PROBE ();
+}
+
 TESTCASE (ignore_gquark)
 {
   guint malloc_count, realloc_count, free_count;
@@ -153,6 +187,41 @@ TESTCASE (full_cycle)
   g_object_unref (t);
 }
 
+TESTCASE (sampled_tracking)
+{
+  GumAllocationTracker * t;
+  guint interval;
+  gpointer a, b;
+
+  t = gum_allocation_tracker_new ();
+  gum_allocation_tracker_begin (t);
+
+  g_object_set (fixture->ap, "allocation-tracker", t, NULL);
+  g_object_set (fixture->ap, "sample-interval", 1, NULL);
+  g_object_get (fixture->ap, "sample-interval", &interval, NULL);
+  g_assert_cmpuint (interval, ==, 1);
+
+  ATTACH_PROBE ();
+
+  a = malloc (512);
+  b = malloc (512);
+  g_assert_cmpuint (gum_allocation_tracker_peek_block_count (t), ==, 2);
+
+  free (b);
+  free (a);
+  g_assert_cmpuint (gum_allocation_tracker_peek_block_count (t), ==, 0);
+
+  g_object_set (fixture->ap, "sample-interval", (guint) G_MAXINT, NULL);
+
+  a = malloc (16);
+  g_assert_cmpuint (gum_allocation_tracker_peek_block_count (t), ==, 0);
+  free (a);
+
+  DETACH_PROBE ();
+
+  g_object_unref (t);
+}
+
 /*
  * Turns out that doing any GType lookups from within the context where
  * malloc() or similar is being called can be dangerous, as the caller
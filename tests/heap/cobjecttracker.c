@@ -12,6 +12,7 @@ TESTLIST_BEGIN (cobjecttracker)
   TESTENTRY (total_count_increase)
   TESTENTRY (total_count_decrease)
   TESTENTRY (object_list)
+  TESTENTRY (checkpoint_changes)
 TESTLIST_END ()
 
 TESTCASE (total_count_increase)
@@ -111,4 +112,37 @@ TESTCASE (object_list)
   gum_cobject_list_free (cobjects);
 }
 
+TESTCASE (checkpoint_changes)
+{
+  GumCObjectTracker * t = fixture->tracker;
+  GList * added, * removed;
+
+  fixture->ht1 = g_hash_table_new (NULL, NULL);
+
+  gum_cobject_tracker_checkpoint (t);
+
+  gum_cobject_tracker_peek_changes (t, &added, &removed);
+  g_assert_cmpint (g_list_length (added), ==, 0);
+  g_assert_cmpint (g_list_length (removed), ==, 0);
+
+  fixture->ht2 = g_hash_table_new (NULL, NULL);
+  g_hash_table_unref (fixture->ht1); fixture->ht1 = NULL;
+
+  fixture->mo = my_object_new ();
+  my_object_free (fixture->mo); fixture->mo = NULL;
+
+  gum_cobject_tracker_peek_changes (t, &added, &removed);
+  g_assert_cmpint (g_list_length (added), ==, 1);
+  g_assert_true (((GumCObject *) added->data)->address == fixture->ht2);
+  g_assert_cmpint (g_list_length (removed), ==, 1);
+  gum_cobject_list_free (added);
+  gum_cobject_list_free (removed);
+
+  gum_cobject_tracker_checkpoint (t);
+
+  gum_cobject_tracker_peek_changes (t, &added, &removed);
+  g_assert_cmpint (g_list_length (added), ==, 0);
+  g_assert_cmpint (g_list_length (removed), ==, 0);
+}
+
 #endif /* HAVE_WINDOWS */
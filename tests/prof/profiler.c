@@ -23,6 +23,7 @@ TESTLIST_BEGIN (profiler)
   TESTENTRY (worst_case_duration)
   TESTENTRY (worst_case_info)
   TESTENTRY (worst_case_info_on_recursion)
+  TESTENTRY (sampling_can_be_started_and_stopped)
 
   REPORT_TESTENTRY (bottleneck)
   REPORT_TESTENTRY (bottlenecks)
@@ -34,6 +35,8 @@ TESTLIST_BEGIN (profiler)
   REPORT_TESTENTRY (xml_multiple_threads)
   REPORT_TESTENTRY (xml_worst_case_info)
   REPORT_TESTENTRY (xml_thread_ordering)
+  REPORT_TESTENTRY (binary_stream_basic)
+  REPORT_TESTENTRY (folded_stacks_basic)
 TESTLIST_END ()
 
 #ifdef HAVE_I386
@@ -294,6 +297,56 @@ REPORT_TESTCASE (xml_thread_ordering)
       "</ProfileReport>");
 }
 
+static gboolean
+collect_binary_chunk (gconstpointer data,
+                      gsize size,
+                      gpointer user_data)
+{
+  g_byte_array_append ((GByteArray *) user_data, data, size);
+
+  return TRUE;
+}
+
+REPORT_TESTCASE (binary_stream_basic)
+{
+  GByteArray * output;
+  guint32 n_threads;
+
+  instrument_example_functions (fixture);
+
+  example_a (fixture->fake_sampler);
+
+  fixture->report = gum_profiler_generate_report (fixture->profiler);
+  g_assert_nonnull (fixture->report);
+
+  output = g_byte_array_new ();
+  g_assert_true (gum_profile_report_emit_binary (fixture->report,
+      collect_binary_chunk, output));
+
+  g_assert_cmpuint (output->len, >, 12);
+  g_assert_cmpint (memcmp (output->data, "GUMPROF1", 8), ==, 0);
+  memcpy (&n_threads, output->data + 8, sizeof (n_threads));
+  g_assert_cmpuint (GUINT32_FROM_LE (n_threads), ==, 1);
+
+  g_byte_array_unref (output);
+}
+
+REPORT_TESTCASE (folded_stacks_basic)
+{
+  gchar * folded;
+
+  gum_profiler_set_stack_folding_enabled (fixture->profiler, TRUE);
+
+  instrument_example_functions (fixture);
+
+  example_a (fixture->fake_sampler);
+
+  folded = gum_profiler_generate_folded_stacks (fixture->profiler);
+  g_assert_nonnull (strstr (folded, "example_a 5\n"));
+  g_assert_nonnull (strstr (folded, "example_a;example_c 4\n"));
+  g_free (folded);
+}
+
 TESTCASE (profile_matching_functions)
 {
   gum_profiler_instrument_functions_matching (fixture->profiler, "simple_*",
@@ -372,4 +425,22 @@ TESTCASE (worst_case_info_on_recursion)
       &example_worst_case_recursive), ==, "2");
 }
 
+TESTCASE (sampling_can_be_started_and_stopped)
+{
+  GumProfiler * prof = fixture->profiler;
+  gchar * folded;
+
+  g_assert_true (gum_profiler_start_sampling (prof, 1000, NULL));
+  g_assert_false (gum_profiler_start_sampling (prof, 1000, NULL));
+
+  g_usleep (G_USEC_PER_SEC / 20);
+
+  gum_profiler_stop_sampling (prof);
+  gum_profiler_stop_sampling (prof);
+
+  folded = gum_profiler_generate_folded_stacks (prof);
+  g_assert_nonnull (folded);
+  g_free (folded);
+}
+
 #endif /* HAVE_WINDOWS */